@@ -22,6 +22,9 @@
 #include "sg/Renderer.h"
 #include "sg/common/FrameBuffer.h"
 
+#include <cstring>
+#include <fstream>
+
 namespace ospray {
   namespace app {
 
@@ -34,11 +37,17 @@ namespace ospray {
       void render(const std::shared_ptr<sg::Frame> &) override;
       int parseCommandLine(int &ac, const char **&av) override;
 
+      using Duration = std::chrono::duration<double, std::milli>;
+      using Stats = pico_bench::Statistics<Duration>;
+
       template <typename T>
       void outputStats(const T &stats);
+      void writeJSON(const std::vector<std::pair<std::string, Stats>> &stages);
+
       size_t numWarmupFrames = 10;
       size_t numBenchFrames = 100;
       std::string imageOutputFile = "";
+      std::string jsonOutputFile = "";
     };
 
     OSPBenchmark::OSPBenchmark()
@@ -57,17 +66,44 @@ namespace ospray {
       if (numBenchFrames <= 0)
         return;
 
+      // the stages of each frame are timed separately, in sg::Frame and here
+      std::vector<Duration> commitTimes;
+      std::vector<Duration> renderTraversalTimes;
+      std::vector<Duration> renderFrameTimes;
+      std::vector<Duration> mapTimes;
+      std::vector<unsigned char> pixels;
+
+      auto fb = root->child("frameBuffer").nodeAs<sg::FrameBuffer>();
+
+      auto toDuration = [](double seconds) {
+        return Duration{seconds * 1000.0};
+      };
+
       auto benchmarker =
-          pico_bench::Benchmarker<std::chrono::milliseconds>{ numBenchFrames };
+          pico_bench::Benchmarker<Duration>{ numBenchFrames, 0 };
 
       auto stats = benchmarker([&]() {
+        const auto start = std::chrono::high_resolution_clock::now();
         root->renderFrame();
-        // TODO: measure just ospRenderFrame() time from within ospray_sg
-        // return std::chrono::milliseconds{500};
+        const auto rendered = std::chrono::high_resolution_clock::now();
+
+        // read back the image like an application would
+        const size_t pixelSize = fb->format() == OSP_FB_RGBA32F ? 16 : 4;
+        pixels.resize(size_t(width) * height * pixelSize);
+        const void *mapped = fb->map();
+        std::memcpy(pixels.data(), mapped, pixels.size());
+        fb->unmap(mapped);
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const auto &times = root->lastStageTimes();
+        commitTimes.push_back(toDuration(times.commit));
+        renderTraversalTimes.push_back(toDuration(times.render));
+        renderFrameTimes.push_back(toDuration(times.renderFrame));
+        mapTimes.push_back(end - rendered);
+        return Duration{end - start};
       });
 
       if (!imageOutputFile.empty()) {
-        auto fb = root->child("frameBuffer").nodeAs<sg::FrameBuffer>();
         auto *srcPB = (const uint32_t *)fb->map();
         if (fb->format() == OSP_FB_RGBA32F)
           utility::writePFM(imageOutputFile + ".pfm", width, height, (vec4f*)srcPB);
@@ -76,7 +112,59 @@ namespace ospray {
         fb->unmap(srcPB);
       }
 
-      outputStats(stats);
+      std::vector<std::pair<std::string, Stats>> stages = {
+        {"frame", stats},
+        {"commit", Stats{commitTimes}},
+        {"renderTraversal", Stats{renderTraversalTimes}},
+        {"ospRenderFrame", Stats{renderFrameTimes}},
+        {"mapCopy", Stats{mapTimes}}
+      };
+
+      for (auto &stage : stages) {
+        stage.second.time_suffix = "ms";
+        std::cout << stage.first << " ";
+        outputStats(stage.second);
+      }
+      std::cout << "load: " << loadSeconds * 1000.0 << "ms\n"
+                << "initial commit (incl. BVH build): "
+                << initialCommitSeconds * 1000.0 << "ms" << std::endl;
+
+      if (!jsonOutputFile.empty())
+        writeJSON(stages);
+    }
+
+    void OSPBenchmark::writeJSON(
+        const std::vector<std::pair<std::string, Stats>> &stages)
+    {
+      std::ofstream out(jsonOutputFile);
+      if (!out) {
+        std::cerr << "#ospBenchmark: could not write '" << jsonOutputFile
+                  << "'" << std::endl;
+        return;
+      }
+
+      // all times in milliseconds
+      out << "{\n"
+          << "  \"unit\": \"ms\",\n"
+          << "  \"load\": " << loadSeconds * 1000.0 << ",\n"
+          << "  \"initialCommit\": " << initialCommitSeconds * 1000.0 << ",\n"
+          << "  \"stages\": {";
+      for (size_t i = 0; i < stages.size(); i++) {
+        const auto &stats = stages[i].second;
+        out << (i ? ",\n" : "\n")
+            << "    \"" << stages[i].first << "\": {"
+            << "\"samples\": " << stats.size()
+            << ", \"min\": " << stats.min().count()
+            << ", \"max\": " << stats.max().count()
+            << ", \"mean\": " << stats.mean().count()
+            << ", \"stdDev\": " << stats.std_dev().count()
+            << ", \"median\": " << stats.median().count()
+            << ", \"mad\": " << stats.median_abs_dev().count();
+        for (float p : {5.f, 25.f, 75.f, 95.f, 99.f})
+          out << ", \"p" << int(p) << "\": " << stats.percentile(p).count();
+        out << "}";
+      }
+      out << "\n  }\n}" << std::endl;
     }
 
     int OSPBenchmark::parseCommandLine(int &ac, const char **&av)
@@ -95,6 +183,10 @@ namespace ospray {
           numBenchFrames = atoi(av[i + 1]);
           removeArgs(ac, av, i, 2);
           --i;
+        } else if (arg == "-json" || arg == "--json") {
+          jsonOutputFile = av[i + 1];
+          removeArgs(ac, av, i, 2);
+          --i;
         }
       }
       return 0;
@@ -0,0 +1,426 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+/*! \file microbench.cpp kernel-level benchmarks of the hot ISPC paths
+
+  Where ospBenchmark measures whole frames of a scene, this measures
+  single kernels on reproducible synthetic inputs of ospray_testing:
+
+  - primary-ray traversal per geometry type (rays/s)
+  - volume sampling per volume type (samples/s)
+  - transfer function lookup (lookups/s)
+  - accumulation + tone mapping of the local frame buffer (pixels/s)
+
+  The transfer function and frame buffer kernels are called directly on
+  the objects behind the API handles, thus the local (ISPC) device is
+  required. ISPC dispatches to the best of the compiled ISA targets
+  the CPU supports; numbers per ISA are obtained from builds with a
+  single target each (OSPRAY_BUILD_ISA).
+ */
+
+#include "pico_bench.h"
+#include "ospray_testing.h"
+// ospray
+#include "ospray/fb/LocalFB.h"
+#include "ospray/fb/TilePool.h"
+#include "ospray/transferFunction/TransferFunction.h"
+// ospcommon
+#include "ospcommon/sysinfo.h"
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifndef OSPRAY_MICROBENCH_ISA_TARGETS
+#  define OSPRAY_MICROBENCH_ISA_TARGETS "unknown"
+#endif
+
+namespace ospray {
+  namespace microbench {
+
+    using namespace ospcommon;
+
+    using Duration = std::chrono::duration<double, std::milli>;
+    using Stats = pico_bench::Statistics<Duration>;
+
+    struct Result
+    {
+      std::string kernel;
+      std::string unit; // of the throughput, e.g. "rays/s"
+      size_t itemsPerRun;
+      Stats stats;
+
+      double throughput() const
+      {
+        return itemsPerRun / (stats.median().count() / 1000.0);
+      }
+    };
+
+    struct Options
+    {
+      size_t numRuns {50};
+      vec2i fbSize {1024, 768};
+      size_t numSamples {1 << 22};
+      std::string filter;
+      std::string jsonOutputFile;
+    };
+
+    template <typename Fn>
+    static Stats run(const Options &options, Fn &&fn)
+    {
+      auto benchmarker = pico_bench::Benchmarker<Duration>{options.numRuns};
+      auto stats = benchmarker(fn);
+      stats.time_suffix = "ms";
+      return stats;
+    }
+
+    static bool selected(const Options &options, const std::string &kernel)
+    {
+      return options.filter.empty()
+          || kernel.find(options.filter) != std::string::npos;
+    }
+
+    // Inputs /////////////////////////////////////////////////////////////////
+
+    /*! a height field of triangles over [-1,1]^2, as ospray_testing does not
+        provide any triangle geometry */
+    static OSPTestingGeometry newTriangleGrid(int numCells)
+    {
+      std::vector<vec3f> vertices;
+      std::vector<vec3i> indices;
+
+      const float step = 2.f / numCells;
+      for (int j = 0; j <= numCells; j++)
+        for (int i = 0; i <= numCells; i++) {
+          const float x = -1.f + i * step;
+          const float y = -1.f + j * step;
+          vertices.push_back(vec3f(x, y, 0.1f * sinf(8.f * x) * cosf(8.f * y)));
+        }
+
+      for (int j = 0; j < numCells; j++)
+        for (int i = 0; i < numCells; i++) {
+          const int v = j * (numCells + 1) + i;
+          indices.push_back(vec3i(v, v + 1, v + numCells + 2));
+          indices.push_back(vec3i(v, v + numCells + 2, v + numCells + 1));
+        }
+
+      OSPData vertexData =
+          ospNewData(vertices.size(), OSP_FLOAT3, vertices.data());
+      OSPData indexData = ospNewData(indices.size(), OSP_INT3, indices.data());
+
+      OSPGeometry mesh = ospNewGeometry("triangles");
+      ospSetData(mesh, "vertex", vertexData);
+      ospSetData(mesh, "index", indexData);
+      ospRelease(vertexData);
+      ospRelease(indexData);
+
+      const box3f bounds(vec3f(-1.f, -1.f, -0.1f), vec3f(1.f, 1.f, 0.1f));
+
+      OSPTestingGeometry retval;
+      retval.geometry = mesh;
+      retval.bounds   = reinterpret_cast<const osp::box3f &>(bounds);
+      return retval;
+    }
+
+    static std::vector<vec3f> randomPoints(size_t numPoints,
+                                           const box3f &bounds)
+    {
+      std::mt19937 gen(0);
+      std::uniform_real_distribution<float> distribution(0.f, 1.f);
+
+      std::vector<vec3f> points(numPoints);
+      for (auto &p : points) {
+        const vec3f t(distribution(gen), distribution(gen), distribution(gen));
+        p = bounds.lower + t * bounds.size();
+      }
+      return points;
+    }
+
+    // Kernels ////////////////////////////////////////////////////////////////
+
+    /*! primary rays of a raycast renderer (showing the geometric normal), 1
+        sample per pixel without accumulation */
+    static Result benchTraversal(const Options &options,
+                                 const std::string &geometryType)
+    {
+      OSPTestingGeometry geometry = geometryType == "triangles"
+          ? newTriangleGrid(1024)
+          : ospTestingNewGeometry(geometryType.c_str(), "raycast_Ng");
+
+      OSPModel world = ospNewModel();
+      ospAddGeometry(world, geometry.geometry);
+      ospCommit(world);
+
+      OSPCamera camera = ospTestingNewDefaultCamera(geometry.bounds);
+      ospSet1f(camera, "aspect", options.fbSize.x / float(options.fbSize.y));
+      ospCommit(camera);
+
+      OSPRenderer renderer = ospNewRenderer("raycast_Ng");
+      ospSetObject(renderer, "model", world);
+      ospSetObject(renderer, "camera", camera);
+      ospSet1i(renderer, "spp", 1);
+      ospCommit(renderer);
+
+      OSPFrameBuffer fb = ospNewFrameBuffer(
+          (const osp::vec2i &)options.fbSize, OSP_FB_RGBA8, OSP_FB_COLOR);
+
+      auto stats = run(options, [&]() {
+        ospRenderFrame(fb, renderer, OSP_FB_COLOR);
+      });
+
+      ospRelease(fb);
+      ospRelease(renderer);
+      ospRelease(camera);
+      ospRelease(world);
+      ospRelease(geometry.geometry);
+
+      return {"traversal/" + geometryType,
+              "rays/s",
+              size_t(options.fbSize.product()),
+              stats};
+    }
+
+    /*! ospSampleVolumeBatch at random positions inside the volume */
+    static Result benchVolumeSampling(const Options &options,
+                                      const std::string &volumeType)
+    {
+      OSPTestingVolume volume = ospTestingNewVolume(volumeType.c_str());
+
+      OSPTransferFunction tfn =
+          ospTestingNewTransferFunction(volume.voxelRange, "grayscale");
+      ospSetObject(volume.volume, "transferFunction", tfn);
+      ospCommit(volume.volume);
+
+      const auto points = randomPoints(
+          options.numSamples, reinterpret_cast<const box3f &>(volume.bounds));
+      std::vector<float> values(points.size());
+
+      OSPSamplePattern pattern;
+      std::memset(&pattern, 0, sizeof(pattern));
+      pattern.type     = OSP_SAMPLE_POINTS;
+      pattern.points   = (const osp::vec3f *)points.data();
+      pattern.count[0] = points.size();
+      pattern.count[1] = 1;
+
+      auto stats = run(options, [&]() {
+        ospSampleVolumeBatch(volume.volume, &pattern, values.data(), nullptr);
+      });
+
+      ospRelease(tfn);
+      ospRelease(volume.volume);
+
+      return {"volumeSampling/" + volumeType, "samples/s", points.size(),
+              stats};
+    }
+
+    /*! color and opacity of random values, on a single thread */
+    static Result benchTransferFunction(const Options &options)
+    {
+      const vec2f range(0.f, 1.f);
+      OSPTransferFunction tfn =
+          ospTestingNewTransferFunction((const osp::vec2f &)range, "jet");
+      auto *transferFunction = (TransferFunction *)tfn;
+
+      std::mt19937 gen(0);
+      std::uniform_real_distribution<float> distribution(range.x, range.y);
+
+      std::vector<float> values(options.numSamples);
+      for (auto &v : values)
+        v = distribution(gen);
+
+      std::vector<vec3f> colors(values.size());
+      std::vector<float> opacities(values.size());
+
+      auto stats = run(options, [&]() {
+        transferFunction->getColorsAndOpacities(
+            values.size(), values.data(), colors.data(), opacities.data());
+      });
+
+      ospRelease(tfn);
+
+      return {"transferFunction/jet", "lookups/s", values.size(), stats};
+    }
+
+    /*! setTile() of all tiles of a frame into an accumulating sRGB frame
+        buffer with the tone mapper, as the renderer would do */
+    static Result benchFrameBuffer(const Options &options)
+    {
+      OSPFrameBuffer handle =
+          ospNewFrameBuffer((const osp::vec2i &)options.fbSize,
+                            OSP_FB_SRGBA,
+                            OSP_FB_COLOR | OSP_FB_ACCUM);
+
+      OSPPixelOp toneMapper = ospNewPixelOp("tonemapper");
+      ospCommit(toneMapper);
+      ospSetPixelOp(handle, toneMapper);
+
+      auto *fb = (LocalFrameBuffer *)handle;
+      const vec2i numTiles = fb->getNumTiles();
+
+      // synthetic radiance, such that the tone mapper has work to do
+      std::vector<TilePool::Ptr> tiles;
+      for (int y = 0; y < numTiles.y; y++)
+        for (int x = 0; x < numTiles.x; x++) {
+          auto tile = TilePool::acquire(
+              vec2i(x, y), options.fbSize, 0, fb->getTileChannels());
+          for (int i = 0; i < TILE_SIZE * TILE_SIZE; i++) {
+            tile->r[i] = 4.f * (i % TILE_SIZE) / TILE_SIZE;
+            tile->g[i] = 4.f * (i / TILE_SIZE) / TILE_SIZE;
+            tile->b[i] = 0.5f;
+            tile->a[i] = 1.f;
+            tile->z[i] = inf;
+          }
+          tiles.push_back(std::move(tile));
+        }
+
+      auto stats = run(options, [&]() {
+        fb->beginFrame();
+        tasking::parallel_for(tiles.size(), [&](size_t i) {
+          Tile &tile  = *tiles[i];
+          tile.accumID = fb->accumID(tile.region.lower / TILE_SIZE);
+          fb->setTile(tile);
+        });
+        fb->endFrame(0.f);
+      });
+
+      ospRelease(toneMapper);
+      ospRelease(handle);
+
+      return {"frameBuffer/accumulateToneMap",
+              "pixels/s",
+              size_t(options.fbSize.product()),
+              stats};
+    }
+
+    // Output /////////////////////////////////////////////////////////////////
+
+    static void writeJSON(const Options &options,
+                          const std::string &isa,
+                          const std::vector<Result> &results)
+    {
+      std::ofstream out(options.jsonOutputFile);
+      if (!out) {
+        std::cerr << "#ospMicroBenchmark: could not write '"
+                  << options.jsonOutputFile << "'" << std::endl;
+        return;
+      }
+
+      // all times in milliseconds
+      out << "{\n"
+          << "  \"isaTargets\": \"" << OSPRAY_MICROBENCH_ISA_TARGETS << "\",\n"
+          << "  \"cpuISA\": \"" << isa << "\",\n"
+          << "  \"kernels\": {";
+      for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    \"" << r.kernel << "\": {"
+            << "\"unit\": \"" << r.unit << "\""
+            << ", \"throughput\": " << r.throughput()
+            << ", \"itemsPerRun\": " << r.itemsPerRun
+            << ", \"samples\": " << r.stats.size()
+            << ", \"min\": " << r.stats.min().count()
+            << ", \"max\": " << r.stats.max().count()
+            << ", \"mean\": " << r.stats.mean().count()
+            << ", \"stdDev\": " << r.stats.std_dev().count()
+            << ", \"median\": " << r.stats.median().count()
+            << ", \"mad\": " << r.stats.median_abs_dev().count() << "}";
+      }
+      out << "\n  }\n}" << std::endl;
+    }
+
+    static void printHelp()
+    {
+      std::cout << "usage: ospMicroBenchmark [options]\n"
+                << "  -r  | --runs <n>         runs per kernel (default 50)\n"
+                << "  -fb | --size <w> <h>     frame size (default 1024 768)\n"
+                << "  -n  | --samples <n>      samples/lookups per run\n"
+                << "  -k  | --kernel <substr>  only run matching kernels\n"
+                << "  -json | --json <file>    write the results as JSON\n";
+    }
+
+  } // ::ospray::microbench
+} // ::ospray
+
+int main(int ac, const char **av)
+{
+  using namespace ospray::microbench;
+
+  OSPError initError = ospInit(&ac, av);
+  if (initError != OSP_NO_ERROR)
+    return initError;
+
+  Options options;
+  for (int i = 1; i < ac; i++) {
+    const std::string arg = av[i];
+    if ((arg == "-r" || arg == "--runs") && i + 1 < ac) {
+      options.numRuns = std::max(1, atoi(av[++i]));
+    } else if ((arg == "-fb" || arg == "--size") && i + 2 < ac) {
+      options.fbSize.x = atoi(av[++i]);
+      options.fbSize.y = atoi(av[++i]);
+    } else if ((arg == "-n" || arg == "--samples") && i + 1 < ac) {
+      options.numSamples = std::max(1l, atol(av[++i]));
+    } else if ((arg == "-k" || arg == "--kernel") && i + 1 < ac) {
+      options.filter = av[++i];
+    } else if ((arg == "-json" || arg == "--json") && i + 1 < ac) {
+      options.jsonOutputFile = av[++i];
+    } else {
+      printHelp();
+      return arg == "-h" || arg == "--help" ? 0 : 1;
+    }
+  }
+
+  const std::string isa = ospcommon::stringOfISA(ospcommon::getCPUFeatures());
+  std::cout << "ISPC targets: " << OSPRAY_MICROBENCH_ISA_TARGETS
+            << ", CPU ISA: " << isa << std::endl;
+
+  std::vector<Result> results;
+  auto bench = [&](const std::string &kernel, std::function<Result()> fn) {
+    if (!selected(options, kernel))
+      return;
+    results.push_back(fn());
+    const auto &r = results.back();
+    std::cout << r.kernel << ": " << r.throughput() / 1e6 << " M" << r.unit
+              << "\n" << r.stats << std::endl;
+  };
+
+  for (const char *geometry : {"spheres", "subdivision_cube", "triangles"})
+    bench(std::string("traversal/") + geometry,
+          [&]() { return benchTraversal(options, geometry); });
+
+  for (const char *volume : {"structured_volume",
+                             "gravity_spheres_volume",
+                             "unstructured_volume",
+                             "gravity_spheres_amr_volume"})
+    bench(std::string("volumeSampling/") + volume,
+          [&]() { return benchVolumeSampling(options, volume); });
+
+  bench("transferFunction/jet",
+        [&]() { return benchTransferFunction(options); });
+
+  bench("frameBuffer/accumulateToneMap",
+        [&]() { return benchFrameBuffer(options); });
+
+  if (!options.jsonOutputFile.empty())
+    writeJSON(options, isa, results);
+
+  ospShutdown();
+
+  return 0;
+}
@@ -97,6 +97,18 @@ general app-parameters:
         adds subsequent import files to a timeseries
     --static
         adds subsequent import files without a timeseries
+    --instanced-animation
+        prebuild the keyframes of timeseries and keep every file in an own
+        instance, thus animations only update instances instead of
+        rebuilding the whole scene
+    --scene-cache
+        load imported files from a binary cache (<file>.ospsgc) next to
+        them, which is written on the first import
+    --deduplicate
+        replace identical geometries of imported files by instances
+    --async-import
+        import files on a background thread, showing their parts as they
+        complete (the camera is not fitted to the scene)
     -w [int]
         window width
     -h [int]
@@ -284,10 +296,16 @@ usage --> "--generate:type[:parameter1=value,parameter2=value,...]"
         addPlane = false;
       }
 
+      utility::CodeTimer setupTimer;
+      setupTimer.start();
       addLightsToScene(renderer);
+      if (instancedAnimation)
+        renderer["world"]["instanceChildren"] = true;
       addImporterNodesToWorld(root);
       addGeneratorNodesToWorld(renderer);
       addAnimatedImporterNodesToWorld(renderer);
+      setupTimer.stop();
+      loadSeconds = setupTimer.seconds();
 
       framebuffer["size"] = vec2i(width, height);
       auto &navFB = root.createChild("navFrameBuffer", "FrameBuffer");
@@ -296,8 +314,11 @@ usage --> "--generate:type[:parameter1=value,parameter2=value,...]"
 
       setupToneMapping(framebuffer, navFB);
 
+      setupTimer.start();
       root.traverse(sg::VerifyNodes(true));
       root.commit();
+      setupTimer.stop();
+      initialCommitSeconds = setupTimer.seconds();
 
       // sensible default for orthographic camera, before command line parsing
       auto &camera = root["camera"];
@@ -417,6 +438,22 @@ usage --> "--generate:type[:parameter1=value,parameter2=value,...]"
           fast = true;
         } else if (arg == "--no-fast" || arg == "-nf") {
           fast = false;
+        } else if (arg == "--scene-cache") {
+          sceneCache = true;
+          removeArgs(ac, av, i, 1);
+          --i;
+        } else if (arg == "--deduplicate") {
+          deduplicate = true;
+          removeArgs(ac, av, i, 1);
+          --i;
+        } else if (arg == "--instanced-animation") {
+          instancedAnimation = true;
+          removeArgs(ac, av, i, 1);
+          --i;
+        } else if (arg == "--async-import") {
+          asyncImport = true;
+          removeArgs(ac, av, i, 1);
+          --i;
         } else if (arg == "--static" || arg == "--file") {
           inAnimation = false;
           removeArgs(ac, av, i, 1);
@@ -713,6 +750,12 @@ usage --> "--generate:type[:parameter1=value,parameter2=value,...]"
                 auto &transform =
                     world.createChild("transform_" + ss.str(), "Transform");
                 transform.add(importerNode_ptr);
+                if (sceneCache)
+                  importerNode["sceneCache"] = true;
+                if (deduplicate)
+                  importerNode["deduplicate"] = true;
+                if (asyncImport)
+                  importerNode["async"] = true;
                 importerNode["fileName"] = fn.str();
 
                 if (fast) {
@@ -863,6 +906,12 @@ usage --> "--generate:type[:parameter1=value,parameter2=value,...]"
         if (importString != "") {
           auto importerNode_ptr = sg::createNode(animatedFile[0].file, "Importer");
           auto &importerNode = *importerNode_ptr;
+          if (sceneCache)
+            importerNode["sceneCache"] = true;
+          if (deduplicate)
+            importerNode["deduplicate"] = true;
+          if (asyncImport)
+            importerNode["async"] = true;
           importerNode["fileName"] = importString;
           transform.add(importerNode_ptr);
           transform.markAsModified();
@@ -876,6 +925,8 @@ usage --> "--generate:type[:parameter1=value,parameter2=value,...]"
                 "anim_" + animatedFile[0].file, "Animator");
 
             anim_selector.createChild("value2", "int", int(animatedFile.size()));
+            if (instancedAnimation)
+              importerNode.child("selector")["instanced"] = true;
             animation.setChild("anim_selector", anim_selector.shared_from_this());
           }
         }
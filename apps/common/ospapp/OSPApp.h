@@ -120,6 +120,15 @@ namespace ospray {
       bool fast =
           utility::getEnvVar<int>("OSPRAY_APPS_FAST_MODE").value_or(0);
 
+      bool sceneCache = false;
+      bool deduplicate = false;
+      bool asyncImport = false;
+      bool instancedAnimation = false;
+
+      // durations of the setup in main(), in seconds
+      double loadSeconds = 0.0;
+      double initialCommitSeconds = 0.0; // includes building the BVHs
+
      private:
 
       void parseGeneralCommandLine(int &ac, const char **&av);
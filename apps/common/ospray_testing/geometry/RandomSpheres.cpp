@@ -48,9 +48,10 @@ namespace ospray {
         vec4f color;
       };
 
-      // create random number distributions for sphere center, radius, and color
-      std::random_device rd;
-      std::mt19937 gen(rd());
+      // create random number distributions for sphere center, radius, and
+      // color, with a fixed seed to make the spheres reproducible (e.g. for
+      // benchmarks)
+      std::mt19937 gen(0);
 
       std::uniform_real_distribution<float> centerDistribution(-1.f, 1.f);
       std::uniform_real_distribution<float> radiusDistribution(0.05f, 0.15f);
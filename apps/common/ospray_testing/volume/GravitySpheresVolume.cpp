@@ -38,19 +38,35 @@ namespace ospray {
       size_t numPoints{10};
     };
 
-    // Inlined definitions ////////////////////////////////////////////////////
+    /* the same field as GravitySpheresVolume, as an AMR volume with a 64^3
+     * root level, refined twice towards the center of the domain */
+    struct GravitySpheresAMRVolume : public Volume
+    {
+      GravitySpheresAMRVolume()           = default;
+      ~GravitySpheresAMRVolume() override = default;
 
-    OSPTestingVolume GravitySpheresVolume::createVolume() const
+      OSPTestingVolume createVolume() const override;
+
+     private:
+      int rootDimension{64};
+      int brickSize{16};
+      int numLevels{3};
+      size_t numPoints{10};
+    };
+
+    // Helper functions ///////////////////////////////////////////////////////
+
+    struct Point
     {
-      struct Point
-      {
-        vec3f center;
-        float weight;
-      };
+      vec3f center;
+      float weight;
+    };
 
-      // create random number distributions for point center and weight
-      std::random_device rd;
-      std::mt19937 gen(rd());
+    static std::vector<Point> generatePoints(size_t numPoints)
+    {
+      // create random number distributions for point center and weight, with a
+      // fixed seed to make the volume reproducible (e.g. for benchmarks)
+      std::mt19937 gen(0);
 
       std::uniform_real_distribution<float> centerDistribution(-1.f, 1.f);
       std::uniform_real_distribution<float> weightDistribution(0.1f, 0.3f);
@@ -66,6 +82,31 @@ namespace ospray {
         p.weight = weightDistribution(gen);
       }
 
+      return points;
+    }
+
+    static float gravityValue(const std::vector<Point> &points,
+                              const vec3f &coordinate)
+    {
+      float value = 0.f;
+
+      for (auto &p : points) {
+        const float distance = length(coordinate - p.center);
+
+        // contribution proportional to weighted inverse-square distance
+        // (i.e. gravity)
+        value += p.weight / (distance * distance);
+      }
+
+      return value;
+    }
+
+    // Inlined definitions ////////////////////////////////////////////////////
+
+    OSPTestingVolume GravitySpheresVolume::createVolume() const
+    {
+      const auto points = generatePoints(numPoints);
+
       // create a structured volume and assign attributes
       OSPVolume volume = ospNewVolume("block_bricked_volume");
 
@@ -99,19 +140,8 @@ namespace ospray {
             size_t index =
                 k * volumeDimension * volumeDimension + j * volumeDimension + i;
 
-            // compute volume value
-            float value = 0.f;
-
-            for (auto &p : points) {
-              vec3f pointCoordinate = logicalToWorldCoordinates(i, j, k);
-              const float distance  = length(pointCoordinate - p.center);
-
-              // contribution proportional to weighted inverse-square distance
-              // (i.e. gravity)
-              value += p.weight / (distance * distance);
-            }
-
-            voxels[index] = value;
+            voxels[index] =
+                gravityValue(points, logicalToWorldCoordinates(i, j, k));
           }
         }
       });
@@ -138,7 +168,101 @@ namespace ospray {
       return retval;
     }
 
+    OSPTestingVolume GravitySpheresAMRVolume::createVolume() const
+    {
+      const auto points = generatePoints(numPoints);
+
+      // layout of the "brickInfo" data of the amr_volume
+      struct BrickInfo
+      {
+        box3i box;
+        int level;
+        float cellWidth;
+      };
+
+      // the root level spans the grid [0, rootDimension)^3, each finer level
+      // halves the cell width and covers the central half of the level above
+      std::vector<BrickInfo> brickInfo;
+
+      for (int level = 0; level < numLevels; level++) {
+        const int levelDimension = rootDimension << level;
+        const int begin = (levelDimension - rootDimension) / 2;
+        const int end   = begin + rootDimension;
+
+        for (int z = begin; z < end; z += brickSize)
+          for (int y = begin; y < end; y += brickSize)
+            for (int x = begin; x < end; x += brickSize) {
+              BrickInfo bi;
+              bi.box.lower = vec3i(x, y, z);
+              bi.box.upper = bi.box.lower + vec3i(brickSize - 1);
+              bi.level     = level;
+              bi.cellWidth = 1.f / float(1 << level);
+              brickInfo.push_back(bi);
+            }
+      }
+
+      // the grid [0, rootDimension)^3 maps to [-1.f, 1.f]^3
+      const float gridSpacing = 2.f / float(rootDimension);
+      const size_t numCells   = size_t(brickSize) * brickSize * brickSize;
+
+      // generate the cell values, sampled at the cell centers
+      std::vector<float> values(brickInfo.size() * numCells);
+
+      tasking::parallel_for(brickInfo.size(), [&](size_t brickID) {
+        const auto &bi = brickInfo[brickID];
+        float *brickValues = values.data() + brickID * numCells;
+        for (int k = 0; k < brickSize; k++) {
+          for (int j = 0; j < brickSize; j++) {
+            for (int i = 0; i < brickSize; i++) {
+              const vec3f cell = vec3f(bi.box.lower + vec3i(i, j, k)) + 0.5f;
+              *brickValues++ = gravityValue(
+                  points, vec3f(-1.f) + cell * bi.cellWidth * gridSpacing);
+            }
+          }
+        }
+      });
+
+      std::vector<OSPData> brickData(brickInfo.size());
+      for (size_t i = 0; i < brickInfo.size(); i++)
+        brickData[i] =
+            ospNewData(numCells, OSP_FLOAT, values.data() + i * numCells);
+
+      OSPData brickDataData =
+          ospNewData(brickData.size(), OSP_DATA, brickData.data());
+      OSPData brickInfoData = ospNewData(brickInfo.size() * sizeof(BrickInfo),
+                                         OSP_RAW,
+                                         brickInfo.data());
+
+      // create an AMR volume and assign attributes
+      OSPVolume volume = ospNewVolume("amr_volume");
+
+      ospSetString(volume, "voxelType", "float");
+      ospSet3f(volume, "gridOrigin", -1.f, -1.f, -1.f);
+      ospSet3f(volume, "gridSpacing", gridSpacing, gridSpacing, gridSpacing);
+      ospSetData(volume, "brickInfo", brickInfoData);
+      ospSetData(volume, "brickData", brickDataData);
+
+      ospRelease(brickInfoData);
+      ospRelease(brickDataData);
+      for (auto d : brickData)
+        ospRelease(d);
+
+      // create OSPRay objects and return results
+
+      const auto range  = vec2f(0.f, 10.f);
+      const auto bounds = box3f(vec3f(-1.f), vec3f(1.f));
+
+      OSPTestingVolume retval;
+      retval.volume     = volume;
+      retval.voxelRange = reinterpret_cast<const osp::vec2f &>(range);
+      retval.bounds     = reinterpret_cast<const osp::box3f &>(bounds);
+
+      return retval;
+    }
+
     OSP_REGISTER_TESTING_VOLUME(GravitySpheresVolume, gravity_spheres_volume);
+    OSP_REGISTER_TESTING_VOLUME(GravitySpheresAMRVolume,
+                                gravity_spheres_amr_volume);
 
   }  // namespace testing
 }  // namespace ospray
@@ -110,6 +110,13 @@ namespace ospray {
                   " tile rendering early termination.");
       child("varianceThreshold").setMinMax(0.f, 25.f);
 
+      createChild("interleave", "int", 1,
+                  NodeFlags::required | NodeFlags::gui_slider,
+                  "while the camera moves render only one of 2 (checkerboard)"
+                  " or 4 pixels per frame, reprojecting the others from the"
+                  " previous frame; 1 renders all pixels.");
+      child("interleave").setMinMax(1,4);
+
       //TODO: move these to seperate SciVisRenderer
       createChild("shadowsEnabled", "bool", true);
       createChild("maxDepth", "int", 5,
@@ -100,23 +100,42 @@ namespace ospray {
 
     std::shared_ptr<FrameBuffer> Frame::renderFrame(bool verifyCommit)
     {
+      // parts of asynchronous imports are added between frames
+      publishPendingImports();
+
+      stageTimes = StageTimes();
+      utility::CodeTimer stageTimer;
+
       if (verifyCommit) {
+        stageTimer.start();
         Node::traverse(VerifyNodes{});
         commit();
+        stageTimer.stop();
+        stageTimes.commit = stageTimer.seconds();
       }
 
-      traverse("render");
+      // the render traversal repeats the last one unless the graph changed
+      if (lastModified() > lastRendered ||
+          childrenLastModified() > lastRendered) {
+        stageTimer.start();
+        traverse("render");
+        lastRendered.renew();
+        stageTimer.stop();
+        stageTimes.render = stageTimer.seconds();
+      }
+
+      auto rendererNode = child("renderer").nodeAs<Renderer>();
 
       auto fb1Node = child("frameBuffer").nodeAs<FrameBuffer>();
       auto fb2Node = child("navFrameBuffer").nodeAs<FrameBuffer>();
-      // use nav FB?
-      auto fbNode = (numAccumulatedFrames == 0 &&
+      // use nav FB? interleaved rendering keeps the full resolution instead
+      const bool interleaved =
+        rendererNode->child("interleave").valueAs<int>() > 1;
+      auto fbNode = (numAccumulatedFrames == 0 && !interleaved &&
           fb1Node->child("size").valueAs<vec2i>() !=
           fb2Node->child("size").valueAs<vec2i>()) ?
         fb2Node : fb1Node;
 
-      auto rendererNode = child("renderer").nodeAs<Renderer>();
-
       const bool accumBudgetReached = frameAccumulationLimit >= 0 &&
         numAccumulatedFrames >= frameAccumulationLimit;
 
@@ -135,7 +154,10 @@ namespace ospray {
       if (numAccumulatedFrames == 0)
         accumulationTimer.start();
 
+      stageTimer.start();
       rendererNode->renderFrame(fbNode);
+      stageTimer.stop();
+      stageTimes.renderFrame = stageTimer.seconds();
 
       numAccumulatedFrames++;
       accumulationTimer.stop();
@@ -183,6 +205,11 @@ namespace ospray {
       return etaSeconds;
     }
 
+    const Frame::StageTimes &Frame::lastStageTimes() const
+    {
+      return stageTimes;
+    }
+
     OSP_REGISTER_SG_NODE(Frame);
 
   } // ::ospray::sg
@@ -70,6 +70,16 @@ namespace ospray {
       float elapsedSeconds() const;
       float estimatedSeconds() const;
 
+      //! durations of the stages of the last renderFrame(), in seconds
+      struct StageTimes
+      {
+        double commit {0.0};      //!< verify and commit traversals
+        double render {0.0};      //!< render traversal
+        double renderFrame {0.0}; //!< ospRenderFrame() alone
+      };
+
+      const StageTimes &lastStageTimes() const;
+
     private:
 
       // Data members //
@@ -80,9 +90,14 @@ namespace ospray {
 
       bool clearFB {true};
 
+      //! when the render traversal was done the last time
+      TimeStamp lastRendered;
+
       int numAccumulatedFrames{0};
       int frameAccumulationLimit{-1};
       
+      StageTimes stageTimes;
+
       // taking total time since accumulation reset
       utility::CodeTimer accumulationTimer;
       // first measurement point, after 4 frames
@@ -0,0 +1,107 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "CachedInstance.h"
+#include "Instance.h"
+#include "Model.h"
+#include "Selector.h"
+#include "../geometry/Geometry.h"
+
+namespace ospray {
+  namespace sg {
+
+    CachedInstance::~CachedInstance()
+    {
+      release();
+    }
+
+    void CachedInstance::update(RenderContext &ctx,
+                                Node &subtree,
+                                size_t lastModified)
+    {
+      if (built && buildTime > lastModified)
+        return;
+
+      release();
+      built = true;
+      buildTime.renew();
+
+      if (!hasLooseGeometry(subtree))
+        return;
+
+      // volumes and instances are skipped without a world, the geometries
+      // are placed by the transform of the instance
+      RenderContext subtreeCtx = ctx;
+      subtreeCtx.world = nullptr;
+      subtreeCtx.currentTransform = one;
+      model = ospNewModel();
+      subtreeCtx.currentOSPModel = model;
+      subtree.finalize(subtreeCtx);
+      ospCommit(model);
+    }
+
+    void CachedInstance::addTo(OSPModel target, const affine3f &transform)
+    {
+      if (!model || !target)
+        return;
+
+      if (!instance || transform != instanceTransform) {
+        ospRelease(instance);
+        instanceTransform = transform;
+        instance = ospNewInstance(model, (osp::affine3f&)instanceTransform);
+        ospCommit(instance);
+      }
+      ospAddGeometry(target, instance);
+    }
+
+    bool CachedInstance::hasLooseGeometry(const Node &subtree)
+    {
+      if (dynamic_cast<const Geometry*>(&subtree))
+        return true;
+
+      // these render into their own models
+      if (dynamic_cast<const Instance*>(&subtree) ||
+          dynamic_cast<const InstanceGroup*>(&subtree) ||
+          dynamic_cast<const Model*>(&subtree))
+        return false;
+      if (dynamic_cast<const Selector*>(&subtree) &&
+          subtree["instanced"].valueAs<bool>())
+        return false;
+
+      for (const auto &child : subtree.children()) {
+        if (hasLooseGeometry(*child.second))
+          return true;
+      }
+      return false;
+    }
+
+    size_t CachedInstance::subtreeLastModified(const Node &subtree)
+    {
+      return std::max<size_t>(subtree.lastModified(),
+                              subtree.childrenLastModified());
+    }
+
+    void CachedInstance::release()
+    {
+      ospRelease(instance);
+      ospRelease(model);
+      instance = nullptr;
+      model = nullptr;
+    }
+
+  } // ::ospray::sg
+} // ::ospray
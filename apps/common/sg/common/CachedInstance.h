@@ -0,0 +1,65 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "Node.h"
+
+namespace ospray {
+  namespace sg {
+
+    /*! the loose geometries of a subtree (i.e. those not below an
+        Instance, see Geometry::postRender), rendered into an own OSPModel
+        and added to the world as a single instance. As long as the subtree
+        is not modified only the transform of the instance changes, thus
+        the BVH of the geometries is built once (e.g. for the keyframes of
+        an animation) and the world rebuilds just its top-level BVH.
+        Volumes and Instances of the subtree are not part of it, they still
+        get added to the world when the subtree is rendered. */
+    struct OSPSG_INTERFACE CachedInstance
+    {
+      CachedInstance() = default;
+      CachedInstance(const CachedInstance &) = delete;
+      CachedInstance &operator=(const CachedInstance &) = delete;
+      ~CachedInstance();
+
+      /*! renders the loose geometries of the subtree into the own model,
+          unless that was done after 'lastModified' already */
+      void update(RenderContext &ctx, Node &subtree, size_t lastModified);
+
+      //! adds the instance with the given transform to the model
+      void addTo(OSPModel target, const affine3f &transform);
+
+      //! whether the subtree has geometries which would end up here
+      static bool hasLooseGeometry(const Node &subtree);
+
+      //! last modification of the subtree, including the node itself
+      static size_t subtreeLastModified(const Node &subtree);
+
+    private:
+
+      void release();
+
+      OSPModel model {nullptr};
+      OSPGeometry instance {nullptr};
+      affine3f instanceTransform {one};
+      bool built {false};
+      TimeStamp buildTime;
+    };
+
+  } // ::ospray::sg
+} // ::ospray
@@ -16,6 +16,8 @@
 
 // scene graph common stuff
 #include "Common.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
 
 // stdlib, for mmap
 #include <sys/types.h>
@@ -26,12 +28,19 @@
 #  include <sys/mman.h>
 #endif
 #include <fcntl.h>
+#ifndef _WIN32
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#endif
 
 // O_LARGEFILE is a GNU extension.
 #ifdef __APPLE__
 #define  O_LARGEFILE  0
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <iostream>
 #include <sstream>
 
@@ -83,5 +92,192 @@ namespace ospray {
 #endif
     }
 
+    MappedFile::MappedFile(const std::string &fileName)
+    {
+#ifdef _WIN32
+      fileHandle = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (fileHandle == INVALID_HANDLE_VALUE)
+        THROW_SG_ERROR("could not open file '" + fileName + "' (error " + std::to_string(GetLastError()) + ")\n");
+      LARGE_INTEGER size;
+      GetFileSizeEx(fileHandle, &size);
+      fileSize = size.QuadPart;
+      if (fileSize == 0)
+        return;
+      fileMappingHandle = CreateFileMapping(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (fileMappingHandle == nullptr)
+        THROW_SG_ERROR("could not create file mapping (error " + std::to_string(GetLastError()) + ")\n");
+      mem = (const unsigned char *)
+        MapViewOfFile(fileMappingHandle, FILE_MAP_READ, 0, 0, fileSize);
+      if (mem == nullptr)
+        THROW_SG_ERROR("could not map file '" + fileName + "'\n");
+#else
+      int fd = ::open(fileName.c_str(), O_LARGEFILE | O_RDONLY);
+      if (fd == -1)
+        THROW_SG_ERROR("could not open file '" + fileName + "'\n");
+      struct stat st;
+      if (fstat(fd, &st) == -1) {
+        ::close(fd);
+        THROW_SG_ERROR("could not stat file '" + fileName + "'\n");
+      }
+      fileSize = st.st_size;
+      if (fileSize == 0) {
+        ::close(fd);
+        return;
+      }
+      void *ptr = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+      // the mapping stays valid after closing the descriptor
+      ::close(fd);
+      if (ptr == MAP_FAILED)
+        THROW_SG_ERROR("could not map file '" + fileName + "'\n");
+      mem = (const unsigned char *)ptr;
+#endif
+    }
+
+    void MappedFile::advise(Access access, bool hugePages, bool numaInterleave)
+    {
+#ifdef _WIN32
+      // the access pattern is only a hint, ignore it
+      (void)access;
+      if (hugePages || numaInterleave) {
+        std::cout << "#osp:sg: huge page and NUMA hints for mapped files "
+                  << "are not supported on Windows" << std::endl;
+      }
+#else
+      if (!mem)
+        return;
+      void *ptr = const_cast<unsigned char *>(mem);
+
+      const int advice[] = {MADV_NORMAL, MADV_SEQUENTIAL,
+                            MADV_RANDOM, MADV_WILLNEED};
+      if (madvise(ptr, fileSize, advice[access]) != 0)
+        std::cout << "#osp:sg: madvise() on mapped file failed" << std::endl;
+
+      if (hugePages) {
+#  ifdef MADV_HUGEPAGE
+        // only has an effect if the kernel supports huge pages for the
+        // page cache of the file system
+        if (madvise(ptr, fileSize, MADV_HUGEPAGE) != 0)
+#  endif
+          std::cout << "#osp:sg: huge pages not supported for mapped file"
+                    << std::endl;
+      }
+
+      if (numaInterleave) {
+#  if defined(__linux__) && defined(SYS_mbind)
+        // interleave the pages (as they are faulted in) over all allowed
+        // nodes, so threads on all sockets see the same bandwidth
+        const int MPOL_INTERLEAVE_ = 3;
+        const unsigned long allNodes = ~0ul;
+        if (syscall(SYS_mbind, ptr, fileSize, MPOL_INTERLEAVE_,
+                    &allNodes, sizeof(allNodes) * 8 + 1, 0) != 0)
+#  endif
+          std::cout << "#osp:sg: NUMA interleaving of mapped file failed"
+                    << std::endl;
+      }
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+#ifdef _WIN32
+      if (mem)
+        UnmapViewOfFile(mem);
+      if (fileMappingHandle)
+        CloseHandle(fileMappingHandle);
+      if (fileHandle && fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle);
+#else
+      if (mem)
+        munmap(const_cast<unsigned char *>(mem), fileSize);
+#endif
+    }
+
+    ParallelFileReader::ParallelFileReader(const std::string &fileName)
+    {
+#ifdef _WIN32
+      fileHandle = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (fileHandle == INVALID_HANDLE_VALUE)
+        THROW_SG_ERROR("could not open file '" + fileName + "' (error " + std::to_string(GetLastError()) + ")\n");
+      LARGE_INTEGER size;
+      GetFileSizeEx(fileHandle, &size);
+      fileSize = size.QuadPart;
+#else
+      fd = ::open(fileName.c_str(), O_LARGEFILE | O_RDONLY);
+      if (fd == -1)
+        THROW_SG_ERROR("could not open file '" + fileName + "'\n");
+      struct stat st;
+      if (fstat(fd, &st) == -1) {
+        ::close(fd);
+        THROW_SG_ERROR("could not stat file '" + fileName + "'\n");
+      }
+      fileSize = st.st_size;
+#  ifdef POSIX_FADV_SEQUENTIAL
+      posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#  endif
+#endif
+    }
+
+    ParallelFileReader::~ParallelFileReader()
+    {
+#ifdef _WIN32
+      if (fileHandle && fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle);
+#else
+      if (fd != -1)
+        ::close(fd);
+#endif
+    }
+
+    bool ParallelFileReader::readChunk(unsigned char *dst,
+                                       size_t offset,
+                                       size_t numBytes) const
+    {
+      while (numBytes > 0) {
+#ifdef _WIN32
+        // reads with an explicit offset don't touch the shared file pointer
+        OVERLAPPED overlapped = {};
+        overlapped.Offset     = DWORD(offset);
+        overlapped.OffsetHigh = DWORD(uint64_t(offset) >> 32);
+        DWORD numRead = 0;
+        const DWORD numToRead = DWORD(std::min(numBytes, size_t(1) << 30));
+        if (!ReadFile(fileHandle, dst, numToRead, &numRead, &overlapped))
+          numRead = 0;
+#else
+        const ssize_t numRead = pread(fd, dst, numBytes, offset);
+        if (numRead < 0 && errno == EINTR)
+          continue;
+#endif
+        if (numRead <= 0)
+          return false;
+        dst      += numRead;
+        offset   += numRead;
+        numBytes -= numRead;
+      }
+      return true;
+    }
+
+    void ParallelFileReader::read(void *dst,
+                                  size_t offset,
+                                  size_t numBytes,
+                                  size_t chunkSize) const
+    {
+      if (offset + numBytes > fileSize)
+        THROW_SG_ERROR("read incomplete data (truncated file or "
+                       "wrong format?!)");
+
+      // exceptions must not escape the tasks, failures are collected
+      std::atomic<bool> failed(false);
+      const size_t numChunks = (numBytes + chunkSize - 1) / chunkSize;
+      tasking::parallel_for(numChunks, [&](size_t i) {
+        const size_t begin = i * chunkSize;
+        if (!readChunk((unsigned char *)dst + begin, offset + begin,
+                       std::min(chunkSize, numBytes - begin)))
+          failed = true;
+      });
+
+      if (failed)
+        THROW_SG_ERROR("could not read file (I/O error)");
+    }
+
   } // ::ospray::sg
 } // ::ospray
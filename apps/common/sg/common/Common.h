@@ -66,6 +66,63 @@ namespace ospray {
     //! map the given file to memory and return that pointer
     OSPSG_INTERFACE const unsigned char* mapFile(const std::string &fileName);
 
+    //! a read-only memory mapping of a whole file, unmapped on destruction
+    struct OSPSG_INTERFACE MappedFile
+    {
+      MappedFile(const std::string &fileName);
+      ~MappedFile();
+
+      MappedFile(const MappedFile &) = delete;
+      MappedFile &operator=(const MappedFile &) = delete;
+
+      const unsigned char *data() const { return mem; }
+      size_t size() const { return fileSize; }
+
+      enum Access { NORMAL, SEQUENTIAL, RANDOM, WILLNEED };
+
+      //! pass access pattern, transparent huge page and NUMA interleaving
+      //  hints to the OS, failing hints are only reported
+      void advise(Access access,
+                  bool hugePages = false,
+                  bool numaInterleave = false);
+
+    private:
+      const unsigned char *mem {nullptr};
+      size_t fileSize {0};
+#ifdef _WIN32
+      void *fileHandle {nullptr};
+      void *fileMappingHandle {nullptr};
+#endif
+    };
+
+    //! a file read with positional reads, which can be issued by several
+    //  threads at once to keep fast storage busy
+    struct OSPSG_INTERFACE ParallelFileReader
+    {
+      ParallelFileReader(const std::string &fileName);
+      ~ParallelFileReader();
+
+      ParallelFileReader(const ParallelFileReader &) = delete;
+      ParallelFileReader &operator=(const ParallelFileReader &) = delete;
+
+      size_t size() const { return fileSize; }
+
+      //! read numBytes starting at offset into dst, split into chunks of
+      //  chunkSize bytes which are read in parallel, throws on short reads
+      void read(void *dst, size_t offset, size_t numBytes,
+                size_t chunkSize = 8 << 20) const;
+
+    private:
+      bool readChunk(unsigned char *dst, size_t offset, size_t numBytes) const;
+
+      size_t fileSize {0};
+#ifdef _WIN32
+      void *fileHandle {nullptr};
+#else
+      int fd {-1};
+#endif
+    };
+
   } // ::ospray::sg
 } // ::ospray
 
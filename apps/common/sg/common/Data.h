@@ -47,8 +47,10 @@ namespace ospray {
       virtual void postCommit(RenderContext &) override
       {
         if (hasParent()) {
-          if (parent().value().is<OSPObject>())
-            ospSetData(parent().valueAs<OSPObject>(), name().c_str(), getOSP());
+          if (parent().value().is<OSPObject>()) {
+            boundTo = parent().valueAs<OSPObject>();
+            ospSetData(boundTo, name().c_str(), getOSP());
+          }
         }
       }
 
@@ -60,6 +62,23 @@ namespace ospray {
         Node::markAsModified();
       }
 
+      /*! \brief whether the OSPData refers to the memory of this node
+
+        The default: OSPRay does not hold a second copy. The parent holds
+        this node, thus it outlives the parent's object, a node which is
+        removed from its parent unbinds itself from the object. Disable
+        sharing if the object can outlive the node (e.g. if it is used
+        outside of the scene graph), changes apply with the next commit. */
+      void setShared(bool shared)
+      {
+        if (shared != sharedBuffer) {
+          sharedBuffer = shared;
+          markAsModified();
+        }
+      }
+
+      bool isShared() const { return sharedBuffer; }
+
       template <typename T>
       T get(size_t idx) const { return ((T*)base())[idx]; }
 
@@ -74,12 +93,11 @@ namespace ospray {
       OSPData     getOSP()
       {
         if (!empty() && !data) {
-          if (type == OSP_RAW) {
-            data = ospNewData(numBytes(), type, base(),
-                              OSP_DATA_SHARED_BUFFER);
-          }
+          const uint32_t flags = sharedBuffer ? OSP_DATA_SHARED_BUFFER : 0;
+          if (type == OSP_RAW)
+            data = ospNewData(numBytes(), type, base(), flags);
           else
-            data = ospNewData(size(), type, base(), OSP_DATA_SHARED_BUFFER);
+            data = ospNewData(size(), type, base(), flags);
 
           ospCommit(data);
         }
@@ -95,6 +113,22 @@ namespace ospray {
 
     protected:
 
+      void removedFromParent(Node &parent) override
+      {
+        // the parent's object must not keep referring to the memory of this
+        // node, which may now be freed before the object
+        if (boundTo && parent.value().is<OSPObject>()
+            && parent.valueAs<OSPObject>() == boundTo) {
+          ospRemoveParam(boundTo, name().c_str());
+          parent.markAsModified();
+        }
+        boundTo = nullptr;
+      }
+
+      //! the object data was last set on, see removedFromParent()
+      OSPObject boundTo {nullptr};
+      bool sharedBuffer {true};
+
       // Helper functions //
 
       std::string arrayTypeAsString() const;
@@ -35,6 +35,11 @@ namespace ospray {
 
       createChild("useAccumBuffer", "bool", true);
       createChild("useVarianceBuffer", "bool", true);
+      createChild("colorBufferCount", "int", 1,
+                  NodeFlags::required | NodeFlags::valid_min_max,
+                  "number of color buffers rendered into in turn, such "
+                  "that mapped frames stay valid while the next "
+                  "renders").setMinMax(1, 4);
 #ifdef OSPRAY_APPS_ENABLE_DENOISER
       createChild("useDenoiser", "bool", true);
 #endif
@@ -70,6 +75,7 @@ namespace ospray {
           || child("displayWall").lastModified() >= lastCommitted()
           || child("useAccumBuffer").lastModified() >= lastCommitted()
           || child("useVarianceBuffer").lastModified() >= lastCommitted()
+          || child("colorBufferCount").lastModified() >= lastCommitted()
 #ifdef OSPRAY_APPS_ENABLE_DENOISER
           || child("useDenoiser").lastModified() >= lastCommitted()
 #endif
@@ -190,6 +196,8 @@ namespace ospray {
 #endif
                                          (useAccum ? OSP_FB_ACCUM : 0) |
                                          (useVariance ? OSP_FB_VARIANCE : 0));
+      ospSet1i(ospFrameBuffer, "colorBufferCount",
+               child("colorBufferCount").valueAs<int>());
       setValue(ospFrameBuffer);
       ospRelease(oldFrameBuffer);
       toneMapperActive = false;
@@ -169,11 +169,15 @@ namespace ospray {
       box3f bounds = ospcommon::empty;
       if (!(hasChild("models") && hasChild("transforms") && hasChild("indices")))
         return bounds;
-      auto& indices = child("indices").nodeAs<DataVector2i>()->v;
+      // accessed as DataBuffer, as they may be mapped from a scene cache
+      auto indexData = child("indices").nodeAs<DataBuffer>();
+      auto indices = (const vec2i *)indexData->base();
       auto models = child("models").nodeAs<ModelList>();
-      auto& transforms = child("transforms").nodeAs<DataVectorAffine3f>()->v;
-      for (auto index : indices)
+      auto transforms =
+          (const ospcommon::affine3f *)child("transforms").nodeAs<DataBuffer>()->base();
+      for (size_t i = 0; i < indexData->size(); i++)
       {
+        const vec2i index = indices[i];
         const box3f& cbounds = models->item(index.x).bounds();
         ospcommon::affine3f transform = worldTransform;
         if (index.y >= 0)
@@ -254,26 +258,48 @@ namespace ospray {
 
     void InstanceGroup::updateInstances(RenderContext &ctx)
     {
+      for (auto instance : ospInstances)
+        ospRelease(instance);
       ospInstances.resize(0);
       if (ctx.currentTransform != cachedTransform)
         updateTransform(ctx);
 
       if (!(hasChild("models") && hasChild("transforms") && hasChild("indices")))
         return;
-      auto& indices = child("indices").nodeAs<DataVector2i>()->v;
+      // accessed as DataBuffer, as they may be mapped from a scene cache
+      auto indexData = child("indices").nodeAs<DataBuffer>();
+      auto indices = (const vec2i *)indexData->base();
       auto models = child("models").nodeAs<ModelList>();
-      auto& transforms = child("transforms").nodeAs<DataVectorAffine3f>()->v;
-      for (auto index : indices)
+      auto transforms =
+          (const ospcommon::affine3f *)child("transforms").nodeAs<DataBuffer>()->base();
+
+      // one instance array per model holds the transforms of all its
+      // instances, instead of one instance geometry each
+      std::vector<std::vector<ospcommon::affine3f>> modelTransforms(
+          models->nodes.size());
+      for (size_t i = 0; i < indexData->size(); i++)
       {
-        auto model = models->item(index.x).valueAs<OSPModel>();
+        const vec2i index = indices[i];
         ospcommon::affine3f transform = worldTransform;
         if (index.y >= 0)
           transform = transform*transforms[index.y];
-        if (model)
-        {
-          ospInstances.push_back(ospNewInstance(model,(osp::affine3f&)transform));
-          ospCommit(ospInstances.back());
-        }
+        modelTransforms[index.x].push_back(transform);
+      }
+
+      for (size_t m = 0; m < modelTransforms.size(); m++)
+      {
+        auto model = models->item(m).valueAs<OSPModel>();
+        const auto &xfms = modelTransforms[m];
+        if (!model || xfms.empty())
+          continue;
+
+        OSPData xfmData = ospNewData(4 * xfms.size(), OSP_FLOAT3, xfms.data());
+        OSPGeometry instances = ospNewGeometry("instance_array");
+        ospSetObject(instances, "model", model);
+        ospSetData(instances, "transforms", xfmData);
+        ospCommit(instances);
+        ospRelease(xfmData);
+        ospInstances.push_back(instances);
       }
       instanceDirty=false;
       cachedTransform = worldTransform;
@@ -15,9 +15,12 @@
 // ======================================================================== //
 
 #include "Model.h"
+#include "Transform.h"
 
 #include "../visitor/MarkAllAsModified.h"
 
+#include <set>
+
 namespace ospray {
   namespace sg {
 
@@ -27,6 +30,7 @@ namespace ospray {
       createChild("dynamicScene", "bool", true);
       createChild("compactMode", "bool", false);
       createChild("robustMode", "bool", false);
+      createChild("instanceChildren", "bool", false);
     }
 
     std::string Model::toString() const
@@ -65,8 +69,13 @@ namespace ospray {
       ctx.currentOSPModel = model;
 
       //instancegroup caches render calls in commit.
-      for (auto &child : properties.children)
-        child.second->finalize(ctx);
+      if (child("instanceChildren").valueAs<bool>())
+        renderChildrenInstanced(ctx);
+      else {
+        childInstances.clear();
+        for (auto &child : properties.children)
+          child.second->finalize(ctx);
+      }
 
       ospCommit(model);
       ctx.currentOSPModel = stashedModel;
@@ -76,6 +85,59 @@ namespace ospray {
       computeBounds();
     }
 
+    //! last modification of what a Transform node renders, apart from its
+    //! transform itself
+    static size_t transformContentLastModified(const Transform &transform)
+    {
+      static const std::set<std::string> transformParameters = {
+        "position", "rotation", "rotationOrder", "scale", "userTransform"
+      };
+      size_t lastModified = transform.lastModified();
+      for (const auto &child : transform.children()) {
+        if (!transformParameters.count(child.first)) {
+          lastModified = std::max(lastModified,
+              CachedInstance::subtreeLastModified(*child.second));
+        }
+      }
+      return lastModified;
+    }
+
+    void Model::renderChildrenInstanced(RenderContext &ctx)
+    {
+      auto model = valueAs<OSPModel>();
+
+      for (auto it = childInstances.begin(); it != childInstances.end();) {
+        if (hasChild(it->first))
+          ++it;
+        else
+          it = childInstances.erase(it);
+      }
+
+      for (auto &child : properties.children) {
+        auto &node = *child.second;
+        auto *transform = dynamic_cast<Transform*>(&node);
+        auto &cached = childInstances[child.first];
+        cached.update(ctx, node, transform ?
+                      transformContentLastModified(*transform) :
+                      CachedInstance::subtreeLastModified(node));
+
+        // the volumes and instances of the child, its loose geometries are
+        // in the cached instance
+        ctx.currentOSPModel = nullptr;
+        node.finalize(ctx);
+        ctx.currentOSPModel = model;
+
+        cached.addTo(model, transform ? transform->worldTransform :
+                                        ctx.currentTransform);
+      }
+    }
+
+    bool Model::commitChildrenInParallel() const
+    {
+      // the geometries and volumes are added to the model after their commit
+      return true;
+    }
+
     OSP_REGISTER_SG_NODE(Model);
 
   } // ::ospray::sg
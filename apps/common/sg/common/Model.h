@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "CachedInstance.h"
 #include "Renderable.h"
 #include "Serialization.h"
 #include "../camera/Camera.h"
@@ -35,10 +36,19 @@ namespace ospray {
                             const std::string& operation) override;
       virtual void preCommit(RenderContext &ctx) override;
       virtual void postCommit(RenderContext &ctx) override;
+      virtual bool commitChildrenInParallel() const override;
 
     protected:
 
+      /*! with "instanceChildren" enabled (meant for the world), the loose
+          geometries of each child are kept in an own, instanced model,
+          which is only rebuilt if the child is modified; the transform of
+          a Transform child is applied by the instance, thus animating it
+          does not rebuild the BVHs of its geometries */
+      void renderChildrenInstanced(RenderContext &ctx);
+
       OSPModel stashedModel{nullptr};
+      std::map<std::string, CachedInstance> childInstances;
     };
 
   } // ::ospray::sg
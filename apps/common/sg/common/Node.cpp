@@ -17,11 +17,21 @@
 #include "Node.h"
 #include "../visitor/VerifyNodes.h"
 
+#include "api/Device.h"
+#include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/utility/Profiler.h"
 #include "ospcommon/utility/StringManip.h"
+// std
+#include <algorithm>
+#include <exception>
 
 namespace ospray {
   namespace sg {
 
+    //! guards the update detection state (modification times and
+    //  modifiedChildren) against parallel commits
+    static std::recursive_mutex modificationMutex;
+
     // ==================================================================
     // sg node implementations
     // ==================================================================
@@ -214,26 +224,69 @@ namespace ospray {
 
     void Node::markAsModified()
     {
+      std::lock_guard<std::recursive_mutex> lock(modificationMutex);
       properties.lastModified = TimeStamp();
-      if (hasParent())
+      if (hasParent()) {
+        listAsModified();
         parent().setChildrenModified(properties.lastModified);
+      }
     }
 
     void Node::setChildrenModified(TimeStamp t)
     {
+      std::lock_guard<std::recursive_mutex> lock(modificationMutex);
       if (t > properties.childrenMTime) {
         properties.childrenMTime = t;
-        if (hasParent())
+        if (hasParent()) {
+          listAsModified();
           parent().setChildrenModified(properties.childrenMTime);
+        }
       }
     }
 
+    void Node::listAsModified()
+    {
+      if (!properties.listedAsModified) {
+        parent().properties.modifiedChildren.push_back(this);
+        properties.listedAsModified = true;
+      }
+    }
+
+    void Node::unlistModified(Node &child)
+    {
+      std::lock_guard<std::recursive_mutex> lock(modificationMutex);
+      auto &modified = properties.modifiedChildren;
+      modified.erase(std::remove(modified.begin(), modified.end(), &child),
+                     modified.end());
+      child.properties.listedAsModified = false;
+    }
+
+    void Node::clearModifiedChildren()
+    {
+      std::lock_guard<std::recursive_mutex> lock(modificationMutex);
+      for (auto *child : properties.modifiedChildren)
+        child->properties.listedAsModified = false;
+      properties.modifiedChildren.clear();
+    }
+
     bool Node::subtreeModifiedButNotCommitted() const
     {
       return (lastModified() > lastCommitted()) ||
              (childrenLastModified() > lastCommitted());
     }
 
+    bool Node::commitIsIndependent() const
+    {
+      // a modified node shared with another subtree has its parent there
+      for (const auto &child : properties.children) {
+        const Node &c = *child.second;
+        if (c.subtreeModifiedButNotCommitted() &&
+            (c.properties.parent != this || !c.commitIsIndependent()))
+          return false;
+      }
+      return true;
+    }
+
     // Parent-child structual interface ///////////////////////////////////////
 
     bool Node::hasChild(const std::string &name) const
@@ -350,7 +403,12 @@ namespace ospray {
     void Node::remove(const std::string &name)
     {
       if (hasChild(name)) {
-        child(name).properties.parent = nullptr;
+        auto &node = child(name);
+        unlistModified(node);
+        if (node.properties.parent == this) {
+          node.properties.parent = nullptr;
+          node.removedFromParent(*this);
+        }
         properties.children.erase(name);
       }
     }
@@ -369,8 +427,31 @@ namespace ospray {
     void Node::setChild(const std::string &name,
                         const std::shared_ptr<Node> &node)
     {
-      properties.children[name] = node;
+      auto &slot = properties.children[name];
+      if (slot && slot != node) {
+        unlistModified(*slot);
+        if (slot->properties.parent == this) {
+          slot->properties.parent = nullptr;
+          slot->removedFromParent(*this);
+        }
+      }
+      if (node->hasParent() && &node->parent() != this)
+        node->parent().unlistModified(*node);
+
+      slot = node;
       node->setParent(*this);
+
+      // a new child is a modification of the subtree, which needs to be
+      // verified and committed; not notified via setChildrenModified(),
+      // which nodes override to react on the values of their children
+      std::lock_guard<std::recursive_mutex> lock(modificationMutex);
+      node->listAsModified();
+      const TimeStamp t;
+      for (Node *n = this; n; n = n->hasParent() ? &n->parent() : nullptr) {
+        n->properties.childrenMTime = t;
+        if (n->hasParent())
+          n->listAsModified();
+      }
     }
 
     bool Node::hasParent() const
@@ -423,8 +504,62 @@ namespace ospray {
       ctx.level++;
 
       if (traverseChildren) {
-        for (auto &child : properties.children)
-          child.second->traverse(ctx, operation);
+        if (operation == "commit") {
+          // only the modified children can need a commit, (re-)traversed in
+          // name order like all children; by index, as committing may modify
+          // (and thus list) further children
+          auto &modified = properties.modifiedChildren;
+          std::vector<Node*> ordered;
+          {
+            std::lock_guard<std::recursive_mutex> lock(modificationMutex);
+            ordered = modified;
+          }
+          std::sort(ordered.begin(), ordered.end(),
+                    [](const Node *a, const Node *b) {
+                      return a->properties.name < b->properties.name;
+                    });
+          const size_t listed = ordered.size();
+
+          // independent subtrees first, in parallel, such that the others
+          // (e.g. sharing materials or textures) see them committed
+          if (ordered.size() > 1 && commitChildrenInParallel() &&
+              api::deviceIsSet() && api::currentDevice().isThreadSafe()) {
+            std::vector<Node*> independent, dependent;
+            for (auto *child : ordered) {
+              if (child->subtreeModifiedButNotCommitted() &&
+                  child->commitIsIndependent())
+                independent.push_back(child);
+              else
+                dependent.push_back(child);
+            }
+
+            if (independent.size() > 1) {
+              std::exception_ptr error;
+              std::mutex errorMutex;
+              tasking::parallel_for(independent.size(), [&](size_t i) {
+                try {
+                  RenderContext childCtx(ctx);
+                  independent[i]->traverse(childCtx, operation);
+                } catch (...) {
+                  std::lock_guard<std::mutex> lock(errorMutex);
+                  if (!error)
+                    error = std::current_exception();
+                }
+              });
+              if (error)
+                std::rethrow_exception(error);
+              ordered.swap(dependent);
+            }
+          }
+
+          for (auto *child : ordered)
+            child->traverse(ctx, operation);
+          for (size_t i = listed; i < modified.size(); i++)
+            modified[i]->traverse(ctx, operation);
+        } else {
+          for (auto &child : properties.children)
+            child.second->traverse(ctx, operation);
+        }
       }
 
       ctx.level--;
@@ -434,6 +569,7 @@ namespace ospray {
 
     void Node::traverse(const std::string &operation)
     {
+      OSPRAY_PROFILE_ZONE("sg::Node::traverse");
       RenderContext ctx;
       traverse(ctx, operation);
     }
@@ -455,6 +591,8 @@ namespace ospray {
       if (operation == "commit" && subtreeModifiedButNotCommitted()) {
         postCommit(ctx);
         markAsCommitted();
+        if (properties.lastVerified > childrenLastModified())
+          clearModifiedChildren();
       }
     }
 
@@ -466,6 +604,15 @@ namespace ospray {
     {
     }
 
+    bool Node::commitChildrenInParallel() const
+    {
+      return false;
+    }
+
+    void Node::removedFromParent(Node &)
+    {
+    }
+
     // ==================================================================
     // global stuff
     // ==================================================================
@@ -473,6 +620,7 @@ namespace ospray {
     using CreatorFct = sg::Node*(*)();
 
     static std::map<std::string, CreatorFct> nodeRegistry;
+    static std::mutex nodeRegistryMutex;
 
     std::shared_ptr<Node> createNode(std::string name,
                                      std::string type,
@@ -480,19 +628,23 @@ namespace ospray {
                                      int flags,
                                      std::string documentation)
     {
-      std::map<std::string, CreatorFct>::iterator it = nodeRegistry.find(type);
       CreatorFct creator = nullptr;
+      {
+        // nodes may be created by parallel commits
+        std::lock_guard<std::mutex> lock(nodeRegistryMutex);
+        auto it = nodeRegistry.find(type);
 
-      if (it == nodeRegistry.end()) {
-        std::string creatorName = "ospray_create_sg_node__" + type;
-        creator = (CreatorFct)getSymbol(creatorName);
+        if (it == nodeRegistry.end()) {
+          std::string creatorName = "ospray_create_sg_node__" + type;
+          creator = (CreatorFct)getSymbol(creatorName);
 
-        if (!creator)
-          throw std::runtime_error("unknown OSPRay sg::Node '" + type + "'");
+          if (!creator)
+            throw std::runtime_error("unknown OSPRay sg::Node '" + type + "'");
 
-        nodeRegistry[type] = creator;
-      } else {
-        creator = it->second;
+          nodeRegistry[type] = creator;
+        } else {
+          creator = it->second;
+        }
       }
 
       std::shared_ptr<sg::Node> newNode(creator());
@@ -255,6 +255,15 @@ namespace ospray {
       //! Called after committing children during traversal
       virtual void postCommit(RenderContext &ctx);
 
+      //! Whether the children with independent subtrees (sharing no modified
+      //  node with their siblings) may be committed in parallel, i.e. they
+      //  do not depend on the order of their commits
+      virtual bool commitChildrenInParallel() const;
+
+      //! Called when this node is removed from (or replaced in) its parent,
+      //  which is still alive, e.g. to unbind what was set on its object
+      virtual void removedFromParent(Node &parent);
+
       struct
       {
         std::string name;
@@ -269,6 +278,11 @@ namespace ospray {
         TimeStamp childrenMTime;
         TimeStamp lastCommitted;
         TimeStamp lastVerified;
+        //! children whose subtree was modified since this node was last
+        //  both verified and committed, such that traversals skip the others
+        std::vector<Node*> modifiedChildren;
+        //! whether this node is in the parent's modifiedChildren
+        bool listedAsModified {false};
         Node* parent {nullptr};
         NodeFlags flags;
         bool valid {false};
@@ -281,6 +295,19 @@ namespace ospray {
 
     private:
 
+      //! add this node to the parent's modifiedChildren
+      void listAsModified();
+
+      //! remove a child from modifiedChildren
+      void unlistModified(Node &child);
+
+      //! forget modifiedChildren once they were both verified and committed
+      void clearModifiedChildren();
+
+      //! whether the commit of this subtree modifies no node shared with
+      //  another subtree
+      bool commitIsIndependent() const;
+
       friend struct VerifyNodes;
     };
 
@@ -446,17 +473,26 @@ namespace ospray {
                     " implement 'bool visit(Node &node, TraversalContext &ctx)'"
                     "!");
 
+      ctx.onlyModifiedChildren = false;
       bool traverseChildren = visitor(*this, ctx);
+      const bool onlyModifiedChildren = ctx.onlyModifiedChildren;
 
       ctx.level++;
 
       if (traverseChildren) {
-        for (auto &child : properties.children)
-          child.second->traverse(visitor, ctx);
+        if (onlyModifiedChildren) {
+          // by index, the visitor may modify (and thus list) further children
+          for (size_t i = 0; i < properties.modifiedChildren.size(); i++)
+            properties.modifiedChildren[i]->traverse(visitor, ctx);
+        } else {
+          for (auto &child : properties.children)
+            child.second->traverse(visitor, ctx);
+        }
       }
 
       ctx.level--;
 
+      ctx.onlyModifiedChildren = onlyModifiedChildren;
       visitor.postChildren(*this, ctx);
     }
 
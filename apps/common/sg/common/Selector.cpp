@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "Selector.h"
+#include "Model.h"
 
 namespace ospray {
   namespace sg {
@@ -22,6 +23,7 @@ namespace ospray {
     Selector::Selector()
     {
       createChild("index", "int", 0);
+      createChild("instanced", "bool", false);
     }
 
     void Selector::preTraverse(RenderContext &ctx, const std::string& operation, bool& traverseChildren)
@@ -29,20 +31,17 @@ namespace ospray {
       if (operation == "render")
       {
         traverseChildren = false;
-         const int index = child("index").valueAs<int>();
-         const int numChildren = properties.children.size();
-         if (index < numChildren - 2 && index >= 0)
-         {
-           int i = 0;
-           for(auto &child : properties.children)
-           {
-             if (child.second->name() != "index" && child.second->name() != "bounds")
-             {
-               if (i++ == index)
-                 child.second->finalize(ctx);
-             }
-           }
-         }
+        if (child("instanced").valueAs<bool>())
+        {
+          renderInstanced(ctx);
+          return;
+        }
+        choiceInstances.clear();
+
+        const int index = child("index").valueAs<int>();
+        const auto nodes = choices();
+        if (index >= 0 && index < int(nodes.size()))
+          nodes[index]->finalize(ctx);
       }
       else
       {
@@ -50,6 +49,56 @@ namespace ospray {
       }
     }
 
+    std::vector<Node*> Selector::choices() const
+    {
+      std::vector<Node*> nodes;
+      for (auto &child : properties.children)
+      {
+        const std::string &name = child.second->name();
+        if (name != "index" && name != "bounds" && name != "instanced")
+          nodes.push_back(child.second.get());
+      }
+      return nodes;
+    }
+
+    void Selector::renderInstanced(RenderContext &ctx)
+    {
+      const auto nodes = choices();
+
+      for (auto it = choiceInstances.begin(); it != choiceInstances.end();)
+      {
+        if (hasChild(it->first))
+          ++it;
+        else
+          it = choiceInstances.erase(it);
+      }
+
+      // preload all choices, such that switching does not build BVHs
+      for (auto *node : nodes)
+      {
+        choiceInstances[node->name()].update(ctx, *node,
+            CachedInstance::subtreeLastModified(*node));
+      }
+
+      const int index = child("index").valueAs<int>();
+      if (index < 0 || index >= int(nodes.size()))
+        return;
+
+      // the volumes and instances of the selected choice
+      Node &selected = *nodes[index];
+      const OSPModel stashedModel = ctx.currentOSPModel;
+      ctx.currentOSPModel = nullptr;
+      selected.finalize(ctx);
+      ctx.currentOSPModel = stashedModel;
+
+      // added to the world, as instances cannot be nested
+      if (ctx.world)
+      {
+        choiceInstances[selected.name()].addTo(
+            ctx.world->valueAs<OSPModel>(), ctx.currentTransform);
+      }
+    }
+
     OSP_REGISTER_SG_NODE(Selector);
 
   } // ::ospray::sg
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "CachedInstance.h"
 #include "Renderable.h"
 
 namespace ospray {
@@ -29,6 +30,17 @@ namespace ospray {
 
       virtual void preTraverse(RenderContext &ctx, const std::string& operation, bool& traverseChildren) override;
 
+    private:
+
+      //! the selectable children, in order
+      std::vector<Node*> choices() const;
+
+      /*! with "instanced" enabled the loose geometries of all choices
+          (e.g. the keyframes of an animation) are prebuilt into own
+          models, and selecting one only adds its instance to the world */
+      void renderInstanced(RenderContext &ctx);
+
+      std::map<std::string, CachedInstance> choiceInstances;
     };
 
   } // ::ospray::sg
@@ -70,6 +70,11 @@ namespace ospray {
       ctx.currentTransform = cachedTransform;
     }
 
+    bool Transform::commitChildrenInParallel() const
+    {
+      return true;
+    }
+
     void Transform::updateTransform(const ospcommon::affine3f& transform)
     {
       const vec3f scale = child("scale").valueAs<vec3f>();
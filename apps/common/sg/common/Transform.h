@@ -35,6 +35,7 @@ namespace ospray {
       void postCommit(RenderContext &ctx) override;
       void preRender(RenderContext &ctx) override;
       void postRender(RenderContext &ctx) override;
+      bool commitChildrenInParallel() const override;
 
       //! \brief the actual (affine) transformation matrix
       ospcommon::affine3f worldTransform{ospcommon::one};  // computed transform
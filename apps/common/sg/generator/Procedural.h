@@ -0,0 +1,118 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// ospcommon
+#include "ospcommon/vec.h"
+// std
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+namespace ospray {
+  namespace sg {
+
+    // Helpers of the generators of large procedural scenes: all values are
+    // pure functions of their (global) coordinates and a seed, thus the
+    // scenes can be generated in parallel, in any order and in pieces, and
+    // are the same on every run and every rank.
+    namespace procedural {
+
+      using namespace ospcommon;
+
+      /*! integer hash (lowbias32), well distributed for consecutive inputs */
+      inline uint32_t hash(uint32_t x)
+      {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+      }
+
+      inline uint32_t hash(uint64_t i, uint32_t seed)
+      {
+        return hash(uint32_t(i) ^ hash(uint32_t(i >> 32) ^ hash(seed)));
+      }
+
+      inline uint32_t hash(const vec3i &p, uint32_t seed)
+      {
+        return hash(p.x ^ hash(p.y ^ hash(p.z ^ hash(seed))));
+      }
+
+      /*! uniformly distributed in [0, 1) */
+      inline float random01(uint32_t h)
+      {
+        return (h >> 8) * (1.f / 16777216.f);
+      }
+
+      /*! value noise in [0, 1): smoothly interpolated random values at the
+          integer lattice points */
+      inline float valueNoise(const vec3f &p, uint32_t seed)
+      {
+        const vec3f fl(std::floor(p.x), std::floor(p.y), std::floor(p.z));
+        const vec3i i(fl);
+        const vec3f f = p - fl;
+        const vec3f w = f * f * (3.f - 2.f * f);
+
+        auto v = [&](int x, int y, int z) {
+          return random01(hash(i + vec3i(x, y, z), seed));
+        };
+
+        const float x00 = v(0, 0, 0) + w.x * (v(1, 0, 0) - v(0, 0, 0));
+        const float x10 = v(0, 1, 0) + w.x * (v(1, 1, 0) - v(0, 1, 0));
+        const float x01 = v(0, 0, 1) + w.x * (v(1, 0, 1) - v(0, 0, 1));
+        const float x11 = v(0, 1, 1) + w.x * (v(1, 1, 1) - v(0, 1, 1));
+        const float y0 = x00 + w.y * (x10 - x00);
+        const float y1 = x01 + w.y * (x11 - x01);
+        return y0 + w.z * (y1 - y0);
+      }
+
+      /*! fractal sum of 'octaves' octaves of value noise, in [0, 1) */
+      inline float fbm(vec3f p, int octaves, uint32_t seed)
+      {
+        float sum = 0.f;
+        float amplitude = 0.5f;
+        float norm = 0.f;
+        for (int o = 0; o < octaves; o++) {
+          sum += amplitude * valueNoise(p, seed + o);
+          norm += amplitude;
+          amplitude *= 0.5f;
+          p *= 2.f;
+        }
+        return norm > 0.f ? sum / norm : 0.f;
+      }
+
+      /*! parses counts like "1000000", "1e9", "500k", "100M" or "2G" */
+      inline size_t parseCount(const std::string &s)
+      {
+        char *end = nullptr;
+        double count = std::strtod(s.c_str(), &end);
+        switch (end ? *end : '\0') {
+        case 'k': case 'K': count *= 1e3; break;
+        case 'm': case 'M': count *= 1e6; break;
+        case 'g': case 'G': count *= 1e9; break;
+        default: break;
+        }
+        return count > 0.0 ? size_t(count) : 0;
+      }
+
+    } // ::ospray::sg::procedural
+  } // ::ospray::sg
+} // ::ospray
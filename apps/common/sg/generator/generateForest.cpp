@@ -0,0 +1,170 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// sg
+#include "../common/Data.h"
+#include "../common/Instance.h"
+#include "../geometry/TriangleMesh.h"
+#include "Generator.h"
+#include "Procedural.h"
+// std
+#include <limits>
+
+namespace ospray {
+  namespace sg {
+
+    // One tree: a trunk and a crown of 'layers' stacked cones, with
+    // 'segments' around; the proportions vary with 'seed'.
+    static std::shared_ptr<Node> makeTree(const std::string &name,
+                                          int segments,
+                                          int layers,
+                                          uint32_t seed)
+    {
+      auto vertices = std::make_shared<DataVector3f>();
+      vertices->setName("vertex");
+      auto indices = std::make_shared<DataVector3i>();
+      indices->setName("index");
+
+      const float trunkHeight = 0.15f + 0.15f * procedural::random01(
+                                    procedural::hash(0, seed));
+      const float width = 0.25f + 0.15f * procedural::random01(
+                              procedural::hash(1, seed));
+      const float trunkRadius = 0.05f;
+
+      auto ring = [&](float y, float radius) {
+        const int first = int(vertices->size());
+        for (int s = 0; s < segments; s++) {
+          const float phi = 2.f * float(M_PI) * s / segments;
+          vertices->push_back(vec3f(radius * std::cos(phi), y,
+                                    radius * std::sin(phi)));
+        }
+        return first;
+      };
+
+      // the trunk, a cylinder
+      const int bottom = ring(0.f, trunkRadius);
+      const int top = ring(trunkHeight, trunkRadius);
+      for (int s = 0; s < segments; s++) {
+        const int t = (s + 1) % segments;
+        indices->push_back(vec3i(bottom + s, bottom + t, top + s));
+        indices->push_back(vec3i(bottom + t, top + t, top + s));
+      }
+
+      // the crown, overlapping cones getting narrower to the top
+      const float layerHeight = (1.f - trunkHeight) / layers;
+      for (int l = 0; l < layers; l++) {
+        const float y = trunkHeight + l * layerHeight * 0.8f;
+        const float radius = width * (1.f - float(l) / layers);
+        const int base = ring(y, radius);
+        const int apex = int(vertices->size());
+        vertices->push_back(vec3f(0.f, y + 1.5f * layerHeight, 0.f));
+        for (int s = 0; s < segments; s++)
+          indices->push_back(vec3i(base + s, base + (s + 1) % segments, apex));
+      }
+
+      auto mesh_node = createNode(name + "_mesh", "TriangleMesh");
+      mesh_node->add(vertices);
+      mesh_node->add(indices);
+
+      auto model_node = createNode(name, "Model");
+      model_node->add(mesh_node);
+      return model_node;
+    }
+
+    // A forest of (up to billions of) instances of a few tree models,
+    // placed on a jittered grid with one tree per unit square, with random
+    // orientation and size. The transforms are generated in parallel.
+    void generateForest(const std::shared_ptr<Node> &world,
+                        const std::vector<string_pair> &params)
+    {
+      // get generator parameters
+
+      size_t numTrees   = 10000;
+      int numPrototypes = 4;
+      int treeTriangles = 1000;
+      uint32_t seed     = 0;
+
+      for (auto &p : params) {
+        if (p.first == "trees" || p.first == "instances") {
+          numTrees = procedural::parseCount(p.second);
+        } else if (p.first == "prototypes") {
+          numPrototypes = std::max(1, std::atoi(p.second.c_str()));
+        } else if (p.first == "treeTriangles") {
+          treeTriangles = std::atoi(p.second.c_str());
+        } else if (p.first == "seed") {
+          seed = std::atoi(p.second.c_str());
+        } else {
+          std::cout << "WARNING: unknown forest generator parameter '"
+                    << p.first << "' with value '" << p.second << "'"
+                    << std::endl;
+        }
+      }
+
+      // the instance group indexes the transforms with 32-bit ints
+      if (numTrees > size_t(std::numeric_limits<int>::max())) {
+        std::cout << "WARNING: limiting the forest to 2^31-1 trees"
+                  << std::endl;
+        numTrees = std::numeric_limits<int>::max();
+      }
+
+      std::cout << "...generating forest of " << numTrees << " instances of "
+                << numPrototypes << " trees..." << std::endl;
+
+      auto group = createNode("forest", "InstanceGroup");
+      auto models =
+          group->createChild("models", "ModelList").nodeAs<ModelList>();
+      auto transforms = group->createChild("transforms", "DataVectorAffine3f")
+                            .nodeAs<DataVectorAffine3f>();
+      auto indices =
+          group->createChild("indices", "DataVector2i").nodeAs<DataVector2i>();
+
+      // trunk (2) and 'layers' cone triangles per segment
+      const int layers = 4;
+      const int segments = std::max(3, treeTriangles / (layers + 2));
+      for (int i = 0; i < numPrototypes; i++) {
+        models->push_back(makeTree("tree_" + std::to_string(i),
+                                   segments, layers, seed + i)->nodeAs<Model>());
+      }
+
+      const size_t side = size_t(std::ceil(std::sqrt(double(numTrees))));
+      transforms->v.resize(numTrees);
+      indices->v.resize(numTrees);
+
+      tasking::parallel_for(numTrees, [&](size_t i) {
+        const uint32_t h = procedural::hash(uint64_t(i), seed);
+        const uint32_t h2 = procedural::hash(h);
+        const vec3f position(i % side + procedural::random01(h),
+                             0.f,
+                             i / side + procedural::random01(h2));
+        const float angle = 2.f * float(M_PI) *
+                            procedural::random01(procedural::hash(h2));
+        const float scale = 0.7f + 0.6f * procedural::random01(h ^ h2);
+
+        transforms->v[i] = affine3f::translate(position)
+                           * affine3f::rotate(vec3f(0.f, 1.f, 0.f), angle)
+                           * affine3f::scale(vec3f(scale));
+        indices->v[i] = vec2i(int(h2 % numPrototypes), int(i));
+      });
+
+      world->add(group);
+    }
+
+    OSPSG_REGISTER_GENERATE_FUNCTION(generateForest, forest);
+
+  }  // ::ospray::sg
+}  // ::ospray
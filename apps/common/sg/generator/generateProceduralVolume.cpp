@@ -0,0 +1,137 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/utility/StringManip.h"
+// sg
+#include "../common/Data.h"
+#include "Generator.h"
+#include "Procedural.h"
+
+namespace ospray {
+  namespace sg {
+
+    template <typename T>
+    static void fillProceduralVolume(T *voxels,
+                                     const vec3l &dims,
+                                     int octaves,
+                                     float frequency,
+                                     uint32_t seed,
+                                     float scale)
+    {
+      const vec3f toNoise = frequency / vec3f(reduce_max(dims));
+
+      // slices in parallel, which also places them on the NUMA node of the
+      // thread generating them
+      tasking::parallel_for(dims.z, [&](int64_t z) {
+        T *slice = voxels + z * dims.x * dims.y;
+        for (int64_t y = 0; y < dims.y; ++y) {
+          for (int64_t x = 0; x < dims.x; ++x) {
+            const vec3f p = vec3f(x, y, z) * toNoise;
+            slice[y * dims.x + x] = T(scale * procedural::fbm(p, octaves, seed));
+          }
+        }
+      });
+    }
+
+    // A fractal noise volume of up to (at least) 4096^3 voxels, generated in
+    // parallel per slice; 'uchar' voxels (the default) need a quarter of the
+    // memory of 'float' ones.
+    void generateProceduralVolume(const std::shared_ptr<Node> &world,
+                                  const std::vector<string_pair> &params)
+    {
+      auto volume_node = createNode("procedural_volume", "StructuredVolume");
+
+      // get generator parameters
+
+      vec3l dims(256, 256, 256);
+      std::string voxelType = "uchar";
+      int octaves = 6;
+      float frequency = 8.f;
+      uint32_t seed = 0;
+
+      for (auto &p : params) {
+        if (p.first == "dimensions" || p.first == "dims") {
+          auto string_dims = ospcommon::utility::split(p.second, 'x');
+          if (string_dims.size() != 3) {
+            std::cout << "WARNING: ignoring incorrect 'dimensions' parameter,"
+                      << " it must be of the form 'dimensions=XxYxZ'"
+                      << std::endl;
+            continue;
+          }
+
+          dims = vec3l(std::atol(string_dims[0].c_str()),
+                       std::atol(string_dims[1].c_str()),
+                       std::atol(string_dims[2].c_str()));
+        } else if (p.first == "voxelType") {
+          voxelType = p.second;
+          if (voxelType != "uchar" && voxelType != "float") {
+            std::cout << "WARNING: procedural volume voxelType must be "
+                      << "'uchar' or 'float', using 'uchar'" << std::endl;
+            voxelType = "uchar";
+          }
+        } else if (p.first == "octaves") {
+          octaves = std::atoi(p.second.c_str());
+        } else if (p.first == "frequency") {
+          frequency = std::atof(p.second.c_str());
+        } else if (p.first == "seed") {
+          seed = std::atoi(p.second.c_str());
+        } else {
+          std::cout << "WARNING: unknown procedural volume generator parameter"
+                    << " '" << p.first << "' with value '" << p.second << "'"
+                    << std::endl;
+        }
+      }
+
+      // generate volume data
+
+      const size_t numVoxels = dims.product();
+
+      std::cout << "...generating procedural volume with dims=" << dims
+                << " (" << (numVoxels >> 20) << "M " << voxelType
+                << " voxels)..." << std::endl;
+
+      std::shared_ptr<DataBuffer> voxel_data;
+      if (voxelType == "float") {
+        auto *voxels = (float *)alignedMalloc(numVoxels * sizeof(float));
+        fillProceduralVolume(voxels, dims, octaves, frequency, seed, 1.f);
+        voxel_data = std::make_shared<DataArray1f>(voxels, numVoxels);
+      } else {
+        auto *voxels = (unsigned char *)alignedMalloc(numVoxels);
+        fillProceduralVolume(voxels, dims, octaves, frequency, seed, 256.f);
+        voxel_data = std::make_shared<DataArray1uc>(voxels, numVoxels);
+      }
+
+      voxel_data->setName("voxelData");
+
+      volume_node->add(voxel_data);
+
+      // volume attributes
+
+      volume_node->child("voxelType")  = voxelType;
+      volume_node->child("dimensions") = vec3i(dims);
+
+      // add volume to world
+
+      world->add(volume_node);
+    }
+
+    OSPSG_REGISTER_GENERATE_FUNCTION(generateProceduralVolume,
+                                     procedural_volume);
+
+  }  // ::ospray::sg
+}  // ::ospray
@@ -0,0 +1,126 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// sg
+#include "../common/Data.h"
+#include "../geometry/TriangleMesh.h"
+#include "Generator.h"
+#include "Procedural.h"
+
+namespace ospray {
+  namespace sg {
+
+    // A fractal height field of (up to a few billion) triangles over the unit
+    // square, split into chunks of 'chunkTriangles' which are generated in
+    // parallel, each a mesh with its own (32-bit) indices.
+    void generateTerrain(const std::shared_ptr<Node> &world,
+                         const std::vector<string_pair> &params)
+    {
+      // get generator parameters
+
+      size_t numTriangles   = 1000000;
+      size_t chunkTriangles = 1 << 24;
+      int octaves           = 8;
+      uint32_t seed         = 0;
+
+      for (auto &p : params) {
+        if (p.first == "triangles") {
+          numTriangles = procedural::parseCount(p.second);
+        } else if (p.first == "chunkTriangles") {
+          chunkTriangles = procedural::parseCount(p.second);
+        } else if (p.first == "octaves") {
+          octaves = std::atoi(p.second.c_str());
+        } else if (p.first == "seed") {
+          seed = std::atoi(p.second.c_str());
+        } else {
+          std::cout << "WARNING: unknown terrain generator parameter '"
+                    << p.first << "' with value '" << p.second << "'"
+                    << std::endl;
+        }
+      }
+
+      // a grid of cells (two triangles each), in tiles of cells per chunk
+
+      const int64_t gridCells =
+          std::max(int64_t(1), int64_t(std::ceil(std::sqrt(numTriangles / 2.0))));
+      const int64_t tileCells = std::max(int64_t(1),
+          std::min(gridCells, int64_t(std::sqrt(chunkTriangles / 2.0))));
+      const int64_t numTiles = (gridCells + tileCells - 1) / tileCells;
+      const size_t numChunks = numTiles * numTiles;
+
+      std::cout << "...generating terrain with " << 2 * gridCells * gridCells
+                << " triangles in " << numChunks << " chunks..." << std::endl;
+
+      // create the nodes first, their data is filled in parallel
+
+      std::vector<std::shared_ptr<DataVector3f>> vertices(numChunks);
+      std::vector<std::shared_ptr<DataVector3i>> indices(numChunks);
+
+      for (size_t i = 0; i < numChunks; i++) {
+        auto mesh_node = createNode("terrain_" + std::to_string(i),
+                                    "TriangleMesh");
+        vertices[i] = std::make_shared<DataVector3f>();
+        vertices[i]->setName("vertex");
+        indices[i] = std::make_shared<DataVector3i>();
+        indices[i]->setName("index");
+        mesh_node->add(vertices[i]);
+        mesh_node->add(indices[i]);
+        world->add(mesh_node);
+      }
+
+      const float invGrid = 1.f / gridCells;
+
+      tasking::parallel_for(numChunks, [&](size_t chunk) {
+        const int64_t x0 = (chunk % numTiles) * tileCells;
+        const int64_t z0 = (chunk / numTiles) * tileCells;
+        const int nx = int(std::min(tileCells, gridCells - x0));
+        const int nz = int(std::min(tileCells, gridCells - z0));
+
+        auto &v = vertices[chunk]->v;
+        v.resize(size_t(nx + 1) * (nz + 1));
+        for (int z = 0; z <= nz; z++) {
+          for (int x = 0; x <= nx; x++) {
+            const float u = (x0 + x) * invGrid;
+            const float w = (z0 + z) * invGrid;
+            const float h = procedural::fbm(vec3f(16.f * u, 16.f * w, 0.5f),
+                                            octaves, seed);
+            v[size_t(z) * (nx + 1) + x] = vec3f(u, 0.25f * h, w);
+          }
+        }
+
+        auto &index = indices[chunk]->v;
+        index.resize(2 * size_t(nx) * nz);
+        for (int z = 0; z < nz; z++) {
+          for (int x = 0; x < nx; x++) {
+            const int i00 = z * (nx + 1) + x;
+            const int i10 = i00 + 1;
+            const int i01 = i00 + nx + 1;
+            const int i11 = i01 + 1;
+            const size_t cell = size_t(z) * nx + x;
+            index[2 * cell]     = vec3i(i00, i01, i10);
+            index[2 * cell + 1] = vec3i(i10, i01, i11);
+          }
+        }
+      });
+    }
+
+    OSPSG_REGISTER_GENERATE_FUNCTION(generateTerrain, terrain);
+    OSPSG_REGISTER_GENERATE_FUNCTION(generateTerrain, large_mesh);
+
+  }  // ::ospray::sg
+}  // ::ospray
@@ -15,12 +15,16 @@
 // ======================================================================== //
 
 // ospcommon
+#include "ospcommon/tasking/parallel_for.h"
 #include "ospcommon/utility/StringManip.h"
 #include "ospcommon/multidim_index_sequence.h"
 // sg
 #include "../common/Data.h"
 #include "../common/NodeList.h"
 #include "Generator.h"
+#include "Procedural.h"
+// std
+#include <limits>
 
 namespace ospray {
   namespace sg {
@@ -298,6 +302,123 @@ namespace ospray {
       world->add(hex_node);
     }
 
+    // A grid of (up to ~2 billion) hexahedra with randomly displaced inner
+    // vertices and a fractal noise field, generated in parallel per slice.
+    void generateProceduralHexahedrons(const std::shared_ptr<Node> &world,
+                                       const std::vector<string_pair> &params)
+    {
+      auto hex_node = createNode("unstructured_procedural",
+                                 "UnstructuredVolume");
+
+      // get generator parameters
+
+      vec3i dims(64, 64, 64);
+      float jitter = 0.25f;
+      int octaves = 6;
+      uint32_t seed = 0;
+
+      for (auto &p : params) {
+        if (p.first == "dimensions" || p.first == "dims") {
+          auto string_dims = ospcommon::utility::split(p.second, 'x');
+          if (string_dims.size() != 3) {
+            std::cout << "WARNING: ignoring incorrect 'dimensions' parameter,"
+                      << " it must be of the form 'dimensions=XxYxZ'"
+                      << std::endl;
+            continue;
+          }
+
+          dims = vec3i(std::atoi(string_dims[0].c_str()),
+                       std::atoi(string_dims[1].c_str()),
+                       std::atoi(string_dims[2].c_str()));
+        } else if (p.first == "jitter") {
+          jitter = std::atof(p.second.c_str());
+        } else if (p.first == "octaves") {
+          octaves = std::atoi(p.second.c_str());
+        } else if (p.first == "seed") {
+          seed = std::atoi(p.second.c_str());
+        } else {
+          std::cout << "WARNING: unknown procedural hexahedron generator "
+                    << "parameter '" << p.first << "' with value '"
+                    << p.second << "'" << std::endl;
+        }
+      }
+
+      // dims are cells, the vertices are indexed with 32-bit ints
+      dims = max(dims, vec3i(1));
+      const vec3l vertexDims = vec3l(dims) + 1;
+      if (vertexDims.product() > std::numeric_limits<int>::max()) {
+        std::cout << "WARNING: too many vertices for the procedural "
+                  << "hexahedrons, they are limited to 2^31-1" << std::endl;
+        return;
+      }
+      // keep the cells convex
+      jitter = clamp(jitter, 0.f, 0.45f);
+
+      std::cout << "...generating " << vec3l(dims).product()
+                << " procedural hexahedrons..." << std::endl;
+
+      auto verts = createNode("vertices", "DataVector3f")->nodeAs<DataVector3f>();
+      auto indices = createNode("indices", "DataVector4i")->nodeAs<DataVector4i>();
+      auto field = createNode("field", "DataVector1f")->nodeAs<DataVector1f>();
+
+      verts->v.resize(vertexDims.product());
+      field->v.resize(vertexDims.product());
+      indices->v.resize(2 * vec3l(dims).product());
+
+      const float cellSize = 1.f / reduce_max(dims);
+
+      tasking::parallel_for(vertexDims.z, [&](int64_t z) {
+        for (int64_t y = 0; y < vertexDims.y; y++) {
+          for (int64_t x = 0; x < vertexDims.x; x++) {
+            const size_t i = (z * vertexDims.y + y) * vertexDims.x + x;
+            vec3f p(x, y, z);
+            // the boundary stays a box
+            const uint32_t h = procedural::hash(uint64_t(i), seed);
+            if (x > 0 && x < dims.x)
+              p.x += jitter * (2.f * procedural::random01(h) - 1.f);
+            if (y > 0 && y < dims.y)
+              p.y += jitter * (2.f * procedural::random01(h * 3u) - 1.f);
+            if (z > 0 && z < dims.z)
+              p.z += jitter * (2.f * procedural::random01(h * 7u) - 1.f);
+            verts->v[i] = p * cellSize;
+            field->v[i] = procedural::fbm(8.f * cellSize * p, octaves, seed);
+          }
+        }
+      });
+
+      tasking::parallel_for(int64_t(dims.z), [&](int64_t z) {
+        for (int y = 0; y < dims.y; y++) {
+          for (int x = 0; x < dims.x; x++) {
+            const int bottom = int((z * vertexDims.y + y) * vertexDims.x + x);
+            const int top = bottom + int(vertexDims.x * vertexDims.y);
+            const int row = int(vertexDims.x);
+            const vec4i loop(0, 1, row + 1, row);
+            const size_t cell = (z * dims.y + y) * size_t(dims.x) + x;
+            indices->v[2 * cell]     = vec4i(bottom) + loop;
+            indices->v[2 * cell + 1] = vec4i(top) + loop;
+          }
+        }
+      });
+
+      hex_node->add(verts);
+      hex_node->add(indices);
+
+      auto vertexFields = std::make_shared<NodeList<DataVector1f>>();
+      std::vector<sg::Any> vertexFieldNames;
+
+      vertexFields->push_back(field);
+      vertexFieldNames.push_back(std::string("GEN/VTX"));
+
+      hex_node->add(vertexFields, "vertexFields");
+      hex_node->createChild("vertexFieldName",
+                            "string",
+                            vertexFieldNames[0]).setWhiteList(vertexFieldNames);
+
+      world->add(hex_node);
+    }
+
+    OSPSG_REGISTER_GENERATE_FUNCTION(generateProceduralHexahedrons,
+                                     unstructured_procedural);
     OSPSG_REGISTER_GENERATE_FUNCTION(generateHexahedrons,  unstructuredHex  );
     OSPSG_REGISTER_GENERATE_FUNCTION(generateTetrahedrons, unstructuredTet  );
     OSPSG_REGISTER_GENERATE_FUNCTION(generateWedges,       unstructuredWedge);
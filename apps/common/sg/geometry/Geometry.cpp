@@ -76,8 +76,9 @@ namespace ospray {
 
     void Geometry::postRender(RenderContext& ctx)
     {
+      // without a current model the geometry is part of a CachedInstance
       auto ospGeometry = valueAs<OSPGeometry>();
-      if (ospGeometry)
+      if (ospGeometry && ctx.currentOSPModel)
         ospAddGeometry(ctx.currentOSPModel, ospGeometry);
     }
 
@@ -0,0 +1,275 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// ospray::sg
+#include "Importer.h"
+#include "../common/Data.h"
+#include "../common/Instance.h"
+#include "../geometry/Geometry.h"
+// std
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+/*! \file sg/importer/Deduplicate.cpp merges byte-identical geometries
+  into a single Model referenced by Instances */
+
+namespace ospray {
+  namespace sg {
+
+    namespace {
+
+      //! a geometry found in the scene, with where it is attached
+      struct GeometryRef
+      {
+        std::shared_ptr<Geometry> geometry;
+        Node *parent;
+        std::string key;
+        //! the Instance whose model holds the geometry, if any
+        Node *instance;
+        Node *instanceParent;
+        std::string instanceKey;
+        uint64_t hash;
+      };
+
+      inline uint64_t mix(uint64_t h)
+      {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+      }
+
+      inline uint64_t hashBytes(const void *data, size_t numBytes, uint64_t h)
+      {
+        const unsigned char *bytes = (const unsigned char *)data;
+        const size_t numWords = numBytes / sizeof(uint64_t);
+        for (size_t i = 0; i < numWords; i++) {
+          uint64_t word;
+          memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(word));
+          h = (h ^ mix(word)) * 0x9e3779b97f4a7c15ULL;
+        }
+        for (size_t i = numWords * sizeof(uint64_t); i < numBytes; i++)
+          h = (h ^ bytes[i]) * 0x100000001b3ULL;
+        return mix(h ^ numBytes);
+      }
+
+      inline uint64_t hashString(const std::string &s, uint64_t h)
+      {
+        return hashBytes(s.data(), s.size(), h);
+      }
+
+      //! parameters like "radius", other children are compared by identity
+      inline bool isValueChild(Node &node)
+      {
+        return node.children().empty() && node.value().valid() &&
+               !node.valueIsType<OSPObject>();
+      }
+
+      /*! hashes the type and the children of a geometry: arrays by their
+          content, other nodes by identity, such that meshes sharing a
+          material list can match; values are only compared */
+      uint64_t hashGeometry(Geometry &geometry)
+      {
+        uint64_t h = hashString(geometry.type(), 0);
+        for (const auto &c : geometry.children()) {
+          h = hashString(c.first, h);
+          auto data = c.second->tryNodeAs<DataBuffer>();
+          if (data) {
+            h = hashBytes(data->base(), data->numBytes(), h ^ data->getType());
+          } else if (!isValueChild(*c.second)) {
+            const Node *node = c.second.get();
+            h = hashBytes(&node, sizeof(node), h);
+          }
+        }
+        return h;
+      }
+
+      bool sameGeometry(Geometry &a, Geometry &b)
+      {
+        if (a.type() != b.type() ||
+            a.children().size() != b.children().size())
+          return false;
+
+        auto ca = a.children().begin();
+        auto cb = b.children().begin();
+        for (; ca != a.children().end(); ++ca, ++cb) {
+          if (ca->first != cb->first)
+            return false;
+          Node &na = *ca->second;
+          Node &nb = *cb->second;
+          auto da = na.tryNodeAs<DataBuffer>();
+          auto db = nb.tryNodeAs<DataBuffer>();
+          if (da || db) {
+            if (!da || !db || da->getType() != db->getType() ||
+                da->numBytes() != db->numBytes() ||
+                memcmp(da->base(), db->base(), da->numBytes()) != 0)
+              return false;
+          } else if (!isValueChild(na) || !isValueChild(nb)) {
+            if (&na != &nb)
+              return false;
+          } else if (na.type() != nb.type() || !(na.value() == nb.value())) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      struct InstanceRef
+      {
+        Node *instance;
+        Node *parent;
+        std::string key;
+      };
+
+      /*! finds the geometries which can be replaced by an Instance: the
+          ones not below an Instance, and the ones directly in the model of
+          an Instance not nested into another one */
+      void collectGeometries(Node &node,
+                             const InstanceRef &instance,
+                             std::unordered_set<const Node *> &visited,
+                             std::vector<GeometryRef> &geometries)
+      {
+        for (const auto &c : node.children()) {
+          Node &child = *c.second;
+          if (!visited.insert(&child).second)
+            continue;
+
+          auto geometry = child.tryNodeAs<Geometry>();
+          if (geometry) {
+            if (!instance.instance || &node == &(*instance.instance)["model"]) {
+              geometries.push_back({geometry, &node, c.first, instance.instance,
+                                    instance.parent, instance.key, 0});
+            }
+          } else if (child.tryNodeAs<InstanceGroup>()) {
+            continue; // already instanced
+          } else if (child.tryNodeAs<Instance>()) {
+            if (!instance.instance) {
+              collectGeometries(child, {&child, &node, c.first},
+                                visited, geometries);
+            }
+          } else if (!child.tryNodeAs<DataBuffer>()) {
+            collectGeometries(child, instance, visited, geometries);
+          }
+        }
+      }
+
+      inline std::string uniqueChildName(Node &parent, const std::string &name)
+      {
+        std::string unique = name;
+        for (int i = 1; parent.hasChild(unique); i++)
+          unique = name + "_" + std::to_string(i);
+        return unique;
+      }
+
+    } // ::ospray::sg::{anonymous}
+
+    size_t deduplicateGeometries(const std::shared_ptr<Node> &world)
+    {
+      std::vector<GeometryRef> geometries;
+      std::unordered_set<const Node *> visited;
+      collectGeometries(*world, {nullptr, nullptr, ""}, visited, geometries);
+
+      tasking::parallel_for(geometries.size(), [&](size_t i) {
+        geometries[i].hash = hashGeometry(*geometries[i].geometry);
+      });
+
+      // groups of identical geometries, the first one is kept
+      std::unordered_map<uint64_t, std::vector<std::vector<size_t>>> buckets;
+      std::vector<std::vector<size_t> *> groups;
+      for (size_t i = 0; i < geometries.size(); i++) {
+        auto &bucket = buckets[geometries[i].hash];
+        bool found = false;
+        for (auto &group : bucket) {
+          if (sameGeometry(*geometries[group[0]].geometry,
+                           *geometries[i].geometry)) {
+            group.push_back(i);
+            found = true;
+            break;
+          }
+        }
+        if (!found)
+          bucket.push_back({i});
+      }
+      for (auto &bucket : buckets)
+        for (auto &group : bucket.second)
+          if (group.size() > 1)
+            groups.push_back(&group);
+
+      // in scene order, independent of the hashes
+      std::sort(groups.begin(), groups.end(),
+                [](const std::vector<size_t> *a, const std::vector<size_t> *b) {
+                  return a->front() < b->front();
+                });
+
+      size_t numRemoved = 0;
+      for (auto *group : groups) {
+        auto shared = geometries[group->front()].geometry;
+        auto model  = createNode(shared->name() + "_model", "Model");
+
+        for (size_t i : *group) {
+          auto &ref = geometries[i];
+          ref.parent->remove(ref.key);
+
+          auto instance = createNode(ref.geometry->name() + "_instance",
+                                     "Instance");
+          instance->setChild("model", model);
+
+          Node *target = ref.parent;
+          if (ref.instance) {
+            // nested instances don't work, thus it becomes a sibling of the
+            // Instance it was in, taking over its placement
+            for (auto name : {"position", "rotation", "rotationOrder", "scale"})
+              (*instance)[name].setValue((*ref.instance)[name].value());
+            target = ref.instanceParent;
+          }
+          instance->setName(uniqueChildName(*target, instance->name()));
+          target->add(instance);
+        }
+
+        model->add(shared);
+        numRemoved += group->size() - 1;
+      }
+
+      // Instances left without anything to render
+      for (auto *group : groups) {
+        for (size_t i : *group) {
+          auto &ref = geometries[i];
+          if (!ref.instance || !ref.instanceParent->hasChild(ref.instanceKey))
+            continue;
+          bool empty = true;
+          for (const auto &c : (*ref.instance)["model"].children())
+            empty &= !c.second->tryNodeAs<Renderable>();
+          if (empty)
+            ref.instanceParent->remove(ref.instanceKey);
+        }
+      }
+
+      if (numRemoved > 0) {
+        std::cout << "#sg: merged " << numRemoved
+                  << " duplicated geometries into instances" << std::endl;
+      }
+
+      return numRemoved;
+    }
+
+  } // ::ospray::sg
+} // ::ospray
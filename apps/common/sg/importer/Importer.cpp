@@ -20,6 +20,9 @@
 #include "Importer.h"
 #include "sg/SceneGraph.h"
 #include "sg/geometry/TriangleMesh.h"
+// std
+#include <mutex>
+#include <sys/stat.h>
 
 /*! \file sg/module/Importer.cpp Defines the interface for writing
   file importers for the ospray::sg */
@@ -100,7 +103,7 @@ namespace ospray {
 
 
 
-    // Importer definitions ///////////////////////////////////////////////////
+    // Importer registry ////////////////////////////////////////////////////
 
     using FileExtToImporterMap = std::map<const std::string, ImporterFunction>;
 
@@ -115,9 +118,104 @@ namespace ospray {
       importerForExtension[fileExtension] = importer;
     }
 
+    // Asynchronous imports ///////////////////////////////////////////////////
+
+    namespace {
+
+      struct AsyncImport
+      {
+        std::shared_ptr<Node> staging;
+        std::weak_ptr<Node> importer;
+        //! whether parts are published before the whole import is done
+        bool progressive;
+      };
+
+      thread_local AsyncImport *currentImport {nullptr};
+
+      std::mutex pendingMutex;
+      std::vector<std::function<void()>> pending;
+
+      void defer(std::function<void()> f)
+      {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.push_back(std::move(f));
+      }
+
+    } // ::ospray::sg::{anonymous}
+
+    void publishImported(const std::shared_ptr<Node> &world,
+                         std::function<void(const std::shared_ptr<Node> &)>
+                         publish)
+    {
+      if (!importIsProgressive()) {
+        publish(world);
+        return;
+      }
+
+      auto staging  = currentImport->staging;
+      auto importer = currentImport->importer;
+      defer([=]() {
+        auto target = world == staging ? importer.lock() : world;
+        if (target)
+          publish(target);
+      });
+    }
+
+    void reportImportProgress(float progress)
+    {
+      if (!currentImport)
+        return;
+
+      auto importer = currentImport->importer;
+      defer([=]() {
+        auto target = importer.lock();
+        if (target)
+          target->child("progress") = progress;
+      });
+    }
+
+    bool importIsProgressive()
+    {
+      return currentImport && currentImport->progressive;
+    }
+
+    void publishPendingImports()
+    {
+      std::vector<std::function<void()>> publish;
+      {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        publish.swap(pending);
+      }
+      for (auto &f : publish)
+        f();
+    }
+
+    // Importer definitions ///////////////////////////////////////////////////
+
     Importer::Importer()
     {
       createChild("fileName", "string");
+      createChild("sceneCache", "bool", false,
+                  NodeFlags::none,
+                  "load imported files from a binary cache next to them, "
+                  "which is written on the first import");
+      createChild("deduplicate", "bool", false,
+                  NodeFlags::none,
+                  "replace byte-identical geometries by instances of a "
+                  "single model after the import");
+      createChild("async", "bool", false,
+                  NodeFlags::none,
+                  "import on a background thread, showing the parts of the "
+                  "scene as they complete");
+      createChild("progress", "float", 1.f,
+                  NodeFlags::gui_readonly,
+                  "progress of an asynchronous import");
+    }
+
+    Importer::~Importer()
+    {
+      if (importThread.joinable())
+        importThread.join();
     }
 
     void Importer::setChildrenModified(TimeStamp t)
@@ -133,10 +231,20 @@ namespace ospray {
       if (loadedFileName != "" || fileName.str() == "")
         return; //TODO: support dynamic re-loading, need to clear children first
 
-      loadedFileName = "";
+      if (child("async").valueAs<bool>()) {
+        // first, as setting the progress notifies this node again
+        loadedFileName = fileName.str();
+        importAsync(fileName);
+        return;
+      }
 
-      auto wsg = this->nodeAs<Node>();
+      importFile(this->nodeAs<Node>(), fileName);
+      loadedFileName = fileName.str();
+    }
 
+    void Importer::importFile(const std::shared_ptr<Node> &wsg,
+                              const FileName &fileName)
+    {
       std::shared_ptr<FormatURL> fu;
       try {
         fu = std::make_shared<FormatURL>(fileName.c_str());
@@ -158,8 +266,48 @@ namespace ospray {
         importDefaultExtensions(wsg, fileName);
       }
       std::cout << "loaded\n";
+    }
 
-      loadedFileName = fileName.str();
+    void Importer::importAsync(const FileName &fileName)
+    {
+      child("progress") = 0.f;
+
+      AsyncImport import;
+      import.staging  = createNode("staging", "Node");
+      import.importer = shared_from_this();
+      // the import passes over its whole result
+      import.progressive = !child("sceneCache").valueAs<bool>() &&
+                           !child("deduplicate").valueAs<bool>();
+
+      importThread = std::thread([=]() mutable {
+        currentImport = &import;
+        try {
+          importFile(import.staging, fileName);
+        } catch (const std::exception &e) {
+          std::cerr << "#sg: asynchronous import of '" << fileName.str()
+                    << "' failed: " << e.what() << std::endl;
+        }
+        currentImport = nullptr;
+
+        // everything not published yet
+        auto staging  = import.staging;
+        auto importer = import.importer;
+        defer([=]() {
+          auto target = importer.lock();
+          if (!target)
+            return;
+          auto children = staging->children();
+          for (auto &c : children)
+            target->setChild(c.first, c.second);
+          target->child("progress") = 1.f;
+        });
+      });
+    }
+
+    bool Importer::commitChildrenInParallel() const
+    {
+      // imported geometries sharing materials are committed after the others
+      return true;
     }
 
     void Importer::importURL(const std::shared_ptr<Node> &world,
@@ -207,6 +355,21 @@ namespace ospray {
           != importerForExtension.end();
     }
 
+    static std::string sceneCacheFileName(const FileName &fileName)
+    {
+      return fileName.str() + ".ospsgc";
+    }
+
+    //! whether the cache exists and is not older than the imported file
+    static bool sceneCacheIsCurrent(const FileName &fileName)
+    {
+      struct stat source, cache;
+      if (stat(fileName.c_str(), &source) != 0 ||
+          stat(sceneCacheFileName(fileName).c_str(), &cache) != 0)
+        return false;
+      return cache.st_mtime >= source.st_mtime;
+    }
+
     void Importer::importDefaultExtensions(const std::shared_ptr<Node> &world,
                                            const FileName &fileNamen)
     {
@@ -225,24 +388,53 @@ namespace ospray {
 
         if (files.size() > 0) {
           auto ext = files[0].ext(); //TODO: check that they are all homogeneous
-          createChild("selector", "Selector");
 #ifdef OSPRAY_APPS_SG_VTK
           if (ext == "vti") {
-            sg::importVTIs(child("selector").shared_from_this(), files);
+            // published first, such that the volumes show up one by one
+            auto selector = createNode("selector", "Selector");
+            publishImported(world, [=](const std::shared_ptr<Node> &world) {
+              world->add(selector);
+            });
+            sg::importVTIs(selector, files);
             return;
           }
 #endif
+          world->createChild("selector", "Selector");
         }
       } else {
         std::cout << "single file import" << std::endl;
         files.push_back(fileNamen);
       }
 
+      const bool useSceneCache = child("sceneCache").valueAs<bool>();
+
       //load files individually
       for (auto fileName : files)
       {
         auto ext = fileName.ext();
 
+        if (ext == "ospsgc") {
+          sg::loadSceneCache(world, fileName);
+          continue;
+        }
+
+        if (useSceneCache && sceneCacheIsCurrent(fileName)) {
+          std::cout << "#sg: loading scene cache '"
+                    << sceneCacheFileName(fileName) << "'" << std::endl;
+          try {
+            sg::loadSceneCache(world, sceneCacheFileName(fileName));
+            continue;
+          } catch (const std::runtime_error &e) {
+            std::cerr << "#sg: could not load scene cache, importing instead: "
+                      << e.what() << std::endl;
+          }
+        }
+
+        // the cache only holds what this file adds to the world
+        std::vector<std::string> previousChildren;
+        for (const auto &c : world->children())
+          previousChildren.push_back(c.first);
+
         if (hasImporterForExtension(ext)) {
           std::cout << "#sg: found importer for extension '" << ext << "'"
                     << std::endl;
@@ -282,6 +474,19 @@ namespace ospray {
           std::cout << "unsupported file format\n";
           return;
         }
+
+        if (child("deduplicate").valueAs<bool>())
+          sg::deduplicateGeometries(world);
+
+        if (useSceneCache) {
+          try {
+            sg::writeSceneCache(world, sceneCacheFileName(fileName),
+                                previousChildren);
+          } catch (const std::runtime_error &e) {
+            std::cerr << "#sg: could not write scene cache: " << e.what()
+                      << std::endl;
+          }
+        }
       }
     }
 
@@ -19,6 +19,9 @@
 // ospray::sg
 #include "../common/Model.h"
 #include "ospcommon/FileName.h"
+// std
+#include <functional>
+#include <thread>
 
 namespace ospray {
   namespace sg {
@@ -55,13 +58,24 @@ namespace ospray {
     struct OSPSG_INTERFACE Importer : public sg::Renderable
     {
       Importer();
+      ~Importer() override;
 
       virtual void setChildrenModified(TimeStamp t) override;
+      virtual bool commitChildrenInParallel() const override;
 
       std::string loadedFileName;
 
     private:
 
+      void importFile(const std::shared_ptr<Node> &world,
+                      const FileName &fileName);
+
+      /*! imports on a background thread into a staging node, parts are
+          added to this node by publishPendingImports() when complete */
+      void importAsync(const FileName &fileName);
+
+      std::thread importThread;
+
       void importURL(const std::shared_ptr<Node> &world,
                      const FileName &fileName,
                      const FormatURL &fu) const;
@@ -72,6 +86,28 @@ namespace ospray {
                                    const FileName &filename);
     };
 
+    /*! runs publish(world), which adds completed parts of an import to
+        world. During an asynchronous import (the Importer's "async" flag)
+        it's instead deferred to publishPendingImports(), with world being
+        the Importer if it was the staging node of the import; the
+        background thread must not touch the published nodes anymore */
+    OSPSG_INTERFACE
+    void publishImported(const std::shared_ptr<Node> &world,
+                         std::function<void(const std::shared_ptr<Node> &)>
+                         publish);
+
+    /*! reports the progress (0..1) of the current asynchronous import via
+        the Importer's "progress", no-op for synchronous imports */
+    OSPSG_INTERFACE void reportImportProgress(float progress);
+
+    /*! whether this thread is running an asynchronous import with
+        progressive publishing */
+    OSPSG_INTERFACE bool importIsProgressive();
+
+    /*! adds the parts published by asynchronous imports since the last
+        call, called by the render thread before traversing the scene */
+    OSPSG_INTERFACE void publishPendingImports();
+
     /*! prototype for any scene graph importer function */
     using ImporterFunction = void (*)(const std::shared_ptr<Node> &world,
                                       const FileName &fileName);
@@ -150,6 +186,25 @@ namespace ospray {
     void writeOSPSG(const std::shared_ptr<Node> &world,
                     const std::string &fileName);
 
+    /*! write the children of world (except the ones named in skipChildren)
+        and their subtrees to a binary scene cache, with all data arrays
+        64-byte aligned */
+    OSPSG_INTERFACE
+    void writeSceneCache(const std::shared_ptr<Node> &world,
+                         const std::string &fileName,
+                         const std::vector<std::string> &skipChildren = {});
+
+    /*! replace byte-identical geometries below world by Instances of a
+        single Model, returns the number of geometries removed */
+    OSPSG_INTERFACE
+    size_t deduplicateGeometries(const std::shared_ptr<Node> &world);
+
+    /*! add the nodes of a scene cache to world, data arrays and textures
+        are shared with the memory mapped file instead of being copied */
+    OSPSG_INTERFACE
+    void loadSceneCache(const std::shared_ptr<Node> &world,
+                        const std::string &fileName);
+
 
     // Macro to register importers ////////////////////////////////////////////
 
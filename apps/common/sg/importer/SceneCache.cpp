@@ -0,0 +1,757 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// ospray::sg
+#include "Importer.h"
+#include "../common/Data.h"
+#include "../common/Material.h"
+#include "../common/Instance.h"
+#include "../texture/Texture2D.h"
+// std
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <unordered_map>
+
+/*! \file sg/importer/SceneCache.cpp a binary cache of imported scenes
+
+  Layout of a cache file, all little-endian and in native struct layout:
+
+    FileHeader
+    string table (null terminated names and string values)
+    NodeRecord[numNodes]
+    EdgeRecord[numEdges]   parent-child links, parents before children
+    uint32_t[numItems]     the ordered nodes of NodeLists
+    array data             every array 64-byte aligned
+
+  Arrays are shared with the mapped file on load, such that they are
+  handed to ospNewData() with OSP_DATA_SHARED_BUFFER without a copy. */
+
+namespace ospray {
+  namespace sg {
+
+    namespace scenecache {
+
+      static const char magic[8] = {'O', 'S', 'P', 'S', 'G', 'C', 0, 0};
+      static const uint32_t version = 1;
+      static const uint32_t noNode = ~0u;
+      static const size_t alignment = 64;
+
+      struct FileHeader
+      {
+        char magic[8];
+        uint32_t version;
+        uint32_t numNodes;
+        uint32_t numEdges;
+        uint32_t numItems;
+        uint64_t stringsOffset;
+        uint64_t stringsSize;
+        uint64_t nodesOffset;
+        uint64_t edgesOffset;
+        uint64_t itemsOffset;
+        uint64_t fileSize;
+      };
+
+      enum Kind : uint32_t
+      {
+        KIND_NODE,
+        KIND_DATA,
+        KIND_TEXTURE2D
+      };
+
+      enum Flags : uint32_t
+      {
+        //! an item of a NodeList, which needs its node type on load
+        FLAG_LIST_ITEM = 1
+      };
+
+      enum ValueType : uint32_t
+      {
+        VALUE_NONE,
+        VALUE_BOOL,
+        VALUE_INT,
+        VALUE_FLOAT,
+        VALUE_VEC2F,
+        VALUE_VEC2I,
+        VALUE_VEC3F,
+        VALUE_VEC3I,
+        VALUE_VEC3FA,
+        VALUE_VEC4F,
+        VALUE_BOX2F,
+        VALUE_BOX2I,
+        VALUE_BOX3F,
+        VALUE_BOX3I,
+        VALUE_STRING
+      };
+
+      struct NodeRecord
+      {
+        uint32_t name;   //!< offset into the string table
+        uint32_t type;   //!< offset into the string table
+        uint32_t parent; //!< index of the parent node, or noNode
+        uint32_t kind;
+        uint32_t flags;
+        uint32_t valueType;
+        //! POD value, string table offset for strings, Texture2D description
+        uint8_t  value[32];
+        uint64_t dataOffset;
+        uint64_t numBytes;
+        uint32_t dataType;
+        uint32_t bytesPerElement;
+        uint32_t firstItem;
+        uint32_t numItems;
+      };
+
+      struct EdgeRecord
+      {
+        uint32_t parent; //!< node index, or noNode for the root's children
+        uint32_t child;
+        uint32_t name;   //!< the child's key in the parent
+      };
+
+      struct TextureDescription
+      {
+        vec2i   size;
+        int32_t channels;
+        int32_t depth;
+        uint8_t preferLinear;
+        uint8_t nearestFilter;
+      };
+
+      // node values //
+
+      template <typename T>
+      inline bool encodeValue(Node &node, ValueType type, NodeRecord &record)
+      {
+        static_assert(sizeof(T) <= sizeof(record.value),
+                      "scene cache value slot too small");
+        if (!node.valueIsType<T>())
+          return false;
+        const T value = node.valueAs<T>();
+        memcpy(record.value, &value, sizeof(T));
+        record.valueType = type;
+        return true;
+      }
+
+      template <typename T>
+      inline void decodeValue(Node &node, const NodeRecord &record)
+      {
+        T value;
+        memcpy(&value, record.value, sizeof(T));
+        node.setValue(value);
+      }
+
+      // typed arrays //
+
+      /*! calls f.apply<T, TID>() for the element type of an array, returns
+          false for unsupported ones */
+      template <typename F>
+      inline bool dispatchArrayType(uint32_t dataType,
+                                    uint32_t bytesPerElement,
+                                    F &&f)
+      {
+        switch (dataType) {
+        case OSP_UCHAR:
+          if (bytesPerElement == sizeof(affine3f))
+            f.template apply<affine3f, OSP_RAW>();
+          else if (bytesPerElement == 1)
+            f.template apply<unsigned char, OSP_UCHAR>();
+          else
+            return false;
+          return true;
+        case OSP_FLOAT:   f.template apply<float, OSP_FLOAT>();    return true;
+        case OSP_FLOAT2:  f.template apply<vec2f, OSP_FLOAT2>();   return true;
+        case OSP_FLOAT3:  f.template apply<vec3f, OSP_FLOAT3>();   return true;
+        case OSP_FLOAT3A: f.template apply<vec3fa, OSP_FLOAT3A>(); return true;
+        case OSP_FLOAT4:  f.template apply<vec4f, OSP_FLOAT4>();   return true;
+        case OSP_INT:     f.template apply<int, OSP_INT>();        return true;
+        case OSP_INT2:    f.template apply<vec2i, OSP_INT2>();     return true;
+        case OSP_INT3:    f.template apply<vec3i, OSP_INT3>();     return true;
+        case OSP_INT4:    f.template apply<vec4i, OSP_INT4>();     return true;
+        default:
+          return false;
+        }
+      }
+
+      //! only checks whether the array type is supported
+      struct CheckArrayType
+      {
+        template <typename T, int TID>
+        void apply()
+        {
+        }
+      };
+
+      //! creates an array sharing the mapped file, which it keeps alive
+      struct MakeMappedArray
+      {
+        std::shared_ptr<MappedFile> file;
+        const NodeRecord &record;
+        std::shared_ptr<DataBuffer> result;
+
+        MakeMappedArray(const std::shared_ptr<MappedFile> &file,
+                        const NodeRecord &record)
+            : file(file), record(record)
+        {
+        }
+
+        template <typename T, int TID>
+        void apply()
+        {
+          auto array = std::make_shared<DataArrayT<T, TID>>(
+              (T *)(file->data() + record.dataOffset),
+              record.numBytes / sizeof(T));
+          auto mapping = file;
+          array->deleter = [mapping](T *) {};
+          result = array;
+        }
+      };
+
+      //! copies the array into an existing DataVector of the same type
+      struct FillVector
+      {
+        Node &node;
+        const unsigned char *data;
+        const NodeRecord &record;
+        bool filled {false};
+
+        FillVector(Node &node,
+                   const unsigned char *data,
+                   const NodeRecord &record)
+            : node(node), data(data), record(record)
+        {
+        }
+
+        template <typename T, int TID>
+        void apply()
+        {
+          auto vec = dynamic_cast<DataVectorT<T, TID> *>(&node);
+          if (!vec)
+            return;
+          const T *begin = (const T *)data;
+          vec->v.assign(begin, begin + record.numBytes / sizeof(T));
+          vec->markAsModified();
+          filled = true;
+        }
+      };
+
+      // NodeLists //
+
+      template <typename T>
+      inline bool getListItems(Node &node, std::vector<Node *> &items)
+      {
+        auto list = dynamic_cast<NodeList<T> *>(&node);
+        if (!list)
+          return false;
+        for (auto &item : list->nodes)
+          items.push_back(item.get());
+        return true;
+      }
+
+      template <typename T>
+      inline bool setListItems(Node &node,
+                               const std::vector<std::shared_ptr<Node>> &items)
+      {
+        auto list = dynamic_cast<NodeList<T> *>(&node);
+        if (!list)
+          return false;
+        list->nodes.clear();
+        for (auto &item : items) {
+          auto typed = std::dynamic_pointer_cast<T>(item);
+          if (typed)
+            list->nodes.push_back(typed);
+        }
+        return true;
+      }
+
+      inline bool getAnyListItems(Node &node, std::vector<Node *> &items)
+      {
+        return getListItems<Material>(node, items) ||
+               getListItems<Model>(node, items) ||
+               getListItems<DataVector1f>(node, items) ||
+               getListItems<Node>(node, items);
+      }
+
+      inline void setAnyListItems(Node &node,
+                                  const std::vector<std::shared_ptr<Node>> &items)
+      {
+        setListItems<Material>(node, items) ||
+            setListItems<Model>(node, items) ||
+            setListItems<DataVector1f>(node, items) ||
+            setListItems<Node>(node, items);
+      }
+
+      // writing //
+
+      struct Writer
+      {
+        std::vector<NodeRecord> nodes;
+        std::vector<EdgeRecord> edges;
+        std::vector<uint32_t> items;
+        std::string strings;
+
+        //! the memory of the array data of each node
+        std::vector<const void *> data;
+
+        std::unordered_map<std::string, uint32_t> stringIds;
+        std::unordered_map<const Node *, uint32_t> nodeIds;
+        std::set<std::string> checkedTypes;
+
+        uint32_t addString(const std::string &s)
+        {
+          auto found = stringIds.find(s);
+          if (found != stringIds.end())
+            return found->second;
+          const uint32_t id = strings.size();
+          strings.append(s.c_str(), s.size() + 1);
+          stringIds[s] = id;
+          return id;
+        }
+
+        //! whether the node can be cached at all
+        static bool cacheable(Node &node)
+        {
+          auto data = node.tryNodeAs<DataBuffer>();
+          return !data || data->getType() != OSP_OBJECT;
+        }
+
+        //! adds the record of a node, not yet its children
+        uint32_t declare(Node &node, uint32_t flags)
+        {
+          const uint32_t id = nodes.size();
+          nodeIds[&node] = id;
+
+          NodeRecord record;
+          memset(&record, 0, sizeof(record));
+          record.name      = addString(node.name());
+          record.type      = addString(node.type());
+          record.parent    = noNode;
+          record.kind      = KIND_NODE;
+          record.flags     = flags;
+          record.valueType = VALUE_NONE;
+          const void *bytes = nullptr;
+
+          auto dataBuffer = node.tryNodeAs<DataBuffer>();
+          auto texture    = node.tryNodeAs<Texture2D>();
+          if (dataBuffer) {
+            record.kind            = KIND_DATA;
+            record.dataType        = dataBuffer->getType();
+            record.bytesPerElement = dataBuffer->bytesPerElement();
+            record.numBytes        = dataBuffer->numBytes();
+            bytes                  = dataBuffer->base();
+            if (!dispatchArrayType(record.dataType,
+                                   record.bytesPerElement,
+                                   CheckArrayType())) {
+              throw std::runtime_error("#osp:sg: cannot cache array '"
+                                       + node.name() + "' of unsupported type");
+            }
+          } else if (texture) {
+            record.kind = KIND_TEXTURE2D;
+            TextureDescription desc;
+            desc.size          = texture->size;
+            desc.channels      = texture->channels;
+            desc.depth         = texture->depth;
+            desc.preferLinear  = texture->preferLinear;
+            desc.nearestFilter = texture->nearestFilter;
+            memcpy(record.value, &desc, sizeof(desc));
+            record.numBytes =
+                size_t(desc.size.x) * desc.size.y * desc.channels * desc.depth;
+            bytes = texture->data ? texture->data
+                    : texture->texelData ? texture->texelData->base()
+                    : nullptr;
+            if (!bytes)
+              record.numBytes = 0;
+          } else {
+            checkCreatable(node.type());
+            encodeValue<bool>(node, VALUE_BOOL, record) ||
+                encodeValue<int>(node, VALUE_INT, record) ||
+                encodeValue<float>(node, VALUE_FLOAT, record) ||
+                encodeValue<vec2f>(node, VALUE_VEC2F, record) ||
+                encodeValue<vec2i>(node, VALUE_VEC2I, record) ||
+                encodeValue<vec3f>(node, VALUE_VEC3F, record) ||
+                encodeValue<vec3i>(node, VALUE_VEC3I, record) ||
+                encodeValue<vec3fa>(node, VALUE_VEC3FA, record) ||
+                encodeValue<vec4f>(node, VALUE_VEC4F, record) ||
+                encodeValue<box2f>(node, VALUE_BOX2F, record) ||
+                encodeValue<box2i>(node, VALUE_BOX2I, record) ||
+                encodeValue<box3f>(node, VALUE_BOX3F, record) ||
+                encodeValue<box3i>(node, VALUE_BOX3I, record);
+            if (node.valueIsType<std::string>()) {
+              const uint32_t s = addString(node.valueAs<std::string>());
+              memcpy(record.value, &s, sizeof(s));
+              record.valueType = VALUE_STRING;
+            }
+          }
+
+          nodes.push_back(record);
+          data.push_back(bytes);
+          return id;
+        }
+
+        //! nodes are re-created by their type on load
+        void checkCreatable(const std::string &type)
+        {
+          if (!checkedTypes.insert(type).second)
+            return;
+          // throws for types without registered creation function
+          createNode("scene cache type check", type);
+        }
+
+        //! adds the links to the children and list items of a declared node
+        void expand(Node &node, uint32_t id)
+        {
+          for (const auto &child : node.children()) {
+            Node &c = *child.second;
+            if (!cacheable(c))
+              continue;
+            auto found = nodeIds.find(&c);
+            const bool isNew = found == nodeIds.end();
+            const uint32_t childId = isNew ? declare(c, 0) : found->second;
+            edges.push_back({id, childId, addString(child.first)});
+            if (isNew)
+              expand(c, childId);
+          }
+
+          std::vector<Node *> listItems;
+          if (getAnyListItems(node, listItems)) {
+            std::vector<uint32_t> itemIds;
+            for (Node *item : listItems) {
+              if (!cacheable(*item))
+                continue;
+              auto found = nodeIds.find(item);
+              uint32_t itemId;
+              if (found == nodeIds.end()) {
+                itemId = declare(*item, FLAG_LIST_ITEM);
+                expand(*item, itemId);
+              } else {
+                itemId = found->second;
+                nodes[itemId].flags |= FLAG_LIST_ITEM;
+              }
+              itemIds.push_back(itemId);
+            }
+            nodes[id].firstItem = items.size();
+            nodes[id].numItems  = itemIds.size();
+            items.insert(items.end(), itemIds.begin(), itemIds.end());
+          }
+        }
+
+        void resolveParents()
+        {
+          for (const auto &n : nodeIds) {
+            if (n.first->hasParent()) {
+              auto parent = nodeIds.find(&n.first->parent());
+              if (parent != nodeIds.end())
+                nodes[n.second].parent = parent->second;
+            }
+          }
+        }
+      };
+
+      inline size_t alignUp(size_t offset)
+      {
+        return (offset + alignment - 1) / alignment * alignment;
+      }
+
+      inline void writeBytes(FILE *file, const void *bytes, size_t numBytes)
+      {
+        if (numBytes > 0 && fwrite(bytes, numBytes, 1, file) != 1)
+          throw std::runtime_error("#osp:sg: error writing scene cache");
+      }
+
+      inline void writePadding(FILE *file, size_t &offset)
+      {
+        static const char zeros[alignment] = {0};
+        const size_t aligned = alignUp(offset);
+        writeBytes(file, zeros, aligned - offset);
+        offset = aligned;
+      }
+
+    } // ::ospray::sg::scenecache
+
+    void writeSceneCache(const std::shared_ptr<Node> &root,
+                         const std::string &fileName,
+                         const std::vector<std::string> &skipChildren)
+    {
+      using namespace scenecache;
+
+      Writer writer;
+      for (const auto &child : root->children()) {
+        if (std::find(skipChildren.begin(), skipChildren.end(), child.first)
+            != skipChildren.end() || !Writer::cacheable(*child.second))
+          continue;
+        Node &c = *child.second;
+        auto found = writer.nodeIds.find(&c);
+        const bool isNew = found == writer.nodeIds.end();
+        const uint32_t id = isNew ? writer.declare(c, 0) : found->second;
+        writer.edges.push_back({noNode, id, writer.addString(child.first)});
+        if (isNew)
+          writer.expand(c, id);
+      }
+      writer.resolveParents();
+
+      // layout //
+
+      FileHeader header;
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, magic, sizeof(magic));
+      header.version  = version;
+      header.numNodes = writer.nodes.size();
+      header.numEdges = writer.edges.size();
+      header.numItems = writer.items.size();
+
+      size_t offset = sizeof(FileHeader);
+      header.stringsOffset = offset;
+      header.stringsSize   = writer.strings.size();
+      offset = alignUp(offset + writer.strings.size());
+      header.nodesOffset = offset;
+      offset = alignUp(offset + writer.nodes.size() * sizeof(NodeRecord));
+      header.edgesOffset = offset;
+      offset = alignUp(offset + writer.edges.size() * sizeof(EdgeRecord));
+      header.itemsOffset = offset;
+      offset = alignUp(offset + writer.items.size() * sizeof(uint32_t));
+      for (auto &record : writer.nodes) {
+        record.dataOffset = offset;
+        offset = alignUp(offset + record.numBytes);
+      }
+      header.fileSize = offset;
+
+      // write //
+
+      FILE *file = fopen(fileName.c_str(), "wb");
+      if (!file) {
+        throw std::runtime_error("#osp:sg: could not open scene cache '"
+                                 + fileName + "' for writing");
+      }
+
+      try {
+        offset = 0;
+        auto write = [&](const void *bytes, size_t numBytes) {
+          writeBytes(file, bytes, numBytes);
+          offset += numBytes;
+          writePadding(file, offset);
+        };
+
+        writeBytes(file, &header, sizeof(header));
+        offset = sizeof(header);
+        write(writer.strings.data(), writer.strings.size());
+        write(writer.nodes.data(), writer.nodes.size() * sizeof(NodeRecord));
+        write(writer.edges.data(), writer.edges.size() * sizeof(EdgeRecord));
+        write(writer.items.data(), writer.items.size() * sizeof(uint32_t));
+        for (size_t i = 0; i < writer.nodes.size(); i++)
+          write(writer.data[i], writer.nodes[i].numBytes);
+      } catch (const std::runtime_error &) {
+        fclose(file);
+        remove(fileName.c_str());
+        throw;
+      }
+
+      fclose(file);
+    }
+
+    void loadSceneCache(const std::shared_ptr<Node> &world,
+                        const std::string &fileName)
+    {
+      using namespace scenecache;
+
+      auto file = std::make_shared<MappedFile>(fileName);
+      const unsigned char *base = file->data();
+      const size_t fileSize     = file->size();
+
+      auto corrupt = [&]() {
+        return std::runtime_error("#osp:sg: '" + fileName
+                                  + "' is no valid scene cache");
+      };
+
+      if (fileSize < sizeof(FileHeader))
+        throw corrupt();
+      FileHeader header;
+      memcpy(&header, base, sizeof(header));
+      if (memcmp(header.magic, magic, sizeof(magic)) != 0)
+        throw corrupt();
+      if (header.version != version) {
+        throw std::runtime_error("#osp:sg: scene cache '" + fileName
+                                 + "' is of unsupported version "
+                                 + std::to_string(header.version));
+      }
+      if (header.fileSize != fileSize ||
+          header.stringsOffset + header.stringsSize > fileSize ||
+          header.nodesOffset + header.numNodes * sizeof(NodeRecord) > fileSize ||
+          header.edgesOffset + header.numEdges * sizeof(EdgeRecord) > fileSize ||
+          header.itemsOffset + header.numItems * sizeof(uint32_t) > fileSize) {
+        throw corrupt();
+      }
+
+      const char *strings = (const char *)base + header.stringsOffset;
+      const auto *records = (const NodeRecord *)(base + header.nodesOffset);
+      const auto *edges   = (const EdgeRecord *)(base + header.edgesOffset);
+      const auto *items   = (const uint32_t *)(base + header.itemsOffset);
+
+      auto string = [&](uint32_t offset) -> std::string {
+        if (offset >= header.stringsSize)
+          throw corrupt();
+        return std::string(strings + offset,
+                           strnlen(strings + offset,
+                                   header.stringsSize - offset));
+      };
+
+      for (uint32_t i = 0; i < header.numNodes; i++) {
+        const auto &record = records[i];
+        if (record.dataOffset + record.numBytes > fileSize ||
+            (record.parent != noNode && record.parent >= header.numNodes) ||
+            record.firstItem + uint64_t(record.numItems) > header.numItems)
+          throw corrupt();
+      }
+
+      // node creation //
+
+      auto setValue = [&](Node &node, const NodeRecord &record) {
+        switch (record.valueType) {
+        case VALUE_BOOL:   decodeValue<bool>(node, record);   break;
+        case VALUE_INT:    decodeValue<int>(node, record);    break;
+        case VALUE_FLOAT:  decodeValue<float>(node, record);  break;
+        case VALUE_VEC2F:  decodeValue<vec2f>(node, record);  break;
+        case VALUE_VEC2I:  decodeValue<vec2i>(node, record);  break;
+        case VALUE_VEC3F:  decodeValue<vec3f>(node, record);  break;
+        case VALUE_VEC3I:  decodeValue<vec3i>(node, record);  break;
+        case VALUE_VEC3FA: decodeValue<vec3fa>(node, record); break;
+        case VALUE_VEC4F:  decodeValue<vec4f>(node, record);  break;
+        case VALUE_BOX2F:  decodeValue<box2f>(node, record);  break;
+        case VALUE_BOX2I:  decodeValue<box2i>(node, record);  break;
+        case VALUE_BOX3F:  decodeValue<box3f>(node, record);  break;
+        case VALUE_BOX3I:  decodeValue<box3i>(node, record);  break;
+        case VALUE_STRING: {
+          uint32_t s;
+          memcpy(&s, record.value, sizeof(s));
+          node.setValue(string(s));
+          break;
+        }
+        default:
+          break;
+        }
+      };
+
+      auto mappedArray = [&](const NodeRecord &record) {
+        MakeMappedArray make(file, record);
+        if (!dispatchArrayType(record.dataType, record.bytesPerElement, make))
+          throw corrupt();
+        make.result->setName(string(record.name));
+        return make.result;
+      };
+
+      // fills existing nodes, returns false if the types don't fit
+      auto fill = [&](Node &node, const NodeRecord &record) {
+        if (record.kind == KIND_DATA) {
+          FillVector fill(node, base + record.dataOffset, record);
+          dispatchArrayType(record.dataType, record.bytesPerElement, fill);
+          return fill.filled;
+        } else if (record.kind == KIND_TEXTURE2D) {
+          auto texture = dynamic_cast<Texture2D *>(&node);
+          if (!texture)
+            return false;
+          TextureDescription desc;
+          memcpy(&desc, record.value, sizeof(desc));
+          texture->size          = desc.size;
+          texture->channels      = desc.channels;
+          texture->depth         = desc.depth;
+          texture->preferLinear  = desc.preferLinear;
+          texture->nearestFilter = desc.nearestFilter;
+          texture->data          = nullptr;
+          if (record.numBytes > 0) {
+            auto texels = std::make_shared<DataArray1uc>(
+                (unsigned char *)(base + record.dataOffset), record.numBytes);
+            texels->deleter = [file](unsigned char *) {};
+            texture->texelData = texels;
+          }
+          return true;
+        }
+        setValue(node, record);
+        return true;
+      };
+
+      auto create = [&](const NodeRecord &record) -> std::shared_ptr<Node> {
+        const std::string type = string(record.type);
+        if (record.kind == KIND_DATA && !(record.flags & FLAG_LIST_ITEM))
+          return mappedArray(record);
+
+        std::shared_ptr<Node> node;
+        try {
+          node = createNode(string(record.name),
+                            record.kind == KIND_TEXTURE2D ? "Texture2D" : type);
+        } catch (const std::runtime_error &) {
+          if (record.kind != KIND_DATA)
+            throw;
+          // arrays not created as DataVector, e.g. DataArrays
+          return mappedArray(record);
+        }
+        if (!fill(*node, record))
+          throw corrupt();
+        return node;
+      };
+
+      std::vector<std::shared_ptr<Node>> nodes(header.numNodes);
+
+      for (uint32_t e = 0; e < header.numEdges; e++) {
+        const auto &edge = edges[e];
+        if (edge.child >= header.numNodes ||
+            (edge.parent != noNode &&
+             (edge.parent >= header.numNodes || !nodes[edge.parent])))
+          throw corrupt();
+
+        Node &parent    = edge.parent == noNode ? *world : *nodes[edge.parent];
+        const auto name = string(edge.name);
+        auto &node      = nodes[edge.child];
+
+        if (!node) {
+          // re-use the children parents create themselves, which keeps
+          // their limits, flags and documentation
+          const auto &record = records[edge.child];
+          if (record.parent == edge.parent && parent.hasChild(name) &&
+              parent[name].type() == string(record.type) &&
+              fill(parent[name], record)) {
+            node = parent[name].shared_from_this();
+            continue;
+          }
+          node = create(record);
+        }
+
+        parent.setChild(name, node);
+      }
+
+      // nodes only referenced by lists
+      for (uint32_t i = 0; i < header.numNodes; i++)
+        if (!nodes[i])
+          nodes[i] = create(records[i]);
+
+      for (uint32_t i = 0; i < header.numNodes; i++) {
+        const auto &record = records[i];
+        if (record.numItems > 0) {
+          std::vector<std::shared_ptr<Node>> listItems;
+          for (uint32_t j = 0; j < record.numItems; j++) {
+            const uint32_t item = items[record.firstItem + j];
+            if (item >= header.numNodes)
+              throw corrupt();
+            listItems.push_back(nodes[item]);
+          }
+          setAnyListItems(*nodes[i], listItems);
+        }
+        if (record.parent != noNode)
+          nodes[i]->setParent(*nodes[record.parent]);
+      }
+    }
+
+  } // ::ospray::sg
+} // ::ospray
@@ -376,10 +376,25 @@ namespace ospray {
     void importCHOMBO(const std::shared_ptr<Node> &world,
                       const FileName &fileName)
     {
+      // asynchronous imports show the root level until all are read
+      if (importIsProgressive()) {
+        auto coarse =
+            sg::createNode("amr", "AMRVolume")->nodeAs<sg::AMRVolume>();
+        parseAMRChomboFile(coarse, fileName, "", nullptr, 0);
+        coarse->child("transferFunction")["valueRange"] =
+            coarse->valueRange.toVec2f();
+        publishImported(world, [=](const std::shared_ptr<Node> &world) {
+          world->add(coarse);
+        });
+        reportImportProgress(0.5f);
+      }
+
       auto node = sg::createNode("amr", "AMRVolume")->nodeAs<sg::AMRVolume>();
       parseAMRChomboFile(node, fileName);
       node->child("transferFunction")["valueRange"] = node->valueRange.toVec2f();
-      world->add(node);
+      publishImported(world, [=](const std::shared_ptr<Node> &world) {
+        world->add(node);
+      });
     }
 
   }  // ::ospray::sg
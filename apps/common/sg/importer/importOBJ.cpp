@@ -25,7 +25,14 @@
 #define TINYOBJLOADER_IMPLEMENTATION  // define this in only *one* .cc
 #include "../3rdParty/tiny_obj_loader.h"
 
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstring>
+#include <map>
 #include <sstream>
 
 #define USE_INSTANCES 0
@@ -89,6 +96,64 @@ namespace ospray {
       }
     }
 
+    /*! loads the textures referenced by mats in parallel into Texture2D's
+        cache, from where createSgMaterials() then picks them up */
+    static void preloadTextures(const std::vector<tinyobj::material_t> &mats,
+                                const FileName &containingPath)
+    {
+      struct TextureFile
+      {
+        FileName fileName;
+        bool preferLinear;
+        bool nearestFilter;
+      };
+
+      // in the order createSgMaterials() loads them, as the first load of a
+      // file determines its filtering
+      std::vector<TextureFile> textures;
+      auto addTexture = [&](const std::string &texName,
+                            bool preferLinear = false,
+                            bool nearestFilter = false) {
+        if (texName.empty())
+          return;
+        const FileName fileName = containingPath + texName;
+        for (const auto &t : textures)
+          if (t.fileName.str() == fileName.str())
+            return;
+        textures.push_back({fileName, preferLinear, nearestFilter});
+      };
+
+      for (auto &mat : mats) {
+        bool addOBJparams = true;
+        for (auto &param : mat.unknown_parameter) {
+          if (param.first == "type") {
+            if (param.second != "OBJMaterial" && param.second != "default")
+              addOBJparams = false;
+          } else if (param.first.find("Map") != std::string::npos &&
+                     param.first.find("Map.") == std::string::npos) {
+            bool nearestFilter =
+                (param.first.find("rotation") != std::string::npos) ||
+                (param.first.find("Rotation") != std::string::npos);
+            addTexture(param.second, false, nearestFilter);
+          }
+        }
+
+        if (addOBJparams) {
+          addTexture(mat.diffuse_texname);
+          addTexture(mat.specular_texname);
+          addTexture(mat.specular_highlight_texname, true);
+          addTexture(mat.bump_texname);
+          addTexture(mat.alpha_texname, true);
+        }
+      }
+
+      tasking::parallel_for(textures.size(), [&](size_t i) {
+        Texture2D::load(textures[i].fileName,
+                        textures[i].preferLinear,
+                        textures[i].nearestFilter);
+      });
+    }
+
     static inline std::shared_ptr<MaterialList> createSgMaterials(
         std::vector<tinyobj::material_t> &mats, const FileName &containingPath)
     {
@@ -100,6 +165,8 @@ namespace ospray {
         return sgMaterials;
       }
 
+      preloadTextures(mats, containingPath);
+
       for (auto &mat : mats) {
         auto matNodePtr = createNode(mat.name, "Material")->nodeAs<Material>();
         auto &matNode   = *matNodePtr;
@@ -168,185 +235,653 @@ namespace ospray {
       return sgMaterials;
     }
 
-    void importOBJ(const std::shared_ptr<Node> &world, const FileName &fileName)
-    {
-      tinyobj::attrib_t attrib;
-      std::vector<tinyobj::shape_t> shapes;
-      std::vector<tinyobj::material_t> materials;
+    // parallel OBJ parser ////////////////////////////////////////////////////
 
-      std::string err;
-      const std::string containingPath = fileName.path();
+    /*! The file is mapped into memory and cut into chunks at line
+        boundaries, which are parsed concurrently: a first pass counts the
+        'v', 'vn' and 'vt' lines of each chunk, such that the second pass
+        knows the global offsets to resolve (also relative) face indices.
+        The groups of the chunks are merged afterwards, where a chunk's
+        faces before its first 'g'/'o' continue the last group of the
+        previous chunk. Faces with more than 4 vertices are triangulated as
+        fans, points and lines are skipped. */
+    namespace objparser {
 
-      // Try to load scene without auto-triangulation.  If point, lines,
-      // or polygons are found; reload the scene as a triangle mesh.
-      bool ret;
-      bool needsReload = false;
-      do {
-        ret = tinyobj::LoadObj(&attrib,
-                               &shapes,
-                               &materials,
-                               &err,
-                               fileName.c_str(),
-                               containingPath.c_str(),
-                               needsReload);  // triangulate meshes if true
-
-        auto numQuads = 0;
-        auto numTriangles = 0;
-        needsReload = false;
-        for (auto &shape : shapes) {
-          for (auto numVertsInFace : shape.mesh.num_face_vertices) {
-            numTriangles += (numVertsInFace == 3);
-            numQuads += (numVertsInFace == 4);
-
-            if (numVertsInFace < 3) {
-              std::cerr << "Warning: less than 3 verts in face!\n" <<
-                           "         Lines and points not supported.\n";
-              needsReload = true;
-            }
-            if (numVertsInFace > 4) {
-              std::cerr << "Warning: more than 4 verts in face!\n" <<
-                           "         Polygons not supported.\n";
-              needsReload = true;
-              break;
+      static const size_t chunkSize = 16 * 1024 * 1024;
+
+      struct Chunk
+      {
+        const char *begin;
+        const char *end;
+
+        // counted by the first pass //
+
+        size_t numVertices {0};
+        size_t numNormals {0};
+        size_t numTexcoords {0};
+
+        //! number of the attributes in all previous chunks
+        size_t firstVertex {0};
+        size_t firstNormal {0};
+        size_t firstTexcoord {0};
+
+        // parsed by the second pass //
+
+        std::vector<tinyobj::real_t> vertices;
+        std::vector<tinyobj::real_t> normals;
+        std::vector<tinyobj::real_t> texcoords;
+
+        /*! the groups, shapes[0] continues the previous chunk's last group
+            if !startsGroup */
+        std::vector<tinyobj::shape_t> shapes;
+        bool startsGroup {false};
+
+        /*! the faces' material_ids index materialNames, -1 for faces
+            before the first 'usemtl', i.e. using the previous chunk's */
+        std::vector<std::string> materialNames;
+        //! index into materialNames active at the chunk's end, or -1
+        int lastMaterial {-1};
+
+        //! the filenames of the 'mtllib' lines
+        std::vector<std::string> mtllibs;
+
+        size_t numSkippedFaces {0};
+
+        // resolved by the merge //
+
+        //! global material ID per materialNames
+        std::vector<int> materialIds;
+        //! global material ID active at the chunk's begin
+        int inheritedMaterial {-1};
+      };
+
+      inline bool isSpace(char c)
+      {
+        return c == ' ' || c == '\t';
+      }
+
+      inline void skipSpace(const char *&p, const char *eol)
+      {
+        while (p < eol && isSpace(*p))
+          p++;
+      }
+
+      //! the end of the line starting at p, without any '\r'
+      inline const char *endOfLine(const char *p, const char *end,
+                                   const char *&next)
+      {
+        const char *eol = (const char *)memchr(p, '\n', end - p);
+        next = eol ? eol + 1 : end;
+        eol  = eol ? eol : end;
+        while (eol > p && eol[-1] == '\r')
+          eol--;
+        return eol;
+      }
+
+      //! consumes keyword kw if followed by a space or the end of the line
+      inline bool keyword(const char *&p, const char *eol, const char *kw)
+      {
+        const size_t n = strlen(kw);
+        if (size_t(eol - p) < n || strncmp(p, kw, n) != 0 ||
+            (p + n < eol && !isSpace(p[n])))
+          return false;
+        p += n;
+        return true;
+      }
+
+      //! the rest of the line, without leading and trailing whitespace
+      inline std::string restOfLine(const char *p, const char *eol)
+      {
+        skipSpace(p, eol);
+        while (eol > p && isSpace(eol[-1]))
+          eol--;
+        return std::string(p, eol);
+      }
+
+      inline bool parseInt(const char *&p, const char *eol, int &value)
+      {
+        const char *q = p;
+        const bool negative = q < eol && *q == '-';
+        if (q < eol && (*q == '-' || *q == '+'))
+          q++;
+        if (q == eol || !isdigit(*q))
+          return false;
+
+        int64_t v = 0;
+        while (q < eol && isdigit(*q))
+          v = 10 * v + (*q++ - '0');
+
+        value = negative ? -v : v;
+        p     = q;
+        return true;
+      }
+
+      //! parses a number, or returns defaultValue at the end of the line
+      inline tinyobj::real_t parseReal(const char *&p, const char *eol,
+                                       tinyobj::real_t defaultValue)
+      {
+        skipSpace(p, eol);
+        if (p == eol)
+          return defaultValue;
+
+        // fast path for [+-]digits[.digits][(e|E)[+-]digits]
+        const char *q = p;
+        const bool negative = *q == '-';
+        if (*q == '-' || *q == '+')
+          q++;
+
+        uint64_t mantissa = 0;
+        int digits   = 0;
+        int exponent = 0;
+        bool any     = false;
+        for (; q < eol && isdigit(*q); q++, any = true) {
+          if (digits < 18) {
+            mantissa = 10 * mantissa + (*q - '0');
+            digits += mantissa != 0;
+          } else {
+            exponent++;
+          }
+        }
+        if (q < eol && *q == '.') {
+          for (q++; q < eol && isdigit(*q); q++, any = true) {
+            if (digits < 18) {
+              mantissa = 10 * mantissa + (*q - '0');
+              digits += mantissa != 0;
+              exponent--;
             }
           }
         }
+        if (any && q < eol && (*q == 'e' || *q == 'E')) {
+          const char *e = q + 1;
+          int expValue;
+          if (parseInt(e, eol, expValue)) {
+            exponent += expValue;
+            q = e;
+          }
+        }
 
-        if (needsReload) {
-          std::cerr << "         Reloading as a triangle mesh.\n";
-
-          // Clear vectors from previous load
-          shapes.clear();
-          materials.clear();
-          attrib.vertices.clear();
-          attrib.normals.clear();
-          attrib.texcoords.clear();
-        } else {
-          std::cout << "... found " << numTriangles << " triangles " <<
-                       "and " << numQuads << " quads.\n";
+        if (any && (q == eol || isSpace(*q))) {
+          p = q;
+          double value = double(mantissa);
+          if (exponent < 0)
+            value /= std::pow(10.0, -exponent);
+          else if (exponent > 0)
+            value *= std::pow(10.0, exponent);
+          return tinyobj::real_t(negative ? -value : value);
         }
-      } while (needsReload);
 
-#if 0 // NOTE(jda) - enable if you want to see warnings from TinyOBJ
-      if (!err.empty())
-        std::cerr << "#ospsg: obj parsing warning(s)...\n" << err << std::endl;
-#endif
+        // anything else, like "nan", "inf" or hexadecimal floats
+        char buffer[64];
+        size_t n = 0;
+        while (p < eol && !isSpace(*p)) {
+          if (n < sizeof(buffer) - 1)
+            buffer[n++] = *p;
+          p++;
+        }
+        buffer[n] = '\0';
+        return tinyobj::real_t(strtod(buffer, nullptr));
+      }
 
-      if (!ret) {
-        std::cerr << "#ospsg: FATAL error parsing obj file, no geometry added"
-                  << " to the scene!" << std::endl;
-        return;
+      //! the 0-based index of a 1-based or relative (negative) index
+      inline int resolveIndex(int index, size_t numBefore, size_t numTotal)
+      {
+        const int64_t resolved =
+            index > 0 ? int64_t(index) - 1 : int64_t(numBefore) + index;
+        return (index == 0 || resolved < 0 || resolved >= int64_t(numTotal))
+                   ? -1 : int(resolved);
       }
 
-      auto sgMaterials = createSgMaterials(materials, containingPath);
+      //! first pass: counts the attributes of the chunk
+      inline void countAttributes(Chunk &chunk)
+      {
+        const char *next;
+        for (const char *p = chunk.begin; p < chunk.end; p = next) {
+          const char *eol = endOfLine(p, chunk.end, next);
+          skipSpace(p, eol);
+          if (keyword(p, eol, "v"))
+            chunk.numVertices++;
+          else if (keyword(p, eol, "vn"))
+            chunk.numNormals++;
+          else if (keyword(p, eol, "vt"))
+            chunk.numTexcoords++;
+        }
+      }
 
-      std::string base_name = fileName.name() + '_';
-      int shapeId           = 0;
+      //! second pass: parses the chunk, given the totals of the file
+      inline void parseChunk(Chunk &chunk,
+                             size_t numVertices,
+                             size_t numNormals,
+                             size_t numTexcoords)
+      {
+        chunk.vertices.reserve(3 * chunk.numVertices);
+        chunk.normals.reserve(3 * chunk.numNormals);
+        chunk.texcoords.reserve(2 * chunk.numTexcoords);
+
+        int material = -1;
+        std::vector<tinyobj::index_t> face;
+
+        const char *next;
+        for (const char *p = chunk.begin; p < chunk.end; p = next) {
+          const char *eol = endOfLine(p, chunk.end, next);
+          skipSpace(p, eol);
+          if (p == eol || *p == '#')
+            continue;
+
+          if (keyword(p, eol, "v")) {
+            chunk.vertices.push_back(parseReal(p, eol, 0.f));
+            chunk.vertices.push_back(parseReal(p, eol, 0.f));
+            chunk.vertices.push_back(parseReal(p, eol, 0.f));
+          } else if (keyword(p, eol, "vn")) {
+            chunk.normals.push_back(parseReal(p, eol, 0.f));
+            chunk.normals.push_back(parseReal(p, eol, 0.f));
+            chunk.normals.push_back(parseReal(p, eol, 0.f));
+          } else if (keyword(p, eol, "vt")) {
+            chunk.texcoords.push_back(parseReal(p, eol, 0.f));
+            chunk.texcoords.push_back(parseReal(p, eol, 0.f));
+          } else if (keyword(p, eol, "f")) {
+            const size_t vBefore  = chunk.firstVertex + chunk.vertices.size() / 3;
+            const size_t vnBefore = chunk.firstNormal + chunk.normals.size() / 3;
+            const size_t vtBefore =
+                chunk.firstTexcoord + chunk.texcoords.size() / 2;
+
+            face.clear();
+            bool valid = true;
+            for (skipSpace(p, eol); p < eol; skipSpace(p, eol)) {
+              tinyobj::index_t idx {-1, -1, -1};
+              int v;
+              if (!parseInt(p, eol, v)) {
+                valid = false;
+                break;
+              }
+              idx.vertex_index = resolveIndex(v, vBefore, numVertices);
+              valid &= idx.vertex_index >= 0;
+              if (p < eol && *p == '/') {
+                p++;
+                int vt;
+                if (parseInt(p, eol, vt))
+                  idx.texcoord_index = resolveIndex(vt, vtBefore, numTexcoords);
+                if (p < eol && *p == '/') {
+                  p++;
+                  int vn;
+                  if (parseInt(p, eol, vn))
+                    idx.normal_index = resolveIndex(vn, vnBefore, numNormals);
+                }
+              }
+              // skip anything else of the token
+              while (p < eol && !isSpace(*p))
+                p++;
+              face.push_back(idx);
+            }
 
-      std::cout << "...adding found triangle & quad groups to the scene...\n";
+            if (!valid || face.size() < 3) {
+              chunk.numSkippedFaces++;
+              continue;
+            }
 
-      size_t shapeCounter = 0;
-      size_t numShapes    = shapes.size();
-      size_t increment    = numShapes / size_t(10);
-      int    incrementer  = 0;
+            if (chunk.shapes.empty())
+              chunk.shapes.emplace_back();
+            auto &mesh = chunk.shapes.back().mesh;
+
+            if (face.size() <= 4) {
+              mesh.indices.insert(mesh.indices.end(), face.begin(), face.end());
+              mesh.num_face_vertices.push_back(face.size());
+              mesh.material_ids.push_back(material);
+            } else {
+              for (size_t k = 1; k + 1 < face.size(); k++) {
+                mesh.indices.push_back(face[0]);
+                mesh.indices.push_back(face[k]);
+                mesh.indices.push_back(face[k + 1]);
+                mesh.num_face_vertices.push_back(3);
+                mesh.material_ids.push_back(material);
+              }
+            }
+          } else if (keyword(p, eol, "g") || keyword(p, eol, "o")) {
+            chunk.startsGroup |= chunk.shapes.empty();
+            chunk.shapes.emplace_back();
+            chunk.shapes.back().name = restOfLine(p, eol);
+          } else if (keyword(p, eol, "usemtl")) {
+            const std::string name = restOfLine(p, eol);
+            auto found = std::find(chunk.materialNames.begin(),
+                                   chunk.materialNames.end(),
+                                   name);
+            material = found - chunk.materialNames.begin();
+            if (found == chunk.materialNames.end())
+              chunk.materialNames.push_back(name);
+            chunk.lastMaterial = material;
+          } else if (keyword(p, eol, "mtllib")) {
+            chunk.mtllibs.push_back(restOfLine(p, eol));
+          }
+        }
+      }
 
-#if !USE_INSTANCES
-      auto objInstance = createNode("instance", "Instance");
-      world->add(objInstance);
-#endif
-      for (auto &shape : shapes) {
+      /*! parses an OBJ file in parallel into tinyobj's representation,
+          returns false if the file cannot be read */
+      bool loadObj(tinyobj::attrib_t &attrib,
+                   std::vector<tinyobj::shape_t> &shapes,
+                   std::vector<tinyobj::material_t> &materials,
+                   const FileName &fileName)
+      {
+        std::unique_ptr<MappedFile> file;
+        try {
+          file.reset(new MappedFile(fileName.str()));
+        } catch (const std::runtime_error &) {
+          return false;
+        }
+        const char *fileBegin = (const char *)file->data();
+        const char *fileEnd   = fileBegin + file->size();
+
+        // split at line boundaries //
+
+        std::vector<Chunk> chunks;
+        for (const char *p = fileBegin; p < fileEnd;) {
+          const char *end = fileEnd;
+          if (size_t(fileEnd - p) > chunkSize) {
+            const char *eol =
+                (const char *)memchr(p + chunkSize, '\n',
+                                     fileEnd - (p + chunkSize));
+            end = eol ? eol + 1 : fileEnd;
+          }
+          Chunk chunk;
+          chunk.begin = p;
+          chunk.end   = end;
+          chunks.push_back(std::move(chunk));
+          p = end;
+        }
 
-        if (shapeCounter++ > (increment * incrementer + 1))
-          std::cout << incrementer++ * 10 << "%\n";
-
-        auto name = base_name + std::to_string(shapeId++) + '_' + shape.name;
-        auto mesh = createNode(name, "QuadMesh")->nodeAs<QuadMesh>();
-
-        auto v = createNode("vertex", "DataVector3f")->nodeAs<DataVector3f>();
-        auto numSrcIndices = shape.mesh.indices.size();
-        v->v.reserve(numSrcIndices);
-
-        auto vi = createNode("index", "DataVector4i")->nodeAs<DataVector4i>();
-        vi->v.reserve(numSrcIndices / 4);
-
-        auto vn = createNode("vertex.normal", "DataVector3f")->nodeAs<DataVector3f>();
-        vn->v.reserve(numSrcIndices);
-
-        auto vt =
-            createNode("vertex.texcoord", "DataVector2f")->nodeAs<DataVector2f>();
-        vt->v.reserve(numSrcIndices);
-
-        // OSPRay doesn't support separate arrays for vertex, normal & texcoord
-        // indices.  So, reindex by creating a single index array then push_back
-        // attribs according to each of their own index arrays.
-        // Put all indices into a single vec4.  Triangles duplicate the last
-        // index.
-        size_t i = 0;
-        for (int numVertsInFace : shape.mesh.num_face_vertices) {
-          auto isQuad = (numVertsInFace == 4);
-          // when a Quad then use same splitting diagonale in OSPRay/Embree as
-          // tinyOBJ would use
-          auto prim_indices = isQuad ? vec4i(3, 0, 1, 2) : vec4i(0, 1, 2, 2);
-          vi->push_back(i + prim_indices);
-          i += numVertsInFace;
+        const size_t numChunks = chunks.size();
+        tasking::parallel_for(numChunks, [&](size_t i) {
+          countAttributes(chunks[i]);
+        });
+
+        size_t numVertices  = 0;
+        size_t numNormals   = 0;
+        size_t numTexcoords = 0;
+        for (auto &chunk : chunks) {
+          chunk.firstVertex   = numVertices;
+          chunk.firstNormal   = numNormals;
+          chunk.firstTexcoord = numTexcoords;
+          numVertices  += chunk.numVertices;
+          numNormals   += chunk.numNormals;
+          numTexcoords += chunk.numTexcoords;
         }
 
-        for (size_t i = 0; i < numSrcIndices; i++) {
-          auto idx = shape.mesh.indices[i];
+        tasking::parallel_for(numChunks, [&](size_t i) {
+          parseChunk(chunks[i], numVertices, numNormals, numTexcoords);
+        });
+
+        // materials, loaded in the order of the 'mtllib' lines //
+
+        std::map<std::string, int> materialMap;
+        tinyobj::MaterialFileReader readMaterials(fileName.path());
+        for (auto &chunk : chunks) {
+          for (auto &line : chunk.mtllibs) {
+            std::vector<std::string> filenames;
+            tinyobj::SplitString(line, ' ', filenames);
+            for (auto &filename : filenames) {
+              if (filename.empty())
+                continue;
+              std::string err;
+              if (readMaterials(filename, &materials, &materialMap, &err))
+                break;
+            }
+          }
+        }
+
+        int material = -1;
+        size_t numSkippedFaces = 0;
+        for (auto &chunk : chunks) {
+          chunk.inheritedMaterial = material;
+          for (auto &name : chunk.materialNames) {
+            auto found = materialMap.find(name);
+            chunk.materialIds.push_back(found == materialMap.end() ?
+                                        -1 : found->second);
+          }
+          if (chunk.lastMaterial >= 0)
+            material = chunk.materialIds[chunk.lastMaterial];
+          numSkippedFaces += chunk.numSkippedFaces;
+        }
 
-          v->push_back(vec3f(attrib.vertices[idx.vertex_index * 3 + 0],
-                             attrib.vertices[idx.vertex_index * 3 + 1],
-                             attrib.vertices[idx.vertex_index * 3 + 2]));
+        if (numSkippedFaces > 0) {
+          std::cerr << "Warning: skipped " << numSkippedFaces << " faces with"
+                    << " less than 3 (valid) verts!\n"
+                    << "         Lines and points not supported.\n";
+        }
 
-          // TODO create missing normals&texcoords if only some faces have them
-          if (!attrib.normals.empty() && idx.normal_index != -1) {
-            vn->push_back(vec3f(attrib.normals[idx.normal_index * 3 + 0],
-                                attrib.normals[idx.normal_index * 3 + 1],
-                                attrib.normals[idx.normal_index * 3 + 2]));
+        // merge the groups of the chunks //
+
+        struct Fragment
+        {
+          const Chunk *chunk;
+          const tinyobj::shape_t *src;
+          size_t dst;
+          size_t firstIndex;
+          size_t firstFace;
+        };
+
+        std::vector<Fragment> fragments;
+        std::vector<std::pair<size_t, size_t>> shapeSizes; // indices, faces
+        for (auto &chunk : chunks) {
+          for (size_t s = 0; s < chunk.shapes.size(); s++) {
+            if (s > 0 || chunk.startsGroup || shapes.empty()) {
+              shapes.emplace_back();
+              shapes.back().name = chunk.shapes[s].name;
+              shapeSizes.emplace_back(0, 0);
+            }
+            auto &src  = chunk.shapes[s];
+            auto &size = shapeSizes.back();
+            fragments.push_back({&chunk, &src, shapes.size() - 1,
+                                 size.first, size.second});
+            size.first  += src.mesh.indices.size();
+            size.second += src.mesh.num_face_vertices.size();
           }
+        }
+
+        for (size_t s = 0; s < shapes.size(); s++) {
+          shapes[s].mesh.indices.resize(shapeSizes[s].first);
+          shapes[s].mesh.num_face_vertices.resize(shapeSizes[s].second);
+          shapes[s].mesh.material_ids.resize(shapeSizes[s].second);
+        }
 
-          if (!attrib.texcoords.empty() && idx.texcoord_index != -1) {
-            vt->push_back(vec2f(attrib.texcoords[idx.texcoord_index * 2 + 0],
-                                attrib.texcoords[idx.texcoord_index * 2 + 1]));
+        attrib.vertices.resize(3 * numVertices);
+        attrib.normals.resize(3 * numNormals);
+        attrib.texcoords.resize(2 * numTexcoords);
+
+        tasking::parallel_for(numChunks + fragments.size(), [&](size_t i) {
+          if (i < numChunks) {
+            auto &chunk = chunks[i];
+            std::copy(chunk.vertices.begin(), chunk.vertices.end(),
+                      attrib.vertices.begin() + 3 * chunk.firstVertex);
+            std::copy(chunk.normals.begin(), chunk.normals.end(),
+                      attrib.normals.begin() + 3 * chunk.firstNormal);
+            std::copy(chunk.texcoords.begin(), chunk.texcoords.end(),
+                      attrib.texcoords.begin() + 2 * chunk.firstTexcoord);
+            return;
           }
+
+          const auto &f   = fragments[i - numChunks];
+          const auto &src = f.src->mesh;
+          auto &dst       = shapes[f.dst].mesh;
+          std::copy(src.indices.begin(), src.indices.end(),
+                    dst.indices.begin() + f.firstIndex);
+          std::copy(src.num_face_vertices.begin(),
+                    src.num_face_vertices.end(),
+                    dst.num_face_vertices.begin() + f.firstFace);
+          std::transform(src.material_ids.begin(), src.material_ids.end(),
+                         dst.material_ids.begin() + f.firstFace,
+                         [&](int id) {
+                           return id < 0 ? f.chunk->inheritedMaterial
+                                         : f.chunk->materialIds[id];
+                         });
+        });
+
+        shapes.erase(std::remove_if(shapes.begin(), shapes.end(),
+                                    [](const tinyobj::shape_t &shape) {
+                                      return shape.mesh.indices.empty();
+                                    }),
+                     shapes.end());
+
+        return true;
+      }
+
+    } // ::ospray::sg::objparser
+
+    //! converts a shape into a QuadMesh, without its materials
+    static std::shared_ptr<QuadMesh> createQuadMesh(
+        const std::string &name,
+        const tinyobj::shape_t &shape,
+        const tinyobj::attrib_t &attrib)
+    {
+      auto mesh = createNode(name, "QuadMesh")->nodeAs<QuadMesh>();
+
+      auto v = createNode("vertex", "DataVector3f")->nodeAs<DataVector3f>();
+      auto numSrcIndices = shape.mesh.indices.size();
+      v->v.reserve(numSrcIndices);
+
+      auto vi = createNode("index", "DataVector4i")->nodeAs<DataVector4i>();
+      vi->v.reserve(numSrcIndices / 4);
+
+      auto vn = createNode("vertex.normal", "DataVector3f")->nodeAs<DataVector3f>();
+      vn->v.reserve(numSrcIndices);
+
+      auto vt =
+          createNode("vertex.texcoord", "DataVector2f")->nodeAs<DataVector2f>();
+      vt->v.reserve(numSrcIndices);
+
+      // OSPRay doesn't support separate arrays for vertex, normal & texcoord
+      // indices.  So, reindex by creating a single index array then push_back
+      // attribs according to each of their own index arrays.
+      // Put all indices into a single vec4.  Triangles duplicate the last
+      // index.
+      size_t i = 0;
+      for (int numVertsInFace : shape.mesh.num_face_vertices) {
+        auto isQuad = (numVertsInFace == 4);
+        // when a Quad then use same splitting diagonale in OSPRay/Embree as
+        // tinyOBJ would use
+        auto prim_indices = isQuad ? vec4i(3, 0, 1, 2) : vec4i(0, 1, 2, 2);
+        vi->push_back(i + prim_indices);
+        i += numVertsInFace;
+      }
+
+      for (size_t i = 0; i < numSrcIndices; i++) {
+        auto idx = shape.mesh.indices[i];
+
+        v->push_back(vec3f(attrib.vertices[idx.vertex_index * 3 + 0],
+                           attrib.vertices[idx.vertex_index * 3 + 1],
+                           attrib.vertices[idx.vertex_index * 3 + 2]));
+
+        // TODO create missing normals&texcoords if only some faces have them
+        if (!attrib.normals.empty() && idx.normal_index != -1) {
+          vn->push_back(vec3f(attrib.normals[idx.normal_index * 3 + 0],
+                              attrib.normals[idx.normal_index * 3 + 1],
+                              attrib.normals[idx.normal_index * 3 + 2]));
         }
 
-        mesh->add(v);
-        mesh->add(vi);
-        if (!vn->empty())
-          mesh->add(vn);
-        if (!vt->empty())
-          mesh->add(vt);
+        if (!attrib.texcoords.empty() && idx.texcoord_index != -1) {
+          vt->push_back(vec2f(attrib.texcoords[idx.texcoord_index * 2 + 0],
+                              attrib.texcoords[idx.texcoord_index * 2 + 1]));
+        }
+      }
 
-        auto pmids = createNode("prim.materialID",
-                                "DataVector1i")->nodeAs<DataVector1i>();
+      mesh->add(v);
+      mesh->add(vi);
+      if (!vn->empty())
+        mesh->add(vn);
+      if (!vt->empty())
+        mesh->add(vt);
 
-        auto numMatIds = shape.mesh.material_ids.size();
-        pmids->v.reserve(numMatIds);
+      auto pmids = createNode("prim.materialID",
+                              "DataVector1i")->nodeAs<DataVector1i>();
 
-        for (auto id : shape.mesh.material_ids)
-          pmids->v.push_back(id);
+      auto numMatIds = shape.mesh.material_ids.size();
+      pmids->v.reserve(numMatIds);
 
-        mesh->add(pmids);
-        mesh->add(sgMaterials);
+      for (auto id : shape.mesh.material_ids)
+        pmids->v.push_back(id);
 
-        auto model = createNode(name + "_model", "Model");
-        model->add(mesh);
+      mesh->add(pmids);
 
-        // TODO: Large .obj models with lots of groups run much slower with each
-        //       group put in a separate instance. In the future, we want to
-        //       support letting the user (ospExampleViewer, for starters)
-        //       specify if each group should be placed in an instance or not.
+      return mesh;
+    }
+
+    void importOBJ(const std::shared_ptr<Node> &world, const FileName &fileName)
+    {
+      tinyobj::attrib_t attrib;
+      std::vector<tinyobj::shape_t> shapes;
+      std::vector<tinyobj::material_t> materials;
+
+      const std::string containingPath = fileName.path();
+
+      if (!objparser::loadObj(attrib, shapes, materials, fileName)) {
+        std::cerr << "#ospsg: FATAL error reading obj file, no geometry added"
+                  << " to the scene!" << std::endl;
+        return;
+      }
+
+      auto numQuads = 0;
+      auto numTriangles = 0;
+      for (auto &shape : shapes) {
+        for (auto numVertsInFace : shape.mesh.num_face_vertices) {
+          numTriangles += (numVertsInFace == 3);
+          numQuads += (numVertsInFace == 4);
+        }
+      }
+      std::cout << "... found " << numTriangles << " triangles " <<
+                   "and " << numQuads << " quads.\n";
+
+      auto sgMaterials = createSgMaterials(materials, containingPath);
+
+      std::string base_name = fileName.name() + '_';
+
+      std::cout << "...adding found triangle & quad groups to the scene...\n";
+
+#if !USE_INSTANCES
+      auto objInstance = createNode("instance", "Instance");
+      publishImported(world, [=](const std::shared_ptr<Node> &world) {
+        world->add(objInstance);
+      });
+#endif
+
+      // the meshes are built in parallel, but added to the scene in order;
+      // in blocks, such that asynchronous imports show them progressively
+      const size_t numShapes = shapes.size();
+      const size_t blockSize = 256;
+      for (size_t begin = 0; begin < numShapes; begin += blockSize) {
+        const size_t end = std::min(begin + blockSize, numShapes);
+        std::vector<std::shared_ptr<QuadMesh>> meshes(end - begin);
+        tasking::parallel_for(end - begin, [&](size_t i) {
+          const size_t shapeId = begin + i;
+          auto &shape = shapes[shapeId];
+          auto name = base_name + std::to_string(shapeId) + '_' + shape.name;
+          meshes[i] = createQuadMesh(name, shape, attrib);
+        });
+
+        publishImported(world, [=](const std::shared_ptr<Node> &world) {
+          for (auto &mesh : meshes) {
+            const auto name = mesh->name();
+
+            mesh->add(sgMaterials);
+
+            auto model = createNode(name + "_model", "Model");
+            model->add(mesh);
+
+            // TODO: Large .obj models with lots of groups run much slower
+            //       with each group put in a separate instance. In the
+            //       future, we want to support letting the user
+            //       (ospExampleViewer, for starters) specify if each group
+            //       should be placed in an instance or not.
 #if USE_INSTANCES
-        auto instance = createNode(name + "_instance", "Instance");
-        instance->setChild("model", model);
-        model->setParent(instance);
+            auto instance = createNode(name + "_instance", "Instance");
+            instance->setChild("model", model);
+            model->setParent(instance);
 
-        world->add(instance);
+            world->add(instance);
 #else
-        (*objInstance)["model"].add(mesh);
+            (*objInstance)["model"].add(mesh);
 #endif
+          }
+        });
 
+        reportImportProgress(float(end) / numShapes);
       }
 
       std::cout << "...finished import!\n";
@@ -22,6 +22,7 @@
 // ospcommon
 #include "ospcommon/containers/AlignedVector.h"
 #include "ospcommon/utility/StringManip.h"
+#include "ospcommon/xml/XMLReader.h"
 
 namespace ospray {
   namespace sg {
@@ -65,6 +66,12 @@ namespace ospray {
           // Silently ignore
         } else if (child.name == "gridSpacing") {
           gridSpacing = toVec3f(child.content.c_str());
+        } else if (child.name == "voxelRange") {
+          volume->child("voxelRange") = toVec2f(child.content.c_str());
+        } else if (child.name == "convertTo") {
+          volume->child("convertTo") = child.content;
+        } else if (child.name == "downsample") {
+          volume->child("downsample") = std::atoi(child.content.c_str());
         } else {
           throw std::runtime_error("unknown old-style osp file "
                                    "component volume::" + child.name);
@@ -176,15 +183,16 @@ namespace ospray {
       std::cout << "#osp:sg: starting to read OSPRay XML file '" << fileName
                 << "'" << std::endl;
 
-      auto doc = xml::readXML(fileName);
+      // top-level entries are read one at a time, without the whole document
+      xml::XMLReader reader(fileName);
+      xml::XMLDoc doc;
+      doc.fileName = fileName;
 
-      std::cout << "#osp:sg: XML file read, starting to parse content..."
-                << std::endl;
+      size_t numNodes = 0;
+      while (reader.next() != xml::XMLReader::END_DOCUMENT) {
+        const auto node = reader.readElement(&doc);
+        numNodes++;
 
-      if (doc->child.empty())
-        throw std::runtime_error("ospray xml input file does not contain any nodes!?");
-
-      for (const auto &node : doc->child) {
         auto nameLower = utility::lowerCase(node.name);
         if (nameLower == "volume" || nameLower == "structuredvolume")
           importStructuredVolume(world, node);
@@ -197,6 +205,9 @@ namespace ospray {
         else
           std::cout << "#importOSG: unknown xml tag '" << node.name << "'\n";
       }
+
+      if (numNodes == 0)
+        throw std::runtime_error("ospray xml input file does not contain any nodes!?");
     }
 
   } // ::ospray::sg
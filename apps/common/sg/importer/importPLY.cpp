@@ -26,6 +26,11 @@
 #include "sg/texture/Texture2D.h"
 //
 #include "../3rdParty/ply.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <atomic>
+#include <sstream>
 
 namespace ospray {
   namespace sg {
@@ -324,6 +329,306 @@ namespace ospray {
           mesh->add(nor);
       }
 
+
+      // fast path for binary little-endian files ////////////////////////////
+
+      struct BinaryProperty
+      {
+        std::string name;
+        //! PLY_* type, of the items for lists
+        int type {0};
+        //! PLY_* type of the count of lists, 0 for scalars
+        int countType {0};
+        //! within the element, assuming triangles for lists
+        size_t offset {0};
+      };
+
+      struct BinaryElement
+      {
+        std::string name;
+        size_t count {0};
+        std::vector<BinaryProperty> props;
+        //! assuming triangles for lists
+        size_t stride {0};
+        const char *begin {nullptr};
+
+        const BinaryProperty *find(const std::string &propName) const
+        {
+          for (const auto &prop : props)
+            if (prop.name == propName)
+              return &prop;
+          return nullptr;
+        }
+      };
+
+      inline int binaryTypeOf(const std::string &name)
+      {
+        if (name == "char"   || name == "int8")    return PLY_CHAR;
+        if (name == "uchar"  || name == "uint8")   return PLY_UCHAR;
+        if (name == "short"  || name == "int16")   return PLY_SHORT;
+        if (name == "ushort" || name == "uint16")  return PLY_USHORT;
+        if (name == "int"    || name == "int32")   return PLY_INT;
+        if (name == "uint"   || name == "uint32")  return PLY_UINT;
+        if (name == "float"  || name == "float32") return PLY_FLOAT;
+        if (name == "double" || name == "float64") return PLY_DOUBLE;
+        return 0;
+      }
+
+      inline size_t binarySizeOf(int type)
+      {
+        static const size_t sizes[] = {0, 1, 2, 4, 1, 2, 4, 4, 8};
+        return sizes[type];
+      }
+
+      inline float readReal(const char *p, int type)
+      {
+        if (type == PLY_DOUBLE) {
+          double d;
+          memcpy(&d, p, sizeof(d));
+          return d;
+        }
+        float f;
+        memcpy(&f, p, sizeof(f));
+        return f;
+      }
+
+      /*! parses the header of a binary little-endian file, returns false
+          for any other format */
+      bool readBinaryHeader(const char *begin, const char *end,
+                            std::vector<BinaryElement> &elements,
+                            const char *&body)
+      {
+        const char *p = begin;
+        bool first = true;
+        bool binaryLE = false;
+        while (p < end) {
+          const char *eol = (const char *)memchr(p, '\n', end - p);
+          if (!eol)
+            return false;
+          std::stringstream line(std::string(p, eol));
+          p = eol + 1;
+
+          std::string keyword;
+          line >> keyword;
+          if (first) {
+            if (keyword != "ply")
+              return false;
+            first = false;
+          } else if (keyword == "format") {
+            std::string format;
+            line >> format;
+            binaryLE = format == "binary_little_endian";
+          } else if (keyword == "element") {
+            elements.emplace_back();
+            line >> elements.back().name >> elements.back().count;
+          } else if (keyword == "property") {
+            if (elements.empty())
+              return false;
+            BinaryProperty prop;
+            std::string type;
+            line >> type;
+            if (type == "list") {
+              std::string countType;
+              line >> countType >> type;
+              prop.countType = binaryTypeOf(countType);
+              if (prop.countType == 0)
+                return false;
+            }
+            prop.type = binaryTypeOf(type);
+            line >> prop.name;
+            if (prop.type == 0 || !line)
+              return false;
+            elements.back().props.push_back(prop);
+          } else if (keyword == "end_header") {
+            body = p;
+            return binaryLE;
+          }
+        }
+        return false;
+      }
+
+      /*! reads binary little-endian files of fixed-stride layout, i.e. with
+          triangles as only lists, by decoding the mapped file in parallel,
+          or by sharing the vertex positions with the mapping if they are
+          the only vertex properties; returns false if the file needs the
+          generic reader */
+      bool readBinaryFile(const std::string &fileName,
+                          std::shared_ptr<sg::TriangleMesh> mesh)
+      {
+        const uint16_t endianness = 1;
+        if (*(const uint8_t *)&endianness != 1)
+          return false;
+
+        std::shared_ptr<MappedFile> file;
+        try {
+          file = std::make_shared<MappedFile>(fileName);
+        } catch (const std::runtime_error &) {
+          return false;
+        }
+        const char *fileBegin = (const char *)file->data();
+        const char *fileEnd   = fileBegin + file->size();
+
+        const char *body = nullptr;
+        std::vector<BinaryElement> elements;
+        if (!readBinaryHeader(fileBegin, fileEnd, elements, body))
+          return false;
+
+        // layout //
+
+        const BinaryElement *vertex = nullptr;
+        const BinaryElement *face   = nullptr;
+        for (auto &element : elements) {
+          for (auto &prop : element.props) {
+            prop.offset = element.stride;
+            if (prop.countType) {
+              // only triangle faces are of fixed stride
+              if (element.name != "face" ||
+                  (prop.name != "vertex_indices" &&
+                   prop.name != "vertex_index") ||
+                  binarySizeOf(prop.countType) != 1 ||
+                  binarySizeOf(prop.type) != 4 || face != nullptr) {
+                return false;
+              }
+              element.stride += 1 + 3 * 4;
+              face = &element;
+            } else {
+              element.stride += binarySizeOf(prop.type);
+            }
+          }
+          if (element.name == "vertex")
+            vertex = &element;
+
+          element.begin = body;
+          if (element.stride == 0 ||
+              size_t(fileEnd - body) / element.stride < element.count)
+            return false;
+          body += element.count * element.stride;
+        }
+
+        if (vertex == nullptr)
+          return false;
+
+        auto isReal = [](const BinaryProperty *prop) {
+          return prop && (prop->type == PLY_FLOAT || prop->type == PLY_DOUBLE);
+        };
+        auto isUchar = [](const BinaryProperty *prop) {
+          return !prop || prop->type == PLY_UCHAR;
+        };
+
+        const BinaryProperty *x = vertex->find("x");
+        const BinaryProperty *y = vertex->find("y");
+        const BinaryProperty *z = vertex->find("z");
+        if (!isReal(x) || !isReal(y) || !isReal(z))
+          return false;
+
+        const BinaryProperty *nx = vertex->find("nx");
+        const BinaryProperty *ny = vertex->find("ny");
+        const BinaryProperty *nz = vertex->find("nz");
+        const bool hasNormals = isReal(nx) && isReal(ny) && isReal(nz);
+
+        const BinaryProperty *red   = vertex->find("red");
+        const BinaryProperty *green = vertex->find("green");
+        const BinaryProperty *blue  = vertex->find("blue");
+        if (!isUchar(red) || !isUchar(green) || !isUchar(blue))
+          return false;
+
+        const BinaryProperty *indices = nullptr;
+        if (face) {
+          indices = face->find("vertex_indices");
+          indices = indices ? indices : face->find("vertex_index");
+        }
+
+        // faces, bailing out on the first non-triangle //
+
+        const size_t blockSize = 64 * 1024;
+        const size_t numFaces  = face ? face->count : 0;
+        auto idx = createNode("index", "DataVector3i")->nodeAs<DataVector3i>();
+        idx->v.resize(numFaces);
+
+        std::atomic<bool> onlyTriangles {true};
+        tasking::parallel_for((numFaces + blockSize - 1) / blockSize,
+                              [&](size_t block) {
+          const size_t end = std::min(numFaces, (block + 1) * blockSize);
+          for (size_t i = block * blockSize; i < end; i++) {
+            const char *item = face->begin + i * face->stride + indices->offset;
+            if (*(const uint8_t *)item != 3) {
+              onlyTriangles = false;
+              return;
+            }
+            memcpy(&idx->v[i], item + 1, sizeof(vec3i));
+          }
+        });
+
+        if (!onlyTriangles)
+          return false;
+
+        // vertices //
+
+        const size_t numVertices = vertex->count;
+        const char *vertices     = vertex->begin;
+        const size_t stride      = vertex->stride;
+
+        std::shared_ptr<DataBuffer> pos;
+        if (vertex->props.size() == 3 && stride == sizeof(vec3f) &&
+            x->type == PLY_FLOAT && x->offset == 0 &&
+            y->type == PLY_FLOAT && y->offset == 4 &&
+            z->type == PLY_FLOAT && z->offset == 8 &&
+            ((size_t)vertices & 0x3) == 0) {
+          // share the positions with the mapping, which is kept alive
+          // by the deleter until the array is released
+          auto array = std::make_shared<DataArray3f>(
+              (vec3f *)vertices, numVertices);
+          array->deleter = [file](vec3f *) {};
+          array->setName("vertex");
+          pos = array;
+        } else {
+          auto vec = createNode("vertex", "DataVector3f")->nodeAs<DataVector3f>();
+          vec->v.resize(numVertices);
+          pos = vec;
+        }
+
+        auto col = createNode("vertex.color", "DataVector4f")->nodeAs<DataVector4f>();
+        auto nor = createNode("normal", "DataVector3f")->nodeAs<DataVector3f>();
+        col->v.resize(numVertices);
+        if (hasNormals)
+          nor->v.resize(numVertices);
+
+        auto posVec = std::dynamic_pointer_cast<DataVector3f>(pos);
+        tasking::parallel_for((numVertices + blockSize - 1) / blockSize,
+                              [&](size_t block) {
+          const size_t end = std::min(numVertices, (block + 1) * blockSize);
+          for (size_t i = block * blockSize; i < end; i++) {
+            const char *v = vertices + i * stride;
+            if (posVec) {
+              posVec->v[i] = vec3f(readReal(v + x->offset, x->type),
+                                   readReal(v + y->offset, y->type),
+                                   readReal(v + z->offset, z->type));
+            }
+            if (hasNormals) {
+              nor->v[i] = vec3f(readReal(v + nx->offset, nx->type),
+                                readReal(v + ny->offset, ny->type),
+                                readReal(v + nz->offset, nz->type));
+            }
+            col->v[i] = vec4f(
+              red   ? *(const uint8_t *)(v + red->offset) / 255.f : 0.f,
+              green ? *(const uint8_t *)(v + green->offset) / 255.f : 0.f,
+              blue  ? *(const uint8_t *)(v + blue->offset) / 255.f : 0.f,
+              1.f
+            );
+          }
+        });
+
+        cout << "num faces : " << numFaces << endl;
+
+        mesh->add(idx);
+        mesh->add(pos);
+        mesh->add(col);
+        if (hasNormals)
+          mesh->add(nor);
+
+        return true;
+      }
+
     } // ::ospray::sg::ply
 
     void importPLY(const std::shared_ptr<Node> &world, const FileName &fileName)
@@ -331,7 +636,11 @@ namespace ospray {
       auto mesh = sg::createNode(fileName.name(),
                                  "TriangleMesh")->nodeAs<TriangleMesh>();
       //mesh->remove("materialList");
-      ply::readFile(fileName.str(), mesh);
+      const std::string &name = fileName.str();
+      const bool gzipped =
+          name.size() > 7 && name.compare(name.size() - 7, 7, ".ply.gz") == 0;
+      if (gzipped || !ply::readBinaryFile(name, mesh))
+        ply::readFile(name, mesh);
       world->add(mesh);
     }
 
@@ -21,6 +21,8 @@
 #include "sg/geometry/TriangleMesh.h"
 #include "sg/texture/Texture2D.h"
 #include "sg/visitor/PrintNodes.h"
+// ospcommon
+#include "ospcommon/xml/XMLReader.h"
 
 // stl
 #include <map>
@@ -486,59 +488,70 @@ namespace ospray {
       }
     }
 
+    /*! parses a top-level entry of the BGFscene, returns whether it is a
+        candidate for the root of the scene */
+    bool parseBGFentry(const xml::Node &node)
+    {
+      if (node.name == "text") {
+        // -------------------------------------------------------
+      } else if (node.name == "Texture2D") {
+        // -------------------------------------------------------
+        parseTextureNode(node);
+        // -------------------------------------------------------
+      } else if (node.name == "Material") {
+        // -------------------------------------------------------
+        parseMaterialNode(node);
+        // -------------------------------------------------------
+      } else if (node.name == "Transform") {
+        // -------------------------------------------------------
+        parseTransformNode(node);
+        return true;
+        // -------------------------------------------------------
+      } else if (node.name == "Mesh") {
+        // -------------------------------------------------------
+        parseMeshNode(node);
+        return true;
+        // -------------------------------------------------------
+      } else if (node.name == "Group") {
+        // -------------------------------------------------------
+#if USE_INSTANCE_GROUP
+        parseInstanceGroupNode(node);
+#else
+        parseGroupNode(node);
+#endif
+        return true;
+      } else {
+        nodeList.push_back({});
+      }
+      return false;
+    }
+
+    /*! streams the entries of the BGFscene, each one is materialized on its
+        own since they reference earlier ones by their index */
     void parseBGFscene(const std::shared_ptr<Node> &world,
-                       const xml::Node &root)
+                       xml::XMLReader &reader)
     {
-      if (root.name != "BGFscene")
-        throw std::runtime_error("XML file is not a RIVL model !?");
-      if (root.child.empty())
-        throw std::runtime_error("emply RIVL model !?");
+      if (reader.next() != xml::XMLReader::START_ELEMENT
+          || reader.name() != "BGFscene")
+        throw std::runtime_error("could not parse RIVL file: Not in RIVL format!?");
 
       RIVLNode lastNode;
-      size_t nodeCounter = 0;
-      size_t numNodes = root.child.size();
-      float increment = float(numNodes)/10.f;
+      size_t numNodes = 0;
       int incrementer = 0;
       std::cout << "mapping RIVL scene state to OSPSG... \n";
-      nodeList.reserve(numNodes);
-      for (const auto &node: root.child) {
-        if (nodeCounter++ >= (increment*float(incrementer))) {
+      while (reader.next() == xml::XMLReader::START_ELEMENT) {
+        if (reader.offset() * 10 >= reader.size() * incrementer) {
           std::cout << incrementer*10 << "%\n";
           incrementer++;
         }
 
-        if (node.name == "text") {
-          // -------------------------------------------------------
-        } else if (node.name == "Texture2D") {
-          // -------------------------------------------------------
-          parseTextureNode(node);
-          // -------------------------------------------------------
-        } else if (node.name == "Material") {
-          // -------------------------------------------------------
-          parseMaterialNode(node);
-          // -------------------------------------------------------
-        } else if (node.name == "Transform") {
-          // -------------------------------------------------------
-          parseTransformNode(node);
+        if (parseBGFentry(reader.readElement()))
           lastNode = nodeList.back();
-          // -------------------------------------------------------
-        } else if (node.name == "Mesh") {
-          // -------------------------------------------------------
-          parseMeshNode(node);
-          lastNode = nodeList.back();
-          // -------------------------------------------------------
-        } else if (node.name == "Group") {
-          // -------------------------------------------------------
-#if USE_INSTANCE_GROUP
-          parseInstanceGroupNode(node);
-#else
-          parseGroupNode(node);
-#endif
-          lastNode = nodeList.back();
-        } else {
-          nodeList.push_back({});
-        }
+        numNodes++;
       }
+      if (numNodes == 0)
+        throw std::runtime_error("emply RIVL model !?");
+
       if (lastNode.sgNode)
       {
         if (lastNode.sgNode->type() == "Model")
@@ -567,11 +580,8 @@ namespace ospray {
         std::cerr << "#osp:sg: WARNING: mapped file is nullptr!!!!" << std::endl;
         std::cerr << "#osp:sg: WARNING: mapped file is nullptr!!!!" << std::endl;
       }
-      std::shared_ptr<xml::XMLDoc> doc = xml::readXML(fileName.str());
-      if (doc->child.size() != 1 || doc->child[0].name != "BGFscene")
-        throw std::runtime_error("could not parse RIVL file: Not in RIVL format!?");
-      const xml::Node &root_element = doc->child[0];
-      parseBGFscene(world, root_element);
+      xml::XMLReader reader(xmlFileName);
+      parseBGFscene(world, reader);
     }
 
     OSPSG_REGISTER_IMPORT_FUNCTION(importRIVL, rivl);
@@ -88,11 +88,14 @@ namespace ospray {
                            const std::vector<FileName> &fileNames)
     {
       auto tf = createNode("transferFunction", "TransferFunction");
-      for(auto file : fileNames)
+      for (size_t i = 0; i < fileNames.size(); i++)
       {
-        auto volume = importVTI_createVolumeNode(file);
-        volume->add(tf);
-        world->add(volume);
+        auto volume = importVTI_createVolumeNode(fileNames[i]);
+        publishImported(world, [=](const std::shared_ptr<Node> &world) {
+          volume->add(tf);
+          world->add(volume);
+        });
+        reportImportProgress(float(i + 1) / fileNames.size());
       }
     }
 
@@ -25,10 +25,25 @@ OIIO_NAMESPACE_USING
 #include "Texture2D.h"
 
 #include "common/OSPCommon.h"
+// std
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+// posix
+#include <sys/stat.h>
 
 namespace ospray {
   namespace sg {
 
+    //! guards Texture2D::textureCache and texelCache, such that textures can
+    //! be loaded in parallel
+    static std::mutex textureCacheMutex;
+
+    //! the textures loaded so far by the hash of their texels, such that
+    //! identical images (e.g. copies of a file) share their texels
+    static std::unordered_multimap<uint64_t, std::shared_ptr<Texture2D>>
+        texelCache;
+
     // static helper functions ////////////////////////////////////////////////
 
     OSPTextureFormat
@@ -53,6 +68,54 @@ namespace ospray {
       return OSP_TEXTURE_FORMAT_INVALID;
     }
 
+    /*! the key of a texture file in Texture2D::textureCache: its absolute
+        path (such that different relative paths to a file share it) and
+        modification time (such that a changed file gets loaded again),
+        and the flags the texture is loaded with */
+    static std::string textureKey(const FileName &fileName,
+                                  bool preferLinear,
+                                  bool nearestFilter)
+    {
+      std::string path = fileName.str();
+      long long mtime = 0;
+#ifdef _WIN32
+      char resolved[_MAX_PATH];
+      if (_fullpath(resolved, path.c_str(), _MAX_PATH))
+        path = resolved;
+      struct _stat64 st;
+      if (_stat64(path.c_str(), &st) == 0)
+        mtime = st.st_mtime;
+#else
+      char *resolved = realpath(path.c_str(), nullptr);
+      if (resolved) {
+        path = resolved;
+        free(resolved);
+      }
+      struct stat st;
+      if (stat(path.c_str(), &st) == 0)
+        mtime = st.st_mtime;
+#endif
+      return path + "|" + std::to_string(mtime) + "|"
+             + (preferLinear ? "l" : "") + (nearestFilter ? "n" : "");
+    }
+
+    /*! FNV-1a hash of the texels, word by word */
+    static uint64_t hashTexels(const void *texels, size_t numBytes)
+    {
+      const uint64_t prime = 0x100000001b3ull;
+      uint64_t hash = 0xcbf29ce484222325ull;
+      const unsigned char *bytes = (const unsigned char *)texels;
+      size_t i = 0;
+      for (; i + sizeof(uint64_t) <= numBytes; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+      }
+      for (; i < numBytes; i++)
+        hash = (hash ^ bytes[i]) * prime;
+      return hash;
+    }
+
     // Texture2D definitions //////////////////////////////////////////////////
 
     Texture2D::Texture2D() : Texture("texture2d") {}
@@ -109,9 +172,15 @@ namespace ospray {
     {
       FileName fileName = fileNameAbs;
       std::string fileNameBase = fileNameAbs;
-
-      if (textureCache.find(fileName.str()) != textureCache.end())
-        return textureCache[fileName.str()];
+      const std::string key =
+          textureKey(fileName, preferLinear, nearestFilter);
+
+      {
+        std::lock_guard<std::mutex> lock(textureCacheMutex);
+        auto cached = textureCache.find(key);
+        if (cached != textureCache.end())
+          return cached->second;
+      }
 
       std::shared_ptr<Texture2D> tex = std::static_pointer_cast<Texture2D>(
         createNode(fileName.name(),"Texture2D"));
@@ -346,19 +415,64 @@ namespace ospray {
               }
             }
           }
+          stbi_image_free(pixels);
         }
       }
 #endif
 
-      if (tex.get() != nullptr)
-        textureCache[fileName.str()] = tex;
+      if (tex.get() != nullptr) {
+        const size_t numBytes =
+            size_t(tex->size.x) * tex->size.y * tex->channels * tex->depth;
+        const uint64_t hash = hashTexels(tex->data, numBytes);
+
+        std::lock_guard<std::mutex> lock(textureCacheMutex);
+
+        // another thread may have loaded the same file meanwhile, return its
+        // texture to keep handing out the same object
+        auto cached = textureCache.find(key);
+        if (cached != textureCache.end()) {
+          alignedFree(tex->data);
+          return cached->second;
+        }
+
+        // a texture with identical texels: share the texture if it was
+        // loaded with the same flags, otherwise (only) its texels
+        auto range = texelCache.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+          const auto &other = it->second;
+          if (other->size != tex->size || other->channels != tex->channels
+              || other->depth != tex->depth
+              || memcmp(other->texelData->base(), tex->data, numBytes) != 0)
+            continue;
+
+          alignedFree(tex->data);
+          tex->data = nullptr;
+          if (other->preferLinear == preferLinear
+              && other->nearestFilter == nearestFilter)
+            tex = other;
+          else
+            tex->texelData = other->texelData;
+          break;
+        }
+
+        if (tex->data) {
+          tex->texelData = std::make_shared<DataArray1uc>(
+              (unsigned char *)tex->data, numBytes);
+          tex->data = nullptr;
+          texelCache.emplace(hash, tex);
+        }
+
+        textureCache.emplace(key, tex);
+      }
 
       return tex;
     }
 
     void Texture2D::clearTextureCache()
     {
+      std::lock_guard<std::mutex> lock(textureCacheMutex);
       textureCache.clear();
+      texelCache.clear();
     }
 
     OSP_REGISTER_SG_NODE(Texture2D);
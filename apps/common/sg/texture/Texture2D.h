@@ -41,7 +41,9 @@ namespace ospray {
       //! \brief load texture from given file.
       /*! \detailed if file does not exist, or cannot be loaded for
           some reason, return NULL. Multiple loads from the same file
-          will return the *same* texture object */
+          (until it is modified) will return the *same* texture object,
+          also when loading in parallel; files with identical images
+          share their texels */
       static std::shared_ptr<Texture2D> load(const FileName &fileName,
                                              const bool preferLinear = false,
                                              const bool nearestFilter = false);
@@ -37,22 +37,36 @@ namespace ospray {
 
     // Inlined definitions ////////////////////////////////////////////////////
 
-    inline bool VerifyNodes::operator()(Node &node, TraversalContext &)
+    inline bool VerifyNodes::operator()(Node &node, TraversalContext &ctx)
     {
+      const bool wasValid = node.properties.valid;
       bool traverseChildren =
-          !(node.properties.valid &&
+          !(wasValid &&
           (node.childrenLastModified() < node.properties.lastVerified));
       node.properties.valid = node.computeValid();
       node.properties.lastVerified = TimeStamp();
 
+      // the required children of a valid node were valid, only the modified
+      // ones need to be verified again
+      ctx.onlyModifiedChildren = wasValid;
+
       return traverseChildren;
     }
 
-    inline void VerifyNodes::postChildren(Node &node, TraversalContext &)
+    inline void VerifyNodes::postChildren(Node &node, TraversalContext &ctx)
     {
-      for (const auto &child : node.properties.children) {
-        if (child.second->flags() & NodeFlags::required)
-          node.properties.valid &= child.second->isValid();
+      if (ctx.onlyModifiedChildren) {
+        for (auto *child : node.properties.modifiedChildren) {
+          if (child->flags() & NodeFlags::required)
+            node.properties.valid &= child->isValid();
+        }
+        if (node.lastCommitted() > node.childrenLastModified())
+          node.clearModifiedChildren();
+      } else {
+        for (const auto &child : node.properties.children) {
+          if (child.second->flags() & NodeFlags::required)
+            node.properties.valid &= child.second->isValid();
+        }
       }
       if (errorOnInvalid && !node.properties.valid)
         throw std::runtime_error(node.name() + " was marked invalid");
@@ -28,6 +28,10 @@ namespace ospray {
     struct TraversalContext
     {
       int level{0};
+      //! set by the visitor of a node to traverse only those children which
+      //  were modified since the node was last both verified and committed
+      //  (also seen by postChildren of the node)
+      bool onlyModifiedChildren{false};
     };
 
     // Base node visitor interface ////////////////////////////////////////////
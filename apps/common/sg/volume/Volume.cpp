@@ -18,6 +18,12 @@
 #include "../common/Model.h"
 // core ospray
 #include "common/OSPCommon.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <cmath>
+#include <mutex>
+#include <type_traits>
 
 namespace ospray {
   namespace sg {
@@ -71,11 +77,145 @@ namespace ospray {
       }
     }
 
+    //! Parallel version of extendVoxelRange for large voxel arrays
+    inline void extendVoxelRangeParallel(ospcommon::vec2f &voxelRange,
+                                         const OSPDataType voxelType,
+                                         const unsigned char *voxels,
+                                         const size_t numVoxels)
+    {
+      const size_t voxelSize = sizeOf(voxelType);
+      const size_t chunkSize = 1 << 20;
+      const size_t numChunks = (numVoxels + chunkSize - 1) / chunkSize;
+      std::mutex mutex;
+      tasking::parallel_for(numChunks, [&](size_t i) {
+        vec2f range(std::numeric_limits<float>::infinity(),
+                    -std::numeric_limits<float>::infinity());
+        const size_t begin = i * chunkSize;
+        const size_t num = std::min(chunkSize, numVoxels - begin);
+        extendVoxelRange(range, voxelType, voxels + begin * voxelSize, num);
+        std::lock_guard<std::mutex> lock(mutex);
+        voxelRange.x = std::min(voxelRange.x, range.x);
+        voxelRange.y = std::max(voxelRange.y, range.y);
+      });
+    }
+
     bool unsupportedVoxelType(const std::string &type) {
       return type != "uchar" && type != "ushort" && type != "short"
         && type != "float" && type != "double";
     }
 
+    template<typename T>
+    inline T clampVoxel(double value)
+    {
+      return static_cast<T>(
+          std::min<double>(std::max<double>(value,
+                                            std::numeric_limits<T>::lowest()),
+                           std::numeric_limits<T>::max()));
+    }
+
+    template<>
+    inline float clampVoxel<float>(double value)
+    {
+      return static_cast<float>(value);
+    }
+
+    template<>
+    inline double clampVoxel<double>(double value)
+    {
+      return value;
+    }
+
+    /*! converts a slab of slices to another voxel type, averaging boxes of
+        factor^3 voxels (clipped at the border of the volume) */
+    struct ConvertSlab
+    {
+      ConvertSlab(const unsigned char *in, const vec3i &inDims,
+                  unsigned char *out, const vec3i &outDims, int factor)
+        : in(in), inDims(inDims), out(out), outDims(outDims), factor(factor)
+      {
+      }
+
+      template<typename IN_T, typename OUT_T>
+      void run() const
+      {
+        const IN_T *src = reinterpret_cast<const IN_T *>(in);
+        OUT_T *dst = reinterpret_cast<OUT_T *>(out);
+        const size_t inPerSlice = (size_t)inDims.x * (size_t)inDims.y;
+
+        tasking::parallel_for(outDims.z * outDims.y, [&](int row) {
+          const int y = row % outDims.y;
+          const int z = row / outDims.y;
+          const int y1 = std::min(y * factor + factor, inDims.y);
+          const int z1 = std::min(z * factor + factor, inDims.z);
+          OUT_T *dstRow = dst + (size_t)row * outDims.x;
+
+          for (int x = 0; x < outDims.x; x++) {
+            const int x1 = std::min(x * factor + factor, inDims.x);
+            double sum = 0.0;
+            for (int iz = z * factor; iz < z1; iz++)
+              for (int iy = y * factor; iy < y1; iy++) {
+                const IN_T *srcRow = src + iz * inPerSlice
+                                         + (size_t)iy * inDims.x;
+                for (int ix = x * factor; ix < x1; ix++)
+                  sum += srcRow[ix];
+              }
+            const int count = (x1 - x * factor) * (y1 - y * factor)
+                              * (z1 - z * factor);
+            dstRow[x] = clampVoxel<OUT_T>(
+                std::is_integral<OUT_T>::value && factor > 1
+                ? std::round(sum / count) : sum / count);
+          }
+        });
+      }
+
+      const unsigned char *in;
+      vec3i inDims;
+      unsigned char *out;
+      vec3i outDims;
+      int factor;
+    };
+
+    template<typename IN_T, typename F>
+    inline void dispatchOutputVoxelType(OSPDataType type, const F &f)
+    {
+      switch (type) {
+        case OSP_UCHAR:  f.template run<IN_T, unsigned char>();  break;
+        case OSP_SHORT:  f.template run<IN_T, short>();          break;
+        case OSP_USHORT: f.template run<IN_T, unsigned short>(); break;
+        case OSP_FLOAT:  f.template run<IN_T, float>();          break;
+        case OSP_DOUBLE: f.template run<IN_T, double>();         break;
+        default:
+          throw std::runtime_error("sg::ConvertSlab: unsupported voxel type!");
+      }
+    }
+
+    //! runs f.run<IN_T, OUT_T>() for the given pair of voxel types
+    template<typename F>
+    inline void dispatchVoxelTypes(OSPDataType inType,
+                                   OSPDataType outType,
+                                   const F &f)
+    {
+      switch (inType) {
+        case OSP_UCHAR:
+          dispatchOutputVoxelType<unsigned char>(outType, f);
+          break;
+        case OSP_SHORT:
+          dispatchOutputVoxelType<short>(outType, f);
+          break;
+        case OSP_USHORT:
+          dispatchOutputVoxelType<unsigned short>(outType, f);
+          break;
+        case OSP_FLOAT:
+          dispatchOutputVoxelType<float>(outType, f);
+          break;
+        case OSP_DOUBLE:
+          dispatchOutputVoxelType<double>(outType, f);
+          break;
+        default:
+          throw std::runtime_error("sg::ConvertSlab: unsupported voxel type!");
+      }
+    }
+
     // =======================================================
     // base volume class
     // =======================================================
@@ -136,7 +276,8 @@ namespace ospray {
     {
       auto ospVolume = valueAs<OSPVolume>();
 
-      if (ospVolume) {
+      // no world while rendering into a CachedInstance
+      if (ospVolume && ctx.world) {
         ospAddVolume(ctx.world->valueAs<OSPModel>(), ospVolume);
         if (child("isosurfaceEnabled").valueAs<bool>() && isosurfacesGeometry)
           ospAddGeometry(ctx.world->valueAs<OSPModel>(), isosurfacesGeometry);
@@ -243,6 +384,28 @@ namespace ospray {
     StructuredVolumeFromFile::StructuredVolumeFromFile()
     {
       createChild("blockBricked", "bool", true, NodeFlags::gui_readonly);
+      createChild("memoryMapped", "bool", false, NodeFlags::gui_readonly,
+                  "map the file and render from it in place "
+                  "(shared_structured_volume, overrides blockBricked)");
+      createChild("mappingAccess", "string", std::string("random"),
+                  NodeFlags::gui_combo | NodeFlags::gui_readonly,
+                  "access pattern hint for the mapped file")
+        .setWhiteList({std::string("normal"), std::string("sequential"),
+                       std::string("random"), std::string("willneed")});
+      createChild("hugePages", "bool", false, NodeFlags::gui_readonly,
+                  "request transparent huge pages for the mapped file");
+      createChild("numaInterleave", "bool", false, NodeFlags::gui_readonly,
+                  "interleave the pages of the mapped file over NUMA nodes");
+      createChild("convertTo", "string", std::string("none"),
+                  NodeFlags::gui_combo | NodeFlags::gui_readonly,
+                  "voxel type the voxels are converted to while loading, "
+                  "values are clamped to its range")
+        .setWhiteList({std::string("none"), std::string("uchar"),
+                       std::string("short"), std::string("ushort"),
+                       std::string("float"), std::string("double")});
+      createChild("downsample", "int", 1, NodeFlags::gui_readonly,
+                  "average boxes of n^3 voxels while loading")
+        .setMinMax(1, 16);
     }
 
     /*! \brief returns a std::string with the c++ name of this class */
@@ -267,7 +430,8 @@ namespace ospray {
         return;
       }
 
-      bool useBlockBricked = child("blockBricked").valueAs<bool>();
+      bool useBlockBricked = child("blockBricked").valueAs<bool>()
+                             && !child("memoryMapped").valueAs<bool>();
       ospVolume = ospNewVolume(useBlockBricked ? "block_bricked_volume" :
                                                  "shared_structured_volume");
 
@@ -294,51 +458,178 @@ namespace ospray {
         ospSetObject(isosurfacesGeometry, "volume", ospVolume);
 
         FileName realFileName = fileNameOfCorrespondingXmlDoc.path() + fileName;
-        FILE *file = fopen(realFileName.c_str(),"rb");
-        if (!file) {
-          throw std::runtime_error("StructuredVolumeFromFile::render(): could not open file '"
-                                   +realFileName.str()+"' (expanded from xml file '"
-                                   +fileNameOfCorrespondingXmlDoc.str()
-                                   +"' and file name '"+fileName+"')");
-        }
 
         vec2f voxelRange(std::numeric_limits<float>::infinity(),
                          -std::numeric_limits<float>::infinity());
         const OSPDataType ospVoxelType = typeForString(voxelType);
         const size_t voxelSize = sizeOf(ospVoxelType);
 
-        bool useBlockBricked = child("blockBricked").valueAs<bool>();
-
-        if (useBlockBricked) {
-          const size_t nPerSlice = (size_t)dimensions.x * (size_t)dimensions.y;
-          std::vector<uint8_t> slice(nPerSlice * voxelSize, 0);
+        bool memoryMapped = child("memoryMapped").valueAs<bool>();
+        bool useBlockBricked = child("blockBricked").valueAs<bool>()
+                               && !memoryMapped;
+
+        if (memoryMapped) {
+          // Zero-copy: the volume samples the mapping of the file directly,
+          // so pages are only read when first touched, and several processes
+          // share them through the page cache.
+          if (child("convertTo").valueAs<std::string>() != "none"
+              || child("downsample").valueAs<int>() > 1) {
+            std::cout << "#osp:sg: WARNING: '" << fileName << "' is memory "
+                      << "mapped, ignoring convertTo and downsample"
+                      << std::endl;
+          }
 
-          for (int z = 0; z < dimensions.z; ++z) {
-            if (fread(slice.data(), voxelSize, nPerSlice, file) != nPerSlice) {
-              throw std::runtime_error("StructuredVolume::render(): read incomplete slice "
-                  "data ... partial file or wrong format!?");
-            }
-            const vec3i region_lo(0, 0, z);
-            const vec3i region_sz(dimensions.x, dimensions.y, 1);
-            extendVoxelRange(voxelRange, ospVoxelType, slice.data(), nPerSlice);
-            ospSetRegion(ospVolume,
-                         slice.data(),
-                         (const osp::vec3i&)region_lo,
-                         (const osp::vec3i&)region_sz);
+          try {
+            mappedFile = std::make_shared<MappedFile>(realFileName.str());
+          } catch (const std::runtime_error &) {
+            throw std::runtime_error("StructuredVolumeFromFile::render(): could not open file '"
+                                     +realFileName.str()+"' (expanded from xml file '"
+                                     +fileNameOfCorrespondingXmlDoc.str()
+                                     +"' and file name '"+fileName+"')");
           }
-        } else {
+
           const size_t nVoxels = (size_t)dimensions.x * (size_t)dimensions.y * (size_t)dimensions.z;
-          uint8_t *voxels = new uint8_t[nVoxels * voxelSize];
-          if (fread(voxels, voxelSize, nVoxels, file) != nVoxels) {
+          if (mappedFile->size() < nVoxels * voxelSize) {
             THROW_SG_ERROR("read incomplete data (truncated file or "
                            "wrong format?!)");
           }
-          extendVoxelRange(voxelRange, ospVoxelType, voxels, nVoxels);
-          OSPData data = ospNewData(nVoxels, ospVoxelType, voxels, OSP_DATA_SHARED_BUFFER);
+
+          const auto access = child("mappingAccess").valueAs<std::string>();
+          mappedFile->advise(access == "normal" ? MappedFile::NORMAL :
+                             access == "sequential" ? MappedFile::SEQUENTIAL :
+                             access == "willneed" ? MappedFile::WILLNEED :
+                                                    MappedFile::RANDOM,
+                             child("hugePages").valueAs<bool>(),
+                             child("numaInterleave").valueAs<bool>());
+
+          // Scanning for the value range would read the whole file, use the
+          // given range instead if there is one.
+          const vec2f givenRange = child("voxelRange").valueAs<vec2f>();
+          if (givenRange.x <= givenRange.y) {
+            voxelRange = givenRange;
+          } else {
+            extendVoxelRangeParallel(voxelRange, ospVoxelType,
+                                     mappedFile->data(), nVoxels);
+          }
+
+          OSPData data = ospNewData(nVoxels, ospVoxelType,
+                                    mappedFile->data(),
+                                    OSP_DATA_SHARED_BUFFER);
           ospSetData(ospVolume,"voxelData",data);
-        }
+          ospRelease(data);
+        } else {
+          // The voxels are copied, either into bricks or into an array shared
+          // with the volume: slabs of whole (64^3) blocks are read with large
+          // positional reads by all threads, then converted by all threads.
+          std::unique_ptr<ParallelFileReader> file;
+          try {
+            file.reset(new ParallelFileReader(realFileName.str()));
+          } catch (const std::runtime_error &) {
+            throw std::runtime_error("StructuredVolumeFromFile::render(): could not open file '"
+                                     +realFileName.str()+"' (expanded from xml file '"
+                                     +fileNameOfCorrespondingXmlDoc.str()
+                                     +"' and file name '"+fileName+"')");
+          }
+
+          const size_t nPerSlice = (size_t)dimensions.x * (size_t)dimensions.y;
+          if (file->size() < nPerSlice * dimensions.z * voxelSize) {
+            throw std::runtime_error("StructuredVolume::render(): read incomplete slice "
+                "data ... partial file or wrong format!?");
+          }
+
+          const int factor = std::max(1, child("downsample").valueAs<int>());
+          const auto convertTo = child("convertTo").valueAs<std::string>();
+          const OSPDataType outVoxelType =
+              convertTo == "none" ? ospVoxelType : typeForString(convertTo);
+          const size_t outVoxelSize = sizeOf(outVoxelType);
+          const bool convert = factor > 1 || outVoxelType != ospVoxelType;
+
+          const vec3i outDimensions = (dimensions + factor - 1) / factor;
+          const size_t outPerSlice =
+              (size_t)outDimensions.x * (size_t)outDimensions.y;
+
+          if (convert) {
+            child("dimensions") = outDimensions;
+            child("voxelType") = stringForType(outVoxelType);
+            child("gridSpacing") =
+                child("gridSpacing").valueAs<vec3f>() * float(factor);
+            child("bounds") = box3f(empty);
+            computeBounds();
+            // the bricks are laid out by setRegion, which needs the final
+            // dimensions and type already
+            ospSet3i(ospVolume, "dimensions", outDimensions.x,
+                     outDimensions.y, outDimensions.z);
+            ospSetString(ospVolume, "voxelType",
+                         stringForType(outVoxelType).c_str());
+          }
+
+          const int slabSlices = 64;
+          std::vector<unsigned char> slabIn;
+          std::vector<unsigned char> slabOut;
+          if (!useBlockBricked) {
+            voxels.resize(outPerSlice * outDimensions.z * outVoxelSize);
+            voxels.shrink_to_fit();
+          }
+
+          int reported = 0;
+          for (int z = 0; z < outDimensions.z; z += slabSlices) {
+            const int numSlices = std::min(slabSlices, outDimensions.z - z);
+            const int zIn = z * factor;
+            const int numSlicesIn = std::min(numSlices * factor,
+                                             dimensions.z - zIn);
+            const size_t numBytesIn = nPerSlice * numSlicesIn * voxelSize;
+            const size_t numBytesOut = outPerSlice * numSlices * outVoxelSize;
+
+            unsigned char *slab = useBlockBricked ? nullptr
+                : voxels.data() + z * outPerSlice * outVoxelSize;
+            if (!slab) {
+              slabOut.resize(numBytesOut);
+              slab = slabOut.data();
+            }
+
+            if (convert) {
+              slabIn.resize(numBytesIn);
+              file->read(slabIn.data(), zIn * nPerSlice * voxelSize,
+                         numBytesIn);
+              dispatchVoxelTypes(ospVoxelType, outVoxelType,
+                  ConvertSlab(slabIn.data(),
+                              vec3i(dimensions.x, dimensions.y, numSlicesIn),
+                              slab,
+                              vec3i(outDimensions.x, outDimensions.y,
+                                    numSlices),
+                              factor));
+            } else {
+              file->read(slab, zIn * nPerSlice * voxelSize, numBytesIn);
+            }
+
+            extendVoxelRangeParallel(voxelRange, outVoxelType, slab,
+                                     outPerSlice * numSlices);
 
-        fclose(file);
+            if (useBlockBricked) {
+              const vec3i region_lo(0, 0, z);
+              const vec3i region_sz(outDimensions.x, outDimensions.y,
+                                    numSlices);
+              ospSetRegion(ospVolume, slab,
+                           (const osp::vec3i&)region_lo,
+                           (const osp::vec3i&)region_sz);
+            }
+
+            const int percent = 100 * (z + numSlices) / outDimensions.z;
+            if (percent / 10 > reported / 10) {
+              std::cout << "#osp:sg: loading '" << fileName << "' ... "
+                        << percent << "%" << std::endl;
+              reported = percent;
+            }
+          }
+
+          if (!useBlockBricked) {
+            OSPData data = ospNewData(outPerSlice * outDimensions.z,
+                                      outVoxelType, voxels.data(),
+                                      OSP_DATA_SHARED_BUFFER);
+            ospSetData(ospVolume,"voxelData",data);
+            ospRelease(data);
+          }
+        }
 
         child("voxelRange") = voxelRange;
         child("transferFunction")["valueRange"] = voxelRange;
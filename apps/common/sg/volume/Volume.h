@@ -69,6 +69,12 @@ namespace ospray {
       std::string fileName;
 
       bool fileLoaded{false};
+
+      //! the voxels shared with the volume if "memoryMapped" is enabled
+      std::shared_ptr<MappedFile> mappedFile;
+
+      //! the voxels shared with the volume if "blockBricked" is disabled
+      std::vector<unsigned char> voxels;
     };
 
   } // ::ospray::sg
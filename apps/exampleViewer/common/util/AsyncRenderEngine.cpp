@@ -33,6 +33,14 @@ namespace ospray {
 #endif
     auto renderer = scenegraph->child("renderer").nodeAs<sg::Renderer>();
 
+    // frames are handed to the consumer as mapped color buffers, which stay
+    // valid while the next frame renders into another one: one is mapped by
+    // the consumer, one is ready to be taken and one is rendered into
+    for (auto name : {"frameBuffer", "navFrameBuffer"}) {
+      if (scenegraph->hasChild(name))
+        scenegraph->child(name)["colorBufferCount"] = 3;
+    }
+
     backgroundThread = make_unique<AsyncLoop>([&, renderer](){
       state = ExecState::RUNNING;
 
@@ -76,8 +84,9 @@ namespace ospray {
 
           // work just on denoisers.back
           denoiseFps.start();
-          frameBuffers.back().resize(sgFB->size(), OSP_FB_RGBA32F);
-          denoisers.back().map(sgFB, (vec4f*)frameBuffers.back().data());
+          auto *result =
+              frameBuffers.back().allocate(sgFB->size(), OSP_FB_RGBA32F);
+          denoisers.back().map(sgFB, (vec4f*)result);
           denoisers.back().execute();
           denoisers.back().unmap(sgFB);
           denoiseFps.stop();
@@ -91,10 +100,9 @@ namespace ospray {
         //             to the latest frame.
         while(state == ExecState::RUNNING && newPixels == true);
 
-        frameBuffers.back().resize(sgFB->size(), sgFB->format());
-        auto srcPB = (uint8_t*)sgFB->map();
-        frameBuffers.back().copy(srcPB);
-        sgFB->unmap(srcPB);
+        // no copy: the consumer is done with the previous frame of back(),
+        // which is unmapped, and gets the color buffer itself
+        frameBuffers.back().map(sgFB->handle(), sgFB->size(), sgFB->format());
 
         newPixels = true;
       }
@@ -112,17 +120,18 @@ namespace ospray {
       }
       lock.unlock();
 
+      // the result is handed to the consumer without a copy, thus spin
+      // until the consumer neither holds nor is about to take a previous
+      // result (which may be the one of denoisers.front)
+      while(state == ExecState::RUNNING && (newPixels || frontMapped));
+
       // work on denoisers.front
       denoiseFps.start();
       denoisers.front().execute();
       denoiseFps.stop();
 
-      // NOTE(jda) - Spin here until the consumer has had the chance to update
-      //             to the latest frame.
-      while(state == ExecState::RUNNING && newPixels == true);
-
-      frameBuffers.back().resize(denoisers.front().size(), OSP_FB_RGBA32F);
-      frameBuffers.back().copy((uint8_t*)denoisers.front().result());
+      frameBuffers.back().reference(denoisers.front().result(),
+                                    denoisers.front().size(), OSP_FB_RGBA32F);
 
       newPixels = true;
     }, AsyncLoop::LaunchMethod::THREAD);
@@ -159,8 +168,8 @@ namespace ospray {
       committed_normal = normal.data();
       albedo.resize(elements);
       committed_albedo = albedo.data();
-      result_.resize(elements);
-      committed_result = result_.data();
+      // result_ is (re)allocated in execute, as it may still be read by
+      // the consumer of the previous frame
       committed_hdr = !fb->toneMapped();
     }
     const vec4f *buf4 = (const vec4f *)fb->map(OSP_FB_COLOR);
@@ -210,6 +219,13 @@ namespace ospray {
 
   void AsyncRenderEngine::Denoiser::execute()
   {
+    if (committed_async) {
+      result_.resize(size_.x * size_.y);
+      if (committed_result != result_.data()) {
+        committed_result = result_.data();
+        needCommit = true;
+      }
+    }
     if (needCommit) {
       filter.setImage("color", (void*)committed_color, oidn::Format::Float3,
           size_.x, size_.y, 0, sizeof(vec4f));
@@ -234,6 +250,8 @@ namespace ospray {
   AsyncRenderEngine::~AsyncRenderEngine()
   {
     stop();
+    frameBuffers.front().release();
+    frameBuffers.back().release();
   }
 
   void AsyncRenderEngine::start(int numOsprayThreads)
@@ -348,6 +366,8 @@ namespace ospray {
 
   const AsyncRenderEngine::Framebuffer &AsyncRenderEngine::mapFramebuffer()
   {
+    // set before taking the new frame, see the denoiser thread
+    frontMapped = true;
     if (newPixels) {
       frameBuffers.swap();
       newPixels = false;
@@ -357,7 +377,7 @@ namespace ospray {
 
   void AsyncRenderEngine::unmapFramebuffer()
   {
-    // no-op
+    frontMapped = false;
   }
 
   void AsyncRenderEngine::validate()
@@ -367,17 +387,36 @@ namespace ospray {
   }
 
   // Framebuffer impl
-  void AsyncRenderEngine::Framebuffer::resize(const vec2i& size,
+  void AsyncRenderEngine::Framebuffer::map(OSPFrameBuffer fb,
+      const vec2i& size, const OSPFrameBufferFormat format)
+  {
+    release();
+    setSize(size, format);
+    if (format_ == OSP_FB_NONE)
+      return;
+    // the mapping keeps the OSPRay framebuffer alive, even if sg replaces
+    // (and releases) it meanwhile
+    data_ = (const uint8_t*)ospMapFrameBuffer(fb, OSP_FB_COLOR);
+    mappedFB = fb;
+  }
+
+  void AsyncRenderEngine::Framebuffer::reference(const void* pixels,
+      const vec2i& size, const OSPFrameBufferFormat format)
+  {
+    release();
+    setSize(size, format);
+    data_ = (const uint8_t*)pixels;
+  }
+
+  uint8_t* AsyncRenderEngine::Framebuffer::allocate(const vec2i& size,
       const OSPFrameBufferFormat format)
   {
-    format_ = format;
-    size_ = size;
-    bytes = size.x * size.y;
-    switch (format) {
-      default: /* fallthrough */
-      case OSP_FB_NONE:
+    release();
+    setSize(size, format);
+    size_t bytes = size_.x * size_.y;
+    switch (format_) {
+      default:
         bytes = 0;
-        size_ = vec2i(0);
         break;
       case OSP_FB_RGBA8: /* fallthrough */
       case OSP_FB_SRGBA:
@@ -387,7 +426,27 @@ namespace ospray {
         bytes *= 4*sizeof(float);
         break;
     }
-    buf.reserve(bytes);
+    buf.resize(bytes);
+    data_ = buf.data();
+    return buf.data();
+  }
+
+  void AsyncRenderEngine::Framebuffer::release()
+  {
+    if (mappedFB) {
+      ospUnmapFrameBuffer(data_, mappedFB);
+      mappedFB = nullptr;
+    }
+    data_ = nullptr;
+  }
+
+  void AsyncRenderEngine::Framebuffer::setSize(const vec2i& size,
+      const OSPFrameBufferFormat format)
+  {
+    format_ = format;
+    size_ = size;
+    if (format == OSP_FB_NONE)
+      size_ = vec2i(0);
   }
 
 }// namespace ospray
@@ -72,21 +72,36 @@ namespace ospray {
     bool          hasNewPickResult();
     OSPPickResult getPickResult();
 
+    /*! the pixels of a frame handed to the consumer: either the mapped
+        color buffer of an OSPRay framebuffer (which, with more than one
+        "colorBufferCount", stays valid while the next frame renders),
+        pixels owned by e.g. a denoiser, or its own storage */
     class Framebuffer
     {
     public:
+      ~Framebuffer() { release(); }
       vec2i size() const noexcept { return size_; }
       OSPFrameBufferFormat format() const noexcept { return format_; }
-      void resize(const vec2i& size, const OSPFrameBufferFormat format);
-      void copy(const uint8_t* src) { if (src) memcpy(buf.data(), src, bytes); }
-      const uint8_t* data() const noexcept { return buf.data(); }
+      const uint8_t* data() const noexcept { return data_; }
+
+      void map(OSPFrameBuffer fb, const vec2i& size,
+               const OSPFrameBufferFormat format);
+      void reference(const void* pixels, const vec2i& size,
+                     const OSPFrameBufferFormat format);
+      uint8_t* allocate(const vec2i& size, const OSPFrameBufferFormat format);
+      //! unmaps the OSPRay framebuffer, if mapped
+      void release();
     private:
+      void setSize(const vec2i& size, const OSPFrameBufferFormat format);
+
       vec2i size_;
-      OSPFrameBufferFormat format_;
-      size_t bytes;
+      OSPFrameBufferFormat format_ {OSP_FB_NONE};
+      const uint8_t* data_ {nullptr};
+      OSPFrameBuffer mappedFB {nullptr};
       std::vector<uint8_t> buf;
     };
 
+    //! the latest frame, valid until unmapFramebuffer()
     const Framebuffer& mapFramebuffer();
     void unmapFramebuffer();
 
@@ -112,6 +127,8 @@ namespace ospray {
     utility::DoubleBufferedValue<Framebuffer> frameBuffers;
 
     std::atomic<bool> newPixels {false};
+    //! the consumer is between mapFramebuffer() and unmapFramebuffer()
+    std::atomic<bool> frontMapped {false};
 
     bool commitDeviceOnAsyncLoopThread {true};
 
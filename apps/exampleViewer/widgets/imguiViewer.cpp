@@ -523,8 +523,17 @@ namespace ospray {
       if (fbData) {
         fbAspect = fbSize.x/float(fbSize.y);
         glBindTexture(GL_TEXTURE_2D, fbTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, texFormat, fbSize.x, fbSize.y, 0, GL_RGBA,
-            texelType, fbData);
+        // upload directly from the mapped frame, only (re)allocating the
+        // texture if its size or format changed
+        if (fbSize != fbTextureSize || mappedFB.format() != fbTextureFormat) {
+          glTexImage2D(GL_TEXTURE_2D, 0, texFormat, fbSize.x, fbSize.y, 0,
+              GL_RGBA, texelType, fbData);
+          fbTextureSize = fbSize;
+          fbTextureFormat = mappedFB.format();
+        } else {
+          glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fbSize.x, fbSize.y, GL_RGBA,
+              texelType, fbData);
+        }
       } else
         fbAspect = 1.f;
 
@@ -91,6 +91,9 @@ namespace ospray {
 
     imgui3D::ImGui3DWidget::ViewPort originalView;
     bool saveScreenshot {false}; // write next mapped framebuffer to disk
+    // size and format of the frame the fbTexture was last allocated for
+    vec2i fbTextureSize {0};
+    OSPFrameBufferFormat fbTextureFormat {OSP_FB_NONE};
     bool cancelFrameOnInteraction {true};
 
     float frameProgress {0.f};
@@ -0,0 +1,156 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/vec.h"
+// std
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+// posix
+#include <sys/types.h>
+
+namespace ospray {
+  namespace utility {
+
+    /*! reads a raw volume plane by plane (in z), converting its voxels to
+        float, such that the conversion utilities can stream through
+        volumes much larger than memory. Coordinates outside the volume
+        are clamped to its border, like Array3D::get() does */
+    struct RawSlabReader
+    {
+      RawSlabReader(const std::string &fileName,
+                    const std::string &format,
+                    const ospcommon::vec3i &dims);
+      ~RawSlabReader();
+
+      /*! read the planes [begin, begin+count) into 'out', as planes of
+          'size' (which may be larger than the volume) */
+      void read(int begin,
+                int count,
+                const ospcommon::vec2i &size,
+                float *out);
+
+      const ospcommon::vec3i dims;
+
+    private:
+      /*! load plane 'z' (clamped to the volume) into 'plane' */
+      void loadPlane(int z);
+
+      template <typename T>
+      void convertPlane();
+
+      FILE *file {nullptr};
+      size_t voxelSize {0};
+      std::vector<unsigned char> raw;
+      std::vector<float> plane;
+      int currentPlane {-1};
+    };
+
+    // Inlined definitions ////////////////////////////////////////////////
+
+    inline RawSlabReader::RawSlabReader(const std::string &fileName,
+                                        const std::string &format,
+                                        const ospcommon::vec3i &dims)
+        : dims(dims)
+    {
+      if (format == "float")
+        voxelSize = sizeof(float);
+      else if (format == "byte" || format == "uchar" || format == "uint8")
+        voxelSize = sizeof(unsigned char);
+      else if (format == "double" || format == "float64")
+        voxelSize = sizeof(double);
+      else
+        throw std::runtime_error("unknown input voxel format");
+
+      file = fopen(fileName.c_str(), "rb");
+      if (!file)
+        throw std::runtime_error("could not open input file '" + fileName +
+                                 "'");
+
+      raw.resize(voxelSize * dims.x * dims.y);
+      plane.resize(size_t(dims.x) * dims.y);
+    }
+
+    inline RawSlabReader::~RawSlabReader()
+    {
+      if (file)
+        fclose(file);
+    }
+
+    template <typename T>
+    inline void RawSlabReader::convertPlane()
+    {
+      const T *in = (const T *)raw.data();
+      ospcommon::tasking::parallel_for(dims.y, [&](int iy) {
+        const size_t row = size_t(iy) * dims.x;
+        for (int ix = 0; ix < dims.x; ix++)
+          plane[row + ix] = (float)in[row + ix];
+      });
+    }
+
+    inline void RawSlabReader::loadPlane(int z)
+    {
+      z = std::max(0, std::min(z, dims.z - 1));
+      if (z == currentPlane)
+        return;
+
+      // planes are mostly read in order, so only seek when we have to
+      if (z != currentPlane + 1) {
+        const off_t ofs = off_t(voxelSize) * dims.x * dims.y * z;
+        if (fseeko(file, ofs, SEEK_SET) != 0)
+          throw std::runtime_error("could not seek in input file");
+      }
+
+      if (fread(raw.data(), voxelSize, size_t(dims.x) * dims.y, file) !=
+          size_t(dims.x) * dims.y)
+        throw std::runtime_error("could not read plane from input file");
+
+      if (voxelSize == sizeof(float))
+        convertPlane<float>();
+      else if (voxelSize == sizeof(double))
+        convertPlane<double>();
+      else
+        convertPlane<unsigned char>();
+
+      currentPlane = z;
+    }
+
+    inline void RawSlabReader::read(int begin,
+                                    int count,
+                                    const ospcommon::vec2i &size,
+                                    float *out)
+    {
+      const size_t planeSize = size_t(size.x) * size.y;
+      for (int i = 0; i < count; i++) {
+        loadPlane(begin + i);
+        float *outPlane = out + i * planeSize;
+        ospcommon::tasking::parallel_for(size.y, [&](int iy) {
+          const float *in =
+              plane.data() + size_t(std::min(iy, dims.y - 1)) * dims.x;
+          float *row = outPlane + size_t(iy) * size.x;
+          for (int ix = 0; ix < size.x; ix++)
+            row[ix] = in[std::min(ix, dims.x - 1)];
+        });
+      }
+    }
+
+  } // ::ospray::utility
+} // ::ospray
@@ -17,16 +17,16 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wundefined-func-template"
 
+#include "RawSlabReader.h"
 #include "ospcommon/FileName.h"
-#include "ospcommon/array3D/Array3D.h"
 #include "ospcommon/box.h"
 #include "ospcommon/tasking/parallel_for.h"
 // std
+#include <memory>
 #include <mutex>
 
 namespace ospray {
   namespace amr {
-    using namespace ospcommon::array3D;
     using namespace ospcommon;
     using namespace std;
 
@@ -37,7 +37,6 @@ namespace ospray {
       float dt;
     };
 
-    static std::mutex fileMutex;
     static FILE *infoOut = nullptr;
     static FILE *dataOut = nullptr;
 
@@ -80,14 +79,168 @@ namespace ospray {
       double lastPingTime {-1.0};
     };
 
-    void makeAMR(const std::shared_ptr<Array3D<float>> _in,
+    /*! one level of the hierarchy, which is streamed through in slabs
+        of one row of bricks in z: once the slab of a level is complete
+        its bricks get written, and it gets reduced into the slab of the
+        next coarser level */
+    struct LevelSlab
+    {
+      vec3i size;              //!< logical size of the entire level
+      std::vector<float> data; //!< 'BS' planes of the level
+      int numPlanes {0};       //!< number of complete planes in 'data'
+      int begin {0};           //!< z of the first plane in 'data'
+      int numReduced {0};      //!< finer planes reduced into the next plane
+      std::unique_ptr<Progress> progress;
+    };
+
+    struct AMRStream
+    {
+      AMRStream(const vec3i &finestLevelSize,
+                const int numLevels,
+                const int BS,
+                const int RF,
+                const float threshold)
+          : BS(BS), RF(RF), threshold(threshold), levels(numLevels)
+      {
+        vec3i levelSize = finestLevelSize;
+        for (int level = numLevels - 1; level >= 0; --level) {
+          LevelSlab &slab = levels[level];
+          slab.size       = levelSize;
+          slab.data.resize(size_t(levelSize.x) * levelSize.y * BS, 0.f);
+          slab.progress.reset(new Progress("level progress:",
+                                           (levelSize / BS).product(),
+                                           30.f));
+          cout << "logical size of level " << level << " is " << levelSize
+               << endl;
+          levelSize = levelSize / RF;
+        }
+      }
+
+      /*! the slab of the finest level, to be filled by the caller */
+      float *finestSlab()
+      {
+        return levels.back().data.data();
+      }
+
+      /*! write the bricks of the (filled) slab of the finest level, and
+          propagate it to the coarser levels */
+      void finishFinestSlab()
+      {
+        levels.back().numPlanes = BS;
+        processSlab(levels.size() - 1);
+      }
+
+    private:
+      void processSlab(const int level)
+      {
+        LevelSlab &slab = levels[level];
+        writeBricks(level);
+        for (int iz = 0; iz < BS; iz++)
+          if (level > 0)
+            reducePlane(level, iz);
+
+        slab.begin += BS;
+        slab.numPlanes = 0;
+        if (slab.begin == slab.size.z) {
+          cout << "done level " << level << ", written " << numWritten
+               << " bricks, removed " << numRemoved << endl;
+        }
+      }
+
+      /*! write the bricks of the slab, in parallel for each row of bricks
+          (which bounds the memory for the bricks to one row), but in the
+          same order as they are enumerated */
+      void writeBricks(const int level)
+      {
+        LevelSlab &slab = levels[level];
+        const vec3i numBricks = slab.size / BS;
+        const size_t planeSize = size_t(slab.size.x) * slab.size.y;
+
+        std::vector<std::vector<float>> data(numBricks.x);
+        std::vector<range1f> ranges(numBricks.x);
+        for (int by = 0; by < numBricks.y; by++) {
+          ospcommon::tasking::parallel_for(numBricks.x, [&](int bx) {
+            data[bx].resize(BS * BS * BS);
+            size_t out = 0;
+            range1f brickRange;
+            for (int iz = 0; iz < BS; iz++)
+              for (int iy = by * BS; iy < (by + 1) * BS; iy++) {
+                const float *row =
+                    slab.data.data() + iz * planeSize + iy * slab.size.x;
+                for (int ix = bx * BS; ix < (bx + 1) * BS; ix++) {
+                  data[bx][out++] = row[ix];
+                  brickRange.extend(row[ix]);
+                }
+              }
+            ranges[bx] = brickRange;
+          });
+
+          for (int bx = 0; bx < numBricks.x; bx++) {
+            if ((level > 0) &&
+                ((ranges[bx].upper - ranges[bx].lower) <= threshold)) {
+              numRemoved++;
+            } else {
+              BrickDesc brick;
+              brick.level     = level;
+              brick.dt        = 1.f / powf(RF, level);
+              brick.box.lower = vec3i(bx, by, slab.begin / BS) * BS;
+              brick.box.upper = brick.box.lower + (BS - 1);
+              numWritten++;
+              fwrite(&brick, sizeof(brick), 1, infoOut);
+              fwrite(data[bx].data(), sizeof(float), BS * BS * BS, dataOut);
+            }
+            slab.progress->ping();
+          }
+        }
+      }
+
+      /*! add plane 'iz' of the slab of 'level' to the current plane of
+          the next coarser level; this adds up the values of each cell in
+          the same order as reducing the entire level would */
+      void reducePlane(const int level, const int iz)
+      {
+        const LevelSlab &slab = levels[level];
+        LevelSlab &next       = levels[level - 1];
+        const size_t planeSize     = size_t(slab.size.x) * slab.size.y;
+        const size_t nextPlaneSize = size_t(next.size.x) * next.size.y;
+
+        float *nextPlane = next.data.data() + next.numPlanes * nextPlaneSize;
+        if (next.numReduced == 0)
+          std::fill(nextPlane, nextPlane + nextPlaneSize, 0.f);
+
+        const int numCells = RF * RF * RF;
+        ospcommon::tasking::parallel_for(next.size.y, [&](int ny) {
+          float *out = nextPlane + ny * next.size.x;
+          for (int iy = ny * RF; iy < (ny + 1) * RF; iy++) {
+            const float *row =
+                slab.data.data() + iz * planeSize + iy * slab.size.x;
+            for (int ix = 0; ix < slab.size.x; ix++)
+              out[ix / RF] += row[ix] / numCells;
+          }
+        });
+
+        if (++next.numReduced == RF) {
+          next.numReduced = 0;
+          if (++next.numPlanes == BS)
+            processSlab(level - 1);
+        }
+      }
+
+      const int BS;
+      const int RF;
+      const float threshold;
+      std::vector<LevelSlab> levels; //!< indexed by level, 0 is coarsest
+    };
+
+    /*! build the AMR hierarchy by streaming through the input volume in
+        slabs of one row of bricks, such that the memory required is a
+        slab per level, rather than the entire volume */
+    void makeAMR(utility::RawSlabReader &in,
                  const int numLevels,
                  const int BS,
                  const int RF,
                  const float threshold)
     {
-      std::shared_ptr<Array3D<float>> in = _in;
-
       int minWidth = BS;
       std::cout << "building AMR model out of RAW volume. BS = " << BS
                 << ", RF = " << RF << endl;
@@ -95,84 +248,28 @@ namespace ospray {
       for (int i = 1; i < numLevels; i++)
         minWidth *= RF;
 
-      if (minWidth >= RF * reduce_max(in->size()))
+      if (minWidth >= RF * reduce_max(in.dims))
         throw std::runtime_error(
             "too many levels, or too fine a refinement factor."
             "do not have a single brick at the root...");
       vec3i finestLevelSize = ospcommon::vec3i(minWidth);
-      while (finestLevelSize.x < in->size().x)
+      while (finestLevelSize.x < in.dims.x)
         finestLevelSize.x += minWidth;
-      while (finestLevelSize.y < in->size().y)
+      while (finestLevelSize.y < in.dims.y)
         finestLevelSize.y += minWidth;
-      while (finestLevelSize.z < in->size().z)
+      while (finestLevelSize.z < in.dims.z)
         finestLevelSize.z += minWidth;
 
       cout << "logical finest level size is " << finestLevelSize << endl;
-      cout << "(note: input size was " << in->size() << ")" << endl;
+      cout << "(note: input size was " << in.dims << ")" << endl;
 
-      /* create and write the bricks */
-      vec3i levelSize = finestLevelSize;
-      for (int level = numLevels - 1; level >= 0; --level) {
-        cout << "-------------------------------------------------------"
-             << endl;
-        cout << "logical size of level " << level << " is " << levelSize
-             << endl;
-        const vec3i nextLevelSize = levelSize / RF;
-        cout << "reducing to next level of " << nextLevelSize << endl;
-        std::shared_ptr<ActualArray3D<float>> nextLevel =
-            std::make_shared<ActualArray3D<float>>(nextLevelSize);
-        // clear next level
-        for (int iz = 0; iz < nextLevelSize.z; iz++)
-          for (int iy = 0; iy < nextLevelSize.y; iy++)
-            for (int ix = 0; ix < nextLevelSize.x; ix++)
-              nextLevel->set(vec3i(ix, iy, iz), 0.f);
-
-        const vec3i numBricks = levelSize / BS;
-        PRINT(numBricks);
-        PRINT(numBricks.product());
-        Progress progress("level progress:", numBricks.product(), 30.f);
-        ospcommon::tasking::parallel_for(
-            numBricks.product(), [&](int brickIdx) {
-              BrickDesc brick;
-              brick.level = level;
-              brick.dt    = 1.f / powf(RF, level);
-              const vec3i brickID(brickIdx % numBricks.x,
-                                  (brickIdx / numBricks.x) % numBricks.y,
-                                  brickIdx / (numBricks.x * numBricks.y));
-              brick.box.lower = brickID * BS;
-              brick.box.upper = brick.box.lower + (BS - 1);
-              std::vector<float> data(BS * BS * BS);
-              size_t out = 0;
-              ospcommon::range1f brickRange;
-              for (int iz = brick.box.lower.z; iz <= brick.box.upper.z; iz++)
-                for (int iy = brick.box.lower.y; iy <= brick.box.upper.y; iy++)
-                  for (int ix = brick.box.lower.x; ix <= brick.box.upper.x;
-                       ix++) {
-                    const vec3i thisLevelCoord(ix, iy, iz);
-                    const vec3i nextLevelCoord(ix / RF, iy / RF, iz / RF);
-                    const float v = in->get(thisLevelCoord);
-                    data[out++]   = v;
-                    nextLevel->set(
-                        nextLevelCoord,
-                        nextLevel->get(nextLevelCoord) + (v / (RF * RF * RF)));
-                    brickRange.extend(v);
-                  }
-
-              std::lock_guard<std::mutex> lock(fileMutex);
-              if ((level > 0) &&
-                  ((brickRange.upper - brickRange.lower) <= threshold)) {
-                numRemoved++;
-              } else {
-                numWritten++;
-                fwrite(&brick, sizeof(brick), 1, infoOut);
-                fwrite(data.data(), sizeof(float), BS * BS * BS, dataOut);
-              }
-              progress.ping();
-            });
-        in        = nextLevel;
-        levelSize = nextLevelSize;
-        cout << "done level " << level << ", written " << numWritten
-             << " bricks, removed " << numRemoved << endl;
+      AMRStream stream(finestLevelSize, numLevels, BS, RF, threshold);
+      for (int iz = 0; iz < finestLevelSize.z; iz += BS) {
+        in.read(iz,
+                BS,
+                vec2i(finestLevelSize.x, finestLevelSize.y),
+                stream.finestSlab());
+        stream.finishFinestSlab();
       }
     }
 
@@ -194,18 +291,7 @@ namespace ospray {
       float threshold         = atof(av[9]);
       std::string outFileBase = av[10];
 
-      std::shared_ptr<Array3D<float>> in;
-      if (format == "float") {
-        in = mmapRAW<float>(inFileName, inDims);
-      } else if (format == "byte" || format == "uchar" || format == "uint8") {
-        in = std::make_shared<Array3DAccessor<unsigned char, float>>(
-            mmapRAW<unsigned char>(inFileName, inDims));
-      } else if (format == "double" || format == "float64") {
-        in = std::make_shared<Array3DAccessor<double, float>>(
-            mmapRAW<double>(inFileName, inDims));
-      } else {
-        throw std::runtime_error("unknown input voxel format");
-      }
+      utility::RawSlabReader in(inFileName, format, inDims);
 
       infoOut = fopen((outFileBase + ".info").c_str(), "wb");
       if (!infoOut)
@@ -17,7 +17,7 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wundefined-func-template"
 
-#include "ospcommon/array3D/Array3D.h"
+#include "RawSlabReader.h"
 #include "ospcommon/box.h"
 #include "ospcommon/tasking/parallel_for.h"
 // std
@@ -27,7 +27,6 @@
 
 namespace ospray {
   namespace vtu {
-    using namespace ospcommon::array3D;
     using namespace ospcommon;
     using namespace std;
 
@@ -38,28 +37,76 @@ namespace ospray {
       unknown = 0xff
     };
 
-    struct PointsData {
-      void resize(uint64_t count) {
-        samples.resize(count);
-        coords.resize(count);
+    /*! an array of the appended data of the output, which gets streamed
+        to a temporary file during the conversion, as the offsets of the
+        arrays in the output are only known at the end */
+    struct ArrayStream
+    {
+      ArrayStream(const std::string &fileName) : fileName(fileName)
+      {
+        file = fopen(fileName.c_str(), "w+b");
+        if (!file)
+          throw std::runtime_error("could not open temporary file '" +
+                                   fileName + "'");
+      }
+
+      ~ArrayStream()
+      {
+        fclose(file);
+        remove(fileName.c_str());
+      }
+
+      template <class T>
+      void write(const std::vector<T> &v)
+      {
+        fwrite(v.data(), sizeof(v[0]), v.size(), file);
+        numBytes += v.size() * sizeof(v[0]);
+      }
+
+      /*! append the array, preceded by its length, to 'out' */
+      void dump(FILE *out)
+      {
+        fwrite(&numBytes, sizeof(numBytes), 1, out);
+        rewind(file);
+        std::vector<char> buffer(64 << 20);
+        size_t n;
+        while ((n = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+          fwrite(buffer.data(), 1, n, out);
       }
 
-      std::vector<float> samples;
+      std::string fileName;
+      FILE *file {nullptr};
+      uint64_t numBytes {0};
+    };
+
+    struct PointsData
+    {
+      PointsData(const std::string &fileBase)
+          : samples(fileBase + ".samples.tmp"),
+            coords(fileBase + ".coords.tmp")
+      {
+      }
+
+      uint64_t count {0};
+      ArrayStream samples;
       range1f samplesRange;
-      std::vector<vec3f> coords;
+      ArrayStream coords;
       box3f coordsRange;
     };
 
-    struct CellsData {
-      void resize(uint64_t count, unsigned int vertsPerCell) {
-        connectivity.resize(vertsPerCell * count);
-        offsets.resize(count);
-        types.resize(count);
+    struct CellsData
+    {
+      CellsData(const std::string &fileBase)
+          : connectivity(fileBase + ".connectivity.tmp"),
+            offsets(fileBase + ".offsets.tmp"),
+            types(fileBase + ".types.tmp")
+      {
       }
 
-      std::vector<uint64_t> connectivity;
-      std::vector<uint64_t> offsets;
-      std::vector<uint8_t> types;
+      uint64_t count {0};
+      ArrayStream connectivity;
+      ArrayStream offsets;
+      ArrayStream types;
     };
 
     static size_t numWritten = 0;
@@ -108,14 +155,17 @@ namespace ospray {
       double lastPingTime {-1.0};
     };
 
-    void makeVTU(const std::shared_ptr<Array3D<float>>& _in,
+    /*! convert the volume plane by plane, such that only the two planes
+        of the current layer of cells (and their bookkeeping) are in
+        memory: the cells of a layer are classified in parallel, and a
+        plane of points is written (compacted to the points referenced by
+        any cell) once both layers touching it have been classified */
+    void makeVTU(utility::RawSlabReader &in,
                  const std::string primType,
                  const range1f& threshold,
                  PointsData& points,
                  CellsData& cells)
     {
-      std::shared_ptr<Array3D<float>> in = _in;
-
       int verticesCubes[][8]  = {{0, 1, 3, 2, 4, 5, 7, 6}};
       int verticesTets[][4]   = {{0, 1, 3, 5}, {3, 2, 0, 6}, {5, 4, 6, 0}, {6, 7, 5, 3}, {0, 3, 6, 5}};  // can also be 6 [mirror] identical tets per cube
       int verticesWedges[][6] = {{0, 1, 3, 4, 5, 7}, {3, 2, 0, 7, 6, 4}};
@@ -134,101 +184,135 @@ namespace ospray {
         default:              cellsPerMacroCell = 0; vertsPerCell = 0; vertIndices = nullptr; break;
       }
 
-      const vec3i pointsTotal = in->size();
-      const vec3i macroCellsTotal = in->size() - vec3i(1);
-      points.resize(pointsTotal.product());
-      cells.resize(cellsPerMacroCell * macroCellsTotal.product(), vertsPerCell);
-      vector<int64_t> pointRefs;
-      pointRefs.resize(pointsTotal.product());
-
-      // compute the entire points array and cells; record the reference counts from cells to points
-      Progress progress("progress", pointsTotal.product(), 1.f);
-      ospcommon::tasking::serial_for(pointsTotal.product(), [&](int pointIdx) {
-        vec3i coords(pointIdx % pointsTotal.x, (pointIdx / pointsTotal.x) % pointsTotal.y, (pointIdx / pointsTotal.x / pointsTotal.y));
-        points.samples[pointIdx] = in->get(coords);
-        points.coords[pointIdx] = coords;
-
-        // create cells
-        if (coords.x < macroCellsTotal.x && coords.y < macroCellsTotal.y && coords.z < macroCellsTotal.z) {
-          for (unsigned int cellInMacroCellIdx = 0; cellInMacroCellIdx < cellsPerMacroCell; cellInMacroCellIdx++) {
+      const vec3i pointsTotal = in.dims;
+      const vec3i macroCellsTotal = in.dims - vec3i(1);
+      const size_t planeSize = size_t(pointsTotal.x) * pointsTotal.y;
+      const size_t cellsPerLayer =
+          size_t(cellsPerMacroCell) * macroCellsTotal.x * macroCellsTotal.y;
+
+      // the two planes of the current layer of cells; the references
+      // from cells to their points, which become the indices of the
+      // compacted points (or -1) once a plane is complete; and which
+      // cells of the current and previous layer are kept
+      std::vector<float> samples[2];
+      std::vector<int64_t> pointRefs[3];
+      std::vector<uint8_t> keep[2];
+      for (int i = 0; i < 2; i++) {
+        samples[i].resize(planeSize);
+        keep[i].resize(cellsPerLayer);
+      }
+      for (int i = 0; i < 3; i++)
+        pointRefs[i].resize(planeSize, 0);
+      int64_t *prevIndex = pointRefs[0].data();
+      int64_t *curRefs   = pointRefs[1].data();
+      int64_t *nextRefs  = pointRefs[2].data();
+      uint8_t *prevKeep  = keep[0].data();
+      uint8_t *curKeep   = keep[1].data();
+      float *curPlane    = samples[0].data();
+      float *nextPlane   = samples[1].data();
+
+      auto vertexOffset = [&](int vertIdx) {
+        return vec3i((vertIdx&1) >> 0, (vertIdx&2) >> 1, (vertIdx&4) >> 2);
+      };
+
+      Progress progress("progress", pointsTotal.z, 1.f);
+      in.read(0, 1, vec2i(pointsTotal.x, pointsTotal.y), curPlane);
+      for (int iz = 0; iz < pointsTotal.z; iz++) {
+        // classify the cells of layer 'iz', and reference their points
+        if (iz < macroCellsTotal.z) {
+          in.read(iz + 1, 1, vec2i(pointsTotal.x, pointsTotal.y), nextPlane);
+          const float *planes[2] = {curPlane, nextPlane};
+          ospcommon::tasking::parallel_for(macroCellsTotal.y, [&](int iy) {
+            for (int ix = 0; ix < macroCellsTotal.x; ix++)
+              for (unsigned int cellInMacroCellIdx = 0; cellInMacroCellIdx < cellsPerMacroCell; cellInMacroCellIdx++) {
+                const size_t cellIdx = cellsPerMacroCell * (ix + size_t(iy) * macroCellsTotal.x) + cellInMacroCellIdx;
 #if USE_THRESHOLD
-            float sum = 0.f;
-            for (unsigned int cellVertexIdx = 0; cellVertexIdx < vertsPerCell; cellVertexIdx++) {
-              int vertIdx = vertIndices[cellInMacroCellIdx*vertsPerCell + cellVertexIdx];
-              sum += in->get(coords + vec3i((vertIdx&1) >> 0, (vertIdx&2) >> 1, (vertIdx&4) >> 2));
-            }
-            sum /= vertsPerCell;
-
-            if (threshold.contains(sum)) {
+                float sum = 0.f;
+                for (unsigned int cellVertexIdx = 0; cellVertexIdx < vertsPerCell; cellVertexIdx++) {
+                  const vec3i v = vec3i(ix, iy, 0) + vertexOffset(vertIndices[cellInMacroCellIdx*vertsPerCell + cellVertexIdx]);
+                  sum += planes[v.z][v.x + size_t(v.y) * pointsTotal.x];
+                }
+                sum /= vertsPerCell;
+                curKeep[cellIdx] = threshold.contains(sum);
+#else
+                curKeep[cellIdx] = true;
 #endif
-              int64_t cellIdx = cellsPerMacroCell * (coords.x + coords.y*macroCellsTotal.x + coords.z*macroCellsTotal.x*macroCellsTotal.y) + cellInMacroCellIdx;
-              for (unsigned int cellVertexIdx = 0; cellVertexIdx < vertsPerCell; cellVertexIdx++) {
-                int vertIdx = vertIndices[cellInMacroCellIdx*vertsPerCell + cellVertexIdx];
-                cells.connectivity[vertsPerCell*cellIdx + cellVertexIdx] = pointIdx + ((vertIdx&1) >> 0)*1 + ((vertIdx&2) >> 1)*pointsTotal.x + ((vertIdx&4) >> 2)*pointsTotal.y*pointsTotal.x;
               }
-              cells.offsets[cellIdx] = vertsPerCell * (cellIdx+1);
-              cells.types[cellIdx] = cellType;
-              numWritten++;
-#if USE_THRESHOLD
-              for (unsigned int cellVertexIdx = 0; cellVertexIdx < vertsPerCell; cellVertexIdx++)
-                pointRefs[cells.connectivity[vertsPerCell*cellIdx + cellVertexIdx]]++;
+          });
+
+          for (int iy = 0; iy < macroCellsTotal.y; iy++)
+            for (int ix = 0; ix < macroCellsTotal.x; ix++)
+              for (unsigned int cellInMacroCellIdx = 0; cellInMacroCellIdx < cellsPerMacroCell; cellInMacroCellIdx++) {
+                const size_t cellIdx = cellsPerMacroCell * (ix + size_t(iy) * macroCellsTotal.x) + cellInMacroCellIdx;
+                if (!curKeep[cellIdx]) {
+                  numRemoved++;
+                  continue;
+                }
+                numWritten++;
+                for (unsigned int cellVertexIdx = 0; cellVertexIdx < vertsPerCell; cellVertexIdx++) {
+                  const vec3i v = vec3i(ix, iy, 0) + vertexOffset(vertIndices[cellInMacroCellIdx*vertsPerCell + cellVertexIdx]);
+                  (v.z ? nextRefs : curRefs)[v.x + size_t(v.y) * pointsTotal.x]++;
+                }
+              }
+        }
+
+        // plane 'iz' is complete: compact its points
+        std::vector<float> planeSamples;
+        std::vector<vec3f> planeCoords;
+        for (int iy = 0; iy < pointsTotal.y; iy++)
+          for (int ix = 0; ix < pointsTotal.x; ix++) {
+            const size_t pointIdx = ix + size_t(iy) * pointsTotal.x;
+            if (curRefs[pointIdx] == 0) {
+              curRefs[pointIdx] = -1;
+              continue;
             }
-            else
-              numRemoved++;
-#endif
+            curRefs[pointIdx] = points.count++;
+            const vec3f coords(ix, iy, iz);
+            planeSamples.push_back(curPlane[pointIdx]);
+            planeCoords.push_back(coords);
+            points.samplesRange.extend(curPlane[pointIdx]);
+            points.coordsRange.extend(coords);
           }
+        points.samples.write(planeSamples);
+        points.coords.write(planeCoords);
+
+        // ... which completes the cells of the previous layer
+        if (iz > 0) {
+          const int64_t *index[2] = {prevIndex, curRefs};
+          std::vector<uint64_t> connectivity;
+          std::vector<uint64_t> offsets;
+          for (int iy = 0; iy < macroCellsTotal.y; iy++)
+            for (int ix = 0; ix < macroCellsTotal.x; ix++)
+              for (unsigned int cellInMacroCellIdx = 0; cellInMacroCellIdx < cellsPerMacroCell; cellInMacroCellIdx++) {
+                const size_t cellIdx = cellsPerMacroCell * (ix + size_t(iy) * macroCellsTotal.x) + cellInMacroCellIdx;
+                if (!prevKeep[cellIdx])
+                  continue;
+                for (unsigned int cellVertexIdx = 0; cellVertexIdx < vertsPerCell; cellVertexIdx++) {
+                  const vec3i v = vec3i(ix, iy, 0) + vertexOffset(vertIndices[cellInMacroCellIdx*vertsPerCell + cellVertexIdx]);
+                  connectivity.push_back(index[v.z][v.x + size_t(v.y) * pointsTotal.x]);
+                }
+                offsets.push_back(vertsPerCell * (cells.count + offsets.size() + 1));
+              }
+          cells.count += offsets.size();
+          cells.connectivity.write(connectivity);
+          cells.offsets.write(offsets);
+          cells.types.write(std::vector<uint8_t>(offsets.size(), cellType));
         }
 
-        progress.ping();
-      });
+        // advance to the next layer
+        std::swap(prevIndex, curRefs);
+        std::swap(curRefs, nextRefs);
+        std::fill(nextRefs, nextRefs + planeSize, 0);
+        std::swap(prevKeep, curKeep);
+        std::swap(curPlane, nextPlane);
 
-#if USE_THRESHOLD
-      int64_t i_without_gaps;
-      // compact the points array
-      i_without_gaps = 0;
-      for (int64_t i = 0; i < pointsTotal.product(); ) {
-        for (; i < pointsTotal.product() && pointRefs[i] != 0; i++, i_without_gaps++) {
-          points.samples[i_without_gaps] = points.samples[i];
-          points.samplesRange.extend(points.samples[i_without_gaps]);
-          points.coords[i_without_gaps] = points.coords[i];
-          points.coordsRange.extend(points.coords[i_without_gaps]);
-          pointRefs[i] = i_without_gaps;
-        }
-        for (; i < pointsTotal.product() && pointRefs[i] == 0; i++)
-          ;
-      }
-      points.resize(i_without_gaps);
-
-      // update the cell references to the just compacted points and compact it as well
-      i_without_gaps = 0;
-      for (int64_t i = 0; i < cellsPerMacroCell * macroCellsTotal.product(); ) {
-        for (; i < cellsPerMacroCell * macroCellsTotal.product() && cells.types[i] == cellType; i++, i_without_gaps++) {
-          for (unsigned int cellVertexIdx = 0; cellVertexIdx < vertsPerCell; cellVertexIdx++)
-            cells.connectivity[vertsPerCell*i_without_gaps + cellVertexIdx] = pointRefs[cells.connectivity[vertsPerCell*i + cellVertexIdx]];
-          cells.offsets[i_without_gaps] = vertsPerCell * (i_without_gaps+1);
-          cells.types[i_without_gaps] = cells.types[i];
-        }
-        for (; i < cellsPerMacroCell * macroCellsTotal.product() && cells.types[i] != cellType; i++)
-          ;
-      }
-      cells.resize(i_without_gaps, vertsPerCell);
-#else
-      for (int64_t i = 0; i < pointsTotal.product(); i++) {
-        points.samplesRange.extend(points.samples[i]);
-        points.coordsRange.extend(points.coords[i]);
+        progress.ping();
       }
-#endif
-    }
-
-    template <class T> void dumpVector(const std::vector<T> v, FILE* out) {
-      uint64_t len = v.size() * sizeof(v[0]);
-      fwrite(&len, sizeof(len), 1, out);
-      fwrite(v.data(), sizeof(v[0]), v.size(), out);
     }
 
     void outputVTU(const std::string& fileName,
-                   const PointsData& points,
-                   const CellsData& cells)
+                   PointsData& points,
+                   CellsData& cells)
     {
       uint64_t offset = 0;
       uint64_t len;
@@ -237,12 +321,11 @@ namespace ospray {
 
       vtuStructure << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\">" << endl;
       vtuStructure << "  <UnstructuredGrid>" << endl;
-      vtuStructure << "    <Piece NumberOfPoints=\"" << points.samples.size() << "\" NumberOfCells=\"" << cells.offsets.size() << "\">" << endl;
-
+      vtuStructure << "    <Piece NumberOfPoints=\"" << points.count << "\" NumberOfCells=\"" << cells.count << "\">" << endl;
       vtuStructure << "      <PointData Scalars=\"ImageFile\">" << endl;
       vtuStructure << "        <DataArray type=\"Float32\" Name=\"ImageFile\" format=\"appended\" RangeMin=\"" << points.samplesRange.lower << "\" RangeMax=\"" << points.samplesRange.upper << "\" offset=\"" << offset << "\">" << endl;
       vtuStructure << "        </DataArray>" << endl;
-      offset += points.samples.size() * sizeof(points.samples[0]) + sizeof(len);
+      offset += points.samples.numBytes + sizeof(len);
       vtuStructure << "      </PointData>" << endl;
 
       vtuStructure << "      <CellData>" << endl;
@@ -268,16 +351,16 @@ namespace ospray {
       vtuStructure << "            </Value>" << endl;
       vtuStructure << "          </InformationKey>" << endl;
       vtuStructure << "        </DataArray>" << endl;
-      offset += points.coords.size() * sizeof(points.coords[0]) + sizeof(len);
+      offset += points.coords.numBytes + sizeof(len);
       vtuStructure << "      </Points>" << endl;
 
       vtuStructure << "      <Cells>" << endl;
       vtuStructure << "        <DataArray type=\"Int64\" Name=\"connectivity\" format=\"appended\" RangeMin=\"\" RangeMax=\"\" offset=\"" << offset << "\"/>" << endl;
-      offset += cells.connectivity.size() * sizeof(cells.connectivity[0]) + sizeof(len);
+      offset += cells.connectivity.numBytes + sizeof(len);
       vtuStructure << "        <DataArray type=\"Int64\" Name=\"offsets\" format=\"appended\" RangeMin=\"\" RangeMax=\"\" offset=\"" << offset << "\"/>" << endl;
-      offset += cells.offsets.size() * sizeof(cells.offsets[0]) + sizeof(len);
+      offset += cells.offsets.numBytes + sizeof(len);
       vtuStructure << "        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" RangeMin=\"\" RangeMax=\"\" offset=\"" << offset << "\"/>" << endl;
-      offset += cells.types.size() * sizeof(cells.types[0]) + sizeof(len);
+      offset += cells.types.numBytes + sizeof(len);
       vtuStructure << "      </Cells>" << endl;
 
       vtuStructure << "    </Piece>" << endl;
@@ -290,11 +373,11 @@ namespace ospray {
       FILE* vtuData = fopen(fileName.c_str(), "ab");
       if (!vtuData)
         throw std::runtime_error("could not open data output file!");
-      dumpVector(points.samples, vtuData);
-      dumpVector(points.coords, vtuData);
-      dumpVector(cells.connectivity, vtuData);
-      dumpVector(cells.offsets, vtuData);
-      dumpVector(cells.types, vtuData);
+      points.samples.dump(vtuData);
+      points.coords.dump(vtuData);
+      cells.connectivity.dump(vtuData);
+      cells.offsets.dump(vtuData);
+      cells.types.dump(vtuData);
       fclose(vtuData);
 
       vtuStructure.open(fileName, std::ofstream::out | std::ofstream::app);
@@ -331,21 +414,10 @@ namespace ospray {
       const range1f threshold(-std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity());
       std::string outFileBase    = av[7];
 #endif
-      std::shared_ptr<Array3D<float>> in;
-      if (format == "float") {
-        in = mmapRAW<float>(inFileName, inDims);
-      } else if (format == "byte" || format == "uchar" || format == "uint8") {
-        in = std::make_shared<Array3DAccessor<unsigned char, float>>(
-            mmapRAW<unsigned char>(inFileName, inDims));
-      } else if (format == "double" || format == "float64") {
-        in = std::make_shared<Array3DAccessor<double, float>>(
-            mmapRAW<double>(inFileName, inDims));
-      } else {
-        throw std::runtime_error("unknown input voxel format");
-      }
+      utility::RawSlabReader in(inFileName, format, inDims);
 
-      PointsData points;
-      CellsData cells;
+      PointsData points(outFileBase);
+      CellsData cells(outFileBase);
       makeVTU(in, primType, threshold, points, cells);
       outputVTU(outFileBase + ".vtu", points, cells);
 
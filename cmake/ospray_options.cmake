@@ -92,6 +92,13 @@ set(OSPRAY_PIXELS_PER_JOB 64 CACHE STRING
     "Must be multiple of largest vector width *and* <= OSPRAY_TILE_SIZE")
 mark_as_advanced(OSPRAY_PIXELS_PER_JOB)
 
+option(OSPRAY_ENABLE_PROFILING
+  "Time the OSPRAY_PROFILE_ZONE()s, reported per frame at log level 2")
+mark_as_advanced(OSPRAY_ENABLE_PROFILING)
+
+option(OSPRAY_PROFILING_RDTSC "Take the profiler's timestamps with rdtsc")
+mark_as_advanced(OSPRAY_PROFILING_RDTSC)
+
 # Must be before ISA config and package
 include(configure_embree)
 
@@ -14,7 +14,9 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 #include "MPIBcastFabric.h"
@@ -36,26 +38,42 @@ namespace mpicommon {
 #endif
   }
 
+  constexpr size_t MPIBcastFabric::maxStagedSize;
+  constexpr size_t MPIBcastFabric::chunkSize;
+  constexpr size_t MPIBcastFabric::pipelineDepth;
+
+  MPIBcastFabric::~MPIBcastFabric()
+  {
+    // after finalizing (e.g. by the offload device on shutdown) the
+    // broadcasts are done already
+    int finalized = 0;
+    MPI_CALL(Finalized(&finalized));
+    if (finalized)
+      return;
+
+    for (auto &stage : staged)
+      waitForBcast(stage.requests);
+  }
+
   /*! receive some block of data - whatever the sender has sent -
     and give us size and pointer to this data */
   size_t MPIBcastFabric::read(void *&mem)
   {
-    uint32_t sz32 = 0;
-    // Get the size of the bcast being sent to us. Only this part must be non-blocking,
-    // after getting the size we know everyone will enter the blocking barrier and the
-    // blocking bcast where the buffer is sent out.
-    MPI_Request request;
-    MPI_CALL(Ibcast(&sz32, 1, MPI_INT, recvRank, group.comm, &request));
-
-    // Now do non-blocking test to see when this bcast is satisfied to avoid
-    // locking out the send/recv threads
-    waitForBcast(request);
+    uint64_t size = 0;
+    // Get the size of the bcast being sent to us. Then receive the
+    // chunks, all with non-blocking tests to avoid locking out the
+    // send/recv threads
+    std::vector<MPI_Request> requests(1);
+    MPI_CALL(Ibcast(&size, 1, MPI_UINT64_T, recvRank, group.comm,
+                    &requests[0]));
+    waitForBcast(requests);
 
     // TODO: Maybe at some point we should dump the buffer if it gets really large
-    buffer.resize(sz32);
+    buffer.resize(size);
     mem = buffer.data();
-    MPI_CALL(Bcast(mem, sz32, MPI_BYTE, recvRank, group.comm));
-    return sz32;
+    bcastChunks(buffer.data(), size, recvRank, requests);
+    waitForBcast(requests);
+    return size;
   }
 
   /*! send exact number of bytes - the fabric can do that through
@@ -63,34 +81,75 @@ namespace mpicommon {
     delivered */
   void MPIBcastFabric::send(const void *_mem, size_t size)
   {
-    assert(size < (1LL<<30));
-    uint32_t sz32 = size;
-
-    // Send the size of the bcast we're sending. Only this part must be non-blocking,
-    // after getting the size we know everyone will enter the blocking barrier and the
-    // blocking bcast where the buffer is sent out.
-    MPI_Request request;
-    MPI_CALL(Ibcast(&sz32, 1, MPI_INT, sendRank, group.comm, &request));
-
-    // Now do non-blocking test to see when this bcast is satisfied to avoid
-    // locking out the send/recv threads
-    waitForBcast(request);
-
-    // NOTE(jda) - UGH! MPI doesn't let us send const data!
-    void *mem = const_cast<void*>(_mem);
-    MPI_CALL(Bcast(mem, sz32, MPI_BYTE, sendRank, group.comm));
+    if (size > maxStagedSize) {
+      // wait for the staged blocks to keep the order of the chunks
+      // of all blocks in flight at most 'pipelineDepth'
+      for (auto &stage : staged)
+        waitForBcast(stage.requests);
+
+      uint64_t size64 = size;
+      std::vector<MPI_Request> requests(1);
+      MPI_CALL(Ibcast(&size64, 1, MPI_UINT64_T, sendRank, group.comm,
+                      &requests[0]));
+      waitForBcast(requests);
+
+      // NOTE(jda) - UGH! MPI doesn't let us send const data!
+      byte_t *mem = static_cast<byte_t*>(const_cast<void*>(_mem));
+      bcastChunks(mem, size, sendRank, requests);
+      waitForBcast(requests);
+      return;
+    }
+
+    // the other stage may still be in flight while this one is reused
+    StagedBlock &stage = staged[currentStage];
+    currentStage = 1 - currentStage;
+    waitForBcast(stage.requests);
+
+    stage.size = size;
+    stage.data.resize(size);
+    std::memcpy(stage.data.data(), _mem, size);
+
+    stage.requests.resize(1);
+    MPI_CALL(Ibcast(&stage.size, 1, MPI_UINT64_T, sendRank, group.comm,
+                    &stage.requests[0]));
+    std::vector<MPI_Request> chunks;
+    bcastChunks(stage.data.data(), size, sendRank, chunks);
+    stage.requests.insert(stage.requests.end(), chunks.begin(), chunks.end());
+  }
+
+  void MPIBcastFabric::bcastChunks(byte_t *mem, size_t size, int root,
+                                   std::vector<MPI_Request> &requests)
+  {
+    requests.clear();
+    for (size_t begin = 0; begin < size; begin += chunkSize) {
+      // keep at most 'pipelineDepth' chunks in flight
+      if (requests.size() == pipelineDepth) {
+        std::vector<MPI_Request> oldest(1, requests.front());
+        waitForBcast(oldest);
+        requests.erase(requests.begin());
+      }
+
+      const int count = std::min(chunkSize, size - begin);
+      requests.emplace_back();
+      MPI_CALL(Ibcast(mem + begin, count, MPI_BYTE, root, group.comm,
+                      &requests.back()));
+    }
   }
 
-  void MPIBcastFabric::waitForBcast(MPI_Request &request)
+  void MPIBcastFabric::waitForBcast(std::vector<MPI_Request> &requests)
   {
+    if (requests.empty())
+      return;
+
     for(;;) {
-      int size_bcast_done;
-      MPI_CALL(Test(&request, &size_bcast_done, MPI_STATUS_IGNORE));
-      if (size_bcast_done)
+      int bcast_done;
+      MPI_CALL(Testall(requests.size(), requests.data(), &bcast_done,
+                       MPI_STATUSES_IGNORE));
+      if (bcast_done)
         break;
       std::this_thread::sleep_for(std::chrono::nanoseconds(250));
     }
-    group.barrier();
+    requests.clear();
   }
 
 } // ::mpicommon
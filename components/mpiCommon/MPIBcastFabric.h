@@ -26,13 +26,20 @@ namespace mpicommon {
   /*! a specific fabric based on MPI. Note that in the case of an
    *  MPIBcastFabric using an intercommunicator the send rank must
    *  be MPI_ROOT and the recv rank must be 0.
+   *
+   *  Each block is broadcast in pipelined chunks of non-blocking
+   *  broadcasts. Small blocks are copied to one of two staging buffers
+   *  and 'send' returns while they are still in flight, such that the
+   *  sender can serialize the next block meanwhile. Large blocks are
+   *  broadcast directly from the given memory.
    */
   class OSPRAY_MPI_INTERFACE MPIBcastFabric : public networking::Fabric
   {
   public:
     MPIBcastFabric(const Group &group, int sendRank, int recvRank);
 
-    virtual ~MPIBcastFabric() override = default;
+    //! waits for the blocks still in flight
+    virtual ~MPIBcastFabric() override;
 
     /*! send exact number of bytes - the fabric can do that through
       multiple smaller messages, but all bytes have to be
@@ -44,12 +51,33 @@ namespace mpicommon {
     virtual size_t read(void *&mem) override;
 
   private:
-    // wait for Bcast with non-blocking test, and barrier
-    void waitForBcast(MPI_Request &);
+    //! blocks up to this size are sent from a staging buffer
+    static constexpr size_t maxStagedSize = 16LL*1024*1024;
+    //! the size of the chunks broadcast of each block
+    static constexpr size_t chunkSize = 8LL*1024*1024;
+    //! the chunks of a block in flight from each rank at once
+    static constexpr size_t pipelineDepth = 4;
+
+    //! post the broadcast of the chunks of a block
+    void bcastChunks(byte_t *mem, size_t size, int root,
+                     std::vector<MPI_Request> &requests);
+
+    // wait for Bcasts with non-blocking test
+    void waitForBcast(std::vector<MPI_Request> &requests);
 
     std::vector<byte_t> buffer;
     Group   group;
     int     sendRank, recvRank;
+
+    //! the double buffered blocks being sent and their requests
+    struct StagedBlock
+    {
+      uint64_t size {0};
+      std::vector<byte_t> data;
+      std::vector<MPI_Request> requests;
+    };
+    StagedBlock staged[2];
+    int currentStage {0};
   };
 
 } // ::mpicommon
@@ -24,6 +24,11 @@ namespace mpicommon {
   OSPRAY_MPI_INTERFACE Group world;
   OSPRAY_MPI_INTERFACE Group app;
   OSPRAY_MPI_INTERFACE Group worker;
+  OSPRAY_MPI_INTERFACE Group node;
+
+  //! the node rank of each global rank (-1 on other nodes), and back
+  static std::vector<int> nodeRanks;
+  static std::vector<int> globalRanks;
 
   // Group definitions ////////////////////////////////////////////////////////
 
@@ -171,4 +176,50 @@ namespace mpicommon {
     }
   }
 
+  bool initNodeGroup()
+  {
+    if (!world.valid() || !world.containsMe)
+      return false;
+
+    if (node.valid())
+      MPI_CALL(Comm_free(&node.comm));
+
+    MPI_Comm nodeComm;
+    MPI_CALL(Comm_split_type(world.comm, MPI_COMM_TYPE_SHARED, world.rank,
+                             MPI_INFO_NULL, &nodeComm));
+    node.setTo(nodeComm);
+
+    // translate the ranks of the node to the world once, the messaging
+    // layer looks them up per message
+    MPI_Group worldGroup, nodeGroup;
+    MPI_CALL(Comm_group(world.comm, &worldGroup));
+    MPI_CALL(Comm_group(node.comm, &nodeGroup));
+    std::vector<int> ranks(node.size);
+    for (int i = 0; i < node.size; ++i)
+      ranks[i] = i;
+    globalRanks.resize(node.size);
+    MPI_CALL(Group_translate_ranks(nodeGroup, node.size, ranks.data(),
+                                   worldGroup, globalRanks.data()));
+    MPI_CALL(Group_free(&nodeGroup));
+    MPI_CALL(Group_free(&worldGroup));
+
+    nodeRanks.assign(world.size, -1);
+    for (int i = 0; i < node.size; ++i)
+      nodeRanks[globalRanks[i]] = i;
+
+    return true;
+  }
+
+  int nodeRankOf(int globalRank)
+  {
+    if (globalRank < 0 || globalRank >= int(nodeRanks.size()))
+      return -1;
+    return nodeRanks[globalRank];
+  }
+
+  int globalRankOf(int nodeRank)
+  {
+    return globalRanks[nodeRank];
+  }
+
 } // ::mpicommon
@@ -178,6 +178,9 @@ namespace mpicommon {
     load balancing, and not part of the worker
     group */
   OSPRAY_MPI_INTERFACE extern Group worker;
+  /*! the ranks of 'world' running on the same (shared memory) node as
+      this process, set by initNodeGroup */
+  OSPRAY_MPI_INTERFACE extern Group node;
 
   // Initialize OSPRay's MPI groups, returns false if MPI
   // was already initialized. useCommWorld indicates if MPI_COMM_WORLD
@@ -192,6 +195,19 @@ namespace mpicommon {
   // messaging calls and MPI_Test(all|any|some) to test for completion
   OSPRAY_MPI_INTERFACE std::unique_lock<std::mutex> acquireMPILock();
 
+  /*! split the (intra-communicator) world group by shared memory node
+      into 'node', via MPI_Comm_split_type(MPI_COMM_TYPE_SHARED); has to
+      be called by all ranks of world. returns false if world is not
+      valid or an inter-communicator */
+  OSPRAY_MPI_INTERFACE bool initNodeGroup();
+
+  /*! the rank in 'node' of the given global rank, -1 if that one runs
+      on another node (or initNodeGroup was not called) */
+  OSPRAY_MPI_INTERFACE int nodeRankOf(int globalRank);
+
+  //! the global rank of the given rank in 'node'
+  OSPRAY_MPI_INTERFACE int globalRankOf(int nodeRank);
+
   inline int globalRank()
   {
     return world.rank;
@@ -0,0 +1,246 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "ospcommon/utility/getEnvVar.h"
+
+#include "Tracing.h"
+
+namespace mpicommon {
+  namespace tracing {
+
+    using namespace ospcommon;
+
+    static utility::Optional<std::string> tracePrefix()
+    {
+      static auto prefix = utility::getEnvVar<std::string>("OSPRAY_MPI_TRACE");
+      return prefix;
+    }
+
+    OSPRAY_MPI_INTERFACE std::atomic<bool> tracingEnabled(
+        tracePrefix().has_value());
+
+    struct Event
+    {
+      const char *name;
+      int64_t begin;
+      int64_t end;
+      int64_t arg;
+      int frame;
+    };
+
+    /*! the events of one thread, only written by its thread and read by
+        the export, such that its lock is practically never contended */
+    struct ThreadBuffer
+    {
+      static constexpr size_t capacity = 1 << 16;
+
+      std::mutex mutex;
+      std::vector<Event> events;
+      //! where the next event goes once 'events' is full (ring buffer)
+      size_t next {0};
+      size_t dropped {0};
+      int threadID {0};
+    };
+
+    static std::mutex registryMutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+    static std::atomic<int> currentFrame(0);
+
+    static ThreadBuffer &localBuffer()
+    {
+      thread_local ThreadBuffer *buffer = nullptr;
+      if (!buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        threadBuffers.emplace_back(new ThreadBuffer);
+        buffer = threadBuffers.back().get();
+        buffer->threadID = threadBuffers.size() - 1;
+        buffer->events.reserve(ThreadBuffer::capacity);
+      }
+      return *buffer;
+    }
+
+    static int64_t toNanoseconds(Clock::time_point t)
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          t.time_since_epoch()).count();
+    }
+
+    void record(const char *name,
+                Clock::time_point begin,
+                Clock::time_point end,
+                int64_t arg)
+    {
+      auto &buffer = localBuffer();
+      const Event event{name, toNanoseconds(begin), toNanoseconds(end),
+                        arg, currentFrame.load(std::memory_order_relaxed)};
+
+      std::lock_guard<std::mutex> lock(buffer.mutex);
+      if (buffer.events.size() < ThreadBuffer::capacity) {
+        buffer.events.push_back(event);
+      } else {
+        buffer.events[buffer.next] = event;
+        buffer.next = (buffer.next + 1) % ThreadBuffer::capacity;
+        buffer.dropped++;
+      }
+    }
+
+    /*! the offset of our clock to the one of rank 0 of 'comm' (Cristian's
+        algorithm, taking the round trip with the least latency) */
+    static int64_t clockOffset(MPI_Comm comm, int rank, int size)
+    {
+      const int roundTrips = 8;
+      int64_t offset = 0;
+
+      if (rank == 0) {
+        for (int r = 1; r < size; ++r) {
+          for (int i = 0; i < roundTrips; ++i) {
+            int64_t now = 0;
+            MPI_CALL(Recv(&now, 1, MPI_INT64_T, r, 0, comm,
+                          MPI_STATUS_IGNORE));
+            now = toNanoseconds(Clock::now());
+            MPI_CALL(Send(&now, 1, MPI_INT64_T, r, 0, comm));
+          }
+        }
+      } else {
+        int64_t bestRoundTrip = std::numeric_limits<int64_t>::max();
+        for (int i = 0; i < roundTrips; ++i) {
+          int64_t t0 = toNanoseconds(Clock::now());
+          int64_t remote = 0;
+          MPI_CALL(Send(&t0, 1, MPI_INT64_T, 0, 0, comm));
+          MPI_CALL(Recv(&remote, 1, MPI_INT64_T, 0, 0, comm,
+                        MPI_STATUS_IGNORE));
+          const int64_t t1 = toNanoseconds(Clock::now());
+          if (t1 - t0 < bestRoundTrip) {
+            bestRoundTrip = t1 - t0;
+            offset = remote - (t0 + t1) / 2;
+          }
+        }
+      }
+
+      return offset;
+    }
+
+    /*! the events recorded since the last export as Chrome trace events,
+        and clear them */
+    static std::string takeEvents(int rank, int64_t offset)
+    {
+      std::ostringstream json;
+      json << std::fixed << std::setprecision(3);
+      std::lock_guard<std::mutex> registryLock(registryMutex);
+      for (auto &buffer : threadBuffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        if (buffer->dropped) {
+          json << "{\"name\":\"dropped events\",\"ph\":\"i\",\"s\":\"t\","
+               << "\"pid\":" << rank << ",\"tid\":" << buffer->threadID
+               << ",\"ts\":0,\"args\":{\"count\":" << buffer->dropped
+               << "}},\n";
+        }
+        for (const auto &e : buffer->events) {
+          // Chrome traces are in microseconds
+          json << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":"
+               << rank << ",\"tid\":" << buffer->threadID << ",\"ts\":"
+               << (e.begin + offset) / 1000.0 << ",\"dur\":"
+               << (e.end - e.begin) / 1000.0 << ",\"args\":{\"frame\":"
+               << e.frame;
+          if (e.arg >= 0)
+            json << ",\"id\":" << e.arg;
+          json << "}},\n";
+        }
+        buffer->events.clear();
+        buffer->next = 0;
+        buffer->dropped = 0;
+      }
+      return json.str();
+    }
+
+    static void writeTrace(int firstFrame, int lastFrame)
+    {
+      // a communicator of our own, to not interfere with other traffic
+      static MPI_Comm comm = MPI_COMM_NULL;
+      if (comm == MPI_COMM_NULL)
+        MPI_CALL(Comm_dup(world.comm, &comm));
+
+      int rank = 0;
+      int size = 0;
+      MPI_CALL(Comm_rank(comm, &rank));
+      MPI_CALL(Comm_size(comm, &size));
+
+      const int64_t offset = clockOffset(comm, rank, size);
+      std::string events = takeEvents(rank, offset);
+      int bytes = events.size();
+
+      std::vector<int> allBytes(rank == 0 ? size : 0);
+      MPI_CALL(Gather(&bytes, 1, MPI_INT, allBytes.data(), 1, MPI_INT,
+                      0, comm));
+
+      std::vector<int> displacements;
+      std::string allEvents;
+      if (rank == 0) {
+        displacements.resize(size, 0);
+        for (int r = 1; r < size; ++r)
+          displacements[r] = displacements[r - 1] + allBytes[r - 1];
+        allEvents.resize(displacements.back() + allBytes.back());
+      }
+
+      MPI_CALL(Gatherv(&events[0], bytes, MPI_CHAR, &allEvents[0],
+                       allBytes.data(), displacements.data(), MPI_CHAR,
+                       0, comm));
+
+      if (rank != 0)
+        return;
+
+      std::ostringstream fileName;
+      fileName << tracePrefix().value() << "-" << firstFrame << "-"
+               << lastFrame << ".json";
+      std::ofstream file(fileName.str());
+      if (!file) {
+        std::cerr << "#osp:mpi: could not write the trace "
+                  << fileName.str() << std::endl;
+        return;
+      }
+
+      // strip the separator of the last event
+      if (!allEvents.empty())
+        allEvents.resize(allEvents.size() - 2);
+      file << "{\"traceEvents\":[\n" << allEvents << "\n]}\n";
+    }
+
+    void endFrame()
+    {
+      if (!enabled())
+        return;
+
+      static const int framesPerTrace =
+          std::max(1, utility::getEnvVar<int>("OSPRAY_MPI_TRACE_FRAMES")
+                          .value_or(10));
+
+      const int frame = currentFrame++;
+      if ((frame + 1) % framesPerTrace == 0)
+        writeTrace(frame + 1 - framesPerTrace, frame);
+    }
+
+  } // ::mpicommon::tracing
+} // ::mpicommon
@@ -0,0 +1,85 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "MPICommon.h"
+
+/*! \file Tracing.h a low overhead tracer of the events of all ranks (e.g.,
+    rendering, sending and compositing tiles), exported as Chrome trace
+    files (viewable with chrome://tracing or Perfetto).
+
+    It is enabled by setting OSPRAY_MPI_TRACE to the prefix of the trace
+    files. Each thread records into its own ring buffer, every
+    OSPRAY_MPI_TRACE_FRAMES (default 10) frames the events of all ranks
+    are gathered on the world's rank 0, with their clocks synchronized to
+    the one of rank 0, and written to one file for these frames */
+
+namespace mpicommon {
+  namespace tracing {
+
+    using Clock = std::chrono::steady_clock;
+
+    OSPRAY_MPI_INTERFACE extern std::atomic<bool> tracingEnabled;
+
+    inline bool enabled()
+    {
+      return tracingEnabled.load(std::memory_order_relaxed);
+    }
+
+    /*! record an event of this thread; 'name' has to be a string literal
+        (it is only stored as pointer), 'arg' is e.g. a tile or rank ID */
+    OSPRAY_MPI_INTERFACE void record(const char *name,
+                                     Clock::time_point begin,
+                                     Clock::time_point end,
+                                     int64_t arg = -1);
+
+    /*! called collectively by all ranks of the world at the end of each
+        frame, writes the trace of the last frames when due. No other MPI
+        communication on the world may be in flight */
+    OSPRAY_MPI_INTERFACE void endFrame();
+
+    /*! records the event of its lifetime */
+    struct Scope
+    {
+      Scope(const char *name, int64_t arg = -1)
+        : name(name), arg(arg)
+      {
+        if (enabled())
+          begin = Clock::now();
+      }
+
+      ~Scope()
+      {
+        if (enabled() && begin != Clock::time_point())
+          record(name, begin, Clock::now(), arg);
+      }
+
+      Scope(const Scope &) = delete;
+      Scope &operator=(const Scope &) = delete;
+
+    private:
+      const char *name;
+      int64_t arg;
+      Clock::time_point begin;
+    };
+
+  } // ::mpicommon::tracing
+} // ::mpicommon
@@ -16,13 +16,17 @@
 
 #include "Context.h"
 #include <snappy.h>
+#include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <cstring>
 
 #include "ospcommon/memory/malloc.h"
 #include "ospcommon/tasking/async.h"
+#include "ospcommon/tasking/parallel_for.h"
 #include "ospcommon/tasking/tasking_system_handle.h"
 #include "ospcommon/utility/getEnvVar.h"
+#include "mpiCommon/Tracing.h"
 
 using ospcommon::AsyncLoop;
 using ospcommon::make_unique;
@@ -34,14 +38,123 @@ using namespace std::chrono;
 
 namespace maml {
 
+  /*! the tag of coalesced messages, not to be used by handlers */
+  static constexpr int bundleTag = 32767;
+
+  /*! the header of each message in a bundle, the bundle starts with the
+      number of messages */
+  struct BundleEntry
+  {
+    int tag;
+    uint32_t size;
+  };
+
+  // BufferPool definitions ///////////////////////////////////////////////////
+
+  constexpr size_t BufferPool::maxPooled;
+
+  BufferPool::~BufferPool()
+  {
+    for (auto &sizeClass : freeBuffers) {
+      for (auto *buffer : sizeClass.second)
+        free(buffer);
+    }
+  }
+
+  byte_t *BufferPool::acquire(size_t size, size_t &capacity)
+  {
+    capacity = 64;
+    while (capacity < size)
+      capacity *= 2;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto &buffers = freeBuffers[capacity];
+      if (!buffers.empty()) {
+        byte_t *buffer = buffers.back();
+        buffers.pop_back();
+        return buffer;
+      }
+    }
+    // the messages use malloc/free
+    return (byte_t*)malloc(capacity);
+  }
+
+  void BufferPool::release(byte_t *buffer, size_t capacity)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto &buffers = freeBuffers[capacity];
+      if (buffers.size() < maxPooled) {
+        buffers.push_back(buffer);
+        return;
+      }
+    }
+    free(buffer);
+  }
+
+  /*! a message whose buffer returns to the pool. If the buffer got
+      replaced (e.g. by compression) the message frees the new one */
+  struct PooledMessage : public Message
+  {
+    PooledMessage(std::shared_ptr<BufferPool> _pool, size_t size)
+      : pool(std::move(_pool))
+    {
+      data = pooled = pool->acquire(size, capacity);
+      this->size = size;
+    }
+
+    ~PooledMessage() override
+    {
+      if (data == pooled) {
+        pool->release(pooled, capacity);
+        data = nullptr;
+      }
+    }
+
+    std::shared_ptr<BufferPool> pool;
+    byte_t *pooled {nullptr};
+    size_t capacity {0};
+  };
+
+  // Context definitions //////////////////////////////////////////////////////
+
   /*! the singleton object that handles all the communication */
   std::unique_ptr<Context> Context::singleton;
 
   Context::Context(bool enableCompression)
-    : compressMessages(enableCompression)
+    : compressMessages(enableCompression),
+      bufferPool(std::make_shared<BufferPool>())
   {
     auto logging = getEnvVar<std::string>("OSPRAY_DP_API_TRACING").value_or("0");
     DETAILED_LOGGING = std::stoi(logging) != 0;
+
+    coalesceBytes = getEnvVar<int>("MAML_COALESCE_BYTES").value_or(0);
+    coalesceLatency = std::chrono::microseconds(
+        getEnvVar<int>("MAML_COALESCE_LATENCY_US").value_or(100));
+
+    splitProgress = getEnvVar<int>("MAML_PROGRESS_THREADS").value_or(1) > 1;
+    if (splitProgress && !mpicommon::mpiIsThreaded) {
+      std::cerr << "#maml: MAML_PROGRESS_THREADS needs MPI_THREAD_MULTIPLE, "
+                << "using a single progress thread" << std::endl;
+      splitProgress = false;
+    }
+    dispatchTasks = getEnvVar<int>("MAML_DISPATCH_TASKS").value_or(0) != 0;
+
+    // collective over the world, all ranks have to agree on the variable
+    auto &world = mpicommon::world;
+    if (getEnvVar<int>("MAML_SHARED_MEMORY").value_or(1) && world.size > 1
+        && mpicommon::initNodeGroup() && mpicommon::node.size > 1) {
+      const size_t ringBytes =
+          getEnvVar<int>("MAML_SHARED_MEMORY_BYTES").value_or(4 << 20);
+      sharedMemory = make_unique<SharedMemoryTransport>(ringBytes,
+          [&](size_t size) { return makePooledMessage(size); });
+    }
+  }
+
+  std::shared_ptr<Message> Context::makePooledMessage(size_t size)
+  {
+    return std::make_shared<PooledMessage>(bufferPool, size);
   }
 
   Context::~Context()
@@ -72,7 +185,8 @@ namespace maml {
   void Context::send(std::shared_ptr<Message> msg)
   {
     // The message uses malloc/free, so use that instead of new/delete
-    if (compressMessages) {
+    if (compressMessages && !isNodeLocal(*msg)) {
+      mpicommon::tracing::Scope trace("compress message", msg->size);
       auto startCompr = high_resolution_clock::now();
       byte_t *compressed = (byte_t*)malloc(snappy::MaxCompressedLength(msg->size));
       size_t compressedSize = 0;
@@ -91,41 +205,82 @@ namespace maml {
       msg->size = compressedSize;
     }
 
-    outbox.push_back(std::move(msg));
+    outbox.push(std::move(msg));
   }
 
   void Context::processInboxMessages()
   {
     auto incomingMessages = inbox.consume();
+    if (incomingMessages.empty())
+      return;
 
-    for (auto &msg : incomingMessages) {
-      auto *handler = handlers[msg->comm];
-
-      if (compressMessages) {
-        auto startCompr = high_resolution_clock::now();
-        // Decompress the message before handing it off
-        size_t uncompressedSize = 0;
-        snappy::GetUncompressedLength(reinterpret_cast<const char*>(msg->data),
-            msg->size, &uncompressedSize);
-        byte_t *uncompressed = (byte_t*)malloc(uncompressedSize);
-        snappy::RawUncompress(reinterpret_cast<const char*>(msg->data),
-            msg->size, reinterpret_cast<char*>(uncompressed));
-        free(msg->data);
-        const size_t compressedSize = msg->size;
-
-        auto endCompr = high_resolution_clock::now();
-        if (DETAILED_LOGGING) {
-          std::lock_guard<std::mutex> lock(statsMutex);
-          decompressTimes.push_back(duration_cast<RealMilliseconds>(endCompr - startCompr));
-          compressedSizes.emplace_back(100.0 * (static_cast<double>(compressedSize) / uncompressedSize));
-        }
-
-        msg->data = uncompressed;
-        msg->size = uncompressedSize;
+    // the messages of each communicator, in the order received
+    std::map<MPI_Comm, std::vector<std::shared_ptr<Message>>> queues;
+    for (auto &msg : incomingMessages)
+      queues[msg->comm].push_back(std::move(msg));
+
+    std::vector<std::pair<MessageHandler *,
+                          std::vector<std::shared_ptr<Message>> *>> work;
+    for (auto &queue : queues)
+      work.emplace_back(handlers[queue.first], &queue.second);
+
+    auto handleQueue = [&](size_t i) {
+      for (auto &msg : *work[i].second) {
+        if (compressMessages && !isNodeLocal(*msg))
+          decompress(*msg);
+        work[i].first->incoming(msg);
       }
+    };
+
+    // waits for all queues, such that the next messages of a
+    // communicator are not handled before the previous ones
+    if (dispatchTasks && work.size() > 1)
+      ospcommon::tasking::parallel_for(work.size(), handleQueue);
+    else {
+      for (size_t i = 0; i < work.size(); ++i)
+        handleQueue(i);
+    }
+  }
 
-      handler->incoming(msg);
+  void Context::decompress(Message &msg)
+  {
+    mpicommon::tracing::Scope trace("decompress message", msg.size);
+    auto startCompr = high_resolution_clock::now();
+    // Decompress the message before handing it off
+    size_t uncompressedSize = 0;
+    snappy::GetUncompressedLength(reinterpret_cast<const char*>(msg.data),
+        msg.size, &uncompressedSize);
+    byte_t *uncompressed = (byte_t*)malloc(uncompressedSize);
+    snappy::RawUncompress(reinterpret_cast<const char*>(msg.data),
+        msg.size, reinterpret_cast<char*>(uncompressed));
+    const size_t compressedSize = msg.size;
+
+    auto endCompr = high_resolution_clock::now();
+    if (DETAILED_LOGGING) {
+      std::lock_guard<std::mutex> lock(statsMutex);
+      decompressTimes.push_back(duration_cast<RealMilliseconds>(endCompr - startCompr));
+      compressedSizes.emplace_back(100.0 * (static_cast<double>(compressedSize) / uncompressedSize));
     }
+
+    free(msg.data);
+    msg.data = uncompressed;
+    msg.size = uncompressedSize;
+  }
+
+  bool Context::isNodeLocal(const Message &msg) const
+  {
+    return sharedMemory && sharedMemory->reaches(msg.comm, msg.rank);
+  }
+
+  void Context::receiveSharedMemoryMessages()
+  {
+    if (!sharedMemory)
+      return;
+
+    std::vector<std::shared_ptr<Message>> received;
+    sharedMemory->receive(received);
+    for (auto &msg : received)
+      inbox.push(std::move(msg));
   }
 
   void Context::sendMessagesFromOutbox()
@@ -134,21 +289,110 @@ namespace maml {
 
     auto mpilock = mpicommon::acquireMPILock();
     for (auto &msg : outgoingMessages) {
-      MPI_Request request;
-
       int rank = 0;
       MPI_CALL(Comm_rank(msg->comm, &rank));
       // Don't send to ourself, just forward to the inbox directly
       if (rank == msg->rank) {
-        inbox.push_back(std::move(msg));
+        inbox.push(std::move(msg));
+        continue;
+      }
+
+      // the ranks of this node need neither MPI nor coalescing
+      if (isNodeLocal(*msg)) {
+        sharedMemory->send(std::move(msg));
+        continue;
+      }
+
+      if (msg->size >= coalesceBytes) {
+        // keep the order of the messages to this destination
+        auto bundle = bundles.find(std::make_pair(msg->comm, msg->rank));
+        if (bundle != bundles.end() && !bundle->second.messages.empty()) {
+          bundle->second.started = high_resolution_clock::time_point();
+          flushBundles(false);
+        }
+        isend(std::move(msg));
       } else {
-        MPI_CALL(Isend(msg->data, msg->size, MPI_BYTE, msg->rank,
-              msg->tag, msg->comm, &request));
-        msg->started = high_resolution_clock::now();
+        auto &bundle = bundles[std::make_pair(msg->comm, msg->rank)];
+        if (bundle.messages.empty())
+          bundle.started = high_resolution_clock::now();
+        bundle.bytes += sizeof(BundleEntry) + msg->size;
+        bundle.messages.push_back(std::move(msg));
+      }
+    }
+
+    if (sharedMemory)
+      sharedMemory->progressSends();
+
+    flushBundles(false);
+  }
+
+  void Context::isend(std::shared_ptr<Message> msg)
+  {
+    MPI_Request request;
+    MPI_CALL(Isend(msg->data, msg->size, MPI_BYTE, msg->rank,
+          msg->tag, msg->comm, &request));
+    msg->started = high_resolution_clock::now();
+
+    pendingSends.push_back(request);
+    sendCache.push_back(std::move(msg));
+  }
+
+  void Context::flushBundles(bool all)
+  {
+    const auto now = high_resolution_clock::now();
+    for (auto &it : bundles) {
+      Bundle &bundle = it.second;
+      if (bundle.messages.empty()
+          || (!all && bundle.bytes < coalesceBytes
+            && now - bundle.started < coalesceLatency)) {
+        continue;
+      }
 
-        pendingSends.push_back(request);
-        sendCache.push_back(std::move(msg));
+      if (bundle.messages.size() == 1) {
+        isend(std::move(bundle.messages.front()));
+      } else {
+        auto packed = makePooledMessage(sizeof(uint32_t) + bundle.bytes);
+        packed->comm = it.first.first;
+        packed->rank = it.first.second;
+        packed->tag = bundleTag;
+
+        byte_t *out = packed->data;
+        const uint32_t count = bundle.messages.size();
+        std::memcpy(out, &count, sizeof(count));
+        out += sizeof(count);
+        for (const auto &msg : bundle.messages) {
+          const BundleEntry entry {msg->tag, uint32_t(msg->size)};
+          std::memcpy(out, &entry, sizeof(entry));
+          out += sizeof(entry);
+          std::memcpy(out, msg->data, msg->size);
+          out += msg->size;
+        }
+        isend(std::move(packed));
       }
+
+      bundle.messages.clear();
+      bundle.bytes = 0;
+    }
+  }
+
+  void Context::unpackBundle(const Message &bundle)
+  {
+    const byte_t *in = bundle.data;
+    uint32_t count = 0;
+    std::memcpy(&count, in, sizeof(count));
+    in += sizeof(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      BundleEntry entry;
+      std::memcpy(&entry, in, sizeof(entry));
+      in += sizeof(entry);
+
+      auto msg = makePooledMessage(entry.size);
+      std::memcpy(msg->data, in, entry.size);
+      in += entry.size;
+      msg->comm = bundle.comm;
+      msg->rank = bundle.rank;
+      msg->tag = entry.tag;
+      inbox.push(std::move(msg));
     }
   }
 
@@ -168,7 +412,7 @@ namespace maml {
         int size;
         MPI_CALL(Get_count(&status, MPI_BYTE, &size));
 
-        auto msg = std::make_shared<Message>(size);
+        auto msg = makePooledMessage(size);
         msg->rank = status.MPI_SOURCE;
         msg->tag  = status.MPI_TAG;
         msg->comm = comm;
@@ -187,80 +431,83 @@ namespace maml {
 
   void Context::waitOnSomeRequests()
   {
-    if (!pendingSends.empty() || !pendingRecvs.empty()) {
+    testRequests(pendingSends, sendCache, false);
+    testRequests(pendingRecvs, recvCache, true);
+  }
 
-      const size_t totalMessages = pendingSends.size() + pendingRecvs.size();
-      int *done = STACK_BUFFER(int, totalMessages);
-      MPI_Request *mergedRequests = STACK_BUFFER(MPI_Request, totalMessages);
+  void Context::testRequests(std::vector<MPI_Request> &requests,
+                             std::vector<std::shared_ptr<Message>> &cache,
+                             bool receives)
+  {
+    if (requests.empty())
+      return;
 
-      for (size_t i = 0; i < totalMessages; ++i) {
-        if (i < pendingSends.size()) {
-          mergedRequests[i] = pendingSends[i];
-        } else {
-          mergedRequests[i] = pendingRecvs[i - pendingSends.size()];
-        }
-      }
+    int *done = STACK_BUFFER(int, requests.size());
 
-      int numDone = 0;
-      {
-        auto mpilock = mpicommon::acquireMPILock();
-        MPI_CALL(Testsome(totalMessages, mergedRequests, &numDone,
-              done, MPI_STATUSES_IGNORE));
+    int numDone = 0;
+    {
+      auto mpilock = mpicommon::acquireMPILock();
+      MPI_CALL(Testsome(requests.size(), requests.data(), &numDone,
+            done, MPI_STATUSES_IGNORE));
+    }
+    auto completed = high_resolution_clock::now();
+
+    for (int i = 0; i < numDone; ++i) {
+      const size_t msgId = done[i];
+      if (mpicommon::tracing::enabled()) {
+        // the message started on the other clock, so shift it to ours
+        using TraceClock = mpicommon::tracing::Clock;
+        const auto now = TraceClock::now();
+        const auto took = duration_cast<TraceClock::duration>(
+            completed - cache[msgId]->started);
+        mpicommon::tracing::record(receives ? "receive message" : "send message",
+                                   now - took, now, cache[msgId]->rank);
       }
-      auto completed = high_resolution_clock::now();
-
-      for (int i = 0; i < numDone; ++i) {
-        size_t msgId = done[i];
-        if (msgId < pendingSends.size()) {
-          if (DETAILED_LOGGING) {
-            std::lock_guard<std::mutex> lock(statsMutex);
-            Message *msg = sendCache[msgId].get();
-            sendTimes.push_back(duration_cast<RealMilliseconds>(completed - msg->started));
-          }
-
-          pendingSends[msgId] = MPI_REQUEST_NULL;
-          sendCache[msgId] = nullptr;
-        } else {
-          msgId -= pendingSends.size();
-
-          if (DETAILED_LOGGING) {
-            std::lock_guard<std::mutex> lock(statsMutex);
-            Message *msg = recvCache[msgId].get();
-            recvTimes.push_back(duration_cast<RealMilliseconds>(completed - msg->started));
-          }
-
-          inbox.push_back(std::move(recvCache[msgId]));
-
-          pendingRecvs[msgId] = MPI_REQUEST_NULL;
-          recvCache[msgId] = nullptr;
-        }
+      if (DETAILED_LOGGING) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        Message *msg = cache[msgId].get();
+        auto &times = receives ? recvTimes : sendTimes;
+        times.push_back(duration_cast<RealMilliseconds>(completed - msg->started));
       }
 
-      // Clean up anything we sent
-      sendCache.erase(std::remove(sendCache.begin(),
-                                  sendCache.end(),
-                                  nullptr), sendCache.end());
+      if (receives) {
+        if (cache[msgId]->tag == bundleTag)
+          unpackBundle(*cache[msgId]);
+        else
+          inbox.push(std::move(cache[msgId]));
+      }
 
-      pendingSends.erase(std::remove(pendingSends.begin(),
-                                     pendingSends.end(),
-                                     MPI_REQUEST_NULL), pendingSends.end());
+      requests[msgId] = MPI_REQUEST_NULL;
+      cache[msgId] = nullptr;
+    }
 
-      // Clean up anything we received
-      recvCache.erase(std::remove(recvCache.begin(),
-                                  recvCache.end(),
-                                  nullptr), recvCache.end());
+    // Clean up anything completed
+    cache.erase(std::remove(cache.begin(), cache.end(), nullptr), cache.end());
 
-      pendingRecvs.erase(std::remove(pendingRecvs.begin(),
-                                     pendingRecvs.end(),
-                                     MPI_REQUEST_NULL), pendingRecvs.end());
-    }
+    requests.erase(std::remove(requests.begin(),
+                               requests.end(),
+                               MPI_REQUEST_NULL), requests.end());
   }
 
   void Context::flushRemainingMessages()
   {
-    while (!pendingRecvs.empty() || !pendingSends.empty() || !inbox.empty() || !outbox.empty()) {
+    auto hasBundles = [&]() {
+      return std::any_of(bundles.begin(), bundles.end(), [](const std::pair<const std::pair<MPI_Comm, int>, Bundle> &b) {
+        return !b.second.messages.empty();
+      });
+    };
+    auto hasSharedMemorySends = [&]() {
+      return sharedMemory && sharedMemory->hasPendingSends();
+    };
+    while (!pendingRecvs.empty() || !pendingSends.empty() || !inbox.empty()
+        || !outbox.empty() || hasBundles() || hasSharedMemorySends()) {
       sendMessagesFromOutbox();
+      {
+        auto mpilock = mpicommon::acquireMPILock();
+        flushBundles(true);
+      }
       pollForAndRecieveMessages();
+      receiveSharedMemoryMessages();
       waitOnSomeRequests();
       processInboxMessages();
     }
@@ -284,10 +531,27 @@ namespace maml {
             AsyncLoop::LaunchMethod::THREAD : AsyncLoop::LaunchMethod::TASK;
       }
 
-      if (!sendReceiveThread.get()) {
+      if (splitProgress) {
+        if (!sendReceiveThread.get()) {
+          sendReceiveThread = make_unique<AsyncLoop>([&](){
+            sendMessagesFromOutbox();
+            testRequests(pendingSends, sendCache, false);
+          }, AsyncLoop::LaunchMethod::THREAD);
+        }
+
+        if (!receiveThread.get()) {
+          receiveThread = make_unique<AsyncLoop>([&](){
+            pollForAndRecieveMessages();
+            receiveSharedMemoryMessages();
+            testRequests(pendingRecvs, recvCache, true);
+          }, AsyncLoop::LaunchMethod::THREAD);
+        }
+        receiveThread->start();
+      } else if (!sendReceiveThread.get()) {
         sendReceiveThread = make_unique<AsyncLoop>([&](){
           sendMessagesFromOutbox();
           pollForAndRecieveMessages();
+          receiveSharedMemoryMessages();
           waitOnSomeRequests();
         }, launchMethod);
       }
@@ -323,6 +587,9 @@ namespace maml {
       if (sendReceiveThread) {
         sendReceiveThread->stop();
       }
+      if (receiveThread) {
+        receiveThread->stop();
+      }
       if (processInboxThread) {
         processInboxThread->stop();
       }
@@ -17,9 +17,10 @@
 #pragma once
 
 #include "maml.h"
+#include "SharedMemory.h"
 //ospcommon
 #include "ospcommon/AsyncLoop.h"
-#include "ospcommon/containers/TransactionalBuffer.h"
+#include "ospcommon/containers/MPSCQueue.h"
 //stl
 #include <future>
 #include <map>
@@ -28,6 +29,26 @@
 
 namespace maml {
 
+  /*! recycles message buffers in power of two size classes, such that
+      the steady state of sending and receiving needs no allocations */
+  class BufferPool
+  {
+  public:
+    ~BufferPool();
+
+    /*! a buffer of at least 'size' bytes, of the size class 'capacity' */
+    ospcommon::byte_t *acquire(size_t size, size_t &capacity);
+
+    void release(ospcommon::byte_t *buffer, size_t capacity);
+
+  private:
+    //! buffers kept at most per size class
+    static constexpr size_t maxPooled = 64;
+
+    std::mutex mutex;
+    std::map<size_t, std::vector<ospcommon::byte_t *>> freeBuffers;
+  };
+
   /*! the singleton object that handles all the communication */
   struct OSPRAY_MAML_INTERFACE Context
   {
@@ -73,6 +94,16 @@ namespace maml {
 
     void processInboxMessages();
 
+    //! decompress a received message in place
+    void decompress(Message &msg);
+
+    /*! whether 'msg' is sent to (or was received from) a rank of this
+        node, whose messages go uncompressed through shared memory */
+    bool isNodeLocal(const Message &msg) const;
+
+    //! put the messages received through shared memory into the inbox
+    void receiveSharedMemoryMessages();
+
     /*! the thread (function) that executes all MPI commands to
         send/receive messages via MPI.
 
@@ -92,13 +123,33 @@ namespace maml {
     void pollForAndRecieveMessages();
     void waitOnSomeRequests();
 
+    /*! test the 'requests' of the messages in 'cache' for completion,
+        putting the completed receives into the inbox */
+    void testRequests(std::vector<MPI_Request> &requests,
+                      std::vector<std::shared_ptr<Message>> &cache,
+                      bool receives);
+
+    //! post the MPI send of 'msg', the MPI lock has to be held
+    void isend(std::shared_ptr<Message> msg);
+
+    /*! send the coalesced messages which are large or old enough (or all
+        with 'all'), the MPI lock has to be held */
+    void flushBundles(bool all);
+
+    /*! a message taking its buffer from 'bufferPool' */
+    std::shared_ptr<Message> makePooledMessage(size_t size);
+
+    //! split a received bundle to the inbox
+    void unpackBundle(const Message &bundle);
+
     void flushRemainingMessages();
 
     // Data members //
 
 
-    ospcommon::TransactionalBuffer<std::shared_ptr<Message>> inbox;
-    ospcommon::TransactionalBuffer<std::shared_ptr<Message>> outbox;
+    // lock-free: any thread may push, only the send/process loops consume
+    ospcommon::MPSCQueue<std::shared_ptr<Message>> inbox;
+    ospcommon::MPSCQueue<std::shared_ptr<Message>> outbox;
 
     // NOTE(jda) - sendCache/pendingSends MUST correspond with each other by
     //             their index in their respective vectors...
@@ -112,15 +163,45 @@ namespace maml {
 
     std::map<MPI_Comm, MessageHandler *> handlers;
 
+    /*! small messages to the same comm:rank are coalesced into one MPI
+        message (with tag 'bundleTag'), sent once it reaches
+        'coalesceBytes' or its first message waited 'coalesceLatency' */
+    struct Bundle
+    {
+      std::vector<std::shared_ptr<Message>> messages;
+      size_t bytes {0};
+      std::chrono::high_resolution_clock::time_point started;
+    };
+    std::map<std::pair<MPI_Comm, int>, Bundle> bundles;
+    //! 0 disables coalescing
+    size_t coalesceBytes {0};
+    std::chrono::microseconds coalesceLatency {100};
+
+    std::shared_ptr<BufferPool> bufferPool;
+
+    /*! the messages between the ranks of the same node, unless disabled
+        with MAML_SHARED_MEMORY=0 */
+    std::unique_ptr<SharedMemoryTransport> sharedMemory;
+
     bool useTaskingSystem {true};
     bool compressMessages {false};
 
+    /*! send and receive from separate threads, which needs a MPI
+        library with MPI_THREAD_MULTIPLE */
+    bool splitProgress {false};
+    /*! handle the messages of different communicators concurrently in
+        the tasking system, messages of the same one are still handled
+        in order */
+    bool dispatchTasks {false};
+
     // NOTE(jda) - these are only used when _not_ using the tasking system...
     std::mutex tasksMutex;
     bool tasksAreRunning {false};
     //std::thread sendReceiveThread, processInboxThread;
     std::atomic<bool> quitThreads{false};
     std::unique_ptr<ospcommon::AsyncLoop> sendReceiveThread;
+    //! only used with 'splitProgress', then 'sendReceiveThread' only sends
+    std::unique_ptr<ospcommon::AsyncLoop> receiveThread;
     std::unique_ptr<ospcommon::AsyncLoop> processInboxThread;
 
     std::mutex statsMutex;
@@ -0,0 +1,237 @@
+// ======================================================================== //
+// Copyright 2016-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "SharedMemory.h"
+// std
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using ospcommon::byte_t;
+
+namespace maml {
+
+  /*! a ring buffer in the shared memory window, followed by its data */
+  struct SharedMemoryTransport::Ring
+  {
+    //! bytes written so far, only advanced by the sender
+    alignas(64) std::atomic<uint64_t> head {0};
+    //! bytes read so far, only advanced by the receiver
+    alignas(64) std::atomic<uint64_t> tail {0};
+
+    byte_t *data()
+    {
+      return reinterpret_cast<byte_t*>(this + 1);
+    }
+  };
+
+  /*! the header of each fragment of a message in a ring, fragments
+      never wrap around the end of the ring */
+  struct Fragment
+  {
+    uint64_t messageSize;
+    int32_t tag;
+    //! bytes of the message in this fragment, or 'wrapMarker'
+    uint32_t size;
+  };
+
+  //! the rest of the ring up to its end is unused, continue at its start
+  static constexpr uint32_t wrapMarker = 0xffffffff;
+  //! fragments start at multiples of this
+  static constexpr size_t fragmentAlign = sizeof(Fragment);
+
+  static inline size_t alignFragment(size_t size)
+  {
+    return (size + fragmentAlign - 1) / fragmentAlign * fragmentAlign;
+  }
+
+  // SharedMemoryTransport definitions ////////////////////////////////////////
+
+  SharedMemoryTransport::SharedMemoryTransport(size_t ringBytes,
+                                               MessageFactory makeMessage)
+    : comm(mpicommon::world.comm),
+      makeMessage(std::move(makeMessage))
+  {
+    // at least a few fragments, with 32 bit fragment sizes
+    capacity = std::min(std::max(ringBytes, size_t(4096)), size_t(1) << 30);
+    capacity = (capacity + 63) / 64 * 64;
+    ringStride = sizeof(Ring) + capacity;
+
+    const auto &node = mpicommon::node;
+    void *base = nullptr;
+    MPI_CALL(Win_allocate_shared(node.size * ringStride, 1, MPI_INFO_NULL,
+                                 node.comm, &base, &window));
+
+    inbound.resize(node.size);
+    for (int i = 0; i < node.size; ++i)
+      inbound[i] = new (ring(base, i)) Ring;
+
+    // one passive target epoch for the direct loads and stores into the
+    // window, the rings synchronize themselves with their atomics
+    MPI_CALL(Win_lock_all(MPI_MODE_NOCHECK, window));
+    MPI_CALL(Barrier(node.comm));
+
+    outbound.resize(node.size);
+    for (int i = 0; i < node.size; ++i) {
+      MPI_Aint size = 0;
+      int dispUnit = 0;
+      void *peerBase = nullptr;
+      MPI_CALL(Win_shared_query(window, i, &size, &dispUnit, &peerBase));
+      outbound[i] = ring(peerBase, node.rank);
+    }
+
+    pending.resize(node.size);
+    pendingWritten.assign(node.size, 0);
+    partial.resize(node.size);
+    partialReceived.assign(node.size, 0);
+  }
+
+  SharedMemoryTransport::~SharedMemoryTransport()
+  {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (!finalized && window != MPI_WIN_NULL) {
+      MPI_Win_unlock_all(window);
+      MPI_Win_free(&window);
+    }
+  }
+
+  SharedMemoryTransport::Ring *SharedMemoryTransport::ring(void *base,
+                                                           int index) const
+  {
+    return reinterpret_cast<Ring*>(static_cast<byte_t*>(base)
+                                   + index * ringStride);
+  }
+
+  bool SharedMemoryTransport::reaches(MPI_Comm comm, int rank) const
+  {
+    return comm == this->comm && mpicommon::nodeRankOf(rank) >= 0;
+  }
+
+  void SharedMemoryTransport::send(std::shared_ptr<Message> msg)
+  {
+    const int dest = mpicommon::nodeRankOf(msg->rank);
+    msg->started = std::chrono::high_resolution_clock::now();
+    pending[dest].push_back(std::move(msg));
+    numPending++;
+  }
+
+  bool SharedMemoryTransport::hasPendingSends() const
+  {
+    return numPending > 0;
+  }
+
+  void SharedMemoryTransport::progressSends()
+  {
+    if (numPending == 0)
+      return;
+
+    for (size_t dest = 0; dest < pending.size(); ++dest) {
+      auto &queue = pending[dest];
+      while (!queue.empty()
+             && writeMessage(*outbound[dest], *queue.front(),
+                             pendingWritten[dest])) {
+        queue.pop_front();
+        pendingWritten[dest] = 0;
+        numPending--;
+      }
+    }
+  }
+
+  bool SharedMemoryTransport::writeMessage(Ring &ring,
+                                           const Message &msg,
+                                           size_t &written)
+  {
+    byte_t *data = ring.data();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const uint64_t tail = ring.tail.load(std::memory_order_acquire);
+
+    bool complete = false;
+    while (!complete) {
+      const size_t available = capacity - (head - tail);
+      const size_t pos = head % capacity;
+      const size_t toEnd = capacity - pos;
+
+      // too little left at the end for any data, skip to the start
+      if (toEnd < 2 * sizeof(Fragment)) {
+        if (available < toEnd)
+          break;
+        reinterpret_cast<Fragment*>(data + pos)->size = wrapMarker;
+        head += toEnd;
+        continue;
+      }
+
+      const size_t room = std::min(available, toEnd);
+      if (room < 2 * sizeof(Fragment))
+        break;
+
+      const size_t n = std::min(msg.size - written, room - sizeof(Fragment));
+      const Fragment fragment {msg.size, msg.tag, uint32_t(n)};
+      std::memcpy(data + pos, &fragment, sizeof(fragment));
+      std::memcpy(data + pos + sizeof(fragment), msg.data + written, n);
+      written += n;
+      head += sizeof(Fragment) + alignFragment(n);
+      complete = written == msg.size;
+    }
+
+    ring.head.store(head, std::memory_order_release);
+    return complete;
+  }
+
+  void SharedMemoryTransport::receive(
+      std::vector<std::shared_ptr<Message>> &received)
+  {
+    for (size_t source = 0; source < inbound.size(); ++source) {
+      Ring &ring = *inbound[source];
+      uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+      const uint64_t head = ring.head.load(std::memory_order_acquire);
+      if (tail == head)
+        continue;
+
+      const byte_t *data = ring.data();
+      while (tail < head) {
+        const size_t pos = tail % capacity;
+        Fragment fragment;
+        std::memcpy(&fragment, data + pos, sizeof(fragment));
+        if (fragment.size == wrapMarker) {
+          tail += capacity - pos;
+          continue;
+        }
+
+        auto &msg = partial[source];
+        if (!msg) {
+          msg = makeMessage(fragment.messageSize);
+          msg->comm = comm;
+          msg->rank = mpicommon::globalRankOf(source);
+          msg->tag = fragment.tag;
+          msg->started = std::chrono::high_resolution_clock::now();
+          partialReceived[source] = 0;
+        }
+
+        std::memcpy(msg->data + partialReceived[source],
+                    data + pos + sizeof(fragment), fragment.size);
+        partialReceived[source] += fragment.size;
+        tail += sizeof(Fragment) + alignFragment(fragment.size);
+
+        if (partialReceived[source] == msg->size)
+          received.push_back(std::move(msg));
+      }
+
+      ring.tail.store(tail, std::memory_order_release);
+    }
+  }
+
+} // ::maml
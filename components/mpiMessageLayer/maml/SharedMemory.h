@@ -0,0 +1,97 @@
+// ======================================================================== //
+// Copyright 2016-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "maml.h"
+// std
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace maml {
+
+  /*! sends the messages between ranks of the same node through
+      single-producer single-consumer ring buffers in an MPI shared
+      memory window (of 'node', see mpicommon::initNodeGroup), instead
+      of MPI messages. Each rank owns one ring per sender of its node;
+      messages larger than the free space of the ring are split into
+      fragments, such that the messages between two ranks keep their
+      order. Only messages on the communicator of the world group are
+      sent this way. */
+  class SharedMemoryTransport
+  {
+  public:
+    using MessageFactory = std::function<std::shared_ptr<Message>(size_t)>;
+
+    /*! collective over mpicommon::node, 'ringBytes' is the capacity of
+        each ring */
+    SharedMemoryTransport(size_t ringBytes, MessageFactory makeMessage);
+    //! collective over mpicommon::node (if MPI is not finalized yet)
+    ~SharedMemoryTransport();
+
+    //! whether messages to comm:rank go through shared memory
+    bool reaches(MPI_Comm comm, int rank) const;
+
+    //! queue 'msg' for sending, only called by the sending thread
+    void send(std::shared_ptr<Message> msg);
+
+    /*! write as many queued messages into the rings as fit, only called
+        by the sending thread */
+    void progressSends();
+
+    //! whether messages are queued which did not fit into the rings yet
+    bool hasPendingSends() const;
+
+    /*! append the completely received messages to 'received', only
+        called by the receiving thread */
+    void receive(std::vector<std::shared_ptr<Message>> &received);
+
+  private:
+
+    struct Ring;
+
+    Ring *ring(void *base, int index) const;
+
+    /*! write the next fragments of 'msg' (of which 'written' bytes were
+        written already) into 'ring', as far as it has room; returns
+        whether the message was completely written */
+    bool writeMessage(Ring &ring, const Message &msg, size_t &written);
+
+    MPI_Win window {MPI_WIN_NULL};
+    MPI_Comm comm {MPI_COMM_NULL};
+    size_t capacity {0};
+    size_t ringStride {0};
+    MessageFactory makeMessage;
+
+    //! the rings of the messages from each rank of the node to this one
+    std::vector<Ring *> inbound;
+    //! the rings of the messages from this rank to each rank of the node
+    std::vector<Ring *> outbound;
+
+    //! per destination (node rank): the queued messages, and how much of
+    //! the front one was already written
+    std::vector<std::deque<std::shared_ptr<Message>>> pending;
+    std::vector<size_t> pendingWritten;
+    std::atomic<size_t> numPending {0};
+
+    //! per source: the message being received, and how much of it was
+    std::vector<std::shared_ptr<Message>> partial;
+    std::vector<size_t> partialReceived;
+  };
+
+} // ::maml
@@ -102,6 +102,59 @@ namespace ospcommon {
       bool valuesAreMine;
     };
 
+    /*! implementation of an array3d that stores its values in tiles of
+        4x4x4 cells, such that the 8 cells of a trilinear interpolation
+        touch few cache lines for any direction of traversal */
+    template <typename value_t>
+    struct TiledArray3D : public Array3D<value_t>
+    {
+      static constexpr int tileWidth = 4;
+
+      TiledArray3D(const vec3i &dims);
+
+      /*! copies (ie, re-arranges) the values of another array3d */
+      TiledArray3D(const Array3D<value_t> &other);
+
+      /*! return size (ie, "dimensions") of volume */
+      vec3i size() const override
+      {
+        return dims;
+      }
+
+      /*! get cell value at given location, clamped to the volume */
+      value_t get(const vec3i &where) const override
+      {
+        return value[indexOf(max(vec3i(0), min(where, dims - vec3i(1))))];
+      }
+
+      /*! set cell value at location to given value
+
+        \warning 'where' MUST be a valid cell location */
+      void set(const vec3i &where, const value_t &t)
+      {
+        value[indexOf(where)] = t;
+      }
+
+      /*! returns number of elements (as 64-bit int) across all dimensions */
+      size_t numElements() const override
+      {
+        return longProduct(dims);
+      }
+
+      /* compute the (1D) index in the tiled layout for a grid coordinate */
+      size_t indexOf(const vec3i &pos) const
+      {
+        const size_t tile = (pos.x >> 2) + size_t(tileCount.x) *
+            ((pos.y >> 2) + size_t(tileCount.y) * (pos.z >> 2));
+        return (tile << 6) | ((pos.z & 3) << 4) | ((pos.y & 3) << 2) |
+               (pos.x & 3);
+      }
+
+      const vec3i dims;
+      const vec3i tileCount;
+      std::vector<value_t> value;
+    };
+
     /*! shifts another array3d by a given amount */
     template <typename value_t>
     struct IndexShiftedArray3D : public Array3D<value_t>
@@ -355,6 +408,26 @@ namespace ospcommon {
       for_each(size(), [&](const vec3i &idx){ set(idx, t); });
     }
 
+    // TiledArray3D //
+
+    template <typename T>
+    constexpr int TiledArray3D<T>::tileWidth;
+
+    template <typename T>
+    inline TiledArray3D<T>::TiledArray3D(const vec3i &dims)
+        : dims(dims),
+          tileCount((dims + tileWidth - 1) / tileWidth),
+          value(longProduct(tileCount) * tileWidth * tileWidth * tileWidth)
+    {
+    }
+
+    template <typename T>
+    inline TiledArray3D<T>::TiledArray3D(const Array3D<T> &other)
+        : TiledArray3D(other.size())
+    {
+      for_each(dims, [&](const vec3i &idx) { set(idx, other.get(idx)); });
+    }
+
     // Array3DAccessor //
 
     template <typename in_t, typename out_t>
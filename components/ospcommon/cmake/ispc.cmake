@@ -117,6 +117,14 @@ MACRO (OSPRAY_ISPC_COMPILE)
   SET(ISPC_TARGET_DIR ${CMAKE_CURRENT_BINARY_DIR})
   INCLUDE_DIRECTORIES(${ISPC_TARGET_DIR})
 
+  # builds of the same sources for another target list (named by
+  # OSPRAY_ISPC_TARGET_NAME) write their (identical) headers aside
+  IF (OSPRAY_ISPC_TARGET_NAME)
+    SET(ISPC_HEADER_DIR ${ISPC_TARGET_DIR}/${OSPRAY_ISPC_TARGET_NAME})
+  ELSE()
+    SET(ISPC_HEADER_DIR ${ISPC_TARGET_DIR})
+  ENDIF()
+
   IF(ISPC_INCLUDE_DIR)
     STRING(REPLACE ";" ";-I;" ISPC_INCLUDE_DIR_PARMS "${ISPC_INCLUDE_DIR}")
     SET(ISPC_INCLUDE_DIR_PARMS "-I" ${ISPC_INCLUDE_DIR_PARMS})
@@ -182,14 +190,15 @@ MACRO (OSPRAY_ISPC_COMPILE)
     LIST(LENGTH ISPC_TARGETS NUM_TARGETS)
     IF (NUM_TARGETS GREATER 1)
       FOREACH(target ${ISPC_TARGETS})
-        STRING(REPLACE "-i32x16" "" target ${target}) # strip avx512(knl|skx)-i32x16
+        STRING(REGEX REPLACE "-i32x(8|16)$" "" target ${target}) # strip avx512(knl|skx)-i32x(8|16)
         SET(results ${results} "${outdir}/${fname}.dev_${target}${ISPC_TARGET_EXT}")
       ENDFOREACH()
     ENDIF()
 
     ADD_CUSTOM_COMMAND(
-      OUTPUT ${results} ${ISPC_TARGET_DIR}/${fname}_ispc.h
+      OUTPUT ${results} ${ISPC_HEADER_DIR}/${fname}_ispc.h
       COMMAND ${CMAKE_COMMAND} -E make_directory ${outdir}
+      COMMAND ${CMAKE_COMMAND} -E make_directory ${ISPC_HEADER_DIR}
       COMMAND ${ISPC_EXECUTABLE}
       ${ISPC_DEFINITIONS}
       -I ${CMAKE_CURRENT_SOURCE_DIR}
@@ -201,7 +210,7 @@ MACRO (OSPRAY_ISPC_COMPILE)
       --woff
       --opt=fast-math
       ${ISPC_ADDITIONAL_ARGS}
-      -h ${ISPC_TARGET_DIR}/${fname}_ispc.h
+      -h ${ISPC_HEADER_DIR}/${fname}_ispc.h
       -MMM  ${outdir}/${fname}.dev.idep
       -o ${outdir}/${fname}.dev${ISPC_TARGET_EXT}
       ${input}
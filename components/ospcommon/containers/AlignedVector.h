@@ -25,5 +25,14 @@ namespace ospcommon {
     template <typename T>
     using AlignedVector = std::vector<T, aligned_allocator<T>>;
 
+    /*! for multi-GB arrays: backed by huge pages, zeroed in parallel by the
+        tasking threads (first touch), and resize() does not initialize
+        the elements once more */
+    template <typename T,
+              int flags = memory::ALLOC_HUGE_PAGES | memory::ALLOC_FIRST_TOUCH |
+                          memory::ALLOC_NO_INIT>
+    using LargeAlignedVector =
+        std::vector<T, aligned_allocator<T, OSPRAY_DEFAULT_ALIGNMENT, flags>>;
+
   }  // namespace container
 }  // namespace ospcommon
\ No newline at end of file
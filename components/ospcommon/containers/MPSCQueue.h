@@ -0,0 +1,147 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace ospcommon {
+
+  /*! \brief unbounded lock-free multi-producer/single-consumer queue
+
+    A drop-in for TransactionalBuffer where many threads push at once:
+    producers link their element with a single atomic exchange (never
+    waiting on each other or on the consumer), while one thread at a time
+    pops or consumes. Elements come out in the order their exchange
+    happened. T needs to be default-constructible.
+   */
+  template <typename T>
+  class MPSCQueue
+  {
+  public:
+
+    MPSCQueue();
+    ~MPSCQueue();
+
+    MPSCQueue(const MPSCQueue &) = delete;
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+    // Insert into the queue (producers)
+    void push(const T &);
+    void push(T &&);
+
+    // Take the oldest element (consumer), false if it is empty
+    bool pop(T &);
+
+    // Take all contents of the queue (consumer)
+    std::vector<T> consume();
+
+    /*! whether there is nothing to pop; a push racing with this may not be
+        visible yet */
+    bool empty() const;
+
+  private:
+
+    struct Node
+    {
+      Node() = default;
+      template <typename U>
+      explicit Node(U &&v) : value(std::forward<U>(v)) {}
+
+      std::atomic<Node*> next {nullptr};
+      T value;
+    };
+
+    void pushNode(Node *node);
+
+    // Data members //
+
+    //! most recently pushed node
+    alignas(64) std::atomic<Node*> tail;
+    //! node whose value was taken last (initially a dummy)
+    alignas(64) Node *head;
+  };
+
+  // Inlined members //////////////////////////////////////////////////////////
+
+  template<typename T>
+  inline MPSCQueue<T>::MPSCQueue()
+  {
+    head = new Node;
+    tail.store(head, std::memory_order_relaxed);
+  }
+
+  template<typename T>
+  inline MPSCQueue<T>::~MPSCQueue()
+  {
+    while (head) {
+      Node *next = head->next.load(std::memory_order_relaxed);
+      delete head;
+      head = next;
+    }
+  }
+
+  template<typename T>
+  inline void MPSCQueue<T>::push(const T &v)
+  {
+    pushNode(new Node(v));
+  }
+
+  template<typename T>
+  inline void MPSCQueue<T>::push(T &&v)
+  {
+    pushNode(new Node(std::move(v)));
+  }
+
+  template<typename T>
+  inline void MPSCQueue<T>::pushNode(Node *node)
+  {
+    Node *prev = tail.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  template<typename T>
+  inline bool MPSCQueue<T>::pop(T &v)
+  {
+    Node *next = head->next.load(std::memory_order_acquire);
+    if (!next)
+      return false;
+
+    v = std::move(next->value);
+    delete head;
+    head = next;
+    return true;
+  }
+
+  template<typename T>
+  inline std::vector<T> MPSCQueue<T>::consume()
+  {
+    std::vector<T> contents;
+    T v;
+    while (pop(v))
+      contents.push_back(std::move(v));
+    return contents;
+  }
+
+  template<typename T>
+  inline bool MPSCQueue<T>::empty() const
+  {
+    return head->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+} // ::ospcommon
@@ -0,0 +1,146 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace ospcommon {
+
+  /*! \brief bounded lock-free multi-producer/single-consumer ring buffer
+
+    Any number of threads may push() concurrently, while only one thread
+    at a time may pop(). Each slot carries a sequence number telling
+    whether it is free for the producer of a lap or filled for the
+    consumer, such that producers only contend on the tail index. T needs
+    to be default-constructible and move-assignable.
+   */
+  template <typename T>
+  class MPSCRing
+  {
+  public:
+
+    //! capacity gets rounded up to a power of two
+    explicit MPSCRing(size_t capacity);
+
+    MPSCRing(const MPSCRing &) = delete;
+    MPSCRing &operator=(const MPSCRing &) = delete;
+
+    // Insert into the ring (producers), false if it is full
+    bool push(const T &);
+    bool push(T &&);
+
+    // Take the oldest element (consumer), false if it is empty
+    bool pop(T &);
+
+    size_t capacity() const;
+
+  private:
+
+    template <typename U>
+    bool emplace(U &&);
+
+    struct Slot
+    {
+      std::atomic<size_t> sequence;
+      T value;
+    };
+
+    // Data members //
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> tail {0};
+    alignas(64) size_t head {0};
+  };
+
+  // Inlined members //////////////////////////////////////////////////////////
+
+  template<typename T>
+  inline MPSCRing<T>::MPSCRing(size_t capacity)
+  {
+    size_t size = 1;
+    while (size < capacity)
+      size *= 2;
+
+    slots.reset(new Slot[size]);
+    mask = size - 1;
+    for (size_t i = 0; i < size; ++i)
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  template<typename T>
+  inline bool MPSCRing<T>::push(const T &v)
+  {
+    return emplace(v);
+  }
+
+  template<typename T>
+  inline bool MPSCRing<T>::push(T &&v)
+  {
+    return emplace(std::move(v));
+  }
+
+  template<typename T>
+  template<typename U>
+  inline bool MPSCRing<T>::emplace(U &&v)
+  {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true) {
+      slot = &slots[pos & mask];
+      const size_t seq = slot->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false; // the consumer did not free the slot of the last lap
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->value = std::forward<U>(v);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  template<typename T>
+  inline bool MPSCRing<T>::pop(T &v)
+  {
+    Slot &slot = slots[head & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+      return false;
+
+    v = std::move(slot.value);
+    slot.sequence.store(head + mask + 1, std::memory_order_release);
+    ++head;
+    return true;
+  }
+
+  template<typename T>
+  inline size_t MPSCRing<T>::capacity() const
+  {
+    return mask + 1;
+  }
+
+} // ::ospcommon
@@ -32,7 +32,11 @@ namespace ospcommon {
 
 #define OSPRAY_DEFAULT_ALIGNMENT 64
 
-    template <typename T, int alignment = OSPRAY_DEFAULT_ALIGNMENT>
+    /*! 'flags' are memory::AllocationFlags, e.g. to get huge pages or to
+        skip the value-initialization of the elements */
+    template <typename T,
+              int alignment = OSPRAY_DEFAULT_ALIGNMENT,
+              int flags     = memory::ALLOC_DEFAULT>
     struct aligned_allocator
     {
       // Compile-time info //
@@ -48,7 +52,7 @@ namespace ospcommon {
       template <typename U>
       struct rebind
       {
-        using other = aligned_allocator<U>;
+        using other = aligned_allocator<U, alignment, flags>;
       };
 
       // Implementation //
@@ -58,11 +62,11 @@ namespace ospcommon {
       ~aligned_allocator()                         = default;
       aligned_allocator &operator=(const aligned_allocator &) = delete;
 
-      template <typename U, int OA = OSPRAY_DEFAULT_ALIGNMENT>
-      aligned_allocator(const aligned_allocator<U, OA> &);
+      template <typename U, int OA, int OF>
+      aligned_allocator(const aligned_allocator<U, OA, OF> &);
 
-      template <typename U, int OA = OSPRAY_DEFAULT_ALIGNMENT>
-      aligned_allocator &operator=(const aligned_allocator<U, OA> &);
+      template <typename U, int OA, int OF>
+      aligned_allocator &operator=(const aligned_allocator<U, OA, OF> &);
 
       T *address(T &r) const;
       const T *address(const T &s) const;
@@ -71,6 +75,7 @@ namespace ospcommon {
 
       bool operator!=(const aligned_allocator &other) const;
 
+      void construct(T *const p) const;
       void construct(T *const p, const T &t) const;
       void destroy(T *const p) const;
 
@@ -89,62 +94,75 @@ namespace ospcommon {
 
     // Inlined member definitions /////////////////////////////////////////////
 
-    template <typename T, int A>
-    template <typename U, int OA>
-    aligned_allocator<T, A>::aligned_allocator(const aligned_allocator<U, OA> &)
+    template <typename T, int A, int F>
+    template <typename U, int OA, int OF>
+    aligned_allocator<T, A, F>::aligned_allocator(
+        const aligned_allocator<U, OA, OF> &)
     {
     }
 
-    template <typename T, int A>
-    template <typename U, int OA>
-    aligned_allocator<T, A> &
-    aligned_allocator<T, A>::operator=(const aligned_allocator<U, OA> &)
+    template <typename T, int A, int F>
+    template <typename U, int OA, int OF>
+    aligned_allocator<T, A, F> &
+    aligned_allocator<T, A, F>::operator=(const aligned_allocator<U, OA, OF> &)
     {
+      return *this;
     }
 
-    template <typename T, int A>
-    inline T *aligned_allocator<T, A>::address(T &r) const
+    template <typename T, int A, int F>
+    inline T *aligned_allocator<T, A, F>::address(T &r) const
     {
       return &r;
     }
 
-    template <typename T, int A>
-    inline const T *aligned_allocator<T, A>::address(const T &s) const
+    template <typename T, int A, int F>
+    inline const T *aligned_allocator<T, A, F>::address(const T &s) const
     {
       return &s;
     }
 
-    template <typename T, int A>
-    inline size_t aligned_allocator<T, A>::max_size() const
+    template <typename T, int A, int F>
+    inline size_t aligned_allocator<T, A, F>::max_size() const
     {
       // The following has been carefully written to be independent of
       // the definition of size_t and to avoid signed/unsigned warnings.
       return (static_cast<size_t>(0) - static_cast<size_t>(1)) / sizeof(T);
     }
 
-    template <typename T, int A>
-    inline bool aligned_allocator<T, A>::operator!=(
+    template <typename T, int A, int F>
+    inline bool aligned_allocator<T, A, F>::operator!=(
         const aligned_allocator &other) const
     {
       return !(*this == other);
     }
 
-    template <typename T, int A>
-    inline void aligned_allocator<T, A>::construct(T *const p, const T &t) const
+    template <typename T, int A, int F>
+    inline void aligned_allocator<T, A, F>::construct(T *const p) const
+    {
+      void *const pv = static_cast<void *>(p);
+      if (F & memory::ALLOC_NO_INIT)
+        new (pv) T;
+      else
+        new (pv) T();
+    }
+
+    template <typename T, int A, int F>
+    inline void aligned_allocator<T, A, F>::construct(T *const p,
+                                                      const T &t) const
     {
       void *const pv = static_cast<void *>(p);
       new (pv) T(t);
     }
 
-    template <typename T, int A>
-    inline bool aligned_allocator<T, A>::operator==(
+    template <typename T, int A, int F>
+    inline bool aligned_allocator<T, A, F>::operator==(
         const aligned_allocator &) const
     {
       return true;
     }
 
-    template <typename T, int A>
-    inline T *aligned_allocator<T, A>::allocate(const size_t n) const
+    template <typename T, int A, int F>
+    inline T *aligned_allocator<T, A, F>::allocate(const size_t n) const
     {
       if (n == 0)
         return nullptr;
@@ -154,7 +172,9 @@ namespace ospcommon {
             "aligned_allocator<T>::allocate() – Integer overflow.");
       }
 
-      void *const pv = memory::alignedMalloc(n * sizeof(T), A);
+      void *const pv = F == memory::ALLOC_DEFAULT ?
+          memory::alignedMalloc(n * sizeof(T), A) :
+          memory::alignedMalloc(n * sizeof(T), A, F);
 
       if (pv == nullptr)
         throw std::bad_alloc();
@@ -162,22 +182,23 @@ namespace ospcommon {
       return static_cast<T *>(pv);
     }
 
-    template <typename T, int A>
-    inline void aligned_allocator<T, A>::deallocate(T *const p,
-                                                    const size_t) const
+    template <typename T, int A, int F>
+    inline void aligned_allocator<T, A, F>::deallocate(T *const p,
+                                                       const size_t) const
     {
       memory::alignedFree(p);
     }
 
-    template <typename T, int A>
+    template <typename T, int A, int F>
     template <typename U>
-    inline T *aligned_allocator<T, A>::allocate(const size_t n, const U *) const
+    inline T *aligned_allocator<T, A, F>::allocate(const size_t n,
+                                                   const U *) const
     {
       return allocate(n);
     }
 
-    template <typename T, int A>
-    inline void aligned_allocator<T, A>::destroy(T *const p) const
+    template <typename T, int A, int F>
+    inline void aligned_allocator<T, A, F>::destroy(T *const p) const
     {
       p->~T();
     }
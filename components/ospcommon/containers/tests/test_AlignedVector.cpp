@@ -28,3 +28,23 @@ TEST_CASE("Interface Tests", "[all]")
 
   REQUIRE(ospcommon::memory::isAligned(aligned_vec.data()));
 }
+
+TEST_CASE("Large vectors", "[all]")
+{
+  using ospcommon::containers::LargeAlignedVector;
+
+  // spans several huge pages, with a partial one at the end
+  const size_t n = 3 * 1024 * 1024 + 17;
+
+  LargeAlignedVector<float> large_vec;
+  large_vec.resize(n);
+
+  REQUIRE(ospcommon::memory::isAligned(large_vec.data()));
+  REQUIRE(large_vec[0] == 0.f);
+  REQUIRE(large_vec[n - 1] == 0.f);
+
+  large_vec[n - 1] = 1.f;
+  large_vec.push_back(2.f);
+  REQUIRE(large_vec[n - 1] == 1.f);
+  REQUIRE(large_vec[n] == 2.f);
+}
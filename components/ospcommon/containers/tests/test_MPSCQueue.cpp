@@ -0,0 +1,86 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "../../testing/catch.hpp"
+
+#include "../MPSCQueue.h"
+
+#include <algorithm>
+#include <thread>
+
+using ospcommon::MPSCQueue;
+
+// Tests //////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interface Tests", "[all]")
+{
+  MPSCQueue<int> q;
+
+  REQUIRE(q.empty());
+
+  q.push(2);
+  q.push(3);
+
+  REQUIRE(!q.empty());
+
+  int v = 0;
+  REQUIRE(q.pop(v));
+  REQUIRE(v == 2);
+
+  auto rest = q.consume();
+
+  REQUIRE(rest.size() == 1);
+  REQUIRE(rest[0] == 3);
+  REQUIRE(q.empty());
+  REQUIRE(!q.pop(v));
+}
+
+TEST_CASE("Concurrent producers", "[all]")
+{
+  MPSCQueue<int> q;
+
+  const int numThreads = 4;
+  const int numPerThread = 10000;
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < numThreads; t++) {
+    producers.emplace_back([&, t]() {
+      for (int i = 0; i < numPerThread; i++)
+        q.push(t * numPerThread + i);
+    });
+  }
+
+  // consume concurrently, the values of each producer arrive in order
+  std::vector<int> last(numThreads, -1);
+  int received = 0;
+  bool inOrder = true;
+  while (received < numThreads * numPerThread) {
+    int v = 0;
+    if (!q.pop(v))
+      continue;
+    const int t = v / numPerThread;
+    inOrder = inOrder && v > last[t];
+    last[t] = v;
+    received++;
+  }
+
+  for (auto &p : producers)
+    p.join();
+
+  REQUIRE(inOrder);
+  REQUIRE(q.empty());
+}
@@ -0,0 +1,87 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "../../testing/catch.hpp"
+
+#include "../MPSCRing.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using ospcommon::MPSCRing;
+
+// Tests //////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Interface Tests", "[all]")
+{
+  MPSCRing<int> ring(3);
+
+  REQUIRE(ring.capacity() == 4);
+
+  for (int i = 0; i < 4; i++)
+    REQUIRE(ring.push(i));
+
+  REQUIRE(!ring.push(4));
+
+  int v = -1;
+  REQUIRE(ring.pop(v));
+  REQUIRE(v == 0);
+
+  // the freed slot is available for the next lap
+  REQUIRE(ring.push(4));
+
+  for (int i = 1; i <= 4; i++) {
+    REQUIRE(ring.pop(v));
+    REQUIRE(v == i);
+  }
+
+  REQUIRE(!ring.pop(v));
+}
+
+TEST_CASE("Concurrent producers", "[all]")
+{
+  MPSCRing<int> ring(64);
+
+  const int numThreads = 4;
+  const int numPerThread = 10000;
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < numThreads; t++) {
+    producers.emplace_back([&, t]() {
+      for (int i = 0; i < numPerThread; i++) {
+        while (!ring.push(t * numPerThread + i))
+          std::this_thread::yield();
+      }
+    });
+  }
+
+  std::vector<int> count(numThreads * numPerThread, 0);
+  for (int received = 0; received < numThreads * numPerThread;) {
+    int v = 0;
+    if (ring.pop(v)) {
+      count[v]++;
+      received++;
+    }
+  }
+
+  for (auto &p : producers)
+    p.join();
+
+  REQUIRE(std::all_of(count.begin(), count.end(),
+                      [](int c) { return c == 1; }));
+}
@@ -21,9 +21,19 @@
 #  include "tbb/scalable_allocator.h"
 #endif
 
+#include "../sysinfo.h"
+#include "../tasking/parallel_for.h"
+
+#include <cstring>
+
 #ifdef _WIN32
 #include <malloc.h>
 #endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace ospcommon {
   namespace memory {
@@ -55,5 +65,83 @@ namespace ospcommon {
 #endif
     }
 
+    //! size of a transparent huge page (on x86-64)
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    void* alignedMalloc(size_t size, size_t align, int flags)
+    {
+      // huge pages can only back huge-page-aligned parts of the range
+      if ((flags & ALLOC_HUGE_PAGES) && size >= HUGE_PAGE_SIZE)
+        align = std::max(align, HUGE_PAGE_SIZE);
+
+      void *ptr = alignedMalloc(size, align);
+      if (!ptr)
+        return nullptr;
+
+      // advise before the first touch, as the pages get faulted in then
+      if (flags & ALLOC_HUGE_PAGES)
+        adviseHugePages(ptr, size);
+      if (flags & ALLOC_FIRST_TOUCH)
+        parallelFirstTouch(ptr, size);
+
+      return ptr;
+    }
+
+    void adviseHugePages(void *ptr, size_t size)
+    {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+      const size_t begin = ALIGN_PTR(ptr, PAGE_SIZE);
+      const size_t end   = ((size_t)ptr + size) & ~size_t(PAGE_SIZE - 1);
+      if (end > begin)
+        madvise((void *)begin, end - begin, MADV_HUGEPAGE);
+#else
+      UNUSED(ptr, size);
+#endif
+    }
+
+    void parallelFirstTouch(void *ptr, size_t size)
+    {
+      // whole huge pages per block, such that no page is shared by threads
+      const size_t blockSize = HUGE_PAGE_SIZE;
+      const size_t numBlocks = (size + blockSize - 1) / blockSize;
+      tasking::parallel_for(numBlocks, 1, [&](size_t first, size_t last) {
+        const size_t begin = first * blockSize;
+        const size_t end   = std::min(last * blockSize, size);
+        std::memset((char *)ptr + begin, 0, end - begin);
+      }, tasking::Partitioning::STATIC);
+    }
+
+    void bindToNUMANode(void *ptr, size_t size, int node)
+    {
+#ifdef __linux__
+      const int numNodes = getNumberOfNUMANodes();
+      if (numNodes < 2 || node < 0 || node >= numNodes)
+        return;
+
+      const size_t begin = ALIGN_PTR(ptr, PAGE_SIZE);
+      const size_t end   = ((size_t)ptr + size) & ~size_t(PAGE_SIZE - 1);
+      if (end <= begin)
+        return;
+
+      // mbind() via syscall, so not to depend on libnuma
+      const int MPOL_PREFERRED = 1;
+      const unsigned MPOL_MF_MOVE = 1 << 1;
+      const size_t maskBits = 8 * sizeof(unsigned long);
+      std::vector<unsigned long> mask(numNodes / maskBits + 1, 0);
+      mask[node / maskBits] = 1ul << (node % maskBits);
+      syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED, mask.data(),
+              mask.size() * maskBits, MPOL_MF_MOVE);
+#else
+      UNUSED(ptr, size, node);
+#endif
+    }
+
+    void* alignedMallocOnNUMANode(size_t size, int node, size_t align)
+    {
+      void *ptr = alignedMalloc(size, std::max(align, size_t(PAGE_SIZE)));
+      bindToNUMANode(ptr, size, node);
+      return ptr;
+    }
+
   } // ::ospcommon::memory
 } // ::ospcommon
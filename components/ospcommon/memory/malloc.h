@@ -24,10 +24,47 @@ namespace ospcommon {
 #define ALIGN_PTR(ptr,alignment) \
   ((((size_t)ptr)+alignment-1)&((size_t)-(ssize_t)alignment))
 
+      /*! opt-in behavior for large allocations, to be or'ed together */
+      enum AllocationFlags
+      {
+        ALLOC_DEFAULT     = 0,
+        /*! back the memory by transparent huge pages, if available */
+        ALLOC_HUGE_PAGES  = 1 << 0,
+        /*! zero the memory in parallel on the tasking threads, such that the
+            pages get faulted in concurrently and placed (first touch) on the
+            NUMA node of the thread which will likely use them */
+        ALLOC_FIRST_TOUCH = 1 << 1,
+        /*! only for containers: default- instead of value-initialize the
+            elements, i.e. leave trivial types uninitialized */
+        ALLOC_NO_INIT     = 1 << 2
+      };
+
       /*! aligned allocation */
       OSPCOMMON_INTERFACE void* alignedMalloc(size_t size, size_t align = 64);
       OSPCOMMON_INTERFACE void alignedFree(void* ptr);
 
+      /*! aligned allocation with the given AllocationFlags, to be freed
+          with alignedFree() */
+      OSPCOMMON_INTERFACE void* alignedMalloc(size_t size, size_t align,
+                                              int flags);
+
+      /*! advise the kernel to back the pages fully within the memory range
+          by transparent huge pages; a no-op where not supported */
+      OSPCOMMON_INTERFACE void adviseHugePages(void *ptr, size_t size);
+
+      /*! zero the memory range in parallel, contiguous parts per thread */
+      OSPCOMMON_INTERFACE void parallelFirstTouch(void *ptr, size_t size);
+
+      /*! prefer the given NUMA node for the pages of the memory range;
+          pages only partially within the range are left as they are, and
+          it is a no-op on systems with a single (or unknown) node */
+      OSPCOMMON_INTERFACE void bindToNUMANode(void *ptr, size_t size, int node);
+
+      /*! aligned allocation located on the given NUMA node, to be freed
+          with alignedFree() */
+      OSPCOMMON_INTERFACE void* alignedMallocOnNUMANode(size_t size, int node,
+                                                        size_t align = 64);
+
       template <typename T>
        __forceinline T* alignedMalloc(size_t nElements, size_t align = 64)
       {
@@ -67,6 +67,13 @@ namespace ospcommon {
 
     void BufferedWriteStream::write(const void *mem, size_t size)
     {
+      // large writes are sent directly, without copying them
+      if (size >= maxBufferSize) {
+        flush();
+        fabric.get().send(mem, size);
+        return;
+      }
+
       size_t stillToWrite = size;
       auto *readPtr = (const uint8_t*)mem;
       while (stillToWrite) {
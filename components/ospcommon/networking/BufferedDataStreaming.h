@@ -44,7 +44,8 @@ namespace ospcommon {
       all write ops preferably into this buffer; this internal
       buffer gets flushed either when the user explicitly calls
       flush(), or when the maximum size of the buffer gets
-      reached */
+      reached. Writes of at least the buffer size are sent to the
+      fabric directly */
     struct OSPCOMMON_INTERFACE BufferedWriteStream : public WriteStream
     {
       BufferedWriteStream(Fabric &fabric, size_t maxBufferSize = 1LL*1024*1024);
@@ -0,0 +1,93 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "QueuedFabric.h"
+
+namespace ospcommon {
+  namespace networking {
+
+    QueuedFabric::QueuedFabric(std::unique_ptr<Fabric> _fabric,
+                               size_t maxQueuedBytes)
+      : fabric(std::move(_fabric)),
+        maxQueuedBytes(maxQueuedBytes),
+        thread([&]() { sendQueued(); })
+    {
+    }
+
+    QueuedFabric::~QueuedFabric()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+      }
+      condition.notify_all();
+      thread.join();
+    }
+
+    void QueuedFabric::send(const void *mem, size_t size)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (size > maxQueuedBytes) {
+        // too large to copy: send it from the caller's memory, after
+        // the blocks before it
+        condition.wait(lock, [&]() { return queue.empty() && !sending; });
+        fabric->send(mem, size);
+        return;
+      }
+
+      condition.wait(lock, [&]() {
+        return queuedBytes + size <= maxQueuedBytes;
+      });
+      queue.emplace_back((const byte_t*)mem, (const byte_t*)mem + size);
+      queuedBytes += size;
+      condition.notify_all();
+    }
+
+    size_t QueuedFabric::read(void *&mem)
+    {
+      return fabric->read(mem);
+    }
+
+    void QueuedFabric::sync()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [&]() { return queue.empty() && !sending; });
+    }
+
+    void QueuedFabric::sendQueued()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      for (;;) {
+        condition.wait(lock, [&]() { return quit || !queue.empty(); });
+        if (queue.empty())
+          return;
+
+        std::vector<byte_t> block = std::move(queue.front());
+        queue.pop_front();
+        sending = true;
+
+        lock.unlock();
+        fabric->send(block.data(), block.size());
+        lock.lock();
+
+        queuedBytes -= block.size();
+        sending = false;
+        condition.notify_all();
+      }
+    }
+
+  } // ::ospcommon::networking
+} // ::ospcommon
@@ -0,0 +1,69 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Fabric.h"
+
+namespace ospcommon {
+  namespace networking {
+
+    /*! A fabric which sends the blocks of another one from a background
+        thread, such that 'send' returns as soon as the block is queued.
+        Up to 'maxQueuedBytes' are queued, larger blocks are sent
+        directly once the queue drained. Reads go to the other fabric */
+    struct OSPCOMMON_INTERFACE QueuedFabric : public Fabric
+    {
+      QueuedFabric(std::unique_ptr<Fabric> fabric,
+                   size_t maxQueuedBytes = 64LL*1024*1024);
+      //! sends the blocks still queued
+      ~QueuedFabric() override;
+
+      QueuedFabric(const QueuedFabric&) = delete;
+      QueuedFabric& operator=(const QueuedFabric&) = delete;
+
+      void send(const void *mem, size_t size) override;
+
+      size_t read(void *&mem) override;
+
+      //! wait until all queued blocks are sent
+      void sync();
+
+    private:
+
+      void sendQueued();
+
+      std::unique_ptr<Fabric> fabric;
+      size_t maxQueuedBytes;
+
+      std::mutex mutex;
+      std::condition_variable condition;
+      std::deque<std::vector<byte_t>> queue;
+      size_t queuedBytes {0};
+      //! a block is taken from the queue, but not sent yet
+      bool sending {false};
+      bool quit {false};
+      std::thread thread;
+    };
+
+  } // ::ospcommon::networking
+} // ::ospcommon
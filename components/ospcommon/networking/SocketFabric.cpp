@@ -14,6 +14,9 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <algorithm>
+#include <future>
+
 #include "SocketFabric.h"
 
 namespace ospcommon {
@@ -29,35 +32,53 @@ namespace ospcommon {
 
     // SocketFabric definitions ///////////////////////////////////////////////
 
-    SocketFabric::SocketFabric(const std::string &hostname, const uint16_t port)
+    SocketFabric::SocketFabric(const std::string &hostname, const uint16_t port,
+                               const uint32_t numStreams)
       : socket(ospcommon::connect(hostname.c_str(), port)),
       buffer(64 * 1024, 0)
-    {}
+    {
+      // tell the listener how many connections to accept
+      const uint32_t n = std::max(numStreams, 1u);
+      ospcommon::write(socket, &n, sizeof(n));
+      ospcommon::flush(socket);
+      for (uint32_t i = 1; i < n; ++i)
+        streams.push_back(ospcommon::connect(hostname.c_str(), port));
+    }
 
-    SocketFabric::SocketFabric(ospcommon::socket_t socket)
+    SocketFabric::SocketFabric(ospcommon::socket_t socket,
+                               std::vector<ospcommon::socket_t> streams)
       : socket(socket),
+      streams(std::move(streams)),
       buffer(64 * 1024, 0)
     {}
 
     SocketFabric::~SocketFabric()
     {
       closeIfExists(socket);
+      for (auto &s : streams)
+        closeIfExists(s);
     }
 
     SocketFabric::SocketFabric(SocketFabric &&other)
       : socket(other.socket),
+      streams(std::move(other.streams)),
       buffer(64 * 1024, 0)
     {
       // Note: the buffered socket destructor does not call shutdown
       other.socket = nullptr;
+      other.streams.clear();
     }
 
     SocketFabric& SocketFabric::operator=(SocketFabric &&other)
     {
       closeIfExists(socket);
+      for (auto &s : streams)
+        closeIfExists(s);
 
       socket = other.socket;
       other.socket = nullptr;
+      streams = std::move(other.streams);
+      other.streams.clear();
 
       return *this;
     }
@@ -67,16 +88,81 @@ namespace ospcommon {
       // A bit annoying, because the ospcommon::Socket wrapper does its
       // own internal buffering, however a Fabric is unbuffered and is
       // made buffered by using the buffered data streams
-      ospcommon::write(socket, mem, s);
-      ospcommon::flush(socket);
+      if (streams.empty()) {
+        ospcommon::write(socket, mem, s);
+        ospcommon::flush(socket);
+        return;
+      }
+
+      const uint64_t size = s;
+      ospcommon::write(socket, &size, sizeof(size));
+      if (s < stripeSize) {
+        ospcommon::write(socket, mem, s);
+        ospcommon::flush(socket);
+        return;
+      }
+
+      std::vector<std::future<void>> stripes;
+      for (size_t i = 1; i <= streams.size(); ++i) {
+        stripes.push_back(std::async(std::launch::async,
+                                     &SocketFabric::sendStripe, this,
+                                     static_cast<const char*>(mem), s, i));
+      }
+      sendStripe(static_cast<const char*>(mem), s, 0);
+      // rethrows a disconnect of the streams
+      for (auto &stripe : stripes)
+        stripe.get();
     }
 
     size_t SocketFabric::read(void *&mem)
     {
-      const size_t s = ospcommon::read_some(socket, buffer.data(),
-          buffer.size());
+      if (streams.empty()) {
+        const size_t s = ospcommon::read_some(socket, buffer.data(),
+            buffer.size());
+        mem = buffer.data();
+        return s;
+      }
+
+      uint64_t size = 0;
+      ospcommon::read(socket, &size, sizeof(size));
+      if (buffer.size() < size)
+        buffer.resize(size);
       mem = buffer.data();
-      return s;
+
+      if (size < stripeSize) {
+        ospcommon::read(socket, buffer.data(), size);
+        return size;
+      }
+
+      std::vector<std::future<void>> stripes;
+      for (size_t i = 1; i <= streams.size(); ++i) {
+        stripes.push_back(std::async(std::launch::async,
+                                     &SocketFabric::readStripe, this,
+                                     buffer.data(), size, i));
+      }
+      readStripe(buffer.data(), size, 0);
+      for (auto &stripe : stripes)
+        stripe.get();
+      return size;
+    }
+
+    void SocketFabric::sendStripe(const char *mem, size_t size, size_t i)
+    {
+      const size_t numStripes = streams.size() + 1;
+      const size_t begin = i * (size / numStripes);
+      const size_t end = i + 1 == numStripes ? size : begin + size / numStripes;
+      auto s = i == 0 ? socket : streams[i - 1];
+      ospcommon::write(s, mem + begin, end - begin);
+      ospcommon::flush(s);
+    }
+
+    void SocketFabric::readStripe(char *mem, size_t size, size_t i)
+    {
+      const size_t numStripes = streams.size() + 1;
+      const size_t begin = i * (size / numStripes);
+      const size_t end = i + 1 == numStripes ? size : begin + size / numStripes;
+      ospcommon::read(i == 0 ? socket : streams[i - 1], mem + begin,
+                      end - begin);
     }
 
     // SocketListener definitions /////////////////////////////////////////////
@@ -92,7 +178,14 @@ namespace ospcommon {
 
     SocketFabric SocketListener::accept()
     {
-      return SocketFabric(ospcommon::listen(socket));
+      auto primary = ospcommon::listen(socket);
+      uint32_t numStreams = 1;
+      ospcommon::read(primary, &numStreams, sizeof(numStreams));
+
+      std::vector<ospcommon::socket_t> streams;
+      for (uint32_t i = 1; i < numStreams; ++i)
+        streams.push_back(ospcommon::listen(socket));
+      return SocketFabric(primary, std::move(streams));
     }
   }
 }
@@ -26,11 +26,17 @@
 namespace ospcommon {
   namespace networking {
 
-    /*! A fabrich which sends and receives over a TCP socket connection */
+    /*! A fabrich which sends and receives over a TCP socket connection.
+        With several streams, blocks of at least 'stripeSize' are split
+        over that many connections, sent and received in parallel, which
+        fills links with a high latency (e.g. over a WAN) much better
+        than one connection */
     struct OSPCOMMON_INTERFACE SocketFabric : public Fabric
     {
-      /*! Connecting to another socket on the host on the desired port */
-      SocketFabric(const std::string &hostname, const uint16_t port);
+      /*! Connecting to another socket on the host on the desired port,
+          with 'numStreams' connections */
+      SocketFabric(const std::string &hostname, const uint16_t port,
+                   const uint32_t numStreams = 1);
       ~SocketFabric() override;
       SocketFabric(SocketFabric &&other);
       SocketFabric& operator=(SocketFabric &&other);
@@ -47,14 +53,25 @@ namespace ospcommon {
         and give us size and pointer to this data */
       size_t read(void *&mem) override;
 
+      //! blocks of at least this size are striped over all streams
+      static constexpr size_t stripeSize = 1024 * 1024;
+
     private:
 
-      explicit SocketFabric(ospcommon::socket_t socket);
+      SocketFabric(ospcommon::socket_t socket,
+                   std::vector<ospcommon::socket_t> streams);
       friend struct SocketListener;
 
+      //! send/read the part of a striped block going over stream 'i'
+      void sendStripe(const char *mem, size_t size, size_t i);
+      void readStripe(char *mem, size_t size, size_t i);
+
       // Data //
 
       ospcommon::socket_t socket;
+      /*! the connections besides 'socket'. Only if there are any, the
+          blocks are preceded by their size, such that they can be split */
+      std::vector<ospcommon::socket_t> streams;
       std::vector<char> buffer;
     };
 
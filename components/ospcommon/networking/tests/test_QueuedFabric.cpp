@@ -0,0 +1,87 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "../../testing/catch.hpp"
+
+#include "../QueuedFabric.h"
+
+#include <chrono>
+#include <numeric>
+#include <thread>
+
+using namespace ospcommon;
+using namespace ospcommon::networking;
+
+// Helper types ///////////////////////////////////////////////////////////////
+
+//! remembers the blocks sent, slowly
+struct RecordingFabric : public Fabric
+{
+  RecordingFabric(std::vector<std::vector<byte_t>> &blocks) : blocks(blocks) {}
+
+  void send(const void *mem, size_t size) override
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto *bytes = static_cast<const byte_t*>(mem);
+    blocks.emplace_back(bytes, bytes + size);
+  }
+
+  size_t read(void *&) override { return 0; }
+
+  std::vector<std::vector<byte_t>> &blocks;
+};
+
+static std::vector<byte_t> makeBlock(size_t size, byte_t first)
+{
+  std::vector<byte_t> block(size);
+  std::iota(block.begin(), block.end(), first);
+  return block;
+}
+
+// Tests //////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Blocks are sent in order", "[all]")
+{
+  std::vector<std::vector<byte_t>> sent;
+  std::vector<std::vector<byte_t>> expected;
+  {
+    QueuedFabric fabric(
+        std::unique_ptr<Fabric>(new RecordingFabric(sent)), 64);
+    for (int i = 0; i < 10; ++i) {
+      // every third block is too large to be queued
+      auto block = makeBlock(i % 3 == 0 ? 100 : 10 + i, i);
+      expected.push_back(block);
+      fabric.send(block.data(), block.size());
+      // the caller may reuse its memory right away
+      std::fill(block.begin(), block.end(), 0);
+    }
+  }
+
+  REQUIRE(sent == expected);
+}
+
+TEST_CASE("Sync waits for the queued blocks", "[all]")
+{
+  std::vector<std::vector<byte_t>> sent;
+  QueuedFabric fabric(std::unique_ptr<Fabric>(new RecordingFabric(sent)));
+
+  auto block = makeBlock(16, 0);
+  for (int i = 0; i < 5; ++i)
+    fabric.send(block.data(), block.size());
+  fabric.sync();
+
+  REQUIRE(sent.size() == 5);
+}
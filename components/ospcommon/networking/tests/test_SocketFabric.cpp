@@ -0,0 +1,81 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "../../testing/catch.hpp"
+
+#include "../SocketFabric.h"
+
+#include <numeric>
+#include <thread>
+
+using namespace ospcommon;
+using namespace ospcommon::networking;
+
+// Helper functions ///////////////////////////////////////////////////////////
+
+static std::vector<byte_t> makeBlock(size_t size, byte_t first)
+{
+  std::vector<byte_t> block(size);
+  std::iota(block.begin(), block.end(), first);
+  return block;
+}
+
+//! sends the blocks from a client with 'numStreams' connections and checks
+//  they all arrive unchanged at the listening side
+static void checkRoundTrip(uint16_t port, uint32_t numStreams,
+                           const std::vector<size_t> &sizes)
+{
+  SocketListener listener(port);
+
+  std::thread client([&]() {
+    SocketFabric fabric("localhost", port, numStreams);
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      auto block = makeBlock(sizes[i], i);
+      fabric.send(block.data(), block.size());
+    }
+  });
+
+  SocketFabric fabric = listener.accept();
+  // the fabric may hand us the data in pieces of any size
+  std::vector<byte_t> expected;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    auto block = makeBlock(sizes[i], i);
+    expected.insert(expected.end(), block.begin(), block.end());
+  }
+
+  std::vector<byte_t> received;
+  while (received.size() < expected.size()) {
+    void *mem = nullptr;
+    const size_t n = fabric.read(mem);
+    auto *bytes = static_cast<byte_t*>(mem);
+    received.insert(received.end(), bytes, bytes + n);
+  }
+  REQUIRE(received == expected);
+  client.join();
+}
+
+// Tests //////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Blocks arrive unchanged over a single stream", "[all]")
+{
+  checkRoundTrip(31731, 1, {8, 100, 3 * SocketFabric::stripeSize});
+}
+
+TEST_CASE("Blocks arrive unchanged when striped over several streams", "[all]")
+{
+  checkRoundTrip(31732, 4, {8, 100, SocketFabric::stripeSize,
+                            3 * SocketFabric::stripeSize + 7, 16});
+}
@@ -453,3 +453,130 @@ namespace ospcommon
 }
 #endif
 
+
+////////////////////////////////////////////////////////////////////////////////
+/// NUMA Topology
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+#include <sched.h>
+#include <fstream>
+#endif
+
+namespace ospcommon
+{
+  struct NUMATopology
+  {
+    std::vector<std::vector<int>> nodeThreads;
+    std::vector<int> threadNode;
+    std::vector<int> spreadOrder;
+  };
+
+#ifdef __linux__
+  /*! parses a sysfs cpu list like "0-15,32-47" */
+  static std::vector<int> parseCPUList(const std::string &list)
+  {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+      int first = 0, last = 0;
+      const int n = sscanf(range.c_str(), "%d-%d", &first, &last);
+      if (n < 1)
+        continue;
+      if (n < 2)
+        last = first;
+      for (int c = first; c <= last; c++)
+        cpus.push_back(c);
+    }
+    return cpus;
+  }
+#endif
+
+  static NUMATopology loadNUMATopology()
+  {
+    NUMATopology topology;
+
+#ifdef __linux__
+    for (int node = 0; ; node++) {
+      std::ifstream file("/sys/devices/system/node/node"
+                         + std::to_string(node) + "/cpulist");
+      if (!file)
+        break;
+      std::string list;
+      std::getline(file, list);
+      topology.nodeThreads.push_back(parseCPUList(list));
+    }
+#endif
+
+    // without any information everything is on a single node
+    if (topology.nodeThreads.empty()) {
+      topology.nodeThreads.emplace_back();
+      for (size_t t = 0; t < getNumberOfLogicalThreads(); t++)
+        topology.nodeThreads[0].push_back(t);
+    }
+
+    for (size_t node = 0; node < topology.nodeThreads.size(); node++) {
+      for (int t : topology.nodeThreads[node]) {
+        if (t >= int(topology.threadNode.size()))
+          topology.threadNode.resize(t + 1, 0);
+        topology.threadNode[t] = node;
+      }
+    }
+
+    // round-robin over the nodes, taking their threads in order
+    for (size_t i = 0; ; i++) {
+      bool any = false;
+      for (const auto &threads : topology.nodeThreads) {
+        if (i < threads.size()) {
+          topology.spreadOrder.push_back(threads[i]);
+          any = true;
+        }
+      }
+      if (!any)
+        break;
+    }
+
+    return topology;
+  }
+
+  static const NUMATopology &numaTopology()
+  {
+    static const NUMATopology topology = loadNUMATopology();
+    return topology;
+  }
+
+  int getNumberOfNUMANodes()
+  {
+    return numaTopology().nodeThreads.size();
+  }
+
+  int getNUMANodeOfThread(int thread)
+  {
+    const auto &threadNode = numaTopology().threadNode;
+    return thread >= 0 && thread < int(threadNode.size()) ?
+      threadNode[thread] : 0;
+  }
+
+  std::vector<int> getThreadsOfNUMANode(int node)
+  {
+    const auto &nodeThreads = numaTopology().nodeThreads;
+    return node >= 0 && node < int(nodeThreads.size()) ?
+      nodeThreads[node] : std::vector<int>();
+  }
+
+  int getCurrentNUMANode()
+  {
+#ifdef __linux__
+    if (getNumberOfNUMANodes() > 1)
+      return getNUMANodeOfThread(sched_getcpu());
+#endif
+    return 0;
+  }
+
+  int getNUMASpreadThread(int index)
+  {
+    const auto &spreadOrder = numaTopology().spreadOrder;
+    return spreadOrder.empty() ? 0 : spreadOrder[index % spreadOrder.size()];
+  }
+}
@@ -26,6 +26,8 @@
 
 #include "common.h"
 
+#include <vector>
+
 namespace ospcommon
 {
   enum CPUModel {
@@ -109,6 +111,22 @@ namespace ospcommon
 
   /*! return the number of logical threads of the system */
   OSPCOMMON_INTERFACE size_t getNumberOfLogicalThreads();
+
+  /*! return the number of NUMA nodes of the system, 1 if unknown */
+  OSPCOMMON_INTERFACE int getNumberOfNUMANodes();
+
+  /*! return the NUMA node of the given logical thread, 0 if unknown */
+  OSPCOMMON_INTERFACE int getNUMANodeOfThread(int thread);
+
+  /*! return the logical threads of the given NUMA node */
+  OSPCOMMON_INTERFACE std::vector<int> getThreadsOfNUMANode(int node);
+
+  /*! return the NUMA node the calling thread is currently running on */
+  OSPCOMMON_INTERFACE int getCurrentNUMANode();
+
+  /*! return the logical thread for the i-th pinned worker thread, such that
+      consecutive workers alternate between the NUMA nodes */
+  OSPCOMMON_INTERFACE int getNUMASpreadThread(int index);
   
   /*! returns the size of the terminal window in characters */
   OSPCOMMON_INTERFACE int getTerminalWidth();
@@ -17,87 +17,254 @@
 #include "TaskSys.h"
 //ospray
 #include "../../platform.h"
+#include "../../sysinfo.h"
+#include "../../thread.h"
+#include "../../memory/malloc.h"
 //stl
+#include <deque>
+#include <memory>
+#include <new>
 #include <thread>
 #include <vector>
+#include <xmmintrin.h>
 
 namespace ospcommon {
   namespace tasking {
     namespace detail {
 
+      //! how often an idle thread looks for work before it goes to sleep
+      static constexpr int spinCount = 1024;
+
+      //! a range of the jobs of a task; what the threads pass around
+      struct JobRange
+      {
+        Task *task;
+        int begin;
+        int end;
+      };
+
+      /*! A Chase-Lev work-stealing deque of job ranges: the owning thread
+          pushes and pops at the bottom (newest first, which keeps nested
+          parallel_for's on the thread that started them), the other
+          threads steal from the top (the oldest and thus largest ranges).
+          The slots are atomics such that a steal racing with the owner is
+          well defined, the CAS on 'top' decides who gets a range. */
+      class WorkDeque
+      {
+      public:
+
+        //! false if the deque is full
+        bool push(const JobRange &range);
+        bool pop(JobRange &range);
+        //! may also fail if other threads take the range at the same time
+        bool steal(JobRange &range);
+
+      private:
+
+        static constexpr int64_t capacity = 1024;
+
+        void read(int64_t i, JobRange &range) const;
+
+        struct Slot
+        {
+          std::atomic<Task*> task;
+          std::atomic_int begin;
+          std::atomic_int end;
+        };
+
+        __aligned(64) std::atomic<int64_t> top {0};
+        __aligned(64) std::atomic<int64_t> bottom {0};
+        __aligned(64) Slot slots[capacity];
+      };
+
+      //! deletes the deques made by newWorkDeque
+      struct WorkDequeDeleter
+      {
+        void operator()(WorkDeque *deque) const
+        {
+          deque->~WorkDeque();
+          memory::alignedFree(deque);
+        }
+      };
+
+      //! plain new does not honor the alignment of WorkDeque in C++11
+      static WorkDeque *newWorkDeque()
+      {
+        void *mem =
+            memory::alignedMalloc(sizeof(WorkDeque), alignof(WorkDeque));
+        return new (mem) WorkDeque;
+      }
+
       struct TaskSys
       {
         TaskSys();
         ~TaskSys();
 
-        void  init(int maxNumRenderTasks);
+        void  init(int maxNumRenderTasks, bool pinThreads);
         void  createWorkerThreads(int numThreads);
-        Task *getNextActiveTask();
         void  shutdownWorkerThreads();
 
+        //! the deque of the calling thread, nullptr if none is left for it
+        WorkDeque *localDeque();
+        //! make the range available to all threads
+        void  push(const JobRange &range);
+        bool  getWork(WorkDeque *local, JobRange &range);
+        //! run the jobs of the range, splitting off parts for other threads
+        void  process(WorkDeque *local, JobRange range);
+        void  wakeWorker();
+
         // Data members //
 
         bool initialized {false};
-        bool running {false};
+        std::atomic<bool> running {false};
+        //! pin the workers to logical threads, spread over the NUMA nodes
+        bool pinThreads {false};
+        //! tells the threads whether the deques they got are still valid
+        int generation {0};
 
         static TaskSys global;
 
-        //! Queue of tasks that have ALREADY been acitvated, which are ready
-        __aligned(64) Task *volatile activeListFirst {nullptr};
-        __aligned(64) Task *volatile activeListLast  {nullptr};
+        /*! the deques of the worker threads, followed by the ones for other
+            threads which schedule tasks (e.g. the application's) */
+        std::vector<std::unique_ptr<WorkDeque, WorkDequeDeleter>> deques;
+        std::atomic<int> numDeques {0};
+        //! deques beyond the ones of the workers
+        static constexpr int numOtherDeques = 64;
+
+        //! tasks of threads without a deque, or with a full one
+        std::mutex __aligned(64) sharedMutex;
+        std::deque<JobRange> sharedQueue;
+        std::atomic<int> __aligned(64) sharedQueueSize {0};
 
-        std::mutex __aligned(64) mutex;
-        std::condition_variable __aligned(64) tasksAvailable;
+        //! the idle workers sleep until the epoch changes
+        std::mutex __aligned(64) sleepMutex;
+        std::condition_variable __aligned(64) wakeUp;
+        std::atomic<int> __aligned(64) numSleeping {0};
+        std::atomic<uint64_t> epoch {0};
 
         std::vector<std::thread> threads;
       };
 
+      //! the deque of the calling thread, in the given generation
+      struct LocalDeque
+      {
+        int generation {-1};
+        WorkDeque *deque {nullptr};
+        uint32_t seed {0};
+      };
+
+      static thread_local LocalDeque threadDeque;
+
+      // WorkDeque definitions ////////////////////////////////////////////////
+
+      inline bool WorkDeque::push(const JobRange &range)
+      {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= capacity)
+          return false;
+
+        Slot &slot = slots[b % capacity];
+        slot.task.store(range.task, std::memory_order_relaxed);
+        slot.begin.store(range.begin, std::memory_order_relaxed);
+        slot.end.store(range.end, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+      }
+
+      inline bool WorkDeque::pop(JobRange &range)
+      {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+          bottom.store(b + 1, std::memory_order_relaxed);
+          return false;
+        }
+
+        read(b, range);
+        if (t == b) {
+          // the last range, race the thieves for it
+          const bool won = top.compare_exchange_strong(t, t + 1,
+              std::memory_order_seq_cst, std::memory_order_relaxed);
+          bottom.store(b + 1, std::memory_order_relaxed);
+          return won;
+        }
+        return true;
+      }
+
+      inline bool WorkDeque::steal(JobRange &range)
+      {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+          return false;
+
+        read(t, range);
+        return top.compare_exchange_strong(t, t + 1,
+            std::memory_order_seq_cst, std::memory_order_relaxed);
+      }
+
+      inline void WorkDeque::read(int64_t i, JobRange &range) const
+      {
+        const Slot &slot = slots[i % capacity];
+        range.task = slot.task.load(std::memory_order_relaxed);
+        range.begin = slot.begin.load(std::memory_order_relaxed);
+        range.end = slot.end.load(std::memory_order_relaxed);
+      }
+
       // Task definitions /////////////////////////////////////////////////////
 
       Task::Task(bool needsToBeDeleted)
       : numJobsCompleted(),
-        numJobsStarted(),
         willNeedToBeDeleted(needsToBeDeleted)
       {
       }
 
-      void Task::workOnIt()
+      void Task::jobsCompleted(int numJobs)
       {
-        int myCompleted = 0;
-
-        while (true) {
-          const int thisJobID = numJobsStarted++;
-
-          if (thisJobID >= numJobsInTask)
-            break;
+        if ((numJobsCompleted += numJobs) != numJobsInTask)
+          return;
 
-          run(thisJobID);
-          ++myCompleted;
-        }
-
-        if (myCompleted != 0) {
-          const int nowCompleted = (numJobsCompleted += myCompleted);
-          if (nowCompleted == numJobsInTask) {
-            {
-              SCOPED_LOCK(mutex);
-              status = Task::COMPLETED;
-              allJobsCompletedCond.notify_all();
-            }
-            if (willNeedToBeDeleted)
-              delete this;
-          }
+        // a waiting thread may destroy the task as soon as it is unlocked
+        const bool deleteTask = willNeedToBeDeleted;
+        {
+          SCOPED_LOCK(mutex);
+          status = Task::COMPLETED;
+          allJobsCompletedCond.notify_all();
         }
+        if (deleteTask)
+          delete this;
       }
 
       void Task::wait()
       {
-        if (status == Task::COMPLETED)
-          return;
-
-        this->workOnIt();
+        TaskSys &sys = TaskSys::global;
+        WorkDeque *local = sys.localDeque();
+
+        // help with any work (e.g. of the jobs of a nested parallel_for)
+        // until the task completed, sleeping once there is nothing left
+        int idle = 0;
+        while (status != Task::COMPLETED) {
+          JobRange range;
+          if (sys.getWork(local, range)) {
+            sys.process(local, range);
+            idle = 0;
+          } else if (++idle < spinCount) {
+            _mm_pause();
+          } else {
+            std::unique_lock<std::mutex> lock(mutex);
+            allJobsCompletedCond.wait(lock,
+                                      [&](){return status==Task::COMPLETED;});
+          }
+        }
 
-        std::unique_lock<std::mutex> lock(mutex);
-        allJobsCompletedCond.wait(lock, [&](){return status==Task::COMPLETED;});
+        // the thread completing the task may still be notifying
+        SCOPED_LOCK(mutex);
       }
 
       // TaskSys definitions //////////////////////////////////////////////////
@@ -107,7 +274,7 @@ namespace ospcommon {
       inline TaskSys::TaskSys()
       {
     #ifdef OSPRAY_TASKING_INTERNAL
-        init(-1);
+        init(-1, false);
     #endif
       }
 
@@ -116,13 +283,14 @@ namespace ospcommon {
         shutdownWorkerThreads();
       }
 
-      inline void TaskSys::init(int numThreads)
+      inline void TaskSys::init(int numThreads, bool pin)
       {
         if (initialized)
           shutdownWorkerThreads();
 
         initialized = true;
         running     = true;
+        pinThreads  = pin;
 
         if (numThreads >= 0) {
           numThreads = std::min(numThreads,
@@ -136,49 +304,156 @@ namespace ospcommon {
 
       inline void TaskSys::createWorkerThreads(int numThreads)
       {
-        for (int t = 1; t < numThreads; t++) {
-          threads.emplace_back([&](){
-            while (true) {
-              Task *task = getNextActiveTask();
-              if (!running)
-                break;
-              if(task == nullptr)
+        // at least one worker, such that fire-and-forget tasks make progress
+        const int numWorkers = std::max(numThreads - 1, 1);
+
+        ++generation;
+        deques.clear();
+        for (int i = 0; i < numWorkers + numOtherDeques; i++)
+          deques.emplace_back(newWorkDeque());
+        numDeques = numWorkers;
+
+        for (int t = 0; t < numWorkers; t++) {
+          threads.emplace_back([this, t](){
+            // the calling thread is expected to take the first slot
+            if (pinThreads)
+              setAffinity(getNUMASpreadThread(t + 1));
+
+            threadDeque.generation = generation;
+            threadDeque.deque = deques[t].get();
+            threadDeque.seed = t + 1;
+            WorkDeque *local = threadDeque.deque;
+
+            int idle = 0;
+            while (running) {
+              JobRange range;
+              if (getWork(local, range)) {
+                process(local, range);
+                idle = 0;
+                continue;
+              }
+
+              if (++idle < spinCount) {
+                _mm_pause();
                 continue;
-              task->workOnIt();
+              }
+
+              // announce going to sleep before looking for work a last
+              // time, such that a thread pushing work then wakes us up
+              const uint64_t seenEpoch = epoch;
+              ++numSleeping;
+              if (getWork(local, range)) {
+                --numSleeping;
+                process(local, range);
+                idle = 0;
+                continue;
+              }
+
+              {
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                wakeUp.wait(lock, [&](){
+                  return epoch != seenEpoch || !running;
+                });
+              }
+              --numSleeping;
+              idle = 0;
             }
           });
         }
       }
 
-      inline Task *TaskSys::getNextActiveTask()
+      inline WorkDeque *TaskSys::localDeque()
       {
-        while (true) {
-          std::unique_lock<std::mutex> lock(mutex);
-          tasksAvailable.wait(lock, [&](){
-            return !(activeListFirst == nullptr && running);
-          });
+        if (threadDeque.generation != generation) {
+          threadDeque.generation = generation;
+          const int i = numDeques++;
+          threadDeque.deque = i < int(deques.size()) ? deques[i].get() : nullptr;
+          threadDeque.seed = i + 1;
+        }
+        return threadDeque.deque;
+      }
 
-          if (!running)
-            return nullptr;
+      inline void TaskSys::push(const JobRange &range)
+      {
+        WorkDeque *local = localDeque();
+        if (!local || !local->push(range)) {
+          SCOPED_LOCK(sharedMutex);
+          sharedQueue.push_back(range);
+          ++sharedQueueSize;
+        }
+        wakeWorker();
+      }
 
-          Task *front = activeListFirst;
-          if (front->numJobsStarted >= front->numJobsInTask) {
-            if (activeListFirst == activeListLast)
-              activeListFirst = activeListLast = nullptr;
-            else
-              activeListFirst = activeListFirst->next;
+      inline bool TaskSys::getWork(WorkDeque *local, JobRange &range)
+      {
+        if (local && local->pop(range))
+          return true;
+
+        // steal from the other threads, starting at a random one
+        const int n = std::min(int(numDeques), int(deques.size()));
+        uint32_t &seed = threadDeque.seed;
+        seed = seed * 1664525u + 1013904223u;
+        const int first = n > 0 ? (seed >> 8) % n : 0;
+        for (int i = 0; i < n; i++) {
+          WorkDeque *victim = deques[(first + i) % n].get();
+          if (victim != local && victim->steal(range))
+            return true;
+        }
 
-            continue;
+        if (sharedQueueSize > 0) {
+          SCOPED_LOCK(sharedMutex);
+          if (!sharedQueue.empty()) {
+            range = sharedQueue.front();
+            sharedQueue.pop_front();
+            --sharedQueueSize;
+            return true;
           }
+        }
+
+        return false;
+      }
 
-          return front;
+      inline void TaskSys::process(WorkDeque *local, JobRange range)
+      {
+        // split off the upper halves for other threads to steal, down to
+        // a few ranges per thread
+        const int numThreads = int(threads.size()) + 1;
+        const int grainSize =
+            std::max(1, range.task->numJobsInTask / (8 * numThreads));
+        while (local && range.end - range.begin > grainSize) {
+          const int mid = range.begin + (range.end - range.begin) / 2;
+          if (!local->push({range.task, mid, range.end}))
+            break;
+          wakeWorker();
+          range.end = mid;
         }
+
+        for (int i = range.begin; i < range.end; i++)
+          range.task->run(i);
+        range.task->jobsCompleted(range.end - range.begin);
+      }
+
+      inline void TaskSys::wakeWorker()
+      {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (numSleeping == 0)
+          return;
+
+        {
+          SCOPED_LOCK(sleepMutex);
+          ++epoch;
+        }
+        wakeUp.notify_one();
       }
 
       inline void TaskSys::shutdownWorkerThreads()
       {
-        running = false;
-        tasksAvailable.notify_all();
+        {
+          SCOPED_LOCK(sleepMutex);
+          running = false;
+          ++epoch;
+        }
+        wakeUp.notify_all();
         for (auto &thread : threads)
           thread.join();
         threads.clear();
@@ -186,9 +461,9 @@ namespace ospcommon {
 
       // Interface definitions ////////////////////////////////////////////////
 
-      void initTaskSystemInternal(int maxNumRenderTasks)
+      void initTaskSystemInternal(int maxNumRenderTasks, bool setAffinity)
       {
-        TaskSys::global.init(maxNumRenderTasks);
+        TaskSys::global.init(maxNumRenderTasks, setAffinity);
       }
 
       int OSPCOMMON_INTERFACE numThreadsTaskSystemInternal()
@@ -198,29 +473,17 @@ namespace ospcommon {
 
       void scheduleTaskInternal(Task *task,
                                 int numJobs,
-                                ScheduleOrder order)
+                                ScheduleOrder)
       {
         task->numJobsInTask = numJobs;
-        task->status = Task::SCHEDULED;
-
-        SCOPED_LOCK(TaskSys::global.mutex);
-        bool wasEmpty = TaskSys::global.activeListFirst == nullptr;
-        if (wasEmpty) {
-          TaskSys::global.activeListFirst=TaskSys::global.activeListLast=task;
-          task->next = nullptr;
-          TaskSys::global.tasksAvailable.notify_all();
-        } else {
-          if (order == BACK_OF_QUEUE) {
-            task->next = nullptr;
-            TaskSys::global.activeListLast->next = task;
-            TaskSys::global.activeListLast = task;
-          } else {
-            task->next = TaskSys::global.activeListFirst;
-            TaskSys::global.activeListFirst = task;
-          }
+        task->status = Task::ACTIVE;
+
+        if (numJobs <= 0) {
+          task->jobsCompleted(0);
+          return;
         }
 
-        task->status = Task::ACTIVE;
+        TaskSys::global.push({task, 0, numJobs});
       }
 
     } // ::ospcommon::tasking::detail
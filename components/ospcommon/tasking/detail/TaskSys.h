@@ -26,6 +26,9 @@ namespace ospcommon {
   namespace tasking {
     namespace detail {
 
+      /*! Both orders put the task onto the work-stealing deque of the
+          scheduling thread, which works on its newest tasks first, while
+          idle threads steal its oldest ones. */
       enum ScheduleOrder
       {
         /*! schedule job to the END of the job queue, meaning it'll get
@@ -46,8 +49,8 @@ namespace ospcommon {
         // interface for scheduling a new task into the task system
         // ------------------------------------------------------------------
 
-        //! wait for the task to complete, optionally (by default) helping
-        //! to actually work on completing this task.
+        //! wait for the task to complete, meanwhile working on the jobs of
+        //! this (or any other) task
         void wait();
 
         // ------------------------------------------------------------------
@@ -60,22 +63,20 @@ namespace ospcommon {
         // internal data for the tasking systme to manage the task
         // ------------------------------------------------------------------
 
-        //! work on task until no more useful job available on this task
-        void workOnIt();
+        //! count 'numJobs' more jobs as done, completing the task with the
+        //! last ones
+        void jobsCompleted(int numJobs);
 
         // Data members //
 
         __aligned(64) std::atomic_int numJobsCompleted;
-        __aligned(64) std::atomic_int numJobsStarted;
         int numJobsInTask {0};
 
         enum Status { INITIALIZING, SCHEDULED, ACTIVE, COMPLETED };
         std::mutex __aligned(64) mutex;
-        Status volatile __aligned(64) status {INITIALIZING};
-        std::condition_variable __aligned(64) allDependenciesFulfilledCond;
+        std::atomic<Status> __aligned(64) status {INITIALIZING};
         std::condition_variable __aligned(64) allJobsCompletedCond;
 
-        __aligned(64) Task *volatile next;
         bool willNeedToBeDeleted {true};
       };
 
@@ -85,9 +86,12 @@ namespace ospcommon {
           tasks.
 
           numThreads==-1 means 'use all that are available; numThreads=0
-          means 'no worker thread, assume that whoever calls wait() will
-          do the work */
-      void OSPCOMMON_INTERFACE initTaskSystemInternal(int numThreads = -1);
+          means 'a single worker thread (for scheduled tasks), assume that
+          whoever calls wait() will do the work'. With setAffinity the
+          workers get pinned to logical threads, spread over the NUMA
+          nodes */
+      void OSPCOMMON_INTERFACE initTaskSystemInternal(int numThreads = -1,
+                                                      bool setAffinity = false);
 
       int OSPCOMMON_INTERFACE numThreadsTaskSystemInternal();
 
@@ -16,10 +16,19 @@
 
 #pragma once
 
+#include "../tasking_system_handle.h"
+#include "../../box.h"
+
+#include <algorithm>
+#include <thread>
 #include <utility>
 
 #ifdef OSPRAY_TASKING_TBB
+#  include <tbb/blocked_range.h>
+#  include <tbb/blocked_range2d.h>
+#  include <tbb/blocked_range3d.h>
 #  include <tbb/parallel_for.h>
+#  include <tbb/partitioner.h>
 #elif defined(OSPRAY_TASKING_CILK)
 #  include <cilk/cilk.h>
 #elif defined(OSPRAY_TASKING_INTERNAL)
@@ -30,6 +39,17 @@
 
 namespace ospcommon {
   namespace tasking {
+
+    //! how a blocked parallel_for() distributes the blocks over the threads
+    enum class Partitioning
+    {
+      //! blocks are handed out on demand, balancing uneven work
+      DYNAMIC,
+      //! each thread gets one contiguous share of the blocks, with the
+      //! least scheduling overhead for even work
+      STATIC
+    };
+
     namespace detail {
 
 #if defined(OSPRAY_TASKING_LIBDISPATCH)
@@ -70,6 +90,127 @@ namespace ospcommon {
 #endif
       }
 
+      //! run fcn(blockIndex) for all numBlocks blocks
+      template<typename TASK_T>
+      inline void parallel_for_blocks(size_t numBlocks,
+                                      Partitioning partitioning,
+                                      const TASK_T &fcn)
+      {
+        if (partitioning == Partitioning::DYNAMIC) {
+          parallel_for_impl(numBlocks, fcn);
+          return;
+        }
+
+        int numThreads = numTaskingThreads();
+        if (numThreads <= 0)
+          numThreads = std::thread::hardware_concurrency();
+        const size_t numChunks = std::min(numBlocks,
+                                          size_t(std::max(numThreads, 1)));
+        parallel_for_impl(numChunks, [&](size_t chunk) {
+          const size_t begin = numBlocks * chunk / numChunks;
+          const size_t end   = numBlocks * (chunk + 1) / numChunks;
+          for (size_t b = begin; b < end; b++)
+            fcn(b);
+        });
+      }
+
+      template<typename INDEX_T, typename TASK_T>
+      inline void parallel_for_blocked_impl(INDEX_T nTasks,
+                                            INDEX_T grainSize,
+                                            Partitioning partitioning,
+                                            const TASK_T &fcn)
+      {
+        if (nTasks <= 0)
+          return;
+
+        grainSize = std::max(grainSize, INDEX_T(1));
+#ifdef OSPRAY_TASKING_TBB
+        if (partitioning == Partitioning::DYNAMIC) {
+          tbb::parallel_for(tbb::blocked_range<INDEX_T>(0, nTasks, grainSize),
+                            [&](const tbb::blocked_range<INDEX_T> &r) {
+                              fcn(r.begin(), r.end());
+                            }, tbb::simple_partitioner());
+          return;
+        }
+#endif
+        const size_t numBlocks = (nTasks + grainSize - 1) / grainSize;
+        parallel_for_blocks(numBlocks, partitioning, [&](size_t b) {
+          const INDEX_T begin = INDEX_T(b) * grainSize;
+          fcn(begin, std::min(begin + grainSize, nTasks));
+        });
+      }
+
+      template<typename TASK_T>
+      inline void parallel_for_blocked_impl(const vec2i &size,
+                                            vec2i grainSize,
+                                            Partitioning partitioning,
+                                            const TASK_T &fcn)
+      {
+        if (size.x <= 0 || size.y <= 0)
+          return;
+
+        grainSize = max(grainSize, vec2i(1));
+#ifdef OSPRAY_TASKING_TBB
+        if (partitioning == Partitioning::DYNAMIC) {
+          using range_t = tbb::blocked_range2d<int>;
+          tbb::parallel_for(range_t(0, size.y, grainSize.y,
+                                    0, size.x, grainSize.x),
+                            [&](const range_t &r) {
+                              fcn(box2i(vec2i(r.cols().begin(),
+                                              r.rows().begin()),
+                                        vec2i(r.cols().end(),
+                                              r.rows().end())));
+                            }, tbb::simple_partitioner());
+          return;
+        }
+#endif
+        const vec2i numBlocks = divRoundUp(size, grainSize);
+        parallel_for_blocks(size_t(numBlocks.x) * numBlocks.y, partitioning,
+                            [&](size_t b) {
+          const vec2i lower = vec2i(b % numBlocks.x, b / numBlocks.x)
+                              * grainSize;
+          fcn(box2i(lower, min(lower + grainSize, size)));
+        });
+      }
+
+      template<typename TASK_T>
+      inline void parallel_for_blocked_impl(const vec3i &size,
+                                            vec3i grainSize,
+                                            Partitioning partitioning,
+                                            const TASK_T &fcn)
+      {
+        if (size.x <= 0 || size.y <= 0 || size.z <= 0)
+          return;
+
+        grainSize = max(grainSize, vec3i(1));
+#ifdef OSPRAY_TASKING_TBB
+        if (partitioning == Partitioning::DYNAMIC) {
+          using range_t = tbb::blocked_range3d<int>;
+          tbb::parallel_for(range_t(0, size.z, grainSize.z,
+                                    0, size.y, grainSize.y,
+                                    0, size.x, grainSize.x),
+                            [&](const range_t &r) {
+                              fcn(box3i(vec3i(r.cols().begin(),
+                                              r.rows().begin(),
+                                              r.pages().begin()),
+                                        vec3i(r.cols().end(),
+                                              r.rows().end(),
+                                              r.pages().end())));
+                            }, tbb::simple_partitioner());
+          return;
+        }
+#endif
+        const vec3i numBlocks = divRoundUp(size, grainSize);
+        const size_t sliceBlocks = size_t(numBlocks.x) * numBlocks.y;
+        parallel_for_blocks(sliceBlocks * numBlocks.z, partitioning,
+                            [&](size_t b) {
+          const vec3i lower = vec3i(b % numBlocks.x,
+                                    (b / numBlocks.x) % numBlocks.y,
+                                    b / sliceBlocks) * grainSize;
+          fcn(box3i(lower, min(lower + grainSize, size)));
+        });
+      }
+
     } // ::ospcommon::tasking::detail
   } // ::ospcommon::tasking
 } // ::ospcommon
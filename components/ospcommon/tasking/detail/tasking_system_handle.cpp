@@ -20,6 +20,7 @@
 #if defined(OSPRAY_TASKING_TBB)
 # include <tbb/task_arena.h>
 # include <tbb/task_scheduler_init.h>
+# include <tbb/task_scheduler_observer.h>
 #elif defined(OSPRAY_TASKING_CILK)
 # include <cilk/cilk_api.h>
 #elif defined(OSPRAY_TASKING_OMP)
@@ -28,17 +29,36 @@
 # include "TaskSys.h"
 #endif
 
+#include <atomic>
 #include <thread>
 
 #include "../../intrinsics.h"
 #include "../../common.h"
+#include "../../sysinfo.h"
+#include "../../thread.h"
 
 namespace ospcommon {
   namespace tasking {
 
+#if defined(OSPRAY_TASKING_TBB)
+    //! pins each thread entering the scheduler to the next logical thread
+    struct affinity_observer : public tbb::task_scheduler_observer
+    {
+      affinity_observer() { observe(true); }
+      ~affinity_observer() { observe(false); }
+
+      void on_scheduler_entry(bool) override
+      {
+        setAffinity(getNUMASpreadThread(nextThread++));
+      }
+
+      std::atomic<int> nextThread {0};
+    };
+#endif
+
     struct tasking_system_handle
     {
-      tasking_system_handle(int numThreads) :
+      tasking_system_handle(int numThreads, bool setAffinity) :
         numThreads(numThreads)
 #if defined(OSPRAY_TASKING_TBB)
         , tbb_init(numThreads)
@@ -49,7 +69,18 @@ namespace ospcommon {
 #elif defined(OSPRAY_TASKING_OMP)
          if (numThreads > 0) omp_set_num_threads(numThreads);
 #elif defined(OSPRAY_TASKING_INTERNAL)
-         detail::initTaskSystemInternal(numThreads < 0 ? -1 : numThreads);
+         detail::initTaskSystemInternal(numThreads < 0 ? -1 : numThreads,
+                                        setAffinity);
+#endif
+        setAffinityObserver(setAffinity);
+      }
+
+      void setAffinityObserver(bool setAffinity)
+      {
+#if defined(OSPRAY_TASKING_TBB)
+        tbb_affinity.reset(setAffinity ? new affinity_observer : nullptr);
+#else
+        UNUSED(setAffinity);
 #endif
       }
 
@@ -80,25 +111,30 @@ namespace ospcommon {
       int numThreads {-1};
 #if defined(OSPRAY_TASKING_TBB)
       tbb::task_scheduler_init tbb_init;
+      std::unique_ptr<affinity_observer> tbb_affinity;
 #endif
     };
 
     static std::unique_ptr<tasking_system_handle> g_tasking_handle;
 
-    void initTaskingSystem(int numThreads)
+    void initTaskingSystem(int numThreads, bool setAffinity)
     {
       _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
       _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
 
 #if defined(OSPRAY_TASKING_TBB)
       if (!g_tasking_handle.get())
-        g_tasking_handle = make_unique<tasking_system_handle>(numThreads);
+        g_tasking_handle = make_unique<tasking_system_handle>(numThreads,
+                                                              setAffinity);
       else {
+        g_tasking_handle->setAffinityObserver(false);
         g_tasking_handle->tbb_init.terminate();
         g_tasking_handle->tbb_init.initialize(numThreads);
+        g_tasking_handle->setAffinityObserver(setAffinity);
       }
 #else
-      g_tasking_handle = make_unique<tasking_system_handle>(numThreads);
+      g_tasking_handle = make_unique<tasking_system_handle>(numThreads,
+                                                            setAffinity);
 #endif
     }
 
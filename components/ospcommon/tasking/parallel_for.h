@@ -44,6 +44,46 @@ namespace ospcommon {
       detail::parallel_for_impl(nTasks, std::forward<TASK_T>(fcn));
     }
 
+    /* NOTE - Blocked versions of parallel_for(): the index space [0,nTasks)
+       (resp. [0,size) in 2D/3D) is split into blocks of at most grainSize
+       items (per dimension), passed as fcn(begin, end) resp. as
+       fcn(const box2i &) or fcn(const box3i &), with exclusive upper
+       bounds. Iterating over a block within fcn keeps the accesses cache
+       friendly and amortizes the scheduling overhead over the block. */
+    template<typename INDEX_T, typename GRAIN_T, typename TASK_T>
+    inline void parallel_for(INDEX_T nTasks,
+                             GRAIN_T grainSize,
+                             TASK_T&& fcn,
+                             Partitioning partitioning = Partitioning::DYNAMIC)
+    {
+      using namespace traits;
+      static_assert(is_valid_index<INDEX_T>::value,
+                    "ospcommon::tasking::parallel_for() requires the type"
+                    " INDEX_T to be unsigned char, short, int, uint, long,"
+                    " long long, or size_t.");
+
+      detail::parallel_for_blocked_impl(nTasks, INDEX_T(grainSize),
+                                        partitioning, fcn);
+    }
+
+    template<typename TASK_T>
+    inline void parallel_for(const vec2i &size,
+                             const vec2i &grainSize,
+                             TASK_T&& fcn,
+                             Partitioning partitioning = Partitioning::DYNAMIC)
+    {
+      detail::parallel_for_blocked_impl(size, grainSize, partitioning, fcn);
+    }
+
+    template<typename TASK_T>
+    inline void parallel_for(const vec3i &size,
+                             const vec3i &grainSize,
+                             TASK_T&& fcn,
+                             Partitioning partitioning = Partitioning::DYNAMIC)
+    {
+      detail::parallel_for_blocked_impl(size, grainSize, partitioning, fcn);
+    }
+
     // NOTE(jda) - Allow serial version of parallel_for() without the need to
     //             change the entire tasking system backend
     template<typename INDEX_T, typename TASK_T>
@@ -21,7 +21,11 @@
 namespace ospcommon {
   namespace tasking {
 
-    void OSPCOMMON_INTERFACE initTaskingSystem(int numThreads = -1);
+    /*! setAffinity pins the threads of the tasking system to logical
+        threads, spread over the NUMA nodes (only supported by the TBB and
+        internal tasking systems) */
+    void OSPCOMMON_INTERFACE initTaskingSystem(int numThreads = -1,
+                                               bool setAffinity = false);
     int  OSPCOMMON_INTERFACE numTaskingThreads();
     void OSPCOMMON_INTERFACE deAffinitizeCores();
 
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <vector>
 
+using namespace ospcommon;
 using ospcommon::tasking::parallel_for;
 
 TEST_CASE("parallel_for")
@@ -40,3 +41,45 @@ TEST_CASE("parallel_for")
 
   REQUIRE(found == v.end());
 }
+
+TEST_CASE("nested parallel_for")
+{
+  const int N_OUTER = 64;
+  const int N_INNER = 1000;
+
+  std::vector<int> v(N_OUTER * N_INNER, 0);
+
+  parallel_for(N_OUTER, [&](int i) {
+    parallel_for(N_INNER, [&](int j) {
+      v[i * N_INNER + j]++;
+    });
+  });
+
+  auto found = std::find_if(v.begin(), v.end(), [](int x){ return x != 1; });
+
+  REQUIRE(found == v.end());
+}
+
+TEST_CASE("blocked parallel_for")
+{
+  using ospcommon::tasking::Partitioning;
+
+  const vec3i size(37, 21, 13);
+  const vec3i grain(8, 4, 5);
+
+  for (auto partitioning : {Partitioning::DYNAMIC, Partitioning::STATIC}) {
+    std::vector<int> v(size.product(), 0);
+
+    parallel_for(size, grain, [&](const box3i &block) {
+      REQUIRE(block.size().x <= grain.x);
+      for (int z = block.lower.z; z < block.upper.z; z++)
+        for (int y = block.lower.y; y < block.upper.y; y++)
+          for (int x = block.lower.x; x < block.upper.x; x++)
+            v[x + size.x * (y + size.y * z)]++;
+    }, partitioning);
+
+    auto found = std::find_if(v.begin(), v.end(), [](int x){ return x != 1; });
+
+    REQUIRE(found == v.end());
+  }
+}
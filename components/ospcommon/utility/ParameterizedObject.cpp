@@ -17,44 +17,71 @@
 #include "ParameterizedObject.h"
 
 #include <algorithm>
+#include <cstring>
 
 namespace ospcommon {
   namespace utility {
 
-    ParameterizedObject::Param::Param(const std::string &_name) : name(_name)
+    ParameterizedObject::Param::Param(const std::string &_name)
+      : name(_name), hash(ParamName::strHash(_name.c_str()))
     {
     }
 
-    void ParameterizedObject::removeParam(const std::string &name)
+    void ParameterizedObject::removeParam(const ParamName &name)
     {
       auto foundParam =
           std::find_if(paramList.begin(), paramList.end(),
             [&](const std::shared_ptr<Param> &p) {
-              return p->name == name;
+              return p->hash == name.hash && p->name == name.str;
             });
 
       if (foundParam != paramList.end()) {
         paramList.erase(foundParam);
+        // indices past the removed param shifted, removal is rare enough
+        rebuildParamIndex(paramIndex.size());
       }
     }
 
     ParameterizedObject::Param *
-    ParameterizedObject::findParam(const std::string &name, bool addIfNotExist)
+    ParameterizedObject::findParam(const ParamName &name, bool addIfNotExist)
     {
-      auto foundParam =
-          std::find_if(paramList.begin(), paramList.end(),
-            [&](const std::shared_ptr<Param> &p) {
-              return p->name == name;
-            });
+      const size_t mask = paramIndex.size() - 1;
+      size_t slot = name.hash & mask;
 
-      if (foundParam != paramList.end())
-        return foundParam->get();
-      else if (addIfNotExist) {
-        paramList.push_back(std::make_shared<Param>(name));
-        return paramList[paramList.size()-1].get();
+      if (!paramIndex.empty()) {
+        while (paramIndex[slot] != 0) {
+          Param *p = paramList[paramIndex[slot] - 1].get();
+          if (p->hash == name.hash && p->name.size() == name.length &&
+              std::memcmp(p->name.data(), name.str, name.length) == 0)
+            return p;
+          slot = (slot + 1) & mask;
+        }
       }
-      else
+
+      if (!addIfNotExist)
         return nullptr;
+
+      paramList.push_back(
+          std::make_shared<Param>(std::string(name.str, name.length)));
+
+      if (2 * paramList.size() > paramIndex.size())
+        rebuildParamIndex(std::max<size_t>(16, 2 * paramIndex.size()));
+      else
+        paramIndex[slot] = paramList.size();
+
+      return paramList.back().get();
+    }
+
+    void ParameterizedObject::rebuildParamIndex(size_t indexSize)
+    {
+      paramIndex.assign(indexSize, 0);
+      const size_t mask = indexSize - 1;
+      for (size_t i = 0; i < paramList.size(); ++i) {
+        size_t slot = paramList[i]->hash & mask;
+        while (paramIndex[slot] != 0)
+          slot = (slot + 1) & mask;
+        paramIndex[slot] = i + 1;
+      }
     }
 
     std::shared_ptr<ParameterizedObject::Param> *
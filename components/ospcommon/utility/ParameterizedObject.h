@@ -17,6 +17,8 @@
 #pragma once
 
 // stl
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 // ospcommon
 #include "Any.h"
@@ -24,6 +26,44 @@
 namespace ospcommon {
   namespace utility {
 
+    /*! \brief the name of a parameter together with its hash, such that
+        lookups neither need to build a std::string nor compare every name
+
+        Constructing it from a string literal is constexpr, thus the hash
+        of the names used at call sites gets folded at compile time. It
+        does not own the characters, so only use it as a temporary. */
+    struct ParamName
+    {
+      template <size_t N>
+      constexpr ParamName(const char (&s)[N])
+        : str(s), length(strLength(s)), hash(strHash(s)) {}
+
+      template <typename T, typename = typename std::enable_if<
+                  std::is_convertible<T, const char *>::value &&
+                  !std::is_array<T>::value>::type>
+      ParamName(const T &s)
+        : str(s), length(strLength(str)), hash(strHash(str)) {}
+
+      ParamName(const std::string &s)
+        : str(s.c_str()), length(s.size()), hash(strHash(str)) {}
+
+      //! 64-bit FNV-1a of a null-terminated string
+      static constexpr uint64_t strHash(const char *s,
+                                        uint64_t h = 0xcbf29ce484222325ull)
+      {
+        return *s ? strHash(s + 1, (h ^ uint8_t(*s)) * 0x100000001b3ull) : h;
+      }
+
+      static constexpr size_t strLength(const char *s, size_t n = 0)
+      {
+        return s[n] ? strLength(s, n + 1) : n;
+      }
+
+      const char *str;
+      size_t      length;
+      uint64_t    hash;
+    };
+
     /*! \brief defines a basic object whose lifetime is managed by ospray */
     struct OSPCOMMON_INTERFACE ParameterizedObject
     {
@@ -44,26 +84,29 @@ namespace ospcommon {
 
         /*! name under which this parameter is registered */
         std::string name;
+
+        /*! ParamName::strHash() of the name */
+        uint64_t hash;
       };
 
       /*! \brief check if a given parameter is available */
-      bool hasParam(const std::string &name);
+      bool hasParam(const ParamName &name);
 
       /*! set a parameter with given name to given value, create param if not
        *  existing */
       template<typename T>
-      void setParam(const std::string &name, const T &t);
+      void setParam(const ParamName &name, const T &t);
 
       template<typename T>
-      T getParam(const std::string &name, T valIfNotFound);
+      T getParam(const ParamName &name, T valIfNotFound);
 
-      void removeParam(const std::string &name);
+      void removeParam(const ParamName &name);
 
     protected:
 
       /*! \brief find a given parameter, or add it if not exists (and so
        *         specified) */
-      Param *findParam(const std::string &name, bool addIfNotExist = false);
+      Param *findParam(const ParamName &name, bool addIfNotExist = false);
 
       /*! enumerate parameters */
       std::shared_ptr<Param> *params_begin();
@@ -79,24 +122,33 @@ namespace ospcommon {
       //             destruction of each copy should only result in freeing the
       //             parameters *once*
       std::vector<std::shared_ptr<Param>> paramList;
+
+      /*! \brief open-addressed (linear probing) hash index into paramList,
+          storing 'index + 1' such that 0 marks an empty slot; its size is
+          a power of two and kept at least twice the number of params */
+      std::vector<uint32_t> paramIndex;
+
+      /*! \brief (re-)insert all of paramList into a paramIndex of size
+          'indexSize' */
+      void rebuildParamIndex(size_t indexSize);
     };
 
     // Inlined ParameterizedObject definitions //////////////////////////////////
 
-    inline bool ParameterizedObject::hasParam(const std::string &name)
+    inline bool ParameterizedObject::hasParam(const ParamName &name)
     {
       return findParam(name, false) != nullptr;
     }
 
     template<typename T>
-    inline void ParameterizedObject::setParam(const std::string &name,
+    inline void ParameterizedObject::setParam(const ParamName &name,
                                               const T &t)
     {
       findParam(name, true)->set(t);
     }
 
     template<typename T>
-    inline T ParameterizedObject::getParam(const std::string &name,
+    inline T ParameterizedObject::getParam(const ParamName &name,
                                            T valIfNotFound)
     {
       Param *param = findParam(name);
@@ -0,0 +1,274 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "Profiler.h"
+#include "../intrinsics.h"
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ospcommon {
+  namespace utility {
+
+    namespace {
+
+      //! an ended zone, or the declaration of a path seen the first time
+      struct ZoneEvent
+      {
+        bool        declaration;
+        const char *name;
+        uint64_t path;
+        uint64_t parentPath;
+        int      depth;
+        uint64_t startTime;
+        uint64_t endTime;
+      };
+
+      /*! single-producer ring of the ended zones of one thread, drained by
+          endFrame() */
+      struct ThreadBuffer
+      {
+        static constexpr size_t capacity = 1 << 16;
+
+        std::unique_ptr<ZoneEvent[]> events {new ZoneEvent[capacity]};
+        std::atomic<size_t> written {0};
+        std::atomic<size_t> read {0};
+        std::atomic<size_t> dropped {0};
+
+        // only used by the owning thread //
+
+        //! (path, name) of the open zones
+        std::vector<std::pair<uint64_t, const char *>> openZones;
+        //! paths this thread declared already
+        std::unordered_set<uint64_t> declaredPaths;
+
+        bool push(const ZoneEvent &event)
+        {
+          const size_t w = written.load(std::memory_order_relaxed);
+          if (w - read.load(std::memory_order_acquire) >= capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+          events[w % capacity] = event;
+          written.store(w + 1, std::memory_order_release);
+          return true;
+        }
+      };
+
+      //! all threads' buffers, kept alive when their thread exits
+      std::mutex buffersMutex;
+      std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+      thread_local std::shared_ptr<ThreadBuffer> threadBuffer;
+
+      inline ThreadBuffer &getThreadBuffer()
+      {
+        if (!threadBuffer) {
+          threadBuffer = std::make_shared<ThreadBuffer>();
+          std::lock_guard<std::mutex> lock(buffersMutex);
+          buffers.push_back(threadBuffer);
+        }
+        return *threadBuffer;
+      }
+
+      inline uint64_t nowNanoseconds()
+      {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(
+            steady_clock::now().time_since_epoch()).count();
+      }
+
+      inline uint64_t timestamp()
+      {
+#ifdef OSPRAY_PROFILING_RDTSC
+        return read_tsc();
+#else
+        return nowNanoseconds();
+#endif
+      }
+
+#ifdef OSPRAY_PROFILING_RDTSC
+      //! reference point for the calibration, taken at load time
+      const uint64_t tsc0 = read_tsc();
+      const uint64_t ns0  = nowNanoseconds();
+#endif
+
+      //! timestamp ticks per millisecond
+      double ticksPerMillisecond()
+      {
+#ifdef OSPRAY_PROFILING_RDTSC
+        const uint64_t ns = nowNanoseconds();
+        if (ns == ns0)
+          return 1e6;
+        return (read_tsc() - tsc0) * 1e6 / (ns - ns0);
+#else
+        return 1e6;
+#endif
+      }
+
+      // aggregation, guarded by frameMutex //
+
+      struct PathInfo
+      {
+        const char *name;
+        uint64_t parentPath;
+        int depth;
+      };
+
+      std::mutex frameMutex;
+      std::unordered_map<uint64_t, PathInfo> paths;
+      std::vector<Profiler::ZoneStats> frameStats;
+
+      std::string pathName(uint64_t path, char separator)
+      {
+        auto it = paths.find(path);
+        if (it == paths.end())
+          return "?"; // its declaration got dropped
+        const PathInfo &info = it->second;
+        if (info.parentPath == 0)
+          return info.name;
+        return pathName(info.parentPath, separator) + separator + info.name;
+      }
+
+    } // ::ospcommon::utility::{anonymous}
+
+    uint64_t Profiler::beginZone(const char *name)
+    {
+      auto &buffer = getThreadBuffer();
+      const uint64_t parent =
+          buffer.openZones.empty() ? 0 : buffer.openZones.back().first;
+      // the name pointer identifies it, equal names are merged by endFrame()
+      uint64_t path = (parent ^ uint64_t(name)) * 0x100000001b3ull;
+      path = path ? path : 1;
+      buffer.openZones.emplace_back(path, name);
+
+      // declared at the begin, such that parents precede their children
+      if (buffer.declaredPaths.find(path) == buffer.declaredPaths.end()) {
+        const int depth = buffer.openZones.size() - 1;
+        if (buffer.push({true, name, path, parent, depth, 0, 0}))
+          buffer.declaredPaths.insert(path);
+      }
+
+      return timestamp();
+    }
+
+    void Profiler::endZone(uint64_t startTime)
+    {
+      const uint64_t endTime = timestamp();
+      auto &buffer = getThreadBuffer();
+
+      const auto zone = buffer.openZones.back();
+      buffer.openZones.pop_back();
+
+      const uint64_t parent =
+          buffer.openZones.empty() ? 0 : buffer.openZones.back().first;
+      const int depth = buffer.openZones.size();
+      buffer.push({false, zone.second, zone.first, parent, depth,
+                   startTime, endTime});
+    }
+
+    void Profiler::endFrame()
+    {
+      std::vector<std::shared_ptr<ThreadBuffer>> threads;
+      {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        threads = buffers;
+      }
+
+      std::lock_guard<std::mutex> lock(frameMutex);
+      const double rcpTicks = 1.0 / ticksPerMillisecond();
+
+      // merge by path name, as the same name may live at several addresses;
+      // keyed with a separator sorting before any name character, such
+      // that children directly follow their parent
+      std::map<std::string, Profiler::ZoneStats> stats;
+      std::vector<std::pair<uint64_t, double>> durations;
+      for (auto &buffer : threads) {
+        const size_t r = buffer->read.load(std::memory_order_relaxed);
+        const size_t w = buffer->written.load(std::memory_order_acquire);
+        for (size_t i = r; i < w; ++i) {
+          const ZoneEvent &event = buffer->events[i % ThreadBuffer::capacity];
+          if (event.declaration) {
+            paths[event.path] = {event.name, event.parentPath, event.depth};
+          } else {
+            durations.emplace_back(event.path,
+                (event.endTime - event.startTime) * rcpTicks);
+          }
+        }
+        buffer->read.store(w, std::memory_order_release);
+      }
+
+      for (const auto &d : durations) {
+        const std::string key = pathName(d.first, '\1');
+        auto it = stats.find(key);
+        if (it == stats.end()) {
+          auto info = paths.find(d.first);
+          Profiler::ZoneStats s;
+          s.path = pathName(d.first, '/');
+          s.name = info != paths.end() ? info->second.name : "?";
+          s.depth = info != paths.end() ? info->second.depth : 0;
+          s.calls = 0;
+          s.totalMilliseconds = 0.0;
+          s.minMilliseconds = d.second;
+          s.maxMilliseconds = d.second;
+          it = stats.emplace(key, s).first;
+        }
+
+        auto &s = it->second;
+        s.calls++;
+        s.totalMilliseconds += d.second;
+        s.minMilliseconds = std::min(s.minMilliseconds, d.second);
+        s.maxMilliseconds = std::max(s.maxMilliseconds, d.second);
+      }
+
+      // sorted by path, thus parents come before their children
+      frameStats.clear();
+      for (auto &s : stats)
+        frameStats.push_back(std::move(s.second));
+    }
+
+    std::vector<Profiler::ZoneStats> Profiler::lastFrame()
+    {
+      std::lock_guard<std::mutex> lock(frameMutex);
+      return frameStats;
+    }
+
+    void Profiler::report(std::ostream &os)
+    {
+      for (const auto &s : lastFrame()) {
+        os << std::string(2 * s.depth, ' ') << s.name << ": "
+           << s.totalMilliseconds << "ms in " << s.calls << " calls (min "
+           << s.minMilliseconds << "ms, max " << s.maxMilliseconds << "ms)\n";
+      }
+    }
+
+    size_t Profiler::droppedZones()
+    {
+      std::lock_guard<std::mutex> lock(buffersMutex);
+      size_t dropped = 0;
+      for (auto &buffer : buffers)
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+      return dropped;
+    }
+
+  } // ::ospcommon::utility
+} // ::ospcommon
@@ -0,0 +1,103 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "../common.h"
+// std
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ospcommon {
+  namespace utility {
+
+    /*! \brief hierarchical profiler of scoped zones
+
+      Zones are timed with OSPRAY_PROFILE_ZONE("name"), which compiles to
+      nothing unless OSPRAY_ENABLE_PROFILING is defined. Each thread
+      records its zones into its own buffer without locking, zones opened
+      while another one is open on the same thread are nested into it. The
+      names need to outlive the profiler, i.e. should be string literals.
+
+      endFrame() collects the zones ended on all threads since its last
+      call and aggregates them by their path of nested names, the result
+      is queried by lastFrame() or printed by report().
+
+      With OSPRAY_PROFILING_RDTSC the timestamps are read by rdtsc instead
+      of from std::chrono::steady_clock, which is calibrated against. */
+    struct OSPCOMMON_INTERFACE Profiler
+    {
+      struct ZoneStats
+      {
+        //! names of the enclosing zones and this one, separated by '/'
+        std::string path;
+        std::string name;
+        int    depth;
+        size_t calls;
+        double totalMilliseconds;
+        double minMilliseconds;
+        double maxMilliseconds;
+      };
+
+      /*! aggregate the zones ended since the last call */
+      static void endFrame();
+
+      /*! the zones of the last endFrame(), parents before their children */
+      static std::vector<ZoneStats> lastFrame();
+
+      /*! print lastFrame() as indented tree */
+      static void report(std::ostream &os);
+
+      /*! zones dropped so far because a thread's buffer was full, i.e.
+          endFrame() was not called often enough */
+      static size_t droppedZones();
+
+      // used by ProfileZone //
+
+      static uint64_t beginZone(const char *name);
+      static void endZone(uint64_t startTime);
+    };
+
+    /*! times its scope as zone of the Profiler */
+    struct ProfileZone
+    {
+      ProfileZone(const char *name) : startTime(Profiler::beginZone(name)) {}
+      ~ProfileZone() { Profiler::endZone(startTime); }
+
+      ProfileZone(const ProfileZone &) = delete;
+      ProfileZone &operator=(const ProfileZone &) = delete;
+
+    private:
+
+      uint64_t startTime;
+    };
+
+  } // ::ospcommon::utility
+} // ::ospcommon
+
+#ifdef OSPRAY_ENABLE_PROFILING
+#  define OSPRAY_PROFILE_CONCAT_(a, b) a##b
+#  define OSPRAY_PROFILE_CONCAT(a, b) OSPRAY_PROFILE_CONCAT_(a, b)
+#  define OSPRAY_PROFILE_ZONE(name)                                 \
+  ospcommon::utility::ProfileZone                                   \
+    OSPRAY_PROFILE_CONCAT(ospray_profile_zone_, __LINE__)(name)
+#  define OSPRAY_PROFILE_END_FRAME() \
+  ospcommon::utility::Profiler::endFrame()
+#else
+#  define OSPRAY_PROFILE_ZONE(name)
+#  define OSPRAY_PROFILE_END_FRAME()
+#endif
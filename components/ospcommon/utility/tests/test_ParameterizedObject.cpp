@@ -38,3 +38,44 @@ TEST_CASE("ParameterizedObject correctness", "[]")
   REQUIRE(obj.getParam<int>(name, 4) == 4);
   REQUIRE(obj.getParam<short>(name, 4) == 4);
 }
+
+TEST_CASE("ParameterizedObject many parameters", "[]")
+{
+  ParameterizedObject obj;
+
+  const int numParams = 100;
+  for (int i = 0; i < numParams; ++i)
+    obj.setParam("param" + std::to_string(i), i);
+
+  for (int i = 0; i < numParams; ++i)
+    REQUIRE(obj.getParam<int>("param" + std::to_string(i), -1) == i);
+
+  for (int i = 0; i < numParams; i += 2)
+    obj.removeParam("param" + std::to_string(i));
+
+  for (int i = 0; i < numParams; ++i) {
+    const std::string name = "param" + std::to_string(i);
+    REQUIRE(obj.hasParam(name) == (i % 2 == 1));
+    REQUIRE(obj.getParam<int>(name, -1) == (i % 2 == 1 ? i : -1));
+  }
+
+  obj.setParam("param0", 42);
+  REQUIRE(obj.getParam<int>("param0", -1) == 42);
+  REQUIRE(!obj.hasParam("param"));
+  REQUIRE(!obj.hasParam("param00"));
+}
+
+TEST_CASE("ParamName hashing", "[]")
+{
+  using ospcommon::utility::ParamName;
+
+  constexpr ParamName literal("baseColor");
+  static_assert(literal.length == 9, "literal length must fold");
+
+  const char *cstr = "baseColor";
+  const std::string str = "baseColor";
+
+  REQUIRE(ParamName(cstr).hash == literal.hash);
+  REQUIRE(ParamName(str).hash == literal.hash);
+  REQUIRE(ParamName("baseColour").hash != literal.hash);
+}
@@ -0,0 +1,74 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "../../testing/catch.hpp"
+
+#include "../Profiler.h"
+
+#include <thread>
+
+using ospcommon::utility::Profiler;
+using ospcommon::utility::ProfileZone;
+
+TEST_CASE("Nested zones", "[]")
+{
+  Profiler::endFrame(); // drop earlier zones
+
+  {
+    ProfileZone outer("outer");
+    for (int i = 0; i < 3; ++i) {
+      ProfileZone inner("inner");
+    }
+  }
+
+  std::thread t([]() {
+    ProfileZone outer("outer");
+    ProfileZone inner("inner");
+  });
+  t.join();
+
+  Profiler::endFrame();
+  auto stats = Profiler::lastFrame();
+
+  REQUIRE(stats.size() == 2);
+  REQUIRE(stats[0].path == "outer");
+  REQUIRE(stats[0].depth == 0);
+  REQUIRE(stats[0].calls == 2);
+  REQUIRE(stats[1].path == "outer/inner");
+  REQUIRE(stats[1].name == "inner");
+  REQUIRE(stats[1].depth == 1);
+  REQUIRE(stats[1].calls == 4);
+  REQUIRE(stats[1].minMilliseconds <= stats[1].maxMilliseconds);
+  REQUIRE(stats[0].totalMilliseconds >= stats[0].maxMilliseconds);
+
+  Profiler::endFrame();
+  REQUIRE(Profiler::lastFrame().empty());
+  REQUIRE(Profiler::droppedZones() == 0);
+}
+
+TEST_CASE("Zones spanning frames", "[]")
+{
+  ProfileZone outer("long");
+  {
+    ProfileZone inner("short");
+  }
+
+  Profiler::endFrame();
+  auto stats = Profiler::lastFrame();
+
+  REQUIRE(stats.size() == 1);
+  REQUIRE(stats[0].path == "long/short");
+}
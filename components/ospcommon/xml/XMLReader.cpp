@@ -0,0 +1,304 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "XMLReader.h"
+// std
+#include <iostream>
+#include <stdexcept>
+// mmap
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace ospcommon {
+  namespace xml {
+
+    static inline bool isWhite(char c)
+    {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static inline bool isNameStart(char c)
+    {
+      return isalpha((unsigned char)c) || c == '_';
+    }
+
+    static inline bool isNameChar(char c)
+    {
+      return isalnum((unsigned char)c) || c == '_' || c == '.';
+    }
+
+    XMLReader::XMLReader(const std::string &fileName) : file(fileName)
+    {
+      const std::string openError =
+          "ospray::XML error: could not open file '" + fileName + "'";
+#ifdef _WIN32
+      HANDLE handle = CreateFileA(fileName.c_str(), GENERIC_READ,
+                                  FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (handle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error(openError);
+      LARGE_INTEGER fileSize;
+      GetFileSizeEx(handle, &fileSize);
+      if (fileSize.QuadPart > 0) {
+        HANDLE map =
+            CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (map)
+          data = (const char *)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(map);
+        if (!data) {
+          CloseHandle(handle);
+          throw std::runtime_error(openError);
+        }
+      }
+      CloseHandle(handle);
+      end = data + fileSize.QuadPart;
+#else
+      int fd = open(fileName.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw std::runtime_error(openError);
+      struct stat st;
+      if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error(openError);
+      }
+      if (st.st_size > 0) {
+        void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED) {
+          close(fd);
+          throw std::runtime_error(openError);
+        }
+        madvise(mem, st.st_size, MADV_SEQUENTIAL);
+        data = (const char *)mem;
+      }
+      close(fd);
+      end = data + st.st_size;
+#endif
+      pos = data;
+      mapping = (void *)data;
+    }
+
+    XMLReader::~XMLReader()
+    {
+      if (!mapping)
+        return;
+#ifdef _WIN32
+      UnmapViewOfFile(mapping);
+#else
+      munmap(mapping, end - data);
+#endif
+    }
+
+    void XMLReader::error(const std::string &msg) const
+    {
+      throw std::runtime_error("error reading XML file '" + file.str()
+                               + "' at byte " + std::to_string(offset())
+                               + ": " + msg);
+    }
+
+    void XMLReader::skipWhites()
+    {
+      while (pos < end && isWhite(*pos))
+        ++pos;
+    }
+
+    bool XMLReader::startsWith(const char *s) const
+    {
+      const size_t n = strlen(s);
+      return size_t(end - pos) >= n && strncmp(pos, s, n) == 0;
+    }
+
+    StringView XMLReader::parseName()
+    {
+      StringView name;
+      if (pos == end || !isNameStart(*pos))
+        return name;
+      name.begin = pos;
+      while (pos < end && isNameChar(*pos))
+        ++pos;
+      name.size = pos - name.begin;
+      return name;
+    }
+
+    StringView XMLReader::attribute(const char *name) const
+    {
+      for (const auto &a : currentAttributes)
+        if (a.first == name)
+          return a.second;
+      return StringView();
+    }
+
+    XMLReader::Event XMLReader::next()
+    {
+      if (closePending) {
+        closePending = false;
+        currentName = openElements.back();
+        openElements.pop_back();
+        return END_ELEMENT;
+      }
+
+      while (true) {
+        skipWhites();
+
+        if (pos == end) {
+          if (!openElements.empty()) {
+            std::cout << "#osp:xml: warning: xml file ended with still-open"
+                         " nodes (this typically indicates a partial xml file)"
+                      << std::endl;
+            openElements.clear();
+          }
+          return END_DOCUMENT;
+        }
+
+        if (startsWith("<!")) {
+          // comment
+          pos += 2;
+          while (pos < end && !startsWith("-->"))
+            ++pos;
+          if (pos == end)
+            error("unterminated comment");
+          pos += 3;
+          continue;
+        }
+
+        if (startsWith("<?")) {
+          // header
+          while (pos < end && !startsWith("?>"))
+            ++pos;
+          if (pos == end)
+            error("unterminated '<?'");
+          pos += 2;
+          continue;
+        }
+
+        if (startsWith("</")) {
+          pos += 2;
+          currentName = parseName();
+          if (openElements.empty() ||
+              currentName.str() != openElements.back().str()) {
+            error("invalid XML node - started with '<"
+                  + (openElements.empty() ? std::string()
+                                          : openElements.back().str())
+                  + "...>', but ended with '</" + currentName.str() + ">'");
+          }
+          skipWhites();
+          if (pos == end || *pos != '>')
+            error("expecting '>'");
+          ++pos;
+          openElements.pop_back();
+          return END_ELEMENT;
+        }
+
+        if (*pos == '<') {
+          ++pos;
+          currentName = parseName();
+          if (currentName.empty())
+            error("could not parse node name");
+
+          currentAttributes.clear();
+          while (true) {
+            skipWhites();
+            StringView attrName = parseName();
+            if (attrName.empty())
+              break;
+            skipWhites();
+            if (pos == end || *pos != '=')
+              error("expecting '='");
+            ++pos;
+            skipWhites();
+            if (pos == end || (*pos != '"' && *pos != '\''))
+              error("expecting '\"' or '''");
+            const char quote = *pos++;
+            StringView value;
+            value.begin = pos;
+            while (pos < end && *pos != quote) {
+              if (*pos == '\\')
+                ++pos;
+              ++pos;
+            }
+            if (pos >= end)
+              error("unterminated attribute value");
+            value.size = pos - value.begin;
+            ++pos;
+            currentAttributes.emplace_back(attrName, value);
+          }
+
+          openElements.push_back(currentName);
+          if (startsWith("/>")) {
+            pos += 2;
+            closePending = true;
+          } else if (pos < end && *pos == '>') {
+            ++pos;
+          } else {
+            error("expecting '>' or '/>'");
+          }
+          return START_ELEMENT;
+        }
+
+        if (openElements.empty())
+          error("un-parsed junk at end of file");
+
+        currentContent.begin = pos;
+        while (pos < end && *pos != '<')
+          ++pos;
+        const char *contentEnd = pos;
+        while (contentEnd > currentContent.begin && isWhite(contentEnd[-1]))
+          --contentEnd;
+        currentContent.size = contentEnd - currentContent.begin;
+        return CONTENT;
+      }
+    }
+
+    Node XMLReader::readElement(XMLDoc *doc)
+    {
+      Node node(doc);
+      node.name = currentName.str();
+      for (const auto &a : currentAttributes)
+        node.properties[a.first.str()] = a.second.str();
+
+      while (true) {
+        switch (next()) {
+        case START_ELEMENT:
+          node.child.push_back(readElement(doc));
+          break;
+        case CONTENT:
+          if (!node.content.empty())
+            error("invalid XML node - two different contents!?");
+          node.content = currentContent.str();
+          break;
+        default:
+          return node;
+        }
+      }
+    }
+
+    void XMLReader::skipElement()
+    {
+      const size_t elementDepth = depth();
+      while (depth() >= elementDepth) {
+        if (next() == END_DOCUMENT)
+          return;
+      }
+    }
+
+  } // ::ospcommon::xml
+} // ::ospcommon
@@ -0,0 +1,130 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "XML.h"
+// std
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ospcommon {
+  namespace xml {
+
+    /*! a not null-terminated string inside the buffer of an XMLReader */
+    struct StringView
+    {
+      const char *begin {nullptr};
+      size_t size {0};
+
+      bool empty() const { return size == 0; }
+      std::string str() const { return std::string(begin, size); }
+
+      bool operator==(const char *s) const
+      {
+        return strlen(s) == size && strncmp(begin, s, size) == 0;
+      }
+      bool operator!=(const char *s) const { return !(*this == s); }
+    };
+
+    /*! \brief pull parser reading an XML file event by event
+
+      The file is memory mapped, names, attributes and contents are views
+      into the mapping, thus valid as long as the reader. The attributes
+      are those of the last START_ELEMENT. The header and comments are
+      skipped, self-closing elements yield a START_ELEMENT followed by an
+      END_ELEMENT.
+
+      As opposed to readXML() there is no document in memory, readers can
+      however materialize single elements (e.g. the top-level entries of a
+      scene file) with readElement(). */
+    struct OSPCOMMON_INTERFACE XMLReader
+    {
+      enum Event
+      {
+        START_ELEMENT,
+        END_ELEMENT,
+        CONTENT,
+        END_DOCUMENT
+      };
+
+      XMLReader(const std::string &fileName);
+      ~XMLReader();
+
+      XMLReader(const XMLReader &) = delete;
+      XMLReader &operator=(const XMLReader &) = delete;
+
+      /*! parse up to the next event, throws std::runtime_error on errors */
+      Event next();
+
+      /*! name of the element of the last START_ELEMENT or END_ELEMENT */
+      StringView name() const { return currentName; }
+
+      /*! the content of the last CONTENT, without surrounding whitespace */
+      StringView content() const { return currentContent; }
+
+      const std::vector<std::pair<StringView, StringView>> &attributes() const
+      { return currentAttributes; }
+
+      /*! value of the given attribute of the last START_ELEMENT, empty if
+          there is none */
+      StringView attribute(const char *name) const;
+
+      /*! number of open elements */
+      size_t depth() const { return openElements.size(); }
+
+      /*! called after START_ELEMENT, reads the element with its children
+          into a Node (which is stand-alone unless doc is given) */
+      Node readElement(XMLDoc *doc = nullptr);
+
+      /*! called after START_ELEMENT, skips the element with its children */
+      void skipElement();
+
+      /*! bytes parsed so far and in total, e.g. for progress reports */
+      size_t offset() const { return pos - data; }
+      size_t size() const { return end - data; }
+
+      const FileName &fileName() const { return file; }
+
+    private:
+
+      StringView parseName();
+      void skipWhites();
+      bool startsWith(const char *s) const;
+      [[noreturn]] void error(const std::string &msg) const;
+
+      FileName file;
+
+      const char *data {nullptr};
+      const char *pos {nullptr};
+      const char *end {nullptr};
+
+      //! platform specific mapping handle
+      void *mapping {nullptr};
+
+      std::vector<StringView> openElements;
+      //! the END_ELEMENT of a self-closing element is due
+      bool closePending {false};
+
+      StringView currentName;
+      StringView currentContent;
+      std::vector<std::pair<StringView, StringView>> currentAttributes;
+    };
+
+  } // ::ospcommon::xml
+} // ::ospcommon
@@ -0,0 +1,118 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "../../testing/catch.hpp"
+
+#include "../XMLReader.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace ospcommon::xml;
+
+static std::string writeFile(const std::string &contents)
+{
+  const std::string fileName = "test_XMLReader.xml";
+  std::ofstream(fileName) << contents;
+  return fileName;
+}
+
+static const char *scene =
+    "<?xml version=\"1.0\"?>\n"
+    "<!-- a comment -->\n"
+    "<BGFscene>\n"
+    "  <Material name='red' type=\"OBJMaterial\">\n"
+    "    <param name=\"kd\" type=\"float3\"> 1 0 0 </param>\n"
+    "  </Material>\n"
+    "  <Mesh id=\"1\" />\n"
+    "</BGFscene>\n";
+
+TEST_CASE("XMLReader events", "[]")
+{
+  XMLReader reader(writeFile(scene));
+
+  REQUIRE(reader.next() == XMLReader::START_ELEMENT);
+  REQUIRE(reader.name() == "BGFscene");
+  REQUIRE(reader.depth() == 1);
+
+  REQUIRE(reader.next() == XMLReader::START_ELEMENT);
+  REQUIRE(reader.name() == "Material");
+  REQUIRE(reader.attributes().size() == 2);
+  REQUIRE(reader.attribute("name") == "red");
+  REQUIRE(reader.attribute("type") == "OBJMaterial");
+  REQUIRE(reader.attribute("none").empty());
+
+  REQUIRE(reader.next() == XMLReader::START_ELEMENT);
+  REQUIRE(reader.name() == "param");
+  REQUIRE(reader.next() == XMLReader::CONTENT);
+  REQUIRE(reader.content() == "1 0 0");
+  REQUIRE(reader.next() == XMLReader::END_ELEMENT);
+  REQUIRE(reader.name() == "param");
+  REQUIRE(reader.next() == XMLReader::END_ELEMENT);
+  REQUIRE(reader.name() == "Material");
+
+  REQUIRE(reader.next() == XMLReader::START_ELEMENT);
+  REQUIRE(reader.name() == "Mesh");
+  REQUIRE(reader.attribute("id") == "1");
+  REQUIRE(reader.next() == XMLReader::END_ELEMENT);
+  REQUIRE(reader.name() == "Mesh");
+
+  REQUIRE(reader.next() == XMLReader::END_ELEMENT);
+  REQUIRE(reader.depth() == 0);
+  REQUIRE(reader.next() == XMLReader::END_DOCUMENT);
+  REQUIRE(reader.offset() == reader.size());
+}
+
+TEST_CASE("XMLReader readElement() matches readXML()", "[]")
+{
+  const std::string fileName = writeFile(scene);
+  auto doc = readXML(fileName);
+  const Node &expected = doc->child[0].child[0];
+
+  XMLReader reader(fileName);
+  reader.next();
+  reader.next();
+  Node material = reader.readElement();
+
+  REQUIRE(material.name == expected.name);
+  REQUIRE(material.properties == expected.properties);
+  REQUIRE(material.child.size() == 1);
+  REQUIRE(material.child[0].name == expected.child[0].name);
+  REQUIRE(material.child[0].content == expected.child[0].content);
+  REQUIRE(material.child[0].properties == expected.child[0].properties);
+
+  REQUIRE(reader.next() == XMLReader::START_ELEMENT);
+  reader.skipElement();
+  REQUIRE(reader.next() == XMLReader::END_ELEMENT);
+  REQUIRE(reader.name() == "BGFscene");
+}
+
+TEST_CASE("XMLReader errors", "[]")
+{
+  XMLReader mismatch(writeFile("<a><b></a>"));
+  mismatch.next();
+  mismatch.next();
+  REQUIRE_THROWS(mismatch.next());
+
+  XMLReader junk(writeFile("<a/> junk"));
+  junk.next();
+  junk.next();
+  REQUIRE_THROWS(junk.next());
+
+  REQUIRE_THROWS(XMLReader("does_not_exist.xml"));
+
+  std::remove("test_XMLReader.xml");
+}
@@ -0,0 +1,239 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "DenoiserPixelOp.h"
+// ospray
+#include "api/Device.h"
+#include "fb/LocalFB.h"
+#include "fb/TilePool.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+
+namespace ospray {
+  namespace denoiser {
+
+    // DenoiserPixelOp definitions ////////////////////////////////////////////
+
+    void DenoiserPixelOp::commit()
+    {
+      PixelOp::commit();
+
+      interval = std::max(1, getParam1i("interval", 1));
+      errorThreshold = getParam1f("errorThreshold", 0.f);
+    }
+
+    std::string DenoiserPixelOp::toString() const
+    {
+      return "ospray::denoiser::DenoiserPixelOp";
+    }
+
+    PixelOp::Instance *
+    DenoiserPixelOp::createInstance(FrameBuffer *fb, PixelOp::Instance *prev)
+    {
+      auto *localFB = dynamic_cast<LocalFrameBuffer *>(fb);
+      if (!localFB) {
+        static WarnOnce warning("the 'denoiser' pixel op only supports local "
+                                "frame buffers, it will be ignored");
+        return prev;
+      }
+
+      // setting the same denoiser again replaces it instead of chaining
+      auto *prevDenoiser = dynamic_cast<DenoiserPixelOp::Instance *>(prev);
+      if (prevDenoiser && prevDenoiser->op.ptr == this)
+        prev = prevDenoiser->prev.ptr;
+
+      return new DenoiserPixelOp::Instance(this, localFB, prev);
+    }
+
+    oidn::DeviceRef DenoiserPixelOp::device()
+    {
+      if (!oidnDevice) {
+        // OIDN runs in endFrame, i.e. when the OSPRay worker threads are
+        // idle, thus it uses the same number of threads and affinity
+        auto &ospDevice = api::currentDevice();
+        oidnDevice = oidn::newDevice();
+        if (ospDevice.numThreads > 0)
+          oidnDevice.set("numThreads", ospDevice.numThreads);
+        oidnDevice.set("setAffinity",
+            ospDevice.threadAffinity == api::Device::AFFINITIZE);
+        oidnDevice.commit();
+      }
+      return oidnDevice;
+    }
+
+    // DenoiserPixelOp::Instance definitions //////////////////////////////////
+
+    DenoiserPixelOp::Instance::Instance(DenoiserPixelOp *op,
+                                        LocalFrameBuffer *fb,
+                                        PixelOp::Instance *prev)
+      : op(op),
+        prev(prev),
+        localFB(fb),
+        useAlbedo(fb->hasAlbedoBuffer),
+        useNormal(fb->hasAlbedoBuffer && fb->hasNormalBuffer)
+    {
+      this->fb = fb;
+
+      const size_t numPixels = size_t(fb->size.x) * fb->size.y;
+      color.resize(numPixels, vec4f(0.f));
+      output.resize(numPixels, vec3f(0.f));
+      if (useAlbedo)
+        albedo.resize(numPixels, vec3f(0.f));
+      if (useNormal)
+        normal.resize(numPixels, vec3f(0.f));
+
+      // the buffers never move, thus committing the filter once suffices
+      filter = op->device().newFilter("RT");
+      filter.setImage("color", color.data(), oidn::Format::Float3,
+                      fb->size.x, fb->size.y, 0, sizeof(vec4f));
+      if (useAlbedo) {
+        filter.setImage("albedo", albedo.data(), oidn::Format::Float3,
+                        fb->size.x, fb->size.y);
+      }
+      if (useNormal) {
+        filter.setImage("normal", normal.data(), oidn::Format::Float3,
+                        fb->size.x, fb->size.y);
+      }
+      filter.setImage("output", output.data(), oidn::Format::Float3,
+                      fb->size.x, fb->size.y);
+      filter.set("hdr", true);
+      filter.commit();
+    }
+
+    void DenoiserPixelOp::Instance::beginFrame()
+    {
+      // the first frame after a clear
+      if (fb->frameID == 0)
+        lastDenoisedFrame = -1;
+
+      if (prev)
+        prev->beginFrame();
+    }
+
+    void DenoiserPixelOp::Instance::endFrame()
+    {
+      if (converged()) {
+        const int32 frameID = fb->frameID;
+        if (lastDenoisedFrame < 0
+            || frameID - lastDenoisedFrame >= op->interval) {
+          filter.execute();
+          lastDenoisedFrame = frameID;
+
+          const char *errorMessage = nullptr;
+          if (op->device().getError(errorMessage) != oidn::Error::None)
+            postStatusMsg() << "#osp:denoiser: " << errorMessage;
+        }
+        // frames in between show the last denoised frame
+        writeColor(output);
+      } else {
+        // the noisy frame stays in the color buffer
+        lastDenoisedFrame = -1;
+      }
+
+      if (prev)
+        prev->endFrame();
+    }
+
+    void DenoiserPixelOp::Instance::preAccum(Tile &tile)
+    {
+      if (prev)
+        prev->preAccum(tile);
+    }
+
+    void DenoiserPixelOp::Instance::postAccum(Tile &tile)
+    {
+      // gather the accumulated HDR color, before the chained ops
+      const float accumID = tile.accumID;
+      const float accScale = 1.f / (tile.accumID + 1);
+      const vec2i lower = tile.region.lower;
+      for (int y = lower.y; y < tile.region.upper.y; y++) {
+        for (int x = lower.x; x < tile.region.upper.x; x++) {
+          const int i = (y - lower.y) * TILE_SIZE + (x - lower.x);
+          const size_t pixel = size_t(y) * fb->size.x + x;
+          color[pixel] = vec4f(tile.r[i], tile.g[i], tile.b[i], tile.a[i]);
+
+          // the tile holds the aux values of this frame only
+          if (useAlbedo) {
+            const vec3f a(tile.ar[i], tile.ag[i], tile.ab[i]);
+            albedo[pixel] = tile.accumID > 0 ?
+              (albedo[pixel] * accumID + a) * accScale : a;
+          }
+          if (useNormal) {
+            const vec3f n(tile.nx[i], tile.ny[i], tile.nz[i]);
+            normal[pixel] = tile.accumID > 0 ?
+              (normal[pixel] * accumID + n) * accScale : n;
+          }
+        }
+      }
+
+      if (prev)
+        prev->postAccum(tile);
+    }
+
+    std::string DenoiserPixelOp::Instance::toString() const
+    {
+      return "ospray::denoiser::DenoiserPixelOp::Instance";
+    }
+
+    bool DenoiserPixelOp::Instance::converged() const
+    {
+      if (op->errorThreshold <= 0.f || !fb->hasVarianceBuffer)
+        return true;
+
+      const vec2i numTiles = fb->getNumTiles();
+      for (int y = 0; y < numTiles.y; y++) {
+        for (int x = 0; x < numTiles.x; x++) {
+          if (fb->tileError(vec2i(x, y)) > op->errorThreshold)
+            return false;
+        }
+      }
+      return true;
+    }
+
+    void
+    DenoiserPixelOp::Instance::writeColor(const std::vector<vec3f> &rgb)
+    {
+      const vec2i numTiles = fb->getNumTiles();
+      tasking::parallel_for(numTiles.x * numTiles.y, [&](int taskIndex) {
+        const vec2i tileID(taskIndex % numTiles.x, taskIndex / numTiles.x);
+        if (!fb->tileInRenderRegion(tileID))
+          return;
+
+        auto tile = TilePool::acquire(tileID, fb->size, fb->accumID(tileID),
+                                      0u);
+        const vec2i lower = tile->region.lower;
+        for (int y = lower.y; y < tile->region.upper.y; y++) {
+          for (int x = lower.x; x < tile->region.upper.x; x++) {
+            const int i = (y - lower.y) * TILE_SIZE + (x - lower.x);
+            const size_t pixel = size_t(y) * fb->size.x + x;
+            tile->r[i] = rgb[pixel].x;
+            tile->g[i] = rgb[pixel].y;
+            tile->b[i] = rgb[pixel].z;
+            tile->a[i] = color[pixel].w;
+          }
+        }
+
+        if (prev)
+          prev->postAccum(*tile);
+        localFB->writeColorTile(*tile);
+      });
+    }
+
+    OSP_REGISTER_PIXEL_OP(DenoiserPixelOp, denoiser);
+
+  } // ::ospray::denoiser
+} // ::ospray
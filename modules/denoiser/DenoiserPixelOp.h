@@ -0,0 +1,101 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+// ospray
+#include "fb/PixelOp.h"
+// oidn
+#include <OpenImageDenoise/oidn.hpp>
+// std
+#include <vector>
+
+namespace ospray {
+
+  struct LocalFrameBuffer;
+
+  namespace denoiser {
+
+    /*! \brief denoises the accumulated color of a local frame buffer
+
+      The instance gathers the accumulated HDR color (before the pixel
+      ops it is chained to) as well as the running means of the albedo
+      and normal planes of the tiles in postAccum, into full-frame
+      buffers which stay in place for the lifetime of the instance, thus
+      the OIDN filter only needs to be committed once. In endFrame the
+      filter runs (following the policy below), and the result is passed
+      through the chained pixel ops and written into the back color
+      buffer, before the frame buffer swaps it to the front.
+     */
+    struct DenoiserPixelOp : public PixelOp
+    {
+      struct Instance : public PixelOp::Instance
+      {
+        Instance(DenoiserPixelOp *op,
+                 LocalFrameBuffer *fb,
+                 PixelOp::Instance *prev);
+
+        void beginFrame() override;
+        void endFrame() override;
+        void preAccum(Tile &tile) override;
+        void postAccum(Tile &tile) override;
+        std::string toString() const override;
+
+        Ref<DenoiserPixelOp> op;
+        Ref<PixelOp::Instance> prev; //!< applied after denoising
+
+      private:
+
+        bool converged() const;
+        void writeColor(const std::vector<vec3f> &color);
+
+        LocalFrameBuffer *localFB;
+        bool useAlbedo;
+        bool useNormal;
+
+        std::vector<vec4f> color; //!< accumulated color of the last frame
+        std::vector<vec3f> albedo; //!< running mean of the albedo
+        std::vector<vec3f> normal; //!< running mean of the normal
+        std::vector<vec3f> output; //!< last denoised frame
+
+        oidn::FilterRef filter;
+        int32 lastDenoisedFrame {-1};
+      };
+
+      DenoiserPixelOp() = default;
+      void commit() override;
+      std::string toString() const override;
+      PixelOp::Instance *createInstance(FrameBuffer *fb,
+                                        PixelOp::Instance *prev) override;
+
+      /*! the OIDN device, shared by all instances; it uses the thread
+          count and affinity of the OSPRay device */
+      oidn::DeviceRef device();
+
+      //! run the filter on every interval'th frame after a clear
+      int32 interval {1};
+      /*! if > 0 (and the frame buffer has OSP_FB_VARIANCE), only denoise
+          frames whose estimated error is below this threshold */
+      float errorThreshold {0.f};
+
+    private:
+
+      oidn::DeviceRef oidnDevice;
+    };
+
+  } // ::ospray::denoiser
+} // ::ospray
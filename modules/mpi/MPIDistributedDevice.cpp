@@ -25,6 +25,7 @@
 #include "ospcommon/utility/getEnvVar.h"
 //mpiCommon
 #include "mpiCommon/MPICommon.h"
+#include "mpiCommon/Tracing.h"
 //ospray_mpi
 #include "mpi/MPIDistributedDevice.h"
 #include "mpi/fb/DistributedFrameBuffer.h"
@@ -91,6 +92,7 @@ namespace ospray {
     void MPIDistributedDevice::commit()
     {
       Device::commit();
+      api::ISPCDevice::commitMemoryBudget(*this);
 
       if (!initialized) {
         int _ac = 1;
@@ -108,6 +110,8 @@ namespace ospray {
 
         embreeDevice = rtcNewDevice(generateEmbreeDeviceCfg(*this).c_str());
         rtcSetDeviceErrorFunction(embreeDevice, embreeErrorFunc, nullptr);
+        rtcSetDeviceMemoryMonitorFunction(embreeDevice,
+            api::ISPCDevice::embreeMemoryMonitor, nullptr);
         RTCError erc = rtcGetDeviceError(embreeDevice);
         if (erc != RTC_ERROR_NONE) {
           // why did the error function not get called !?
@@ -150,9 +154,8 @@ namespace ospray {
     MPIDistributedDevice::frameBufferMap(OSPFrameBuffer _fb,
                                          OSPFrameBufferChannel channel)
     {
-      if (!mpicommon::IamTheMaster())
-        throw std::runtime_error("Can only map framebuffer on the master!");
-
+      // besides the master, the display ranks of a display wall (see the
+      // 'displayGrid' of the DistributedFrameBuffer) map their region
       auto &fb = lookupDistributedObject<FrameBuffer>(_fb);
 
       return fb.mapBuffer(channel);
@@ -181,9 +184,19 @@ namespace ospray {
     void MPIDistributedDevice::commit(OSPObject _object)
     {
       auto *object = lookupObject<ManagedObject>(_object);
+      object->lastCommitted.renew();
       object->commit();
     }
 
+    void MPIDistributedDevice::commitBatch(const OSPObject *objects,
+                                           size_t count)
+    {
+      std::vector<ManagedObject *> batch(count);
+      for (size_t i = 0; i < count; i++)
+        batch[i] = lookupObject<ManagedObject>(objects[i]);
+      commitInDependencyOrder(batch.data(), count);
+    }
+
     void MPIDistributedDevice::addGeometry(OSPModel _model,
                                            OSPGeometry _geometry)
     {
@@ -208,6 +221,24 @@ namespace ospray {
       return (OSPData)instance;
     }
 
+    OSPData MPIDistributedDevice::newDataStrided(size_t nitems,
+                                                 OSPDataType format,
+                                                 const void *init,
+                                                 size_t byteStride,
+                                                 int flags)
+    {
+      auto *instance = new Data(nitems, format, init, flags, byteStride);
+      return (OSPData)instance;
+    }
+
+    void MPIDistributedDevice::dataMarkModified(OSPData _data,
+                                                size_t firstItem,
+                                                size_t numItems)
+    {
+      auto *data = lookupObject<Data>(_data);
+      data->markModified(firstItem, firstItem + numItems);
+    }
+
     void MPIDistributedDevice::setVoidPtr(OSPObject _object,
                                           const char *bufName,
                                           void *v)
@@ -399,11 +430,35 @@ namespace ospray {
       mpicommon::world.barrier();
       auto &fb       = lookupDistributedObject<FrameBuffer>(_fb);
       auto &renderer = lookupDistributedObject<Renderer>(_renderer);
-      auto result    = renderer.renderFrame(&fb, fbChannelFlags);
+      float result   = 0.f;
+      {
+        mpicommon::tracing::Scope trace("frame");
+        result = renderer.renderFrame(&fb, fbChannelFlags);
+      }
+      mpicommon::tracing::endFrame();
       mpicommon::world.barrier();
       return result;
     }
 
+    OSPFrameStats MPIDistributedDevice::getFrameStats(OSPFrameBuffer _fb)
+    {
+      auto &fb = lookupDistributedObject<FrameBuffer>(_fb);
+      return fb.getFrameStats();
+    }
+
+    /*! the memory of this rank's part of the object */
+    OSPMemoryUsage MPIDistributedDevice::getMemoryUsage(OSPObject _object)
+    {
+      auto *object = lookupObject<ManagedObject>(_object);
+      return object->getMemoryUsage();
+    }
+
+    OSPMemoryUsage
+    MPIDistributedDevice::getMemoryTotals(OSPMemoryCategory category)
+    {
+      return ManagedObject::getMemoryTotals(category);
+    }
+
     void MPIDistributedDevice::release(OSPObject _obj)
     {
       if (!_obj) return;
@@ -411,6 +466,7 @@ namespace ospray {
       auto &handle = reinterpret_cast<ObjectHandle&>(_obj);
       if (handle.defined()) {
         handle.freeObject();
+        handle.free();
       } else {
         auto *obj = (ManagedObject*)_obj;
         obj->refDec();
@@ -108,6 +108,9 @@ namespace ospray {
       /*! commit the given object's outstanding changes */
       void commit(OSPObject object) override;
 
+      /*! commit the outstanding changes of 'count' objects at once */
+      void commitBatch(const OSPObject *objects, size_t count) override;
+
       /*! add a new geometry to a model */
       void addGeometry(OSPModel _model, OSPGeometry _geometry) override;
 
@@ -124,6 +127,14 @@ namespace ospray {
       OSPData newData(size_t nitems, OSPDataType format,
                       const void *init, int flags) override;
 
+      OSPData newDataStrided(size_t nitems, OSPDataType format,
+                             const void *init, size_t byteStride,
+                             int flags) override;
+
+      void dataMarkModified(OSPData _data,
+                            size_t firstItem,
+                            size_t numItems) override;
+
       /*! Copy data into the given volume. */
       int setRegion(OSPVolume object, const void *source,
                     const vec3i &index, const vec3i &count) override;
@@ -207,6 +218,13 @@ namespace ospray {
                         OSPRenderer _renderer,
                         const uint32 fbChannelFlags) override;
 
+      /*! statistics of the last frame, as seen by this rank */
+      OSPFrameStats getFrameStats(OSPFrameBuffer _fb) override;
+
+      OSPMemoryUsage getMemoryUsage(OSPObject _object) override;
+
+      OSPMemoryUsage getMemoryTotals(OSPMemoryCategory category) override;
+
       /*! load module */
       int loadModule(const char *name) override;
 
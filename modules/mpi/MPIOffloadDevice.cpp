@@ -18,6 +18,7 @@
 
 #include "mpiCommon/MPICommon.h"
 #include "mpiCommon/MPIBcastFabric.h"
+#include "common/CompressedFabric.h"
 #include "mpi/MPIOffloadDevice.h"
 #include "common/Model.h"
 #include "common/Data.h"
@@ -27,6 +28,7 @@
 #include "ospcommon/FileName.h"
 #include "geometry/TriangleMesh.h"
 #include "render/Renderer.h"
+#include "render/RenderTask.h"
 #include "camera/Camera.h"
 #include "volume/Volume.h"
 #include "mpi/render/MPILoadBalancer.h"
@@ -37,6 +39,9 @@
 #include "ospcommon/utility/getEnvVar.h"
 
 // std
+#include <algorithm>
+#include <functional>
+#include <sstream>
 #ifndef _WIN32
 #  include <unistd.h> // for fork()
 #  include <dlfcn.h>
@@ -59,8 +64,9 @@ namespace ospray {
     //! this runs an ospray worker process.
     /*! it's up to the proper init routine to decide which processes
       call this function and which ones don't. This function will not
-      return. */
-    void runWorker();
+      return. With 'startSession' the workers serve one application
+      after the other, see createMPI_ServeSessions */
+    void runWorker(const std::function<void()> &startSession = nullptr);
 
     // Misc helper functions //////////////////////////////////////////////////
 
@@ -75,6 +81,38 @@ namespace ospray {
       }
     }
 
+    /*! parse a list of worker ranks and inclusive ranges of them (e.g.,
+        "0,2,4-7"), an empty list means all workers */
+    static std::vector<int> parseRanks(const std::string &list, int numWorkers)
+    {
+      std::vector<int> ranks;
+      std::stringstream stream(list);
+      std::string item;
+      while (std::getline(stream, item, ',')) {
+        if (item.empty())
+          continue;
+        int first = 0, last = 0;
+        const auto dash = item.find('-');
+        try {
+          first = std::stoi(item.substr(0, dash));
+          last = dash == std::string::npos ? first
+                                           : std::stoi(item.substr(dash + 1));
+        } catch (const std::logic_error &) {
+          throw std::runtime_error("invalid targetRanks '" + list + "'");
+        }
+        if (first < 0 || last < first || last >= numWorkers) {
+          throw std::runtime_error("targetRanks '" + list + "' out of the "
+                                   "range of the " + std::to_string(numWorkers)
+                                   + " workers");
+        }
+        for (int r = first; r <= last; ++r)
+          ranks.push_back(r);
+      }
+      std::sort(ranks.begin(), ranks.end());
+      ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+      return ranks;
+    }
+
     static inline void setupMaster()
     {
       MPI_CALL(Comm_split(mpi::world.comm,1,mpi::world.rank,&app.comm));
@@ -188,6 +226,122 @@ namespace ospray {
       }
     }
 
+    /*! in this mode ("service" mode)
+      - the workers are launched on their own (e.g., "mpirun -n <N>
+        ospray_mpi_worker --osp:mpi-serve") and stay up to serve one
+        application (session) after the other, saving the MPI job launch
+        and device initialization for each of them
+      - the first worker waits on the given port for an application to
+        attach (see createMPI_AttachToService), passes it the MPI port
+        name to connect to, and all workers accept that connection
+      - when the application finalizes, the workers release all its
+        objects and wait for the next one
+    */
+    void createMPI_ServeSessions(int *ac, const char **av, uint16_t port)
+    {
+      mpi::init(ac,av,true);
+
+      if (world.rank < 1) {
+        postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
+            << "=====================================================\n"
+            << "initializing OSPRay MPI in 'serve sessions' mode     \n"
+            << "on port " << port << "\n"
+            << "=====================================================";
+      }
+
+      const MPI_Comm serviceComm = world.comm;
+      socket_t serviceSocket = nullptr;
+      if (world.rank == 0)
+        serviceSocket = ospcommon::bind(port);
+
+      bool connected = false;
+      auto startSession = [=]() mutable {
+        if (connected) {
+          // the application disconnected in the same order
+          MPI_CALL(Comm_disconnect(&world.comm));
+          MPI_CALL(Comm_disconnect(&app.comm));
+        }
+        connected = true;
+
+        world.comm = serviceComm;
+        world.makeIntraComm();
+        worker.comm = serviceComm;
+        worker.makeIntraComm();
+
+        char appPortName[MPI_MAX_PORT_NAME];
+        if (worker.rank == 0) {
+          MPI_CALL(Open_port(MPI_INFO_NULL, appPortName));
+
+          socket_t clientSocket = ospcommon::listen(serviceSocket);
+          size_t len = strlen(appPortName);
+          ospcommon::write(clientSocket,&len,sizeof(len));
+          ospcommon::write(clientSocket,appPortName,len);
+          flush(clientSocket);
+          ospcommon::close(clientSocket);
+        }
+
+        MPI_CALL(Comm_accept(appPortName,MPI_INFO_NULL,0,worker.comm,
+                             &app.comm));
+        if (worker.rank == 0)
+          MPI_CALL(Close_port(appPortName));
+        app.makeInterComm();
+
+        mpi::Group mergedComm;
+        MPI_CALL(Intercomm_merge(app.comm,1,&mergedComm.comm));
+        mergedComm.makeIntraComm();
+        mpi::world.comm = mergedComm.comm;
+        mpi::world.makeIntraComm();
+
+        mpi::world.barrier();
+
+        postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
+            << "#w: worker " << worker.rank << " starting a new session";
+      };
+
+      mpi::runWorker(startSession);
+    }
+
+    /*! in this mode ("attach" mode) the application connects to workers
+        already running in "service" mode (see createMPI_ServeSessions)
+        on the given host, which is the host of their first rank */
+    void createMPI_AttachToService(int *ac, const char **av,
+                                   const std::string &host, uint16_t port)
+    {
+      mpi::init(ac,av,true);
+
+      app.comm = world.comm;
+      app.makeIntraComm();
+
+      if (!IamTheMaster()) {
+        throw std::runtime_error("--osp:mpi-attach only makes sense with "
+                                 "a single rank...");
+      }
+
+      postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
+          << "=====================================================\n"
+          << "initializing OSPRay MPI in 'attach to service' mode  \n"
+          << "connecting to " << host << ":" << port << "\n"
+          << "=====================================================";
+
+      char appPortName[MPI_MAX_PORT_NAME] = {0};
+      auto serviceSocket = ospcommon::connect(host.c_str(),port);
+      size_t len;
+      ospcommon::read(serviceSocket,&len,sizeof(len));
+      ospcommon::read(serviceSocket,appPortName,len);
+      ospcommon::close(serviceSocket);
+
+      MPI_CALL(Comm_connect(appPortName,MPI_INFO_NULL,0,app.comm,&worker.comm));
+      worker.makeInterComm();
+
+      mpi::Group mergedComm;
+      MPI_CALL(Intercomm_merge(worker.comm,0,&mergedComm.comm));
+      mergedComm.makeIntraComm();
+      mpi::world.comm = mergedComm.comm;
+      mpi::world.makeIntraComm();
+
+      mpi::world.barrier();
+    }
+
     /*! in this mode ("separate worker group" mode)
       - the user may or may not have launched MPI explicitly for his app
       - the app may or may not be running distributed
@@ -379,7 +533,9 @@ namespace ospray {
     {
       if (IamTheMaster()) {
         postStatusMsg("shutting down mpi device", OSPRAY_MPI_VERBOSE_LEVEL);
-        work::CommandFinalize work;
+        while (!pendingFrames.empty())
+          waitForFrames((OSPFrameBuffer)pendingFrames.begin()->first);
+        work::CommandFinalize work(attachedToService);
         processWork(work, true);
       }
     }
@@ -420,6 +576,25 @@ namespace ospray {
         }
 
         createMPI_connectToListener(&_ac,_av,portName);
+      } else if (mode == "mpi-serve") {
+        createMPI_ServeSessions(&_ac,_av,getParam<int>("servicePort", 3141));
+      } else if (mode == "mpi-attach") {
+        std::string host = getParam<std::string>("serviceHost", "");
+
+        if (host.empty()) {
+          throw std::runtime_error("You must provide the host of the worker "
+                                   "service to attach to!");
+        }
+
+        const auto colon = host.rfind(':');
+        uint16_t port = 3141;
+        if (colon != std::string::npos) {
+          port = std::stoi(host.substr(colon + 1));
+          host = host.substr(0, colon);
+        }
+
+        createMPI_AttachToService(&_ac,_av,host,port);
+        attachedToService = true;
       } else {
         throw std::runtime_error("Invalid MPI mode!");
       }
@@ -447,6 +622,17 @@ namespace ospray {
       /* set up fabric and stuff - by now all the communicators should
          be properly set up */
       mpiFabric   = make_unique<MPIBcastFabric>(mpi::worker, MPI_ROOT, 0);
+      // the workers must agree on compressing the commands, so this can
+      // only be set through the environment
+      if (getEnvVar<int>("OSPRAY_MPI_COMPRESS_COMMANDS").value_or(0))
+        mpiFabric = make_unique<CompressedFabric>(std::move(mpiFabric));
+      // sending the commands from a background thread needs MPI calls
+      // from several threads
+      if (getParam<int>("asyncCommands", true) && mpicommon::mpiIsThreaded) {
+        auto queue = make_unique<networking::QueuedFabric>(std::move(mpiFabric));
+        commandQueue = queue.get();
+        mpiFabric = std::move(queue);
+      }
       readStream  = make_unique<networking::BufferedReadStream>(*mpiFabric);
       writeStream = make_unique<networking::BufferedWriteStream>(*mpiFabric);
     }
@@ -477,9 +663,13 @@ namespace ospray {
 
       size_t bufferSize = 1024 * size_t(writeBufferSize * 1024);
 
+      std::lock_guard<std::recursive_mutex> lock(workMutex);
       writeStream->flush();
       writeStream = make_unique<networking::BufferedWriteStream>(*mpiFabric, bufferSize);
 
+      targetRanks = parseRanks(getParam<std::string>("targetRanks", ""),
+                               worker.size);
+
       work::SetLoadBalancer slbWork(ObjectHandle(),
                                     useDynamicLoadBalancer,
                                     preAllocatedTiles);
@@ -502,6 +692,8 @@ namespace ospray {
     const void *MPIOffloadDevice::frameBufferMap(OSPFrameBuffer _fb,
                                                  OSPFrameBufferChannel channel)
     {
+      waitForFrames(_fb);
+
       ObjectHandle handle = (const ObjectHandle &)_fb;
       FrameBuffer *fb = (FrameBuffer *)handle.lookup();
 
@@ -535,6 +727,13 @@ namespace ospray {
       processWork(work);
     }
 
+    void MPIOffloadDevice::commitBatch(const OSPObject *objects, size_t count)
+    {
+      // one work unit for the whole batch, rather than one per object
+      work::CommitBatch work(objects, count);
+      processWork(work);
+    }
+
     /*! add a new geometry to a model */
     void MPIOffloadDevice::addGeometry(OSPModel _model, OSPGeometry _geometry)
     {
@@ -555,8 +754,9 @@ namespace ospray {
     {
       ObjectHandle handle = allocateHandle();
 
-      work::NewData work(handle, nitems, format, init, flags);
-      processWork(work);
+      work::NewData work(handle, nitems, format, init, flags, targetRanks);
+      // the targeted workers need the work before the data
+      processWork(work, !work.targetRanks.empty());
 
       return (OSPData)(int64)handle;
     }
@@ -587,11 +787,34 @@ namespace ospray {
       delete [] typeString;
 
       Assert(type != OSP_UNKNOWN && "unknown volume voxel type");
-      work::SetRegion work(_volume, index, count, source, type);
-      processWork(work);
+      work::SetRegion work(_volume, index, count, source, type, targetRanks);
+      processWork(work, !targetRanks.empty());
       return true;
     }
 
+    template <typename T>
+    void MPIOffloadDevice::batchParam(OSPObject _object,
+                                      const char *name,
+                                      const T &val)
+    {
+      const ObjectHandle handle = (ObjectHandle&)_object;
+      std::lock_guard<std::recursive_mutex> lock(workMutex);
+      paramBatch.add(handle, paramBatch.internName(name), val);
+
+      // Run the master side variant of setting the parameter
+      work::SetParam<T>(handle, name, val).runOnMaster();
+    }
+
+    template <>
+    void MPIOffloadDevice::batchParam(OSPObject _object,
+                                      const char *name,
+                                      const ObjectHandle &val)
+    {
+      const ObjectHandle handle = (ObjectHandle&)_object;
+      std::lock_guard<std::recursive_mutex> lock(workMutex);
+      paramBatch.add(handle, paramBatch.internName(name), val);
+    }
+
     /*! assign (named) string parameter to an object */
     void MPIOffloadDevice::setString(OSPObject _object,
                                      const char *bufName,
@@ -614,8 +837,7 @@ namespace ospray {
                                    const char *bufName,
                                    const bool b)
     {
-      work::SetParam<bool> work((ObjectHandle&)_object, bufName, b);
-      processWork(work);
+      batchParam(_object, bufName, b);
     }
 
     /*! assign (named) float parameter to an object */
@@ -623,8 +845,7 @@ namespace ospray {
                                     const char *bufName,
                                     const float f)
     {
-      work::SetParam<float> work((ObjectHandle&)_object, bufName, f);
-      processWork(work);
+      batchParam(_object, bufName, f);
     }
 
     /*! assign (named) int parameter to an object */
@@ -632,8 +853,7 @@ namespace ospray {
                                   const char *bufName,
                                   const int i)
     {
-      work::SetParam<int> work((ObjectHandle&)_object, bufName, i);
-      processWork(work);
+      batchParam(_object, bufName, i);
     }
 
     /*! assign (named) vec2f parameter to an object */
@@ -641,8 +861,7 @@ namespace ospray {
                                     const char *bufName,
                                     const vec2f &v)
     {
-      work::SetParam<vec2f> work((ObjectHandle&)_object, bufName, v);
-      processWork(work);
+      batchParam(_object, bufName, v);
     }
 
     /*! assign (named) vec3f parameter to an object */
@@ -650,8 +869,7 @@ namespace ospray {
                                     const char *bufName,
                                     const vec3f &v)
     {
-      work::SetParam<vec3f> work((ObjectHandle&)_object, bufName, v);
-      processWork(work);
+      batchParam(_object, bufName, v);
     }
 
     /*! assign (named) vec4f parameter to an object */
@@ -659,8 +877,7 @@ namespace ospray {
                                     const char *bufName,
                                     const vec4f &v)
     {
-      work::SetParam<vec4f> work((ObjectHandle&)_object, bufName, v);
-      processWork(work);
+      batchParam(_object, bufName, v);
     }
 
     /*! assign (named) vec2i parameter to an object */
@@ -668,8 +885,7 @@ namespace ospray {
                                     const char *bufName,
                                     const vec2i &v)
     {
-      work::SetParam<vec2i> work((ObjectHandle&)_object, bufName, v);
-      processWork(work);
+      batchParam(_object, bufName, v);
     }
 
     /*! assign (named) vec3i parameter to an object */
@@ -677,8 +893,7 @@ namespace ospray {
                                     const char *bufName,
                                     const vec3i &v)
     {
-      work::SetParam<vec3i> work((ObjectHandle&)_object, bufName, v);
-      processWork(work);
+      batchParam(_object, bufName, v);
     }
 
     /*! assign (named) data item as a parameter to an object */
@@ -686,8 +901,7 @@ namespace ospray {
                                      const char *bufName,
                                      OSPObject _value)
     {
-      work::SetParam<OSPObject> work((ObjectHandle&)_target, bufName, _value);
-      processWork(work);
+      batchParam(_target, bufName, (ObjectHandle&)_value);
     }
 
     /*! create a new pixelOp object (out of list of registered pixelOps) */
@@ -796,6 +1010,7 @@ namespace ospray {
     void MPIOffloadDevice::frameBufferClear(OSPFrameBuffer _fb,
                                      const uint32 fbChannelFlags)
     {
+      waitForFrames(_fb);
       work::ClearFrameBuffer work(_fb, fbChannelFlags);
       processWork(work);
     }
@@ -820,11 +1035,110 @@ namespace ospray {
                                         OSPRenderer _renderer,
                                         const uint32 fbChannelFlags)
     {
+      waitForFrames(_fb);
       work::RenderFrame work(_fb, _renderer, fbChannelFlags);
       processWork(work, true);
       return work.varianceResult;
     }
 
+    OSPFuture MPIOffloadDevice::renderFrameAsync(OSPFrameBuffer _fb,
+                                                 OSPRenderer _renderer,
+                                                 const uint32 fbChannelFlags)
+    {
+      // the master renders one frame per frame buffer at a time
+      waitForFrames(_fb);
+
+      auto work = std::make_shared<work::RenderFrame>(_fb, _renderer,
+                                                      fbChannelFlags);
+
+      // NOTE: the work is sent right away from the app thread, so that any
+      //       command issued while the frame is in flight is ordered after
+      //       it on the workers; only the master side of the frame (waiting
+      //       on, and gathering, the DFB) runs in the background
+      sendWork(*work, true);
+
+      auto *fb = (FrameBuffer*)((ObjectHandle&)_fb).lookup();
+      Assert(fb);
+
+      auto *task = new RenderTask(fb, [=]() {
+        work->runOnMaster();
+        reportFrameStats(_fb);
+        return work->varianceResult;
+      });
+
+      // futures only exist on the master, see release()
+      ObjectHandle handle = allocateHandle();
+      handle.assign(task);
+      pendingFrames[((ObjectHandle&)_fb).i64] = task;
+      return (OSPFuture)(int64)handle;
+    }
+
+    void MPIOffloadDevice::waitForFrames(OSPFrameBuffer _fb)
+    {
+      auto frame = pendingFrames.find(((ObjectHandle&)_fb).i64);
+      if (frame == pendingFrames.end())
+        return;
+
+      // errors of the frame are reported by ospWait
+      try {
+        frame->second->wait();
+      } catch (const std::exception &) {
+      }
+      pendingFrames.erase(frame);
+    }
+
+    int MPIOffloadDevice::isReady(OSPFuture _future)
+    {
+      auto *future = (Future*)((ObjectHandle&)_future).lookup();
+      return future->isFinished();
+    }
+
+    float MPIOffloadDevice::wait(OSPFuture _future)
+    {
+      auto *future = (Future*)((ObjectHandle&)_future).lookup();
+      return future->wait();
+    }
+
+    void MPIOffloadDevice::cancel(OSPFuture _future)
+    {
+      auto *future = (Future*)((ObjectHandle&)_future).lookup();
+      future->cancel();
+    }
+
+    float MPIOffloadDevice::getProgress(OSPFuture _future)
+    {
+      auto *future = (Future*)((ObjectHandle&)_future).lookup();
+      return future->getProgress();
+    }
+
+    /*! the master's statistics: it does not render tiles itself, thus
+        only the frame times and skipped tiles are known here */
+    OSPFrameStats MPIOffloadDevice::getFrameStats(OSPFrameBuffer _fb)
+    {
+      ObjectHandle handle = (const ObjectHandle &)_fb;
+      FrameBuffer *fb = (FrameBuffer *)handle.lookup();
+      return fb->getFrameStats();
+    }
+
+    /*! the master's memory: only the objects it keeps itself (frame
+        buffers) are known here, the workers report the memory of their
+        objects in their status messages (log level 2) */
+    OSPMemoryUsage MPIOffloadDevice::getMemoryUsage(OSPObject _object)
+    {
+      ObjectHandle handle = (const ObjectHandle &)_object;
+      if (!handle.defined()) {
+        OSPMemoryUsage usage;
+        usage.bytes = usage.accelBytes = usage.objects = 0;
+        return usage;
+      }
+      return handle.lookup()->getMemoryUsage();
+    }
+
+    OSPMemoryUsage MPIOffloadDevice::getMemoryTotals(OSPMemoryCategory category)
+    {
+      return ManagedObject::getMemoryTotals(category);
+    }
+
     //! release (i.e., reduce refcount of) given object
     /*! note that all objects in ospray are refcounted, so one cannot
       explicitly "delete" any object. instead, each object is created
@@ -837,8 +1151,19 @@ namespace ospray {
       stay 'alive' as long as the given geometry requires it. */
     void MPIOffloadDevice::release(OSPObject _obj)
     {
-      work::CommandRelease work((const ObjectHandle&)_obj);
+      // futures only exist on the master, the workers don't know them
+      ObjectHandle handle = (const ObjectHandle&)_obj;
+      if (handle.defined() && dynamic_cast<Future*>(handle.lookup())) {
+        handle.freeObject();
+        handle.free();
+        return;
+      }
+
+      work::CommandRelease work(handle);
       processWork(work);
+
+      // the workers drop the handle in order, so it can be handed out again
+      handle.free();
     }
 
     //! assign given material to given geometry
@@ -879,8 +1204,53 @@ namespace ospray {
       return work.pickResult;
     }
 
+    void MPIOffloadDevice::pickBatch(OSPRenderer renderer,
+                                     const vec2f *screenPos,
+                                     size_t count,
+                                     OSPPickResult *results)
+    {
+      work::PickBatch work(renderer, screenPos, count, results);
+      processWork(work, true);
+    }
+
+    void MPIOffloadDevice::traceRays(OSPModel model,
+                                     const OSPTraceRay *rays,
+                                     size_t count,
+                                     OSPTraceHit *hits,
+                                     uint32 flags)
+    {
+      work::TraceRays work(model, rays, count, hits, flags);
+      processWork(work, true);
+    }
+
     void MPIOffloadDevice::processWork(work::Work &work, bool flushWriteStream)
     {
+      std::lock_guard<std::recursive_mutex> lock(workMutex);
+      sendWork(work, flushWriteStream);
+
+      // the master side of flushed work waits on the workers, thus
+      // the work has to leave the command queue first
+      if (flushWriteStream && commandQueue)
+        commandQueue->sync();
+
+      // Run the master side variant of the work unit
+      work.runOnMaster();
+
+      postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
+          << "#osp.mpi.master: done work item, tag " << typeIdOf(work)
+          << ": " << typeString(work);
+    }
+
+    void MPIOffloadDevice::sendWork(work::Work &work, bool flushWriteStream)
+    {
+      std::lock_guard<std::recursive_mutex> lock(workMutex);
+
+      // keep the order of the parameter changes and the other work
+      if (&work != &paramBatch && !paramBatch.empty()) {
+        sendWork(paramBatch);
+        paramBatch.clear();
+      }
+
       static size_t numWorkSent = 0;
       postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
           << "#osp.mpi.master: processing/sending work item "
@@ -892,13 +1262,6 @@ namespace ospray {
 
       if (flushWriteStream)
         writeStream->flush();
-
-      // Run the master side variant of the work unit
-      work.runOnMaster();
-
-      postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
-          << "#osp.mpi.master: done work item, tag " << tag << ": "
-          << typeString(work);
     }
 
     ObjectHandle MPIOffloadDevice::allocateHandle() const
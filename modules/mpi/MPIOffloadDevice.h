@@ -18,13 +18,17 @@
 
 // ospcommon
 #include "ospcommon/networking/BufferedDataStreaming.h"
+#include "ospcommon/networking/QueuedFabric.h"
 // mpicommon
 #include "mpiCommon/MPICommon.h"
 // ospray
 #include "api/Device.h"
+#include "common/Future.h"
 #include "common/Managed.h"
 // ospray::mpi
 #include "common/OSPWork.h"
+// std
+#include <mutex>
 
 /*! \file MPIDevice.h Implements the "mpi" device for mpi rendering */
 
@@ -42,6 +46,10 @@ namespace ospray {
 
       // Device Implementation ////////////////////////////////////////////////
 
+      /*! the work of several threads is merged into the command stream, one
+          complete work item (with its reply) at a time */
+      bool isThreadSafe() const override { return true; }
+
       /*! create a new frame buffer */
       OSPFrameBuffer
       frameBufferCreate(const vec2i &size,
@@ -89,6 +97,9 @@ namespace ospray {
       /*! commit the given object's outstanding changes */
       void commit(OSPObject object) override;
 
+      /*! commit the outstanding changes of 'count' objects at once */
+      void commitBatch(const OSPObject *objects, size_t count) override;
+
       /*! add a new geometry to a model */
       void addGeometry(OSPModel _model, OSPGeometry _geometry) override;
 
@@ -188,6 +199,26 @@ namespace ospray {
                         OSPRenderer _renderer,
                         const uint32 fbChannelFlags) override;
 
+      /*! render a frame with the master side of it running in the
+          background, see ospRenderFrameAsync */
+      OSPFuture renderFrameAsync(OSPFrameBuffer _fb,
+                                 OSPRenderer _renderer,
+                                 const uint32 fbChannelFlags) override;
+
+      int isReady(OSPFuture _future) override;
+
+      float wait(OSPFuture _future) override;
+
+      void cancel(OSPFuture _future) override;
+
+      float getProgress(OSPFuture _future) override;
+
+      OSPFrameStats getFrameStats(OSPFrameBuffer _fb) override;
+
+      OSPMemoryUsage getMemoryUsage(OSPObject _object) override;
+
+      OSPMemoryUsage getMemoryTotals(OSPMemoryCategory category) override;
+
       /*! load module */
       int loadModule(const char *name) override;
 
@@ -212,26 +243,68 @@ namespace ospray {
       OSPPickResult pick(OSPRenderer renderer,
                          const vec2f &screenPos) override;
 
+      void pickBatch(OSPRenderer renderer,
+                     const vec2f *screenPos,
+                     size_t count,
+                     OSPPickResult *results) override;
+
+      void traceRays(OSPModel model,
+                     const OSPTraceRay *rays,
+                     size_t count,
+                     OSPTraceHit *hits,
+                     uint32 flags) override;
+
     private:
 
       void initializeDevice();
 
       void processWork(work::Work &work, bool flushWriteStream = false);
 
+      /*! only send the work to the workers, without running its master
+          side variant */
+      void sendWork(work::Work &work, bool flushWriteStream = false);
+
+      /*! collect the parameter change into 'paramBatch', sent with the
+          next other work */
+      template <typename T>
+      void batchParam(OSPObject object, const char *name, const T &val);
+
       /*! This only exists to support getting the voxel type for setRegion */
       int getString(OSPObject object, const char *name, char **value);
 
       ObjectHandle allocateHandle() const;
 
+      /*! wait for the frames rendered asynchronously into 'fb' */
+      void waitForFrames(OSPFrameBuffer fb);
+
       /*! @{ read and write stream for the work commands */
       std::unique_ptr<networking::Fabric>      mpiFabric;
+      //! the command queue (part of 'mpiFabric'), if commands are async
+      networking::QueuedFabric *commandQueue {nullptr};
       std::unique_ptr<networking::ReadStream>  readStream;
       std::unique_ptr<networking::WriteStream> writeStream;
       /*! @} */
 
       work::WorkTypeRegistry workRegistry;
 
+      work::ParamBatch paramBatch;
+
+      /*! serializes the writes to the command stream and 'paramBatch', and
+          the master side of the work (which may wait for the workers'
+          reply), API calls may come from several threads */
+      std::recursive_mutex workMutex;
+
+      //! the last frame rendered asynchronously into each frame buffer
+      std::map<int64, Ref<Future>> pendingFrames;
+
+      /*! the worker ranks (from the device parameter 'targetRanks') which
+          the data of the next ospNewData and ospSetRegion calls is sent
+          to, empty for all */
+      std::vector<int> targetRanks;
+
       bool initialized {false};
+      //! the workers serve further applications after this one
+      bool attachedToService {false};
     };
 
   } // ::ospray::mpi
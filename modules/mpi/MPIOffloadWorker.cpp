@@ -16,6 +16,7 @@
 
 #include "mpiCommon/MPICommon.h"
 #include "mpiCommon/MPIBcastFabric.h"
+#include "common/CompressedFabric.h"
 #include "mpi/MPIOffloadDevice.h"
 #include "api/ISPCDevice.h"
 #include "common/Model.h"
@@ -35,6 +36,7 @@
 #include "ospcommon/utility/getEnvVar.h"
 // std
 #include <algorithm>
+#include <functional>
 
 #ifdef OPEN_MPI
 # include <thread>
@@ -98,22 +100,16 @@ namespace ospray {
       routine to decide which processes call this function and which
       ones don't. This function will not return.
 
+      With 'startSession' given the workers serve successive applications
+      instead: it is called to connect to the next one when a session
+      ended, while the embree device and the loaded modules are kept.
+
       \internal We ssume that mpi::worker and mpi::app have already been set up
     */
-    void runWorker()
+    void runWorker(const std::function<void()> &startSession)
     {
       auto &device = ospray::api::Device::current;
 
-      auto OSPRAY_FORCE_COMPRESSION =
-        utility::getEnvVar<int>("OSPRAY_FORCE_COMPRESSION");
-      // Turning on the compression past 64 ranks seems to be a good
-      // balancing point for cost of compressing vs. performance gain
-      auto enableCompression =
-        OSPRAY_FORCE_COMPRESSION.value_or(
-            mpicommon::numGlobalRanks() >= OSP_MPI_COMPRESSION_THRESHOLD);
-
-      maml::init(enableCompression);
-
       // NOTE(jda) - This guard guarantees that the embree device gets cleaned
       //             up no matter how the scope of runWorker() is left
       struct EmbreeDeviceScopeGuard
@@ -131,6 +127,9 @@ namespace ospray {
       guard.embreeDevice = embreeDevice;
 
       rtcSetDeviceErrorFunction(embreeDevice, embreeErrorFunc, nullptr);
+      rtcSetDeviceMemoryMonitorFunction(embreeDevice,
+          api::ISPCDevice::embreeMemoryMonitor, nullptr);
+      api::ISPCDevice::commitMemoryBudget(*device);
       RTCError erc = rtcGetDeviceError(embreeDevice);
       if (erc != RTC_ERROR_NONE) {
         // why did the error function not get called !?
@@ -144,28 +143,55 @@ namespace ospray {
           << "#w: running MPI worker process " << worker.rank
           << "/" << worker.size << " on pid " << getpid() << "@" << hostname;
 
-      // -------------------------------------------------------
-      // setting up read/write streams
-      // -------------------------------------------------------
-      auto mpiFabric  = make_unique<MPIBcastFabric>(mpi::app, MPI_ROOT, 0);
-      auto readStream = make_unique<networking::BufferedReadStream>(*mpiFabric);
-
       // create registry of work item types
       std::map<work::Work::tag_t,work::CreateWorkFct> workTypeRegistry;
       work::registerOSPWorkItems(workTypeRegistry);
 
-      while (1) {
-        auto work = readWork(workTypeRegistry, *readStream);
-        postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
-            << "#osp.mpi.worker: processing work " << typeIdOf(work)
-            << ": " << typeString(work);
-
-        work->run();
+      do {
+        if (startSession)
+          startSession();
+
+        auto OSPRAY_FORCE_COMPRESSION =
+          utility::getEnvVar<int>("OSPRAY_FORCE_COMPRESSION");
+        // Turning on the compression past 64 ranks seems to be a good
+        // balancing point for cost of compressing vs. performance gain
+        auto enableCompression =
+          OSPRAY_FORCE_COMPRESSION.value_or(
+              mpicommon::numGlobalRanks() >= OSP_MPI_COMPRESSION_THRESHOLD);
+
+        maml::init(enableCompression);
+
+        // -------------------------------------------------------
+        // setting up read/write streams
+        // -------------------------------------------------------
+        std::unique_ptr<networking::Fabric> mpiFabric =
+            make_unique<MPIBcastFabric>(mpi::app, MPI_ROOT, 0);
+        if (getEnvVar<int>("OSPRAY_MPI_COMPRESS_COMMANDS").value_or(0))
+          mpiFabric = make_unique<CompressedFabric>(std::move(mpiFabric));
+        auto readStream =
+            make_unique<networking::BufferedReadStream>(*mpiFabric);
+
+        while (1) {
+          auto work = readWork(workTypeRegistry, *readStream);
+          postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
+              << "#osp.mpi.worker: processing work " << typeIdOf(work)
+              << ": " << typeString(work);
+
+          work->run();
+
+          postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
+              << "#osp.mpi.worker: done w/ work " << typeIdOf(work)
+              << ": " << typeString(work);
+
+          // only returns from 'run' when the session ends
+          if (dynamic_cast<work::CommandFinalize*>(work.get()))
+            break;
+        }
 
-        postStatusMsg(OSPRAY_MPI_VERBOSE_LEVEL)
-            << "#osp.mpi.worker: done w/ work " << typeIdOf(work)
-            << ": " << typeString(work);
-      }
+        // the objects (and handles) of the application are gone with it
+        ObjectHandle::freeAll();
+        messaging::shutdown();
+      } while (startSession);
     }
 
   } // ::ospray::mpi
@@ -20,6 +20,7 @@
 #include <vector>
 #include <random>
 #include <array>
+#include <cstring>
 #include "mpiCommon/MPICommon.h"
 #include "ospcommon/xml/XML.h"
 #include "ospray/ospray_cpp/Data.h"
@@ -173,51 +174,95 @@ namespace gensv {
     return faces;
   }
 
-  LoadedVolume makeBrick(const size_t brickNum, const size_t numBricks) {
-    LoadedVolume vol;
-    vol.tfcn.set("valueRange", vec2f(0, numBricks - 1));
-    vol.tfcn.commit();
+  /* Copy the slab of the voxels at 'index' along 'axis' of the volume to
+   * 'slab' (or back with 'unpack'), in the same order on all ranks.
+   */
+  void copySlab(uint8_t *volume, uint8_t *slab, const size_t voxelSize,
+                const vec3i &dims, const int axis, const int index,
+                const bool unpack)
+  {
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    vec3i p;
+    p[axis] = index;
+    for (p[v] = 0; p[v] < dims[v]; ++p[v]) {
+      for (p[u] = 0; p[u] < dims[u]; ++p[u]) {
+        uint8_t *voxel = volume + voxelSize
+          * (p.x + dims.x * (size_t(p.y) + dims.y * size_t(p.z)));
+        if (unpack) {
+          std::memcpy(voxel, slab, voxelSize);
+        } else {
+          std::memcpy(slab, voxel, voxelSize);
+        }
+        slab += voxelSize;
+      }
+    }
+  }
 
-    const vec3i volumeDims(128);
-    const vec3i grid = computeGrid(numBricks);
-    const vec3f gridSpacing = vec3f(1.f);
-    const vec3i brickId(brickNum % grid.x, (brickNum / grid.x) % grid.y, brickNum / (grid.x * grid.y));
-    const vec3f gridOrigin = vec3f(brickId) * gridSpacing * vec3f(volumeDims);
+  void exchangeGhostVoxels(void *data, const size_t voxelSize,
+                           const vec3i &fullDims, const vec3i &brickId,
+                           const vec3i &grid)
+  {
+    uint8_t *volume = static_cast<uint8_t*>(data);
     const std::array<int, 3> ghosts = computeGhostFaces(brickId, grid);
-    vec3i ghostDims(0);
-    for (size_t i = 0; i < 3; ++i) {
-      if (ghosts[i] & POS_FACE) {
-        ghostDims[i] += 1;
+
+    // Exchanging the axes one after the other sends the ghost layers
+    // received before along, filling the edges and corners as well
+    for (int axis = 0; axis < 3; ++axis) {
+      const int u = (axis + 1) % 3;
+      const int v = (axis + 2) % 3;
+      const size_t slabBytes = voxelSize * fullDims[u] * fullDims[v];
+
+      std::vector<uint8_t> sendSlabs[2], recvSlabs[2];
+      std::vector<MPI_Request> requests;
+      for (int side = 0; side < 2; ++side) {
+        const bool positive = side == 1;
+        if (!(ghosts[axis] & (positive ? POS_FACE : NEG_FACE))) {
+          continue;
+        }
+        vec3i neighbor = brickId;
+        neighbor[axis] += positive ? 1 : -1;
+        const int rank = neighbor.x + grid.x * (neighbor.y + grid.y * neighbor.z);
+        // Tagged with the direction sent in
+        const int sendTag = 2 * axis + side;
+        const int recvTag = 2 * axis + (1 - side);
+
+        recvSlabs[side].resize(slabBytes);
+        requests.push_back(MPI_REQUEST_NULL);
+        MPI_CALL(Irecv(recvSlabs[side].data(), slabBytes, MPI_BYTE, rank,
+                       recvTag, mpicommon::world.comm, &requests.back()));
+
+        sendSlabs[side].resize(slabBytes);
+        copySlab(volume, sendSlabs[side].data(), voxelSize, fullDims, axis,
+                 positive ? fullDims[axis] - 2 : 1, false);
+        requests.push_back(MPI_REQUEST_NULL);
+        MPI_CALL(Isend(sendSlabs[side].data(), slabBytes, MPI_BYTE, rank,
+                       sendTag, mpicommon::world.comm, &requests.back()));
       }
-      if (ghosts[i] & NEG_FACE) {
-        ghostDims[i] += 1;
+
+      MPI_CALL(Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE));
+
+      for (int side = 0; side < 2; ++side) {
+        if (!recvSlabs[side].empty()) {
+          copySlab(volume, recvSlabs[side].data(), voxelSize, fullDims, axis,
+                   side == 1 ? fullDims[axis] - 1 : 0, true);
+        }
       }
     }
-    const vec3i fullDims = volumeDims + ghostDims;
-    const vec3i ghostOffset(ghosts[0] & NEG_FACE ? 1 : 0,
-                               ghosts[1] & NEG_FACE ? 1 : 0,
-                               ghosts[2] & NEG_FACE ? 1 : 0);
-    vol.ghostGridOrigin = gridOrigin - vec3f(ghostOffset) * gridSpacing;
+  }
 
-    vol.volume = ospray::cpp::Volume("block_bricked_volume");
-    vol.volume.set("voxelType", "uchar");
-    vol.volume.set("dimensions", fullDims);
-    vol.volume.set("transferFunction", vol.tfcn);
-    vol.volume.set("gridSpacing", gridSpacing);
-    vol.volume.set("gridOrigin", vol.ghostGridOrigin);
+  LoadedVolume makeBrick(const size_t brickNum, const size_t numBricks) {
+    const vec3i volumeDims(128);
+    const vec3i grid = computeGrid(numBricks);
 
+    // Each brick is filled with its number, the ghost voxels get the
+    // numbers of the neighbouring bricks
     containers::AlignedVector<unsigned char> volumeData(
-      fullDims.x * fullDims.y * fullDims.z, 0
+      volumeDims.x * volumeDims.y * volumeDims.z, brickNum
     );
 
-    for (size_t i = 0; i < volumeData.size(); ++i)
-      volumeData[i] = brickNum;
-
-    vol.volume.setRegion(volumeData.data(), vec3i(0), fullDims);
-    vol.volume.commit();
-
-    vol.bounds = box3f(gridOrigin, gridOrigin + vec3f(volumeDims));
-    return vol;
+    return makeGhostedVolume(volumeData.data(), "uchar", volumeDims, grid,
+                             vec2f(0, numBricks - 1));
   }
 
   LoadedVolume makeVolume() {
@@ -241,6 +286,73 @@ namespace gensv {
     throw std::runtime_error("Unrecognized data type!");
   }
 
+  LoadedVolume makeGhostedVolume(const void *interior,
+                                 const std::string &dtype,
+                                 const vec3i &brickDims,
+                                 const vec3i &grid,
+                                 const vec2f &valueRange,
+                                 const vec3f &gridSpacing)
+  {
+    const int myRank = mpicommon::globalRank();
+    if (grid.x * grid.y * grid.z != mpicommon::numGlobalRanks()) {
+      throw std::runtime_error("makeGhostedVolume: the grid of bricks must "
+                               "have one brick per rank");
+    }
+    const vec3i brickId(myRank % grid.x, (myRank / grid.x) % grid.y,
+                        myRank / (grid.x * grid.y));
+
+    LoadedVolume vol;
+    vol.tfcn.set("valueRange", valueRange);
+    vol.tfcn.commit();
+
+    const vec3f gridOrigin = vec3f(brickId) * gridSpacing * vec3f(brickDims);
+    const std::array<int, 3> ghosts = computeGhostFaces(brickId, grid);
+    vec3i ghostDims(0);
+    for (size_t i = 0; i < 3; ++i) {
+      if (ghosts[i] & POS_FACE) {
+        ghostDims[i] += 1;
+      }
+      if (ghosts[i] & NEG_FACE) {
+        ghostDims[i] += 1;
+      }
+    }
+    const vec3i fullDims = brickDims + ghostDims;
+    const vec3i ghostOffset(ghosts[0] & NEG_FACE ? 1 : 0,
+                            ghosts[1] & NEG_FACE ? 1 : 0,
+                            ghosts[2] & NEG_FACE ? 1 : 0);
+    vol.ghostGridOrigin = gridOrigin - vec3f(ghostOffset) * gridSpacing;
+
+    // Place the interior in the ghosted brick, then fill in the ghosts
+    const size_t voxelSize = sizeForDtype(dtype);
+    containers::AlignedVector<unsigned char> volumeData(
+      voxelSize * fullDims.x * fullDims.y * fullDims.z, 0
+    );
+    const uint8_t *src = static_cast<const uint8_t*>(interior);
+    const size_t rowBytes = voxelSize * brickDims.x;
+    for (int z = 0; z < brickDims.z; ++z) {
+      for (int y = 0; y < brickDims.y; ++y) {
+        const size_t row = ghostOffset.x + fullDims.x
+          * (size_t(y + ghostOffset.y) + fullDims.y * size_t(z + ghostOffset.z));
+        std::memcpy(&volumeData[voxelSize * row], src, rowBytes);
+        src += rowBytes;
+      }
+    }
+    exchangeGhostVoxels(volumeData.data(), voxelSize, fullDims, brickId, grid);
+
+    vol.volume = ospray::cpp::Volume("block_bricked_volume");
+    vol.volume.set("voxelType", dtype.c_str());
+    vol.volume.set("dimensions", fullDims);
+    vol.volume.set("transferFunction", vol.tfcn);
+    vol.volume.set("gridSpacing", gridSpacing);
+    vol.volume.set("gridOrigin", vol.ghostGridOrigin);
+    vol.volume.setRegion(volumeData.data(), vec3i(0), fullDims);
+    vol.volume.commit();
+
+    vol.bounds = box3f(gridOrigin,
+                       gridOrigin + vec3f(brickDims) * gridSpacing);
+    return vol;
+  }
+
   LoadedVolume loadVolume(const FileName &file, const vec3i &dimensions,
                           const std::string &dtype, const vec2f &valueRange)
   {
@@ -283,10 +395,14 @@ namespace gensv {
     const size_t nbytes = fullDims.x * fullDims.y * fullDims.z * dtypeSize;
     containers::AlignedVector<unsigned char> volumeData(nbytes, 0);
 
-    RawReader reader(file, vec3sz(dimensions), dtypeSize);
-    reader.readRegion(brickId * brickDims - vec3sz(ghostOffset),
-                      vec3sz(fullDims),
-                      reinterpret_cast<uint8_t*>(volumeData.data()));
+    // All ranks read their brick from the same file, so read collectively
+    // to let MPI-IO aggregate the reads instead of each rank hitting the
+    // file system on its own
+    readRegionCollective(file, vec3sz(dimensions), dtypeSize,
+                         brickId * brickDims - vec3sz(ghostOffset),
+                         vec3sz(fullDims),
+                         reinterpret_cast<uint8_t*>(volumeData.data()),
+                         mpicommon::world.comm);
 
     vol.volume.setRegion(volumeData.data(), vec3i(0), vec3i(fullDims));
     vol.volume.commit();
@@ -70,5 +70,29 @@ namespace gensv {
    */
   LoadedVolume loadVolume(const FileName &file, const vec3i &dimensions,
                           const std::string &dtype, const vec2f &valueRange);
+
+  /* Fill the one voxel thick ghost layers of this rank's brick with the
+   * border voxels of its neighbours in the grid of bricks, where rank
+   * 'x + grid.x * (y + grid.y * z)' owns the brick (x, y, z). The 'data'
+   * holds the brick with its ghost layers (see computeGhostFaces), which
+   * are exchanged one axis after the other with non-blocking MPI, such
+   * that also the edges and corners are filled. Collective on the world.
+   */
+  void exchangeGhostVoxels(void *data, const size_t voxelSize,
+                           const vec3i &fullDims, const vec3i &brickId,
+                           const vec3i &grid);
+
+  /* Make the block bricked volume of this rank's brick of a volume
+   * decomposed into a grid of equally sized bricks, from only the interior
+   * voxels of the brick. The ghost voxels needed for seam-free
+   * interpolation across the bricks are exchanged with the neighbours of
+   * the rank, see exchangeGhostVoxels. Collective on the world.
+   */
+  LoadedVolume makeGhostedVolume(const void *interior,
+                                 const std::string &dtype,
+                                 const vec3i &brickDims,
+                                 const vec3i &grid,
+                                 const vec2f &valueRange,
+                                 const vec3f &gridSpacing = vec3f(1.f));
 }
 
@@ -14,6 +14,7 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include "raw_reader.h"
@@ -71,5 +72,64 @@ size_t RawReader::readRegion(const vec3sz &start, const vec3sz &size, unsigned c
   return read;
 }
 
+size_t readRegionCollective(const FileName &fileName, const vec3sz &dimensions,
+    size_t voxelSize, const vec3sz &start, const vec3sz &size,
+    unsigned char *buffer, MPI_Comm comm)
+{
+  assert(size.x > 0 && size.y > 0 && size.z > 0);
+
+  // Enable collective buffering, where a subset of the ranks read large
+  // contiguous blocks of the file and distribute them to the others
+  MPI_Info info;
+  MPI_CALL(Info_create(&info));
+  MPI_CALL(Info_set(info, "romio_cb_read", "enable"));
+  MPI_CALL(Info_set(info, "collective_buffering", "true"));
+
+  MPI_File file;
+  const int rc = MPI_File_open(comm, fileName.c_str(),
+                               MPI_MODE_RDONLY, info, &file);
+  MPI_CALL(Info_free(&info));
+  if (rc != MPI_SUCCESS) {
+    throw std::runtime_error("ImportRAW: Unable to open file " + fileName.str());
+  }
+
+  MPI_Datatype voxelType;
+  MPI_CALL(Type_contiguous(voxelSize, MPI_BYTE, &voxelType));
+  MPI_CALL(Type_commit(&voxelType));
+
+  // The voxels are stored with X varying fastest, i.e. in C order of Z, Y, X
+  int sizes[3] = {int(dimensions.z), int(dimensions.y), int(dimensions.x)};
+  int subsizes[3] = {int(size.z), int(size.y), int(size.x)};
+  int starts[3] = {int(start.z), int(start.y), int(start.x)};
+  MPI_Datatype regionType;
+  MPI_CALL(Type_create_subarray(3, sizes, subsizes, starts, MPI_ORDER_C,
+                                voxelType, &regionType));
+  MPI_CALL(Type_commit(&regionType));
+  MPI_CALL(File_set_view(file, 0, voxelType, regionType,
+                         "native", MPI_INFO_NULL));
+
+  // The count of a read is an int, so large regions are read in several
+  // rounds, in which all ranks have to take part
+  const size_t maxVoxels = size_t(1) << 30;
+  const size_t numVoxels = size.x * size.y * size.z;
+  int numRounds = (numVoxels + maxVoxels - 1) / maxVoxels;
+  MPI_CALL(Allreduce(MPI_IN_PLACE, &numRounds, 1, MPI_INT, MPI_MAX, comm));
+
+  size_t read = 0;
+  for (int i = 0; i < numRounds; ++i) {
+    const int count = std::min(maxVoxels, numVoxels - std::min(numVoxels, read));
+    MPI_Status status;
+    MPI_CALL(File_read_all(file, buffer + read * voxelSize, count, voxelType,
+                           &status));
+    int numRead = 0;
+    MPI_CALL(Get_count(&status, voxelType, &numRead));
+    read += std::max(numRead, 0);
+  }
+
+  MPI_CALL(Type_free(&regionType));
+  MPI_CALL(Type_free(&voxelType));
+  MPI_CALL(File_close(&file));
+  return read;
 }
 
+}
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "mpiCommon/MPICommon.h"
 #include "ospcommon/FileName.h"
 #include "ospcommon/vec.h"
 #include <cstdio>
@@ -54,5 +55,16 @@ private:
   }
 };
 
+// Collectively read a region of a RAW volume file on each rank of comm with
+// MPI-IO. Each rank describes its region with a subarray type, so that the
+// MPI implementation can aggregate the reads of all ranks into few large
+// contiguous reads (two-phase collective I/O), instead of each rank seeking
+// through the shared file on its own. Must be called by all ranks of comm.
+// Returns the number of voxels read
+size_t readRegionCollective(const ospcommon::FileName &fileName,
+    const vec3sz &dimensions, size_t voxelSize,
+    const vec3sz &start, const vec3sz &size,
+    unsigned char *buffer, MPI_Comm comm);
+
 }
 
@@ -30,6 +30,7 @@
 // pico_bench
 #include "pico_bench.h"
 // stl
+#include <fstream>
 #include <random>
 #include "gensv/generateSciVis.h"
 
@@ -77,6 +78,16 @@ namespace ospRandSciVisTest {
   static float fovy = 60.f;
   static bool customView = false;
 
+  // compositing settings of the distributed frame buffer and renderer
+  static std::string tileOwnership = "roundRobin";
+  static std::string tileCodec     = "none";
+  static int  compositeRadix       = 2;
+  static bool streamFinalTiles     = false;
+  static bool pipelineFrames       = false;
+  static bool rmaFinalTiles        = false;
+  //! where to write the results as JSON, if at all
+  static std::string jsonFile;
+
   void setupCamera(ospray::cpp::Camera &camera, box3f worldBounds)
   {
     if (!customView) {
@@ -132,6 +143,20 @@ namespace ospRandSciVisTest {
         customView = true;
       } else if (arg == "-fv" || arg == "--fovy") {
         fovy = atof(av[++i]);
+      } else if (arg == "--tile-ownership") {
+        tileOwnership = av[++i];
+      } else if (arg == "--tile-codec") {
+        tileCodec = av[++i];
+      } else if (arg == "--composite-radix") {
+        compositeRadix = std::atoi(av[++i]);
+      } else if (arg == "--stream-final-tiles") {
+        streamFinalTiles = true;
+      } else if (arg == "--pipeline-frames") {
+        pipelineFrames = true;
+      } else if (arg == "--rma-final-tiles") {
+        rmaFinalTiles = true;
+      } else if (arg == "--json") {
+        jsonFile = av[++i];
       }
     }
   }
@@ -169,6 +194,47 @@ namespace ospRandSciVisTest {
                            });
   }
 
+  /* Write the settings and frame time statistics of the benchmark for
+   * scripts comparing runs, e.g. scripts/bench/run_mpi_scaling.py
+   */
+  template <typename T>
+  void writeJSON(const pico_bench::Statistics<T> &stats)
+  {
+    std::ofstream json(jsonFile);
+    if (!json) {
+      std::cerr << "could not write '" << jsonFile << "'\n";
+      return;
+    }
+
+    json << "{\n"
+      << "  \"ranks\": " << (runDistributed ? mpicommon::numGlobalRanks() : 1)
+      << ",\n"
+      << "  \"distributed\": " << (runDistributed ? "true" : "false") << ",\n"
+      << "  \"width\": " << fbSize.x << ",\n"
+      << "  \"height\": " << fbSize.y << ",\n"
+      << "  \"frames\": " << numFrames << ",\n"
+      << "  \"spheresPerNode\": " << numSpheresPerNode << ",\n"
+      << "  \"tileOwnership\": \"" << tileOwnership << "\",\n"
+      << "  \"tileCodec\": \"" << tileCodec << "\",\n"
+      << "  \"compositeRadix\": " << compositeRadix << ",\n"
+      << "  \"streamFinalTiles\": "
+                             << (streamFinalTiles ? "true" : "false") << ",\n"
+      << "  \"pipelineFrames\": "
+                             << (pipelineFrames ? "true" : "false") << ",\n"
+      << "  \"rmaFinalTiles\": "
+                             << (rmaFinalTiles ? "true" : "false") << ",\n"
+      << "  \"frameTime\": {\n"
+      << "    \"unit\": \"" << stats.time_suffix << "\",\n"
+      << "    \"max\": " << stats.max().count() << ",\n"
+      << "    \"min\": " << stats.min().count() << ",\n"
+      << "    \"median\": " << stats.median().count() << ",\n"
+      << "    \"medianAbsDev\": " << stats.median_abs_dev().count() << ",\n"
+      << "    \"mean\": " << stats.mean().count() << ",\n"
+      << "    \"stdDev\": " << stats.std_dev().count() << "\n"
+      << "  }\n"
+      << "}\n";
+  }
+
   void run_benchmark()
   {
     using namespace std::chrono;
@@ -204,9 +270,16 @@ namespace ospRandSciVisTest {
     renderer.set("model", model);
     renderer.set("camera", camera);
     renderer.set("bgColor", vec3f(0.02));
+    renderer.set("tileOwnership", tileOwnership);
     renderer.commit();
 
     ospray::cpp::FrameBuffer fb(fbSize,OSP_FB_SRGBA,OSP_FB_COLOR|OSP_FB_ACCUM);
+    fb.set("tileCodec", tileCodec);
+    fb.set("compositeRadix", compositeRadix);
+    fb.set("streamFinalTiles", int(streamFinalTiles));
+    fb.set("pipelineFrames", int(pipelineFrames));
+    fb.set("rmaFinalTiles", int(rmaFinalTiles));
+    fb.commit();
     fb.clear(OSP_FB_ACCUM);
 
     auto bencher = pico_bench::Benchmarker<milliseconds>{numFrames};
@@ -229,6 +302,8 @@ namespace ospRandSciVisTest {
       // the tiles which they composite.
       if (mpicommon::IamTheMaster()) {
         std::cout << stats << '\n';
+        if (!jsonFile.empty())
+          writeJSON(stats);
         auto *lfb = (uint32_t*)fb.map(OSP_FB_COLOR);
         utility::writePPM("randomSciVisTestDistributed.ppm",
                           fbSize.x, fbSize.y, lfb);
@@ -247,6 +322,10 @@ namespace ospRandSciVisTest {
         renderer.renderFrame(fb, OSP_FB_COLOR | OSP_FB_ACCUM);
       });
 
+      std::cout << stats << '\n';
+      if (!jsonFile.empty())
+        writeJSON(stats);
+
       auto *lfb = (uint32_t*)fb.map(OSP_FB_COLOR);
       utility::writePPM("randomSciVisTestLocal.ppm", fbSize.x, fbSize.y, lfb);
       fb.unmap(lfb);
@@ -0,0 +1,81 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <cstring>
+#include <stdexcept>
+#include <snappy.h>
+#include "CompressedFabric.h"
+
+namespace ospray {
+  namespace mpi {
+
+    CompressedFabric::CompressedFabric(
+        std::unique_ptr<ospcommon::networking::Fabric> fabric)
+      : fabric(std::move(fabric)),
+      readStream(*this->fabric)
+    {}
+
+    void CompressedFabric::send(const void *mem, size_t size)
+    {
+      BlockHeader header {size, 0};
+      if (size >= minCompressedSize) {
+        compressed.resize(sizeof(header) + snappy::MaxCompressedLength(size));
+        size_t compressedSize = 0;
+        snappy::RawCompress(static_cast<const char*>(mem), size,
+                            compressed.data() + sizeof(header),
+                            &compressedSize);
+        if (compressedSize < size) {
+          header.compressedSize = compressedSize;
+          std::memcpy(compressed.data(), &header, sizeof(header));
+          fabric->send(compressed.data(), sizeof(header) + compressedSize);
+          return;
+        }
+      }
+
+      // send the block directly instead of copying it behind the header
+      fabric->send(&header, sizeof(header));
+      fabric->send(mem, size);
+    }
+
+    size_t CompressedFabric::read(void *&mem)
+    {
+      BlockHeader header;
+      readStream.read(&header, sizeof(header));
+
+      buffer.resize(header.size);
+      if (header.compressedSize == 0) {
+        readStream.read(buffer.data(), header.size);
+      } else {
+        compressed.resize(header.compressedSize);
+        readStream.read(compressed.data(), header.compressedSize);
+        size_t uncompressedSize = 0;
+        if (!snappy::GetUncompressedLength(compressed.data(),
+                                           header.compressedSize,
+                                           &uncompressedSize)
+            || uncompressedSize != header.size
+            || !snappy::RawUncompress(compressed.data(), header.compressedSize,
+                                   buffer.data())) {
+          throw std::runtime_error("CompressedFabric: received a corrupted "
+                                   "block");
+        }
+      }
+
+      mem = buffer.data();
+      return header.size;
+    }
+
+  } // ::ospray::mpi
+} // ::ospray
@@ -0,0 +1,61 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "ospcommon/networking/BufferedDataStreaming.h"
+#include "ospcommon/networking/Fabric.h"
+
+namespace ospray {
+  namespace mpi {
+
+    /*! A fabric which snappy compresses the blocks sent over another one,
+        to save bandwidth when the commands carry large data arrays. Blocks
+        smaller than 'minCompressedSize', or which do not get smaller, are
+        sent as they are. Both sides of the connection must use it */
+    struct CompressedFabric : public ospcommon::networking::Fabric
+    {
+      CompressedFabric(std::unique_ptr<ospcommon::networking::Fabric> fabric);
+      ~CompressedFabric() override = default;
+
+      void send(const void *mem, size_t size) override;
+
+      size_t read(void *&mem) override;
+
+      //! smaller blocks are not worth the cost of compressing
+      static constexpr size_t minCompressedSize = 1024;
+
+    private:
+
+      //! precedes each block sent over 'fabric'
+      struct BlockHeader
+      {
+        uint64_t size;
+        //! 0 if the block is not compressed
+        uint64_t compressedSize;
+      };
+
+      std::unique_ptr<ospcommon::networking::Fabric> fabric;
+      //! the blocks of 'fabric' may be split or joined up
+      ospcommon::networking::BufferedReadStream readStream;
+      std::vector<char> compressed;
+      std::vector<char> buffer;
+    };
+
+  } // ::ospray::mpi
+} // ::ospray
@@ -147,6 +147,11 @@ namespace ospray {
         maml::stop();
       }
 
+      void shutdown()
+      {
+        handler = nullptr;
+      }
+
     } // ::ospray::mpi::messaging
   } // ::ospray::mpi
 } // ::ospray
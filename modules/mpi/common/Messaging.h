@@ -58,6 +58,11 @@ namespace ospray {
 
       void disableAsyncMessaging();
 
+      /*! drop the message handler registered with maml for the world
+          communicator, once all listeners are gone and maml is shut down,
+          such that a new one is set up with the next maml context */
+      void shutdown();
+
       // collective messaging interface ///////////////////////////////////////
 
       // Broadcast some data, if rank == rootGlobalRank we send data, otherwise
@@ -14,9 +14,11 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <algorithm>
 #include <vector>
 
 #include "mpiCommon/MPICommon.h"
+#include "mpiCommon/Tracing.h"
 #include "OSPWork.h"
 #include "ospray/common/ObjectHandle.h"
 #include "mpi/fb/DistributedFrameBuffer.h"
@@ -52,6 +54,7 @@ namespace ospray {
         registerWorkUnit<NewTexture>(registry);
 
         registerWorkUnit<CommitObject>(registry);
+        registerWorkUnit<CommitBatch>(registry);
         registerWorkUnit<CommandRelease>(registry);
 
         registerWorkUnit<LoadModule>(registry);
@@ -79,11 +82,14 @@ namespace ospray {
         registerWorkUnit<SetParam<vec3f>>(registry);
         registerWorkUnit<SetParam<vec3i>>(registry);
         registerWorkUnit<SetParam<vec4f>>(registry);
+        registerWorkUnit<ParamBatch>(registry);
 
         registerWorkUnit<RemoveParam>(registry);
 
         registerWorkUnit<CommandFinalize>(registry);
         registerWorkUnit<Pick>(registry);
+        registerWorkUnit<PickBatch>(registry);
+        registerWorkUnit<TraceRays>(registry);
       }
 
       // SetLoadBalancer //////////////////////////////////////////////////////
@@ -141,6 +147,7 @@ namespace ospray {
       {
         ManagedObject *obj = handle.lookup();
         if (obj) {
+          obj->lastCommitted.renew();
           obj->commit();
         } else {
           throw std::runtime_error("Error: rank "
@@ -153,7 +160,9 @@ namespace ospray {
       {
         if (handle.defined()) {
           ManagedObject *obj = handle.lookup();
-          if (dynamic_cast<Renderer*>(obj)) {
+          // the master's frame buffer needs e.g. the render region
+          if (dynamic_cast<Renderer*>(obj) || dynamic_cast<FrameBuffer*>(obj)) {
+            obj->lastCommitted.renew();
             obj->commit();
           }
         }
@@ -169,6 +178,56 @@ namespace ospray {
         b >> handle.i64;
       }
 
+      // CommitBatch //////////////////////////////////////////////////////////
+
+      CommitBatch::CommitBatch(const OSPObject *objects, size_t count)
+      {
+        handles.reserve(count);
+        for (size_t i = 0; i < count; i++)
+          handles.push_back((const ObjectHandle &)objects[i]);
+      }
+
+      void CommitBatch::run()
+      {
+        std::vector<ManagedObject *> objects;
+        for (const int64 h : handles) {
+          ManagedObject *obj = ObjectHandle(h).lookup();
+          if (!obj) {
+            throw std::runtime_error("Error: rank "
+                                     + std::to_string(mpicommon::world.rank)
+                                     + " did not have object to commit!");
+          }
+          objects.push_back(obj);
+        }
+        commitInDependencyOrder(objects.data(), objects.size());
+      }
+
+      void CommitBatch::runOnMaster()
+      {
+        // like CommitObject, the master only commits renderers and frame
+        // buffers
+        std::vector<ManagedObject *> objects;
+        for (const int64 h : handles) {
+          const ObjectHandle handle(h);
+          if (!handle.defined())
+            continue;
+          ManagedObject *obj = handle.lookup();
+          if (dynamic_cast<Renderer*>(obj) || dynamic_cast<FrameBuffer*>(obj))
+            objects.push_back(obj);
+        }
+        commitInDependencyOrder(objects.data(), objects.size());
+      }
+
+      void CommitBatch::serialize(WriteStream &b) const
+      {
+        b << handles;
+      }
+
+      void CommitBatch::deserialize(ReadStream &b)
+      {
+        b >> handles;
+      }
+
       // ospNewFrameBuffer ////////////////////////////////////////////////////
 
       CreateFrameBuffer::CreateFrameBuffer(ObjectHandle handle,
@@ -258,6 +317,181 @@ namespace ospray {
         }
       }
 
+      // ParamBatch ///////////////////////////////////////////////////////////
+
+      static size_t sizeOfParam(ParamBatch::ParamType type)
+      {
+        switch (type) {
+        case ParamBatch::PARAM_INT:    return sizeof(int);
+        case ParamBatch::PARAM_BOOL:   return sizeof(bool);
+        case ParamBatch::PARAM_FLOAT:  return sizeof(float);
+        case ParamBatch::PARAM_VEC2F:  return sizeof(vec2f);
+        case ParamBatch::PARAM_VEC2I:  return sizeof(vec2i);
+        case ParamBatch::PARAM_VEC3F:  return sizeof(vec3f);
+        case ParamBatch::PARAM_VEC3I:  return sizeof(vec3i);
+        case ParamBatch::PARAM_VEC4F:  return sizeof(vec4f);
+        case ParamBatch::PARAM_OBJECT: return sizeof(int64);
+        }
+        throw std::runtime_error("invalid parameter type in ParamBatch");
+      }
+
+      //! (worker) the names interned by the master, by their ID
+      static std::vector<std::string> &internedParamNames()
+      {
+        static std::vector<std::string> names;
+        return names;
+      }
+
+      uint32 ParamBatch::internName(const std::string &name)
+      {
+        auto it = nameIDs.find(name);
+        if (it != nameIDs.end())
+          return it->second;
+
+        const uint32 id = nameIDs.size();
+        nameIDs[name] = id;
+        newNames.emplace_back(id, name);
+        return id;
+      }
+
+      void ParamBatch::add(ObjectHandle handle, uint32 nameID, ParamType type,
+                           const void *value)
+      {
+        Assert(handle != nullHandle);
+        const auto key = std::make_pair(handle.i64, nameID);
+        auto it = entryIndex.find(key);
+        if (it == entryIndex.end()) {
+          it = entryIndex.emplace(key, entries.size()).first;
+          entries.emplace_back();
+        }
+
+        Entry &entry = entries[it->second];
+        entry.handle = handle.i64;
+        entry.nameID = nameID;
+        entry.type = type;
+        std::memcpy(entry.value, value, sizeOfParam(type));
+      }
+
+      bool ParamBatch::empty() const
+      {
+        return entries.empty() && newNames.empty();
+      }
+
+      void ParamBatch::clear()
+      {
+        newNames.clear();
+        entries.clear();
+        entryIndex.clear();
+      }
+
+      void ParamBatch::run()
+      {
+        auto &names = internedParamNames();
+        for (const auto &name : newNames) {
+          if (name.first >= names.size())
+            names.resize(name.first + 1);
+          names[name.first] = name.second;
+        }
+
+        ManagedObject *obj = nullptr;
+        int64 objHandle = 0;
+        for (const auto &entry : entries) {
+          if (!obj || entry.handle != objHandle) {
+            objHandle = entry.handle;
+            obj = ObjectHandle(objHandle).lookup();
+            Assert(obj);
+          }
+
+          const std::string &name = names[entry.nameID];
+          const void *value = entry.value;
+          switch (entry.type) {
+          case PARAM_INT:
+            obj->setParam(name, *(const int*)value);
+            break;
+          case PARAM_BOOL:
+            obj->setParam(name, *(const bool*)value);
+            break;
+          case PARAM_FLOAT:
+            obj->setParam(name, *(const float*)value);
+            break;
+          case PARAM_VEC2F:
+            obj->setParam(name, *(const vec2f*)value);
+            break;
+          case PARAM_VEC2I:
+            obj->setParam(name, *(const vec2i*)value);
+            break;
+          case PARAM_VEC3F:
+            obj->setParam(name, *(const vec3f*)value);
+            break;
+          case PARAM_VEC3I:
+            obj->setParam(name, *(const vec3i*)value);
+            break;
+          case PARAM_VEC4F:
+            obj->setParam(name, *(const vec4f*)value);
+            break;
+          case PARAM_OBJECT: {
+            const ObjectHandle handle(*(const int64*)value);
+            ManagedObject *param = nullptr;
+            if (handle != NULL_HANDLE) {
+              param = handle.lookup();
+              Assert(param);
+            }
+            obj->setParam(name.c_str(), param);
+            break;
+          }
+          }
+        }
+      }
+
+      void ParamBatch::serialize(WriteStream &b) const
+      {
+        b << uint32(newNames.size());
+        for (const auto &name : newNames)
+          b << name.first << name.second;
+
+        // one record of all parameters per object
+        std::map<int64, std::vector<const Entry*>> records;
+        for (const auto &entry : entries)
+          records[entry.handle].push_back(&entry);
+
+        b << uint32(records.size());
+        for (const auto &record : records) {
+          b << record.first << uint32(record.second.size());
+          for (const Entry *entry : record.second) {
+            b << entry->nameID << uint8(entry->type);
+            b.write(entry->value, sizeOfParam(entry->type));
+          }
+        }
+      }
+
+      void ParamBatch::deserialize(ReadStream &b)
+      {
+        clear();
+
+        uint32 numNames = 0;
+        b >> numNames;
+        newNames.resize(numNames);
+        for (auto &name : newNames)
+          b >> name.first >> name.second;
+
+        uint32 numRecords = 0;
+        b >> numRecords;
+        for (uint32 i = 0; i < numRecords; ++i) {
+          int64 handle = 0;
+          uint32 numParams = 0;
+          b >> handle >> numParams;
+          for (uint32 j = 0; j < numParams; ++j) {
+            Entry entry;
+            uint8 type = 0;
+            entry.handle = handle;
+            b >> entry.nameID >> type;
+            entry.type = ParamType(type);
+            b.read(entry.value, sizeOfParam(entry.type));
+            entries.push_back(entry);
+          }
+        }
+      }
+
       // ospSetMaterial ///////////////////////////////////////////////////////
 
       void SetMaterial::run()
@@ -322,18 +556,69 @@ namespace ospray {
         handle.assign(material);
       }
 
+      // Targeted (point-to-point) payloads ////////////////////////////////////
+
+      //! p2p messages are limited to 2GB, larger payloads are split
+      static constexpr size_t maxPayloadChunk = 1LL << 30;
+      static constexpr int payloadTag = 0;
+
+      static bool isTargeted(const std::vector<int> &targetRanks)
+      {
+        return std::find(targetRanks.begin(), targetRanks.end(),
+                         mpicommon::worker.rank) != targetRanks.end();
+      }
+
+      /*! send the payload of a work item from the master to the given
+          worker ranks over the app/worker intercommunicator (which
+          maml does not listen on). The workers receive the payloads in
+          the order of the work items, so all use the same tag */
+      static void sendPayload(const utility::ArrayView<byte_t> &payload,
+                              const std::vector<int> &targetRanks)
+      {
+        std::vector<MPI_Request> requests;
+        for (int rank : targetRanks) {
+          for (size_t begin = 0; begin < payload.size();
+               begin += maxPayloadChunk) {
+            const int count = std::min(maxPayloadChunk, payload.size() - begin);
+            requests.emplace_back();
+            MPI_CALL(Isend(payload.data() + begin, count, MPI_BYTE, rank,
+                           payloadTag, mpicommon::worker.comm,
+                           &requests.back()));
+          }
+        }
+        MPI_CALL(Waitall(requests.size(), requests.data(),
+                         MPI_STATUSES_IGNORE));
+      }
+
+      static void receivePayload(std::vector<byte_t> &payload)
+      {
+        for (size_t begin = 0; begin < payload.size();
+             begin += maxPayloadChunk) {
+          const int count = std::min(maxPayloadChunk, payload.size() - begin);
+          MPI_CALL(Recv(payload.data() + begin, count, MPI_BYTE, 0,
+                        payloadTag, mpicommon::app.comm,
+                        MPI_STATUS_IGNORE));
+        }
+      }
+
       // ospNewData ///////////////////////////////////////////////////////////
 
       NewData::NewData(ObjectHandle handle,
                        size_t nItems,
                        OSPDataType format,
                        const void *_initMem,
-                       int flags)
+                       int flags,
+                       const std::vector<int> &targetRanks)
         : handle(handle),
           nItems(nItems),
           format(format),
-          flags(flags)
+          flags(flags),
+          targetRanks(targetRanks)
       {
+        // without initial data all workers create the same data
+        if (!_initMem || !nItems)
+          this->targetRanks.clear();
+
         if (_initMem && nItems) {
           auto numBytes = sizeOf(format) * nItems;
 
@@ -355,6 +640,16 @@ namespace ospray {
         // it), so let's assert that nobody accidentally uses it.
         assert(format != OSP_STRING);
 
+        if (!targetRanks.empty()) {
+          if (!isTargeted(targetRanks)) {
+            handle.assign(new Data(0, format, nullptr));
+            return;
+          }
+          copiedData.resize(sizeOf(format) * nItems);
+          receivePayload(copiedData);
+          dataView = copiedData;
+        }
+
         if (format == OSP_OBJECT ||
             format == OSP_CAMERA  ||
             format == OSP_DATA ||
@@ -387,25 +682,37 @@ namespace ospray {
         handle.assign(ospdata);
       }
 
+      void NewData::runOnMaster()
+      {
+        if (!targetRanks.empty() && dataView.size() > 0)
+          sendPayload(dataView, targetRanks);
+      }
+
       void NewData::serialize(WriteStream &b) const
       {
-        b << (int64)handle << nItems << (int32)format << flags << dataView;
+        b << (int64)handle << nItems << (int32)format << flags << targetRanks;
+        if (targetRanks.empty())
+          b << dataView;
       }
 
       void NewData::deserialize(ReadStream &b)
       {
         int32 fmt;
-        b >> handle.i64 >> nItems >> fmt >> flags >> copiedData;
-        dataView = copiedData;
+        b >> handle.i64 >> nItems >> fmt >> flags >> targetRanks;
+        if (targetRanks.empty()) {
+          b >> copiedData;
+          dataView = copiedData;
+        }
         format = (OSPDataType)fmt;
       }
 
       // ospSetRegion /////////////////////////////////////////////////////////
 
       SetRegion::SetRegion(OSPVolume volume, vec3i start, vec3i size,
-                           const void *src, OSPDataType type)
+                           const void *src, OSPDataType type,
+                           const std::vector<int> &targetRanks)
         : handle((ObjectHandle&)volume), regionStart(start),
-          regionSize(size), type(type)
+          regionSize(size), type(type), targetRanks(targetRanks)
       {
         size_t bytes = ospray::sizeOf(type) * size.x * size.y * size.z;
         // TODO: With the MPI batching this limitation should be lifted
@@ -421,6 +728,14 @@ namespace ospray {
 
       void SetRegion::run()
       {
+        if (!targetRanks.empty()) {
+          if (!isTargeted(targetRanks))
+            return;
+          data.resize(ospray::sizeOf(type) * regionSize.x * regionSize.y
+                      * regionSize.z);
+          receivePayload(data);
+        }
+
         Volume *volume = (Volume*)handle.lookup();
         Assert(volume);
         // TODO: Does it make sense to do the allreduce & report back fails?
@@ -431,15 +746,27 @@ namespace ospray {
         }
       }
 
+      void SetRegion::runOnMaster()
+      {
+        if (!targetRanks.empty()) {
+          sendPayload(data, targetRanks);
+        }
+      }
+
       void SetRegion::serialize(WriteStream &b) const
       {
-        b << (int64)handle << regionStart << regionSize << (int32)type << data;
+        b << (int64)handle << regionStart << regionSize << (int32)type
+          << targetRanks;
+        if (targetRanks.empty())
+          b << data;
       }
 
       void SetRegion::deserialize(ReadStream &b)
       {
         int32 ty;
-        b >> handle.i64 >> regionStart >> regionSize >> ty >> data;
+        b >> handle.i64 >> regionStart >> regionSize >> ty >> targetRanks;
+        if (targetRanks.empty())
+          b >> data;
         type = (OSPDataType)ty;
       }
 
@@ -489,7 +816,11 @@ namespace ospray {
         FrameBuffer *fb    = (FrameBuffer*)fbHandle.lookup();
         Assert(renderer);
         Assert(fb);
-        varianceResult = renderer->renderFrame(fb, channels);
+        {
+          mpicommon::tracing::Scope trace("frame");
+          varianceResult = renderer->renderFrame(fb, channels);
+        }
+        mpicommon::tracing::endFrame();
       }
 
       void RenderFrame::runOnMaster()
@@ -582,7 +913,8 @@ namespace ospray {
       void RemoveParam::runOnMaster()
       {
         ManagedObject *obj = handle.lookup();
-        if (dynamic_cast<Renderer*>(obj) || dynamic_cast<Volume*>(obj)) {
+        if (dynamic_cast<Renderer*>(obj) || dynamic_cast<Volume*>(obj)
+            || dynamic_cast<FrameBuffer*>(obj)) {
           obj->removeParam(name.c_str());
         }
       }
@@ -658,8 +990,20 @@ namespace ospray {
 
       // ospFinalize //////////////////////////////////////////////////////////
 
+      CommandFinalize::CommandFinalize(bool endSession)
+        : endSession(endSession)
+      {}
+
       void CommandFinalize::run()
       {
+        // workers serving several applications only leave the session,
+        // the worker loop then connects to the next application
+        if (endSession) {
+          maml::shutdown();
+          world.barrier();
+          return;
+        }
+
         runOnMaster();
 
         // TODO: Is it ok to call exit again here?
@@ -676,14 +1020,24 @@ namespace ospray {
       {
         maml::shutdown();
         world.barrier();
+        // finalizing waits for all connected processes, which the
+        // workers of a service are not going to do
+        if (endSession) {
+          MPI_CALL(Comm_disconnect(&world.comm));
+          MPI_CALL(Comm_disconnect(&worker.comm));
+        }
         MPI_CALL(Finalize());
       }
 
-      void CommandFinalize::serialize(WriteStream &) const
-      {}
+      void CommandFinalize::serialize(WriteStream &b) const
+      {
+        b << endSession;
+      }
 
-      void CommandFinalize::deserialize(ReadStream &)
-      {}
+      void CommandFinalize::deserialize(ReadStream &b)
+      {
+        b >> endSession;
+      }
 
       Pick::Pick(OSPRenderer renderer, const vec2f &screenPos)
         : rendererHandle((ObjectHandle&)renderer), screenPos(screenPos)
@@ -720,6 +1074,98 @@ namespace ospray {
         b >> rendererHandle.i64 >> screenPos;
       }
 
+      PickBatch::PickBatch(OSPRenderer renderer,
+                           const vec2f *screenPos,
+                           size_t count,
+                           OSPPickResult *results)
+        : rendererHandle((ObjectHandle&)renderer),
+          screenPos(screenPos, screenPos + count),
+          results(results)
+      {}
+
+      void PickBatch::run()
+      {
+        // Like Pick, but all positions in one message each way
+        if (mpicommon::world.rank == 1) {
+          Renderer *renderer = (Renderer*)rendererHandle.lookup();
+          Assert(renderer);
+          std::vector<OSPPickResult> pickResults(screenPos.size());
+          renderer->pick(screenPos.data(), screenPos.size(),
+                         pickResults.data());
+          MPI_CALL(Send(pickResults.data(),
+                        int(pickResults.size() * sizeof(OSPPickResult)),
+                        MPI_BYTE, 0, 0, mpicommon::world.comm));
+        }
+        mpicommon::worker.barrier();
+      }
+
+      void PickBatch::runOnMaster()
+      {
+        MPI_CALL(Recv(results, int(screenPos.size() * sizeof(OSPPickResult)),
+                      MPI_BYTE, 1, 0, mpicommon::world.comm,
+                      MPI_STATUS_IGNORE));
+      }
+
+      void PickBatch::serialize(WriteStream &b) const
+      {
+        b << (int64)rendererHandle << screenPos;
+      }
+
+      void PickBatch::deserialize(ReadStream &b)
+      {
+        b >> rendererHandle.i64 >> screenPos;
+      }
+
+      // TraceRays ////////////////////////////////////////////////////////////
+
+      TraceRays::TraceRays(OSPModel model,
+                           const OSPTraceRay *rays,
+                           size_t count,
+                           OSPTraceHit *hits,
+                           uint32 flags)
+        : modelHandle((ObjectHandle&)model),
+          flags(flags),
+          rays(rays, rays + count),
+          hits(hits)
+      {}
+
+      void TraceRays::run()
+      {
+        // Like PickBatch, the first worker traces all rays
+        if (mpicommon::world.rank == 1) {
+          Model *model = (Model*)modelHandle.lookup();
+          Assert(model);
+          std::vector<OSPTraceHit> traceHits(rays.size());
+          model->traceRays(rays.data(), rays.size(), traceHits.data(), flags);
+          MPI_CALL(Send(traceHits.data(),
+                        int(traceHits.size() * sizeof(OSPTraceHit)),
+                        MPI_BYTE, 0, 0, mpicommon::world.comm));
+        }
+        mpicommon::worker.barrier();
+      }
+
+      void TraceRays::runOnMaster()
+      {
+        MPI_CALL(Recv(hits, int(rays.size() * sizeof(OSPTraceHit)),
+                      MPI_BYTE, 1, 0, mpicommon::world.comm,
+                      MPI_STATUS_IGNORE));
+      }
+
+      void TraceRays::serialize(WriteStream &b) const
+      {
+        // the rays as one block, not element-wise like std::vector
+        b << (int64)modelHandle << flags << rays.size();
+        b.write(rays.data(), rays.size() * sizeof(OSPTraceRay));
+      }
+
+      void TraceRays::deserialize(ReadStream &b)
+      {
+        size_t count = 0;
+        b >> modelHandle.i64 >> flags >> count;
+        rays.resize(count);
+        b.read(rays.data(), count * sizeof(OSPTraceRay));
+      }
+
     } // ::ospray::mpi::work
   } // ::ospray::mpi
 } // ::ospray
@@ -248,10 +248,14 @@ namespace ospray {
       {
         NewData() = default;
         NewData(ObjectHandle handle, size_t nItems,
-                OSPDataType format, const void *initData, int flags);
+                OSPDataType format, const void *initData, int flags,
+                const std::vector<int> &targetRanks = {});
 
         void run() override;
 
+        /*! sends the data to the 'targetRanks', if any */
+        void runOnMaster() override;
+
         /*! serializes itself on the given serial buffer - will write
           all data into this buffer in a way that it can afterwards
           un-serialize itself 'on the other side'*/
@@ -271,16 +275,24 @@ namespace ospray {
                                             //    on flags given on construction
 
         int32 flags;
+
+        /*! the worker ranks receiving the data (with point-to-point
+            messages instead of the broadcast), empty for all. The other
+            workers create an empty data */
+        std::vector<int> targetRanks;
       };
 
       struct SetRegion : public Work
       {
         SetRegion() = default;
         SetRegion(OSPVolume volume, vec3i start, vec3i size, const void *src,
-                  OSPDataType type);
+                  OSPDataType type, const std::vector<int> &targetRanks = {});
 
         void run() override;
 
+        /*! sends the region to the 'targetRanks', if any */
+        void runOnMaster() override;
+
         /*! serializes itself on the given serial buffer - will write
           all data into this buffer in a way that it can afterwards
           un-serialize itself 'on the other side'*/
@@ -295,6 +307,10 @@ namespace ospray {
         vec3i               regionSize;
         OSPDataType         type;
         std::vector<byte_t> data;
+
+        /*! the worker ranks receiving the region, empty for all. The other
+            workers leave the volume unchanged */
+        std::vector<int> targetRanks;
       };
 
       struct CommitObject : public Work
@@ -318,6 +334,27 @@ namespace ospray {
         ObjectHandle handle;
       };
 
+      /*! commit several objects at once, in dependency order */
+      struct CommitBatch : public Work
+      {
+        CommitBatch() = default;
+        CommitBatch(const OSPObject *objects, size_t count);
+
+        void run() override;
+        void runOnMaster() override;
+
+        /*! serializes itself on the given serial buffer - will write
+          all data into this buffer in a way that it can afterwards
+          un-serialize itself 'on the other side'*/
+        void serialize(WriteStream &b) const override;
+
+        /*! de-serialize from a buffer that an object of this type has
+          serialized itself in */
+        void deserialize(ReadStream &b) override;
+
+        std::vector<int64> handles;
+      };
+
       struct ClearFrameBuffer : public Work
       {
         ClearFrameBuffer() = default;
@@ -514,7 +551,8 @@ namespace ospray {
             return;
 
           ManagedObject *obj = handle.lookup();
-          if (dynamic_cast<Renderer*>(obj) || dynamic_cast<Volume*>(obj)) {
+          if (dynamic_cast<Renderer*>(obj) || dynamic_cast<Volume*>(obj)
+              || dynamic_cast<FrameBuffer*>(obj)) {
             obj->setParam(name, val);
           }
         }
@@ -615,6 +653,95 @@ namespace ospray {
         ObjectHandle val;
       };
 
+      /*! the parameter changes (of plain types and objects) collected
+          on the master since the last other work, sent as one work
+          item with a compact record per object. Parameter names are
+          interned: each name is sent once with its ID, later batches
+          only send the ID */
+      struct ParamBatch : public Work
+      {
+        enum ParamType : uint8
+        {
+          PARAM_INT, PARAM_BOOL, PARAM_FLOAT, PARAM_VEC2F, PARAM_VEC2I,
+          PARAM_VEC3F, PARAM_VEC3I, PARAM_VEC4F, PARAM_OBJECT
+        };
+
+        ParamBatch() = default;
+
+        //! set the parameter 'nameID' (defined before) of 'handle' to 'val'
+        template <typename T>
+        void add(ObjectHandle handle, uint32 nameID, const T &val);
+
+        //! the ID of the parameter 'name', defining it with the next batch
+        uint32 internName(const std::string &name);
+
+        bool empty() const;
+        void clear();
+
+        void run() override;
+
+        /*! serializes itself on the given serial buffer - will write
+          all data into this buffer in a way that it can afterwards
+          un-serialize itself 'on the other side'*/
+        void serialize(WriteStream &b) const override;
+
+        /*! de-serialize from a buffer that an object of this type has
+          serialized itself in */
+        void deserialize(ReadStream &b) override;
+
+      private:
+
+        struct Entry
+        {
+          int64 handle;
+          uint32 nameID;
+          ParamType type;
+          byte_t value[16];
+        };
+
+        void add(ObjectHandle handle, uint32 nameID, ParamType type,
+                 const void *value);
+
+        //! the names defined with this batch
+        std::vector<std::pair<uint32, std::string>> newNames;
+        //! the parameters set, the last change of one replaces the others
+        std::vector<Entry> entries;
+        std::map<std::pair<int64, uint32>, size_t> entryIndex;
+
+        //! (master) all interned names
+        std::map<std::string, uint32> nameIDs;
+      };
+
+      template <typename T>
+      struct ParamTypeOf;
+      template <> struct ParamTypeOf<int>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_INT; };
+      template <> struct ParamTypeOf<bool>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_BOOL; };
+      template <> struct ParamTypeOf<float>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_FLOAT; };
+      template <> struct ParamTypeOf<vec2f>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_VEC2F; };
+      template <> struct ParamTypeOf<vec2i>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_VEC2I; };
+      template <> struct ParamTypeOf<vec3f>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_VEC3F; };
+      template <> struct ParamTypeOf<vec3i>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_VEC3I; };
+      template <> struct ParamTypeOf<vec4f>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_VEC4F; };
+      template <> struct ParamTypeOf<ObjectHandle>
+      { static constexpr ParamBatch::ParamType value = ParamBatch::PARAM_OBJECT; };
+
+      template <typename T>
+      inline void ParamBatch::add(ObjectHandle handle, uint32 nameID,
+                                  const T &val)
+      {
+        static_assert(sizeof(T) <= sizeof(Entry::value),
+                      "parameter type too large for ParamBatch");
+        add(handle, nameID, ParamTypeOf<T>::value, &val);
+      }
+
       struct RemoveParam : public Work
       {
         RemoveParam() = default;
@@ -701,6 +828,8 @@ namespace ospray {
       struct CommandFinalize : public Work
       {
         CommandFinalize() = default;
+        //! only ends the session with workers serving several applications
+        CommandFinalize(bool endSession);
 
         void run() override;
         void runOnMaster() override;
@@ -713,6 +842,8 @@ namespace ospray {
         /*! de-serialize from a buffer that an object of this type has
           serialized itself in */
         void deserialize(ReadStream &b) override;
+
+        bool endSession {false};
       };
 
       struct Pick : public Work
@@ -737,6 +868,60 @@ namespace ospray {
         OSPPickResult pickResult;
       };
 
+      struct PickBatch : public Work
+      {
+        PickBatch() = default;
+        PickBatch(OSPRenderer renderer,
+                  const vec2f *screenPos,
+                  size_t count,
+                  OSPPickResult *results);
+
+        void run() override;
+        void runOnMaster() override;
+
+        /*! serializes itself on the given serial buffer - will write
+          all data into this buffer in a way that it can afterwards
+          un-serialize itself 'on the other side'*/
+        void serialize(WriteStream &b) const override;
+
+        /*! de-serialize from a buffer that an object of this type has
+          serialized itself in */
+        void deserialize(ReadStream &b) override;
+
+        ObjectHandle rendererHandle;
+        std::vector<vec2f> screenPos;
+        //! where the master receives the results into (not serialized)
+        OSPPickResult *results {nullptr};
+      };
+
+      struct TraceRays : public Work
+      {
+        TraceRays() = default;
+        TraceRays(OSPModel model,
+                  const OSPTraceRay *rays,
+                  size_t count,
+                  OSPTraceHit *hits,
+                  uint32 flags);
+
+        void run() override;
+        void runOnMaster() override;
+
+        /*! serializes itself on the given serial buffer - will write
+          all data into this buffer in a way that it can afterwards
+          un-serialize itself 'on the other side'*/
+        void serialize(WriteStream &b) const override;
+
+        /*! de-serialize from a buffer that an object of this type has
+          serialized itself in */
+        void deserialize(ReadStream &b) override;
+
+        ObjectHandle modelHandle;
+        uint32 flags {0};
+        std::vector<OSPTraceRay> rays;
+        //! where the master receives the hits into (not serialized)
+        OSPTraceHit *hits {nullptr};
+      };
+
     } // ::ospray::mpi::work
   } // ::ospray::mpi
 } // ::ospray
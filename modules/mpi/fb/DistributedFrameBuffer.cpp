@@ -14,6 +14,7 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <functional>
 #include <thread>
 #include <snappy.h>
 #include "DistributedFrameBuffer.h"
@@ -26,7 +27,9 @@
 #include "pico_bench.h"
 
 #include "mpiCommon/MPICommon.h"
+#include "mpiCommon/Tracing.h"
 #include "api/Device.h"
+#include "fb/TilePool.h"
 
 #ifdef _WIN32
 #  include <windows.h> // for Sleep
@@ -48,11 +51,25 @@ namespace ospray {
 
   using DFB = DistributedFrameBuffer;
 
+  //! whether the (half-open) pixel regions 'a' and 'b' overlap
+  static inline bool overlaps(const box2i &a, const box2i &b)
+  {
+    return a.lower.x < b.upper.x && b.lower.x < a.upper.x
+      && a.lower.y < b.upper.y && b.lower.y < a.upper.y;
+  }
+
   // DistributedTileError definitions /////////////////////////////////////////
 
   DistributedTileError::DistributedTileError(const vec2i &numTiles)
-    : TileError(numTiles)
+    : TileError(numTiles),
+      syncedError(std::max(tiles, 0), inf)
+  {
+  }
+
+  void DistributedTileError::clear()
   {
+    TileError::clear();
+    std::fill(syncedError.begin(), syncedError.end(), inf);
   }
 
   void DistributedTileError::sync()
@@ -60,7 +77,33 @@ namespace ospray {
     if (tiles <= 0)
       return;
 
-    MPI_CALL(Bcast(tileErrorBuffer, tiles, MPI_FLOAT, 0, mpicommon::world.comm));
+    // once the image converges only few tile errors still change, so only
+    // those are broadcast
+    updates.clear();
+    if (mpicommon::IamTheMaster()) {
+      for (int i = 0; i < tiles; ++i) {
+        if (tileErrorBuffer[i] != syncedError[i])
+          updates.push_back({i, tileErrorBuffer[i]});
+      }
+    }
+
+    int numUpdates = updates.size();
+    MPI_CALL(Bcast(&numUpdates, 1, MPI_INT, 0, mpicommon::world.comm));
+    if (numUpdates == 0)
+      return;
+
+    // sending the indices is not worth it when most of the errors changed
+    if (numUpdates * sizeof(ErrorUpdate) >= tiles * sizeof(float)) {
+      MPI_CALL(Bcast(tileErrorBuffer, tiles, MPI_FLOAT, 0,
+                     mpicommon::world.comm));
+    } else {
+      updates.resize(numUpdates);
+      MPI_CALL(Bcast(updates.data(), numUpdates * sizeof(ErrorUpdate),
+                     MPI_BYTE, 0, mpicommon::world.comm));
+      for (const auto &u : updates)
+        tileErrorBuffer[u.tile] = u.error;
+    }
+    std::copy(tileErrorBuffer, tileErrorBuffer + tiles, syncedError.begin());
   }
 
   // DistributedFrameBuffer definitions ///////////////////////////////////////
@@ -93,34 +136,141 @@ namespace ospray {
     tileInstances = (int32*)alignedMalloc(bytes);
     memset(tileInstances, 0, bytes);
 
-    if (mpicommon::IamTheMaster()) {
-      if (colorBufferFormat == OSP_FB_NONE) {
-        DBG(cout << "#osp:mpi:dfb: we're the master, but framebuffer has 'NONE' "
-                 << "format; creating distributed frame buffer WITHOUT having a "
-                 << "mappable copy on the master" << endl);
-      } else {
-        localFBonMaster
-          = ospcommon::make_unique<LocalFrameBuffer>(numPixels,
-              colorBufferFormat,
-              channels & ~(OSP_FB_ACCUM | OSP_FB_VARIANCE));
-      }
+    if (mpicommon::IamTheMaster() && colorBufferFormat == OSP_FB_NONE) {
+      DBG(cout << "#osp:mpi:dfb: we're the master, but framebuffer has 'NONE' "
+               << "format; creating distributed frame buffer WITHOUT having a "
+               << "mappable copy on the master" << endl);
+    }
+    updateLocalFB();
+  }
+
+  void DFB::updateLocalFB()
+  {
+    localFBonMaster.reset();
+    localRegion = box2i(vec2i(0), getNumPixels());
+    if (colorBufferFormat == OSP_FB_NONE)
+      return;
+
+    if (routeToDisplays()) {
+      const int cell = mpicommon::globalRank() - firstDisplayRank;
+      if (cell < 0 || cell >= displayGrid.product())
+        return;
+      localRegion = displayRegion(cell);
+    } else if (!mpicommon::IamTheMaster()) {
+      return;
     }
+
+    const uint32 channels = OSP_FB_COLOR
+      | (hasDepthBuffer ? OSP_FB_DEPTH : 0)
+      | (hasNormalBuffer ? OSP_FB_NORMAL : 0)
+      | (hasAlbedoBuffer ? OSP_FB_ALBEDO : 0);
+    localFBonMaster = ospcommon::make_unique<LocalFrameBuffer>(
+        localRegion.size(), colorBufferFormat, channels);
+  }
+
+  bool DFB::routeToDisplays() const
+  {
+    return displayGrid.product() > 0;
+  }
+
+  box2i DFB::displayRegion(const int cell) const
+  {
+    const vec2i numPixels = getNumPixels();
+    const vec2i c(cell % displayGrid.x, cell / displayGrid.x);
+    return box2i(c * numPixels / displayGrid,
+                 (c + 1) * numPixels / displayGrid);
   }
 
   DFB::~DistributedFrameBuffer()
   {
+    // the other ranks started the gather as well, thus it completes
+    finishFinalGather();
+    rmaFinalTiles = false;
+    updateFinalTileWindow();
     freeTiles();
     alignedFree(tileAccumID);
     alignedFree(tileInstances);
   }
 
+  void DFB::commit()
+  {
+    FrameBuffer::commit();
+
+    streamFinalTiles = getParam1i("streamFinalTiles", 0)
+      && colorBufferFormat != OSP_FB_NONE;
+
+    // committed on all ranks, thus the last frame is gathered on all
+    pipelineFrames = getParam1i("pipelineFrames", 0);
+    if (!pipelineFrames)
+      finishFinalGather();
+
+    // the display ranks show their part of the frame themselves
+    vec2i grid = max(getParam<vec2i>("displayGrid", vec2i(0)), vec2i(0));
+    if (grid.product() == 0)
+      grid = vec2i(0);
+    const int firstRank = getParam1i("firstDisplayRank", 0);
+    if (grid != displayGrid || firstRank != firstDisplayRank) {
+      if (grid.product() > 0
+          && (firstRank < 0
+              || firstRank + grid.product() > mpicommon::numGlobalRanks())) {
+        throw std::runtime_error("#osp:mpi:dfb: the display grid needs "
+                                 "more ranks than there are");
+      }
+      finishFinalGather();
+      // the window exposes the old local framebuffer
+      rmaFinalTiles = false;
+      updateFinalTileWindow();
+      displayGrid = grid;
+      firstDisplayRank = firstRank;
+      updateLocalFB();
+    }
+
+    // the tiles are only put into the master's framebuffer when they would
+    // be gathered there otherwise
+    const bool rma = getParam1i("rmaFinalTiles", 0)
+      && colorBufferFormat != OSP_FB_NONE
+      && !streamFinalTiles && !routeToDisplays();
+    if (rma != rmaFinalTiles) {
+      finishFinalGather();
+      rmaFinalTiles = rma;
+      updateFinalTileWindow();
+    }
+
+    const std::string codec = getParamString("tileCodec", "none");
+    if (codec == "lossless")
+      tileCodec = TILE_CODEC_LOSSLESS;
+    else if (codec == "fp16")
+      tileCodec = TILE_CODEC_FP16;
+    else if (codec == "srgb8")
+      tileCodec = TILE_CODEC_SRGB8;
+    else {
+      if (codec != "none") {
+        static WarnOnce warning("unknown tileCodec of the distributed "
+                                "framebuffer, using none");
+      }
+      tileCodec = TILE_CODEC_NONE;
+    }
+    tileDepthBits = getParam1i("tileDepthBits", 24) <= 16 ? 16 : 24;
+    interactive = getParam1i("interactive", 0);
+
+    const size_t radix = std::max(2, getParam1i("compositeRadix", 2));
+    if (radix != compositeRadix) {
+      compositeRadix = radix;
+      if (frameMode == Z_COMPOSITE_RADIX_K) {
+        freeTiles();
+        createTiles();
+      }
+    }
+  }
+
   void DFB::startNewFrame(const float errorThreshold)
   {
+    tileTimings.consume();
     queueTimes.clear();
     workTimes.clear();
 
     nextTileWrite = 0;
-    if (colorBufferFormat != OSP_FB_NONE) {
+    if (colorBufferFormat != OSP_FB_NONE && !streamFinalTiles) {
       const size_t finalTileSize = masterMsgSize(colorBufferFormat,
                                                  hasDepthBuffer,
                                                  hasNormalBuffer,
@@ -159,8 +309,13 @@ namespace ospray {
       MPI_CALL(Bcast(tileInstances, getTotalTiles(), MPI_INT, 0,
                      mpicommon::world.comm));
 
-      if (colorBufferFormat == OSP_FB_NONE) {
-        SCOPED_LOCK(tileErrorsMutex);
+      if (colorBufferFormat == OSP_FB_NONE || routeToDisplays()
+          || rmaFinalTiles) {
+        if (!tileErrorRing || tileErrorRing->capacity() < myTiles.size()) {
+          using TileErrorRing = ospcommon::MPSCRing<std::pair<vec2i, float>>;
+          tileErrorRing =
+            ospcommon::make_unique<TileErrorRing>(myTiles.size());
+        }
         tileIDs.clear();
         tileErrors.clear();
         tileIDs.reserve(myTiles.size());
@@ -170,6 +325,10 @@ namespace ospray {
       // after Bcast of tileInstances (needed in WriteMultipleTile::newFrame)
       for (auto &tile : myTiles)
         tile->newFrame();
+      for (auto &stage : compositeStages) {
+        if (stage)
+          stage->newFrame();
+      }
 
       if (mpicommon::IamTheMaster()) {
         numTilesExpected.resize(mpicommon::numGlobalRanks(), 0);
@@ -178,17 +337,28 @@ namespace ospray {
 
       globalTilesCompletedThisFrame = 0;
       numTilesCompletedThisFrame = 0;
+      numStreamedTiles = 0;
+      numStreamedTilesExpected = 0;
       for (int t = 0; t < getTotalTiles(); t++) {
         const uint32_t nx = static_cast<uint32_t>(getNumTiles().x);
         const uint32_t ty = t / nx;
         const uint32_t tx = t - ty * nx;
         const vec2i tileID(tx, ty);
-        if (hasAccumBuffer && tileError(tileID) <= errorThreshold) {
+        // tiles outside the render region are treated like converged ones
+        if (!tileInRenderRegion(tileID)
+            || (hasAccumBuffer && tileError(tileID) <= errorThreshold)) {
           if (allTiles[t]->mine()) {
             numTilesCompletedThisFrame++;
           }
+        } else if (routeToDisplays()) {
+          const vec2i begin = tileID * TILE_SIZE;
+          const box2i tileRegion(begin,
+              min(begin + vec2i(TILE_SIZE), getNumPixels()));
+          if (localFBonMaster && overlaps(tileRegion, localRegion))
+            ++numStreamedTilesExpected;
         } else if (mpicommon::IamTheMaster()) {
           ++numTilesExpected[allTiles[t]->ownerID];
+          ++numStreamedTilesExpected;
         }
       }
 
@@ -224,27 +394,35 @@ namespace ospray {
 
     allTiles.clear();
     myTiles.clear();
+    compositeStages.clear();
   }
 
   bool DFB::isFrameComplete(const size_t numTiles)
   {
-    SCOPED_LOCK(numTilesMutex);
-    numTilesCompletedThisFrame += numTiles;
+    // exactly one caller sees the count reach the number of tiles
+    const size_t numCompleted = numTilesCompletedThisFrame += numTiles;
 
-    if (reportRenderingProgress) {
-      renderingProgressTiles += numTiles;
+    // NOTE: progress is always tracked (also without a progress callback)
+    //       for the futures of ospRenderFrameAsync, it is cheap as it is
+    //       rate limited to one message per second per rank; a caller
+    //       finding another one reporting skips the report
+    renderingProgressTiles += numTiles;
 
+    std::unique_lock<std::mutex> lock(numTilesMutex, std::try_to_lock);
+    if (lock.owns_lock()) {
       auto now = std::chrono::high_resolution_clock::now();
-      auto timeSinceUpdate = duration_cast<milliseconds>(now - lastProgressReport);
+      auto timeSinceUpdate =
+          duration_cast<milliseconds>(now - lastProgressReport);
       if (timeSinceUpdate.count() >= 1000) {
-        auto msg = std::make_shared<mpicommon::Message>(sizeof(ProgressMessage));
-        ProgressMessage *msgData = reinterpret_cast<ProgressMessage*>(msg->data);
+        auto msg =
+            std::make_shared<mpicommon::Message>(sizeof(ProgressMessage));
+        ProgressMessage *msgData =
+            reinterpret_cast<ProgressMessage*>(msg->data);
         msgData->command = PROGRESS_MESSAGE;
-        msgData->numCompleted = renderingProgressTiles;
+        msgData->numCompleted = renderingProgressTiles.exchange(0);
         msgData->frameID = frameID;
         mpi::messaging::sendTo(mpicommon::masterRank(), myId, msg);
 
-        renderingProgressTiles = 0;
         lastProgressReport = now;
       }
     }
@@ -252,15 +430,18 @@ namespace ospray {
     if (mpicommon::IamAWorker()
         || (mpicommon::IamTheMaster() && masterIsAWorker))
     {
-      return numTilesCompletedThisFrame == myTiles.size();
+      return numCompleted == myTiles.size();
     }
     // Note: This test is not actually going to ever be true on the master,
     // because it doesn't finish tiles until the gather at the end of the frame
-    return numTilesCompletedThisFrame == static_cast<size_t>(getTotalTiles());
+    return numCompleted == static_cast<size_t>(getTotalTiles());
   }
 
   size_t DFB::ownerIDFromTileID(size_t tileID) const
   {
+    if (!tileOwners.empty())
+      return tileOwners[tileID];
+
     return masterIsAWorker ? tileID % mpicommon::numGlobalRanks() :
       mpicommon::globalRankFromWorkerRank(tileID % mpicommon::numWorkers());
   }
@@ -272,22 +453,88 @@ namespace ospray {
     switch(frameMode) {
     case WRITE_MULTIPLE:
       td = new WriteMultipleTile(this, xy, tileID, ownerID);
+      tileMemory += sizeof(WriteMultipleTile);
       break;
     case ALPHA_BLEND:
       td = new AlphaBlendTile_simple(this, xy, tileID, ownerID);
+      tileMemory += sizeof(AlphaBlendTile_simple);
       break;
     case Z_COMPOSITE:
-      size_t numWorkers = masterIsAWorker ? mpicommon::numGlobalRanks() :
-                                            mpicommon::numWorkers();
-      td = new ZCompositeTile(this, xy, tileID, ownerID, numWorkers);
+      td = new ZCompositeTile(this, xy, tileID, ownerID, numCompositeRanks());
+      tileMemory += sizeof(ZCompositeTile);
+      break;
+    case Z_COMPOSITE_RADIX_K: {
+      size_t numParts, parentRank;
+      compositeTree(tileID, numParts, parentRank);
+      td = new ZCompositeTile(this, xy, tileID, ownerID, numParts);
+      tileMemory += sizeof(ZCompositeTile);
       break;
     }
+    }
 
     return td;
   }
 
+  size_t DFB::numCompositeRanks() const
+  {
+    return masterIsAWorker ? mpicommon::numGlobalRanks() :
+                             mpicommon::numWorkers();
+  }
+
+  void DFB::compositeTree(size_t tileID,
+                          size_t &numParts,
+                          size_t &parentRank) const
+  {
+    // ranks are indexed relative to the owner of the tile, the root of the
+    // tree. In the stage with 'stride' the ranks at multiples of 'stride'
+    // are grouped by 'compositeRadix', all send to the first of their group
+    const size_t n = numCompositeRanks();
+    const size_t ownerID = ownerIDFromTileID(tileID);
+    const size_t owner = masterIsAWorker ? ownerID :
+      mpicommon::workerRankFromGlobalRank(ownerID);
+    const size_t me = masterIsAWorker ? mpicommon::globalRank() :
+                                        mpicommon::workerRank();
+    const size_t index = (me + n - owner) % n;
+
+    numParts = 1;
+    size_t parent = index;
+    for (size_t stride = 1; stride < n; stride *= compositeRadix) {
+      const size_t group = stride * compositeRadix;
+      if (index % group != 0) {
+        parent = index - index % group;
+        break;
+      }
+      for (size_t i = 1; i < compositeRadix; i++) {
+        if (index + i * stride < n)
+          numParts++;
+      }
+    }
+
+    const size_t parentWorker = (parent + owner) % n;
+    parentRank = masterIsAWorker ? parentWorker :
+      mpicommon::globalRankFromWorkerRank(parentWorker);
+  }
+
   void DFB::createTiles()
   {
+    // the master which is not a worker does not take part in compositing
+    const bool compositing = frameMode == Z_COMPOSITE_RADIX_K
+      && (masterIsAWorker || mpicommon::IamAWorker());
+    if (compositing)
+      compositeStages.resize(getTotalTiles());
+
+    // tileAccumID and tileInstances, the tiles are added by createTile
+    tileMemory = 2 * sizeof(int32) * getTotalTiles();
+
+    // the tiles of this rank are the bulk, check them before allocating
+    const size_t tileBytes = frameMode == WRITE_MULTIPLE ?
+      sizeof(WriteMultipleTile) : frameMode == ALPHA_BLEND ?
+      sizeof(AlphaBlendTile_simple) : sizeof(ZCompositeTile);
+    size_t numMyTiles = 0;
+    for (size_t i = 0; i < size_t(getTotalTiles()); i++)
+      numMyTiles += ownerIDFromTileID(i) == size_t(mpicommon::globalRank());
+    checkMemoryBudget(tileMemory + numMyTiles * tileBytes);
+
     size_t tileID = 0;
     vec2i numPixels = getNumPixels();
     for (int y = 0; y < numPixels.y; y += TILE_SIZE) {
@@ -300,9 +547,48 @@ namespace ospray {
           allTiles.push_back(td);
         } else {
           allTiles.push_back(new TileDesc(tileStart, tileID, ownerID));
+          tileMemory += sizeof(TileDesc);
+          if (compositing) {
+            size_t numParts, parentRank;
+            compositeTree(tileID, numParts, parentRank);
+            if (numParts > 1) {
+              compositeStages[tileID] =
+                ospcommon::make_unique<ZCompositeStage>(numParts, parentRank);
+              tileMemory += sizeof(ZCompositeStage);
+            }
+          }
         }
       }
     }
+
+    setMemoryUsage(OSP_MEMORY_FRAMEBUFFER, tileMemory);
+  }
+
+  OSPMemoryUsage DFB::getMemoryUsage() const
+  {
+    OSPMemoryUsage usage = FrameBuffer::getMemoryUsage();
+    if (localFBonMaster)
+      usage.bytes += localFBonMaster->getMemoryUsage().bytes;
+    return usage;
+  }
+
+  void DFB::setTileOwners(const std::vector<size_t> &owners)
+  {
+    if (owners == tileOwners)
+      return;
+
+    if (!owners.empty() && owners.size() != size_t(getTotalTiles())) {
+      throw std::runtime_error("#osp:mpi:dfb: the tile owners need to have "
+                               "one entry per tile");
+    }
+
+    freeTiles();
+    tileOwners = owners;
+    createTiles();
+
+    // the new tiles start without accumulated samples
+    memset(tileAccumID, 0, getTotalTiles()*sizeof(int32));
+    tileErrorRegion.clear();
   }
 
   void DFB::setFrameMode(FrameMode newFrameMode)
@@ -344,7 +630,13 @@ namespace ospray {
     auto startWaitFrame = high_resolution_clock::now();
     std::unique_lock<std::mutex> lock(mutex);
     frameDoneCond.wait(lock, [&]{
-      return frameIsDone;
+      // with streaming the master (or a display rank) also waits for the
+      // final tiles, which could otherwise still be in flight when
+      // messaging is disabled
+      const bool streaming = streamFinalTiles || routeToDisplays();
+      const bool allStreamed = !streaming || cancelRendering
+        || numStreamedTiles == numStreamedTilesExpected;
+      return frameIsDone && allStreamed;
     });
 
     // Broadcast the rendering cancellation status to the workers
@@ -371,20 +663,35 @@ namespace ospray {
     waitFrameFinishTime = duration_cast<RealMilliseconds>(endWaitFrame - startWaitFrame);
 
     // Report that we're 100% done and do a final check for cancellation
-    if (reportRenderingProgress && !api::currentDevice().reportProgress(1.0)) {
+    FrameBuffer::reportProgress(1.f);
+    if (!api::currentDevice().reportProgress(1.0) || frameCancelled()) {
       cancelRendering = true;
     }
 
-    if (reportRenderingProgress) {
-      int renderingCancelled = cancelRendering.load();
-      MPI_CALL(Bcast(&renderingCancelled, 1, MPI_INT, masterRank(), world.comm));
-      if (renderingCancelled) {
-        return;
-      }
+    int renderingCancelled = cancelRendering.load();
+    MPI_CALL(Bcast(&renderingCancelled, 1, MPI_INT, masterRank(), world.comm));
+
+    // the final tiles of the previous frame, gathered while this one
+    // rendered, also when this frame got cancelled
+    finishFinalGather();
+    // the puts of this frame complete (or, if cancelled, what was put)
+    fenceFinalTiles();
+
+    if (renderingCancelled) {
+      return;
     }
 
-    if (colorBufferFormat != OSP_FB_NONE) {
-      gatherFinalTiles();
+    if (routeToDisplays()) {
+      // the master still needs the errors for adaptive accumulation
+      if (hasVarianceBuffer)
+        gatherFinalErrors();
+    } else if (colorBufferFormat != OSP_FB_NONE && !rmaFinalTiles) {
+      if (!streamFinalTiles) {
+        if (pipelineFrames)
+          startFinalGather();
+        else
+          gatherFinalTiles();
+      }
     } else if (hasVarianceBuffer) {
       gatherFinalErrors();
     }
@@ -392,26 +699,57 @@ namespace ospray {
 
   void DFB::processMessage(WriteTileMessage *msg)
   {
-    ospray::Tile tile;
-    unpackWriteTileMessage(msg, tile, hasNormalBuffer || hasAlbedoBuffer);
+#if TILE_SIZE > MAX_TILE_SIZE
+    auto tilePtr = TilePool::acquire();
+    auto &tile   = *tilePtr;
+#else
+    ospray::Tile __aligned(64) tile;
+#endif
+    unpackWriteTileMessage(msg, tile);
+    // the parts of a staged composite have been pre-accumulated already by
+    // the rank rendering them
+    if (frameMode == Z_COMPOSITE_RADIX_K) {
+      compositeStage(tile);
+      return;
+    }
     if (pixelOp) {
+      const double pixelOpStart = getSysTime();
       pixelOp->preAccum(tile);
+      recordPixelOpTime(getSysTime() - pixelOpStart);
     }
     auto *tileDesc = this->getTileDescFor(tile.region.lower);
     TileData *td = (TileData*)tileDesc;
-    td->process(tile);
+    // the pixel op may have added something to an empty tile
+    if (msg->codec == TILE_CODEC_EMPTY && !pixelOp)
+      td->processEmpty(tile);
+    else
+      td->process(tile);
+  }
+
+  std::shared_ptr<mpicommon::Message>
+  DFB::makeTileMessage(const ospray::Tile &tile) const
+  {
+    TileCodec codec = tileCodec;
+    if (!interactive
+        && (codec == TILE_CODEC_FP16 || codec == TILE_CODEC_SRGB8)) {
+      codec = TILE_CODEC_LOSSLESS;
+    }
+    return makeWriteTileMessage(tile, getTileChannels(), codec, tileDepthBits);
   }
 
   template <typename ColorT>
   void DistributedFrameBuffer::processMessage(MasterTileMessage_FB<ColorT> *msg)
   {
-    if (hasVarianceBuffer) {
+    // display ranks leave the errors to the master (gatherFinalErrors)
+    if (hasVarianceBuffer && !routeToDisplays()) {
       const vec2i tileID = msg->coords/TILE_SIZE;
       if (msg->error < (float)inf)
         tileErrorRegion.update(tileID, msg->error);
     }
 
-    vec2i numPixels = getNumPixels();
+    // localFBonMaster holds (the display region) 'localRegion' of the frame
+    const vec2i numPixels = localRegion.size();
+    const vec2i coords = msg->coords - localRegion.lower;
 
     MasterTileMessage_FB_Depth<ColorT> *depth = nullptr;
     if (hasDepthBuffer && msg->command & MASTER_TILE_HAS_DEPTH) {
@@ -424,14 +762,14 @@ namespace ospray {
 
     ColorT *color = reinterpret_cast<ColorT*>(localFBonMaster->colorBuffer);
     for (int iy = 0; iy < TILE_SIZE; iy++) {
-      int iiy = iy + msg->coords.y;
-      if (iiy >= numPixels.y) {
+      int iiy = iy + coords.y;
+      if (iiy < 0 || iiy >= numPixels.y) {
         continue;
       }
 
       for (int ix = 0; ix < TILE_SIZE; ix++) {
-        int iix = ix + msg->coords.x;
-        if (iix >= numPixels.x) {
+        int iix = ix + coords.x;
+        if (iix < 0 || iix >= numPixels.x) {
           continue;
         }
 
@@ -458,7 +796,9 @@ namespace ospray {
                tile->begin.x,tile->begin.y));
 
     if (pixelOp) {
+      const double pixelOpStart = getSysTime();
       pixelOp->postAccum(tile->final);
+      recordPixelOpTime(getSysTime() - pixelOpStart);
     }
 
     // Write the final colors into the color buffer
@@ -494,9 +834,18 @@ namespace ospray {
     if (mpicommon::IamAWorker()) {
       // TODO still send normal & albedo
       if (colorBufferFormat == OSP_FB_NONE) {
-        SCOPED_LOCK(tileErrorsMutex);
-        tileIDs.push_back(tile->begin/TILE_SIZE);
-        tileErrors.push_back(tile->error);
+        tileErrorRing->push(std::make_pair(tile->begin/TILE_SIZE,
+                                           tile->error));
+      } else if (routeToDisplays()) {
+        tileErrorRing->push(std::make_pair(tile->begin/TILE_SIZE,
+                                           tile->error));
+        sendToDisplays(*msg().message, tile->begin);
+      } else if (rmaFinalTiles) {
+        tileErrorRing->push(std::make_pair(tile->begin/TILE_SIZE,
+                                           tile->error));
+        putFinalTile(tile);
+      } else if (streamFinalTiles) {
+        streamFinalTile(*msg().message, mpicommon::masterRank());
       } else {
         auto tileMsg = msg().message;
         const size_t n = nextTileWrite.fetch_add(tileMsg->size);
@@ -508,13 +857,22 @@ namespace ospray {
       }
       DBG(printf("RANK %d MARKING AS COMPLETED %i,%i -> %i/%i\n",
                  mpicommon::globalRank(), tile->begin.x, tile->begin.y,
-                 numTilesCompletedThisFrame, myTiles.size()));
+                 int(numTilesCompletedThisFrame), int(myTiles.size())));
     } else {
       // TODO: Better unify the master is worker code path
       if (colorBufferFormat == OSP_FB_NONE) {
-        SCOPED_LOCK(tileErrorsMutex);
-        tileIDs.push_back(tile->begin/TILE_SIZE);
-        tileErrors.push_back(tile->error);
+        tileErrorRing->push(std::make_pair(tile->begin/TILE_SIZE,
+                                           tile->error));
+      } else if (routeToDisplays()) {
+        tileErrorRing->push(std::make_pair(tile->begin/TILE_SIZE,
+                                           tile->error));
+        sendToDisplays(*msg().message, tile->begin);
+      } else if (rmaFinalTiles) {
+        tileErrorRing->push(std::make_pair(tile->begin/TILE_SIZE,
+                                           tile->error));
+        putFinalTile(tile);
+      } else if (streamFinalTiles) {
+        streamFinalTile(*msg().message, mpicommon::masterRank());
       } else {
         auto tileMsg = msg().message;
         const size_t n = nextTileWrite.fetch_add(tileMsg->size);
@@ -527,11 +885,75 @@ namespace ospray {
     }
   }
 
+  void DFB::streamFinalTile(const mpicommon::Message &tileMsg, const int rank)
+  {
+    if (rank == mpicommon::globalRank()) {
+      // our own tiles (e.g. master is a worker) are written directly
+      writeFinalTile(reinterpret_cast<TileMessage*>(tileMsg.data));
+      return;
+    }
+
+    const size_t headerSize = sizeof(CompressedTileMessage);
+    auto msg = std::make_shared<mpicommon::Message>(headerSize
+        + snappy::MaxCompressedLength(tileMsg.size));
+    auto *header = reinterpret_cast<CompressedTileMessage*>(msg->data);
+    header->command = MASTER_TILE_COMPRESSED;
+    header->uncompressedSize = tileMsg.size;
+
+    size_t compressedSize = 0;
+    mpicommon::tracing::Scope trace("compress tile");
+    snappy::RawCompress(reinterpret_cast<const char*>(tileMsg.data),
+        tileMsg.size, reinterpret_cast<char*>(msg->data) + headerSize,
+        &compressedSize);
+    msg->size = headerSize + compressedSize;
+
+    mpi::messaging::sendTo(rank, myId, msg);
+  }
+
+  void DFB::sendToDisplays(const mpicommon::Message &tileMsg,
+                           const vec2i &begin)
+  {
+    const box2i tileRegion(begin,
+                           min(begin + vec2i(TILE_SIZE), getNumPixels()));
+    for (int cell = 0; cell < displayGrid.product(); ++cell) {
+      if (overlaps(tileRegion, displayRegion(cell)))
+        streamFinalTile(tileMsg, firstDisplayRank + cell);
+    }
+  }
+
+  void DFB::processMessage(CompressedTileMessage *msg, size_t size)
+  {
+    const size_t headerSize = sizeof(CompressedTileMessage);
+    std::vector<char> tile(msg->uncompressedSize);
+    {
+      mpicommon::tracing::Scope trace("decompress tile");
+      snappy::RawUncompress(reinterpret_cast<const char*>(msg) + headerSize,
+                            size - headerSize, tile.data());
+    }
+    writeFinalTile(reinterpret_cast<TileMessage*>(tile.data()));
+  }
+
+  void DFB::writeFinalTile(TileMessage *msg)
+  {
+    if (msg->command & MASTER_WRITE_TILE_I8) {
+      this->processMessage((MasterTileMessage_RGBA_I8*)msg);
+    } else if (msg->command & MASTER_WRITE_TILE_F32) {
+      this->processMessage((MasterTileMessage_RGBA_F32*)msg);
+    } else {
+      throw std::runtime_error("#dfb: non-master tile streamed to master!");
+    }
+
+    SCOPED_LOCK(mutex);
+    if (++numStreamedTiles == numStreamedTilesExpected)
+      frameDoneCond.notify_all();
+  }
+
   void DFB::updateProgress(ProgressMessage *msg)
   {
     globalTilesCompletedThisFrame += msg->numCompleted;
     const float progress = globalTilesCompletedThisFrame / (float)getTotalTiles();
-    if (reportRenderingProgress && !api::currentDevice().reportProgress(progress)) {
+    FrameBuffer::reportProgress(progress);
+    if (!api::currentDevice().reportProgress(progress) || frameCancelled()) {
       sendCancelRenderingMessage();
     }
   }
@@ -600,6 +1022,7 @@ namespace ospray {
     tasking::schedule([=]() {
       auto startedTask = high_resolution_clock::now();
       auto *msg = (TileMessage*)message->data;
+      mpicommon::tracing::Scope trace("process tile message");
       if (msg->command & MASTER_WRITE_TILE_I8) {
         throw std::runtime_error("#dfb: master msg should not be scheduled!");
       } else if (msg->command & MASTER_WRITE_TILE_F32) {
@@ -608,6 +1031,8 @@ namespace ospray {
         this->processMessage((WriteTileMessage*)msg);
       } else if (msg->command & PROGRESS_MESSAGE) {
         updateProgress((ProgressMessage*)msg);
+      } else if (msg->command & MASTER_TILE_COMPRESSED) {
+        this->processMessage((CompressedTileMessage*)msg, message->size);
       } else {
         throw std::runtime_error("#dfb: unknown tile type processed!");
       }
@@ -616,9 +1041,7 @@ namespace ospray {
       auto queueTime = duration_cast<duration<double, std::milli>>(startedTask - queuedTask);
       auto computeTime = duration_cast<duration<double, std::milli>>(finishedTask - startedTask);
 
-      std::lock_guard<std::mutex> lock(statsMutex);
-      queueTimes.push_back(queueTime);
-      workTimes.push_back(computeTime);
+      tileTimings.push(std::make_pair(queueTime, computeTime));
     });
   }
 
@@ -627,6 +1050,7 @@ namespace ospray {
     using namespace mpicommon;
     using namespace std::chrono;
 
+    tracing::Scope trace("gather final tiles");
     auto preGatherComputeStart = high_resolution_clock::now();
 
     const size_t tileSize = masterMsgSize(colorBufferFormat, hasDepthBuffer,
@@ -657,6 +1081,7 @@ namespace ospray {
     const size_t renderedTileBytes = nextTileWrite.load();
     size_t compressedSize = 0;
     if (renderedTileBytes > 0) {
+      tracing::Scope trace("compress final tiles");
       auto startCompr = high_resolution_clock::now();
       compressedSize = snappy::MaxCompressedLength(renderedTileBytes);
       compressedBuf.resize(compressedSize, 0);
@@ -717,21 +1142,176 @@ namespace ospray {
 #endif
     finalGatherTime = duration_cast<RealMilliseconds>(endGather - startGather);
 
+    if (IamTheMaster())
+      writeGatheredTiles(tileGatherResult, totalTilesExpected);
+  }
+
+  void DFB::startFinalGather()
+  {
+    using namespace mpicommon;
+
+    tracing::Scope trace("start final gather");
+
+    // the counts of the Igatherv have to be known upfront, thus the tiles
+    // are sent uncompressed, each rank sends all its expected tiles
+    const size_t tileSize = masterMsgSize(colorBufferFormat, hasDepthBuffer,
+                                          hasNormalBuffer, hasAlbedoBuffer);
+    auto &gather = pendingGather;
+    gather.numTiles = 0;
+    gather.bytesExpected.assign(numGlobalRanks(), 0);
+    gather.offsets.assign(numGlobalRanks(), 0);
     if (IamTheMaster()) {
-      auto startMasterWrite = high_resolution_clock::now();
-      tasking::parallel_for(totalTilesExpected, [&](size_t tile) {
-        auto *msg = reinterpret_cast<TileMessage*>(&tileGatherResult[tile * tileSize]);
-        if (msg->command & MASTER_WRITE_TILE_I8) {
-          this->processMessage((MasterTileMessage_RGBA_I8*)msg);
-        } else if (msg->command & MASTER_WRITE_TILE_F32) {
-          this->processMessage((MasterTileMessage_RGBA_F32*)msg);
-        } else {
-          throw std::runtime_error("#dfb: non-master tile in final gather!");
-        }
+      size_t recvOffset = 0;
+      for (int i = 0; i < numGlobalRanks(); ++i) {
+        gather.bytesExpected[i] = numTilesExpected[i] * tileSize;
+        gather.offsets[i] = recvOffset;
+        recvOffset += gather.bytesExpected[i];
+        gather.numTiles += numTilesExpected[i];
+      }
+      gather.result.resize(recvOffset);
+    }
+
+    // the next frame writes its final tiles into the other buffer
+    std::swap(tileGatherBuffer, gather.sendBuffer);
+    const int sendBytes = static_cast<int>(nextTileWrite.load());
+    MPI_CALL(Igatherv(gather.sendBuffer.data(), sendBytes, MPI_BYTE,
+                      gather.result.data(), gather.bytesExpected.data(),
+                      gather.offsets.data(), MPI_BYTE,
+                      masterRank(), world.comm, &gather.request));
+  }
+
+  void DFB::finishFinalGather()
+  {
+    using namespace std::chrono;
+
+    auto &gather = pendingGather;
+    if (gather.request == MPI_REQUEST_NULL)
+      return;
+
+    tracing::Scope trace("finish final gather");
+    auto startGather = high_resolution_clock::now();
+    MPI_CALL(Wait(&gather.request, MPI_STATUS_IGNORE));
+    auto endGather = high_resolution_clock::now();
+    finalGatherTime = duration_cast<RealMilliseconds>(endGather - startGather);
+
+    if (mpicommon::IamTheMaster())
+      writeGatheredTiles(gather.result, gather.numTiles);
+  }
+
+  void DFB::writeGatheredTiles(std::vector<char> &tiles,
+                               const size_t numTiles)
+  {
+    using namespace std::chrono;
+
+    const size_t tileSize = masterMsgSize(colorBufferFormat, hasDepthBuffer,
+                                          hasNormalBuffer, hasAlbedoBuffer);
+    auto startMasterWrite = high_resolution_clock::now();
+    tasking::parallel_for(numTiles, [&](size_t tile) {
+      auto *msg = reinterpret_cast<TileMessage*>(&tiles[tile * tileSize]);
+      if (msg->command & MASTER_WRITE_TILE_I8) {
+        this->processMessage((MasterTileMessage_RGBA_I8*)msg);
+      } else if (msg->command & MASTER_WRITE_TILE_F32) {
+        this->processMessage((MasterTileMessage_RGBA_F32*)msg);
+      } else {
+        throw std::runtime_error("#dfb: non-master tile in final gather!");
+      }
+    });
+    auto endMasterWrite = high_resolution_clock::now();
+    masterTileWriteTime = duration_cast<RealMilliseconds>(endMasterWrite - startMasterWrite);
+  }
+
+  void DFB::updateFinalTileWindow()
+  {
+    using namespace mpicommon;
+
+    // the buffers of localFBonMaster and their sizes, in the order of
+    // finalTileAddress
+    auto forEachBuffer = [&](const std::function<void(void*, size_t)> &f) {
+      if (!IamTheMaster() || !localFBonMaster)
+        return;
+      const size_t numPixels = getNumPixels().product();
+      const size_t colorSize = colorBufferFormat == OSP_FB_RGBA32F
+        ? sizeof(vec4f) : sizeof(uint32);
+      f(localFBonMaster->colorBuffer, numPixels * colorSize);
+      f(localFBonMaster->depthBuffer, numPixels * sizeof(float));
+      f(localFBonMaster->normalBuffer, numPixels * sizeof(vec3f));
+      f(localFBonMaster->albedoBuffer, numPixels * sizeof(vec3f));
+    };
+
+    if (finalTileWindow != MPI_WIN_NULL) {
+      forEachBuffer([&](void *buffer, size_t) {
+        if (buffer)
+          MPI_CALL(Win_detach(finalTileWindow, buffer));
       });
-      auto endMasterWrite = high_resolution_clock::now();
-      masterTileWriteTime = duration_cast<RealMilliseconds>(endMasterWrite - startMasterWrite);
+      MPI_CALL(Win_free(&finalTileWindow));
     }
+
+    if (!rmaFinalTiles)
+      return;
+
+    MPI_CALL(Win_create_dynamic(MPI_INFO_NULL, world.comm, &finalTileWindow));
+    int channel = 0;
+    std::fill(finalTileAddress, finalTileAddress + 4, MPI_Aint(0));
+    forEachBuffer([&](void *buffer, size_t size) {
+      if (buffer) {
+        MPI_CALL(Win_attach(finalTileWindow, buffer, size));
+        MPI_CALL(Get_address(buffer, &finalTileAddress[channel]));
+      }
+      ++channel;
+    });
+    MPI_CALL(Bcast(finalTileAddress, 4, MPI_AINT, masterRank(), world.comm));
+    // open the access epoch of the first frame
+    MPI_CALL(Win_fence(0, finalTileWindow));
+  }
+
+  void DFB::putFinalTile(TileData *tile)
+  {
+    using namespace mpicommon;
+
+    // the tile is clipped to the frame, the rest of its pixels is padding
+    const vec2i numPixels = getNumPixels();
+    const vec2i size = min(vec2i(TILE_SIZE), numPixels - tile->begin);
+    const size_t offset = size_t(tile->begin.y) * numPixels.x + tile->begin.x;
+
+    auto put = [&](const void *data, const int channel, const int pixelSize) {
+      MPI_Datatype origin, target;
+      MPI_CALL(Type_vector(size.y, size.x * pixelSize, TILE_SIZE * pixelSize,
+                           MPI_BYTE, &origin));
+      MPI_CALL(Type_vector(size.y, size.x * pixelSize, numPixels.x * pixelSize,
+                           MPI_BYTE, &target));
+      MPI_CALL(Type_commit(&origin));
+      MPI_CALL(Type_commit(&target));
+      MPI_CALL(Put(data, 1, origin, masterRank(),
+                   finalTileAddress[channel] + offset * pixelSize, 1, target,
+                   finalTileWindow));
+      // still valid for the pending put
+      MPI_CALL(Type_free(&origin));
+      MPI_CALL(Type_free(&target));
+    };
+
+    auto mpilock = acquireMPILock();
+    put(tile->color, 0, colorBufferFormat == OSP_FB_RGBA32F
+                        ? sizeof(vec4f) : sizeof(uint32));
+    if (hasDepthBuffer)
+      put(tile->final.z, 1, sizeof(float));
+    if (hasNormalBuffer)
+      put(tile->final.nx, 2, sizeof(vec3f));
+    if (hasAlbedoBuffer)
+      put(tile->final.ar, 3, sizeof(vec3f));
+  }
+
+  void DFB::fenceFinalTiles()
+  {
+    using namespace std::chrono;
+
+    if (finalTileWindow == MPI_WIN_NULL)
+      return;
+
+    tracing::Scope trace("fence final tiles");
+    auto startFence = high_resolution_clock::now();
+    MPI_CALL(Win_fence(0, finalTileWindow));
+    auto endFence = high_resolution_clock::now();
+    finalGatherTime = duration_cast<RealMilliseconds>(endFence - startFence);
   }
 
   void DFB::gatherFinalErrors()
@@ -739,6 +1319,12 @@ namespace ospray {
     using namespace mpicommon;
     using namespace ospcommon;
 
+    std::pair<vec2i, float> tileError;
+    while (tileErrorRing->pop(tileError)) {
+      tileIDs.push_back(tileError.first);
+      tileErrors.push_back(tileError.second);
+    }
+
     std::vector<int> tilesFromRank(numGlobalRanks(), 0);
     const int myTileCount = tileIDs.size();
     MPI_CALL(Gather(&myTileCount, 1, MPI_INT,
@@ -783,6 +1369,26 @@ namespace ospray {
     }
   }
 
+  uint32 DFB::getTileChannels() const
+  {
+    // the ID channels are not (yet) sent between the ranks
+    uint32 channels = FrameBuffer::getTileChannels()
+      & ~(OSP_FB_GEOMETRY_ID | OSP_FB_PRIMITIVE_ID | OSP_FB_INSTANCE_ID);
+    // compositing needs the depth of the fragments
+    if (frameMode != WRITE_MULTIPLE)
+      channels |= OSP_FB_DEPTH;
+    // normal and albedo are accumulated (and sent to the master) together
+    if (channels & (OSP_FB_NORMAL | OSP_FB_ALBEDO))
+      channels |= OSP_FB_NORMAL | OSP_FB_ALBEDO;
+    return channels;
+  }
+
+  void DFB::cancelFrame()
+  {
+    FrameBuffer::cancelFrame();
+    sendCancelRenderingMessage();
+  }
+
   void DFB::sendCancelRenderingMessage()
   {
     // WILL: Because we don't have a threaded MPI and the master
@@ -820,11 +1426,24 @@ namespace ospray {
   //! required
   void DFB::setTile(ospray::Tile &tile)
   {
+    if (frameMode == Z_COMPOSITE_RADIX_K) {
+      if (!frameIsActive)
+        throw std::runtime_error("#dfb: cannot setTile if frame is inactive!");
+
+      if (pixelOp) {
+        const double pixelOpStart = getSysTime();
+        pixelOp->preAccum(tile);
+        recordPixelOpTime(getSysTime() - pixelOpStart);
+      }
+      compositeStage(tile);
+      return;
+    }
+
     auto *tileDesc = this->getTileDescFor(tile.region.lower);
 
     // Note my tile, send to the owner
     if (!tileDesc->mine()) {
-      auto msg = makeWriteTileMessage(tile, hasNormalBuffer || hasAlbedoBuffer);
+      auto msg = makeTileMessage(tile);
 
       int dstRank = tileDesc->ownerID;
       DBG(printf("rank %i: send tile %i,%i to %i\n",mpicommon::globalRank(),
@@ -839,6 +1458,36 @@ namespace ospray {
     }
   }
 
+  void DFB::compositeStage(const ospray::Tile &tile)
+  {
+    auto *tileDesc = this->getTileDescFor(tile.region.lower);
+    if (tileDesc->mine()) {
+      TileData *td = (TileData*)tileDesc;
+      td->process(tile);
+      return;
+    }
+
+    ZCompositeStage *stage = compositeStages[tileDesc->tileID].get();
+    std::shared_ptr<mpicommon::Message> msg;
+    size_t dstRank;
+    if (stage) {
+      // wait for the parts of our group before forwarding their composite
+      TilePool::Ptr composited = stage->process(tile);
+      if (!composited)
+        return;
+      msg = makeTileMessage(*composited);
+      dstRank = stage->parentRank;
+    } else {
+      size_t numParts;
+      compositeTree(tileDesc->tileID, numParts, dstRank);
+      msg = makeTileMessage(tile);
+    }
+
+    DBG(printf("rank %i: forward tile %i,%i to %i\n",mpicommon::globalRank(),
+               tileDesc->begin.x,tileDesc->begin.y,int(dstRank)));
+    mpi::messaging::sendTo(dstRank, myId, msg);
+  }
+
   /*! \brief clear (the specified channels of) this frame buffer
 
     \details for the *distributed* frame buffer, we assume that
@@ -848,6 +1497,9 @@ namespace ospray {
   */
   void DFB::clear(const uint32 fbChannelFlags)
   {
+    // the tiles of a frame before the clear must not arrive after it
+    finishFinalGather();
+
     frameID = -1; // we increment at the start of the frame
     if (!myTiles.empty()) {
       tasking::parallel_for(myTiles.size(), [&](size_t taskIndex) {
@@ -906,14 +1558,13 @@ namespace ospray {
   void DFB::beginFrame()
   {
     cancelRendering = false;
-    reportRenderingProgress = api::currentDevice().hasProgressCallback();
-    MPI_CALL(Bcast(&reportRenderingProgress, 1, MPI_INT,
-                   mpicommon::masterRank(), mpicommon::world.comm));
     FrameBuffer::beginFrame();
   }
 
   float DFB::endFrame(const float errorThreshold)
   {
+    reducePixelOpStatistics();
+
     if (mpicommon::IamTheMaster() && !masterIsAWorker) {
       /* do nothing */
     } else {
@@ -930,10 +1581,37 @@ namespace ospray {
       return inf;
   }
 
+  void DFB::reducePixelOpStatistics()
+  {
+    using namespace mpicommon;
+    if (world.size == 1)
+      return;
+
+    // each rank only has the statistics of the tiles it owns, and the master
+    // may not have a pixel op at all, so first agree on their size
+    std::vector<uint32> stats;
+    if (pixelOp && (!IamTheMaster() || masterIsAWorker))
+      stats = pixelOp->getFrameStatistics();
+
+    int size = stats.size();
+    MPI_CALL(Allreduce(MPI_IN_PLACE, &size, 1, MPI_INT, MPI_MAX, world.comm));
+    if (size == 0)
+      return;
+
+    stats.resize(size, 0);
+    MPI_CALL(Allreduce(MPI_IN_PLACE, stats.data(), size, MPI_UINT32_T,
+                       MPI_SUM, world.comm));
+    if (pixelOp)
+      pixelOp->setFrameStatistics(stats);
+  }
+
   void DFB::reportTimings(std::ostream &os)
   {
 #if 1
-    std::lock_guard<std::mutex> lock(statsMutex);
+    for (const auto &t : tileTimings.consume()) {
+      queueTimes.push_back(t.first);
+      workTimes.push_back(t.second);
+    }
 
     using Stats = pico_bench::Statistics<RealMilliseconds>;
     if (!queueTimes.empty()) {
@@ -23,18 +23,37 @@
 // ospray_mpi
 #include "../common/Messaging.h"
 #include "DistributedFrameBuffer_TileMessages.h"
+// ospcommon
+#include "ospcommon/containers/MPSCQueue.h"
+#include "ospcommon/containers/MPSCRing.h"
 // std
+#include <atomic>
 #include <condition_variable>
 
 namespace ospray {
   struct TileDesc;
   struct TileData;
+  struct ZCompositeStage;
 
   class DistributedTileError : public TileError
   {
     public:
       DistributedTileError(const vec2i &numTiles);
-      void sync(); // broadcast tileErrorBuffer to all workers
+      void clear(); // must be called on all ranks
+      // broadcast the entries of tileErrorBuffer changed since the last
+      // sync to all workers
+      void sync();
+
+    private:
+      // the errors the workers know about
+      std::vector<float> syncedError;
+      // the entries changed since the last sync
+      struct ErrorUpdate
+      {
+        int32 tile;
+        float error;
+      };
+      std::vector<ErrorUpdate> updates;
   };
 
   struct DistributedFrameBuffer : public mpi::messaging::MessageHandler,
@@ -48,6 +67,11 @@ namespace ospray {
 
     ~DistributedFrameBuffer() override ;
 
+    void commit() override;
+
+    //! includes the mappable copy of the frame on the master
+    OSPMemoryUsage getMemoryUsage() const override;
+
     // ==================================================================
     // framebuffer / device interface
     // ==================================================================
@@ -82,8 +106,15 @@ namespace ospray {
     float tileError(const vec2i &tile) override;
     void  beginFrame() override;
     float endFrame(const float errorThreshold) override;
+    void  cancelFrame() override;
+    uint32 getTileChannels() const override;
 
-    enum FrameMode { WRITE_MULTIPLE, ALPHA_BLEND, Z_COMPOSITE };
+    /*! Z_COMPOSITE_RADIX_K composites the same as Z_COMPOSITE, but in
+        stages: the ranks are grouped by 'compositeRadix', each group
+        composites into one of its ranks, which forwards the result to the
+        next stage, until only the owner of the tile is left */
+    enum FrameMode { WRITE_MULTIPLE, ALPHA_BLEND, Z_COMPOSITE,
+                     Z_COMPOSITE_RADIX_K };
 
     void setFrameMode(FrameMode newFrameMode) ;
 
@@ -103,8 +134,21 @@ namespace ospray {
     //! process a client-to-client write tile message */
     void processMessage(WriteTileMessage *msg);
 
+    //! a write tile message of 'tile', with the codec of this frame
+    std::shared_ptr<mpicommon::Message> makeTileMessage(const ospray::Tile &tile) const;
+
+    //! decompress and process a final tile streamed to the master
+    void processMessage(CompressedTileMessage *msg, size_t size);
+
     size_t ownerIDFromTileID(size_t tileID) const;
 
+    /*! set the global rank owning each tile, replacing the default
+        round-robin assignment (restored by an empty 'owners'). This is
+        how renderers plug in their own ownership policies; all ranks need
+        to set the same owners between frames. Changing the owners
+        restarts the accumulation. */
+    void setTileOwners(const std::vector<size_t> &owners);
+
     // signal the workers whether to cancel 
     bool continueRendering() const { return !cancelRendering; }
 
@@ -113,13 +157,16 @@ namespace ospray {
   private:
 
     using RealMilliseconds = std::chrono::duration<double, std::milli>;
+    /*! (queue, work) time of each processed tile, pushed by the tasks
+        and drained into queueTimes/workTimes on the main thread */
+    ospcommon::MPSCQueue<std::pair<RealMilliseconds, RealMilliseconds>>
+      tileTimings;
     std::vector<RealMilliseconds> queueTimes;
     std::vector<RealMilliseconds> workTimes;
     RealMilliseconds finalGatherTime, masterTileWriteTime,
                      waitFrameFinishTime, compressTime, decompressTime,
                      preGatherDuration;
     double compressedPercent;
-    std::mutex statsMutex;
 
     std::vector<char> compressedBuf;
     std::vector<char> tileGatherResult;
@@ -127,10 +174,59 @@ namespace ospray {
     std::vector<char> compressedResults;
     std::atomic<size_t> nextTileWrite;
 
+    /*! whether the final tiles are streamed to the master as they are
+        completed, instead of gathered at the end of the frame */
+    bool streamFinalTiles {false};
+    //! the final tiles written/expected on the master this frame (streaming)
+    size_t numStreamedTiles {0};
+    size_t numStreamedTilesExpected {0};
+
+    /*! whether the final tiles of a frame are gathered on the master with
+        a non-blocking Igatherv while the next frame renders, and written
+        into the mappable copy at the end of that next frame (i.e., the
+        master lags one frame behind) */
+    bool pipelineFrames {false};
+
+    //! the (pipelined) gather of the final tiles of the previous frame
+    struct PendingGather
+    {
+      MPI_Request request {MPI_REQUEST_NULL};
+      //! the tiles sent, the next frame writes into tileGatherBuffer
+      std::vector<char> sendBuffer;
+      //! (master) the tiles received, and their size and offset per rank
+      std::vector<char> result;
+      std::vector<int> bytesExpected;
+      std::vector<int> offsets;
+      size_t numTiles {0};
+    };
+    PendingGather pendingGather;
+
+    /*! display wall mode: the frame is split into a grid of 'displayGrid'
+        (columns, rows) regions, shown by the consecutive global ranks from
+        'firstDisplayRank' on. The final tiles are sent straight from their
+        owners to the display ranks of their regions, instead of to the
+        master. Off while 'displayGrid' is 0 */
+    vec2i displayGrid {0};
+    int firstDisplayRank {0};
+
+    /*! the pixels kept in localFBonMaster: the whole frame on the master,
+        its display region on a display rank */
+    box2i localRegion;
+
+    /*! with 'rmaFinalTiles' the master exposes the buffers of
+        localFBonMaster in 'finalTileWindow' (a dynamic window at the
+        addresses 'finalTileAddress' of color, depth, normal and albedo),
+        and the owners MPI_Put their final tiles right into place, closed
+        by one fence per frame */
+    bool rmaFinalTiles {false};
+    MPI_Win finalTileWindow {MPI_WIN_NULL};
+    MPI_Aint finalTileAddress[4] {0, 0, 0, 0};
+
     friend struct TileData;
     friend struct WriteMultipleTile;
     friend struct AlphaBlendTile_simple;
     friend struct ZCompositeTile;
+    friend struct ZCompositeStage;
 
     // ==================================================================
     // internal helper functions
@@ -171,6 +267,18 @@ namespace ospray {
     TileData *createTile(const vec2i &xy, size_t tileID, size_t ownerID);
     void freeTiles();
 
+    //! number of ranks rendering (and compositing) tiles
+    size_t numCompositeRanks() const;
+
+    /*! the radix-k compositing tree of 'tileID' at this rank: the number
+        of parts composited here (including our own) and the global rank
+        the result is sent to (our own one at the owner of the tile) */
+    void compositeTree(size_t tileID, size_t &numParts, size_t &parentRank) const;
+
+    /*! forward a tile of the radix-k compositing to the next stage (or
+        into the owner's tile) */
+    void compositeStage(const ospray::Tile &tile);
+
     /*! atomic update and check if frame is complete with given tiles */
     bool isFrameComplete(size_t numTiles);
 
@@ -181,12 +289,60 @@ namespace ospray {
      * copy into the framebuffer */
     void gatherFinalTiles();
 
+    /*! start gathering the final tiles to the master without waiting for
+        them, completed by finishFinalGather at the end of the next frame;
+        must be called on all ranks */
+    void startFinalGather();
+
+    /*! wait for the pending gather (if any) and write its tiles on the
+        master; must be called on all ranks */
+    void finishFinalGather();
+
+    //! (master) write the 'numTiles' gathered final tiles in 'tiles'
+    void writeGatheredTiles(std::vector<char> &tiles, size_t numTiles);
+
+    /*! (re)create or free finalTileWindow for the current 'rmaFinalTiles'
+        and localFBonMaster; must be called on all ranks */
+    void updateFinalTileWindow();
+
+    //! MPI_Put the channels of a final tile into the buffers of the master
+    void putFinalTile(TileData *tile);
+
+    /*! complete the puts of this frame (if in 'rmaFinalTiles' mode); must
+        be called on all ranks */
+    void fenceFinalTiles();
+
+    /*! sum the frame statistics of the pixel op (e.g., histograms of the
+        tiles owned by each rank) over all ranks; must be called on all
+        ranks */
+    void reducePixelOpStatistics();
+
     /*! Gather the tile IDs and error info from the other ranks to the master,
      * for OSP_FB_NONE rendering, where we only track that info on the master */
     void gatherFinalErrors();
 
     void sendCancelRenderingMessage();
 
+    /*! compress a final tile and send it to the global 'rank' (the master
+        or a display rank), or write it directly when that is us */
+    void streamFinalTile(const mpicommon::Message &tileMsg, int rank);
+
+    //! whether the final tiles are sent to display ranks (see displayGrid)
+    bool routeToDisplays() const;
+
+    //! the pixels of the region 'cell' of the display grid
+    box2i displayRegion(int cell) const;
+
+    //! stream a final tile to the display ranks of all regions it overlaps
+    void sendToDisplays(const mpicommon::Message &tileMsg, const vec2i &begin);
+
+    /*! (re)create localFBonMaster on the master, or on a display rank for
+        its display region */
+    void updateLocalFB();
+
+    //! write a (decompressed) final tile into localFBonMaster
+    void writeFinalTile(TileMessage *msg);
+
     // Data members ///////////////////////////////////////////////////////////
 
     int32 *tileAccumID; //< holds accumID per tile, for adaptive accumulation
@@ -197,17 +353,35 @@ namespace ospray {
     DistributedTileError tileErrorRegion;
 
     /*! local frame buffer on the master used for storing the final
-        tiles. will be null on all workers, and _may_ be null on the
-        master if the master does not have a color buffer */
+        tiles. will be null on all workers (but the display ranks of a
+        display wall, see displayGrid), and _may_ be null on the master
+        if the master does not have a color buffer */
     std::unique_ptr<LocalFrameBuffer> localFBonMaster;
 
     FrameMode frameMode;
 
+    //! the owner of each tile if not assigned round-robin, see setTileOwners
+    std::vector<size_t> tileOwners;
+
+    /*! the codec of the tiles sent for compositing, lossy codecs are only
+        used for 'interactive' frames, the others use TILE_CODEC_LOSSLESS */
+    TileCodec tileCodec {TILE_CODEC_NONE};
+    int tileDepthBits {24};
+    bool interactive {false};
+
+    //! the group size of a stage in Z_COMPOSITE_RADIX_K mode
+    size_t compositeRadix {2};
+
+    /*! the partial composites of the tiles we are not the owner of, but
+        composite for other ranks in Z_COMPOSITE_RADIX_K mode (indexed by
+        tileID, null where we only send our own part) */
+    std::vector<std::unique_ptr<ZCompositeStage>> compositeStages;
+
     /*! #tiles we've (already) sent to / received by the master this frame
         (used to track when current node is done with this frame - we are done
         exactly once we've completed sending / receiving the last tile to / by
         the master) */
-    size_t numTilesCompletedThisFrame;
+    std::atomic<size_t> numTilesCompletedThisFrame;
 
     /*! The total number of tiles completed by all workers during this frame,
         to track progress for the user's progress callback. NOTE: This is
@@ -219,7 +393,7 @@ namespace ospray {
     /*! The number of tiles the master is expecting to receive from each rank */
     std::vector<size_t> numTilesExpected;
 
-    /* protected numTilesCompletedThisFrame to ensure atomic update and compare */
+    /* guards the progress reports, and the start of a frame */
     std::mutex numTilesMutex;
 
     /*! vector of info for *all* tiles. Each logical tile in the
@@ -230,6 +404,9 @@ namespace ospray {
         node'), with the actual data of those tiles */
     std::vector<TileData *> myTiles;
 
+    //! memory of the tiles and per-tile arrays, summed up by createTiles
+    size_t tileMemory {0};
+
     /*! mutex used to protect all threading-sensitive data in this
         object */
     std::mutex mutex;
@@ -247,8 +424,7 @@ namespace ospray {
 
     bool masterIsAWorker {false};
 
-    int reportRenderingProgress;
-    int renderingProgressTiles;
+    std::atomic<int> renderingProgressTiles;
     std::chrono::high_resolution_clock::time_point lastProgressReport;
 
     //! condition that gets triggered when the frame is done
@@ -263,8 +439,11 @@ namespace ospray {
     std::vector<std::shared_ptr<mpicommon::Message>> delayedMessage;
 
     /*! Gather all tile errors in the optimized FB_NONE case to send them out
-        in the single gatherv. */
-    std::mutex tileErrorsMutex;
+        in the single gatherv. Completed tiles push to the ring, which holds
+        at least myTiles.size() entries, and gatherFinalErrors() drains it
+        into tileIDs/tileErrors. */
+    std::unique_ptr<ospcommon::MPSCRing<std::pair<vec2i, float>>>
+      tileErrorRing;
     std::vector< vec2i > tileIDs;
     std::vector< float > tileErrors;
   };
@@ -15,27 +15,326 @@
 // ======================================================================== //
 #include "../common/Messaging.h"
 #include "DistributedFrameBuffer_TileMessages.h"
+// snappy
+#include <snappy.h>
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
 
 namespace ospray {
 
+// the header of a write tile message is the tile up to its first plane
+static const size_t tileHeaderSize = offsetof(ospray::Tile, r);
+
+// calls fcn(plane) for color and the given optional planes of a tile, in
+// memory order
+template <typename TileT, typename FCN_T>
+static void forEachTilePlane(TileT &tile, uint32 channels, FCN_T &&fcn)
+{
+  fcn(tile.r); fcn(tile.g); fcn(tile.b); fcn(tile.a);
+  if (channels & OSP_FB_DEPTH) {
+    fcn(tile.z);
+  }
+  if (channels & OSP_FB_NORMAL) {
+    fcn(tile.nx); fcn(tile.ny); fcn(tile.nz);
+  }
+  if (channels & OSP_FB_ALBEDO) {
+    fcn(tile.ar); fcn(tile.ag); fcn(tile.ab);
+  }
+}
+
+// rows outside of the region (at the lower/upper edges of the frame
+// buffer) are not sent
+static size_t tilePlaneSize(const ospray::Tile &tile)
+{
+  return tile.region.size().y * TILE_SIZE * sizeof(float);
+}
+
+// whether the planes of the tile are those of TILE_CODEC_EMPTY
+static bool tileIsEmpty(const ospray::Tile &tile, uint32 channels, size_t n)
+{
+  bool empty = true;
+  forEachTilePlane(tile, channels, [&](const float *plane) {
+    const float background = plane == tile.z ? (float)inf : 0.f;
+    for (size_t i = 0; empty && i < n; i++)
+      empty = plane[i] == background;
+  });
+  return empty;
+}
+
+// half precision floats, rounded to nearest (denormals are flushed to 0)
+static uint16_t floatToHalf(float f)
+{
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  const uint32_t sign = (x >> 16) & 0x8000;
+  const uint32_t mant = x & 0x7fffff;
+  const int exp = int((x >> 23) & 0xff) - 127 + 15;
+  if (((x >> 23) & 0xff) == 0xff) // inf and nan
+    return sign | 0x7c00 | (mant ? 0x200 : 0);
+  if (exp <= 0)
+    return sign;
+  if (exp >= 31)
+    return sign | 0x7c00;
+  // a carry of the rounding correctly increments the exponent
+  return (sign | (exp << 10) | (mant >> 13)) + ((mant >> 12) & 1);
+}
+
+static float halfToFloat(uint16_t h)
+{
+  const uint32_t sign = uint32_t(h & 0x8000) << 16;
+  const uint32_t exp = (h >> 10) & 0x1f;
+  const uint32_t mant = h & 0x3ff;
+  uint32_t x = sign;
+  if (exp == 31)
+    x |= 0x7f800000 | (mant << 13);
+  else if (exp != 0)
+    x |= ((exp - 15 + 127) << 23) | (mant << 13);
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+static uint8_t linearToSRGB8(float v)
+{
+  v = clamp(v, 0.f, 1.f);
+  v = v <= 0.0031308f ? 12.92f * v : 1.055f * std::pow(v, 1.f/2.4f) - 0.055f;
+  return uint8_t(v * 255.f + 0.5f);
+}
+
+static float srgb8ToLinear(uint8_t c)
+{
+  static const std::array<float, 256> table = []{
+    std::array<float, 256> t;
+    for (int i = 0; i < 256; i++) {
+      const float v = i / 255.f;
+      t[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+    }
+    return t;
+  }();
+  return table[c];
+}
+
+// the bytes per value of a plane encoded with a lossy codec
+static size_t lossyValueSize(const ospray::Tile &tile, const float *plane,
+                             TileCodec codec, int depthBits)
+{
+  if (plane == tile.z)
+    return depthBits / 8;
+  const bool color = plane == tile.r || plane == tile.g
+    || plane == tile.b || plane == tile.a;
+  return color && codec == TILE_CODEC_SRGB8 ? 1 : 2;
+}
+
+// the finite depths are mapped to [0, maxCode-1] over the range of the
+// tile (which precedes the plane), maxCode encodes infinity (no hit)
+static uint8_t *encodeDepth(const float *z, size_t n, int depthBits,
+                            uint8_t *out)
+{
+  float zMin = (float)inf, zMax = -(float)inf;
+  for (size_t i = 0; i < n; i++) {
+    if (z[i] < (float)inf) {
+      zMin = std::min(zMin, z[i]);
+      zMax = std::max(zMax, z[i]);
+    }
+  }
+  const uint32_t maxCode = (1u << depthBits) - 1;
+  const float scale = zMax > zMin ? (maxCode - 1) / (zMax - zMin) : 0.f;
+  std::memcpy(out, &zMin, sizeof(float));
+  std::memcpy(out + sizeof(float), &zMax, sizeof(float));
+  out += 2 * sizeof(float);
+
+  const int bytes = depthBits / 8;
+  for (size_t i = 0; i < n; i++) {
+    const uint32_t code = z[i] < (float)inf ?
+      uint32_t((z[i] - zMin) * scale + 0.5f) : maxCode;
+    for (int b = 0; b < bytes; b++)
+      *out++ = uint8_t(code >> (8 * b));
+  }
+  return out;
+}
+
+static const uint8_t *decodeDepth(const uint8_t *in, size_t n, int depthBits,
+                                  float *z)
+{
+  float zMin, zMax;
+  std::memcpy(&zMin, in, sizeof(float));
+  std::memcpy(&zMax, in + sizeof(float), sizeof(float));
+  in += 2 * sizeof(float);
+
+  const uint32_t maxCode = (1u << depthBits) - 1;
+  const float scale = (zMax - zMin) / (maxCode - 1);
+  const int bytes = depthBits / 8;
+  for (size_t i = 0; i < n; i++) {
+    uint32_t code = 0;
+    for (int b = 0; b < bytes; b++)
+      code |= uint32_t(*in++) << (8 * b);
+    z[i] = code == maxCode ? (float)inf : zMin + code * scale;
+  }
+  return in;
+}
+
 std::shared_ptr<mpicommon::Message> makeWriteTileMessage(const ospray::Tile &tile,
-                                                         bool hasAux)
+                                                         uint32 channels,
+                                                         TileCodec codec,
+                                                         int depthBits)
 {
-  const size_t msgSize = hasAux ? sizeof(ospray::Tile)
-                                : sizeof(WriteTileMessage);
-  auto msg = std::make_shared<mpicommon::Message>(msgSize + sizeof(int));
-  const static int header = WORKER_WRITE_TILE;
-  std::memcpy(msg->data, &header, sizeof(int));
-  std::memcpy(msg->data + sizeof(int), &tile, msgSize);
+  channels &= tile.channels;
+  depthBits = depthBits <= 16 ? 16 : 24;
+
+  const size_t planeSize = tilePlaneSize(tile);
+  const size_t n = planeSize / sizeof(float);
+  if (tileIsEmpty(tile, channels, n))
+    codec = TILE_CODEC_EMPTY;
+
+  const size_t numPlanes = 4 + (channels & OSP_FB_DEPTH ? 1 : 0)
+    + (channels & OSP_FB_NORMAL ? 3 : 0) + (channels & OSP_FB_ALBEDO ? 3 : 0);
+  const size_t rawSize = numPlanes * planeSize;
+  const size_t headerSize = sizeof(WriteTileMessage) + tileHeaderSize;
+  size_t maxPayloadSize = rawSize + 2 * sizeof(float);
+  if (codec == TILE_CODEC_LOSSLESS)
+    maxPayloadSize = snappy::MaxCompressedLength(rawSize);
+  else if (codec == TILE_CODEC_EMPTY)
+    maxPayloadSize = 0;
+
+  auto msg = std::make_shared<mpicommon::Message>(headerSize + maxPayloadSize);
+  auto *header = reinterpret_cast<WriteTileMessage*>(msg->data);
+  header->command = WORKER_WRITE_TILE;
+  header->codec = codec;
+  header->depthBits = depthBits;
+
+  auto *out = msg->data + sizeof(WriteTileMessage);
+  std::memcpy(out, &tile, tileHeaderSize);
+  std::memcpy(out + offsetof(ospray::Tile, channels), &channels,
+              sizeof(channels));
+  out += tileHeaderSize;
+
+  switch (codec) {
+  case TILE_CODEC_EMPTY:
+    break;
+  case TILE_CODEC_NONE:
+    forEachTilePlane(tile, channels, [&](const float *plane) {
+      std::memcpy(out, plane, planeSize);
+      out += planeSize;
+    });
+    break;
+  case TILE_CODEC_LOSSLESS: {
+    // neighboring floats share most of their high bits, which become
+    // zero bytes after the XOR, gathered in runs by the byte shuffle
+    const size_t numValues = numPlanes * n;
+    std::vector<uint32_t> delta(numValues);
+    uint32_t *d = delta.data();
+    forEachTilePlane(tile, channels, [&](const float *plane) {
+      std::memcpy(d, plane, planeSize);
+      for (size_t i = n - 1; i > 0; i--)
+        d[i] ^= d[i - 1];
+      d += n;
+    });
+    std::vector<char> shuffled(rawSize);
+    for (size_t i = 0; i < numValues; i++) {
+      for (size_t b = 0; b < sizeof(uint32_t); b++)
+        shuffled[b * numValues + i] = char(delta[i] >> (8 * b));
+    }
+    size_t compressedSize = 0;
+    snappy::RawCompress(shuffled.data(), rawSize,
+                        reinterpret_cast<char*>(out), &compressedSize);
+    out += compressedSize;
+    break;
+  }
+  case TILE_CODEC_FP16:
+  case TILE_CODEC_SRGB8:
+    forEachTilePlane(tile, channels, [&](const float *plane) {
+      const size_t valueSize = lossyValueSize(tile, plane, codec, depthBits);
+      if (plane == tile.z) {
+        out = encodeDepth(plane, n, depthBits, out);
+      } else if (valueSize == 1) {
+        const bool alpha = plane == tile.a;
+        for (size_t i = 0; i < n; i++) {
+          *out++ = alpha ? uint8_t(clamp(plane[i], 0.f, 1.f) * 255.f + 0.5f)
+                         : linearToSRGB8(plane[i]);
+        }
+      } else {
+        for (size_t i = 0; i < n; i++) {
+          const uint16_t h = floatToHalf(plane[i]);
+          std::memcpy(out, &h, sizeof(h));
+          out += sizeof(h);
+        }
+      }
+    });
+    break;
+  }
+
+  header->payloadSize = out - (msg->data + headerSize);
+  msg->size = headerSize + header->payloadSize;
   return msg;
 }
 
-void unpackWriteTileMessage(WriteTileMessage *msg, ospray::Tile &tile,
-                            bool hasAux)
+void unpackWriteTileMessage(WriteTileMessage *msg, ospray::Tile &tile)
 {
-  const size_t msgSize = hasAux ? sizeof(ospray::Tile)
-                                : sizeof(WriteTileMessage);
-  std::memcpy(&tile, reinterpret_cast<char*>(msg) + sizeof(int), msgSize);
+  const uint8_t *in = reinterpret_cast<uint8_t*>(msg) + sizeof(WriteTileMessage);
+  std::memcpy(&tile, in, tileHeaderSize);
+  in += tileHeaderSize;
+
+  const TileCodec codec = TileCodec(msg->codec);
+  const int depthBits = msg->depthBits;
+  const size_t planeSize = tilePlaneSize(tile);
+  const size_t n = planeSize / sizeof(float);
+  switch (codec) {
+  case TILE_CODEC_EMPTY:
+    forEachTilePlane(tile, tile.channels, [&](float *plane) {
+      std::fill(plane, plane + n, plane == tile.z ? (float)inf : 0.f);
+    });
+    break;
+  case TILE_CODEC_NONE:
+    forEachTilePlane(tile, tile.channels, [&](float *plane) {
+      std::memcpy(plane, in, planeSize);
+      in += planeSize;
+    });
+    break;
+  case TILE_CODEC_LOSSLESS: {
+    size_t rawSize = 0;
+    snappy::GetUncompressedLength(reinterpret_cast<const char*>(in),
+                                  msg->payloadSize, &rawSize);
+    std::vector<char> shuffled(rawSize);
+    snappy::RawUncompress(reinterpret_cast<const char*>(in), msg->payloadSize,
+                          shuffled.data());
+    const size_t numValues = rawSize / sizeof(uint32_t);
+    size_t offset = 0;
+    forEachTilePlane(tile, tile.channels, [&](float *plane) {
+      uint32_t prev = 0;
+      for (size_t i = 0; i < n; i++, offset++) {
+        uint32_t v = 0;
+        for (size_t b = 0; b < sizeof(uint32_t); b++)
+          v |= uint32_t(uint8_t(shuffled[b * numValues + offset])) << (8 * b);
+        prev = i == 0 ? v : v ^ prev;
+        std::memcpy(&plane[i], &prev, sizeof(float));
+      }
+    });
+    break;
+  }
+  case TILE_CODEC_FP16:
+  case TILE_CODEC_SRGB8:
+    forEachTilePlane(tile, tile.channels, [&](float *plane) {
+      const size_t valueSize = lossyValueSize(tile, plane, codec, depthBits);
+      if (plane == tile.z) {
+        in = decodeDepth(in, n, depthBits, plane);
+      } else if (valueSize == 1) {
+        const bool alpha = plane == tile.a;
+        for (size_t i = 0; i < n; i++, in++)
+          plane[i] = alpha ? *in / 255.f : srgb8ToLinear(*in);
+      } else {
+        for (size_t i = 0; i < n; i++) {
+          uint16_t h;
+          std::memcpy(&h, in, sizeof(h));
+          plane[i] = halfToFloat(h);
+          in += sizeof(h);
+        }
+      }
+    });
+    break;
+  }
 }
 
 size_t masterMsgSize(OSPFrameBufferFormat fmt, bool hasDepth,
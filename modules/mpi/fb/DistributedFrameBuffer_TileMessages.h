@@ -43,7 +43,10 @@ namespace ospray {
     // abort rendering the current frame
     CANCEL_RENDERING = 1 << 6,
     // Worker updating us on tiles completed
-    PROGRESS_MESSAGE = 1 << 7
+    PROGRESS_MESSAGE = 1 << 7,
+    /*! a (snappy) compressed final tile, streamed to the master as soon as
+        it is completed instead of gathered at the end of the frame */
+    MASTER_TILE_COMPRESSED = 1 << 8
   };
 
   struct TileMessage
@@ -92,30 +95,53 @@ namespace ospray {
   using MasterTileMessage_RGBAF32_Z_AUX = MasterTileMessage_FB_Depth_Aux<vec4f>;
   using MasterTileMessage_NONE       = MasterTileMessage;
 
+  /*! header of a MASTER_TILE_COMPRESSED message, followed by the
+      compressed (master) tile message */
+  struct CompressedTileMessage : public TileMessage
+  {
+    uint32_t uncompressedSize;
+  };
+
+  /*! how the planes of a write tile message are encoded */
+  enum TileCodec
+  {
+    //! plain floats
+    TILE_CODEC_NONE,
+    /*! lossless: the bits of each float XOR-ed with its predecessor,
+        shuffled into byte planes and snappy compressed */
+    TILE_CODEC_LOSSLESS,
+    //! lossy: half floats, and the depth quantized to 'depthBits'
+    TILE_CODEC_FP16,
+    /*! lossy: 8 bit sRGB color (clamped to [0, 1]) and alpha, half float
+        normal and albedo, and the depth quantized to 'depthBits' */
+    TILE_CODEC_SRGB8,
+    /*! the tile has no hits: color, alpha, normal and albedo are 0 and the
+        depth is infinite, so no planes are sent at all. Chosen by
+        makeWriteTileMessage for such tiles regardless of the codec */
+    TILE_CODEC_EMPTY
+  };
+
   /*! message sent from one node's instance to another, to tell that
-      instance to write that tile */
+      instance to write that tile. It is followed by the header of the
+      tile (everything before its planes) and, packed, only the rows of
+      the tile's region of only the planes of the tile's channels,
+      encoded with 'codec' */
   struct WriteTileMessage : public TileMessage
   {
-    region2i region; // screen region that this corresponds to
-    vec2i    fbSize; // total frame buffer size, for the camera
-    vec2f    rcp_fbSize;
-    int32    generation;
-    int32    children;
-    int32    sortOrder;
-    int32    accumID; //!< how often has been accumulated into this tile
-    float    pad[4]; //!< padding to match the ISPC-side layout
-    float    r[TILE_SIZE*TILE_SIZE];  // 'red' component
-    float    g[TILE_SIZE*TILE_SIZE];  // 'green' component
-    float    b[TILE_SIZE*TILE_SIZE];  // 'blue' component
-    float    a[TILE_SIZE*TILE_SIZE];  // 'alpha' component
-    float    z[TILE_SIZE*TILE_SIZE];  // 'depth' component
+    int codec;
+    int depthBits;
+    //! the size of the encoded planes
+    uint32_t payloadSize;
   };
 
+  /*! 'channels' masks the optional planes of the tile to be sent,
+      'depthBits' (16 or 24) is used by the lossy codecs only */
   std::shared_ptr<mpicommon::Message> makeWriteTileMessage(const ospray::Tile &tile,
-                                                           bool hasAux);
+                                                           uint32 channels,
+                                                           TileCodec codec = TILE_CODEC_NONE,
+                                                           int depthBits = 24);
 
-  void unpackWriteTileMessage(WriteTileMessage *msg, ospray::Tile &tile,
-                              bool hasAux);
+  void unpackWriteTileMessage(WriteTileMessage *msg, ospray::Tile &tile);
 
   size_t masterMsgSize(OSPFrameBufferFormat fmt, bool hasDepth,
                        bool hasNormal, bool hasAlbedo);
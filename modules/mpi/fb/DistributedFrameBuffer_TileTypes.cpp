@@ -47,6 +47,7 @@ namespace ospray {
     missingInCurrentGeneration = 1;
 
     assert(bufferedTile.empty());
+    parts.clear();
     if (!bufferedTile.empty()) {
       std::cout << mpicommon::globalRank()
         << " is starting with buffered tiles!\n" << std::flush;
@@ -77,11 +78,25 @@ namespace ospray {
     written into / composited into this dfb tile */
   void AlphaBlendTile_simple::process(const ospray::Tile &tile)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    BufferedTile *addTile = new BufferedTile;
-    memcpy(&addTile->tile,&tile,sizeof(tile));
+    addTile(tile, true);
+  }
 
-    bufferedTile.push_back(addTile);
+  void AlphaBlendTile_simple::processEmpty(const ospray::Tile &tile)
+  {
+    addTile(tile, false);
+  }
+
+  void AlphaBlendTile_simple::addTile(const ospray::Tile &tile, bool hasHits)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    // a tile without hits adds nothing to the blend, but one is needed to
+    // blend into
+    if (hasHits || bufferedTile.empty()) {
+      auto addTile = TilePool::acquire();
+      memcpy(addTile.get(), &tile, sizeof(tile));
+      bufferedTile.push_back(std::move(addTile));
+    }
+    parts.emplace_back(tile.generation, tile.children);
 
     if (tile.generation == currentGeneration) {
       --missingInCurrentGeneration;
@@ -102,11 +117,10 @@ namespace ospray {
         missingInCurrentGeneration = expectedInNextGeneration;
         expectedInNextGeneration = 0;
 
-        for (uint32_t i = 0; i < bufferedTile.size(); i++) {
-          BufferedTile *bt = bufferedTile[i];
-          if (bt->tile.generation == currentGeneration) {
+        for (const auto &part : parts) {
+          if (part.first == currentGeneration) {
             --missingInCurrentGeneration;
-            expectedInNextGeneration += bt->tile.children;
+            expectedInNextGeneration += part.second;
           }
           if (missingInCurrentGeneration < 0) {
             std::stringstream str;
@@ -135,14 +149,14 @@ namespace ospray {
 #if 1
       // Sort for back-to-front blending
       std::sort(bufferedTile.begin(), bufferedTile.end(),
-          [](const BufferedTile *a, const BufferedTile *b) {
-            return a->tile.sortOrder > b->tile.sortOrder;
+          [](const TilePool::Ptr &a, const TilePool::Ptr &b) {
+            return a->sortOrder > b->sortOrder;
           });
 #endif
 
       Tile **tileArray = STACK_BUFFER(Tile*, bufferedTile.size());
       for (uint32_t i = 0; i < bufferedTile.size(); i++) {
-        tileArray[i] = &bufferedTile[i]->tile;
+        tileArray[i] = bufferedTile[i].get();
       }
 
       ispc::DFB_sortAndBlendFragments((ispc::VaryingTile **)tileArray,
@@ -151,21 +165,22 @@ namespace ospray {
       this->final.region = tile.region;
       this->final.fbSize = tile.fbSize;
       this->final.rcp_fbSize = tile.rcp_fbSize;
-      accumulate(bufferedTile[0]->tile);
+      accumulate(*bufferedTile[0]);
       dfb->tileIsCompleted(this);
-      for (auto &tile : bufferedTile)
-        delete tile;
 
       bufferedTile.clear();
+      parts.clear();
     }
   }
 
   void WriteMultipleTile::newFrame()
   {
-    maxAccumID = 0;
     instances = dfb->tileInstances[tileID];
     writeOnceTile = instances <= 1;
-    tileBuffered = false;
+    slots.clear();
+    slots.resize(instances);
+    nextSlot = 0;
+    numStored = 0;
   }
 
   void WriteMultipleTile::process(const ospray::Tile &tile)
@@ -179,8 +194,6 @@ namespace ospray {
       return;
     }
 
-    bool done = false;
-
     if (tile.accumID == 0) {
       final.region = tile.region;
       final.fbSize = tile.fbSize;
@@ -191,71 +204,142 @@ namespace ospray {
       memcpy(final.z, tile.z, bytes);
     }
 
-    {
-      SCOPED_LOCK(mutex);
-      maxAccumID = std::max(maxAccumID, tile.accumID);
-      if (!tileBuffered && (tile.accumID & 1) == 0) {
-        memcpy(&bufferedTile, &tile, sizeof(ospray::Tile));
-        tileBuffered = true;
-      } else {
-        ispc::DFB_accumulateTileSimple(
-          (const ispc::VaryingTile*)&tile,
-          (ispc::VaryingTile*)&accum,
-          (ispc::VaryingTile*)&variance);
-        if (dfb->hasNormalBuffer || dfb->hasAlbedoBuffer)
-          ispc::DFB_accumulateAuxTile((const ispc::VaryingTile*)&tile
-              , (ispc::Tile*)&final
-              , (ispc::VaryingTile*)&accum
-              );
+    const size_t slot = nextSlot++;
+    slots[slot] = TilePool::acquire();
+    memcpy(slots[slot].get(), &tile, sizeof(ospray::Tile));
+    if (++numStored < instances)
+      return;
+
+    // accumulate in order of accumID, thus independent of the arrival order
+    std::sort(slots.begin(), slots.end(),
+              [](const TilePool::Ptr &a, const TilePool::Ptr &b) {
+                return a->accumID < b->accumID;
+              });
+    const int maxAccumID = slots.back()->accumID;
+
+    // defer accumulation of the first even tile to get a correct variance
+    // estimate
+    size_t buffered = slots.size() - 1;
+    for (size_t i = 0; i < slots.size(); i++) {
+      if ((slots[i]->accumID & 1) == 0) {
+        buffered = i;
+        break;
       }
-      done = --instances == 0;
     }
-
-    if (done) {
-      auto sz = tile.region.size();
-      if ((maxAccumID & 1) == 0) {
-        // if maxAccumID is even, variance buffer is one accumulated tile
-        // short, which leads to vast over-estimation of variance; thus
-        // estimate variance now, when accum buffer is also one (the buffered)
-        // tile short
-        const float prevErr = DFB_computeErrorForTile(
-          (ispc::vec2i&)sz,
-          (ispc::VaryingTile*)&accum,
-          (ispc::VaryingTile*)&variance,
-          maxAccumID - 1);
-
-        // use maxAccumID for correct normalization
-        // this is OK, because both accumIDs are even
-        bufferedTile.accumID = maxAccumID;
-        accumulate(bufferedTile);
-        error = prevErr;
-      } else {
-        // correct normalization is with maxAccumID, which is odd here
-        bufferedTile.accumID = maxAccumID;
-        // but original bufferedTile.accumID is always even and thus won't be
-        // accumulated into variance buffer
-        DFB_accumulateTile((const ispc::VaryingTile*)&bufferedTile
-            , (ispc::VaryingTile*)&final
+    for (size_t i = 0; i < slots.size(); i++) {
+      if (i == buffered)
+        continue;
+      ispc::DFB_accumulateTileSimple(
+        (const ispc::VaryingTile*)slots[i].get(),
+        (ispc::VaryingTile*)&accum,
+        (ispc::VaryingTile*)&variance);
+      if (dfb->hasNormalBuffer || dfb->hasAlbedoBuffer)
+        ispc::DFB_accumulateAuxTile((const ispc::VaryingTile*)slots[i].get()
+            , (ispc::Tile*)&final
             , (ispc::VaryingTile*)&accum
-            , (ispc::VaryingTile*)&variance
-            , dfb->hasAccumBuffer
-            , false // disable accumulation of variance
             );
-        if (dfb->hasNormalBuffer || dfb->hasAlbedoBuffer)
-          ispc::DFB_accumulateAuxTile((const ispc::VaryingTile*)&bufferedTile
-              , (ispc::Tile*)&final
-              , (ispc::VaryingTile*)&accum
-              );
-        // but still need to update the error
-        error = DFB_computeErrorForTile((ispc::vec2i&)sz
+    }
+    ospray::Tile &bufferedTile = *slots[buffered];
+
+    auto sz = tile.region.size();
+    if ((maxAccumID & 1) == 0) {
+      // if maxAccumID is even, variance buffer is one accumulated tile
+      // short, which leads to vast over-estimation of variance; thus
+      // estimate variance now, when accum buffer is also one (the buffered)
+      // tile short
+      const float prevErr = DFB_computeErrorForTile(
+        (ispc::vec2i&)sz,
+        (ispc::VaryingTile*)&accum,
+        (ispc::VaryingTile*)&variance,
+        maxAccumID - 1);
+
+      // use maxAccumID for correct normalization
+      // this is OK, because both accumIDs are even
+      bufferedTile.accumID = maxAccumID;
+      accumulate(bufferedTile);
+      error = prevErr;
+    } else {
+      // correct normalization is with maxAccumID, which is odd here
+      bufferedTile.accumID = maxAccumID;
+      // but original bufferedTile.accumID is always even and thus won't be
+      // accumulated into variance buffer
+      DFB_accumulateTile((const ispc::VaryingTile*)&bufferedTile
+          , (ispc::VaryingTile*)&final
+          , (ispc::VaryingTile*)&accum
+          , (ispc::VaryingTile*)&variance
+          , dfb->hasAccumBuffer
+          , false // disable accumulation of variance
+          );
+      if (dfb->hasNormalBuffer || dfb->hasAlbedoBuffer)
+        ispc::DFB_accumulateAuxTile((const ispc::VaryingTile*)&bufferedTile
+            , (ispc::Tile*)&final
             , (ispc::VaryingTile*)&accum
-            , (ispc::VaryingTile*)&variance
-            , maxAccumID
             );
-      }
+      // but still need to update the error
+      error = DFB_computeErrorForTile((ispc::vec2i&)sz
+          , (ispc::VaryingTile*)&accum
+          , (ispc::VaryingTile*)&variance
+          , maxAccumID
+          );
+    }
 
-      dfb->tileIsCompleted(this);
+    slots.clear();
+    dfb->tileIsCompleted(this);
+  }
+
+  ZCompositor::~ZCompositor()
+  {
+    delete pending.exchange(nullptr);
+  }
+
+  void ZCompositor::newFrame(size_t numParts)
+  {
+    this->numParts = numParts;
+    delete pending.exchange(nullptr);
+  }
+
+  void ZCompositor::combine(Part &part, const ospray::Tile &tile,
+                            size_t numParts, bool hasHits)
+  {
+    // there is nothing closer to composite from a part without hits, it is
+    // only needed if all parts are empty
+    if (hasHits) {
+      if (part.hasHits)
+        ispc::DFB_zComposite((const ispc::VaryingTile*)&tile,
+                             (ispc::VaryingTile*)part.tile.get());
+      else
+        memcpy(part.tile.get(), &tile, sizeof(tile));
+      part.hasHits = true;
+    }
+    part.numParts += numParts;
+  }
+
+  TilePool::Ptr ZCompositor::add(const ospray::Tile &tile, bool hasHits)
+  {
+    // composite directly into a waiting part, else copy the tile
+    std::unique_ptr<Part> part(pending.exchange(nullptr));
+    if (part) {
+      combine(*part, tile, 1, hasHits);
+    } else {
+      part.reset(new Part{TilePool::acquire(), 1, hasHits});
+      memcpy(part->tile.get(), &tile, sizeof(tile));
     }
+
+    while (part->numParts < numParts) {
+      std::unique_ptr<Part> other(pending.exchange(nullptr));
+      if (other) {
+        combine(*part, *other->tile, other->numParts, other->hasHits);
+        continue;
+      }
+      Part *expected = nullptr;
+      if (pending.compare_exchange_strong(expected, part.get())) {
+        // another arriving part continues with ours
+        part.release();
+        return nullptr;
+      }
+    }
+
+    return std::move(part->tile);
   }
 
   ZCompositeTile::ZCompositeTile(DistributedFrameBuffer *dfb,
@@ -269,28 +353,40 @@ namespace ospray {
 
   void ZCompositeTile::newFrame()
   {
-    numPartsComposited = 0;
+    compositor.newFrame(numWorkers);
   }
 
   void ZCompositeTile::process(const ospray::Tile &tile)
   {
-    bool done = false;
-
-    {
-      SCOPED_LOCK(mutex);
-      if (numPartsComposited == 0)
-        memcpy(&compositedTileData, &tile, sizeof(tile));
-      else
-        ispc::DFB_zComposite((const ispc::VaryingTile*)&tile,
-                             (ispc::VaryingTile*)&this->compositedTileData);
+    addPart(tile, true);
+  }
 
-      done = (++numPartsComposited == numWorkers);
-    }
+  void ZCompositeTile::processEmpty(const ospray::Tile &tile)
+  {
+    addPart(tile, false);
+  }
 
-    if (done) {
-      accumulate(this->compositedTileData);
+  void ZCompositeTile::addPart(const ospray::Tile &tile, bool hasHits)
+  {
+    TilePool::Ptr composited = compositor.add(tile, hasHits);
+    if (composited) {
+      accumulate(*composited);
       dfb->tileIsCompleted(this);
     }
   }
 
+  ZCompositeStage::ZCompositeStage(size_t numParts, size_t parentRank)
+    : numParts(numParts), parentRank(parentRank)
+  {}
+
+  void ZCompositeStage::newFrame()
+  {
+    compositor.newFrame(numParts);
+  }
+
+  TilePool::Ptr ZCompositeStage::process(const ospray::Tile &tile)
+  {
+    return compositor.add(tile, true);
+  }
+
 }// namespace ospray
@@ -16,8 +16,9 @@
 
 #pragma once
 
-#include "fb/Tile.h"
+#include "fb/TilePool.h"
 
+#include <atomic>
 #include <vector>
 
 namespace ospray {
@@ -71,6 +72,10 @@ namespace ospray {
         written into / composited into this dfb tile */
     virtual void process(const ospray::Tile &tile) = 0;
 
+    /*! like process, for a tile without hits (see TILE_CODEC_EMPTY), which
+        compositing tiles only need to count */
+    virtual void processEmpty(const ospray::Tile &tile) { process(tile); }
+
     // WILL debugging
     virtual bool isComplete() const { return false; }
 
@@ -116,14 +121,45 @@ namespace ospray {
     void process(const ospray::Tile &tile) override;
 
    private:
-    int maxAccumID;
     size_t instances;
     bool writeOnceTile;
-    // serialize when multiple instances of this tile arrive at the same time
-    std::mutex mutex;
-    // defer accumulation to get correct variance estimate
-    ospray::Tile bufferedTile;
-    bool tileBuffered;
+    // the instances of this tile arriving at the same time are copied into
+    // their own slot without locking, the last one accumulates them all
+    std::vector<TilePool::Ptr> slots;
+    std::atomic<size_t> nextSlot {0};
+    std::atomic<size_t> numStored {0};
+  };
+
+  /*! lock-free Z-compositing of the parts of a tile arriving at the same
+      time: each part either waits in 'pending' or takes the part waiting
+      there, combines with it and tries again. Thus the parts are combined
+      pairwise in parallel, and the thread combining the last pair gets the
+      composite. */
+  struct ZCompositor
+  {
+    ~ZCompositor();
+
+    /*! called exactly once at the beginning of each frame */
+    void newFrame(size_t numParts);
+
+    /*! composite one part, a part without hits (see TILE_CODEC_EMPTY) is
+        only counted; returns the composite of all parts to the caller
+        adding the last one, null to all others */
+    TilePool::Ptr add(const ospray::Tile &tile, bool hasHits);
+
+  private:
+    struct Part
+    {
+      TilePool::Ptr tile;
+      size_t numParts;
+      bool hasHits;
+    };
+
+    static void combine(Part &part, const ospray::Tile &tile,
+                        size_t numParts, bool hasHits);
+
+    size_t numParts {0};
+    std::atomic<Part *> pending {nullptr};
   };
 
   // -------------------------------------------------------
@@ -140,17 +176,40 @@ namespace ospray {
         written into / composited into this dfb tile */
     void process(const ospray::Tile &tile) override;
 
-    /*! number of input tiles that have been composited into this
-        tile */
-    size_t numPartsComposited;
+    void processEmpty(const ospray::Tile &tile) override;
 
     size_t numWorkers;
 
     /*! since we do not want to mess up the existing accumulatation
-        buffer in the parent tile we temporarily composite into this
-        buffer until all the composites have been done. */
-    ospray::Tile compositedTileData;
-    std::mutex mutex;
+        buffer in the parent tile we composite into separate tiles until
+        all the composites have been done. */
+    ZCompositor compositor;
+
+  private:
+    void addPart(const ospray::Tile &tile, bool hasHits);
+  };
+
+  /*! the partial Z-composite of a tile owned by another rank, which we
+      composite for a group of ranks in Z_COMPOSITE_RADIX_K mode before
+      forwarding it to the next stage. Unlike TileData it is neither
+      accumulated nor sent to the master. */
+  struct ZCompositeStage
+  {
+    ZCompositeStage(size_t numParts, size_t parentRank);
+
+    /*! called exactly once at the beginning of each frame */
+    void newFrame();
+
+    /*! composite one part, returns the composite to be forwarded when
+        that was the last part, else null */
+    TilePool::Ptr process(const ospray::Tile &tile);
+
+    //! number of parts to composite, including our own
+    size_t numParts;
+    //! the global rank of the next stage
+    size_t parentRank;
+
+    ZCompositor compositor;
   };
 
   /*! specialized tile implementation that first buffers all
@@ -171,21 +230,19 @@ namespace ospray {
         written into / composited into this dfb tile */
     void process(const ospray::Tile &tile) override;
 
-    bool isComplete() const override { return missingInCurrentGeneration == 0; }
-
-    struct BufferedTile
-    {
-      ospray::Tile tile;
+    void processEmpty(const ospray::Tile &tile) override;
 
-      /*! determines order of this tile relative to other tiles.
-
-        Tiles will get blended with the 'over' operator in
-        increasing 'BufferedTile::sortOrder' value */
-      float sortOrder;
-    };
+    bool isComplete() const override { return missingInCurrentGeneration == 0; }
 
   private:
-    std::vector<BufferedTile *> bufferedTile;
+    /*! add a tile, which is buffered for blending only if it 'hasHits' (or
+        is the first one) */
+    void addTile(const ospray::Tile &tile, bool hasHits);
+
+    // copies of the incoming tiles, taken from the TilePool
+    std::vector<TilePool::Ptr> bufferedTile;
+    // the generation and number of children of all incoming tiles
+    std::vector<std::pair<int, int>> parts;
     int currentGeneration;
     int expectedInNextGeneration;
     int missingInCurrentGeneration;
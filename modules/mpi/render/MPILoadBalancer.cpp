@@ -21,14 +21,17 @@
 #include "MPILoadBalancer.h"
 #include "../fb/DistributedFrameBuffer.h"
 #include "../common/Profiling.h"
+#include "mpiCommon/Tracing.h"
 // ospray
 #include "ospray/render/Renderer.h"
+#include "ospray/fb/TilePool.h"
 // ospcommon
 #include "ospcommon/tasking/parallel_for.h"
 #include "ospcommon/tasking/schedule.h"
 #include "ospcommon/utility/getEnvVar.h"
 // std
 #include <algorithm>
+#include <numeric>
 
 namespace ospray {
   namespace mpi {
@@ -41,6 +44,18 @@ namespace ospray {
 
     static bool REPL_DETAILED_LOGGING = false;
 
+    /*! the master does not render tiles itself, but knows about the
+        ones which are skipped because they converged */
+    static void recordSkippedTiles(DistributedFrameBuffer *dfb,
+                                   const float errorThreshold)
+    {
+      const box2i region = dfb->getRenderRegion();
+      for (int y = region.lower.y; y < region.upper.y; y++)
+        for (int x = region.lower.x; x < region.upper.x; x++)
+          if (dfb->tileError(vec2i(x, y)) <= errorThreshold)
+            dfb->recordSkippedTile();
+    }
+
     namespace staticLoadBalancer {
 
       // staticLoadBalancer::Master definitions ///////////////////////////////
@@ -71,9 +86,11 @@ namespace ospray {
         assert(dfb);
 
         ProfilingPoint startRender;
+        const double frameStart = getSysTime();
 
         dfb->startNewFrame(renderer->errorThreshold);
         dfb->beginFrame();
+        recordSkippedTiles(dfb, renderer->errorThreshold);
         dfb->closeCurrentFrame();
 
         /* the client will do its magic here, and the distributed
@@ -100,7 +117,12 @@ namespace ospray {
         }
         ++frameNumber;
 
-        return dfb->endFrame(renderer->errorThreshold);
+        const double endFrameStart = getSysTime();
+        const float error = dfb->endFrame(renderer->errorThreshold);
+        const double frameEnd = getSysTime();
+        dfb->recordFrameTime(frameEnd - frameStart, frameEnd - endFrameStart);
+
+        return error;
       }
 
       std::string Master::toString() const
@@ -120,51 +142,89 @@ namespace ospray {
         auto *dfb = dynamic_cast<DistributedFrameBuffer*>(fb);
 
         ProfilingPoint startRender;
+        const double frameStart = getSysTime();
 
         dfb->startNewFrame(renderer->errorThreshold);
         // dfb->beginFrame(); is called by renderer->beginFrame:
         void *perFrameData = renderer->beginFrame(fb);
 
-        const int ALLTASKS = fb->getTotalTiles();
-        int NTASKS = ALLTASKS / worker.size;
-
-        // NOTE(jda) - If all tiles do not divide evenly among all worker ranks
-        //             (a.k.a. ALLTASKS / worker.size has a remainder), then
-        //             some ranks will have one extra tile to do. Thus NTASKS
-        //             is incremented if we are one of those ranks.
-        if ((ALLTASKS % worker.size) > worker.rank)
-          NTASKS++;
-
-        // TODO WILL: The work assignment here does not match the tile
-        // ownership in the DFB, we should tweak it so that in replicated
-        // rendering each worker renders the round-robin ownership tiles
-        // that it owns in the DFB. This will cut down a lot of communication
-        tasking::parallel_for(NTASKS, [&](int taskIndex) {
-          const size_t tileID = taskIndex * worker.size + worker.rank;
-          const size_t numTiles_x = fb->getNumTiles().x;
-          const size_t tile_y = tileID / numTiles_x;
-          const size_t tile_x = tileID - tile_y*numTiles_x;
-          const vec2i tileId(tile_x, tile_y);
-          const int32 accumID = fb->accumID(tileId);
-
-          if (fb->tileError(tileId) <= renderer->errorThreshold)
-            return;
+        // only the tiles of the render region are distributed
+        const box2i region = fb->getRenderRegion();
+        const vec2i regionTiles = region.size();
+        const int ALLTASKS = regionTiles.x * regionTiles.y;
+
+        /* Only the tiles which did not converge yet are distributed, such
+           that converged parts of the image do not leave their workers
+           idle. All ranks know the same tile errors after the sync in
+           startNewFrame, and deal out the tiles in order of decreasing
+           error, going back and forth over the workers, such that each
+           gets about the same number of tiles and share of the error.
+           Every rank advances the accumulation ID of all tiles, which thus
+           stays right when a tile is rendered by another worker than in
+           the previous frame (the samples are accumulated on its owner) */
+        std::vector<int32> accumIDs(ALLTASKS);
+        std::vector<std::pair<float, int>> activeTiles;
+        for (int regionTileID = 0; regionTileID < ALLTASKS; ++regionTileID) {
+          const vec2i tileId = region.lower
+            + vec2i(regionTileID % regionTiles.x, regionTileID / regionTiles.x);
+          accumIDs[regionTileID] = fb->accumID(tileId);
+
+          const float error = fb->tileError(tileId);
+          if (error > renderer->errorThreshold)
+            activeTiles.emplace_back(error, regionTileID);
+          else if (regionTileID % worker.size == worker.rank)
+            fb->recordSkippedTile();
+        }
+
+        std::sort(activeTiles.begin(), activeTiles.end(),
+                  [](const std::pair<float, int> &a,
+                     const std::pair<float, int> &b) {
+                    return a.first > b.first
+                      || (a.first == b.first && a.second < b.second);
+                  });
+
+        std::vector<int> myTiles;
+        for (size_t i = 0; i < activeTiles.size(); ++i) {
+          const int round = i / worker.size;
+          const int slot = i % worker.size;
+          if ((round % 2 == 0 ? slot : worker.size - 1 - slot) == worker.rank)
+            myTiles.push_back(activeTiles[i].second);
+        }
+
+        tasking::parallel_for(myTiles.size(), [&](size_t taskIndex) {
+          const int regionTileID = myTiles[taskIndex];
+          const vec2i tileId = region.lower
+            + vec2i(regionTileID % regionTiles.x, regionTileID / regionTiles.x);
+          const int32 accumID = accumIDs[regionTileID];
+
+          const double tileStart = getSysTime();
 
 #if TILE_SIZE > MAX_TILE_SIZE
-          auto tilePtr = make_unique<Tile>(tileId, fb->size, accumID);
+          auto tilePtr = TilePool::acquire(tileId, fb->size, accumID,
+                                           fb->getTileChannels());
           auto &tile   = *tilePtr;
 #else
-          Tile __aligned(64) tile(tileId, fb->size, accumID);
+          Tile __aligned(64) tile(tileId, fb->size, accumID,
+                                  fb->getTileChannels());
 #endif
 
+          tile.shadingRate = renderer->tileShadingRate(fb, tileId);
+
           if (dfb->continueRendering()) {
-            tasking::parallel_for(numJobs(renderer->spp, accumID),
+            tracing::Scope trace("render tile", regionTileID);
+            tasking::parallel_for(numJobs(renderer->spp, accumID,
+                                          tile.shadingRate),
                                   [&](size_t tid) {
               renderer->renderTile(perFrameData, tile, tid);
             });
           }
 
           fb->setTile(tile);
+
+          const vec2i samples = divRoundUp(tile.region.size(),
+                                           vec2i(1 << tile.shadingRate));
+          fb->recordTile(getSysTime() - tileStart,
+                         int64_t(samples.x) * samples.y * renderer->spp);
         });
         auto endRender = high_resolution_clock::now();
 
@@ -193,8 +253,14 @@ namespace ospray {
         }
         ++frameNumber;
 
-        return dfb->endFrame(inf); // irrelevant return value on slave, still
-                                   // call to stop maml layer
+        const double endFrameStart = getSysTime();
+        const float error = dfb->endFrame(inf); // irrelevant return value on
+                                                // slave, still call to stop
+                                                // maml layer
+        const double frameEnd = getSysTime();
+        dfb->recordFrameTime(frameEnd - frameStart, frameEnd - endFrameStart);
+
+        return error;
       }
 
       std::string Slave::toString() const
@@ -232,33 +298,57 @@ namespace ospray {
       {
         preferredTiles.resize(worker.size);
         workerNotified.resize(worker.size);
-
-        // TODO numPreAllocated should be estimated/tuned automatically
+        tilesAssigned.resize(worker.size);
+        // until measured, assume all workers are equally fast
+        workerShare.resize(worker.size, 1.f / worker.size);
       }
 
       void Master::incoming(const std::shared_ptr<mpicommon::Message> &msg)
       {
         const int requester = *(int*)msg->data;
-        scheduleTile(workerRankFromGlobalRank(requester));
+        scheduleTiles(workerRankFromGlobalRank(requester));
+      }
+
+      int Master::batchSize(const int worker) const
+      {
+        // half of the worker's share of the remaining tiles: large batches
+        // (few messages) at the start of the frame, down to single tiles
+        // towards its end, to balance the finishing times
+        return std::max(1, int(0.5f * tilesRemaining * workerShare[worker]));
       }
 
-      void Master::scheduleTile(const int worker)
+      void Master::scheduleTiles(const int worker, const int minTiles)
       {
         if (workerNotified[worker])
           return;
 
-        // choose tile from preferred queue
-        auto queue = preferredTiles.begin() + worker;
+        const int numTiles = std::max(minTiles, batchSize(worker));
+        std::vector<TileTask> batch;
+        batch.reserve(numTiles);
+        while (batch.size() < size_t(numTiles)) {
+          // choose tile from preferred queue
+          auto queue = preferredTiles.begin() + worker;
 
-        // else look for largest non-empty queue
-        if (queue->empty())
-          queue = std::max_element(preferredTiles.begin(), preferredTiles.end(),
-              [](TileVector a, TileVector b) { return a.size() < b.size(); });
+          // else steal from the largest non-empty queue
+          if (queue->empty())
+            queue = std::max_element(preferredTiles.begin(), preferredTiles.end(),
+                [](const TileVector &a, const TileVector &b) {
+                  return a.size() < b.size(); });
 
-        TileTask task;
-        if (queue->empty()) {
+          if (queue->empty())
+            break;
+
+          TileTask task = queue->back();
+          queue->pop_back();
+          task.tilesExhausted = false;
+          batch.push_back(task);
+        }
+
+        if (batch.empty()) {
           workerNotified[worker] = true;
+          TileTask task;
           task.tilesExhausted = true;
+          batch.push_back(task);
           // If we told all the workers that we're out of tiles, then we're
           // done with this frame.
           const auto notNotified = std::find(workerNotified.begin(),
@@ -267,15 +357,30 @@ namespace ospray {
             dfb->closeCurrentFrame();
           }
         } else {
-          task = queue->back();
-          queue->pop_back();
-          task.tilesExhausted = false;
+          tilesRemaining -= batch.size();
+          tilesAssigned[worker] += batch.size();
         }
 
-        auto answer = std::make_shared<mpicommon::Message>(&task, sizeof(task));
+        auto answer = std::make_shared<mpicommon::Message>(batch.data(),
+            batch.size() * sizeof(TileTask));
         mpi::messaging::sendTo(globalRankFromWorkerRank(worker), myId, answer);
       }
 
+      void Master::updateWorkerShares()
+      {
+        const int total = std::accumulate(tilesAssigned.begin(),
+                                          tilesAssigned.end(), 0);
+        if (total == 0)
+          return;
+
+        // the tiles a worker took within the (dynamically balanced) frame
+        // are proportional to its throughput, smoothed over frames
+        for (size_t i = 0; i < workerShare.size(); ++i) {
+          workerShare[i] = 0.5f * workerShare[i]
+            + 0.5f * tilesAssigned[i] / float(total);
+        }
+      }
+
       void Master::generateTileTasks(DistributedFrameBuffer * const dfb
           , const float errorThreshold
           )
@@ -289,6 +394,9 @@ namespace ospray {
         for (int y = 0, tileNr = 0; y < dfb->numTiles.y; y++) {
           for (int x = 0; x < dfb->numTiles.x; x++, tileNr++) {
             const auto tileId = vec2i(x, y);
+            if (!dfb->tileInRenderRegion(tileId))
+              continue;
+
             const auto tileError = dfb->tileError(tileId);
             if (tileError <= errorThreshold)
               continue;
@@ -314,7 +422,8 @@ namespace ospray {
         // TODO: estimate variance reduction to avoid duplicating tiles that are
         // just slightly above errorThreshold too often
         auto it = activeTiles.begin();
-        const size_t tilesTotal = dfb->getTotalTiles();
+        const vec2i regionTiles = dfb->getRenderRegion().size();
+        const size_t tilesTotal = regionTiles.x * regionTiles.y;
         // loop over (active) tiles multiple times (instead of e.g. computing
         // instance count) to have maximum distance between duplicated tiles in
         // queue ==> higher chance that duplicated tiles do not arrive at the
@@ -340,21 +449,34 @@ namespace ospray {
         dfb = dynamic_cast<DistributedFrameBuffer*>(fb);
         assert(dfb);
 
-        for (size_t i = 0; i < workerNotified.size(); ++i)
+        for (size_t i = 0; i < workerNotified.size(); ++i) {
           workerNotified[i] = false;
+          tilesAssigned[i] = 0;
+        }
+
+        const double frameStart = getSysTime();
 
         generateTileTasks(dfb, renderer->errorThreshold);
+        tilesRemaining = 0;
+        for (const auto &queue : preferredTiles)
+          tilesRemaining += queue.size();
 
         dfb->startNewFrame(renderer->errorThreshold);
         dfb->beginFrame();
+        recordSkippedTiles(dfb, renderer->errorThreshold);
 
-        for(int tiles = 0; tiles < numPreAllocated; tiles++)
-          for(int workerID = 0; workerID < worker.size; workerID++)
-            scheduleTile(workerID);
+        for(int workerID = 0; workerID < worker.size; workerID++)
+          scheduleTiles(workerID, numPreAllocated);
 
         dfb->waitUntilFinished();
+        updateWorkerShares();
 
-        return dfb->endFrame(renderer->errorThreshold);
+        const double endFrameStart = getSysTime();
+        const float error = dfb->endFrame(renderer->errorThreshold);
+        const double frameEnd = getSysTime();
+        dfb->recordFrameTime(frameEnd - frameStart, frameEnd - endFrameStart);
+
+        return error;
       }
 
       std::string Master::toString() const
@@ -370,19 +492,27 @@ namespace ospray {
 
       void Slave::incoming(const std::shared_ptr<mpicommon::Message> &msg)
       {
-        auto task = *(TileTask*)msg->data;
+        const auto *tasks = (const TileTask*)msg->data;
+        const int numTasks = msg->size / sizeof(TileTask);
 
         mutex.lock();
-        if (task.tilesExhausted)
+        requestPending = false;
+        if (tasks[0].tilesExhausted) {
           tilesAvailable = false;
-        else
-          tilesScheduled++;
+        } else {
+          tilesScheduled += numTasks;
+          requestThreshold = numTasks / 2;
+        }
         mutex.unlock();
 
-        if (tilesAvailable)
-          tasking::schedule([&,task]{tileTask(task);});
-        else
+        if (tilesAvailable) {
+          for (int i = 0; i < numTasks; ++i) {
+            const TileTask task = tasks[i];
+            tasking::schedule([&,task]{tileTask(task);});
+          }
+        } else {
           cv.notify_one();
+        }
       }
 
       float Slave::renderFrame(Renderer *_renderer
@@ -396,7 +526,10 @@ namespace ospray {
 
         tilesAvailable = true;
         tilesScheduled = 0;
+        requestThreshold = 0;
+        requestPending = false;
 
+        const double frameStart = getSysTime();
         dfb->startNewFrame(renderer->errorThreshold);
         // dfb->beginFrame(); is called by renderer->beginFrame:
         perFrameData = renderer->beginFrame(fb);
@@ -411,35 +544,62 @@ namespace ospray {
 
         renderer->endFrame(perFrameData,channelFlags);
 
-        return dfb->endFrame(inf); // irrelevant return value on slave, still
-                                   // call to stop maml layer
+        const double endFrameStart = getSysTime();
+        const float error = dfb->endFrame(inf); // irrelevant return value on
+                                                // slave, still call to stop
+                                                // maml layer
+        const double frameEnd = getSysTime();
+        dfb->recordFrameTime(frameEnd - frameStart, frameEnd - endFrameStart);
+
+        return error;
       }
 
 
       void Slave::tileTask(const TileTask &task)
       {
 #if TILE_SIZE > MAX_TILE_SIZE
-        auto tilePtr = make_unique<Tile>(task.tileId, fb->size, task.accumId);
+        auto tilePtr = TilePool::acquire(task.tileId, fb->size, task.accumId,
+                                         fb->getTileChannels());
         auto &tile   = *tilePtr;
 #else
-        Tile __aligned(64) tile(task.tileId, fb->size, task.accumId);
+        Tile __aligned(64) tile(task.tileId, fb->size, task.accumId,
+                                fb->getTileChannels());
 #endif
 
         while (!frameActive);// PRINT(frameActive); // XXX busy wait for valid perFrameData
 
+        const double tileStart = getSysTime();
+        tile.shadingRate = renderer->tileShadingRate(fb, task.tileId);
+
         auto *dfb = dynamic_cast<DistributedFrameBuffer*>(fb);
         if (dfb->continueRendering()) {
-          tasking::parallel_for(numJobs(renderer->spp, task.accumId),
+          tracing::Scope trace("render tile", task.tileId.y
+                               * fb->getNumTiles().x + task.tileId.x);
+          tasking::parallel_for(numJobs(renderer->spp, task.accumId,
+                                        tile.shadingRate),
                                 [&](size_t tid) {
             renderer->renderTile(perFrameData, tile, tid);
           });
         }
 
-        if (tilesAvailable)
+        // ask for the next batch while the rest of this one is rendered
+        bool request = false;
+        {
+          SCOPED_LOCK(mutex);
+          if (tilesAvailable && !requestPending
+              && tilesScheduled - 1 <= requestThreshold) {
+            requestPending = request = true;
+          }
+        }
+        if (request)
           requestTile(); // XXX here or after setTile?
 
         fb->setTile(tile);
 
+        const vec2i samples = divRoundUp(tile.region.size(),
+                                         vec2i(1 << tile.shadingRate));
+        fb->recordTile(getSysTime() - tileStart,
+                       int64_t(samples.x) * samples.y * renderer->spp);
 
         SCOPED_LOCK(mutex);
         if (--tilesScheduled == 0)
@@ -78,6 +78,10 @@ namespace ospray {
           same tiles as the DistributedFramebuffer (i.e. round-robin pattern,
           each client 'i' renderss tiles with 'tileID%numWorkers==i') to avoid
           transferring a computed tile for accumulation
+
+          Tiles are handed out in batches, whose size follows the tiles still
+          to render (guided self-scheduling) and the throughput each worker
+          had in the previous frames
       */
 
       struct TileTask {
@@ -99,14 +103,21 @@ namespace ospray {
         std::string toString() const override;
 
       private:
-        void scheduleTile(const int worker);
+        void scheduleTiles(const int worker, const int minTiles = 1);
         void generateTileTasks(DistributedFrameBuffer * const dfb
             , const float errorThreshold
             );
+        //! number of tiles to send to 'worker' with its next batch
+        int batchSize(const int worker) const;
+        //! update the throughput estimate with the tiles of the last frame
+        void updateWorkerShares();
 
         typedef std::vector<TileTask> TileVector;
         std::vector<TileVector> preferredTiles; // per worker default queue
         std::vector<bool> workerNotified; // worker knows we're done?
+        std::vector<float> workerShare; // fraction of the tiles rendered
+        std::vector<int> tilesAssigned; // this frame, per worker
+        size_t tilesRemaining{0}; // in all queues
         int numPreAllocated{4};
         DistributedFrameBuffer *dfb{nullptr};
       };
@@ -138,6 +149,9 @@ namespace ospray {
         std::mutex mutex;
         std::condition_variable cv;
         int tilesScheduled;
+        // request the next batch once this many tiles are left to render
+        int requestThreshold;
+        bool requestPending;
         bool tilesAvailable;
         bool frameActive;
       };
@@ -14,7 +14,9 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <limits>
 #include <map>
 #include <utility>
@@ -30,6 +32,7 @@
 #include "../MPILoadBalancer.h"
 #include "../../fb/DistributedFrameBuffer.h"
 #include "../../common/Profiling.h"
+#include "mpiCommon/Tracing.h"
 #include "lights/Light.h"
 #include "lights/AmbientLight.h"
 // ispc exports
@@ -48,9 +51,14 @@ namespace ospray {
       int currentRegion;
       bool computeVisibility;
       bool *regionVisible;
+      // the regions whose projection overlaps the tile, only these are
+      // tested for visibility
+      const int *candidateRegions;
+      int numCandidateRegions;
 
       RegionInfo()
-        : currentRegion(0), computeVisibility(true), regionVisible(nullptr)
+        : currentRegion(0), computeVisibility(true), regionVisible(nullptr),
+          candidateRegions(nullptr), numCandidateRegions(0)
       {}
     };
 
@@ -83,6 +91,56 @@ namespace ospray {
     // or off-screen, the region will be empty.
     RegionScreenBounds projectRegion(const box3f &bounds, const Camera *camera);
 
+    //! the tiles [minTile, maxTile) the projected region bounds touch
+    static void projectedTileRange(const box2f &bounds, const vec2i &numTiles,
+                                   vec2i &minTile, vec2i &maxTile)
+    {
+      minTile = vec2i(bounds.lower.x / TILE_SIZE, bounds.lower.y / TILE_SIZE);
+      maxTile = vec2i(std::min(std::ceil(bounds.upper.x / TILE_SIZE), float(numTiles.x)),
+                      std::min(std::ceil(bounds.upper.y / TILE_SIZE), float(numTiles.y)));
+    }
+
+    /*! assign each tile to a rank which renders the region covering most of
+        it, such that this part does not need to be sent for compositing.
+        Tiles not covered by any region are assigned round-robin. */
+    static std::vector<size_t> localityTileOwners(
+        const std::vector<DistributedRegion> &allRegions,
+        const std::vector<RegionScreenBounds> &projectedRegions,
+        const std::function<size_t(int, size_t)> &regionTileRank,
+        const vec2i &numTiles)
+    {
+      const size_t totalTiles = size_t(numTiles.x) * numTiles.y;
+      std::vector<size_t> owners(totalTiles);
+      std::vector<float> coverage(totalTiles, 0.f);
+      for (size_t i = 0; i < totalTiles; ++i)
+        owners[i] = i % mpicommon::numGlobalRanks();
+
+      for (size_t i = 0; i < allRegions.size(); ++i) {
+        const box2f &bounds = projectedRegions[i].bounds;
+        if (bounds.empty() || projectedRegions[i].depth < 0)
+          continue;
+
+        vec2i minTile, maxTile;
+        projectedTileRange(bounds, numTiles, minTile, maxTile);
+        for (int y = minTile.y; y < maxTile.y; ++y) {
+          for (int x = minTile.x; x < maxTile.x; ++x) {
+            const box2f tile(vec2f(x * TILE_SIZE, y * TILE_SIZE),
+                             vec2f((x + 1) * TILE_SIZE, (y + 1) * TILE_SIZE));
+            const vec2f overlap = max(vec2f(0.f), min(tile.upper, bounds.upper)
+                                      - max(tile.lower, bounds.lower));
+            const float area = overlap.x * overlap.y;
+            const size_t tileIndex = size_t(x) + size_t(y) * numTiles.x;
+            if (area > coverage[tileIndex]) {
+              coverage[tileIndex] = area;
+              owners[tileIndex] = regionTileRank(allRegions[i].id, tileIndex);
+            }
+          }
+        }
+      }
+
+      return owners;
+    }
+
     DistributedRegion::DistributedRegion() : id(-1) {}
     DistributedRegion::DistributedRegion(box3f bounds, int id)
       : bounds(bounds), id(id)
@@ -132,6 +190,19 @@ namespace ospray {
       ghostRegionIEs.clear();
 
       numAoSamples = getParam1i("aoSamples", 0);
+      const std::string ownership = getParamString("tileOwnership", "roundRobin");
+      if (ownership != "roundRobin" && ownership != "locality") {
+        static WarnOnce warning("unknown tileOwnership of the mpi_raycast "
+                                "renderer, using roundRobin");
+      }
+      localityOwnership = ownership == "locality";
+      const std::string replicas = getParamString("replicaAssignment",
+                                                  "roundRobin");
+      if (replicas != "roundRobin" && replicas != "balanced") {
+        static WarnOnce warning("unknown replicaAssignment of the mpi_raycast "
+                                "renderer, using roundRobin");
+      }
+      balanceReplicas = replicas == "balanced";
       oneSidedLighting = getParam1i("oneSidedLighting", 1);
       shadowsEnabled = getParam1i("shadowsEnabled", 0);
 
@@ -220,10 +291,6 @@ namespace ospray {
       ProfilingPoint startRender;
 
       auto *dfb = dynamic_cast<DistributedFrameBuffer *>(fb);
-      dfb->setFrameMode(DistributedFrameBuffer::ALPHA_BLEND);
-      dfb->startNewFrame(errorThreshold);
-
-      beginFrame(dfb);
 
       const size_t numRegions = allRegions.size();
       // Do a prepass and project each region's box to the screen to see
@@ -259,6 +326,24 @@ namespace ospray {
       for (const auto &e : regionOrdering) {
         sortOrder[e.second] = depthIndex++;
       }
+
+      assignReplicaTiles(projectedRegions, dfb->getNumTiles());
+
+      // Every rank computes the same owners from the global regions, the
+      // tiles are only re-assigned when they change (i.e. with the camera)
+      if (localityOwnership) {
+        using namespace std::placeholders;
+        dfb->setTileOwners(localityTileOwners(allRegions, projectedRegions,
+            std::bind(&DistributedRaycastRenderer::regionTileRank, this, _1, _2),
+            dfb->getNumTiles()));
+      } else {
+        dfb->setTileOwners({});
+      }
+
+      dfb->setFrameMode(DistributedFrameBuffer::ALPHA_BLEND);
+      dfb->startNewFrame(errorThreshold);
+
+      beginFrame(dfb);
 #if 0
       if (mpicommon::globalRank() == 0) {
         std::cout << "sortorder: {";
@@ -287,11 +372,9 @@ namespace ospray {
         }
         // TODO: Should we push back by a few pixels as well just in case
         // for the random sampling? May need to spill +/- a pixel? I'm not sure
-        const vec2i minTile(projection.bounds.lower.x / TILE_SIZE,
-                            projection.bounds.lower.y / TILE_SIZE);
         const vec2i numTiles = fb->getNumTiles();
-        const vec2i maxTile(std::min(std::ceil(projection.bounds.upper.x / TILE_SIZE), float(numTiles.x)),
-                            std::min(std::ceil(projection.bounds.upper.y / TILE_SIZE), float(numTiles.y)));
+        vec2i minTile, maxTile;
+        projectedTileRange(projection.bounds, numTiles, minTile, maxTile);
 
         tilesForFrame.reserve((maxTile.x - minTile.x) * (maxTile.y - minTile.y));
         for (int y = minTile.y; y < maxTile.y; ++y) {
@@ -299,14 +382,7 @@ namespace ospray {
             // If we share ownership of this region but aren't responsible
             // for rendering it to this tile, don't render it.
             const size_t tileIndex = size_t(x) + size_t(y) * numTiles.x;
-            const auto &owners = regionOwners[region->id];
-            const size_t numRegionOwners = owners.size();
-            const size_t ownerRank = std::distance(owners.begin(),
-                                                   owners.find(globalRank()));
-            // TODO: Can we do a better than round-robin over all tiles assignment here?
-            // It could be that we end up not evenly dividing the workload.
-            const bool regionTileOwner = (tileIndex % numRegionOwners) == ownerRank;
-            if (regionTileOwner) {
+            if (regionTileRank(region->id, tileIndex) == size_t(globalRank())) {
               tilesForFrame.push_back(tileIndex);
             }
           }
@@ -315,8 +391,9 @@ namespace ospray {
 
       // Be sure to include all the tiles that we're the owner for as well,
       // in some cases none of our data might project to them.
-      for (int i = globalRank(); i < dfb->getTotalTiles(); i += numGlobalRanks()) {
-        tilesForFrame.push_back(i);
+      for (int i = 0; i < dfb->getTotalTiles(); ++i) {
+        if (dfb->ownerIDFromTileID(i) == size_t(globalRank()))
+          tilesForFrame.push_back(i);
       }
 
       std::sort(tilesForFrame.begin(), tilesForFrame.end());
@@ -338,12 +415,14 @@ namespace ospray {
                                const uint32_t tile_y = i / numTiles_x;
                                const uint32_t tile_x = i - tile_y*numTiles_x;
                                const vec2i tileID(tile_x, tile_y);
-                               return dfb->tileError(tileID) > errorThreshold;
+                               return dfb->tileInRenderRegion(tileID)
+                                 && dfb->tileError(tileID) > errorThreshold;
                              });
         tilesForFrame.erase(end, tilesForFrame.end());
 #endif
       }
 
+      std::atomic<size_t> renderedRegionTiles(0);
       tasking::parallel_for(tilesForFrame.size(), [&](size_t taskIndex) {
         const int tileIndex = tilesForFrame[taskIndex];
 
@@ -352,11 +431,13 @@ namespace ospray {
         const uint32_t tile_x = tileIndex - tile_y*numTiles_x;
         const vec2i tileID(tile_x, tile_y);
         const int32 accumID = fb->accumID(tileID);
-        const bool tileOwner = (tileIndex % numGlobalRanks()) == globalRank();
+        const bool tileOwner = dfb->ownerIDFromTileID(tileIndex)
+          == size_t(globalRank());
         const int NUM_JOBS = (TILE_SIZE * TILE_SIZE) / RENDERTILE_PIXELS_PER_JOB;
 
 #if !PARTITION_OUT_FINISHED_TILES
-        if (dfb->tileError(tileID) <= errorThreshold) {
+        if (!dfb->tileInRenderRegion(tileID)
+            || dfb->tileError(tileID) <= errorThreshold) {
           return;
         }
 #endif
@@ -369,11 +450,29 @@ namespace ospray {
         regionInfo.regionVisible = STACK_BUFFER(bool, numRegions);
         std::fill(regionInfo.regionVisible, regionInfo.regionVisible + numRegions, false);
 
+        // Cull the regions by their screen-space footprint, such that the
+        // rays only test the (few) regions which could touch this tile
+        int *candidateRegions = STACK_BUFFER(int, numRegions);
+        const vec2f tileLower(tile_x * TILE_SIZE, tile_y * TILE_SIZE);
+        const vec2f tileUpper = tileLower + vec2f(TILE_SIZE);
+        for (size_t i = 0; i < numRegions; ++i) {
+          const box2f &footprint = projectedRegions[i].bounds;
+          if (!footprint.empty()
+              && footprint.lower.x < tileUpper.x && footprint.upper.x > tileLower.x
+              && footprint.lower.y < tileUpper.y && footprint.upper.y > tileLower.y) {
+            candidateRegions[regionInfo.numCandidateRegions++] = i;
+          }
+        }
+        regionInfo.candidateRegions = candidateRegions;
+
         // The first renderTile doesn't actually do any rendering, and instead
         // just computes which tiles the region projects to.
-        tasking::parallel_for(static_cast<size_t>(NUM_JOBS), [&](size_t tIdx) {
-          renderTile(&regionInfo, bgtile, tIdx);
-        });
+        if (regionInfo.numCandidateRegions > 0) {
+          tracing::Scope trace("region visibility", tileIndex);
+          tasking::parallel_for(static_cast<size_t>(NUM_JOBS), [&](size_t tIdx) {
+            renderTile(&regionInfo, bgtile, tIdx);
+          });
+        }
         regionInfo.computeVisibility = false;
 
         // If we own the tile send the background color and the count of children for the
@@ -424,19 +523,18 @@ namespace ospray {
           // multiple shared regions projecting to the same tile, and we
           // could be the region tile owner for only some of those
           const auto &region = regions[i];
-          const auto &owners = regionOwners[region->id];
-          const size_t numRegionOwners = owners.size();
-          const size_t ownerRank = std::distance(owners.begin(),
-                                                 owners.find(globalRank()));
-          const bool regionTileOwner = (tileIndex % numRegionOwners) == ownerRank;
-          if (regionTileOwner) {
+          if (regionTileRank(region->id, tileIndex) == size_t(globalRank())) {
+            renderedRegionTiles++;
             RegionInfo localInfo;
             localInfo.regionVisible = regionInfo.regionVisible;
             localInfo.computeVisibility = false;
             localInfo.currentRegion = i;
-            tasking::parallel_for(NUM_JOBS, [&](int tIdx) {
-              renderTile(&localInfo, tile, tIdx);
-            });
+            {
+              tracing::Scope trace("render region tile", region->id);
+              tasking::parallel_for(NUM_JOBS, [&](int tIdx) {
+                renderTile(&localInfo, tile, tIdx);
+              });
+            }
             tile.sortOrder = sortOrder[region->id];
             fb->setTile(tile);
           }
@@ -452,6 +550,10 @@ namespace ospray {
       dfb->waitUntilFinished();
       endFrame(nullptr, channelFlags);
 
+      exchangeTileCosts(duration_cast<duration<double, std::milli>>(
+                          endRender - startRender.time).count(),
+                        renderedRegionTiles);
+
       ProfilingPoint endComposite;
 
       if (DETAILED_LOGGING && frameNumber > 5) {
@@ -516,7 +618,8 @@ namespace ospray {
         const vec2i tileID(tile_x, tile_y);
         const int32 accumID = fb->accumID(tileID);
 
-        if (fb->tileError(tileID) <= errorThreshold) {
+        if (!fb->tileInRenderRegion(tileID)
+            || fb->tileError(tileID) <= errorThreshold) {
           return;
         }
 
@@ -524,9 +627,12 @@ namespace ospray {
 
         // We use the task of rendering the first region to also fill out the block visiblility list
         const int NUM_JOBS = (TILE_SIZE * TILE_SIZE) / RENDERTILE_PIXELS_PER_JOB;
-        tasking::parallel_for(NUM_JOBS, [&](int tIdx) {
-          renderTile(NULL, tile, tIdx);
-        });
+        {
+          tracing::Scope trace("render tile", taskIndex);
+          tasking::parallel_for(NUM_JOBS, [&](int tIdx) {
+            renderTile(NULL, tile, tIdx);
+          });
+        }
 
         fb->setTile(tile);
       });
@@ -637,6 +743,95 @@ namespace ospray {
 #endif
     }
 
+    void DistributedRaycastRenderer::assignReplicaTiles(
+        const std::vector<RegionScreenBounds> &projectedRegions,
+        const vec2i &numTiles)
+    {
+      const size_t totalTiles = size_t(numTiles.x) * numTiles.y;
+      const size_t numRanks = mpicommon::numGlobalRanks();
+      if (tileCosts.size() != numRanks)
+        tileCosts.assign(numRanks, 1.0);
+
+      // The predicted render time of each rank, starting from the regions
+      // only it owns, then the tiles of the replicated regions are given
+      // one by one to the replica finishing them first
+      std::vector<double> predicted(numRanks, 0.0);
+      std::vector<size_t> replicated;
+      for (size_t i = 0; i < allRegions.size(); ++i) {
+        const auto &owners = regionOwners.at(allRegions[i].id);
+        if (owners.size() > 1) {
+          replicated.push_back(i);
+          continue;
+        }
+
+        const box2f &bounds = projectedRegions[i].bounds;
+        if (!balanceReplicas || bounds.empty() || projectedRegions[i].depth < 0)
+          continue;
+
+        vec2i minTile, maxTile;
+        projectedTileRange(bounds, numTiles, minTile, maxTile);
+        const size_t rank = *owners.begin();
+        predicted[rank] += tileCosts[rank] * std::max(0, maxTile.x - minTile.x)
+                           * std::max(0, maxTile.y - minTile.y);
+      }
+
+      replicaTileRanks.clear();
+      for (const size_t i : replicated) {
+        const auto &owners = regionOwners.at(allRegions[i].id);
+        const std::vector<size_t> ranks(owners.begin(), owners.end());
+        auto &tileRanks = replicaTileRanks[allRegions[i].id];
+        tileRanks.resize(totalTiles);
+        for (size_t t = 0; t < totalTiles; ++t)
+          tileRanks[t] = ranks[t % ranks.size()];
+
+        const box2f &bounds = projectedRegions[i].bounds;
+        if (!balanceReplicas || bounds.empty() || projectedRegions[i].depth < 0)
+          continue;
+
+        vec2i minTile, maxTile;
+        projectedTileRange(bounds, numTiles, minTile, maxTile);
+        for (int y = minTile.y; y < maxTile.y; ++y) {
+          for (int x = minTile.x; x < maxTile.x; ++x) {
+            size_t best = ranks.front();
+            for (const size_t r : ranks) {
+              if (predicted[r] + tileCosts[r] < predicted[best] + tileCosts[best])
+                best = r;
+            }
+            tileRanks[size_t(x) + size_t(y) * numTiles.x] = best;
+            predicted[best] += tileCosts[best];
+          }
+        }
+      }
+    }
+
+    size_t DistributedRaycastRenderer::regionTileRank(int regionID,
+                                                      size_t tileIndex) const
+    {
+      const auto &owners = regionOwners.at(regionID);
+      if (owners.size() == 1)
+        return *owners.begin();
+      return replicaTileRanks.at(regionID)[tileIndex];
+    }
+
+    void DistributedRaycastRenderer::exchangeTileCosts(double renderTime,
+                                                       size_t renderedTiles)
+    {
+      if (!balanceReplicas || replicaTileRanks.empty())
+        return;
+
+      // A rank which rendered no tiles keeps its previous cost
+      const double cost = renderedTiles > 0 ? renderTime / renderedTiles : -1.0;
+      std::vector<double> costs(tileCosts.size(), -1.0);
+      MPI_CALL(Allgather(&cost, 1, MPI_DOUBLE, costs.data(), 1, MPI_DOUBLE,
+                         mpicommon::world.comm));
+
+      // Smooth the costs, to not swap the tiles back and forth every frame
+      for (size_t r = 0; r < tileCosts.size(); ++r) {
+        if (costs[r] > 0.0)
+          tileCosts[r] = 0.5 * (tileCosts[r] + costs[r]);
+      }
+    }
+
     RegionScreenBounds projectRegion(const box3f &bounds, const Camera *camera)
     {
       RegionScreenBounds screen;
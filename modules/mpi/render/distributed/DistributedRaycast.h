@@ -40,6 +40,8 @@ namespace ospray {
       bool operator<(const ospray::mpi::DistributedRegion &b) const;
     };
 
+    struct RegionScreenBounds;
+
     /* The distributed raycast renderer supports rendering distributed
      * geometry and volume data, assuming that the data distribution is suitable
      * for sort-last compositing. Specifically, the data must be organized
@@ -48,6 +50,11 @@ namespace ospray {
      * from the MPIDistributedDevice to determine the number of tiles to
      * render and expect for compositing.
      *
+     * A region can be replicated on several ranks by giving their models the
+     * same id, the tiles it projects to are then split among these ranks,
+     * either round-robin or balanced by the render times of the ranks in the
+     * previous frame (hybrid sort-first/sort-last rendering).
+     *
      * Also see apps/ospRandSciVisTest.cpp and apps/ospRandSphereTest.cpp for
      * example usage.
      */
@@ -72,7 +79,24 @@ namespace ospray {
       // "full picture" of what geometries live on what nodes
       void exchangeModelBounds();
 
+      /*! assign the tiles of the replicated regions to their owners, all
+          ranks compute the same assignment */
+      void assignReplicaTiles(
+          const std::vector<RegionScreenBounds> &projectedRegions,
+          const vec2i &numTiles);
+
+      //! the rank rendering the region to the tile
+      size_t regionTileRank(int regionID, size_t tileIndex) const;
+
+      /*! share the render time per tile of this frame (collective), as cost
+          for the next assignment */
+      void exchangeTileCosts(double renderTime, size_t renderedTiles);
+
       int numAoSamples;
+      // assign the tiles to the ranks rendering most of them
+      bool localityOwnership {false};
+      // balance the replicated regions by render time, else round-robin
+      bool balanceReplicas {false};
       bool oneSidedLighting;
       bool shadowsEnabled;
       PerspectiveCamera *camera;
@@ -89,6 +113,10 @@ namespace ospray {
       std::vector<DistributedRegion> allRegions;
       // The ranks which own each region
       std::unordered_map<int, std::set<size_t>> regionOwners;
+      // For the replicated regions, the rank rendering each tile
+      std::unordered_map<int, std::vector<size_t>> replicaTileRanks;
+      // The smoothed render time per tile of each rank (ms)
+      std::vector<double> tileCosts;
     };
 
   } // ::ospray::mpi
@@ -29,6 +29,9 @@
 #  include <process.h> // for getpid
 #endif
 
+// std
+#include <atomic>
+
 using ospray::api::Device;
 using ospray::api::deviceIsSet;
 using ospray::api::currentDevice;
@@ -92,6 +95,10 @@ static inline Device *createMpiDevice(const std::string &type)
   return device;
 }
 
+//! start of ospInit, for the time to the first frame
+static double initStartTime = 0.0;
+static std::atomic<bool> firstFrameRendered {false};
+
 static inline void loadModulesFromEnvironmentVar()
 {
   auto OSPRAY_LOAD_MODULES =
@@ -113,7 +120,10 @@ OSPRAY_CATCH_BEGIN
     throw std::runtime_error("device already exists [ospInit() called twice?]");
   }
 
+  initStartTime = getSysTime();
   loadModulesFromEnvironmentVar();
+  recordInitPhase("modules from OSPRAY_LOAD_MODULES",
+                  getSysTime() - initStartTime);
 
   auto OSP_MPI_LAUNCH = utility::getEnvVar<std::string>("OSPRAY_MPI_LAUNCH");
 
@@ -127,6 +137,7 @@ OSPRAY_CATCH_BEGIN
                                          OSP_MPI_LAUNCH.value());
   }
 
+  const double cmdLineStart = getSysTime();
   if (_ac && _av) {
     for (int i = 1; i < *_ac; i++) {
       std::string av(_av[i]);
@@ -217,6 +228,31 @@ OSPRAY_CATCH_BEGIN
         continue;
       }
 
+      const char *serveArgName = "--osp:mpi-serve";
+      if (!strncmp(_av[i], serveArgName, strlen(serveArgName))) {
+        int port = 3141;
+        if (strlen(_av[i]) > strlen(serveArgName))
+          port = atoi(_av[i]+strlen(serveArgName)+1);
+        removeArgs(*_ac,_av,i,1);
+
+        currentDevice.reset(createMpiDevice("mpi_offload"));
+        currentDevice->setParam<std::string>("mpiMode", "mpi-serve");
+        currentDevice->setParam<int>("servicePort", port);
+        --i;
+        continue;
+      }
+
+      if (av == "--osp:mpi-attach") {
+        if (i+2 > *_ac)
+          throw std::runtime_error("--osp:mpi-attach expects an argument");
+        currentDevice.reset(createMpiDevice("mpi_offload"));
+        currentDevice->setParam<std::string>("mpiMode", "mpi-attach");
+        currentDevice->setParam<std::string>("serviceHost", _av[i+1]);
+        removeArgs(*_ac,_av,i,2);
+        --i;
+        continue;
+      }
+
       const char *connectArgName = "--osp:mpi-connect";
       if (!strncmp(_av[i], connectArgName, strlen(connectArgName))) {
         std::string portName = _av[i+1];
@@ -233,6 +269,9 @@ OSPRAY_CATCH_BEGIN
     }
   }
 
+  recordInitPhase("modules and devices of the command line",
+                  getSysTime() - cmdLineStart);
+
   // no device created on cmd line, yet, so default to ISPCDevice
   if (!deviceIsSet()) {
     auto OSPRAY_DEFAULT_DEVICE =
@@ -242,14 +281,18 @@ OSPRAY_CATCH_BEGIN
       auto device_name = OSPRAY_DEFAULT_DEVICE.value();
       currentDevice.reset(Device::createDevice(device_name.c_str()));
     } else {
+      const double moduleStart = getSysTime();
       ospLoadModule("ispc");
+      recordInitPhase("ispc module", getSysTime() - moduleStart);
       currentDevice.reset(Device::createDevice("default"));
     }
   }
 
   ospray::initFromCommandLine(_ac,&_av);
 
+  const double commitStart = getSysTime();
   currentDevice->commit();
+  recordInitPhase("device commit", getSysTime() - commitStart);
 
   return OSP_NO_ERROR;
 }
@@ -266,6 +309,8 @@ OSPRAY_CATCH_END()
 extern "C" OSPDevice ospNewDevice(const char *deviceType)
 OSPRAY_CATCH_BEGIN
 {
+  if (initStartTime == 0.0)
+    initStartTime = getSysTime();
   return (OSPDevice)Device::createDevice(deviceType);
 }
 OSPRAY_CATCH_END(nullptr)
@@ -409,6 +454,29 @@ OSPRAY_CATCH_BEGIN
 }
 OSPRAY_CATCH_END(nullptr)
 
+extern "C" OSPData ospNewDataStrided(size_t nitems, OSPDataType format,
+                                     const void *init, size_t byteStride,
+                                     const uint32_t flags)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  OSPData data = currentDevice().newDataStrided(nitems, format, init,
+                                                byteStride, flags);
+  return data;
+}
+OSPRAY_CATCH_END(nullptr)
+
+extern "C" void ospDataMarkModified(OSPData data,
+                                    size_t firstItem,
+                                    size_t numItems)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert(data != nullptr && "invalid data in ospDataMarkModified");
+  currentDevice().dataMarkModified(data, firstItem, numItems);
+}
+OSPRAY_CATCH_END()
+
 extern "C" void ospSetData(OSPObject object, const char *bufName, OSPData data)
 OSPRAY_CATCH_BEGIN
 {
@@ -600,9 +668,7 @@ OSPRAY_CATCH_BEGIN
 
   flags &= ~OSP_TEXTURE_SHARED_BUFFER;
 
-  const auto texelBytes  = sizeOf(type);
-  const auto totalTexels = size.x * size.y;
-  const auto totalBytes  = totalTexels * texelBytes;
+  const auto totalBytes  = sizeOf(type, (const vec2i&)size);
 
   auto data_handle = ospNewData(totalBytes,
                                 OSP_RAW,
@@ -663,10 +729,90 @@ extern "C" float ospRenderFrame(OSPFrameBuffer fb,
 OSPRAY_CATCH_BEGIN
 {
   ASSERT_DEVICE();
-  return currentDevice().renderFrame(fb, renderer, fbChannelFlags);
+  const float error = currentDevice().renderFrame(fb, renderer, fbChannelFlags);
+  currentDevice().reportFrameStats(fb);
+  if (!firstFrameRendered.exchange(true))
+    reportInitPhases(getSysTime() - initStartTime);
+  return error;
 }
 OSPRAY_CATCH_END(inf)
 
+extern "C" OSPFuture ospRenderFrameAsync(OSPFrameBuffer fb,
+                                         OSPRenderer renderer,
+                                         const uint32_t fbChannelFlags)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  return currentDevice().renderFrameAsync(fb, renderer, fbChannelFlags);
+}
+OSPRAY_CATCH_END(nullptr)
+
+extern "C" int ospIsReady(OSPFuture future)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert(future && "invalid future handle to query");
+  return currentDevice().isReady(future);
+}
+OSPRAY_CATCH_END(1)
+
+extern "C" float ospWait(OSPFuture future)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert(future && "invalid future handle to wait on");
+  return currentDevice().wait(future);
+}
+OSPRAY_CATCH_END(inf)
+
+extern "C" void ospCancel(OSPFuture future)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert(future && "invalid future handle to cancel");
+  currentDevice().cancel(future);
+}
+OSPRAY_CATCH_END()
+
+extern "C" float ospGetProgress(OSPFuture future)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert(future && "invalid future handle to query");
+  return currentDevice().getProgress(future);
+}
+OSPRAY_CATCH_END(1.f)
+
+extern "C" void ospGetFrameStats(OSPFrameBuffer fb, OSPFrameStats *stats)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert(fb && "invalid frame buffer handle to query");
+  Assert(stats && "invalid OSPFrameStats to fill");
+  *stats = currentDevice().getFrameStats(fb);
+}
+OSPRAY_CATCH_END()
+
+extern "C" void ospGetMemoryUsage(OSPObject object, OSPMemoryUsage *usage)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert(object && "invalid object handle to query");
+  Assert(usage && "invalid OSPMemoryUsage to fill");
+  *usage = currentDevice().getMemoryUsage(object);
+}
+OSPRAY_CATCH_END()
+
+extern "C" void ospGetMemoryTotals(OSPMemoryCategory category,
+                                   OSPMemoryUsage *usage)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert(usage && "invalid OSPMemoryUsage to fill");
+  *usage = currentDevice().getMemoryTotals(category);
+}
+OSPRAY_CATCH_END()
+
 extern "C" void ospCommit(OSPObject object)
 OSPRAY_CATCH_BEGIN
 {
@@ -676,6 +822,15 @@ OSPRAY_CATCH_BEGIN
 }
 OSPRAY_CATCH_END()
 
+extern "C" void ospCommitBatch(const OSPObject *objects, size_t count)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  if (!objects || count == 0) return;
+  currentDevice().commitBatch(objects, count);
+}
+OSPRAY_CATCH_END()
+
 extern "C" void ospDeviceCommit(OSPDevice _object)
 OSPRAY_CATCH_BEGIN
 {
@@ -765,6 +920,16 @@ OSPRAY_CATCH_BEGIN
 }
 OSPRAY_CATCH_END()
 
+extern "C" void ospSetFrameStatsFunc(OSPFrameStatsFunc callback, void* userPtr)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  std::lock_guard<std::mutex> lock(currentDevice().frameStatsMutex);
+  currentDevice().frameStatsCallback = callback;
+  currentDevice().frameStatsUserPtr = userPtr;
+}
+OSPRAY_CATCH_END()
+
 extern "C" void ospSetString(OSPObject _object, const char *id, const char *s)
 OSPRAY_CATCH_BEGIN
 {
@@ -1017,6 +1182,33 @@ OSPRAY_CATCH_BEGIN
 }
 OSPRAY_CATCH_END()
 
+extern "C" void ospPickBatch(OSPPickResult *results,
+                             OSPRenderer renderer,
+                             const osp::vec2f *screenPos,
+                             size_t count)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert2(renderer, "nullptr renderer passed to ospPickBatch");
+  if (!results || !screenPos || count == 0) return;
+  currentDevice().pickBatch(renderer, (const vec2f*)screenPos, count, results);
+}
+OSPRAY_CATCH_END()
+
+extern "C" void ospTraceRays(OSPModel model,
+                             const OSPTraceRay *rays,
+                             size_t count,
+                             OSPTraceHit *hits,
+                             uint32_t flags)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert2(model, "nullptr model passed to ospTraceRays");
+  if (!rays || !hits || count == 0) return;
+  currentDevice().traceRays(model, rays, count, hits, flags);
+}
+OSPRAY_CATCH_END()
+
 extern "C" void ospSampleVolume(float **results,
                                 OSPVolume volume,
                                 const osp::vec3f &worldCoordinates,
@@ -1035,3 +1227,19 @@ OSPRAY_CATCH_BEGIN
                                (const vec3f*)&worldCoordinates, count);
 }
 OSPRAY_CATCH_END()
+
+extern "C" void ospSampleVolumeBatch(OSPVolume volume,
+                                     const OSPSamplePattern *pattern,
+                                     float *values,
+                                     osp::vec3f *gradients)
+OSPRAY_CATCH_BEGIN
+{
+  ASSERT_DEVICE();
+  Assert2(volume, "nullptr volume passed to ospSampleVolumeBatch");
+  Assert2(pattern, "nullptr pattern passed to ospSampleVolumeBatch");
+  Assert2(values, "nullptr values passed to ospSampleVolumeBatch");
+
+  currentDevice().sampleVolumeBatch(volume, *pattern, values,
+                                    (vec3f*)gradients);
+}
+OSPRAY_CATCH_END()
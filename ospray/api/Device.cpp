@@ -24,7 +24,9 @@
 #include "ospcommon/sysinfo.h"
 #include "ospcommon/tasking/tasking_system_handle.h"
 
+#include <cstring>
 #include <map>
+#include <vector>
 
 namespace ospray {
   namespace api {
@@ -60,7 +62,7 @@ namespace ospray {
       if (!repo.libraryExists("ospray")) {
         repo.addDefaultLibrary();
         // also load the local device, otherwise ospNewDevice("default") fails
-        repo.add("ospray_module_ispc");
+        repo.add("ospray_module_" + ispcModuleName());
       }
 
       return objectFactory<Device, OSP_DEVICE>(type);
@@ -143,11 +145,30 @@ namespace ospray {
 
       threadAffinity = getParam<int>("setAffinity", threadAffinity);
 
-      tasking::initTaskingSystem(numThreads);
+      const double taskingStart = getSysTime();
+      tasking::initTaskingSystem(numThreads, threadAffinity == AFFINITIZE);
+      recordInitPhase("tasking system", getSysTime() - taskingStart);
 
       committed = true;
     }
 
+    OSPData Device::newDataStrided(size_t nitems, OSPDataType format,
+                                   const void *init, size_t byteStride,
+                                   int flags)
+    {
+      const size_t itemSize = sizeOf(format);
+      if (!init || byteStride == 0 || byteStride == itemSize)
+        return newData(nitems, format, init, flags);
+
+      std::vector<char> packed(nitems * itemSize);
+      for (size_t i = 0; i < nitems; i++) {
+        std::memcpy(packed.data() + i * itemSize,
+                    (const char *)init + i * byteStride, itemSize);
+      }
+      return newData(nitems, format, packed.data(),
+                     flags & ~OSP_DATA_SHARED_BUFFER);
+    }
+
     bool Device::isCommitted()
     {
       return committed;
@@ -180,6 +201,18 @@ namespace ospray {
       return cont;
     }
 
+    void Device::reportFrameStats(OSPFrameBuffer fb)
+    {
+      if (!frameStatsCallback)
+        return;
+
+      const OSPFrameStats stats = getFrameStats(fb);
+
+      // frames of several frame buffers may finish at the same time
+      std::lock_guard<std::mutex> lock(frameStatsMutex);
+      frameStatsCallback(frameStatsUserPtr, fb, &stats);
+    }
+
     std::string generateEmbreeDeviceCfg(const Device &device)
     {
       std::stringstream embreeConfig;
@@ -64,6 +64,14 @@ namespace ospray {
       /*! commit the given object's outstanding changes */
       virtual void commit(OSPObject object) = 0;
 
+      /*! commit the outstanding changes of 'count' objects, each after
+          the objects of the batch it depends on */
+      virtual void commitBatch(const OSPObject *objects, size_t count)
+      {
+        for (size_t i = 0; i < count; i++)
+          commit(objects[i]);
+      }
+
       /*! add a new geometry to a model */
       virtual void addGeometry(OSPModel _model, OSPGeometry _geometry) = 0;
 
@@ -80,6 +88,21 @@ namespace ospray {
       virtual OSPData newData(size_t nitems, OSPDataType format,
                               const void *init, int flags) = 0;
 
+      /*! create a new data buffer of items 'byteStride' bytes apart; by
+          default the items are packed into a compact copy */
+      virtual OSPData newDataStrided(size_t nitems, OSPDataType format,
+                                     const void *init, size_t byteStride,
+                                     int flags);
+
+      /*! mark items of the data buffer modified, applied with its next
+          commit; ignoring the marks (i.e., changing all items) is valid */
+      virtual void dataMarkModified(OSPData _data,
+                                    size_t firstItem,
+                                    size_t numItems)
+      {
+        UNUSED(_data, firstItem, numItems);
+      }
+
       /*! Copy data into the given volume. */
       virtual int setRegion(OSPVolume object, const void *source,
                             const vec3i &index, const vec3i &count) = 0;
@@ -174,7 +197,60 @@ namespace ospray {
                                 OSPRenderer _renderer,
                                 const uint32 fbChannelFlags) = 0;
 
+      /*! call a renderer to render a frame buffer without blocking, the
+          returned future is released via release() */
+      virtual OSPFuture renderFrameAsync(OSPFrameBuffer _fb,
+                                         OSPRenderer _renderer,
+                                         const uint32 fbChannelFlags)
+      {
+        UNUSED(_fb, _renderer, fbChannelFlags);
+        NOT_IMPLEMENTED;
+      }
+
+      virtual int isReady(OSPFuture _future)
+      {
+        UNUSED(_future);
+        NOT_IMPLEMENTED;
+      }
+
+      virtual float wait(OSPFuture _future)
+      {
+        UNUSED(_future);
+        NOT_IMPLEMENTED;
+      }
+
+      virtual void cancel(OSPFuture _future)
+      {
+        UNUSED(_future);
+        NOT_IMPLEMENTED;
+      }
+
+      virtual float getProgress(OSPFuture _future)
+      {
+        UNUSED(_future);
+        NOT_IMPLEMENTED;
+      }
+
+      /*! statistics of the last frame rendered into the frame buffer */
+      virtual OSPFrameStats getFrameStats(OSPFrameBuffer _fb)
+      {
+        UNUSED(_fb);
+        NOT_IMPLEMENTED;
+      }
 
+      /*! memory held by the object (on this rank) */
+      virtual OSPMemoryUsage getMemoryUsage(OSPObject _object)
+      {
+        UNUSED(_object);
+        NOT_IMPLEMENTED;
+      }
+
+      /*! memory held by all objects of the category (on this rank) */
+      virtual OSPMemoryUsage getMemoryTotals(OSPMemoryCategory category)
+      {
+        UNUSED(category);
+        NOT_IMPLEMENTED;
+      }
 
       //! release (i.e., reduce refcount of) given object
       /*! note that all objects in ospray are refcounted, so one cannot
@@ -208,6 +284,27 @@ namespace ospray {
         NOT_IMPLEMENTED;
       }
 
+      /*! perform 'count' pick operations at once */
+      virtual void pickBatch(OSPRenderer renderer,
+                             const vec2f *screenPos,
+                             size_t count,
+                             OSPPickResult *results)
+      {
+        for (size_t i = 0; i < count; i++)
+          results[i] = pick(renderer, screenPos[i]);
+      }
+
+      /*! trace 'count' rays against the committed model */
+      virtual void traceRays(OSPModel model,
+                             const OSPTraceRay *rays,
+                             size_t count,
+                             OSPTraceHit *hits,
+                             uint32 flags)
+      {
+        UNUSED(model, rays, count, hits, flags);
+        NOT_IMPLEMENTED;
+      }
+
       virtual void sampleVolume(float **results,
                                 OSPVolume volume,
                                 const vec3f *worldCoordinates,
@@ -217,9 +314,22 @@ namespace ospray {
         NOT_IMPLEMENTED;
       }
 
+      virtual void sampleVolumeBatch(OSPVolume volume,
+                                     const OSPSamplePattern &pattern,
+                                     float *values,
+                                     vec3f *gradients)
+      {
+        UNUSED(volume, pattern, values, gradients);
+        NOT_IMPLEMENTED;
+      }
+
       virtual void commit();
       bool isCommitted();
 
+      /*! whether API calls on distinct objects may be issued from several
+          threads concurrently (e.g. to commit a scene in parallel) */
+      virtual bool isThreadSafe() const { return false; }
+
       bool hasProgressCallback() { return progressCallback != nullptr; }
 
       // Public Data //
@@ -260,6 +370,13 @@ namespace ospray {
 
       bool reportProgress(const float);
 
+      OSPFrameStatsFunc frameStatsCallback {nullptr};
+      void *frameStatsUserPtr {nullptr};
+      std::mutex frameStatsMutex; // protect user callback function
+
+      //! hands the statistics of the finished frame to the user's callback
+      void reportFrameStats(OSPFrameBuffer);
+
     private:
 
       bool committed {false};
@@ -24,20 +24,23 @@
 #include "volume/Volume.h"
 #include "transferFunction/TransferFunction.h"
 #include "render/LoadBalancer.h"
+#include "render/RenderTask.h"
 #include "common/Material.h"
 #include "common/Library.h"
 #include "texture/Texture.h"
 #include "texture/Texture2D.h"
 #include "lights/Light.h"
 #include "fb/LocalFB.h"
+#include "ospcommon/utility/getEnvVar.h"
 
 // stl
 #include <algorithm>
+#include <mutex>
 
 extern "C" {
   RTCDevice ispc_embreeDevice()
   {
-    return ospray::api::ISPCDevice::embreeDevice;
+    return ospray::api::ISPCDevice::getEmbreeDevice();
   }
 }
 
@@ -45,10 +48,60 @@ namespace ospray {
   namespace api {
 
     RTCDevice ISPCDevice::embreeDevice = nullptr;
+    std::atomic<int64_t> ISPCDevice::embreeMemoryUsed {0};
+    std::atomic<bool> ISPCDevice::embreeMemoryBudgetExceeded {false};
+
+    //! the Embree device while it is created in the background, see commit
+    static std::future<RTCDevice> pendingEmbreeDevice;
+    static std::atomic<bool> embreeDevicePending {false};
+    static std::mutex pendingEmbreeDeviceMutex;
+
+    RTCDevice ISPCDevice::getEmbreeDevice()
+    {
+      if (embreeDevicePending) {
+        std::lock_guard<std::mutex> lock(pendingEmbreeDeviceMutex);
+        if (embreeDevicePending) {
+          const double waitStart = getSysTime();
+          try {
+            embreeDevice = pendingEmbreeDevice.get();
+          } catch (...) {
+            embreeDevicePending = false;
+            throw;
+          }
+          embreeDevicePending = false;
+          recordInitPhase("waiting for the embree device",
+                          getSysTime() - waitStart);
+        }
+      }
+      return embreeDevice;
+    }
+
+    bool ISPCDevice::embreeMemoryMonitor(void *, ssize_t bytes, bool post)
+    {
+      // embree only cancels allocations announced before they happen,
+      // which then must not be counted
+      if (bytes > 0 && !post
+          && !ManagedObject::withinMemoryBudget(embreeMemoryUsed + bytes)) {
+        embreeMemoryBudgetExceeded = true;
+        return false;
+      }
+      embreeMemoryUsed += bytes;
+      return true;
+    }
+
+    void ISPCDevice::commitMemoryBudget(Device &device)
+    {
+      auto OSPRAY_MEMORY_BUDGET =
+          utility::getEnvVar<int>("OSPRAY_MEMORY_BUDGET");
+      const int budget = OSPRAY_MEMORY_BUDGET.value_or(
+          device.getParam<int>("memoryBudget", 0));
+      ManagedObject::setMemoryBudget(int64_t(budget) << 20);
+    }
 
     ISPCDevice::~ISPCDevice()
     {
       try {
+        getEmbreeDevice();
         if (embreeDevice) {
           rtcReleaseDevice(embreeDevice);
           embreeDevice = nullptr;
@@ -67,22 +120,35 @@ namespace ospray {
     void ISPCDevice::commit()
     {
       Device::commit();
-
-      if (!embreeDevice) {
-      // -------------------------------------------------------
-      // initialize embree. (we need to do this here rather than in
-      // ospray::init() because in mpi-mode the latter is also called
-      // in the host-stubs, where it shouldn't.
-      // -------------------------------------------------------
-        embreeDevice = rtcNewDevice(generateEmbreeDeviceCfg(*this).c_str());
-        rtcSetDeviceErrorFunction(embreeDevice, embreeErrorFunc, nullptr);
-        RTCError erc = rtcGetDeviceError(embreeDevice);
-        if (erc != RTC_ERROR_NONE) {
-          // why did the error function not get called !?
-          postStatusMsg() << "#osp:init: embree internal error number " << erc;
-          assert(erc == RTC_ERROR_NONE);
-        }
-
+      commitMemoryBudget(*this);
+
+      if (!embreeDevice && !embreeDevicePending) {
+        // -------------------------------------------------------
+        // initialize embree. (we need to do this here rather than in
+        // ospray::init() because in mpi-mode the latter is also called
+        // in the host-stubs, where it shouldn't.
+        // -------------------------------------------------------
+        // this is done in the background, overlapping with the setup of
+        // the scene by the application; first users of the device wait
+        // for it in getEmbreeDevice
+        const std::string config = generateEmbreeDeviceCfg(*this);
+        pendingEmbreeDevice = std::async(std::launch::async, [=]() {
+          const double start = getSysTime();
+          RTCDevice device = rtcNewDevice(config.c_str());
+          rtcSetDeviceErrorFunction(device, embreeErrorFunc, nullptr);
+          rtcSetDeviceMemoryMonitorFunction(device,
+                                            embreeMemoryMonitor, nullptr);
+          RTCError erc = rtcGetDeviceError(device);
+          if (erc != RTC_ERROR_NONE) {
+            // why did the error function not get called !?
+            postStatusMsg() << "#osp:init: embree internal error number "
+                            << erc;
+            assert(erc == RTC_ERROR_NONE);
+          }
+          recordInitPhase("embree device", getSysTime() - start);
+          return device;
+        });
+        embreeDevicePending = true;
       }
 
       TiledLoadBalancer::instance = make_unique<LocalTiledLoadBalancer>();
@@ -132,14 +198,22 @@ namespace ospray {
     void ISPCDevice::commit(OSPObject _object)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
+      object->lastCommitted.renew();
       object->commit();
     }
 
+    void ISPCDevice::commitBatch(const OSPObject *objects, size_t count)
+    {
+      commitInDependencyOrder((ManagedObject *const *)objects, count);
+    }
+
     /*! add a new geometry to a model */
     void ISPCDevice::addGeometry(OSPModel _model, OSPGeometry _geometry)
     {
       Model *model = (Model *)_model;
       Geometry *geometry = (Geometry *)_geometry;
+      std::lock_guard<std::mutex> lock(model->objectMutex);
       model->geometry.push_back(geometry);
     }
 
@@ -147,6 +221,7 @@ namespace ospray {
     {
       Model *model = (Model *)_model;
       Geometry *geometry = (Geometry *)_geometry;
+      std::lock_guard<std::mutex> lock(model->objectMutex);
 
       auto it = std::find_if(model->geometry.begin(),
                              model->geometry.end(),
@@ -164,6 +239,7 @@ namespace ospray {
     {
       Model *model = (Model *) _model;
       Volume *volume = (Volume *) _volume;
+      std::lock_guard<std::mutex> lock(model->objectMutex);
       model->volume.push_back(volume);
     }
 
@@ -171,6 +247,7 @@ namespace ospray {
     {
       Model *model = (Model *)_model;
       Volume *volume = (Volume *)_volume;
+      std::lock_guard<std::mutex> lock(model->objectMutex);
 
       auto it = std::find_if(model->volume.begin(),
                              model->volume.end(),
@@ -191,12 +268,30 @@ namespace ospray {
       return (OSPData)data;
     }
 
+    OSPData ISPCDevice::newDataStrided(size_t nitems, OSPDataType format,
+                                       const void *init, size_t byteStride,
+                                       int flags)
+    {
+      Data *data = new Data(nitems,format,init,flags,byteStride);
+      return (OSPData)data;
+    }
+
+    void ISPCDevice::dataMarkModified(OSPData _data,
+                                      size_t firstItem,
+                                      size_t numItems)
+    {
+      Data *data = (Data *)_data;
+      std::lock_guard<std::mutex> lock(data->objectMutex);
+      data->markModified(firstItem, firstItem + numItems);
+    }
+
     /*! assign (named) string parameter to an object */
     void ISPCDevice::setString(OSPObject _object,
                                 const char *bufName,
                                 const char *s)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam<std::string>(bufName, s);
     }
 
@@ -206,12 +301,14 @@ namespace ospray {
                                  void *v)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, v);
     }
 
     void ISPCDevice::removeParam(OSPObject _object, const char *name)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       // ManagedObjects have to be decref before removing them
       ManagedObject *existing = object->getParam<ManagedObject*>(name, nullptr);
       if (existing)
@@ -225,6 +322,7 @@ namespace ospray {
                             const int f)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, f);
     }
 
@@ -234,6 +332,7 @@ namespace ospray {
                              const bool b)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, b);
     }
 
@@ -243,6 +342,7 @@ namespace ospray {
                               const float f)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, f);
     }
 
@@ -251,6 +351,7 @@ namespace ospray {
                               const vec3i &index, const vec3i &count)
     {
       Volume *volume = (Volume *)handle;
+      std::lock_guard<std::mutex> lock(volume->objectMutex);
       return volume->setRegion(source, index, count);
     }
 
@@ -260,6 +361,7 @@ namespace ospray {
                               const vec2f &v)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, v);
     }
 
@@ -269,6 +371,7 @@ namespace ospray {
                               const vec3f &v)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, v);
     }
 
@@ -278,6 +381,7 @@ namespace ospray {
                               const vec4f &v)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, v);
     }
 
@@ -287,6 +391,7 @@ namespace ospray {
                               const vec2i &v)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, v);
     }
 
@@ -296,6 +401,7 @@ namespace ospray {
                               const vec3i &v)
     {
       ManagedObject *object = (ManagedObject *)_object;
+      std::lock_guard<std::mutex> lock(object->objectMutex);
       object->setParam(bufName, v);
     }
 
@@ -306,6 +412,7 @@ namespace ospray {
     {
       ManagedObject *target = (ManagedObject *)_target;
       ManagedObject *value  = (ManagedObject *)_value;
+      std::lock_guard<std::mutex> lock(target->objectMutex);
       target->setParam(bufName, value);
     }
 
@@ -397,6 +504,63 @@ namespace ospray {
       return renderer->renderFrame(fb, fbChannelFlags);
     }
 
+    OSPFuture ISPCDevice::renderFrameAsync(OSPFrameBuffer _fb,
+                                           OSPRenderer    _renderer,
+                                           const uint32   fbChannelFlags)
+    {
+      FrameBuffer   *fb       = (FrameBuffer *)_fb;
+      Ref<Renderer>  renderer = (Renderer *)_renderer;
+
+      auto *task = new RenderTask(fb, [=]() mutable {
+        const float error = renderer->renderFrame(fb, fbChannelFlags);
+        reportFrameStats(_fb);
+        return error;
+      });
+
+      return (OSPFuture)task;
+    }
+
+    int ISPCDevice::isReady(OSPFuture _future)
+    {
+      auto *future = (Future *)_future;
+      return future->isFinished();
+    }
+
+    float ISPCDevice::wait(OSPFuture _future)
+    {
+      auto *future = (Future *)_future;
+      return future->wait();
+    }
+
+    void ISPCDevice::cancel(OSPFuture _future)
+    {
+      auto *future = (Future *)_future;
+      future->cancel();
+    }
+
+    float ISPCDevice::getProgress(OSPFuture _future)
+    {
+      auto *future = (Future *)_future;
+      return future->getProgress();
+    }
+
+    OSPFrameStats ISPCDevice::getFrameStats(OSPFrameBuffer _fb)
+    {
+      auto *fb = (FrameBuffer *)_fb;
+      return fb->getFrameStats();
+    }
+
+    OSPMemoryUsage ISPCDevice::getMemoryUsage(OSPObject _object)
+    {
+      auto *object = (ManagedObject *)_object;
+      return object->getMemoryUsage();
+    }
+
+    OSPMemoryUsage ISPCDevice::getMemoryTotals(OSPMemoryCategory category)
+    {
+      return ManagedObject::getMemoryTotals(category);
+    }
+
     //! release (i.e., reduce refcount of) given object
     /*! Note that all objects in ospray are refcounted, so one cannot
       explicitly "delete" any object. Instead, each object is created
@@ -419,6 +583,7 @@ namespace ospray {
     {
       Geometry *geometry = (Geometry*)_geometry;
       Material *material = (Material*)_material;
+      std::lock_guard<std::mutex> lock(geometry->objectMutex);
       geometry->setMaterial(material);
     }
 
@@ -429,6 +594,25 @@ namespace ospray {
       return renderer->pick(screenPos);
     }
 
+    void ISPCDevice::pickBatch(OSPRenderer _renderer,
+                               const vec2f *screenPos,
+                               size_t count,
+                               OSPPickResult *results)
+    {
+      Renderer *renderer = (Renderer*)_renderer;
+      renderer->pick(screenPos, count, results);
+    }
+
+    void ISPCDevice::traceRays(OSPModel _model,
+                               const OSPTraceRay *rays,
+                               size_t count,
+                               OSPTraceHit *hits,
+                               uint32 flags)
+    {
+      Model *model = (Model*)_model;
+      model->traceRays(rays, count, hits, flags);
+    }
+
     void ISPCDevice::sampleVolume(float **results,
                                   OSPVolume _volume,
                                   const vec3f *worldCoordinates,
@@ -438,6 +622,15 @@ namespace ospray {
       volume->computeSamples(results, worldCoordinates, count);
     }
 
+    void ISPCDevice::sampleVolumeBatch(OSPVolume _volume,
+                                       const OSPSamplePattern &pattern,
+                                       float *values,
+                                       vec3f *gradients)
+    {
+      Volume *volume = (Volume *)_volume;
+      volume->computeSampleBatch(pattern, values, gradients);
+    }
+
     OSP_REGISTER_DEVICE(ISPCDevice, local_device);
     OSP_REGISTER_DEVICE(ISPCDevice, local);
     OSP_REGISTER_DEVICE(ISPCDevice, default_device);
@@ -446,6 +639,17 @@ namespace ospray {
   } // ::ospray::api
 } // ::ospray
 
+#ifdef OSPRAY_ISPC_DEVICE_VARIANT
+// build for another ISPC target, loaded as module "ispc_<variant>" instead
+// of "ispc" (see ospray::ispcModuleName())
+#define OSPRAY_ISPC_INIT_MODULE_(variant) ospray_init_module_ispc_##variant
+#define OSPRAY_ISPC_INIT_MODULE(variant) OSPRAY_ISPC_INIT_MODULE_(variant)
+extern "C" OSPRAY_DLLEXPORT void
+OSPRAY_ISPC_INIT_MODULE(OSPRAY_ISPC_DEVICE_VARIANT)()
+{
+}
+#else
 extern "C" OSPRAY_DLLEXPORT void ospray_init_module_ispc()
 {
 }
+#endif
@@ -20,6 +20,9 @@
 #include "Device.h"
 //embree
 #include "embree3/rtcore.h"
+// std
+#include <atomic>
+#include <future>
 
 /*! \file ISPCDevice.h Implements the "local" device for local rendering */
 
@@ -41,6 +44,8 @@ namespace ospray {
 
       // Device Implementation ////////////////////////////////////////////////
 
+      bool isThreadSafe() const override { return true; }
+
       /*! create a new frame buffer */
       OSPFrameBuffer frameBufferCreate(const vec2i &size,
                                        const OSPFrameBufferFormat mode,
@@ -69,6 +74,9 @@ namespace ospray {
       /*! commit the given object's outstanding changes */
       void commit(OSPObject object) override;
 
+      /*! commit the outstanding changes of 'count' objects at once */
+      void commitBatch(const OSPObject *objects, size_t count) override;
+
       /*! add a new geometry to a model */
       void addGeometry(OSPModel _model, OSPGeometry _geometry) override;
 
@@ -85,6 +93,14 @@ namespace ospray {
       OSPData newData(size_t nitems, OSPDataType format,
                       const void *init, int flags) override;
 
+      OSPData newDataStrided(size_t nitems, OSPDataType format,
+                             const void *init, size_t byteStride,
+                             int flags) override;
+
+      void dataMarkModified(OSPData _data,
+                            size_t firstItem,
+                            size_t numItems) override;
+
       /*! load module */
       int loadModule(const char *name) override;
 
@@ -196,6 +212,24 @@ namespace ospray {
                                OSPRenderer _renderer,
                                const uint32 fbChannelFlags) override;
 
+      OSPFuture renderFrameAsync(OSPFrameBuffer _fb,
+                                 OSPRenderer _renderer,
+                                 const uint32 fbChannelFlags) override;
+
+      int isReady(OSPFuture _future) override;
+
+      float wait(OSPFuture _future) override;
+
+      void cancel(OSPFuture _future) override;
+
+      float getProgress(OSPFuture _future) override;
+
+      OSPFrameStats getFrameStats(OSPFrameBuffer _fb) override;
+
+      OSPMemoryUsage getMemoryUsage(OSPObject _object) override;
+
+      OSPMemoryUsage getMemoryTotals(OSPMemoryCategory category) override;
+
       //! release (i.e., reduce refcount of) given object
       /*! note that all objects in ospray are refcounted, so one cannot
         explicitly "delete" any object. instead, each object is created
@@ -213,16 +247,49 @@ namespace ospray {
 
       OSPPickResult pick(OSPRenderer renderer, const vec2f &screenPos) override;
 
+      void pickBatch(OSPRenderer renderer,
+                     const vec2f *screenPos,
+                     size_t count,
+                     OSPPickResult *results) override;
+
+      void traceRays(OSPModel model,
+                     const OSPTraceRay *rays,
+                     size_t count,
+                     OSPTraceHit *hits,
+                     uint32 flags) override;
+
       void sampleVolume(float **results,
                         OSPVolume volume,
                         const vec3f *worldCoordinates,
                         const size_t &count) override;
 
+      void sampleVolumeBatch(OSPVolume volume,
+                             const OSPSamplePattern &pattern,
+                             float *values,
+                             vec3f *gradients) override;
+
       // Public Data //
 
       // NOTE(jda) - Keep embreeDevice static until runWorker() in MPI mode can
       //             safely assume that a device exists.
       static RTCDevice embreeDevice;
+
+      /*! the Embree device, for users of embreeDevice which may run before
+          its asynchronous creation (started in commit) has completed */
+      static RTCDevice getEmbreeDevice();
+
+      /*! memory currently allocated by embree (for BVHs etc.), tracked by
+          embreeMemoryMonitor, which all devices install */
+      static std::atomic<int64_t> embreeMemoryUsed;
+      /*! set when embreeMemoryMonitor cancelled an allocation exceeding
+          the memory budget (failing the build), reset by Model::commit */
+      static std::atomic<bool> embreeMemoryBudgetExceeded;
+      static bool embreeMemoryMonitor(void *, ssize_t bytes, bool post);
+
+      /*! sets the memory budget from the "memoryBudget" parameter of
+          'device' (in MB, 0 is unlimited, OSPRAY_MEMORY_BUDGET overrides
+          it), by all devices holding the objects locally */
+      static void commitMemoryBudget(Device &device);
     };
 
   } // ::ospray::api
@@ -19,6 +19,7 @@
 #include "../common/OSPCommon.h"
 
 #include <map>
+#include <mutex>
 
 namespace ospray {
 
@@ -31,8 +32,13 @@ namespace ospray {
 
     // Function pointers corresponding to each subtype.
     static std::map<std::string, creationFunctionPointer> symbolRegistry;
+    static std::mutex registryMutex;
     const auto type_string = stringForType(OSP_TYPE);
 
+    // Objects may be created from several threads (see
+    // Device::isThreadSafe()).
+    std::unique_lock<std::mutex> lock(registryMutex);
+
     // Find the creation function for the subtype if not already known.
     if (symbolRegistry.count(type) == 0) {
       postStatusMsg(2) << "#ospray: trying to look up "
@@ -56,9 +62,12 @@ namespace ospray {
     }
 
     // Create a concrete instance of the requested subtype.
-    auto *object = symbolRegistry[type] ? (*symbolRegistry[type])() : nullptr;
+    const creationFunctionPointer create = symbolRegistry[type];
+    lock.unlock();
+    auto *object = create ? (*create)() : nullptr;
 
     if (object == nullptr) {
+      lock.lock();
       symbolRegistry.erase(type);
       throw std::runtime_error("Could not find " + type_string + " of type: "
         + type + ".  Make sure you have the correct OSPRay libraries linked.");
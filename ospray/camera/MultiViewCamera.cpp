@@ -0,0 +1,65 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "MultiViewCamera.h"
+#include "MultiViewCamera_ispc.h"
+#include "common/Data.h"
+
+namespace ospray {
+
+  MultiViewCamera::MultiViewCamera()
+  {
+    ispcEquivalent = ispc::MultiViewCamera_create(this);
+  }
+
+  std::string MultiViewCamera::toString() const
+  {
+    return "ospray::MultiViewCamera";
+  }
+
+  void MultiViewCamera::commit()
+  {
+    Camera::commit();
+
+    Data *cameraData = getParamData("cameras");
+    if (!cameraData || cameraData->numItems == 0
+        || (cameraData->type != OSP_OBJECT && cameraData->type != OSP_CAMERA))
+      throw std::runtime_error("a multiview camera needs a 'cameras' array "
+                               "(OSP_CAMERA) with at least one camera");
+
+    views.clear();
+    std::vector<void *> viewIEs;
+    for (size_t i = 0; i < cameraData->numItems; i++) {
+      Camera *view = ((Camera **)cameraData->data)[i];
+      if (!view || view == this)
+        throw std::runtime_error("invalid camera in 'cameras' of a "
+                                 "multiview camera");
+      views.push_back(view);
+      viewIEs.push_back(view->getIE());
+    }
+
+    // e.g. level of detail selection uses the camera position, take the
+    // one of the first view
+    pos = views[0]->pos;
+    dir = views[0]->dir;
+    up  = views[0]->up;
+
+    ispc::MultiViewCamera_set(getIE(), viewIEs.data(), viewIEs.size());
+  }
+
+  OSP_REGISTER_CAMERA(MultiViewCamera, multiview);
+
+} // ::ospray
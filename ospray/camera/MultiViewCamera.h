@@ -0,0 +1,61 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "camera/Camera.h"
+// std
+#include <vector>
+
+namespace ospray {
+
+  /*! \defgroup multiview_camera The Multi-View Camera ("multiview")
+
+    \brief Renders several views, each with its own camera, into the
+    layers of one frame buffer with a single ospRenderFrame
+
+    \ingroup ospray_supported_cameras
+
+    The frame buffer is split into as many equally high horizontal
+    bands (layers) as there are cameras, layer i being rendered by
+    camera i; thus the mapped buffer holds the images of the views one
+    after the other. All tiles of all views are scheduled by one load
+    balancer, and per-frame work (renderer setup, frame buffer
+    reductions, MPI collectives) is done once instead of per view,
+    e.g. for cube maps, light probe grids or multi-camera rigs.
+
+    The multi-view camera supports the following parameters
+    <pre>
+    Data<OSPCamera> cameras; // the (committed) camera of each view
+    </pre>
+  */
+
+  //! Implements the multi-view camera (see \subpage multiview_camera)
+  struct OSPRAY_SDK_INTERFACE MultiViewCamera : public Camera
+  {
+    /*! \brief constructor \internal also creates the ispc-side data structure */
+    MultiViewCamera();
+    virtual ~MultiViewCamera() override = default;
+
+    virtual std::string toString() const override;
+    virtual void commit() override;
+
+    // Data members //
+
+    std::vector<Ref<Camera>> views;
+  };
+
+} // ::ospray
@@ -0,0 +1,249 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// ospray
+#include "AccelCache.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#include "ospcommon/memory/malloc.h"
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ospray {
+
+  namespace {
+
+    constexpr char magic[8] = {'O', 'S', 'P', 'A', 'C', 'C', 'E', 'L'};
+    constexpr uint32 version = 1;
+    constexpr size_t alignment = 64;
+
+    struct FileHeader
+    {
+      char magic[8];
+      uint32 version;
+      uint32 numSections;
+      uint64 inputHash;
+    };
+
+    struct SectionHeader
+    {
+      uint32 tag;
+      uint32 pad;
+      uint64 offset;
+      uint64 numBytes;
+    };
+
+    inline size_t alignUp(size_t value)
+    {
+      return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    inline uint64 mix(uint64 h)
+    {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    inline uint64 hashBlock(const uint8 *data, size_t numBytes, uint64 h)
+    {
+      const size_t numWords = numBytes / sizeof(uint64);
+      for (size_t i = 0; i < numWords; i++) {
+        uint64 word;
+        std::memcpy(&word, data + i * sizeof(uint64), sizeof(word));
+        h = (h ^ mix(word)) * 0x9e3779b97f4a7c15ULL;
+      }
+      for (size_t i = numWords * sizeof(uint64); i < numBytes; i++)
+        h = (h ^ data[i]) * 0x100000001b3ULL;
+      return mix(h ^ numBytes);
+    }
+
+  } // ::ospray::{anonymous}
+
+  AccelCache::~AccelCache()
+  {
+    unmap();
+  }
+
+  uint64 AccelCache::hash(const void *data, size_t numBytes, uint64 seed)
+  {
+    // hash blocks in parallel, then the block hashes in order
+    const size_t blockSize = size_t(1) << 22;
+    const size_t numBlocks = (numBytes + blockSize - 1) / blockSize;
+    std::vector<uint64> blockHash(numBlocks);
+    tasking::parallel_for(numBlocks, [&](size_t blockID) {
+      const size_t begin = blockID * blockSize;
+      const size_t end   = std::min(begin + blockSize, numBytes);
+      blockHash[blockID] =
+          hashBlock((const uint8 *)data + begin, end - begin, blockID);
+    });
+
+    return hashBlock((const uint8 *)blockHash.data(),
+                     blockHash.size() * sizeof(uint64),
+                     mix(seed ^ numBytes));
+  }
+
+  bool AccelCache::map(const std::string &fileName, uint64 inputHash)
+  {
+    unmap();
+
+#ifdef _WIN32
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file)
+      return false;
+    fileSize = file.tellg();
+    mem = memory::alignedMalloc(fileSize);
+    file.seekg(0);
+    if (!file.read((char *)mem, fileSize)) {
+      unmap();
+      return false;
+    }
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(FileHeader)) {
+      ::close(fd);
+      return false;
+    }
+    fileSize = info.st_size;
+    mem = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+      mem = nullptr;
+      return false;
+    }
+#endif
+
+    const FileHeader *header = (const FileHeader *)mem;
+    if (fileSize < sizeof(FileHeader) ||
+        std::memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+        header->version != version || header->inputHash != inputHash ||
+        fileSize < sizeof(FileHeader)
+                   + header->numSections * sizeof(SectionHeader)) {
+      unmap();
+      return false;
+    }
+
+    const SectionHeader *table = (const SectionHeader *)(header + 1);
+    for (uint32 i = 0; i < header->numSections; i++) {
+      if (table[i].offset + table[i].numBytes > fileSize) {
+        unmap();
+        return false;
+      }
+      sections.push_back({table[i].tag,
+                          (const uint8 *)mem + table[i].offset,
+                          size_t(table[i].numBytes)});
+    }
+
+    return true;
+  }
+
+  const void *AccelCache::section(uint32 tag, size_t &numBytes) const
+  {
+    for (const auto &s : sections) {
+      if (s.tag == tag) {
+        numBytes = s.numBytes;
+        return s.data;
+      }
+    }
+    numBytes = 0;
+    return nullptr;
+  }
+
+  void AccelCache::write(const std::string &fileName,
+                         uint64 inputHash,
+                         const std::vector<Section> &sections)
+  {
+    FileHeader header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version     = version;
+    header.numSections = sections.size();
+    header.inputHash   = inputHash;
+
+    std::vector<SectionHeader> table(sections.size());
+    size_t offset = alignUp(sizeof(FileHeader) +
+                            sections.size() * sizeof(SectionHeader));
+    for (size_t i = 0; i < sections.size(); i++) {
+      table[i].tag      = sections[i].tag;
+      table[i].pad      = 0;
+      table[i].offset   = offset;
+      table[i].numBytes = sections[i].numBytes;
+      offset = alignUp(offset + sections[i].numBytes);
+    }
+
+    // write to a temporary file first, other processes may map the cache
+    const std::string tmpName = fileName + ".tmp";
+    FILE *file = fopen(tmpName.c_str(), "wb");
+    if (!file)
+      throw std::runtime_error("could not open accel cache file '" + tmpName
+                               + "' for writing");
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (!table.empty()) {
+      ok &= fwrite(table.data(), sizeof(SectionHeader), table.size(), file)
+            == table.size();
+    }
+    const char zeros[alignment] = {0};
+    size_t written = sizeof(FileHeader) + table.size() * sizeof(SectionHeader);
+    for (size_t i = 0; i < sections.size() && ok; i++) {
+      ok &= fwrite(zeros, 1, table[i].offset - written, file)
+            == table[i].offset - written;
+      ok &= fwrite(sections[i].data, 1, sections[i].numBytes, file)
+            == sections[i].numBytes;
+      written = table[i].offset + sections[i].numBytes;
+    }
+    ok &= fclose(file) == 0;
+#ifdef _WIN32
+    if (ok)
+      std::remove(fileName.c_str());
+#endif
+
+    if (!ok || std::rename(tmpName.c_str(), fileName.c_str()) != 0) {
+      std::remove(tmpName.c_str());
+      throw std::runtime_error("could not write accel cache file '"
+                               + fileName + "'");
+    }
+  }
+
+  void AccelCache::unmap()
+  {
+    if (mem) {
+#ifdef _WIN32
+      memory::alignedFree(mem);
+#else
+      munmap(mem, fileSize);
+#endif
+    }
+    mem      = nullptr;
+    fileSize = 0;
+    sections.clear();
+  }
+
+} // ::ospray
@@ -0,0 +1,66 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "OSPCommon.h"
+// std
+#include <vector>
+
+namespace ospray {
+
+  /*! a file holding the acceleration structures (BVHs, face normals,
+      ...) built over the input data of an object, so they can be
+      memory-mapped instead of being rebuilt on every run. The file
+      consists of tagged sections and records a hash of the input data,
+      a file built from other input is never used. */
+  struct OSPRAY_SDK_INTERFACE AccelCache
+  {
+    //! A blob of the file, identified by a tag unique within the file.
+    struct Section
+    {
+      uint32 tag;
+      const void *data;
+      size_t numBytes;
+    };
+
+    AccelCache() = default;
+    ~AccelCache();
+
+    //! Hash 'numBytes' of 'data', combined with a previous hash 'seed'.
+    static uint64 hash(const void *data, size_t numBytes, uint64 seed = 0);
+
+    /*! map 'fileName'; returns false if the file doesn't exist, is not
+        a valid cache file, or was written for different input */
+    bool map(const std::string &fileName, uint64 inputHash);
+
+    //! Return the section with the given tag, or nullptr if there is none.
+    const void *section(uint32 tag, size_t &numBytes) const;
+
+    //! Write the given sections to 'fileName' (replacing that file).
+    static void write(const std::string &fileName,
+                      uint64 inputHash,
+                      const std::vector<Section> &sections);
+
+   private:
+    void unmap();
+
+    void *mem {nullptr};
+    size_t fileSize {0};
+    std::vector<Section> sections;
+  };
+
+} // ::ospray
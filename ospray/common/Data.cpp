@@ -20,24 +20,43 @@
 
 namespace ospray {
 
-  Data::Data(size_t numItems, OSPDataType type, const void *init, int flags) :
+  Data::Data(size_t numItems, OSPDataType type, const void *init, int flags,
+             size_t stride) :
     numItems(numItems),
     numBytes(numItems * sizeOf(type)),
+    byteStride(sizeOf(type)),
     flags(flags),
     type(type)
   {
+    const bool strided = stride != 0 && stride != byteStride;
+    if (strided && type == OSP_OBJECT)
+      throw std::runtime_error("data of objects cannot be strided");
+
     if (flags & OSP_DATA_SHARED_BUFFER) {
       Assert2(init != NULL, "shared buffer is NULL");
       data = const_cast<void *>(init);
+      if (strided) {
+        byteStride = stride;
+        numBytes = numItems ? (numItems - 1) * stride + sizeOf(type) : 0;
+      }
     } else {
+      checkMemoryBudget(numBytes);
       data = alignedMalloc(numBytes+16);
-      if (init)
+      if (init && strided) {
+        // pack the strided items
+        for (size_t i = 0; i < numItems; i++) {
+          memcpy((char *)data + i * byteStride,
+                 (const char *)init + i * stride, byteStride);
+        }
+      } else if (init)
         memcpy(data,init,numBytes);
       else if (type == OSP_OBJECT)
         memset(data,0,numBytes);
     }
 
     managedObjectType = OSP_DATA;
+    setMemoryUsage(OSP_MEMORY_DATA,
+                   flags & OSP_DATA_SHARED_BUFFER ? 0 : numBytes);
 
     if (type == OSP_OBJECT) {
       ManagedObject **child = (ManagedObject **)data;
@@ -66,6 +85,18 @@ namespace ospray {
     listeners that have registered know that we have changed */
   void Data::commit()
   {
+    if (markedBegin < markedEnd) {
+      modifiedBegin = markedBegin;
+      modifiedEnd = markedEnd;
+    } else {
+      modifiedBegin = 0;
+      modifiedEnd = numItems;
+    }
+    markedBegin = markedEnd = 0;
+
+    previouslyCommitted = committed;
+    committed = utility::TimeStamp();
+
     notifyListenersThatObjectGotChanged();
   }
 
@@ -74,9 +105,62 @@ namespace ospray {
     return "ospray::Data";
   }
 
+  void Data::getDependencies(std::vector<ManagedObject *> &dependencies)
+  {
+    if (type != OSP_OBJECT)
+      return;
+
+    ManagedObject **child = (ManagedObject **)data;
+    for (size_t i = 0; i < numItems; i++) {
+      if (child[i])
+        dependencies.push_back(child[i]);
+    }
+  }
+
   size_t ospray::Data::size() const
   {
     return numItems;
   }
 
+  bool Data::compact() const
+  {
+    return byteStride == sizeOf(type);
+  }
+
+  int Data::componentStride() const
+  {
+    if (byteStride % 4 != 0) {
+      throw std::runtime_error("the stride of the data must be a multiple "
+                               "of 4 bytes");
+    }
+    return int(byteStride / 4);
+  }
+
+  void Data::markModified(size_t begin, size_t end)
+  {
+    end = std::min(end, numItems);
+    if (begin >= end)
+      return;
+
+    if (markedBegin < markedEnd) {
+      markedBegin = std::min(markedBegin, begin);
+      markedEnd = std::max(markedEnd, end);
+    } else {
+      markedBegin = begin;
+      markedEnd = end;
+    }
+  }
+
+  void Data::modifiedSince(size_t time, size_t &begin, size_t &end) const
+  {
+    // a shared buffer may also have been changed without committing it
+    if (committed > time && previouslyCommitted <= time) {
+      begin = modifiedBegin;
+      end = modifiedEnd;
+    } else {
+      begin = 0;
+      end = numItems;
+    }
+  }
+
 } // ::ospray
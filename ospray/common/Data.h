@@ -22,10 +22,15 @@
 namespace ospray {
 
   /*! \brief defines a data array (aka "buffer") type that contains
-      'n' items of a given type */
+      'n' items of a given type
+
+      A shared buffer can be a strided view of the application's memory,
+      with items 'byteStride' bytes apart (e.g. the positions in an array
+      of interleaved vertices); non-shared data is always compact. */
   struct OSPRAY_SDK_INTERFACE Data : public ManagedObject
   {
-    Data(size_t numItems, OSPDataType type, const void *data, int flags = 0);
+    Data(size_t numItems, OSPDataType type, const void *data, int flags = 0,
+         size_t byteStride = 0);
 
     virtual ~Data() override;
 
@@ -36,16 +41,49 @@ namespace ospray {
     /*! pretty-print this object, for debugging purposes */
     virtual std::string toString() const override;
 
+    /*! the items of a data array of objects */
+    virtual void getDependencies(std::vector<ManagedObject *> &dependencies)
+        override;
+
     /*! return number of items in this data buffer */
     size_t size() const;
 
+    /*! whether the items are adjacent in memory (i.e., not strided) */
+    bool compact() const;
+
+    /*! the stride between items in 32-bit components (ints or floats),
+        throws if it is not a multiple of 4 bytes */
+    int componentStride() const;
+
+    /*! mark the items [begin, end) as modified, such that the next commit
+        reports only those (and the ranges marked before) as changed */
+    void markModified(size_t begin, size_t end);
+
+    /*! the items [begin, end) changed since the given time stamp: those
+        of the last commit if it is the only commit since, otherwise
+        (conservatively) all items */
+    void modifiedSince(size_t time, size_t &begin, size_t &end) const;
+
     // Data members //
 
     void       *data;     /*!< pointer to data */
     size_t      numItems; /*!< number of items */
-    size_t      numBytes; /*!< total num bytes (sizeof(type)*numItems) */
+    size_t      numBytes; /*!< total num bytes spanned by the items
+                               (sizeof(type)*numItems if compact) */
+    size_t      byteStride; /*!< bytes from one item to the next */
     int         flags;    /*!< creation flags */
     OSPDataType type;     /*!< element type */
+
+    /*! items [modifiedBegin, modifiedEnd) were changed by the last commit */
+    size_t modifiedBegin {0};
+    size_t modifiedEnd {0};
+
+  private:
+
+    size_t markedBegin {0}; /*!< marked since the last commit, */
+    size_t markedEnd {0};   /*!< nothing marked means all items */
+    size_t committed {0};   /*!< time stamps of the last two commits */
+    size_t previouslyCommitted {0};
   };
 
 } // ::ospray
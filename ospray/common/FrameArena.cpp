@@ -0,0 +1,132 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "FrameArena.h"
+// std
+#include <atomic>
+#include <vector>
+
+namespace ospray {
+
+  //! number of frames in flight; the arenas are reset once it reaches 0
+  static std::atomic<int> numActiveFrames {0};
+  //! incremented with each reset, telling the threads to rewind
+  static std::atomic<uint64_t> arenaEpoch {0};
+
+  struct ThreadArena
+  {
+    ~ThreadArena()
+    {
+      for (auto &chunk : chunks)
+        alignedFree(chunk.mem);
+    }
+
+    struct Chunk
+    {
+      void *mem;
+      size_t size;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t current {0}; //!< chunk currently bumped off
+    size_t offset {0};  //!< of the next allocation in the current chunk
+    uint64_t epoch {0};
+  };
+
+  static thread_local ThreadArena threadArena;
+
+  void FrameArena::beginFrame()
+  {
+    numActiveFrames++;
+  }
+
+  void FrameArena::endFrame()
+  {
+    if (--numActiveFrames == 0)
+      arenaEpoch++;
+  }
+
+  //! the arena of the calling thread, rewound if all memory of previous
+  //  frames is free again
+  static ThreadArena &currentArena()
+  {
+    auto &arena = threadArena;
+    const uint64_t epoch = arenaEpoch.load(std::memory_order_acquire);
+    if (arena.epoch != epoch) {
+      arena.epoch   = epoch;
+      arena.current = 0;
+      arena.offset  = 0;
+    }
+    return arena;
+  }
+
+  FrameArena::Mark FrameArena::mark()
+  {
+    const auto &arena = currentArena();
+    return {arena.current, arena.offset, arena.epoch};
+  }
+
+  void FrameArena::release(const Mark &m)
+  {
+    // after a rewind the arena is already before the mark
+    auto &arena = currentArena();
+    if (arena.epoch != m.epoch)
+      return;
+    arena.current = m.chunk;
+    arena.offset  = m.offset;
+  }
+
+  void *FrameArena::allocate(size_t bytes, size_t align)
+  {
+    auto &arena = currentArena();
+
+    while (arena.current < arena.chunks.size()) {
+      const auto &chunk = arena.chunks[arena.current];
+      const size_t begin = (size_t)chunk.mem + arena.offset;
+      const size_t aligned = ALIGN_PTR(begin, align);
+      if (aligned + bytes <= (size_t)chunk.mem + chunk.size) {
+        arena.offset = aligned + bytes - (size_t)chunk.mem;
+        return (void *)aligned;
+      }
+      arena.current++;
+      arena.offset = 0;
+    }
+
+    // chunks are 64 byte aligned, which covers all usual alignments
+    const size_t size = std::max(bytes + align, chunkSize);
+    arena.chunks.push_back({alignedMalloc(size, 64), size});
+    arena.current = arena.chunks.size() - 1;
+    const size_t aligned = ALIGN_PTR(arena.chunks.back().mem, align);
+    arena.offset = aligned + bytes - (size_t)arena.chunks.back().mem;
+    return (void *)aligned;
+  }
+
+  extern "C" void *ospray_FrameArena_allocate(uint64 bytes)
+  {
+    return FrameArena::allocate(bytes);
+  }
+
+  extern "C" void ospray_FrameArena_mark(FrameArena::Mark *m)
+  {
+    *m = FrameArena::mark();
+  }
+
+  extern "C" void ospray_FrameArena_release(const FrameArena::Mark *m)
+  {
+    FrameArena::release(*m);
+  }
+
+} // ::ospray
@@ -0,0 +1,76 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "common/OSPCommon.h"
+
+namespace ospray {
+
+  /*! \brief per-thread bump allocator for scratch memory of a frame
+
+    Renderers need temporary buffers while rendering a frame (e.g. the
+    path states of the wavefront path tracer per job). Instead of hitting
+    the heap for them, memory is bumped off chunks owned by the calling
+    thread, without any locking. All memory handed out stays valid until
+    the last frame in flight ended (frames may overlap, see
+    ospRenderFrameAsync); then all chunks get reused from their start by
+    the next frame. Chunks are kept and only freed on thread exit.
+
+    Scratch memory of a single job must not pile up over the whole frame:
+    jobs take a mark() at their start and release() it at their end,
+    such that the next job on the thread reuses the same memory.
+
+    Renderer::beginFrame()/endFrame() bracket each frame; ISPC code
+    allocates via ospray_FrameArena_allocate() and scopes its jobs with
+    ospray_FrameArena_mark()/release() (see OSPCommon.ih).
+   */
+  struct OSPRAY_SDK_INTERFACE FrameArena
+  {
+    static void beginFrame();
+    static void endFrame();
+
+    /*! returns (uninitialized) memory valid until the end of the frame;
+        must only be called between beginFrame() and endFrame() */
+    static void *allocate(size_t bytes, size_t align = 64);
+
+    //! position in the arena of the calling thread
+    struct Mark
+    {
+      uint64_t chunk;
+      uint64_t offset;
+      uint64_t epoch;
+    };
+
+    //! the current position in the arena of the calling thread
+    static Mark mark();
+
+    /*! frees all memory allocated by the calling thread since 'm' was
+        taken; marks must be released in reverse order */
+    static void release(const Mark &m);
+
+    template <typename T>
+    static T *allocate(size_t nElements)
+    {
+      return (T*)allocate(nElements * sizeof(T),
+                          std::max(alignof(T), size_t(16)));
+    }
+
+    //! size of the chunks, larger allocations get a chunk of their own
+    static constexpr size_t chunkSize = 1 << 20;
+  };
+
+} // ::ospray
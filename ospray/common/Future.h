@@ -0,0 +1,50 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "common/Managed.h"
+
+namespace ospray {
+
+  /*! \brief handle to an operation running asynchronously to the
+      application, as returned by ospRenderFrameAsync
+
+      The operation keeps running if the application releases the
+      future; it is only waited on when the last reference goes away.
+   */
+  struct OSPRAY_SDK_INTERFACE Future : public ManagedObject
+  {
+    Future() = default;
+    virtual ~Future() override = default;
+
+    /*! \brief whether the operation has finished, never blocks */
+    virtual bool isFinished() = 0;
+
+    /*! \brief block until the operation has finished, returns its result */
+    virtual float wait() = 0;
+
+    /*! \brief ask the operation to finish early, never blocks */
+    virtual void cancel() = 0;
+
+    /*! \brief progress of the operation, in [0..1] */
+    virtual float getProgress() = 0;
+
+    virtual std::string toString() const override
+    { return "ospray::Future"; }
+  };
+
+} // ::ospray
@@ -15,12 +15,37 @@
 // ======================================================================== //
 
 #include "Managed.h"
+#include "Data.h"
+#include "api/ISPCDevice.h"
 #include "OSPCommon_ispc.h"
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ospray {
 
+  /*! totals of the memory reported via setMemoryUsage, per category */
+  struct MemoryTotals
+  {
+    std::atomic<int64_t> bytes {0};
+    std::atomic<int64_t> accelBytes {0};
+    std::atomic<int64_t> objects {0};
+  };
+
+  static MemoryTotals memoryTotals[OSP_MEMORY_CATEGORY_COUNT];
+
+  static std::atomic<int64_t> memoryBudget {0};
+
   ManagedObject::~ManagedObject()
   {
+    setMemoryUsage(OSP_MEMORY_CATEGORY_COUNT, 0);
+
     // it is OK to potentially delete nullptr, nothing bad happens ==> no need to check
     ispc::delete_uniform(ispcEquivalent);
     ispcEquivalent = nullptr;
@@ -53,6 +78,7 @@ namespace ospray {
   /*! \detailed this object will now get update notifications from us */
   void ManagedObject::registerListener(ManagedObject *newListener)
   {
+    std::lock_guard<std::mutex> lock(listenerMutex);
     objectsListeningForChanges.insert(newListener);
   }
 
@@ -60,19 +86,125 @@ namespace ospray {
   /*! \detailed this object will no longer get update notifications from us  */
   void ManagedObject::unregisterListener(ManagedObject *noLongerListening)
   {
+    std::lock_guard<std::mutex> lock(listenerMutex);
     objectsListeningForChanges.erase(noLongerListening);
   }
 
+  OSPMemoryUsage ManagedObject::getMemoryUsage() const
+  {
+    OSPMemoryUsage usage;
+    usage.bytes = memoryBytes;
+    usage.accelBytes = memoryAccelBytes;
+    usage.objects = 1;
+    return usage;
+  }
+
+  OSPMemoryUsage ManagedObject::getMemoryTotals(OSPMemoryCategory category)
+  {
+    if (category < 0 || category >= OSP_MEMORY_CATEGORY_COUNT)
+      throw std::runtime_error("invalid memory category");
+
+    const MemoryTotals &totals = memoryTotals[category];
+    OSPMemoryUsage usage;
+    usage.bytes = totals.bytes;
+    usage.accelBytes = totals.accelBytes;
+    usage.objects = totals.objects;
+    return usage;
+  }
+
+  void ManagedObject::setMemoryUsage(OSPMemoryCategory category,
+                                     int64_t bytes,
+                                     int64_t accelBytes)
+  {
+    if (memoryCategory != OSP_MEMORY_CATEGORY_COUNT) {
+      MemoryTotals &totals = memoryTotals[memoryCategory];
+      totals.bytes -= memoryBytes;
+      totals.accelBytes -= memoryAccelBytes;
+      totals.objects--;
+    }
+
+    // OSP_MEMORY_CATEGORY_COUNT removes this object from the totals
+    memoryCategory = category;
+    memoryBytes = category != OSP_MEMORY_CATEGORY_COUNT ? bytes : 0;
+    memoryAccelBytes = category != OSP_MEMORY_CATEGORY_COUNT ? accelBytes : 0;
+    if (memoryCategory == OSP_MEMORY_CATEGORY_COUNT)
+      return;
+
+    MemoryTotals &totals = memoryTotals[memoryCategory];
+    totals.bytes += memoryBytes;
+    totals.accelBytes += memoryAccelBytes;
+    totals.objects++;
+
+    postStatusMsg(2) << "#osp: " << toString() << " uses "
+                     << memoryBytes / (1024.0 * 1024.0) << " MB ("
+                     << memoryAccelBytes / (1024.0 * 1024.0)
+                     << " MB acceleration structures), all objects of its "
+                     << "category " << totals.bytes / (1024.0 * 1024.0)
+                     << " MB";
+  }
+
+  void ManagedObject::setMemoryBudget(int64_t bytes)
+  {
+    memoryBudget = std::max(int64_t(0), bytes);
+  }
+
+  int64_t ManagedObject::getMemoryBudget()
+  {
+    return memoryBudget;
+  }
+
+  bool ManagedObject::withinMemoryBudget(int64_t embreeBytes,
+                                         int64_t additionalBytes)
+  {
+    const int64_t budget = memoryBudget;
+    if (budget == 0)
+      return true;
+
+    int64_t used = embreeBytes + additionalBytes;
+    for (int c = 0; c < OSP_MEMORY_CATEGORY_COUNT; c++) {
+      if (c != OSP_MEMORY_MODEL)
+        used += memoryTotals[c].bytes;
+    }
+    return used <= budget;
+  }
+
+  void ManagedObject::checkMemoryBudget(int64_t bytes) const
+  {
+    const int64_t embreeBytes = api::ISPCDevice::embreeMemoryUsed;
+    if (withinMemoryBudget(embreeBytes, bytes - memoryBytes))
+      return;
+
+    std::stringstream ss;
+    ss << toString() << " needs " << bytes / (1024.0 * 1024.0)
+       << " MB, exceeding the memoryBudget of "
+       << getMemoryBudget() / (1024.0 * 1024.0) << " MB";
+    throw std::runtime_error(ss.str());
+  }
+
   /*! \brief gets called whenever any of this node's dependencies got changed */
   void ManagedObject::dependencyGotChanged(ManagedObject *object)
   {
     UNUSED(object);
   }
 
-#define define_getparam(T,ABB)                                      \
-  T ManagedObject::getParam##ABB(const char *name, T valIfNotFound) \
-  {                                                                 \
-    return getParam<T>(name, valIfNotFound);                        \
+  void ManagedObject::getDependencies(std::vector<ManagedObject *> &dependencies)
+  {
+    std::for_each(params_begin(),
+                  params_end(),
+                  [&](std::shared_ptr<Param> &p) {
+                    auto &param = *p;
+                    if (param.data.is<OSP_PTR>()) {
+                      auto *obj = param.data.get<OSP_PTR>();
+                      if (obj != nullptr) dependencies.push_back(obj);
+                    }
+                  });
+  }
+
+#define define_getparam(T,ABB)                                         \
+  T ManagedObject::getParam##ABB(const utility::ParamName &name,       \
+                                 T valIfNotFound)                      \
+  {                                                                    \
+    return getParam<T>(name, valIfNotFound);                           \
   }
 
   define_getparam(ManagedObject *, Object)
@@ -92,8 +224,67 @@ namespace ospray {
 
   void ManagedObject::notifyListenersThatObjectGotChanged()
   {
+    std::lock_guard<std::mutex> lock(listenerMutex);
     for (auto *object : objectsListeningForChanges)
       object->dependencyGotChanged(this);
   }
 
+  void commitInDependencyOrder(ManagedObject *const *objects, size_t count)
+  {
+    // the depth of an object is the longest chain of dependencies on other
+    // objects of the batch (possibly via objects not in the batch), thus
+    // the objects of a depth do not depend on each other
+    const std::unordered_set<ManagedObject *> batch(objects, objects + count);
+    std::unordered_map<ManagedObject *, int> depth;
+    std::function<int(ManagedObject *)> depthOf = [&](ManagedObject *object) {
+      auto known = depth.find(object);
+      if (known != depth.end())
+        return std::max(known->second, 0); // ignore cycles
+      depth[object] = -1;
+
+      std::vector<ManagedObject *> dependencies;
+      object->getDependencies(dependencies);
+      int d = 0;
+      for (auto *dependency : dependencies)
+        d = std::max(d, depthOf(dependency));
+      if (batch.count(object))
+        d++;
+      return depth[object] = d;
+    };
+
+    std::vector<std::vector<ManagedObject *>> levels;
+    std::unordered_set<ManagedObject *> added;
+    for (size_t i = 0; i < count; i++) {
+      ManagedObject *object = objects[i];
+      if (!object || !added.insert(object).second)
+        continue;
+      const int d = depthOf(object);
+      if (levels.size() < size_t(d))
+        levels.resize(d);
+      levels[d - 1].push_back(object);
+    }
+
+    for (const auto &level : levels) {
+      for (auto *object : level)
+        object->commitLazyDependencies();
+
+      std::mutex errorMutex;
+      std::exception_ptr error;
+      tasking::parallel_for(level.size(), [&](size_t i) {
+        ManagedObject *object = level[i];
+        try {
+          std::lock_guard<std::mutex> lock(object->objectMutex);
+          object->lastCommitted.renew();
+          object->commit();
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (!error)
+            error = std::current_exception();
+        }
+      });
+      if (error)
+        std::rethrow_exception(error);
+    }
+  }
+
 } // ::ospray
@@ -19,11 +19,13 @@
 // ospcommon
 #include "ospcommon/utility/Any.h"
 #include "ospcommon/utility/ParameterizedObject.h"
+#include "ospcommon/utility/TimeStamp.h"
 // ospray
 #include "ospray/OSPDataType.h"
 #include "common/OSPCommon.h"
 #include "common/ObjectHandle.h"
 // stl
+#include <mutex>
 #include <vector>
 #include <set>
 
@@ -138,22 +140,24 @@ namespace ospray {
         have its refcount increased; it is up to the callee to
         properly do that (typically by assigning to a proper 'ref'
         instance */
-    ManagedObject *getParamObject(const char *name,
+    ManagedObject *getParamObject(const utility::ParamName &name,
                                   ManagedObject *valIfNotFound = nullptr);
 
-    Data *getParamData(const char *name, Data *valIfNotFound = nullptr);
-
-    vec4f  getParam4f(const char *name, vec4f  valIfNotFound);
-    vec3fa getParam3f(const char *name, vec3fa valIfNotFound);
-    vec3f  getParam3f(const char *name, vec3f  valIfNotFound);
-    vec3i  getParam3i(const char *name, vec3i  valIfNotFound);
-    vec2f  getParam2f(const char *name, vec2f  valIfNotFound);
-    int32  getParam1i(const char *name, int32  valIfNotFound);
-    float  getParam1f(const char *name, float  valIfNotFound);
-    float  getParamf (const char *name, float  valIfNotFound);
-
-    void *getParamVoidPtr(const char *name, void * valIfNotFound);
-    std::string getParamString(const char *name,
+    Data *getParamData(const utility::ParamName &name,
+                       Data *valIfNotFound = nullptr);
+
+    vec4f  getParam4f(const utility::ParamName &name, vec4f  valIfNotFound);
+    vec3fa getParam3f(const utility::ParamName &name, vec3fa valIfNotFound);
+    vec3f  getParam3f(const utility::ParamName &name, vec3f  valIfNotFound);
+    vec3i  getParam3i(const utility::ParamName &name, vec3i  valIfNotFound);
+    vec2f  getParam2f(const utility::ParamName &name, vec2f  valIfNotFound);
+    int32  getParam1i(const utility::ParamName &name, int32  valIfNotFound);
+    float  getParam1f(const utility::ParamName &name, float  valIfNotFound);
+    float  getParamf (const utility::ParamName &name, float  valIfNotFound);
+
+    void *getParamVoidPtr(const utility::ParamName &name,
+                          void * valIfNotFound);
+    std::string getParamString(const utility::ParamName &name,
                                std::string valIfNotFound = "");
 
     // ------------------------------------------------------------------
@@ -173,6 +177,18 @@ namespace ospray {
         objects in 'objectsListeningForChanges' */
     void notifyListenersThatObjectGotChanged();
 
+    //! \brief the objects that have to be committed before this one
+    /*! \detailed used to order the commits of a batch of objects (see
+        commitInDependencyOrder); by default the object parameters,
+        derived classes add the objects they reference otherwise */
+    virtual void getDependencies(std::vector<ManagedObject *> &dependencies);
+
+    //! \brief commit what the commit of this object would commit lazily
+    /*! \detailed e.g. the models instanced by the geometries of a model;
+        called serially before commits which may run in parallel to each
+        other, such that no parallel task commits a shared object */
+    virtual void commitLazyDependencies() {}
+
     //! \brief register a new listener for given object
     /*! \detailed this object will now get update notifications from us */
     void registerListener(ManagedObject *newListener);
@@ -181,6 +197,44 @@ namespace ospray {
     /*! \detailed this object will no longer get update notifications from us */
     void unregisterListener(ManagedObject *noLongerListening);
 
+    // ------------------------------------------------------------------
+    // memory accounting, see ospGetMemoryUsage
+    // ------------------------------------------------------------------
+
+    /*! \brief the memory currently held by this object */
+    /*! \detailed objects also holding memory not reported via
+        setMemoryUsage (e.g., of internal objects) override this */
+    virtual OSPMemoryUsage getMemoryUsage() const;
+
+    /*! \brief the memory held by all existing objects of a category */
+    static OSPMemoryUsage getMemoryTotals(OSPMemoryCategory category);
+
+    /*! \brief (re)sets the memory held by this object, to be called by
+        derived classes whenever they (re)allocate, typically in commit */
+    /*! \detailed 'accelBytes' is the part of 'bytes' in acceleration
+        structures; the totals of the category get updated accordingly */
+    void setMemoryUsage(OSPMemoryCategory category,
+                        int64_t bytes,
+                        int64_t accelBytes = 0);
+
+    /*! \brief the memory budget of the device (in bytes, 0 is unlimited),
+        see the "memoryBudget" device parameter */
+    static void setMemoryBudget(int64_t bytes);
+    static int64_t getMemoryBudget();
+
+    /*! \brief whether 'embreeBytes' allocated by embree plus
+        'additionalBytes' fit into the memory budget, together with the
+        memory held by all objects */
+    /*! \detailed the memory of models is the one of their BVHs, thus
+        is not counted twice */
+    static bool withinMemoryBudget(int64_t embreeBytes,
+                                   int64_t additionalBytes = 0);
+
+    /*! \brief throws if this object holding 'bytes' (instead of what it
+        currently reports) exceeds the memory budget, to be called by
+        derived classes before large allocations */
+    void checkMemoryBudget(int64_t bytes) const;
+
     // Data members //
 
     //! \brief List of managed objects that want to get notified
@@ -195,17 +249,44 @@ namespace ospray {
        dies */
     std::set<ManagedObject *> objectsListeningForChanges;
 
+    /*! \brief serializes the API calls setting parameters of or committing
+        this object (see Device::isThreadSafe()), such that distinct
+        objects can be set up by several threads concurrently */
+    std::mutex objectMutex;
+
     /*! \brief a global ID that can be used for referencing an object remotely*/
     id_t ID {(id_t)-1};
 
+    /*! \brief when this object was last committed (by the device), allows
+        e.g. models to skip geometries that did not change */
+    utility::TimeStamp lastCommitted;
+
     /*! \brief ISPC-side equivalent of this C++-side class, if available
      *         (nullptr if not) */
     void *ispcEquivalent {nullptr};
 
     /*! \brief subtype of this ManagedObject */
     OSPDataType managedObjectType {OSP_UNKNOWN};
+
+  private:
+
+    /*! guards 'objectsListeningForChanges', listeners of shared objects
+        (e.g. a transfer function) may be committed concurrently */
+    std::mutex listenerMutex;
+
+    /*! memory reported with setMemoryUsage, 'memoryCategory' is
+        OSP_MEMORY_CATEGORY_COUNT as long as nothing was reported */
+    OSPMemoryCategory memoryCategory {OSP_MEMORY_CATEGORY_COUNT};
+    int64_t memoryBytes {0};
+    int64_t memoryAccelBytes {0};
   };
 
+  /*! \brief commit a batch of objects (see ospCommitBatch), each once
+      and after the objects of the batch it depends on; objects which are
+      independent of each other are committed in parallel */
+  OSPRAY_SDK_INTERFACE void commitInDependencyOrder(ManagedObject *const *objects,
+                                                    size_t count);
+
   // Inlined ManagedObject definitions ////////////////////////////////////////
 
   inline void* ManagedObject::getIE() const
@@ -214,7 +295,8 @@ namespace ospray {
   }
 
   inline Data*
-  ManagedObject::getParamData(const char *name, Data *valIfNotFound)
+  ManagedObject::getParamData(const utility::ParamName &name,
+                              Data *valIfNotFound)
   {
     return (Data*)getParamObject(name,(ManagedObject*)valIfNotFound);
   }
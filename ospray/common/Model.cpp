@@ -17,15 +17,46 @@
 // ospray
 #include "api/ISPCDevice.h"
 #include "Model.h"
+#include "geometry/Instance.h"
+#include "geometry/InstanceArray.h"
 // ispc exports
 #include "Model_ispc.h"
 #include "Volume_ispc.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/utility/Profiler.h"
+// std
+#include <algorithm>
 
 namespace ospray {
 
+  //! number of rays traced as one stream by one task of traceRays
+  static constexpr size_t traceBatchSize = 1024;
+
   extern "C" void *ospray_getEmbreeDevice()
   {
-    return api::ISPCDevice::embreeDevice;
+    return api::ISPCDevice::getEmbreeDevice();
+  }
+
+  RTCBuildQuality buildQualityForString(const std::string &s)
+  {
+    if (s == "low")
+      return RTC_BUILD_QUALITY_LOW;
+    if (s == "medium")
+      return RTC_BUILD_QUALITY_MEDIUM;
+    if (s == "high")
+      return RTC_BUILD_QUALITY_HIGH;
+    if (s == "refit")
+      return RTC_BUILD_QUALITY_REFIT;
+    throw std::runtime_error("unknown buildQuality '" + s + "'");
+  }
+
+  extern "C" uint32 ospray_Model_attachGeometry(void *model,
+                                                void *geometry,
+                                                RTCGeometry embreeGeom)
+  {
+    return ((Model *)model)->attachGeometry((const Geometry *)geometry,
+                                            embreeGeom);
   }
 
   Model::Model()
@@ -42,16 +73,65 @@ namespace ospray {
     ispc::Model_cleanup(getIE());
   }
 
+  uint32 Model::attachGeometry(const Geometry *geom, RTCGeometry embreeGeom)
+  {
+    // the map is only written (before and after the parallel finalize) by
+    // commit, and attaching is thread-safe in embree
+    auto id = geometryIDs.find(geom);
+    if (id == geometryIDs.end())
+      return rtcAttachGeometry(embreeSceneHandle, embreeGeom);
+
+    rtcAttachGeometryByID(embreeSceneHandle, embreeGeom, id->second);
+    return id->second;
+  }
+
   std::string Model::toString() const
   {
     return "ospray::Model";
   }
 
+  void Model::getDependencies(std::vector<ManagedObject *> &dependencies)
+  {
+    ManagedObject::getDependencies(dependencies);
+    for (auto &g : geometry)
+      dependencies.push_back(g.ptr);
+    for (auto &v : volume)
+      dependencies.push_back(v.ptr);
+  }
+
+  void Model::commitLazyDependencies()
+  {
+    std::vector<Model *> instanced;
+    for (auto &g : geometry)
+      g->getInstancedModels(instanced);
+
+    // recursively commits the models instanced by those
+    for (auto *model : instanced) {
+      if (!model->embreeSceneHandle)
+        model->commit();
+    }
+  }
+
   void Model::commit()
   {
+    OSPRAY_PROFILE_ZONE("Model::commit");
+
+    // not from within the parallel finalize below: a task waiting there
+    // may run the finalize of another instance of the same model
+    commitLazyDependencies();
+
     useEmbreeDynamicSceneFlag = getParam<int>("dynamicScene", 0);
-    useEmbreeCompactSceneFlag = getParam<int>("compactMode", 0);
+    useEmbreeCompactSceneFlag =
+        getParam<int>("compactMode", 0) || compactForMemoryBudget;
     useEmbreeRobustSceneFlag = getParam<int>("robustMode", 0);
+    const bool robustOffset = getParam<int>("robustOffset", 0);
+    buildQuality = buildQualityForString(getParamString("buildQuality",
+                                                        "medium"));
+    if (buildQuality == RTC_BUILD_QUALITY_REFIT)
+      throw std::runtime_error("model buildQuality cannot be 'refit'");
+
+    const double commitStart = getSysTime();
+    const int64_t embreeMemoryStart = api::ISPCDevice::embreeMemoryUsed;
 
     postStatusMsg(2)
         << "=======================================================\n"
@@ -68,23 +148,88 @@ namespace ospray {
     sceneFlags =
         sceneFlags | (useEmbreeRobustSceneFlag ? RTC_SCENE_FLAG_ROBUST : 0);
 
-    ispc::Model_init(getIE(),
-                     embreeDevice,
-                     sceneFlags,
-                     geometry.size(),
-                     volume.size());
+    // reuse the embree scene if possible, and only detach and finalize
+    // again the geometries that were changed, added, or moved
+    const size_t lastSceneTime = sceneTime;
+    sceneTime.renew();
 
-    embreeSceneHandle = (RTCScene)ispc::Model_getEmbreeSceneHandle(getIE());
+    if (!embreeSceneHandle || sceneFlags != embreeSceneFlags
+        || buildQuality != embreeSceneQuality) {
+      ispc::Model_init(getIE(),
+                       embreeDevice,
+                       sceneFlags,
+                       geometry.size(),
+                       volume.size());
 
-    bounds = empty;
+      embreeSceneHandle = (RTCScene)ispc::Model_getEmbreeSceneHandle(getIE());
+      embreeSceneFlags = sceneFlags;
+      embreeSceneQuality = buildQuality;
+      rtcSetSceneBuildQuality(embreeSceneHandle, buildQuality);
+      attachedGeometry.clear();
+    } else {
+      ispc::Model_resize(getIE(), geometry.size(), volume.size());
+    }
+
+    size_t numUnmoved = 0;
+    while (numUnmoved < std::min(attachedGeometry.size(), geometry.size())
+           && attachedGeometry[numUnmoved] == geometry[numUnmoved].ptr)
+      numUnmoved++;
+
+    std::vector<bool> refinalize(geometry.size(), true);
+    for (size_t i = 0; i < numUnmoved; i++)
+      refinalize[i] = geometry[i]->changedSince(lastSceneTime);
+
+    // geometries which can update their embree geometry in place (e.g.
+    // by refitting) are neither detached nor finalized again
+    size_t numRefitted = 0;
+    for (size_t i = 0; i < numUnmoved; i++) {
+      if (refinalize[i] && geometry[i]->refit(this)) {
+        refinalize[i] = false;
+        numRefitted++;
+      }
+    }
+
+    for (size_t i = 0; i < attachedGeometry.size(); i++) {
+      if (i >= numUnmoved || refinalize[i])
+        rtcDetachGeometry(embreeSceneHandle, i);
+    }
+
+    // in case finalizing throws, the next commit starts from scratch
+    attachedGeometry.clear();
 
+    // the geometries are finalized in parallel, attachGeometry keeps the
+    // embree geomID == index in 'geometry'
+    std::vector<size_t> toFinalize;
     for (size_t i = 0; i < geometry.size(); i++) {
-       postStatusMsg(2)
-           << "=======================================================\n"
-           << "Finalizing geometry " << i;
+      geometryIDs[geometry[i].ptr] = i;
+      if (refinalize[i])
+        toFinalize.push_back(i);
+    }
+
+    tasking::parallel_for(toFinalize.size(), [&](size_t n) {
+      const size_t i = toFinalize[n];
+      postStatusMsg(2)
+          << "=======================================================\n"
+          << "Finalizing geometry " << i;
 
       geometry[i]->finalize(this);
+    });
+
+    geometryIDs.clear();
+
+    // per geometry BVH quality, only relevant for two-level BVHs
+    for (size_t i : toFinalize) {
+      const std::string quality = geometry[i]->getParamString("buildQuality");
+      if (!quality.empty()) {
+        RTCGeometry embreeGeom = rtcGetGeometry(embreeSceneHandle, i);
+        rtcSetGeometryBuildQuality(embreeGeom, buildQualityForString(quality));
+        rtcCommitGeometry(embreeGeom);
+      }
+    }
+
+    bounds = empty;
 
+    for (size_t i = 0; i < geometry.size(); i++) {
       bounds.extend(geometry[i]->bounds);
       ispc::Model_setGeometry(getIE(), i, geometry[i]->getIE());
     }
@@ -97,8 +242,141 @@ namespace ospray {
     }
 
     ispc::Model_setBounds(getIE(), (ispc::box3f*)&bounds);
+    ispc::Model_setRobustOffset(getIE(), robustOffset);
+    commitClipping();
+
+    {
+      OSPRAY_PROFILE_ZONE("BVH build");
+      api::ISPCDevice::embreeMemoryBudgetExceeded = false;
+      try {
+        rtcCommitScene(embreeSceneHandle);
+      } catch (const std::runtime_error &) {
+        // the build was cancelled by the memory budget, retry once with a
+        // compact BVH; the geometries are not attached, thus the scene and
+        // all geometries get finalized again
+        if (!api::ISPCDevice::embreeMemoryBudgetExceeded
+            || useEmbreeCompactSceneFlag)
+          throw;
+        postStatusMsg(1) << "#osp: BVH of " << toString() << " exceeds the "
+                         << "memoryBudget, falling back to a compact BVH";
+        compactForMemoryBudget = true;
+        commit();
+        return;
+      }
+    }
+
+    lodGeometries.clear();
+    containsInstances = false;
+    for (auto &g : geometry) {
+      attachedGeometry.push_back(g.ptr);
+      Instance *instance = dynamic_cast<Instance *>(g.ptr);
+      // instance arrays trace into their model just like nested instances
+      containsInstances = containsInstances || instance
+                          || dynamic_cast<InstanceArray *>(g.ptr);
+      if (g->hasLOD())
+        lodGeometries.push_back(g.ptr);
+    }
+
+    const int64_t embreeMemory = api::ISPCDevice::embreeMemoryUsed;
+    postStatusMsg(1) << "#osp: model committed in "
+                     << (getSysTime() - commitStart) * 1000.0 << " ms ("
+                     << toFinalize.size() << " of " << geometry.size()
+                     << " geometries finalized, " << numRefitted
+                     << " refitted), embree now uses "
+                     << embreeMemory / (1024.0 * 1024.0) << " MB ("
+                     << (embreeMemory - embreeMemoryStart) / (1024.0 * 1024.0)
+                     << " MB change)";
+
+    // embree reports its memory only per device, thus the change during
+    // the commit is attributed to this model (approximate with models
+    // committed concurrently)
+    const int64_t sceneBytes = std::max(int64_t(0), getMemoryUsage().bytes
+                                        + embreeMemory - embreeMemoryStart);
+    setMemoryUsage(OSP_MEMORY_MODEL, sceneBytes, sceneBytes);
+  }
+
+  void Model::commitClipping()
+  {
+    // copies, the data may be released after the commit
+    auto read = [&](const char *name, OSPDataType type, size_t itemsPerObject,
+                    size_t &numObjects) {
+      Data *data = getParamData(name);
+      numObjects = 0;
+      if (!data)
+        return std::vector<vec4f>();
+      if (data->type != type || !data->compact()
+          || data->numItems % itemsPerObject != 0) {
+        throw std::runtime_error(std::string("model '") + name + "' must be "
+                                 "compact " + stringForType(type) + " data");
+      }
+      numObjects = data->numItems / itemsPerObject;
+      std::vector<vec4f> items(data->numItems);
+      for (size_t i = 0; i < data->numItems; i++) {
+        items[i] = type == OSP_FLOAT4 ? ((const vec4f *)data->data)[i]
+                                      : vec4f(((const vec3f *)data->data)[i], 0.f);
+      }
+      return items;
+    };
+
+    size_t numPlanes, numBoxes, numSpheres;
+    clipPlanes  = read("clipPlanes", OSP_FLOAT4, 1, numPlanes);
+    clipSpheres = read("clipSpheres", OSP_FLOAT4, 1, numSpheres);
+    const std::vector<vec4f> boxes = read("clipBoxes", OSP_FLOAT3, 2, numBoxes);
+    clipBoxes.resize(numBoxes);
+    for (size_t i = 0; i < numBoxes; i++) {
+      clipBoxes[i] = box3f(vec3f(boxes[2 * i].x, boxes[2 * i].y,
+                                 boxes[2 * i].z),
+                           vec3f(boxes[2 * i + 1].x, boxes[2 * i + 1].y,
+                                 boxes[2 * i + 1].z));
+    }
+
+    if (numPlanes + numBoxes + numSpheres > maxClipObjects) {
+      throw std::runtime_error("a model can have at most "
+                               + std::to_string(maxClipObjects)
+                               + " clip planes, boxes and spheres");
+    }
+
+    ispc::Model_setClipping(getIE(),
+                            numPlanes,
+                            (const ispc::vec4f *)clipPlanes.data(),
+                            numBoxes,
+                            (const ispc::box3f *)clipBoxes.data(),
+                            numSpheres,
+                            (const ispc::vec4f *)clipSpheres.data());
+  }
+
+  void Model::selectLOD(const vec3f &eye)
+  {
+    if (lodGeometries.empty())
+      return;
+
+    // the geometries modify distinct embree geometries
+    std::vector<uint8_t> changed(lodGeometries.size(), 0);
+    tasking::parallel_for(lodGeometries.size(), [&](size_t i) {
+      changed[i] = lodGeometries[i]->selectLOD(this, eye);
+    });
+
+    if (std::find(changed.begin(), changed.end(), 1) != changed.end())
+      rtcCommitScene(embreeSceneHandle);
+  }
+
+  void Model::traceRays(const OSPTraceRay *rays,
+                        size_t count,
+                        OSPTraceHit *hits,
+                        uint32 flags)
+  {
+    assert(getIE());
 
-    rtcCommitScene(embreeSceneHandle);
+    const size_t numTasks = divRoundUp(count, traceBatchSize);
+    tasking::parallel_for(numTasks, [&](size_t taskID) {
+      const size_t begin = taskID * traceBatchSize;
+      const size_t n     = std::min(begin + traceBatchSize, count) - begin;
+      ispc::Model_traceRays(getIE(),
+                            (const ispc::TraceRay *)rays + begin,
+                            n,
+                            (ispc::TraceHit *)hits + begin,
+                            flags);
+    });
   }
 
 } // ::ospray
@@ -21,6 +21,8 @@
 #include "volume/Volume.h"
 
 // stl
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 // embree
@@ -28,6 +30,11 @@
 
 namespace ospray {
 
+  /*! \brief parses the "buildQuality" parameter of models and geometries:
+      "low", "medium", "high", or (for geometries only) "refit" */
+  OSPRAY_SDK_INTERFACE
+  RTCBuildQuality buildQualityForString(const std::string &s);
+
   /*! \brief Base Abstraction for an OSPRay 'Model' entity
 
     A 'model' is the generalization of a 'scene' in embree: it is a
@@ -44,6 +51,32 @@ namespace ospray {
     virtual std::string toString() const override;
     virtual void commit() override;
 
+    /*! \brief the geometries and volumes, besides the parameters */
+    virtual void getDependencies(std::vector<ManagedObject *> &dependencies)
+        override;
+
+    /*! \brief commit the (never committed) models instanced by the
+        geometries, before these are finalized in parallel */
+    virtual void commitLazyDependencies() override;
+
+    /*! \brief attaches the embree geometry of 'geom' (being finalized)
+        to the scene, with the geomID being the index of 'geom' in
+        'geometry'; this is thread-safe, geometries are finalized in
+        parallel. returns the geomID */
+    uint32 attachGeometry(const Geometry *geom, RTCGeometry embreeGeom);
+
+    /*! \brief switch the geometries with levels of detail to the level
+        for a camera at 'eye', committing the scene again if any level
+        changed; called before each frame */
+    void selectLOD(const vec3f &eye);
+
+    /*! \brief trace 'count' arbitrary rays against the committed model,
+        in parallel streams of rays, see ospTraceRays */
+    void traceRays(const OSPTraceRay *rays,
+                   size_t count,
+                   OSPTraceHit *hits,
+                   uint32 flags);
+
     // Data members //
 
     using GeometryVector = std::vector<Ref<Geometry>>;
@@ -61,6 +94,44 @@ namespace ospray {
     bool useEmbreeDynamicSceneFlag{true};
     bool useEmbreeCompactSceneFlag{false};
     bool useEmbreeRobustSceneFlag{false};
+    /*! \brief set once a BVH build exceeded the memory budget, the model
+        then always uses a compact BVH */
+    bool compactForMemoryBudget{false};
+    //! \brief BVH quality of the scene, parameter "buildQuality"
+    RTCBuildQuality buildQuality{RTC_BUILD_QUALITY_MEDIUM};
+
+    //! \brief whether 'geometry' contains instances (set by commit)
+    bool containsInstances {false};
+
+    //! \brief when the embree scene was last (re)built by commit
+    utility::TimeStamp sceneTime;
+
+    /*! \brief guards the volume updates to this model by instances of
+        it, which get finalized in parallel */
+    std::mutex instanceMutex;
+
+  private:
+
+    /*! the geometries attached to the embree scene by the last commit,
+        the embree geomID of each is its index; a following commit only
+        re-finalizes the geometries that changed since then */
+    std::vector<Geometry *> attachedGeometry;
+    int embreeSceneFlags {-1};
+    RTCBuildQuality embreeSceneQuality {RTC_BUILD_QUALITY_MEDIUM};
+    //! index of each geometry in 'geometry', only valid during commit
+    std::unordered_map<const Geometry *, uint32> geometryIDs;
+    //! the geometries (in 'geometry') with levels of detail
+    std::vector<Geometry *> lodGeometries;
+
+    /*! reads the clip objects ("clipPlanes", "clipBoxes" and
+        "clipSpheres"), whose union is removed from the geometry */
+    void commitClipping();
+
+    //! same as MODEL_MAX_CLIP_OBJECTS in Model.ih
+    static constexpr size_t maxClipObjects = 16;
+    std::vector<vec4f> clipPlanes;
+    std::vector<box3f> clipBoxes;
+    std::vector<vec4f> clipSpheres;
   };
 
 } // ::ospray
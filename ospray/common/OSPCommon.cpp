@@ -16,8 +16,11 @@
 
 #include "OSPCommon.h"
 #include "api/Device.h"
+#include "ospcommon/utility/getEnvVar.h"
 
+#include <algorithm>
 #include <map>
+#include <mutex>
 
 namespace ospray {
 
@@ -33,6 +36,12 @@ namespace ospray {
     return alignedFree(ptr);
   }
 
+  extern "C" void *malloc64Large(size_t size)
+  {
+    return alignedMalloc(size, 64,
+                         memory::ALLOC_HUGE_PAGES | memory::ALLOC_FIRST_TOUCH);
+  }
+
   WarnOnce::WarnOnce(const std::string &s, uint32_t postAtLogLevel)
     : s(s)
   {
@@ -166,6 +175,7 @@ namespace ospray {
     case OSP_ULONG2:    return sizeof(vec2ul);
     case OSP_ULONG3:    return sizeof(vec3ul);
     case OSP_ULONG4:    return sizeof(vec4ul);
+    case OSP_HALF:      return sizeof(uint16);
     case OSP_FLOAT:     return sizeof(float);
     case OSP_FLOAT2:    return sizeof(vec2f);
     case OSP_FLOAT3:    return sizeof(vec3f);
@@ -190,6 +200,7 @@ namespace ospray {
     if (strcmp(string, "float2") == 0) return(OSP_FLOAT2);
     if (strcmp(string, "float3") == 0) return(OSP_FLOAT3);
     if (strcmp(string, "float4") == 0) return(OSP_FLOAT4);
+    if (strcmp(string, "half"  ) == 0) return(OSP_HALF);
     if (strcmp(string, "int"   ) == 0) return(OSP_INT);
     if (strcmp(string, "int2"  ) == 0) return(OSP_INT2);
     if (strcmp(string, "int3"  ) == 0) return(OSP_INT3);
@@ -249,6 +260,7 @@ namespace ospray {
     case OSP_ULONG2:            return "ulong2";
     case OSP_ULONG3:            return "ulong3";
     case OSP_ULONG4:            return "ulong4";
+    case OSP_HALF:              return "half";
     case OSP_FLOAT:             return "float";
     case OSP_FLOAT2:            return "float2";
     case OSP_FLOAT3:            return "float3";
@@ -278,6 +290,12 @@ namespace ospray {
       case OSP_TEXTURE_RA8:
       case OSP_TEXTURE_LA8:            return sizeof(vec2uc);
       case OSP_TEXTURE_R32F:           return sizeof(float);
+      case OSP_TEXTURE_BC1:
+      case OSP_TEXTURE_BC1_SRGB:
+      case OSP_TEXTURE_BC4:            return 8;
+      case OSP_TEXTURE_BC5:
+      case OSP_TEXTURE_BC7:
+      case OSP_TEXTURE_BC7_SRGB:       return 16;
       case OSP_TEXTURE_FORMAT_INVALID: break;
     }
 
@@ -287,13 +305,28 @@ namespace ospray {
     throw std::runtime_error(error.str());
   }
 
+  size_t sizeOf(const OSPTextureFormat type, const vec2i &size)
+  {
+    if (isBlockCompressed(type))
+      return sizeOf(type) * size_t((size.x + 3) / 4) * ((size.y + 3) / 4);
+    return sizeOf(type) * size_t(size.x) * size.y;
+  }
+
+  bool isBlockCompressed(const OSPTextureFormat type)
+  {
+    return type >= OSP_TEXTURE_BC1 && type <= OSP_TEXTURE_BC7_SRGB;
+  }
+
   uint32_t logLevel()
   {
     return ospray::api::Device::current->logLevel;
   }
 
-  OSPError loadLocalModule(const std::string &name)
+  OSPError loadLocalModule(const std::string &_name)
   {
+    // the ISPC device may be replaced by a build for another ISPC target
+    const std::string name = _name == "ispc" ? ispcModuleName() : _name;
+
     std::string libName = "ospray_module_" + name;
     loadLibrary(libName);
 
@@ -318,6 +351,20 @@ namespace ospray {
     return OSP_NO_ERROR;
   }
 
+  std::string ispcModuleName()
+  {
+    auto OSPRAY_ISPC_DEVICE =
+      utility::getEnvVar<std::string>("OSPRAY_ISPC_DEVICE");
+
+    if (!OSPRAY_ISPC_DEVICE || OSPRAY_ISPC_DEVICE.value().empty())
+      return "ispc";
+
+    // accept the ISPC target name as well, e.g. "avx512skx-i32x8"
+    std::string variant = OSPRAY_ISPC_DEVICE.value();
+    std::replace(variant.begin(), variant.end(), '-', '_');
+    return "ispc_" + variant;
+  }
+
   StatusMsgStream postStatusMsg(uint32_t postAtLogLevel)
   {
     return StatusMsgStream(postAtLogLevel);
@@ -334,6 +381,33 @@ namespace ospray {
       ospray::api::Device::current->msg_fcn((msg + '\n').c_str());
   }
 
+  static std::mutex initPhasesMutex;
+  static std::vector<std::pair<std::string, double>> initPhases;
+  static bool initPhasesReported = false;
+
+  void recordInitPhase(const std::string &phase, const double seconds)
+  {
+    std::lock_guard<std::mutex> lock(initPhasesMutex);
+    if (!initPhasesReported)
+      initPhases.emplace_back(phase, seconds);
+  }
+
+  void reportInitPhases(const double timeToFirstFrame)
+  {
+    std::lock_guard<std::mutex> lock(initPhasesMutex);
+    if (initPhasesReported)
+      return;
+    initPhasesReported = true;
+
+    auto msg = postStatusMsg(1);
+    msg << "#osp:init: first frame completed " << timeToFirstFrame * 1e3
+        << "ms after ospInit";
+    for (const auto &phase : initPhases)
+      msg << "\n#osp:init:   " << phase.first << ": " << phase.second * 1e3
+          << "ms";
+    initPhases.clear();
+  }
+
   void handleError(OSPError e, const std::string &message)
   {
     if (api::deviceIsSet()) {
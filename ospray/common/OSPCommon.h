@@ -136,6 +136,9 @@ namespace ospray {
     OSPRAY_CORE_INTERFACE void *malloc64(size_t size);
     /*! 64-bit malloc. allows for alloc'ing memory larger than 4GB */
     OSPRAY_CORE_INTERFACE void free64(void *ptr);
+    /*! malloc64() for multi-GB arrays: huge pages and zeroed in parallel
+        (first touch), see memory::AllocationFlags; free with free64() */
+    OSPRAY_CORE_INTERFACE void *malloc64Large(size_t size);
   }
 
   /*! Convert a type string to an OSPDataType. */
@@ -150,11 +153,23 @@ namespace ospray {
   /*! size of OSPDataType */
   OSPRAY_CORE_INTERFACE size_t sizeOf(const OSPDataType);
 
-  /*! size of OSPTextureFormat */
+  /*! size of OSPTextureFormat, i.e., of a texel or of a 4x4 texel block
+      for the block-compressed formats */
   OSPRAY_CORE_INTERFACE size_t sizeOf(const OSPTextureFormat);
 
+  /*! size of an image of the given OSPTextureFormat */
+  OSPRAY_CORE_INTERFACE size_t sizeOf(const OSPTextureFormat, const vec2i &size);
+
+  /*! whether OSPTextureFormat is block-compressed */
+  OSPRAY_CORE_INTERFACE bool isBlockCompressed(const OSPTextureFormat);
+
   OSPRAY_CORE_INTERFACE OSPError loadLocalModule(const std::string &name);
 
+  /*! name of the module providing the ISPC device: "ispc", or the variant
+      "ispc_<target>" built for another ISPC target (see the CMake option
+      OSPRAY_ISPC_DEVICE_VARIANTS) selected with OSPRAY_ISPC_DEVICE */
+  OSPRAY_CORE_INTERFACE std::string ispcModuleName();
+
   /*! little helper class that prints out a warning string upon the
     first time it is encountered.
 
@@ -215,6 +230,17 @@ namespace ospray {
 
   OSPRAY_CORE_INTERFACE StatusMsgStream postStatusMsg(uint32_t postAtLogLevel = 0);
 
+  /*! records the duration (in seconds) of a phase of the initialization,
+      e.g. loading modules or creating the Embree device; thread-safe, as
+      independent phases may run concurrently */
+  OSPRAY_CORE_INTERFACE void recordInitPhase(const std::string &phase,
+                                             const double seconds);
+
+  /*! posts the recorded init phases and the time from ospInit to the
+      completion of the first frame at log level 1, once; phases recorded
+      later on are ignored */
+  OSPRAY_CORE_INTERFACE void reportInitPhases(const double timeToFirstFrame);
+
   /////////////////////////////////////////////////////////////////////////////
 
   OSPRAY_CORE_INTERFACE void handleError(OSPError e, const std::string &message);
@@ -15,34 +15,105 @@
 // ======================================================================== //
 
 #include "ObjectHandle.h"
-#include <map>
+#include <atomic>
+#include <mutex>
 #include <stack>
+#include <vector>
 
 namespace ospray {
 
-  static std::map<int64, ospray::ManagedObject *> objectByHandle;
+  /*! the slots are allocated in chunks which never move once allocated,
+      such that readers don't need to lock while the table grows */
+  static constexpr int   slotChunkBits = 12;
+  static constexpr int64 slotChunkSize = int64(1) << slotChunkBits;
+  static constexpr int64 maxSlotChunks = (int64(1) << 31) / slotChunkSize;
+
+  struct HandleSlot
+  {
+    //! the full handle currently assigned to this slot, 0 if none
+    std::atomic<int64> handle;
+    std::atomic<ManagedObject *> object;
+  };
+
+  static std::atomic<HandleSlot *> slotChunks[maxSlotChunks];
+
+  //! one past the highest ID assigned so far, bounds the scans
+  static std::atomic<int64> slotsInUse(0);
+
+  //! serializes assign/free/allocation, lookups do not take it
+  static std::mutex handleMutex;
+
   static std::stack<int64> freedHandles;
 
+  //! generation of each handed out ID, -1 once freed (catches double frees)
+  static std::vector<int32> liveGenerations;
+
   //! next unassigned ID on this node
   /*! we start numbering with 1 to make sure that "0:0" is an
     invalid handle (so we can typecast between (64-bit) handles
     and (64-bit)OSPWhatEver pointers */
   static int32 nextFreeLocalID = 1;
 
+  //! the slot of the given ID, nullptr if its chunk was never allocated
+  static inline HandleSlot *findSlot(int32 ID)
+  {
+    const uint32 index = ID;
+    if (index >= maxSlotChunks * slotChunkSize)
+      return nullptr;
+
+    HandleSlot *chunk =
+        slotChunks[index >> slotChunkBits].load(std::memory_order_acquire);
+    return chunk ? &chunk[index & (slotChunkSize - 1)] : nullptr;
+  }
+
+  //! the slot of the given ID, allocates its chunk if needed (under lock)
+  static HandleSlot &getSlot(int32 ID)
+  {
+    HandleSlot *slot = findSlot(ID);
+    if (slot)
+      return *slot;
+
+    const uint32 index = ID;
+    if (index >= maxSlotChunks * slotChunkSize)
+      throw std::runtime_error("invalid object handle ID " +
+                               std::to_string(ID));
+
+    HandleSlot *chunk = new HandleSlot[slotChunkSize];
+    for (int64 i = 0; i < slotChunkSize; ++i) {
+      chunk[i].handle.store(0, std::memory_order_relaxed);
+      chunk[i].object.store(nullptr, std::memory_order_relaxed);
+    }
+    slotChunks[index >> slotChunkBits].store(chunk, std::memory_order_release);
+    return chunk[index & (slotChunkSize - 1)];
+  }
+
   void ObjectHandle::free()
   {
-    freedHandles.push((int64) * this);
+    std::lock_guard<std::mutex> lock(handleMutex);
+    const size_t ID = uint32(i32.ID);
+    if (i64 == 0 || ID >= liveGenerations.size() ||
+        liveGenerations[ID] != i32.generation)
+      return;
+
+    liveGenerations[ID] = -1;
+
+    ObjectHandle next(i64);
+    next.i32.generation = (i32.generation + 1) & 0x7fffffff;
+    freedHandles.push(next);
   }
 
   ObjectHandle::ObjectHandle()
   {
+    std::lock_guard<std::mutex> lock(handleMutex);
     if (freedHandles.empty()) {
-      i32.ID    = nextFreeLocalID++;
-      i32.owner = 0;
+      i32.ID         = nextFreeLocalID++;
+      i32.generation = 0;
+      liveGenerations.resize(i32.ID + 1, -1);
     } else {
       i64 = freedHandles.top();
       freedHandles.pop();
     }
+    liveGenerations[i32.ID] = i32.generation;
   }
 
   ObjectHandle::ObjectHandle(int64 i) : i64(i) {}
@@ -58,24 +129,66 @@ namespace ospray {
   /*! define the given handle to refer to given object */
   void ObjectHandle::assign(const ObjectHandle &handle, ManagedObject *object)
   {
-    objectByHandle[handle] = object;
+    handle.assign(object);
   }
 
   void ObjectHandle::assign(ManagedObject *object) const
   {
-    objectByHandle[i64] = object;
+    std::lock_guard<std::mutex> lock(handleMutex);
+    HandleSlot &slot = getSlot(i32.ID);
+    slot.object.store(object, std::memory_order_relaxed);
+    slot.handle.store(i64, std::memory_order_release);
+
+    const int64 used = int64(uint32(i32.ID)) + 1;
+    if (used > slotsInUse.load(std::memory_order_relaxed))
+      slotsInUse.store(used, std::memory_order_relaxed);
   }
 
   void ObjectHandle::freeObject() const
   {
-    auto it = objectByHandle.find(i64);
-    it->second->refDec();
-    objectByHandle.erase(it);
+    ManagedObject *object = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(handleMutex);
+      HandleSlot *slot = findSlot(i32.ID);
+      if (!slot || slot->handle.load(std::memory_order_relaxed) != i64)
+        return;
+      object = slot->object.load(std::memory_order_relaxed);
+      slot->handle.store(0, std::memory_order_release);
+      slot->object.store(nullptr, std::memory_order_relaxed);
+    }
+    // outside the lock, the destructor may free handles itself
+    object->refDec();
+  }
+
+  void ObjectHandle::freeAll()
+  {
+    // the destructors of the objects may look up handles themselves
+    std::vector<ManagedObject *> objects;
+    {
+      std::lock_guard<std::mutex> lock(handleMutex);
+      const int64 numSlots = slotsInUse.load(std::memory_order_relaxed);
+      for (int64 i = 0; i < numSlots; ++i) {
+        HandleSlot *slot = findSlot(i);
+        if (!slot || slot->handle.load(std::memory_order_relaxed) == 0)
+          continue;
+        objects.push_back(slot->object.load(std::memory_order_relaxed));
+        slot->handle.store(0, std::memory_order_release);
+        slot->object.store(nullptr, std::memory_order_relaxed);
+      }
+
+      slotsInUse.store(0, std::memory_order_relaxed);
+      freedHandles = std::stack<int64>();
+      liveGenerations.clear();
+      nextFreeLocalID = 1;
+    }
+
+    for (auto *object : objects)
+      object->refDec();
   }
 
-  int32 ObjectHandle::ownerRank() const
+  int32 ObjectHandle::generation() const
   {
-    return i32.owner;
+    return i32.generation;
   }
 
   int32 ObjectHandle::objID() const
@@ -90,7 +203,9 @@ namespace ospray {
 
   bool ObjectHandle::defined() const
   {
-    return objectByHandle.find(i64) != objectByHandle.end();
+    const HandleSlot *slot = findSlot(i32.ID);
+    return slot && i64 != 0 &&
+           slot->handle.load(std::memory_order_acquire) == i64;
   }
 
   ManagedObject *ObjectHandle::lookup() const
@@ -98,8 +213,8 @@ namespace ospray {
     if (i64 == 0)
       return nullptr;
 
-    auto it = objectByHandle.find(i64);
-    if (it == objectByHandle.end()) {
+    const HandleSlot *slot = findSlot(i32.ID);
+    if (!slot || slot->handle.load(std::memory_order_acquire) != i64) {
 #ifndef NDEBUG
       // iw - made this into a warning only; the original code had
       // this throw an actual exceptoin, but that may be overkill
@@ -110,14 +225,19 @@ namespace ospray {
       return nullptr;
     }
 
-    return it->second;
+    return slot->object.load(std::memory_order_relaxed);
   }
 
   ObjectHandle ObjectHandle::lookup(ManagedObject *object)
   {
-    for (auto it = objectByHandle.begin(); it != objectByHandle.end(); it++) {
-      if (it->second == object)
-        return (ObjectHandle(it->first));
+    const int64 numSlots = slotsInUse.load(std::memory_order_relaxed);
+    for (int64 i = 0; i < numSlots; ++i) {
+      const HandleSlot *slot = findSlot(i);
+      if (slot && slot->object.load(std::memory_order_relaxed) == object) {
+        const int64 handle = slot->handle.load(std::memory_order_acquire);
+        if (handle != 0)
+          return ObjectHandle(handle);
+      }
     }
 
     return (nullHandle);
@@ -37,9 +37,15 @@ namespace ospray {
     to test the handled resturend from ospNewXXX calls for null just
     as if they were pointers (and thus, 'null' objects are
     consistent between local and mpi rendering)
+
+    the ID is the index of the handle's slot in a dense table, the
+    generation gets bumped whenever a freed ID is handed out again, such
+    that stale handles are not mistaken for the new object in that slot.
+    lookup() and defined() are lock-free.
   */
   union OSPRAY_SDK_INTERFACE ObjectHandle
   {
+    /*! return the handle's ID for reuse by a later ObjectHandle() */
     void free();
 
     ObjectHandle();
@@ -64,7 +70,11 @@ namespace ospray {
 
     void freeObject() const;
 
-    int32 ownerRank() const;
+    /*! release the objects of all handles and start numbering the handles
+        anew, e.g. when a worker serves the next application */
+    static void freeAll();
+
+    int32 generation() const;
     int32 objID() const;
 
     /*! cast to int64 to allow fast operations with this type */
@@ -75,7 +85,7 @@ namespace ospray {
     struct
     {
       int32 ID;
-      int32 owner;
+      int32 generation;
     } i32;
 
     int64 i64;
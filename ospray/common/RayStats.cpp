@@ -0,0 +1,79 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "RayStats.h"
+// std
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ospray {
+
+  //! the counters of one thread, only ever written by that thread
+  struct ThreadRayCounters
+  {
+    std::atomic<int64_t> rays[RAY_TYPE_COUNT];
+
+    ThreadRayCounters()
+    {
+      for (auto &r : rays)
+        r.store(0, std::memory_order_relaxed);
+    }
+  };
+
+  //! all threads' counters, kept after thread exit to keep the totals
+  static std::mutex countersMutex;
+  static std::vector<std::unique_ptr<ThreadRayCounters>> allCounters;
+
+  static ThreadRayCounters *registerThread()
+  {
+    std::lock_guard<std::mutex> lock(countersMutex);
+    allCounters.emplace_back(new ThreadRayCounters);
+    return allCounters.back().get();
+  }
+
+  static thread_local ThreadRayCounters *threadCounters {nullptr};
+
+  void RayStats::count(RayType type, int64_t n)
+  {
+    if (!threadCounters)
+      threadCounters = registerThread();
+
+    // only this thread writes, a plain (relaxed) load and store suffices
+    auto &counter = threadCounters->rays[type];
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+
+  RayStats::Counts RayStats::total()
+  {
+    Counts counts;
+    std::lock_guard<std::mutex> lock(countersMutex);
+    for (auto &counters : allCounters) {
+      for (int t = 0; t < RAY_TYPE_COUNT; t++)
+        counts.rays[t] += counters->rays[t].load(std::memory_order_relaxed);
+    }
+    return counts;
+  }
+
+  extern "C" void ospray_RayStats_count(int32 type, int32 n)
+  {
+    RayStats::count(RayType(type), n);
+  }
+
+} // ::ospray
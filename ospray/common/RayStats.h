@@ -0,0 +1,61 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "common/OSPCommon.h"
+
+namespace ospray {
+
+  //! the kinds of rays counted, keep in sync with RayStats.ih
+  enum RayType
+  {
+    RAY_PRIMARY,   //!< camera rays
+    RAY_SECONDARY, //!< bounces of paths, and continuations through
+                   //!< transparent surfaces
+    RAY_SHADOW,    //!< towards lights
+    RAY_AO,        //!< ambient occlusion
+    RAY_TYPE_COUNT
+  };
+
+  /*! \brief counts the rays traced by the renderers
+
+    Each thread increments counters of its own, thus counting needs
+    neither locks nor atomic read-modify-write operations. The counters
+    are never reset: the rays of a frame are the difference of the
+    totals summed over all threads at the begin and the end of the frame
+    (see FrameBuffer::beginFrame and FrameBuffer::recordFrameTime), thus
+    with frames in flight at the same time (ospRenderFrameAsync) each
+    frame counts the rays of the others traced in the meantime.
+
+    ISPC code counts via countRays() (see RayStats.ih).
+   */
+  struct OSPRAY_SDK_INTERFACE RayStats
+  {
+    struct Counts
+    {
+      int64_t rays[RAY_TYPE_COUNT] {};
+    };
+
+    //! counts 'n' rays of 'type' traced by the calling thread
+    static void count(RayType type, int64_t n);
+
+    //! sums the counters of all threads
+    static Counts total();
+  };
+
+} // ::ospray
@@ -16,6 +16,10 @@
 
 #include "FrameBuffer.h"
 #include "FrameBuffer_ispc.h"
+#include "ospcommon/sysinfo.h"
+// std
+#include <cmath>
+#include <cstring>
 
 namespace ospray {
 
@@ -31,10 +35,15 @@ namespace ospray {
       hasVarianceBuffer(channels & OSP_FB_VARIANCE && channels & OSP_FB_ACCUM),
       hasNormalBuffer(channels & OSP_FB_NORMAL),
       hasAlbedoBuffer(channels & OSP_FB_ALBEDO),
-      frameID(-1)
+      hasGeometryIDBuffer(channels & OSP_FB_GEOMETRY_ID),
+      hasPrimitiveIDBuffer(channels & OSP_FB_PRIMITIVE_ID),
+      hasInstanceIDBuffer(channels & OSP_FB_INSTANCE_ID),
+      frameID(-1),
+      renderRegion(vec2i(0), numTiles)
   {
     managedObjectType = OSP_FRAMEBUFFER;
     Assert(size.x > 0 && size.y > 0);
+    std::memset(&frameStats, 0, sizeof(frameStats));
   }
 
   vec2i FrameBuffer::getTileSize() const
@@ -52,6 +61,84 @@ namespace ospray {
     return numTiles.x * numTiles.y;
   }
 
+  uint32 FrameBuffer::getTileChannels() const
+  {
+    return (hasDepthBuffer ? OSP_FB_DEPTH : 0)
+      | (hasNormalBuffer ? OSP_FB_NORMAL : 0)
+      | (hasAlbedoBuffer ? OSP_FB_ALBEDO : 0)
+      | (hasGeometryIDBuffer ? OSP_FB_GEOMETRY_ID : 0)
+      | (hasPrimitiveIDBuffer ? OSP_FB_PRIMITIVE_ID : 0)
+      | (hasInstanceIDBuffer ? OSP_FB_INSTANCE_ID : 0);
+  }
+
+  void FrameBuffer::commit()
+  {
+    // the region of interest is given in pixels, and extended to full tiles
+    const vec2i start = getParam<vec2i>("regionStart", vec2i(0));
+    const vec2i end   = getParam<vec2i>("regionEnd", size);
+    renderRegion.lower = clamp(start / getTileSize(), vec2i(0), numTiles);
+    renderRegion.upper = clamp(divRoundUp(end, getTileSize()),
+                               renderRegion.lower, numTiles);
+
+    priority = getParam1i("priority", 0);
+
+    // shared (i.e. zero-copy) data can be updated every frame without
+    // another commit
+    maxDepthData = getParamData("maxDepth", nullptr);
+    if (maxDepthData && (maxDepthData->type != OSP_FLOAT
+          || maxDepthData->numItems != size_t(size.x) * size.y)) {
+      static WarnOnce warning("the maxDepth data array of the framebuffer "
+                              "needs to be of type OSP_FLOAT and have one "
+                              "entry per pixel, ignoring it");
+      maxDepthData = nullptr;
+    }
+
+    if (getIE())
+      ispc::FrameBuffer_setMaxDepth(getIE(), (float *)getMaxDepth());
+  }
+
+  const float *FrameBuffer::getMaxDepth() const
+  {
+    return maxDepthData ? (const float *)maxDepthData->data : nullptr;
+  }
+
+  box2i FrameBuffer::getRenderRegion() const
+  {
+    return renderRegion;
+  }
+
+  bool FrameBuffer::tileInRenderRegion(const vec2i &tileID) const
+  {
+    return tileID.x >= renderRegion.lower.x && tileID.x < renderRegion.upper.x
+      && tileID.y >= renderRegion.lower.y && tileID.y < renderRegion.upper.y;
+  }
+
+  int FrameBuffer::tileNUMANode(const vec2i &tileID) const
+  {
+    return tileID.y * getNumberOfNUMANodes() / numTiles.y;
+  }
+
+  void FrameBuffer::distributeOverNUMANodes(void *buffer,
+                                            const size_t pixelBytes) const
+  {
+    const int numNodes = getNumberOfNUMANodes();
+    if (!buffer || numNodes < 2)
+      return;
+
+    const size_t rowBytes = size.x * pixelBytes;
+    int beginRow = 0;
+    for (int node = 0; node < numNodes; node++) {
+      // first tile row of the next node, see tileNUMANode
+      const int nextTileRow = divRoundUp((node + 1) * numTiles.y, numNodes);
+      const int endRow = std::min(nextTileRow * TILE_SIZE, size.y);
+      if (endRow > beginRow) {
+        memory::bindToNUMANode((uint8 *)buffer + beginRow * rowBytes,
+                               (endRow - beginRow) * rowBytes, node);
+      }
+      beginRow = endRow;
+    }
+  }
+
   vec2i FrameBuffer::getNumPixels() const
   {
     return size;
@@ -60,7 +147,90 @@ namespace ospray {
   void FrameBuffer::beginFrame()
   {
     frameID++;
+    frameProgress = 0.f;
     ispc::FrameBuffer_set_frameID(getIE(), frameID);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    std::memset(&frameStats, 0, sizeof(frameStats));
+    raysAtBeginFrame = RayStats::total();
+  }
+
+  void FrameBuffer::cancelFrame()
+  {
+    cancelRender = true;
+  }
+
+  void FrameBuffer::clearCancel()
+  {
+    cancelRender = false;
+  }
+
+  bool FrameBuffer::frameCancelled() const
+  {
+    return cancelRender;
+  }
+
+  void FrameBuffer::reportProgress(const float newValue)
+  {
+    frameProgress = clamp(newValue, 0.f, 1.f);
+  }
+
+  float FrameBuffer::getCurrentProgress() const
+  {
+    return frameProgress;
+  }
+
+  OSPFrameStats FrameBuffer::getFrameStats() const
+  {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return frameStats;
+  }
+
+  void FrameBuffer::recordTile(const double renderTime, const int64_t samples)
+  {
+    // bin i holds [2^(i-17), 2^(i-16)) seconds, see OSPFrameStats
+    int exponent = -16;
+    if (renderTime > 0.0)
+      std::frexp(renderTime, &exponent);
+    const int bin = clamp(exponent + 16, 0, OSP_FRAME_STATS_TILE_BINS - 1);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    frameStats.tileTimeMin = frameStats.tilesRendered == 0 ? renderTime
+      : std::min(frameStats.tileTimeMin, renderTime);
+    frameStats.tileTimeMax = std::max(frameStats.tileTimeMax, renderTime);
+    frameStats.tileTimeSum += renderTime;
+    frameStats.tilesRendered++;
+    frameStats.samples += samples;
+    frameStats.tileTimeHistogram[bin]++;
+  }
+
+  void FrameBuffer::recordSkippedTile()
+  {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    frameStats.tilesSkipped++;
+  }
+
+  void FrameBuffer::recordPixelOpTime(const double seconds)
+  {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    frameStats.pixelOpTime += seconds;
+  }
+
+  void FrameBuffer::recordFrameTime(const double frameTime,
+                                    const double endFrameTime)
+  {
+    const RayStats::Counts rays = RayStats::total();
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    frameStats.frameTime = frameTime;
+    frameStats.endFrameTime = endFrameTime;
+    auto frameRays = [&](RayType type) {
+      return rays.rays[type] - raysAtBeginFrame.rays[type];
+    };
+    frameStats.primaryRays   = frameRays(RAY_PRIMARY);
+    frameStats.secondaryRays = frameRays(RAY_SECONDARY);
+    frameStats.shadowRays    = frameRays(RAY_SHADOW);
+    frameStats.aoRays        = frameRays(RAY_AO);
   }
 
   std::string FrameBuffer::toString() const
@@ -18,8 +18,13 @@
 
 // ospray
 #include "common/Managed.h"
+#include "common/Data.h"
+#include "common/RayStats.h"
 #include "ospray/ospray.h"
 #include "fb/PixelOp.h"
+// std
+#include <atomic>
+#include <mutex>
 
 namespace ospray {
 
@@ -43,6 +48,8 @@ namespace ospray {
     /*! \brief clear (the specified channels of) this frame buffer */
     virtual void clear(const uint32 fbChannelFlags) = 0;
 
+    virtual void commit() override;
+
     //! get number of pixels per tile, in x and y direction
     vec2i getTileSize() const;
 
@@ -51,9 +58,30 @@ namespace ospray {
 
     int getTotalTiles() const;
 
+    /*! the optional planes (OSP_FB_DEPTH/NORMAL/ALBEDO) tiles rendered
+        into this frame buffer need to carry, see Tile::channels */
+    virtual uint32 getTileChannels() const;
+
+    /*! the (tile-aligned) region of interest to render, in tiles; tiles
+        outside of it are skipped and keep their previous content */
+    box2i getRenderRegion() const;
+    bool tileInRenderRegion(const vec2i &tileID) const;
+
     //! get number of pixels in x and y diretion
     vec2i getNumPixels() const;
 
+    /*! on NUMA systems the frame buffer is split into horizontal bands of
+        tile rows, one per node; returns the node owning the tile's memory */
+    int tileNUMANode(const vec2i &tileID) const;
+
+    /*! place the bands of the given (size.x*size.y pixels, row-major)
+        buffer on the NUMA nodes owning them */
+    void distributeOverNUMANodes(void *buffer, const size_t pixelBytes) const;
+
+    /*! the optional per-pixel maximum ray distance ("maxDepth", e.g. the
+        depth buffer of a rasterizer to composite with), nullptr if none */
+    const float *getMaxDepth() const;
+
     /*! how often has been accumulated into that tile
         Note that it is up to the application to properly
         reset the accumulationIDs (using ospClearAccum(fb)) if anything
@@ -66,6 +94,27 @@ namespace ospray {
     //! returns error of frame
     virtual float endFrame(const float errorThreshold) = 0;
 
+    /*! \brief request the frame currently rendered into this frame
+        buffer to stop early (see ospCancel), polled by the load
+        balancers together with the user's progress callback */
+    virtual void cancelFrame();
+    void clearCancel();
+    bool frameCancelled() const;
+
+    //! set/get the progress of the current frame, in [0..1]
+    void reportProgress(const float newValue);
+    float getCurrentProgress() const;
+
+    //! statistics of the last frame, see ospGetFrameStats
+    /*! reset by beginFrame, the record* functions are thread-safe and
+        get called by the load balancers and the frame buffers;
+        recordFrameTime ends the frame and also takes its ray counts */
+    OSPFrameStats getFrameStats() const;
+    void recordTile(const double renderTime, const int64_t samples);
+    void recordSkippedTile();
+    void recordPixelOpTime(const double seconds);
+    void recordFrameTime(const double frameTime, const double endFrameTime);
+
     //! \brief common function to help printf-debugging
     /*! \detailed Every derived class should override this! */
     virtual std::string toString() const override;
@@ -86,11 +135,38 @@ namespace ospray {
     bool hasVarianceBuffer;
     bool hasNormalBuffer;
     bool hasAlbedoBuffer;
+    //! the IDs of the primary hit, see OSP_FB_GEOMETRY_ID
+    bool hasGeometryIDBuffer;
+    bool hasPrimitiveIDBuffer;
+    bool hasInstanceIDBuffer;
 
     //! This marks the global number of frames that have been rendered since
     //! the last ospFramebufferClear() has been called.
     int32 frameID;
 
     Ref<PixelOp::Instance> pixelOp;
+
+    /*! frames rendered concurrently into different frame buffers with a
+        higher priority get their tiles rendered first (parameter
+        'priority', default 0) */
+    int32 priority {0};
+
+    /*! state of the LocalTiledLoadBalancer: the order in which the tiles
+        are handed out, and one frame at a time */
+    std::vector<int> tileOrder;
+    vec2i orderedNumTiles {0};
+    std::mutex renderMutex;
+
+  private:
+
+    box2i renderRegion;
+    Ref<Data> maxDepthData;
+
+    mutable std::mutex statsMutex;
+    OSPFrameStats frameStats;
+    RayStats::Counts raysAtBeginFrame;
+
+    std::atomic<bool> cancelRender {false};
+    std::atomic<float> frameProgress {0.f};
   };
 } // ::ospray
@@ -17,9 +17,19 @@
 //ospray
 #include "LocalFB.h"
 #include "LocalFB_ispc.h"
+#include "FrameBuffer_ispc.h"
+// std
+#include <algorithm>
 
 namespace ospray {
 
+  //! the buffers are large and swept every frame, prefer huge pages for them
+  template <typename T>
+  static T *allocateBuffer(size_t numElements)
+  {
+    return (T*)alignedMalloc(numElements * sizeof(T), 64, ALLOC_HUGE_PAGES);
+  }
+
   LocalFrameBuffer::LocalFrameBuffer(const vec2i &size,
                                      ColorBufferFormat colorBufferFormat,
                                      const uint32 channels,
@@ -29,42 +39,32 @@ namespace ospray {
   {
     Assert(size.x > 0);
     Assert(size.y > 0);
-    if (colorBufferToUse)
-      colorBuffer = colorBufferToUse;
-    else {
-      switch (colorBufferFormat) {
-      case OSP_FB_NONE:
-        colorBuffer = nullptr;
-        break;
-      case OSP_FB_RGBA8:
-      case OSP_FB_SRGBA:
-        colorBuffer = (uint32*)alignedMalloc(sizeof(uint32)*size.x*size.y);
-        break;
-      case OSP_FB_RGBA32F:
-        colorBuffer = (vec4f*)alignedMalloc(sizeof(vec4f)*size.x*size.y);
-        break;
-      }
-    }
+    ownsColorBuffer = !colorBufferToUse;
+    checkMemoryBudget(memoryBytes(1, halfPrecisionAccum));
+    colorBuffer = colorBufferToUse ? colorBufferToUse : allocateColorBuffer();
+    colorBuffers.push_back(colorBuffer);
+    colorBufferMapCount.push_back(0);
 
-    depthBuffer = hasDepthBuffer ? alignedMalloc<float>(size.x*size.y) :
+    depthBuffer = hasDepthBuffer ? allocateBuffer<float>(size.x*size.y) :
       nullptr;
+    distributeOverNUMANodes(depthBuffer, sizeof(float));
 
-    accumBuffer = hasAccumBuffer ? alignedMalloc<vec4f>(size.x*size.y) :
-      nullptr;
+    // not accumulated, but written like the depth buffer
+    auto idBuffer = [&](bool present) {
+      int32 *buffer = present ? allocateBuffer<int32>(size.x*size.y) : nullptr;
+      if (buffer)
+        std::fill(buffer, buffer + size.x*size.y, -1);
+      return buffer;
+    };
+    geomIDBuffer = idBuffer(hasGeometryIDBuffer);
+    primIDBuffer = idBuffer(hasPrimitiveIDBuffer);
+    instIDBuffer = idBuffer(hasInstanceIDBuffer);
 
     const size_t bytes = sizeof(int32)*getTotalTiles();
     tileAccumID = (int32*)alignedMalloc(bytes);
     memset(tileAccumID, 0, bytes);
 
-    varianceBuffer = hasVarianceBuffer ? alignedMalloc<vec4f>(size.x*size.y) :
-      nullptr;
-
-    normalBuffer = hasNormalBuffer ? alignedMalloc<vec3f>(size.x*size.y) :
-      nullptr;
-
-    albedoBuffer = hasAlbedoBuffer ? alignedMalloc<vec3f>(size.x*size.y) :
-      nullptr;
-
+    allocateAccumBuffers();
 
     ispcEquivalent = ispc::LocalFrameBuffer_create(this,size.x,size.y,
                                                    colorBufferFormat,
@@ -74,18 +74,204 @@ namespace ospray {
                                                    varianceBuffer,
                                                    normalBuffer,
                                                    albedoBuffer,
+                                                   pixelError,
                                                    tileAccumID);
+    ispc::LocalFrameBuffer_setIDBuffers(getIE(), geomIDBuffer, primIDBuffer,
+                                        instIDBuffer);
+    updateMemoryUsage();
   }
 
   LocalFrameBuffer::~LocalFrameBuffer()
   {
     alignedFree(depthBuffer);
-    alignedFree(colorBuffer);
+    alignedFree(geomIDBuffer);
+    alignedFree(primIDBuffer);
+    alignedFree(instIDBuffer);
+    if (ownsColorBuffer) {
+      for (auto *b : colorBuffers)
+        alignedFree(b);
+    }
+    freeAccumBuffers();
+    alignedFree(tileAccumID);
+    for (auto *b : mappedHalfBuffers)
+      alignedFree(b);
+  }
+
+  void *LocalFrameBuffer::allocateColorBuffer() const
+  {
+    void *buffer = nullptr;
+    switch (colorBufferFormat) {
+    case OSP_FB_RGBA8:
+    case OSP_FB_SRGBA:
+      buffer = allocateBuffer<uint32>(size.x*size.y);
+      distributeOverNUMANodes(buffer, sizeof(uint32));
+      break;
+    case OSP_FB_RGBA32F:
+      buffer = allocateBuffer<vec4f>(size.x*size.y);
+      distributeOverNUMANodes(buffer, sizeof(vec4f));
+      break;
+    default:
+      break;
+    }
+    return buffer;
+  }
+
+  void LocalFrameBuffer::setColorBufferCount(const int32 count)
+  {
+    std::lock_guard<std::mutex> lock(colorBufferMutex);
+    checkMemoryBudget(memoryBytes(count, halfPrecisionAccum));
+
+    // the last completed frame is kept (as front buffer)
+    void *front = colorBuffers[frontBuffer];
+    for (auto *b : colorBuffers) {
+      if (b != front)
+        alignedFree(b);
+    }
+
+    colorBuffers.assign(1, front);
+    for (int32 i = 1; i < count; i++)
+      colorBuffers.push_back(allocateColorBuffer());
+    colorBufferMapCount.assign(count, 0);
+
+    frontBuffer = 0;
+    backBuffer = count > 1 ? 1 : 0;
+    colorBuffer = colorBuffers[backBuffer];
+    ispc::LocalFrameBuffer_setColorBuffer(getIE(), colorBuffer);
+
+    tileWrittenFrame.assign(count > 1 ? getTotalTiles() : 0, -1);
+    updateMemoryUsage();
+  }
+
+  void LocalFrameBuffer::swapColorBuffers()
+  {
+    std::lock_guard<std::mutex> lock(colorBufferMutex);
+
+    // tiles which were not rendered this frame (converged or outside of
+    // the render region) still need the content of the previous frame
+    const size_t pixelBytes = colorBufferFormat == OSP_FB_RGBA32F ?
+      sizeof(vec4f) : sizeof(uint32);
+    const uint8 *src = (const uint8 *)colorBuffers[frontBuffer];
+    uint8 *dst = (uint8 *)colorBuffers[backBuffer];
+    for (int32 ty = 0; ty < numTiles.y; ty++) {
+      for (int32 tx = 0; tx < numTiles.x; tx++) {
+        if (tileWrittenFrame[ty * numTiles.x + tx] == frameID)
+          continue;
+        const vec2i lower = vec2i(tx, ty) * TILE_SIZE;
+        const vec2i upper = min(lower + TILE_SIZE, size);
+        const size_t rowBytes = (upper.x - lower.x) * pixelBytes;
+        for (int32 y = lower.y; y < upper.y; y++) {
+          const size_t ofs = (size_t(y) * size.x + lower.x) * pixelBytes;
+          memcpy(dst + ofs, src + ofs, rowBytes);
+        }
+      }
+    }
+
+    frontBuffer = backBuffer;
+
+    // render next into the least recently completed buffer that is not
+    // currently mapped by the application; if all are mapped, the
+    // oldest one gets overwritten
+    const size_t count = colorBuffers.size();
+    backBuffer = (frontBuffer + 1) % count;
+    for (size_t i = 1; i < count; i++) {
+      const size_t b = (frontBuffer + i) % count;
+      if (colorBufferMapCount[b] == 0) {
+        backBuffer = b;
+        break;
+      }
+    }
+
+    colorBuffer = colorBuffers[backBuffer];
+    ispc::LocalFrameBuffer_setColorBuffer(getIE(), colorBuffer);
+  }
+
+  void LocalFrameBuffer::allocateAccumBuffers()
+  {
+    const size_t numPixels = size.x*size.y;
+    if (halfPrecisionAccum) {
+      accumBufferHalf = hasAccumBuffer ?
+        allocateBuffer<uint16>(4*numPixels) : nullptr;
+      varianceBufferHalf = hasVarianceBuffer ?
+        allocateBuffer<uint16>(4*numPixels) : nullptr;
+      normalBufferHalf = hasNormalBuffer ?
+        allocateBuffer<uint16>(3*numPixels) : nullptr;
+      albedoBufferHalf = hasAlbedoBuffer ?
+        allocateBuffer<uint16>(3*numPixels) : nullptr;
+    } else {
+      accumBuffer = hasAccumBuffer ? allocateBuffer<vec4f>(numPixels) :
+        nullptr;
+      varianceBuffer = hasVarianceBuffer ? allocateBuffer<vec4f>(numPixels) :
+        nullptr;
+      normalBuffer = hasNormalBuffer ? allocateBuffer<vec3f>(numPixels) :
+        nullptr;
+      albedoBuffer = hasAlbedoBuffer ? allocateBuffer<vec3f>(numPixels) :
+        nullptr;
+      pixelError = hasVarianceBuffer ? allocateBuffer<float>(numPixels) :
+        nullptr;
+    }
+
+    // the tiles get written by threads on the NUMA node owning them
+    distributeOverNUMANodes(accumBufferHalf, 4*sizeof(uint16));
+    distributeOverNUMANodes(varianceBufferHalf, 4*sizeof(uint16));
+    distributeOverNUMANodes(normalBufferHalf, 3*sizeof(uint16));
+    distributeOverNUMANodes(albedoBufferHalf, 3*sizeof(uint16));
+    distributeOverNUMANodes(accumBuffer, sizeof(vec4f));
+    distributeOverNUMANodes(varianceBuffer, sizeof(vec4f));
+    distributeOverNUMANodes(normalBuffer, sizeof(vec3f));
+    distributeOverNUMANodes(albedoBuffer, sizeof(vec3f));
+    distributeOverNUMANodes(pixelError, sizeof(float));
+    resetPixelError();
+  }
+
+  void LocalFrameBuffer::resetPixelError()
+  {
+    if (pixelError)
+      std::fill(pixelError, pixelError + size.x*size.y, inf);
+  }
+
+  int64_t LocalFrameBuffer::memoryBytes(size_t numColorBuffers,
+                                        bool half) const
+  {
+    const size_t numPixels = size.x*size.y;
+    size_t pixelBytes = hasDepthBuffer ? sizeof(float) : 0;
+    pixelBytes += sizeof(int32) * (hasGeometryIDBuffer + hasPrimitiveIDBuffer
+                                   + hasInstanceIDBuffer);
+    if (ownsColorBuffer && colorBufferFormat != OSP_FB_NONE) {
+      pixelBytes += numColorBuffers * (colorBufferFormat == OSP_FB_RGBA32F ?
+                                       sizeof(vec4f) : sizeof(uint32));
+    }
+    const size_t channelBytes = half ? sizeof(uint16) : sizeof(float);
+    pixelBytes += channelBytes * (4*hasAccumBuffer + 4*hasVarianceBuffer +
+                                  3*hasNormalBuffer + 3*hasAlbedoBuffer);
+    // the pixel error is only kept at full precision
+    if (hasVarianceBuffer && !half)
+      pixelBytes += sizeof(float);
+
+    return numPixels * pixelBytes + sizeof(int32)*getTotalTiles();
+  }
+
+  void LocalFrameBuffer::updateMemoryUsage()
+  {
+    setMemoryUsage(OSP_MEMORY_FRAMEBUFFER,
+                   memoryBytes(colorBuffers.size(), halfPrecisionAccum));
+  }
+
+  void LocalFrameBuffer::freeAccumBuffers()
+  {
     alignedFree(accumBuffer);
     alignedFree(varianceBuffer);
     alignedFree(normalBuffer);
     alignedFree(albedoBuffer);
-    alignedFree(tileAccumID);
+    alignedFree(accumBufferHalf);
+    alignedFree(varianceBufferHalf);
+    alignedFree(normalBufferHalf);
+    alignedFree(albedoBufferHalf);
+    alignedFree(pixelError);
+    accumBuffer = varianceBuffer = nullptr;
+    pixelError = nullptr;
+    normalBuffer = albedoBuffer = nullptr;
+    accumBufferHalf = varianceBufferHalf = nullptr;
+    normalBufferHalf = albedoBufferHalf = nullptr;
   }
 
   std::string LocalFrameBuffer::toString() const
@@ -93,6 +279,42 @@ namespace ospray {
     return "ospray::LocalFrameBuffer";
   }
 
+  void LocalFrameBuffer::commit()
+  {
+    FrameBuffer::commit();
+
+    const int32 numColorBuffers = std::max(1, getParam1i("colorBufferCount", 1));
+    if (numColorBuffers != int32(colorBuffers.size())) {
+      if (!ownsColorBuffer || !colorBuffer) {
+        static WarnOnce warning("colorBufferCount is ignored for frame "
+                                "buffers without an own color buffer");
+      } else {
+        setColorBufferCount(numColorBuffers);
+      }
+    }
+
+    const bool half = getParam1i("halfPrecisionAccum", 0);
+    if (half == halfPrecisionAccum)
+      return;
+
+    checkMemoryBudget(memoryBytes(colorBuffers.size(), half));
+
+    // switching the precision discards the accumulated samples
+    halfPrecisionAccum = half;
+    freeAccumBuffers();
+    allocateAccumBuffers();
+    clear(OSP_FB_ACCUM);
+
+    ispc::LocalFrameBuffer_setAccumBuffers(getIE(),
+                                           accumBuffer,
+                                           varianceBuffer,
+                                           normalBuffer,
+                                           albedoBuffer,
+                                           pixelError);
+    ispc::FrameBuffer_setPixelError(getIE(), nullptr, 0.f);
+    updateMemoryUsage();
+  }
+
   void LocalFrameBuffer::clear(const uint32 fbChannelFlags)
   {
     frameID = -1; // we increment at the start of the frame
@@ -102,46 +324,115 @@ namespace ospray {
       // LocalFrameBuffer_accumulateTile takes care of clearing the
       // accumulating buffers
       memset(tileAccumID, 0, getTotalTiles()*sizeof(int32));
+      std::fill(tileWrittenFrame.begin(), tileWrittenFrame.end(), -1);
 
       // always also clear error buffer (if present)
       if (hasVarianceBuffer) {
         tileErrorRegion.clear();
+        resetPixelError();
       }
     }
   }
 
   void LocalFrameBuffer::setTile(Tile &tile)
   {
-    if (pixelOp)
+    if (!tileWrittenFrame.empty()) {
+      const vec2i tileID = tile.region.lower/TILE_SIZE;
+      tileWrittenFrame[tileID.y * numTiles.x + tileID.x] = frameID;
+    }
+    if (pixelOp) {
+      const double pixelOpStart = getSysTime();
       pixelOp->preAccum(tile);
-    if (accumBuffer) {
-      const float err = ispc::LocalFrameBuffer_accumulateTile(getIE(),(ispc::Tile&)tile);
-      if ((tile.accumID & 1) == 1)
-        tileErrorRegion.update(tile.region.lower/TILE_SIZE, err);
+      recordPixelOpTime(getSysTime() - pixelOpStart);
     }
-    if (hasAlbedoBuffer)
-      ispc::LocalFrameBuffer_accumulateAuxTile(getIE(),(ispc::Tile&)tile,
-          (ispc::vec3f*)albedoBuffer, tile.ar, tile.ag, tile.ab);
-    if (hasNormalBuffer)
-      ispc::LocalFrameBuffer_accumulateAuxTile(getIE(),(ispc::Tile&)tile,
-          (ispc::vec3f*)normalBuffer, tile.nx, tile.ny, tile.nz);
-    if (pixelOp)
-      pixelOp->postAccum(tile);
-    if (colorBuffer) {
+    if (halfPrecisionAccum) {
+      if (accumBufferHalf) {
+        const float err =
+          ispc::LocalFrameBuffer_accumulateTileHalf(getIE(),(ispc::Tile&)tile,
+              accumBufferHalf, varianceBufferHalf);
+        if ((tile.accumID & 1) == 1)
+          tileErrorRegion.update(tile.region.lower/TILE_SIZE, err);
+      }
+      if (hasAlbedoBuffer)
+        ispc::LocalFrameBuffer_accumulateAuxTileHalf(getIE(),(ispc::Tile&)tile,
+            albedoBufferHalf, tile.ar, tile.ag, tile.ab);
+      if (hasNormalBuffer)
+        ispc::LocalFrameBuffer_accumulateAuxTileHalf(getIE(),(ispc::Tile&)tile,
+            normalBufferHalf, tile.nx, tile.ny, tile.nz);
+    } else if (accumBuffer && colorBuffer && colorOpsFused) {
+      // single sweep: accumulate, apply the color ops of the pixel op,
+      // and convert into the color buffer
+      float err = inf;
       switch (colorBufferFormat) {
       case OSP_FB_RGBA8:
-        ispc::LocalFrameBuffer_writeTile_RGBA8(getIE(),(ispc::Tile&)tile);
+        err = ispc::LocalFrameBuffer_accumulateWriteTile_RGBA8(getIE(),
+            (ispc::Tile&)tile, colorOps.data(), colorOps.size());
         break;
       case OSP_FB_SRGBA:
-        ispc::LocalFrameBuffer_writeTile_SRGBA(getIE(),(ispc::Tile&)tile);
+        err = ispc::LocalFrameBuffer_accumulateWriteTile_SRGBA(getIE(),
+            (ispc::Tile&)tile, colorOps.data(), colorOps.size());
         break;
       case OSP_FB_RGBA32F:
-        ispc::LocalFrameBuffer_writeTile_RGBA32F(getIE(),(ispc::Tile&)tile);
+        err = ispc::LocalFrameBuffer_accumulateWriteTile_RGBA32F(getIE(),
+            (ispc::Tile&)tile, colorOps.data(), colorOps.size());
         break;
       default:
         NOTIMPLEMENTED;
       }
+      if ((tile.accumID & 1) == 1)
+        tileErrorRegion.update(tile.region.lower/TILE_SIZE, err);
+
+      accumulateAuxTiles(tile);
+      return;
+    } else {
+      if (accumBuffer) {
+        const float err = ispc::LocalFrameBuffer_accumulateTile(getIE(),(ispc::Tile&)tile);
+        if ((tile.accumID & 1) == 1)
+          tileErrorRegion.update(tile.region.lower/TILE_SIZE, err);
+      }
+      accumulateAuxTiles(tile);
     }
+    if (pixelOp && !colorOpsFused) {
+      const double pixelOpStart = getSysTime();
+      pixelOp->postAccum(tile);
+      recordPixelOpTime(getSysTime() - pixelOpStart);
+    }
+    writeColorTile(tile);
+  }
+
+  void LocalFrameBuffer::writeColorTile(Tile &tile)
+  {
+    if (!colorBuffer)
+      return;
+
+    void **ops = colorOpsFused ? colorOps.data() : nullptr;
+    const int32 numOps = colorOpsFused ? colorOps.size() : 0;
+    switch (colorBufferFormat) {
+    case OSP_FB_RGBA8:
+      ispc::LocalFrameBuffer_writeTile_RGBA8(getIE(),(ispc::Tile&)tile,
+          ops, numOps);
+      break;
+    case OSP_FB_SRGBA:
+      ispc::LocalFrameBuffer_writeTile_SRGBA(getIE(),(ispc::Tile&)tile,
+          ops, numOps);
+      break;
+    case OSP_FB_RGBA32F:
+      ispc::LocalFrameBuffer_writeTile_RGBA32F(getIE(),(ispc::Tile&)tile,
+          ops, numOps);
+      break;
+    default:
+      NOTIMPLEMENTED;
+    }
+  }
+
+  void LocalFrameBuffer::accumulateAuxTiles(Tile &tile)
+  {
+    if (hasAlbedoBuffer)
+      ispc::LocalFrameBuffer_accumulateAuxTile(getIE(),(ispc::Tile&)tile,
+          (ispc::vec3f*)albedoBuffer, tile.ar, tile.ag, tile.ab);
+    if (hasNormalBuffer)
+      ispc::LocalFrameBuffer_accumulateAuxTile(getIE(),(ispc::Tile&)tile,
+          (ispc::vec3f*)normalBuffer, tile.nx, tile.ny, tile.nz);
   }
 
   int32 LocalFrameBuffer::accumID(const vec2i &tile)
@@ -159,12 +450,26 @@ namespace ospray {
     FrameBuffer::beginFrame();
     if (pixelOp)
       pixelOp->beginFrame();
+
+    // pixel ops that are pure per-pixel color transforms are applied
+    // while writing the color buffer, instead of in another pass
+    colorOps.clear();
+    colorOpsFused = !pixelOp || pixelOp->getColorOps(colorOps);
   }
 
   float LocalFrameBuffer::endFrame(const float errorThreshold)
   {
-    if (pixelOp)
+    // pixel ops may still rewrite the back buffer here (see writeColorTile)
+    if (pixelOp) {
+      const double pixelOpStart = getSysTime();
       pixelOp->endFrame();
+      recordPixelOpTime(getSysTime() - pixelOpStart);
+    }
+    if (colorBuffers.size() > 1)
+      swapColorBuffers();
+    // the pixels of the next frame converged with the same threshold
+    ispc::FrameBuffer_setPixelError(getIE(),
+        errorThreshold > 0.f ? pixelError : nullptr, errorThreshold);
     return tileErrorRegion.refine(errorThreshold);
   }
 
@@ -172,26 +477,73 @@ namespace ospray {
   {
     const void *buf;
     switch (channel) {
-      case OSP_FB_COLOR: buf = colorBuffer; break;
+      case OSP_FB_COLOR: buf = mapColorBuffer(); break;
       case OSP_FB_DEPTH: buf = depthBuffer; break;
       case OSP_FB_NORMAL: buf = normalBuffer; break;
       case OSP_FB_ALBEDO: buf = albedoBuffer; break;
+      case OSP_FB_GEOMETRY_ID: buf = geomIDBuffer; break;
+      case OSP_FB_PRIMITIVE_ID: buf = primIDBuffer; break;
+      case OSP_FB_INSTANCE_ID: buf = instIDBuffer; break;
       default: buf = nullptr; break;
     }
 
+    // half-precision channels are mapped as a float copy
+    const uint16 *half = nullptr;
+    if (channel == OSP_FB_NORMAL)
+      half = normalBufferHalf;
+    if (channel == OSP_FB_ALBEDO)
+      half = albedoBufferHalf;
+    if (half) {
+      const size_t numPixels = size.x*size.y;
+      vec3f *copy = alignedMalloc<vec3f>(numPixels);
+      ispc::LocalFrameBuffer_halfToFloat(half, (float*)copy, 3*numPixels);
+      mappedHalfBuffers.push_back(copy);
+      buf = copy;
+    }
+
     if (buf)
       this->refInc();
 
     return buf;
   }
 
+  const void *LocalFrameBuffer::mapColorBuffer()
+  {
+    // the front buffer, i.e. the last completed frame
+    std::lock_guard<std::mutex> lock(colorBufferMutex);
+    colorBufferMapCount[frontBuffer]++;
+    return colorBuffers[frontBuffer];
+  }
+
   void LocalFrameBuffer::unmap(const void *mappedMem)
   {
+    auto copy = std::find(mappedHalfBuffers.begin(), mappedHalfBuffers.end(),
+                          mappedMem);
+    if (copy != mappedHalfBuffers.end()) {
+      alignedFree(*copy);
+      mappedHalfBuffers.erase(copy);
+      this->refDec();
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(colorBufferMutex);
+      auto color = std::find(colorBuffers.begin(), colorBuffers.end(),
+                             mappedMem);
+      if (mappedMem && color != colorBuffers.end()) {
+        colorBufferMapCount[color - colorBuffers.begin()]--;
+        this->refDec();
+        return;
+      }
+    }
+
     if (mappedMem) {
-      if (mappedMem != colorBuffer
-          && mappedMem != depthBuffer
+      if (mappedMem != depthBuffer
           && mappedMem != normalBuffer
-          && mappedMem != albedoBuffer)
+          && mappedMem != albedoBuffer
+          && mappedMem != geomIDBuffer
+          && mappedMem != primIDBuffer
+          && mappedMem != instIDBuffer)
       {
         throw std::runtime_error("ERROR: unmapping a pointer not created by "
             "OSPRay!");
@@ -27,15 +27,28 @@ namespace ospray {
   {
     void      *colorBuffer; /*!< format depends on
                                FrameBuffer::colorBufferFormat, may be
-                               NULL */
+                               NULL; the (back) buffer rendered into */
     float     *depthBuffer; /*!< one float per pixel, may be NULL */
     vec4f     *accumBuffer; /*!< one RGBA per pixel, may be NULL */
     vec4f     *varianceBuffer; /*!< one RGBA per pixel, may be NULL, accumulates every other sample, for variance estimation / stopping */
     vec3f     *normalBuffer; /*!< accumulated world-space normal per pixel, may be NULL */
     vec3f     *albedoBuffer; /*!< accumulated, one RGB per pixel, may be NULL */
+    int32     *geomIDBuffer; /*!< geometry ID of the primary hit per pixel, may be NULL */
+    int32     *primIDBuffer; /*!< primitive ID of the primary hit per pixel, may be NULL */
+    int32     *instIDBuffer; /*!< instance ID of the primary hit per pixel, may be NULL */
     int32     *tileAccumID; //< holds accumID per tile, for adaptive accumulation
+    float     *pixelError {nullptr}; /*!< error per pixel, with the (float) variance buffer; the renderer skips the pixels which converged */
     TileError  tileErrorRegion; /*!< holds error per tile and adaptive regions, for variance estimation / stopping */
 
+    /*! if enabled (parameter "halfPrecisionAccum"), the accumulating
+        buffers are stored as FP16 in the *Half buffers below, and the
+        respective float buffers above are NULL */
+    bool       halfPrecisionAccum {false};
+    uint16    *accumBufferHalf {nullptr}; /*!< RGBA halfs per pixel, running mean */
+    uint16    *varianceBufferHalf {nullptr}; /*!< RGBA halfs per pixel, running mean */
+    uint16    *normalBufferHalf {nullptr}; /*!< XYZ halfs per pixel, running mean */
+    uint16    *albedoBufferHalf {nullptr}; /*!< RGB halfs per pixel, running mean */
+
     LocalFrameBuffer(const vec2i &size,
                      ColorBufferFormat colorBufferFormat,
                      const uint32 channels,
@@ -45,6 +58,7 @@ namespace ospray {
     //! \brief common function to help printf-debugging
     /*! \detailed Every derived class should override this! */
     virtual std::string toString() const override;
+    virtual void commit() override;
 
     void setTile(Tile &tile) override;
     int32 accumID(const vec2i &tile) override;
@@ -55,6 +69,48 @@ namespace ospray {
     const void *mapBuffer(OSPFrameBufferChannel channel) override;
     void unmap(const void *mappedMem) override;
     void clear(const uint32 fbChannelFlags) override;
+
+    /*! converts the (accumulated and post-processed) colors of the tile
+        into the back color buffer, without accumulating; pixel ops which
+        replace the colors of the whole frame (e.g. a denoiser) use this
+        in their endFrame, before the back buffer gets swapped */
+    void writeColorTile(Tile &tile);
+
+  private:
+    void *allocateColorBuffer() const;
+    void setColorBufferCount(const int32 count);
+    void swapColorBuffers();
+    const void *mapColorBuffer();
+    void allocateAccumBuffers();
+    void resetPixelError();
+    void freeAccumBuffers();
+    /*! the memory of the buffers with 'numColorBuffers' color buffers and
+        'half' precision accumulation */
+    int64_t memoryBytes(size_t numColorBuffers, bool half) const;
+    void updateMemoryUsage();
+    void accumulateAuxTiles(Tile &tile);
+
+    /*! float copies handed out by mapBuffer for half-precision channels */
+    std::vector<vec3f *> mappedHalfBuffers;
+
+    /*! ISPC color ops of the pixel op, applied while writing the color
+        buffer; only valid if the whole pixel op can be fused */
+    std::vector<void *> colorOps;
+    bool colorOpsFused {true};
+
+    /*! swap chain of (parameter "colorBufferCount") color buffers:
+        frames are rendered into the back buffer, which becomes the
+        front buffer returned by mapBuffer in endFrame, thus the
+        application can read the last frame while the next one renders */
+    std::vector<void *> colorBuffers;
+    std::vector<int32> colorBufferMapCount;
+    size_t frontBuffer {0};
+    size_t backBuffer {0};
+    bool ownsColorBuffer {true};
+    /*! frameID in which each tile was last written into the back buffer,
+        only tracked with more than one color buffer */
+    std::vector<int32> tileWrittenFrame;
+    std::mutex colorBufferMutex;
   };
 
 } // ::ospray
@@ -19,6 +19,8 @@
 // ospray
 #include "fb/Tile.h"
 #include "common/Managed.h"
+// std
+#include <vector>
 
 namespace ospray {
 
@@ -68,6 +70,25 @@ namespace ospray {
           into the color buffer */
       virtual void postAccum(Tile &tile) { UNUSED(tile); }
 
+      /*! appends the per-pixel color transforms of this op (and of the
+          ops it is chained to) to 'ops', in the order they need to be
+          applied; these are the ISPC-side PixelOp_ColorOp objects (see
+          PixelOp.ih), which the frame buffer then fuses into its single
+          sweep accumulating and writing a tile, instead of calling
+          postAccum. returns false if the op cannot be fused, then
+          postAccum gets called as usual */
+      virtual bool getColorOps(std::vector<void *> &ops) const
+      { UNUSED(ops); return false; }
+
+      /*! statistics this op gathered from the tiles of the frame (e.g., a
+          histogram), as counts which add up over tiles; a distributed
+          frame buffer sums them over all ranks and hands the sums back
+          with setFrameStatistics, before calling endFrame. empty if the op
+          (and the ops it is chained to) gather none */
+      virtual std::vector<uint32> getFrameStatistics() const { return {}; }
+      virtual void setFrameStatistics(const std::vector<uint32> &stats)
+      { UNUSED(stats); }
+
       //! \brief common function to help printf-debugging
       /*! Every derived class should override this! */
       virtual std::string toString() const;
@@ -32,10 +32,11 @@ namespace ospray {
 
       note that a tile contains "all" of the values a renderer might
       want to use. not all renderers nor all frame buffers will use
-      all those values; it's up to the renderer and frame buffer to
-      agree on which fields will be set. Similarly, the frame buffer
-      may actually use uchars, but the tile will always store
-      floats. */
+      all those values; 'channels' tells which of the optional planes
+      (depth, normal, albedo, IDs) are set by renderers, and only those get
+      read by frame buffers and shipped between ranks. Color is always
+      set. Similarly, the frame buffer may actually use uchars, but the
+      tile will always store floats. */
   struct OSPRAY_SDK_INTERFACE __aligned(64) Tile
   {
     region2i region; // screen region that this corresponds to
@@ -45,7 +46,9 @@ namespace ospray {
     int32    children;
     int32    sortOrder;
     int32    accumID; //!< how often has been accumulated into this tile
-    float    pad[4]; //!< padding to match the ISPC-side layout
+    uint32   channels; //!< OSP_FB_DEPTH|NORMAL|ALBEDO|*_ID planes which are set
+    int32    shadingRate; //!< log2 of the pixel decimation, see Renderer::tileShadingRate
+    float    pad[2]; //!< padding to match the ISPC-side layout
     float    r[TILE_SIZE*TILE_SIZE];  // 'red' component
     float    g[TILE_SIZE*TILE_SIZE];  // 'green' component
     float    b[TILE_SIZE*TILE_SIZE];  // 'blue' component
@@ -57,14 +60,25 @@ namespace ospray {
     float    ar[TILE_SIZE*TILE_SIZE]; // albedo red
     float    ag[TILE_SIZE*TILE_SIZE]; // albedo green
     float    ab[TILE_SIZE*TILE_SIZE]; // albedo blue
+    int32    geomID[TILE_SIZE*TILE_SIZE]; // of the primary hit, -1 if none
+    int32    primID[TILE_SIZE*TILE_SIZE];
+    int32    instID[TILE_SIZE*TILE_SIZE];
+
+    //! all optional planes, i.e. what a tile carries if not told otherwise
+    static constexpr uint32 allChannels
+      = OSP_FB_DEPTH | OSP_FB_NORMAL | OSP_FB_ALBEDO
+      | OSP_FB_GEOMETRY_ID | OSP_FB_PRIMITIVE_ID | OSP_FB_INSTANCE_ID;
 
     Tile() = default;
-    Tile(const vec2i &tile, const vec2i &fbsize, const int32 accumId)
+    Tile(const vec2i &tile, const vec2i &fbsize, const int32 accumId,
+         const uint32 channels = allChannels)
       : fbSize(fbsize),
         rcp_fbSize(rcp(vec2f(fbsize))),
         generation(0),
         children(0),
-        accumID(accumId)
+        accumID(accumId),
+        channels(channels & allChannels),
+        shadingRate(0)
     {
       region.lower = tile * TILE_SIZE;
       region.upper = ospcommon::min(region.lower + TILE_SIZE, fbsize);
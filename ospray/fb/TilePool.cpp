@@ -0,0 +1,59 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "TilePool.h"
+// std
+#include <type_traits>
+#include <vector>
+
+namespace ospray {
+
+  struct FreeTiles
+  {
+    ~FreeTiles()
+    {
+      for (auto *mem : tiles)
+        alignedFree(mem);
+    }
+
+    std::vector<void*> tiles;
+  };
+
+  static thread_local FreeTiles freeTiles;
+
+  void *TilePool::allocate()
+  {
+    auto &tiles = freeTiles.tiles;
+    if (tiles.empty())
+      return alignedMalloc(sizeof(Tile), 64);
+
+    void *mem = tiles.back();
+    tiles.pop_back();
+    return mem;
+  }
+
+  void TilePool::Release::operator()(Tile *tile) const
+  {
+    static_assert(std::is_trivially_destructible<Tile>::value,
+                  "TilePool does not call the destructor of Tile");
+    auto &tiles = freeTiles.tiles;
+    if (tiles.size() < maxFreeTiles)
+      tiles.push_back(tile);
+    else
+      alignedFree(tile);
+  }
+
+} // ::ospray
@@ -0,0 +1,72 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "fb/Tile.h"
+// std
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace ospray {
+
+  /*! \brief per-thread pool of (64-byte aligned) tiles
+
+    For builds with TILE_SIZE > MAX_TILE_SIZE tiles are too big for the
+    stack. Instead of one heap allocation per tile and frame, tiles are
+    taken from (and given back to) a free list owned by the calling
+    thread, such that in steady state no allocations happen. A tile
+    given back on a different thread simply moves into that thread's
+    free list; each list keeps at most 'maxFreeTiles' tiles.
+   */
+  struct OSPRAY_SDK_INTERFACE TilePool
+  {
+    struct OSPRAY_SDK_INTERFACE Release
+    {
+      void operator()(Tile *tile) const;
+    };
+
+    using Ptr = std::unique_ptr<Tile, Release>;
+
+    static constexpr size_t maxFreeTiles = 16;
+
+    /*! returns a default-initialized (i.e. garbage) tile */
+    static Ptr acquire();
+
+    /*! returns a tile constructed with the given Tile constructor args */
+    template <typename... Args>
+    static Ptr acquire(Args&&... args);
+
+  private:
+
+    static void *allocate();
+  };
+
+  // Inlined definitions //////////////////////////////////////////////////////
+
+  inline TilePool::Ptr TilePool::acquire()
+  {
+    return Ptr(new (allocate()) Tile);
+  }
+
+  template <typename... Args>
+  inline TilePool::Ptr TilePool::acquire(Args&&... args)
+  {
+    return Ptr(new (allocate()) Tile(std::forward<Args>(args)...));
+  }
+
+} // ::ospray
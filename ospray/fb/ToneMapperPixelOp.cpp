@@ -15,7 +15,11 @@
 // ======================================================================== //
 
 #include "ToneMapperPixelOp.h"
+#include "FrameBuffer.h"
 #include "ToneMapperPixelOp_ispc.h"
+// std
+#include <cmath>
+#include <numeric>
 
 using namespace ospcommon;
 
@@ -30,8 +34,9 @@ namespace ospray {
   {
     PixelOp::commit();
       
-    float exposure = getParam1f("exposure", 1.f);
-    
+    exposure = getParam1f("exposure", 1.f);
+    autoExposure = getParam1i("autoExposure", 0);
+
     // Default parameters fitted to the ACES 1.0 grayscale curve (RRT.a1.0.3 + ODT.Academy.Rec709_100nits_dim.a1.0.3)
     // We included exposure adjustment to match 18% middle gray (ODT(RRT(0.18)) = 0.18)
     const float aces_contrast = 1.6773f;
@@ -51,6 +56,9 @@ namespace ospray {
     float b = -((powf(m, -a*d)*(-powf(m, a) + (n*(powf(m, a*d)*n*powf(w, a) - powf(m, a)*powf(w, a*d))) / (powf(m, a*d)*n - n*powf(w, a*d)))) / n);
     float c = max((powf(m, a*d)*n*powf(w, a) - powf(m, a)*powf(w, a*d)) / (powf(m, a*d)*n - n*powf(w, a*d)), 0.f); // avoid discontinuous curve by clamping to 0
     
+    midIn = m;
+
+    // with autoExposure the exposure is updated at the end of each frame
     ispc::ToneMapperPixelOp_set(ispcEquivalent, exposure, a, b, c, d, acesColor);
   }
 
@@ -59,22 +67,120 @@ namespace ospray {
     return "ospray::ToneMapperPixelOp";
   }
 
-  PixelOp::Instance* ToneMapperPixelOp::createInstance(FrameBuffer*, PixelOp::Instance* /*prev*/)
+  PixelOp::Instance* ToneMapperPixelOp::createInstance(FrameBuffer* fb, PixelOp::Instance* prev)
+  {
+    // setting the same tone mapper again replaces it instead of chaining
+    auto* prevToneMapper = dynamic_cast<ToneMapperPixelOp::Instance*>(prev);
+    if (prevToneMapper && prevToneMapper->ispcInstance == getIE())
+      prev = prevToneMapper->prev.ptr;
+
+    return new ToneMapperPixelOp::Instance(this, fb, prev);
+  }
+
+  ToneMapperPixelOp::Instance::Instance(ToneMapperPixelOp* toneMapper, FrameBuffer* fb, PixelOp::Instance* prev)
+    : ispcInstance(toneMapper->getIE()), toneMapper(toneMapper), prev(prev)
   {
-    // FIXME: use prev too
-    return new ToneMapperPixelOp::Instance(getIE());
+    this->fb = fb;
+    tileHistograms.resize(size_t(fb->getTotalTiles()) * histogramBins, 0);
   }
 
-  ToneMapperPixelOp::Instance::Instance(void* ispcInstance)
-    : ispcInstance(ispcInstance)
+  void ToneMapperPixelOp::Instance::beginFrame()
   {
+    if (prev)
+      prev->beginFrame();
+  }
+
+  void ToneMapperPixelOp::Instance::endFrame()
+  {
+    if (prev)
+      prev->endFrame();
+
+    if (!toneMapper->autoExposure)
+      return;
+
+    // a local frame buffer has all tiles, a distributed one already set the
+    // histogram summed over the ranks
+    if (frameHistogram.size() != size_t(histogramBins))
+      frameHistogram = getFrameStatistics();
+
+    // expose the mean log luminance of the 10-90% percentiles (ignoring
+    // e.g. the background and highlights) to midIn, for the next frame
+    const uint64_t total = std::accumulate(frameHistogram.begin(),
+                                           frameHistogram.end(), uint64_t(0));
+    if (total > 0) {
+      const double lowest = 0.1 * total;
+      const double highest = 0.9 * total;
+      const float binWidth = (histogramMaxLog2 - histogramMinLog2) / histogramBins;
+      double below = 0.0;
+      double sum = 0.0;
+      double count = 0.0;
+      for (int i = 0; i < histogramBins; i++) {
+        // the part of this bin within the percentiles
+        const double n = std::min<double>(below + frameHistogram[i], highest)
+                         - std::max(below, lowest);
+        if (n > 0.0) {
+          sum += n * (histogramMinLog2 + (i + 0.5f) * binWidth);
+          count += n;
+        }
+        below += frameHistogram[i];
+      }
+      if (count > 0.0) {
+        const float averageLog2 = float(sum / count);
+        ispc::ToneMapperPixelOp_setExposure(ispcInstance,
+            toneMapper->exposure * toneMapper->midIn / std::exp2(averageLog2));
+      }
+    }
+
+    frameHistogram.clear();
+  }
+
+  void ToneMapperPixelOp::Instance::preAccum(Tile& tile)
+  {
+    if (prev)
+      prev->preAccum(tile);
   }
 
   void ToneMapperPixelOp::Instance::postAccum(Tile& tile)
   {
+    if (prev)
+      prev->postAccum(tile);
+    if (toneMapper->autoExposure) {
+      // tiles are written concurrently, but each into its own histogram
+      const vec2i tileID = tile.region.lower / TILE_SIZE;
+      const size_t tileIndex = tileID.y * size_t(fb->getNumTiles().x) + tileID.x;
+      ispc::ToneMapperPixelOp_histogram((ispc::Tile&)tile,
+                                        &tileHistograms[tileIndex * histogramBins],
+                                        histogramBins,
+                                        histogramMinLog2, histogramMaxLog2);
+    }
     ToneMapperPixelOp_apply(ispcInstance, (ispc::Tile&)tile);
   }
 
+  bool ToneMapperPixelOp::Instance::getColorOps(std::vector<void*>& ops) const
+  {
+    // the histogram for auto exposure is computed in postAccum
+    if (toneMapper->autoExposure || (prev && !prev->getColorOps(ops)))
+      return false;
+    ops.push_back(ispcInstance);
+    return true;
+  }
+
+  std::vector<uint32> ToneMapperPixelOp::Instance::getFrameStatistics() const
+  {
+    if (!toneMapper->autoExposure)
+      return {};
+
+    std::vector<uint32> histogram(histogramBins, 0);
+    for (size_t i = 0; i < tileHistograms.size(); i++)
+      histogram[i % histogramBins] += tileHistograms[i];
+    return histogram;
+  }
+
+  void ToneMapperPixelOp::Instance::setFrameStatistics(const std::vector<uint32>& stats)
+  {
+    frameHistogram = stats;
+  }
+
   std::string ToneMapperPixelOp::Instance::toString() const
   {
     return "ospray::ToneMapperPixelOp::Instance";
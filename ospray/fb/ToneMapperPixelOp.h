@@ -26,18 +26,41 @@ namespace ospray {
   {
     struct OSPRAY_SDK_INTERFACE Instance : public PixelOp::Instance
     {
-      Instance(void* ispcInstance);
+      Instance(ToneMapperPixelOp* toneMapper, FrameBuffer* fb, PixelOp::Instance* prev);
 
+      virtual void beginFrame() override;
+      virtual void endFrame() override;
+      virtual void preAccum(Tile& tile) override;
       virtual void postAccum(Tile& tile) override;
+      virtual bool getColorOps(std::vector<void*>& ops) const override;
+      virtual std::vector<uint32> getFrameStatistics() const override;
+      virtual void setFrameStatistics(const std::vector<uint32>& stats) override;
       virtual std::string toString() const override;
 
       void* ispcInstance;
+      Ref<ToneMapperPixelOp> toneMapper;
+      Ref<PixelOp::Instance> prev; //!< applied before tone mapping
+
+      /*! log-luminance histograms of the (accumulated) tiles, kept per tile
+          such that tiles which are not rendered again still count */
+      std::vector<uint32> tileHistograms;
+      //! the histogram of the whole frame, summed over all ranks by the DFB
+      std::vector<uint32> frameHistogram;
     };
 
+    //! log2 luminance range and resolution of the auto exposure histograms
+    static constexpr int histogramBins = 64;
+    static constexpr float histogramMinLog2 = -16.f;
+    static constexpr float histogramMaxLog2 = 16.f;
+
     ToneMapperPixelOp();
     virtual void commit() override;
     virtual std::string toString() const override;
     virtual PixelOp::Instance* createInstance(FrameBuffer* fb, PixelOp::Instance* prev) override;
+
+    float exposure {1.f};   //!< exposure, or its compensation with autoExposure
+    float midIn {0.18f};    //!< the key the average luminance is exposed to
+    bool autoExposure {false};
   };
 
 } // ::ospray
@@ -0,0 +1,493 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#undef NDEBUG
+
+// ospray
+#include "ClusterMesh.h"
+#include "GeometryBounds.h"
+#include "common/Model.h"
+#include "common/OSPCommon.h"
+#include "ospcommon/tasking/parallel_for.h"
+// ispc-generated files
+#include "TriangleMesh_ispc.h"
+// std
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ospray {
+
+  //! the octree during the build, flattened afterwards
+  struct ClusterMesh::BuildCell
+  {
+    vec3f lower;
+    float size;
+    Cluster cluster;
+    std::vector<std::unique_ptr<BuildCell>> children;
+  };
+
+  namespace {
+
+    //! the octree is not refined deeper, e.g. for coincident triangles
+    const int maxDepth = 21;
+
+    //! subtrees with more triangles are built in parallel
+    const size_t parallelBuildTriangles = 1 << 18;
+
+    //! item 'i' of (possibly strided) data
+    template <typename T>
+    const T &item(const Data *data, size_t i)
+    {
+      const size_t stride =
+          data->compact() ? sizeOf(data->type) : data->byteStride;
+      return *(const T *)((const char *)data->data + i * stride);
+    }
+
+    //! a grid cell (with coordinates in [-2^20, 2^20)) as hash key
+    uint64 gridKey(const vec3i &g)
+    {
+      const uint64 mask = (1 << 21) - 1;
+      return uint64((g.x + (1 << 20)) & mask)
+        | uint64((g.y + (1 << 20)) & mask) << 21
+        | uint64((g.z + (1 << 20)) & mask) << 42;
+    }
+
+  } // ::ospray::{anonymous}
+
+  ClusterMesh::ClusterMesh()
+  {
+    this->ispcEquivalent = ispc::TriangleMesh_create(this);
+  }
+
+  std::string ClusterMesh::toString() const
+  {
+    return "ospray::ClusterMesh";
+  }
+
+  void ClusterMesh::finalize(Model *model)
+  {
+    Geometry::finalize(model);
+
+    vertexData = getParamData("vertex", getParamData("position"));
+    normalData = getParamData("vertex.normal", getParamData("normal"));
+    colorData  = getParamData("vertex.color", getParamData("color"));
+    indexData  = getParamData("index", getParamData("triangle"));
+    geom_materialID = getParam1i("geom.materialID", -1);
+
+    clusterTriangles = std::min(std::max(getParam1i("clusterTriangles", 4096),
+                                         64), 1 << 16);
+    lodError     = std::max(0.f, getParam1f("lodError", 0.001f));
+    maxTriangles = std::min<size_t>(std::max(1, getParam1i("maxTriangles",
+                                                           1 << 24)),
+                                    1 << 28);
+
+    if (!vertexData || !indexData)
+      throw std::runtime_error("cluster mesh must have 'vertex' and 'index' "
+                               "arrays");
+    if (vertexData->type != OSP_FLOAT3 && vertexData->type != OSP_FLOAT3A)
+      throw std::runtime_error("cluster mesh 'vertex' must have data type "
+                               "OSP_FLOAT3 or OSP_FLOAT3A");
+    if (indexData->type != OSP_INT3 && indexData->type != OSP_UINT3
+        && indexData->type != OSP_INT4 && indexData->type != OSP_UINT4)
+      throw std::runtime_error("cluster mesh 'index' must have data type "
+                               "OSP_INT3 or OSP_INT4");
+    if (normalData && normalData->type != OSP_FLOAT3
+        && normalData->type != OSP_FLOAT3A)
+      throw std::runtime_error("cluster mesh 'vertex.normal' must have data "
+                               "type OSP_FLOAT3 or OSP_FLOAT3A");
+    if (colorData && colorData->type != OSP_FLOAT4
+        && colorData->type != OSP_FLOAT3A)
+      throw std::runtime_error("cluster mesh 'vertex.color' must have data "
+                               "type OSP_FLOAT4 or OSP_FLOAT3A");
+    colorAlpha = colorData && colorData->type == OSP_FLOAT4;
+
+    postStatusMsg(2) << "#osp: building 'cluster_mesh' geometry, #triangles = "
+                     << indexData->numItems;
+
+    const size_t numInvalid =
+      countInvalidIndices((const int32 *)indexData->data,
+                          indexData->byteStride / sizeof(int32), 3,
+                          indexData->numItems, vertexData->numItems,
+                          indexData->type == OSP_UINT3
+                          || indexData->type == OSP_UINT4);
+    if (numInvalid > 0) {
+      throw std::runtime_error(std::to_string(numInvalid)
+                               + " cluster mesh indices are out of range of "
+                               "its " + std::to_string(vertexData->numItems)
+                               + " vertices");
+    }
+
+    build();
+
+    // the clusters hold all of the mesh
+    vertexData = nullptr;
+    normalData = nullptr;
+    colorData  = nullptr;
+    indexData  = nullptr;
+
+    bounds = clusters[0].bounds;
+
+    // start with the root as cut
+    cut.clear();
+    setCut({0});
+
+    embreeGeometry = rtcNewGeometry(ispc_embreeDevice(),
+                                    RTC_GEOMETRY_TYPE_TRIANGLE);
+    embreeGeomID = model->attachGeometry(this, embreeGeometry);
+    rtcReleaseGeometry(embreeGeometry);
+    updateMesh(model);
+  }
+
+  bool ClusterMesh::hasLOD() const
+  {
+    return clusters.size() > 1;
+  }
+
+  bool ClusterMesh::selectLOD(Model *model, const vec3f &eye)
+  {
+    // Refine the clusters with the largest projected error first, as long
+    // as it is larger than 'lodError' and the triangles fit into the
+    // budget.
+    auto priority = [&](int32 id) {
+      const box3f &b = clusters[id].bounds;
+      const vec3f d = max(max(b.lower - eye, eye - b.upper), vec3f(0.f));
+      return clusters[id].error
+        / std::max(length(d), 1e-6f * reduce_max(b.size()));
+    };
+
+    using Candidate = std::pair<float, int32>;
+    std::priority_queue<Candidate> queue;
+    std::vector<int32> newCut;
+    size_t numTriangles = clusters[0].triangles.size();
+    queue.emplace(priority(0), 0);
+
+    while (!queue.empty()) {
+      const int32 id = queue.top().second;
+      const float p = queue.top().first;
+      queue.pop();
+
+      const Cluster &cluster = clusters[id];
+      bool refine = cluster.numChildren > 0 && p > lodError;
+      if (refine) {
+        size_t childTriangles = 0;
+        for (int32 c = 0; c < cluster.numChildren; c++)
+          childTriangles += clusters[cluster.firstChild + c].triangles.size();
+        refine = numTriangles - cluster.triangles.size() + childTriangles
+          <= maxTriangles;
+        if (refine)
+          numTriangles += childTriangles - cluster.triangles.size();
+      }
+
+      if (!refine) {
+        newCut.push_back(id);
+        continue;
+      }
+
+      for (int32 c = 0; c < cluster.numChildren; c++) {
+        const int32 child = cluster.firstChild + c;
+        queue.emplace(priority(child), child);
+      }
+    }
+
+    std::sort(newCut.begin(), newCut.end());
+    if (newCut == cut)
+      return false;
+
+    setCut(newCut);
+    updateMesh(model);
+    return true;
+  }
+
+  void ClusterMesh::build()
+  {
+    const size_t numTriangles = indexData->numItems;
+    centroids.resize(numTriangles);
+    std::vector<uint64> ids(numTriangles);
+    tasking::parallel_for(numTriangles, [&](size_t i) {
+      const vec3i &t = item<vec3i>(indexData.ptr, i);
+      centroids[i] = (item<vec3f>(vertexData.ptr, t.x)
+                      + item<vec3f>(vertexData.ptr, t.y)
+                      + item<vec3f>(vertexData.ptr, t.z)) * (1.f / 3.f);
+      ids[i] = i;
+    });
+
+    // the bounds of the centroids
+    box3f centroidBounds = reduceBounds(numTriangles, [&](size_t i) {
+      return box3f(centroids[i], centroids[i]);
+    }).bounds;
+    if (centroidBounds.empty())
+      centroidBounds = box3f(vec3f(0.f), vec3f(0.f));
+
+    // a cube, slightly enlarged to contain the upper centroids
+    BuildCell root;
+    root.lower = centroidBounds.lower;
+    root.size  = std::max(reduce_max(centroidBounds.size()), 1e-6f) * 1.0001f;
+
+    buildRec(root, ids.data(), ids.data() + ids.size(), 0);
+    std::vector<vec3f>().swap(centroids);
+
+    // flatten in breadth-first order, which keeps children consecutive
+    clusters.clear();
+    std::vector<BuildCell *> order {&root};
+    for (size_t i = 0; i < order.size(); i++) {
+      BuildCell &b = *order[i];
+      b.cluster.firstChild  = b.children.empty() ? -1 : int32(order.size());
+      b.cluster.numChildren = int32(b.children.size());
+      for (auto &child : b.children)
+        order.push_back(child.get());
+      clusters.push_back(std::move(b.cluster));
+    }
+
+    postStatusMsg(2) << "#osp: built 'cluster_mesh' hierarchy with "
+                     << clusters.size() << " clusters";
+  }
+
+  void ClusterMesh::buildRec(BuildCell &cell, uint64 *begin, uint64 *end,
+                             int depth)
+  {
+    const size_t numTriangles = end - begin;
+    if (numTriangles <= size_t(clusterTriangles) || depth >= maxDepth) {
+      makeLeaf(cell.cluster, begin, end);
+      return;
+    }
+
+    // partition into octants by the centroids, by z, then y, then x
+    const vec3f center = cell.lower + 0.5f * cell.size;
+    uint64 *split[9];
+    split[0] = begin;
+    split[8] = end;
+    split[4] = std::partition(split[0], split[8], [&](uint64 id) {
+      return centroids[id].z < center.z;
+    });
+    for (int i = 2; i < 8; i += 4) {
+      split[i] = std::partition(split[i - 2], split[i + 2], [&](uint64 id) {
+        return centroids[id].y < center.y;
+      });
+    }
+    for (int i = 1; i < 8; i += 2) {
+      split[i] = std::partition(split[i - 1], split[i + 1], [&](uint64 id) {
+        return centroids[id].x < center.x;
+      });
+    }
+
+    std::vector<std::pair<uint64 *, uint64 *>> ranges;
+    for (int o = 0; o < 8; o++) {
+      if (split[o] == split[o + 1])
+        continue;
+      std::unique_ptr<BuildCell> child(new BuildCell);
+      child->size  = 0.5f * cell.size;
+      child->lower = cell.lower
+        + child->size * vec3f(o & 1, (o >> 1) & 1, (o >> 2) & 1);
+      cell.children.push_back(std::move(child));
+      ranges.emplace_back(split[o], split[o + 1]);
+    }
+
+    auto buildChild = [&](size_t i) {
+      buildRec(*cell.children[i], ranges[i].first, ranges[i].second,
+               depth + 1);
+    };
+    if (numTriangles > parallelBuildTriangles)
+      tasking::parallel_for(ranges.size(), buildChild);
+    else
+      for (size_t i = 0; i < ranges.size(); i++)
+        buildChild(i);
+
+    simplify(cell);
+  }
+
+  void ClusterMesh::makeLeaf(Cluster &cluster, const uint64 *begin,
+                             const uint64 *end) const
+  {
+    cluster.error = 0.f;
+    cluster.bounds = empty;
+
+    std::unordered_map<int32, int32> local;
+    for (const uint64 *id = begin; id < end; id++) {
+      const vec3i &t = item<vec3i>(indexData.ptr, *id);
+      vec3i triangle;
+      for (int k = 0; k < 3; k++) {
+        const int32 v = t[k];
+        auto it = local.emplace(v, int32(cluster.vertices.size()));
+        if (it.second) {
+          const vec3f &position = item<vec3f>(vertexData.ptr, v);
+          cluster.vertices.push_back(position);
+          cluster.bounds.extend(position);
+          if (normalData)
+            cluster.normals.push_back(item<vec3f>(normalData.ptr, v));
+          if (colorData) {
+            cluster.colors.push_back(colorAlpha ?
+                item<vec4f>(colorData.ptr, v) :
+                vec4f(item<vec3f>(colorData.ptr, v), 1.f));
+          }
+        }
+        triangle[k] = it.first->second;
+      }
+      cluster.triangles.push_back(triangle);
+    }
+  }
+
+  void ClusterMesh::simplify(BuildCell &cell) const
+  {
+    // Vertex clustering on a grid with about 'clusterTriangles' triangles
+    // on a surface through the cell; the grids of all cells of a level are
+    // aligned, thus neighboring clusters of the same level match.
+    const int res = std::max(2, int(std::sqrt(clusterTriangles / 2.f)));
+    const float gridSize = cell.size / res;
+    const float toGrid = res / cell.size;
+
+    struct Sum
+    {
+      vec3f position {0.f};
+      vec3f normal {0.f};
+      vec4f color {0.f};
+      int count {0};
+    };
+
+    std::unordered_map<uint64, int32> gridVertex;
+    std::unordered_set<uint64> uniqueTriangles;
+    std::vector<Sum> sums;
+    Cluster &cluster = cell.cluster;
+    cluster.error = 0.f;
+    cluster.bounds = empty;
+
+    for (const auto &child : cell.children) {
+      const Cluster &c = child->cluster;
+      cluster.error = std::max(cluster.error, c.error);
+      cluster.bounds.extend(c.bounds);
+
+      std::vector<int32> remap(c.vertices.size());
+      for (size_t i = 0; i < c.vertices.size(); i++) {
+        const vec3f p = c.vertices[i];
+        const vec3f g = (p - cell.lower) * toGrid;
+        const vec3i gi(std::floor(g.x), std::floor(g.y), std::floor(g.z));
+        auto it = gridVertex.emplace(gridKey(gi), int32(sums.size()));
+        if (it.second)
+          sums.emplace_back();
+        Sum &sum = sums[it.first->second];
+        sum.position += p;
+        if (!c.normals.empty())
+          sum.normal += vec3f(c.normals[i]);
+        if (!c.colors.empty())
+          sum.color += c.colors[i];
+        sum.count++;
+        remap[i] = it.first->second;
+      }
+
+      for (const vec3i &t : c.triangles) {
+        const vec3i r(remap[t.x], remap[t.y], remap[t.z]);
+        if (r.x == r.y || r.y == r.z || r.z == r.x)
+          continue;
+        // the same triangle from several children is kept once
+        int32 v[3] = {r.x, r.y, r.z};
+        std::sort(v, v + 3);
+        const uint64 key = uint64(v[0]) | uint64(v[1]) << 21
+          | uint64(v[2]) << 42;
+        if (uniqueTriangles.insert(key).second)
+          cluster.triangles.push_back(r);
+      }
+    }
+
+    const bool hasNormals = !cell.children[0]->cluster.normals.empty();
+    const bool hasColors = !cell.children[0]->cluster.colors.empty();
+    cluster.vertices.resize(sums.size());
+    cluster.normals.resize(hasNormals ? sums.size() : 0);
+    cluster.colors.resize(hasColors ? sums.size() : 0);
+    for (size_t i = 0; i < sums.size(); i++) {
+      const float w = 1.f / sums[i].count;
+      cluster.vertices[i] = sums[i].position * w;
+      if (hasNormals)
+        cluster.normals[i] = safe_normalize(sums[i].normal);
+      if (hasColors)
+        cluster.colors[i] = sums[i].color * w;
+    }
+
+    cluster.error = std::max(cluster.error, gridSize * std::sqrt(3.f));
+  }
+
+  void ClusterMesh::setCut(const std::vector<int32> &newCut)
+  {
+    cut = newCut;
+
+    std::vector<size_t> vertexOffsets(cut.size() + 1, 0);
+    std::vector<size_t> triangleOffsets(cut.size() + 1, 0);
+    for (size_t i = 0; i < cut.size(); i++) {
+      const Cluster &cluster = clusters[cut[i]];
+      vertexOffsets[i + 1] = vertexOffsets[i] + cluster.vertices.size();
+      triangleOffsets[i + 1] = triangleOffsets[i] + cluster.triangles.size();
+    }
+
+    const bool hasNormals = !clusters[0].normals.empty();
+    const bool hasColors = !clusters[0].colors.empty();
+    vertices.resize(vertexOffsets.back());
+    normals.resize(hasNormals ? vertexOffsets.back() : 0);
+    colors.resize(hasColors ? vertexOffsets.back() : 0);
+    triangles.resize(triangleOffsets.back());
+
+    tasking::parallel_for(cut.size(), [&](size_t i) {
+      const Cluster &cluster = clusters[cut[i]];
+      std::copy(cluster.vertices.begin(), cluster.vertices.end(),
+                vertices.begin() + vertexOffsets[i]);
+      if (hasNormals) {
+        std::copy(cluster.normals.begin(), cluster.normals.end(),
+                  normals.begin() + vertexOffsets[i]);
+      }
+      if (hasColors) {
+        std::copy(cluster.colors.begin(), cluster.colors.end(),
+                  colors.begin() + vertexOffsets[i]);
+      }
+      const vec3i offset(int32(vertexOffsets[i]));
+      for (size_t j = 0; j < cluster.triangles.size(); j++)
+        triangles[triangleOffsets[i] + j] = cluster.triangles[j] + offset;
+    });
+  }
+
+  void ClusterMesh::updateMesh(Model *model)
+  {
+    rtcSetSharedGeometryBuffer(embreeGeometry, RTC_BUFFER_TYPE_INDEX, 0,
+                               RTC_FORMAT_UINT3, triangles.data(), 0,
+                               sizeof(vec3i), triangles.size());
+    rtcSetSharedGeometryBuffer(embreeGeometry, RTC_BUFFER_TYPE_VERTEX, 0,
+                               RTC_FORMAT_FLOAT3, vertices.data(), 0,
+                               sizeof(vec3fa), vertices.size());
+    rtcCommitGeometry(embreeGeometry);
+
+    ispc::TriangleMesh_set(getIE(), model->getIE(),
+                           embreeGeometry,
+                           embreeGeomID,
+                           triangles.size(),
+                           3, 4, 4,
+                           sizeof(vec4f),
+                           sizeof(vec2f),
+                           (int*)triangles.data(),
+                           (float*)vertices.data(),
+                           normals.empty() ? nullptr : (float*)normals.data(),
+                           colors.empty() ?
+                               nullptr : (ispc::vec4f*)colors.data(),
+                           nullptr,
+                           geom_materialID,
+                           materialList ? ispcMaterialPtrs.data() : nullptr,
+                           nullptr,
+                           colorAlpha,
+                           false);
+  }
+
+  OSP_REGISTER_GEOMETRY(ClusterMesh, cluster_mesh);
+
+} // ::ospray
@@ -0,0 +1,111 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "Geometry.h"
+#include "common/Data.h"
+
+namespace ospray {
+
+  /*! \brief A (huge) triangle mesh rendered with a continuous level of
+      detail, from a hierarchy of simplified clusters of its triangles.
+
+      At commit the triangles are split into an octree by their centroid,
+      with the leaves holding clusters of the original triangles. Each
+      inner cell holds a simplification of the clusters of its children
+      (by clustering their vertices on a grid), with about as many
+      triangles, and the geometric error of that grid. Before each frame
+      a cut through the octree is selected by the projected error, whose
+      clusters are traced as one triangle mesh; thus the BVH scales with
+      the screen resolution, not with the mesh.
+
+      The mesh of the cut is shaded like a "triangles" geometry (sharing
+      its ISPC side), with interpolated normals and colors.
+   */
+  struct OSPRAY_SDK_INTERFACE ClusterMesh : public Geometry
+  {
+    ClusterMesh();
+    virtual ~ClusterMesh() override = default;
+
+    virtual std::string toString() const override;
+    virtual void finalize(Model *model) override;
+
+    virtual bool hasLOD() const override;
+    virtual bool selectLOD(Model *model, const vec3f &eye) override;
+
+    //! the triangles of a cell of the octree
+    struct Cluster
+    {
+      box3f bounds;
+      float error;      //!< geometric error of the simplification
+      int32 firstChild; //!< the children are consecutive
+      int32 numChildren;
+      std::vector<vec3fa> vertices;
+      std::vector<vec3fa> normals; //!< empty if the mesh has none
+      std::vector<vec4f> colors;   //!< empty if the mesh has none
+      std::vector<vec3i> triangles;
+    };
+
+  private:
+
+    struct BuildCell;
+
+    //! build the octree over the triangles of the mesh
+    void build();
+    void buildRec(BuildCell &cell, uint64 *begin, uint64 *end, int depth);
+
+    //! the cluster of a leaf, with the given (original) triangles
+    void makeLeaf(Cluster &cluster, const uint64 *begin,
+                  const uint64 *end) const;
+
+    //! the simplified cluster of an inner cell, from its children
+    void simplify(BuildCell &cell) const;
+
+    //! the triangles of the clusters in 'cut', for rendering
+    void setCut(const std::vector<int32> &newCut);
+
+    //! pass the mesh of the cut to embree and the ISPC side
+    void updateMesh(Model *model);
+
+    // the input mesh, only used during the build
+    Ref<Data> vertexData;
+    Ref<Data> normalData;
+    Ref<Data> colorData;
+    Ref<Data> indexData;
+    std::vector<vec3f> centroids;
+
+    float lodError {0.001f};
+    size_t maxTriangles {0};
+    int32 clusterTriangles {0};
+    int32 geom_materialID {-1};
+    bool colorAlpha {false};
+
+    std::vector<Cluster> clusters;
+
+    //! the selected clusters, and their mesh
+    std::vector<int32> cut;
+    std::vector<vec3fa> vertices;
+    std::vector<vec3fa> normals;
+    std::vector<vec4f> colors;
+    std::vector<vec3i> triangles;
+
+    //! the attached embree geometry
+    RTCGeometry embreeGeometry {nullptr};
+    int32 embreeGeomID {-1};
+  };
+
+} // ::ospray
@@ -18,6 +18,7 @@
 
 // ospray
 #include "Curves.h"
+#include "GeometryBounds.h"
 #include "common/Data.h"
 #include "common/Model.h"
 #include "ospcommon/utility/DataView.h"
@@ -99,7 +100,8 @@ namespace ospray {
       throw std::runtime_error("curves must have 'vertex' array");
     if (vertexData->type != OSP_FLOAT4)
       throw std::runtime_error("curves 'vertex' must be type OSP_FLOAT4");
-    auto vertex = (vec4f*)vertexData->data;
+    // (strided views of interleaved arrays are shared with embree as well)
+    utility::DataView<vec4f> vertex(vertexData->data, vertexData->byteStride);
     auto numVertices = vertexData->numItems;
 
     indexData  = getParamData("index",nullptr);
@@ -107,7 +109,7 @@ namespace ospray {
       throw std::runtime_error("curves must have 'index' array");
     if (indexData->type != OSP_INT)
       throw std::runtime_error("curves 'index' array must be type OSP_INT");
-    auto index = (uint32*)indexData->data;
+    utility::DataView<uint32> index(indexData->data, indexData->byteStride);
     auto numSegments = indexData->numItems;
 
     normalData = getParamData("vertex.normal", nullptr);
@@ -136,15 +138,33 @@ namespace ospray {
     if (basis == LINEAR || basis == HERMITE)
       numVerts = 2;
 
-    bounds = empty;
-    for (uint32_t i = 0; i < indexData->numItems; i++) {
-      const uint32_t idx = index[i];
-      for (uint32_t v = idx; v < idx + numVerts; v++) {
-        float radius = vertex[v].w;
-        vec3f vtx(vertex[v].x, vertex[v].y, vertex[v].z);
-        bounds.extend(vtx - radius);
-        bounds.extend(vtx + radius);
-      }
+    // each segment uses the numVerts vertices starting at its index
+    const size_t numInvalidIndices =
+      countInvalidIndices((const int32 *)indexData->data,
+                          indexData->byteStride / sizeof(int32), 1,
+                          numSegments, int64(numVertices) - numVerts + 1,
+                          true);
+    if (numInvalidIndices > 0) {
+      throw std::runtime_error(std::to_string(numInvalidIndices)
+                               + " curves segments are out of range of its "
+                               + std::to_string(numVertices) + " vertices");
+    }
+
+    const GeometryBounds segmentBounds =
+      reduceBounds(numSegments, [&](size_t i) {
+        const uint32_t idx = index[i];
+        box3f b = empty;
+        for (uint32_t v = idx; v < idx + numVerts; v++) {
+          float radius = vertex[v].w;
+          vec3f vtx(vertex[v].x, vertex[v].y, vertex[v].z);
+          b.extend(box3f(vtx - radius, vtx + radius));
+        }
+        return b;
+      });
+    bounds = segmentBounds.bounds;
+    if (segmentBounds.numInvalid > 0) {
+      postStatusMsg(1) << "#osp: " << segmentBounds.numInvalid << " curves "
+                       << "segments have non-finite vertices";
     }
 
     ispc::Curves_set(getIE(),
@@ -152,12 +172,16 @@ namespace ospray {
                      (ispc::RTCGeometryType)curveMap[basis][type],
                      (const ispc::vec4f*)vertexData->data,
                      vertexData->numItems,
+                     vertexData->byteStride,
                      (const uint32_t*)indexData->data,
                      indexData->numItems,
+                     indexData->byteStride,
                      normalData ? (const ispc::vec3f*)normalData->data : nullptr,
                      normalData ? normalData->numItems : 0,
+                     normalData ? normalData->byteStride : 0,
                      tangentData ? (const ispc::vec3f*)tangentData->data : nullptr,
-                     tangentData ? tangentData->numItems : 0);
+                     tangentData ? tangentData->numItems : 0,
+                     tangentData ? tangentData->byteStride : 0);
   }
 
   OSP_REGISTER_GEOMETRY(Curves,curves);
@@ -18,6 +18,7 @@
 
 // ospray
 #include "Cylinders.h"
+#include "GeometryBounds.h"
 #include "common/Data.h"
 #include "common/Model.h"
 // ispc-generated files
@@ -41,7 +42,6 @@ namespace ospray {
 
     radius            = getParam1f("radius",0.01f);
     materialID        = getParam1i("materialID",0);
-    bytesPerCylinder  = getParam1i("bytes_per_cylinder",6*sizeof(float));
     offset_v0         = getParam1i("offset_v0",0);
     offset_v1         = getParam1i("offset_v1",3*sizeof(float));
     offset_radius     = getParam1i("offset_radius",-1);
@@ -51,22 +51,37 @@ namespace ospray {
     colorData         = getParamData("color");
     texcoordData      = getParamData("texcoord");
 
+    // a strided view of interleaved data holds one cylinder per item
+    const bool stridedCylinders = cylinderData && !cylinderData->compact();
+    bytesPerCylinder  = getParam1i("bytes_per_cylinder", stridedCylinders ?
+                                   cylinderData->byteStride : 6*sizeof(float));
+
     if (cylinderData.ptr == nullptr || bytesPerCylinder == 0) {
       throw std::runtime_error("#ospray:geometry/cylinders: no 'cylinders'"
                                " data specified");
     }
-    numCylinders = cylinderData->numBytes / bytesPerCylinder;
+    if (texcoordData && !texcoordData->compact()) {
+      throw std::runtime_error("#ospray:geometry/cylinders: 'texcoord' data "
+                               "cannot be strided");
+    }
+    numCylinders = stridedCylinders ? cylinderData->numItems
+                                    : cylinderData->numBytes / bytesPerCylinder;
     postStatusMsg(2) << "#osp: creating 'cylinders' geometry, #cylinders = "
                      << numCylinders;
 
-    const char* cylinderPtr = (const char*)cylinderData->data;
-    bounds = empty;
-    for (uint32_t i = 0; i < numCylinders; i++, cylinderPtr += bytesPerCylinder) {
-      const float r = offset_radius < 0 ? radius : *(const float*)(cylinderPtr + offset_radius);
-      const vec3f v0 = *(const vec3f*)(cylinderPtr + offset_v0);
-      const vec3f v1 = *(const vec3f*)(cylinderPtr + offset_v1);
-      bounds.extend(box3f(v0 - r, v0 + r));
-      bounds.extend(box3f(v1 - r, v1 + r));
+    const char* cylinders = (const char*)cylinderData->data;
+    const GeometryBounds cylinderBounds =
+      reduceBounds(numCylinders, [&](size_t i) {
+        const char *cylinderPtr = cylinders + i * bytesPerCylinder;
+        const float r = offset_radius < 0 ? radius : *(const float*)(cylinderPtr + offset_radius);
+        const vec3f v0 = *(const vec3f*)(cylinderPtr + offset_v0);
+        const vec3f v1 = *(const vec3f*)(cylinderPtr + offset_v1);
+        return box3f(min(v0, v1) - r, max(v0, v1) + r);
+      });
+    bounds = cylinderBounds.bounds;
+    if (cylinderBounds.numInvalid > 0) {
+      postStatusMsg(1) << "#osp: " << cylinderBounds.numInvalid << " cylinders "
+                       << "have non-finite vertices or radius";
     }
 
     auto colComps = colorData && colorData->type == OSP_FLOAT3 ? 3 : 4;
@@ -75,7 +90,9 @@ namespace ospray {
                                 materialList ? ispcMaterialPtrs.data() : nullptr,
                                 texcoordData ? texcoordData->data : nullptr,
                                 colorData ? colorData->data : nullptr,
-                                colComps * sizeof(float),
+                                colorData && !colorData->compact() ?
+                                  colorData->byteStride :
+                                  colComps * sizeof(float),
                                 colorData && colorData->type == OSP_FLOAT4,
                                 numCylinders,bytesPerCylinder,
                                 radius,materialID,
@@ -84,6 +84,16 @@ namespace ospray {
       setMaterialList(materialListDataPtr);
   }
 
+  bool Geometry::changedSince(const size_t time) const
+  {
+    return lastCommitted > time;
+  }
+
+  bool Geometry::refit(Model *)
+  {
+    return false;
+  }
+
   Geometry *Geometry::createInstance(const char *type)
   {
     return createInstanceHelper<Geometry, OSP_GEOMETRY>(type);
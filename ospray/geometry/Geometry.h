@@ -58,9 +58,37 @@ namespace ospray {
     virtual std::string toString() const override;
 
     /*! \brief integrates this geometry's primitives into the respective
-        model's acceleration structure */
+        model's acceleration structure
+
+      \detailed The geometries of a model are finalized in parallel, the
+      embree geometry needs to be attached via Model::attachGeometry
+      (or Model_attachGeometry on the ISPC side) */
     virtual void finalize(Model *);
 
+    /*! \brief whether this geometry needs to be finalized again since
+        the given time, i.e. since the last commit of the model */
+    virtual bool changedSince(const size_t time) const;
+
+    /*! \brief tries to apply the changes since the last finalize(model)
+        in place, i.e. without detaching the embree geometry from the
+        model's scene (e.g. by refitting the BVH of a deforming mesh);
+        returns false if the geometry needs to be finalized again */
+    virtual bool refit(Model *model);
+
+    /*! \brief whether this geometry has levels of detail, which are
+        selected before each frame */
+    virtual bool hasLOD() const { return false; }
+
+    /*! \brief switch to the level of detail for a camera at 'eye' (in
+        the space of 'model'), returns whether it changed; the embree
+        geometry needs to be committed again then (the scene of 'model'
+        is committed by the caller) */
+    virtual bool selectLOD(Model *model, const vec3f &eye) { return false; }
+
+    /*! \brief appends the models this geometry instances, which need to
+        be committed before it gets finalized */
+    virtual void getInstancedModels(std::vector<Model *> &models) {}
+
     /*! \brief creates an abstract geometry class of given type
 
       The respective geometry type must be a registered geometry type
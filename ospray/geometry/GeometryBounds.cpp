@@ -0,0 +1,132 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "GeometryBounds.h"
+// std
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace ospray {
+
+  /*! the bounds of the vertices [begin, end) with a compile-time stride:
+      the branch-free selects on per-component accumulators vectorize to
+      SIMD min/max, invalid coordinates only spoil the checksum */
+  template <int Stride>
+  static GeometryBounds chunkBounds(const float *vertex,
+                                    size_t begin,
+                                    size_t end)
+  {
+    const float inf = std::numeric_limits<float>::infinity();
+    float lower[3] = {inf, inf, inf};
+    float upper[3] = {-inf, -inf, -inf};
+    float check[3] = {0.f, 0.f, 0.f};
+
+    const float *v = vertex + begin * Stride;
+    for (size_t i = begin; i < end; i++, v += Stride) {
+      for (int k = 0; k < 3; k++) {
+        lower[k] = v[k] < lower[k] ? v[k] : lower[k];
+        upper[k] = v[k] > upper[k] ? v[k] : upper[k];
+        // NaN for NaN and infinite coordinates, 0 otherwise
+        check[k] += v[k] - v[k];
+      }
+    }
+
+    GeometryBounds result;
+    if (check[0] == 0.f && check[1] == 0.f && check[2] == 0.f) {
+      if (begin < end)
+        result.bounds = box3f(vec3f(lower[0], lower[1], lower[2]),
+                              vec3f(upper[0], upper[1], upper[2]));
+      return result;
+    }
+
+    // rare: leave out the invalid vertices
+    v = vertex + begin * Stride;
+    for (size_t i = begin; i < end; i++, v += Stride) {
+      const vec3f p(v[0], v[1], v[2]);
+      if (std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z))
+        result.bounds.extend(p);
+      else
+        result.numInvalid++;
+    }
+    return result;
+  }
+
+  GeometryBounds vertexBounds(const float *vertex,
+                              size_t stride,
+                              size_t begin,
+                              size_t end)
+  {
+    if (begin >= end)
+      return GeometryBounds();
+
+    const size_t count = end - begin;
+    const size_t numChunks = (count + boundsChunkSize - 1) / boundsChunkSize;
+    std::vector<GeometryBounds> bounds(numChunks);
+    tasking::parallel_for(numChunks, [&](size_t chunk) {
+      const size_t b = begin + chunk * boundsChunkSize;
+      const size_t e = std::min(end, b + boundsChunkSize);
+      // the common strides get a loop specialized on them
+      switch (stride) {
+      case 3:  bounds[chunk] = chunkBounds<3>(vertex, b, e); break;
+      case 4:  bounds[chunk] = chunkBounds<4>(vertex, b, e); break;
+      default: {
+        GeometryBounds result;
+        for (size_t i = b; i < e; i++) {
+          const vec3f &p = *(const vec3f *)(vertex + i * stride);
+          if (std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z))
+            result.bounds.extend(p);
+          else
+            result.numInvalid++;
+        }
+        bounds[chunk] = result;
+      }
+      }
+    });
+
+    GeometryBounds result;
+    for (const auto &b : bounds)
+      result.extend(b);
+    return result;
+  }
+
+  size_t countInvalidIndices(const int32 *index,
+                             size_t stride,
+                             size_t numComps,
+                             size_t count,
+                             int64 limit,
+                             bool isUnsigned)
+  {
+    std::atomic<size_t> numInvalid {0};
+    const size_t numChunks = (count + boundsChunkSize - 1) / boundsChunkSize;
+    tasking::parallel_for(numChunks, [&](size_t chunk) {
+      const size_t end = std::min(count, (chunk + 1) * boundsChunkSize);
+      size_t invalid = 0;
+      for (size_t i = chunk * boundsChunkSize; i < end; i++) {
+        const int32 *tuple = index + i * stride;
+        for (size_t k = 0; k < numComps; k++) {
+          const int64 idx = isUnsigned ? int64(uint32(tuple[k]))
+                                       : int64(tuple[k]);
+          invalid += !inRange(idx, 0, limit);
+        }
+      }
+      if (invalid)
+        numInvalid += invalid;
+    });
+    return numInvalid;
+  }
+
+} // ::ospray
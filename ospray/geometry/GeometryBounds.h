@@ -0,0 +1,111 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "common/OSPCommon.h"
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <cmath>
+#include <vector>
+
+namespace ospray {
+
+  /*! \file GeometryBounds.h Parallel bounds reduction and validation of
+      the input arrays of geometries, for their finalize() */
+
+  //! number of items reduced serially by one task
+  static constexpr size_t boundsChunkSize = 1 << 16;
+
+  inline bool inRange(int64 i, int64 i0, int64 i1)
+  {
+    return i >= i0 && i < i1;
+  }
+
+  //! the bounds of (valid) items, and the number of invalid ones
+  struct GeometryBounds
+  {
+    box3f bounds {empty};
+    //! items with NaN or infinite coordinates, left out of the bounds
+    size_t numInvalid {0};
+
+    void extend(const GeometryBounds &other)
+    {
+      bounds.extend(other.bounds);
+      numInvalid += other.numInvalid;
+    }
+  };
+
+  /*! \brief the bounds of the vertices [begin, end) of an array of
+      'stride' floats per vertex (whose first three are the position),
+      reduced in parallel chunks
+
+    \detailed The inner loop keeps the per-component minima and maxima
+    (and a NaN-propagating checksum) in independent lanes, such that it
+    gets vectorized; only chunks with invalid vertices are scanned again
+    per vertex to leave them out. */
+  OSPRAY_SDK_INTERFACE
+  GeometryBounds vertexBounds(const float *vertex,
+                              size_t stride,
+                              size_t begin,
+                              size_t end);
+
+  /*! \brief the number of the indices (the first 'numComps' of each of
+      the 'count' tuples of 'stride' 32-bit integers, 'isUnsigned' or
+      signed) outside of [0, limit), counted in parallel chunks */
+  OSPRAY_SDK_INTERFACE
+  size_t countInvalidIndices(const int32 *index,
+                             size_t stride,
+                             size_t numComps,
+                             size_t count,
+                             int64 limit,
+                             bool isUnsigned);
+
+  inline bool finiteBounds(const box3f &b)
+  {
+    return std::isfinite(b.lower.x) && std::isfinite(b.lower.y)
+      && std::isfinite(b.lower.z) && std::isfinite(b.upper.x)
+      && std::isfinite(b.upper.y) && std::isfinite(b.upper.z);
+  }
+
+  /*! \brief the bounds of the items [0, count), 'itemBounds(i)' returning
+      the box3f of item i, reduced in parallel chunks */
+  template <typename ItemBounds>
+  inline GeometryBounds reduceBounds(size_t count,
+                                     const ItemBounds &itemBounds)
+  {
+    const size_t numChunks = (count + boundsChunkSize - 1) / boundsChunkSize;
+    std::vector<GeometryBounds> chunkBounds(numChunks);
+    tasking::parallel_for(numChunks, [&](size_t chunk) {
+      const size_t end = std::min(count, (chunk + 1) * boundsChunkSize);
+      GeometryBounds b;
+      for (size_t i = chunk * boundsChunkSize; i < end; i++) {
+        const box3f ib = itemBounds(i);
+        if (finiteBounds(ib))
+          b.bounds.extend(ib);
+        else
+          b.numInvalid++;
+      }
+      chunkBounds[chunk] = b;
+    });
+
+    GeometryBounds result;
+    for (const auto &b : chunkBounds)
+      result.extend(b);
+    return result;
+  }
+
+} // ::ospray
@@ -44,13 +44,52 @@ namespace ospray {
     instancedScene = (Model *)getParamObject("model", nullptr);
     assert(instancedScene);
 
-    if (!instancedScene->embreeSceneHandle) {
-      instancedScene->commit();
+    lodModels.assign(1, instancedScene);
+    lodSize.assign(1, 0.f);
+    lodLevel = 0;
+    Data *lodModelData = getParamData("lod.models");
+    if (lodModelData) {
+      Data *lodSizeData = getParamData("lod.size");
+      if (lodModelData->type != OSP_OBJECT || !lodSizeData
+          || lodSizeData->type != OSP_FLOAT
+          || lodSizeData->numItems != lodModelData->numItems) {
+        throw std::runtime_error("an instance with lod.models also needs one "
+                                 "lod.size (OSP_FLOAT) per model");
+      }
+      for (size_t i = 0; i < lodModelData->numItems; i++) {
+        Model *lod = ((Model **)lodModelData->data)[i];
+        if (!lod)
+          throw std::runtime_error("lod.models must not contain NULL");
+        lodModels.push_back(lod);
+        lodSize.push_back(((const float *)lodSizeData->data)[i]);
+      }
     }
 
-    RTCGeometry embreeGeom   = rtcNewGeometry(ispc_embreeDevice(),RTC_GEOMETRY_TYPE_INSTANCE);
-    embreeGeomID = rtcAttachGeometry(model->embreeSceneHandle,embreeGeom);
-    rtcSetGeometryInstancedScene(embreeGeom,instancedScene->embreeSceneHandle);
+    // committed by Model::commitLazyDependencies, instances (of the same
+    // model) are finalized in parallel
+    for (auto &lod : lodModels) {
+      if (!lod->embreeSceneHandle)
+        throw std::runtime_error("the model of an instance is not committed");
+    }
+
+    std::lock_guard<std::mutex> lock(instancedScene->instanceMutex);
+
+    // motion blur: 'motion.transform' holds one (column-major, like
+    // xfm.*) transformation per time step
+    motionXfm.clear();
+    Data *motionData = getParamData("motion.transform");
+    if (motionData) {
+      if (motionData->type != OSP_FLOAT3 && motionData->type != OSP_FLOAT)
+        throw std::runtime_error("motion.transform must have data type "
+                                 "OSP_FLOAT3 or OSP_FLOAT");
+      const size_t numTimeSteps = motionData->numBytes / sizeof(AffineSpace3f);
+      if (numTimeSteps < 2)
+        throw std::runtime_error("motion.transform must hold two or more "
+                                 "transformations");
+      const AffineSpace3f *keys = (const AffineSpace3f *)motionData->data;
+      motionXfm.assign(keys, keys + numTimeSteps);
+      xfm = motionXfm[0];
+    }
 
     const box3f b = instancedScene->bounds;
     if (b.empty()) {
@@ -72,27 +111,64 @@ namespace ospray {
       const vec3f v111(b.upper.x,b.upper.y,b.upper.z);
 
       bounds = empty;
-      bounds.extend(xfmPoint(xfm,v000));
-      bounds.extend(xfmPoint(xfm,v001));
-      bounds.extend(xfmPoint(xfm,v010));
-      bounds.extend(xfmPoint(xfm,v011));
-      bounds.extend(xfmPoint(xfm,v100));
-      bounds.extend(xfmPoint(xfm,v101));
-      bounds.extend(xfmPoint(xfm,v110));
-      bounds.extend(xfmPoint(xfm,v111));
+      const size_t numKeys = motionXfm.empty() ? 1 : motionXfm.size();
+      for (size_t t = 0; t < numKeys; t++) {
+        const AffineSpace3f &key = motionXfm.empty() ? xfm : motionXfm[t];
+        bounds.extend(xfmPoint(key,v000));
+        bounds.extend(xfmPoint(key,v001));
+        bounds.extend(xfmPoint(key,v010));
+        bounds.extend(xfmPoint(key,v011));
+        bounds.extend(xfmPoint(key,v100));
+        bounds.extend(xfmPoint(key,v101));
+        bounds.extend(xfmPoint(key,v110));
+        bounds.extend(xfmPoint(key,v111));
+      }
     }
 
-    rtcSetGeometryTransform(embreeGeom,0,RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR,&xfm);
-    rtcCommitGeometry(embreeGeom);
-    rtcReleaseGeometry(embreeGeom);
-
     AffineSpace3f rcp_xfm = rcp(xfm);
-    areaPDF.resize(instancedScene->geometry.size());
+    size_t maxGeometries = 0;
+    for (auto &lod : lodModels)
+      maxGeometries = std::max(maxGeometries, lod->geometry.size());
+    areaPDF.resize(std::max(maxGeometries, size_t(1)));
     ispc::InstanceGeometry_set(getIE(),
                                (ispc::AffineSpace3f&)xfm,
                                (ispc::AffineSpace3f&)rcp_xfm,
                                instancedScene->getIE(),
-                               &areaPDF[0]);
+                               &areaPDF[0],
+                               motionXfm.size(),
+                               (ispc::AffineSpace3f*)motionXfm.data());
+
+    nested = false;
+    for (auto &lod : lodModels)
+      nested = nested || lod->containsInstances;
+
+    if (nested) {
+      // embree supports only a single level of instancing, thus
+      // instances of models with instances are user geometries which
+      // trace rays into their model themselves
+      embreeGeomID = ispc::InstanceGeometry_attachNested(getIE(),
+                                                         model->getIE(),
+                                                         (ispc::box3f&)bounds);
+    } else {
+      RTCGeometry embreeGeom =
+          rtcNewGeometry(ispc_embreeDevice(), RTC_GEOMETRY_TYPE_INSTANCE);
+      embreeGeomID = model->attachGeometry(this, embreeGeom);
+      rtcSetGeometryInstancedScene(embreeGeom,
+                                   instancedScene->embreeSceneHandle);
+
+      if (motionXfm.empty())
+        rtcSetGeometryTransform(embreeGeom,0,RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR,&xfm);
+      else {
+        rtcSetGeometryTimeStepCount(embreeGeom,motionXfm.size());
+        for (size_t t = 0; t < motionXfm.size(); t++) {
+          rtcSetGeometryTransform(embreeGeom,t,RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR,
+                                  &motionXfm[t]);
+        }
+      }
+      rtcCommitGeometry(embreeGeom);
+      rtcReleaseGeometry(embreeGeom);
+    }
+
     for (auto volume : instancedScene->volume) {
       ospSet3f((OSPObject)volume.ptr, "xfm.l.vx", xfm.l.vx.x, xfm.l.vx.y, xfm.l.vx.z);
       ospSet3f((OSPObject)volume.ptr, "xfm.l.vy", xfm.l.vy.x, xfm.l.vy.y, xfm.l.vy.z);
@@ -101,6 +177,69 @@ namespace ospray {
     }
   }
 
+  bool Instance::changedSince(const size_t time) const
+  {
+    // also the bounds of the instanced model may have changed
+    if (Geometry::changedSince(time))
+      return true;
+    if (lodModels.empty())
+      return instancedScene && instancedScene->sceneTime > time;
+    for (auto &lod : lodModels) {
+      if (lod->sceneTime > time)
+        return true;
+    }
+    return false;
+  }
+
+  void Instance::getInstancedModels(std::vector<Model *> &models)
+  {
+    Model *instanced = (Model *)getParamObject("model", nullptr);
+    if (instanced)
+      models.push_back(instanced);
+
+    Data *lodModelData = getParamData("lod.models");
+    if (lodModelData && lodModelData->type == OSP_OBJECT) {
+      for (size_t i = 0; i < lodModelData->numItems; i++) {
+        Model *lod = ((Model **)lodModelData->data)[i];
+        if (lod)
+          models.push_back(lod);
+      }
+    }
+  }
+
+  bool Instance::hasLOD() const
+  {
+    return lodModels.size() > 1;
+  }
+
+  bool Instance::selectLOD(Model *model, const vec3f &eye)
+  {
+    size_t level = 0;
+    if (!bounds.empty()) {
+      const float dist = length(center(bounds) - eye);
+      const float size = length(bounds.size()) / std::max(dist, 1e-6f);
+      while (level + 1 < lodModels.size() && size < lodSize[level + 1])
+        level++;
+    }
+
+    if (level == lodLevel)
+      return false;
+
+    lodLevel = level;
+    ispc::InstanceGeometry_setModel(getIE(), lodModels[level]->getIE());
+
+    // nested instances trace into their (current) model themselves
+    if (nested)
+      return false;
+
+    RTCGeometry embreeGeom = rtcGetGeometry(model->embreeSceneHandle,
+                                            embreeGeomID);
+    rtcSetGeometryInstancedScene(embreeGeom,
+                                 lodModels[level]->embreeSceneHandle);
+    rtcCommitGeometry(embreeGeom);
+    return true;
+  }
+
   OSP_REGISTER_GEOMETRY(Instance,instance);
 
 } // ::ospray
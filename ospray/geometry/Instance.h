@@ -35,6 +35,9 @@ namespace ospray {
     float3 "xfm.l.vz" // 1st column of the affine transformation matrix
     float3 "xfm.p"    // 4th column (translation) of the affine transformation matrix
     OSPModel "model"  // model we're instancing
+    Data<float3> "motion.transform" // 4 columns per time step, for motion blur
+    Data<OSPModel> "lod.models" // coarser levels of detail of "model"
+    Data<float> "lod.size" // projected size below which each level is used
     </pre>
 
     The functionality for this geometry is implemented via the
@@ -50,6 +53,16 @@ namespace ospray {
     virtual ~Instance() override = default;
     virtual std::string toString() const override;
     virtual void finalize(Model *model) override;
+    virtual bool changedSince(const size_t time) const override;
+
+    /*! \brief whether this instance has (coarser) levels of detail */
+    virtual bool hasLOD() const override;
+
+    /*! \brief switch to the level of detail for a camera at 'eye' */
+    virtual bool selectLOD(Model *model, const vec3f &eye) override;
+
+    /*! \brief the instanced model and its levels of detail */
+    virtual void getInstancedModels(std::vector<Model *> &models) override;
 
     // Data members //
 
@@ -62,6 +75,18 @@ namespace ospray {
     std::vector<float> areaPDF;
     /*! geometry ID of this geometry in the parent model */
     uint32        embreeGeomID;
+    /*! transformation per time step for motion blur, empty if static */
+    std::vector<AffineSpace3f> motionXfm;
+
+    /*! levels of detail, the first is 'instancedScene', each following
+        is used when the projected size of the instance (the diagonal
+        of its bounds divided by its distance) is below its 'lodSize' */
+    std::vector<Ref<Model>> lodModels;
+    std::vector<float> lodSize;
+    size_t lodLevel {0};
+    /*! whether the instanced model contains instances itself, then this
+        is an embree user geometry instead of an embree instance */
+    bool nested {false};
   };
 
 } // ::ospray
@@ -0,0 +1,127 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// ospray
+#include "InstanceArray.h"
+#include "common/Model.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// ispc exports
+#include "InstanceArray_ispc.h"
+
+namespace ospray {
+
+  InstanceArray::InstanceArray()
+  {
+    this->ispcEquivalent = ispc::InstanceArray_create(this);
+  }
+
+  std::string InstanceArray::toString() const
+  {
+    return "ospray::InstanceArray";
+  }
+
+  void InstanceArray::finalize(Model *model)
+  {
+    instancedScene = (Model *)getParamObject("model", nullptr);
+    if (!instancedScene)
+      throw std::runtime_error("an instance_array needs a 'model'");
+
+    // committed by Model::commitLazyDependencies
+    if (!instancedScene->embreeSceneHandle)
+      throw std::runtime_error("the model of an instance_array is not "
+                               "committed");
+
+    transformData = getParamData("transforms");
+    if (!transformData || (transformData->type != OSP_FLOAT3
+                           && transformData->type != OSP_FLOAT)) {
+      throw std::runtime_error("an instance_array needs 'transforms' of data "
+                               "type OSP_FLOAT3 or OSP_FLOAT");
+    }
+    const size_t numInstances =
+        transformData->numBytes / sizeof(AffineSpace3f);
+    const AffineSpace3f *xfm = (const AffineSpace3f *)transformData->data;
+
+    // the materialList is indexed per instance, otherwise the instanced
+    // geometries keep their materials
+    materialIDData = getParamData("materialIDs");
+    if (materialIDData) {
+      if (materialIDData->type != OSP_INT
+          || materialIDData->numItems < numInstances) {
+        throw std::runtime_error("the 'materialIDs' of an instance_array "
+                                 "must be OSP_INT, one per instance");
+      }
+      Geometry::finalize(model);
+    }
+
+    // the inverse transformations and the bounds, in parallel in chunks
+    const box3f b = instancedScene->bounds;
+    if (b.empty()) {
+      static WarnOnce warning("creating an instance_array of a model that "
+                              "does not have a valid bounding box");
+    }
+    rcpXfm.resize(numInstances);
+    const size_t chunkSize = 64 * 1024;
+    const size_t numChunks = (numInstances + chunkSize - 1) / chunkSize;
+    std::vector<box3f> chunkBounds(numChunks, empty);
+    tasking::parallel_for(numChunks, [&](size_t chunk) {
+      const size_t end = std::min(numInstances, (chunk + 1) * chunkSize);
+      for (size_t i = chunk * chunkSize; i < end; i++) {
+        rcpXfm[i] = rcp(xfm[i]);
+        if (!b.empty()) {
+          const vec3f center = xfmPoint(xfm[i], ospcommon::center(b));
+          const vec3f half = 0.5f * b.size();
+          const vec3f extent = abs(xfm[i].l.vx) * half.x
+                               + abs(xfm[i].l.vy) * half.y
+                               + abs(xfm[i].l.vz) * half.z;
+          chunkBounds[chunk].extend(box3f(center - extent, center + extent));
+        }
+      }
+    });
+    bounds = empty;
+    for (const auto &cb : chunkBounds)
+      bounds.extend(cb);
+
+    ispc::InstanceArray_set(getIE(),
+                            instancedScene->getIE(),
+                            (ispc::box3f&)b,
+                            int(numInstances),
+                            (ispc::AffineSpace3f*)xfm,
+                            (ispc::AffineSpace3f*)rcpXfm.data(),
+                            materialIDData ? (int*)materialIDData->data
+                                           : nullptr);
+
+    embreeGeomID = ispc::InstanceArray_attach(getIE(), model->getIE());
+  }
+
+  void InstanceArray::getInstancedModels(std::vector<Model *> &models)
+  {
+    Model *instanced = (Model *)getParamObject("model", nullptr);
+    if (instanced)
+      models.push_back(instanced);
+  }
+
+  bool InstanceArray::changedSince(const size_t time) const
+  {
+    // also the bounds of the instanced model may have changed
+    return Geometry::changedSince(time)
+      || (instancedScene && instancedScene->sceneTime > time);
+  }
+
+  OSP_REGISTER_GEOMETRY(InstanceArray,instance_array);
+
+} // ::ospray
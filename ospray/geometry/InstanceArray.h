@@ -0,0 +1,75 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "Geometry.h"
+#include "common/Data.h"
+
+namespace ospray {
+
+  /*! \defgroup geometry_instance_array Instance Arrays ("instance_array")
+
+    \brief Implements many instances of the same model with a single
+    geometry.
+
+    \ingroup ospray_supported_geometries
+
+    Once created, an instance array recognizes the following parameters
+    <pre>
+    OSPModel "model"  // model we're instancing
+    Data<float3> "transforms" // 4 columns per instance, like xfm.* of instances
+    Data<int32> "materialIDs" // optional, per instance index into "materialList"
+    </pre>
+
+    The functionality for this geometry is implemented via the
+    \ref ospray::InstanceArray class.
+  */
+
+  /*! \brief An array of instances of a single model
+
+    All instances are primitives of one embree user geometry, which
+    traces rays into the instanced model itself (like nested instances),
+    thus creating and committing millions of instances needs neither
+    millions of objects nor of API calls.
+   */
+  struct OSPRAY_SDK_INTERFACE InstanceArray : public Geometry
+  {
+    InstanceArray();
+    virtual ~InstanceArray() override = default;
+    virtual std::string toString() const override;
+    virtual void finalize(Model *model) override;
+    virtual bool changedSince(const size_t time) const override;
+
+    /*! \brief the instanced model */
+    virtual void getInstancedModels(std::vector<Model *> &models) override;
+
+    // Data members //
+
+    /*! reference to instanced model */
+    Ref<Model> instancedScene;
+    /*! the transformations, one AffineSpace3f per instance */
+    Ref<Data> transformData;
+    /*! optional per instance material IDs */
+    Ref<Data> materialIDData;
+    /*! the inverse transformations, for transforming rays */
+    std::vector<AffineSpace3f> rcpXfm;
+    /*! geometry ID of this geometry in the parent model */
+    uint32 embreeGeomID;
+  };
+
+} // ::ospray
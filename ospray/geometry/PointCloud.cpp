@@ -0,0 +1,590 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#undef NDEBUG
+
+// ospray
+#include "PointCloud.h"
+#include "GeometryBounds.h"
+#include "common/Data.h"
+#include "common/Model.h"
+#include "common/OSPCommon.h"
+#include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/tasking/schedule.h"
+// ispc-generated files
+#include "PointCloud_ispc.h"
+// std
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <thread>
+
+namespace ospray {
+
+  //! the octree during the build, flattened afterwards
+  struct PointCloud::BuildCell
+  {
+    vec3f lower;
+    float size;
+    float radius;
+    float spacing;
+    std::vector<Point> points;
+    std::vector<std::unique_ptr<BuildCell>> children;
+  };
+
+  namespace {
+
+    struct FileHeader
+    {
+      char magic[8];
+      uint64 numCells;
+      uint32 hasColor;
+      uint32 pad;
+    };
+
+    const char fileMagic[8] = {'O','S','P','P','C','L','D','1'};
+
+    //! the octree is not refined deeper, e.g. for coincident points
+    const int maxDepth = 21;
+
+    //! subtrees with more points are built in parallel
+    const size_t parallelBuildPoints = 1 << 20;
+
+    //! cells loaded from the file at the same time
+    const size_t maxPendingLoads = 64;
+
+    uint32 packColor(const vec4f &c)
+    {
+      const vec4f v = clamp(c, vec4f(0.f), vec4f(1.f)) * 255.f + 0.5f;
+      return uint32(v.x) | uint32(v.y) << 8 | uint32(v.z) << 16
+        | uint32(v.w) << 24;
+    }
+
+  } // ::ospray::{anonymous}
+
+  PointCloud::PointCloud()
+  {
+    this->ispcEquivalent = ispc::PointCloud_create(this);
+  }
+
+  PointCloud::~PointCloud()
+  {
+    // the background loads access this geometry
+    waitForLoads();
+  }
+
+  std::string PointCloud::toString() const
+  {
+    return "ospray::PointCloud";
+  }
+
+  void PointCloud::finalize(Model *model)
+  {
+    Geometry::finalize(model);
+
+    waitForLoads();
+    loaded.clear();
+    requests.clear();
+    pendingLoads = 0;
+
+    fileName   = getParamString("filename", "");
+    leafPoints = std::max(64, getParam1i("leafPoints", 16384));
+    lodSize    = std::max(0.f, getParam1f("lodSize", 0.001f));
+    maxPoints  = std::min<size_t>(std::max(1, getParam1i("maxPoints", 1 << 24)),
+                                  1 << 30);
+    maxMemory  = size_t(std::max(1, getParam1i("maxMemory", 1024))) << 20;
+    const float radius = getParam1f("radius", 0.01f);
+
+    Data *positionData = getParamData("position");
+    Data *colorData    = getParamData("color");
+
+    if (positionData) {
+      if (positionData->type != OSP_FLOAT3 && positionData->type != OSP_FLOAT3A)
+        throw std::runtime_error("#ospray:geometry/point_cloud: 'position' "
+                                 "must be OSP_FLOAT3 or OSP_FLOAT3A data");
+
+      hasColor = colorData != nullptr;
+      if (hasColor && colorData->type != OSP_UCHAR4
+          && colorData->type != OSP_FLOAT3 && colorData->type != OSP_FLOAT3A
+          && colorData->type != OSP_FLOAT4)
+        throw std::runtime_error("#ospray:geometry/point_cloud: 'color' must "
+                                 "be OSP_UCHAR4, OSP_FLOAT3, OSP_FLOAT3A or "
+                                 "OSP_FLOAT4 data");
+      if (hasColor && colorData->numItems < positionData->numItems)
+        throw std::runtime_error("#ospray:geometry/point_cloud: fewer 'color' "
+                                 "than 'position' items");
+
+      const size_t numPoints = positionData->numItems;
+      postStatusMsg(2) << "#osp: building 'point_cloud' geometry, #points = "
+                       << numPoints;
+
+      const size_t positionStride = positionData->compact() ?
+          sizeOf(positionData->type) : positionData->byteStride;
+      const size_t colorStride = !colorData ? 0 : colorData->compact() ?
+          sizeOf(colorData->type) : colorData->byteStride;
+
+      std::vector<Point> points(numPoints);
+      tasking::parallel_for(numPoints, [&](size_t i) {
+        points[i].position = *(const vec3f *)((const char *)positionData->data
+                                              + i * positionStride);
+        points[i].color = 0xffffffff;
+        if (!hasColor)
+          return;
+        const char *c = (const char *)colorData->data + i * colorStride;
+        if (colorData->type == OSP_UCHAR4)
+          points[i].color = *(const uint32 *)c;
+        else if (colorData->type == OSP_FLOAT4)
+          points[i].color = packColor(*(const vec4f *)c);
+        else
+          points[i].color = packColor(vec4f(*(const vec3f *)c, 1.f));
+      });
+
+      build(points, radius);
+
+      // with a file the hierarchy can be paged, otherwise it stays resident
+      paged = !fileName.empty() && write();
+      if (!fileName.empty() && !paged)
+        postStatusMsg() << "#osp: could not write point cloud '" << fileName
+                        << "'";
+    } else if (!fileName.empty()) {
+      read();
+      paged = true;
+    } else {
+      throw std::runtime_error("#ospray:geometry/point_cloud: neither "
+                               "'position' data nor a 'filename' specified");
+    }
+
+    lastUsed.assign(cells.size(), 0);
+    requested.assign(cells.size(), 0);
+    frame = 0;
+
+    // the root is always resident, as fallback for all cells not loaded yet
+    if (!isResident(0))
+      readCell(0, cellPoints[0]);
+    residentBytes = 0;
+    float maxRadius = radius;
+    for (size_t i = 0; i < cells.size(); i++) {
+      residentBytes += cellPoints[i].size() * sizeof(Point);
+      maxRadius = std::max(maxRadius, cells[i].radius);
+    }
+
+    bounds = box3f(cells[0].lower - maxRadius,
+                   cells[0].lower + cells[0].size + maxRadius);
+
+    // start with the root as cut, which also sizes the (native) spheres
+    embreeGeometry = nullptr;
+    nativeSpheres = false;
+    cut.clear();
+    setCut({0});
+
+    // as embree's native sphere primitive if possible, like spheres; the
+    // spheres of the cut are consecutive floats
+    int32 nativeGeomID = -1;
+#if RTC_VERSION >= 30600
+    RTCGeometry geom = rtcNewGeometry(ispc_embreeDevice(),
+                                      RTC_GEOMETRY_TYPE_SPHERE_POINT);
+    rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0,
+                               RTC_FORMAT_FLOAT4, spheres.data(), 0,
+                               sizeof(vec4f), spheres.size());
+    rtcCommitGeometry(geom);
+    nativeGeomID = model->attachGeometry(this, geom);
+    rtcReleaseGeometry(geom);
+    embreeGeometry = geom;
+    nativeSpheres = true;
+#endif
+
+    void *userGeometry =
+        ispc::PointCloud_set(getIE(),
+                             model->getIE(),
+                             materialList ? ispcMaterialPtrs.data() : nullptr,
+                             nativeGeomID);
+    if (!nativeSpheres)
+      embreeGeometry = (RTCGeometry)userGeometry;
+  }
+
+  bool PointCloud::hasLOD() const
+  {
+    return cells.size() > 1;
+  }
+
+  bool PointCloud::selectLOD(Model *, const vec3f &eye)
+  {
+    frame++;
+    publishLoaded();
+
+    // Refine the cells with the largest projected point spacing first,
+    // as long as it is larger than 'lodSize' and the points fit into the
+    // budget; cells with children not loaded yet stay in the cut and
+    // request them.
+    auto priority = [&](int32 id) {
+      const Cell &cell = cells[id];
+      const vec3f d = max(max(cell.lower - eye, eye - cell.lower - cell.size),
+                          vec3f(0.f));
+      return cell.spacing / std::max(length(d), 1e-6f * cell.size);
+    };
+
+    using Candidate = std::pair<float, int32>;
+    std::priority_queue<Candidate> queue;
+    std::vector<int32> newCut;
+    size_t numPoints = cells[0].numPoints;
+    queue.emplace(priority(0), 0);
+
+    while (!queue.empty()) {
+      const int32 id = queue.top().second;
+      const float p = queue.top().first;
+      queue.pop();
+
+      const Cell &cell = cells[id];
+      lastUsed[id] = frame;
+
+      bool refine = cell.numChildren > 0 && p > lodSize;
+      if (refine) {
+        size_t childPoints = 0;
+        for (int32 c = 0; c < cell.numChildren; c++) {
+          const int32 child = cell.firstChild + c;
+          childPoints += cells[child].numPoints;
+          if (!isResident(child)) {
+            requestCell(child);
+            refine = false;
+          }
+        }
+        if (numPoints - cell.numPoints + childPoints > maxPoints)
+          refine = false;
+        else if (refine)
+          numPoints += childPoints - cell.numPoints;
+      }
+
+      if (!refine) {
+        newCut.push_back(id);
+        continue;
+      }
+
+      for (int32 c = 0; c < cell.numChildren; c++) {
+        const int32 child = cell.firstChild + c;
+        queue.emplace(priority(child), child);
+      }
+    }
+
+    updateResidency();
+
+    std::sort(newCut.begin(), newCut.end());
+    if (newCut == cut)
+      return false;
+
+    setCut(newCut);
+    return true;
+  }
+
+  void PointCloud::build(std::vector<Point> &points, float radius)
+  {
+    const GeometryBounds positionBounds =
+      reduceBounds(points.size(), [&](size_t i) {
+        return box3f(points[i].position, points[i].position);
+      });
+    if (positionBounds.numInvalid > 0) {
+      postStatusMsg(1) << "#osp: " << positionBounds.numInvalid << " points "
+                       << "of the point cloud are not finite";
+    }
+    box3f pointBounds = positionBounds.bounds;
+    if (pointBounds.empty())
+      pointBounds = box3f(vec3f(0.f), vec3f(0.f));
+
+    // a cube, slightly enlarged to contain the upper points
+    BuildCell root;
+    root.lower = pointBounds.lower;
+    root.size  = std::max(reduce_max(pointBounds.size()), 1e-6f) * 1.0001f;
+
+    buildRadius = radius;
+    buildRec(root, points.data(), points.data() + points.size(), 0);
+
+    // flatten in breadth-first order, which keeps children consecutive
+    cells.clear();
+    cellPoints.clear();
+    std::vector<BuildCell *> order {&root};
+    uint64 pointOffset = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+      BuildCell &b = *order[i];
+      Cell cell;
+      cell.lower       = b.lower;
+      cell.size        = b.size;
+      cell.firstChild  = b.children.empty() ? -1 : int32(order.size());
+      cell.numChildren = int32(b.children.size());
+      cell.pointOffset = pointOffset;
+      cell.numPoints   = uint32(b.points.size());
+      cell.radius      = b.radius;
+      cell.spacing     = b.spacing;
+      cell.pad         = 0;
+      pointOffset += cell.numPoints;
+      for (auto &child : b.children)
+        order.push_back(child.get());
+      cells.push_back(cell);
+      cellPoints.push_back(std::move(b.points));
+    }
+
+    postStatusMsg(2) << "#osp: built 'point_cloud' octree with "
+                     << cells.size() << " cells";
+  }
+
+  void PointCloud::buildRec(BuildCell &cell, Point *begin, Point *end,
+                            int depth)
+  {
+    const size_t numPoints = end - begin;
+    if (numPoints <= size_t(leafPoints) || depth >= maxDepth) {
+      cell.points.assign(begin, end);
+      cell.radius  = buildRadius;
+      cell.spacing = 0.f;
+      return;
+    }
+
+    // the first point in each cell of a grid with about 'leafPoints' cells
+    const int res = std::max(2, int(std::cbrt(float(leafPoints))));
+    const float toGrid = res / cell.size;
+    std::vector<uint8_t> taken(res * res * res, 0);
+    for (const Point *p = begin; p < end; p++) {
+      const vec3i g = clamp(vec3i((p->position - cell.lower) * toGrid),
+                            vec3i(0), vec3i(res - 1));
+      uint8_t &t = taken[(g.z * res + g.y) * res + g.x];
+      if (!t) {
+        t = 1;
+        cell.points.push_back(*p);
+      }
+    }
+    cell.spacing = cell.size / res;
+    cell.radius  = std::max(buildRadius, 0.87f * cell.spacing);
+
+    // partition into octants, by z, then y, then x
+    const vec3f center = cell.lower + 0.5f * cell.size;
+    Point *split[9];
+    split[0] = begin;
+    split[8] = end;
+    split[4] = std::partition(split[0], split[8], [&](const Point &p) {
+      return p.position.z < center.z;
+    });
+    for (int i = 2; i < 8; i += 4) {
+      split[i] = std::partition(split[i - 2], split[i + 2], [&](const Point &p) {
+        return p.position.y < center.y;
+      });
+    }
+    for (int i = 1; i < 8; i += 2) {
+      split[i] = std::partition(split[i - 1], split[i + 1], [&](const Point &p) {
+        return p.position.x < center.x;
+      });
+    }
+
+    std::vector<std::pair<Point *, Point *>> ranges;
+    for (int o = 0; o < 8; o++) {
+      if (split[o] == split[o + 1])
+        continue;
+      std::unique_ptr<BuildCell> child(new BuildCell);
+      child->size  = 0.5f * cell.size;
+      child->lower = cell.lower
+        + child->size * vec3f(o & 1, (o >> 1) & 1, (o >> 2) & 1);
+      cell.children.push_back(std::move(child));
+      ranges.emplace_back(split[o], split[o + 1]);
+    }
+
+    auto buildChild = [&](size_t i) {
+      buildRec(*cell.children[i], ranges[i].first, ranges[i].second,
+               depth + 1);
+    };
+    if (numPoints > parallelBuildPoints)
+      tasking::parallel_for(ranges.size(), buildChild);
+    else
+      for (size_t i = 0; i < ranges.size(); i++)
+        buildChild(i);
+  }
+
+  bool PointCloud::write() const
+  {
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file)
+      return false;
+
+    FileHeader header;
+    std::copy(fileMagic, fileMagic + 8, header.magic);
+    header.numCells = cells.size();
+    header.hasColor = hasColor;
+    header.pad      = 0;
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)cells.data(), cells.size() * sizeof(Cell));
+    for (const auto &points : cellPoints)
+      file.write((const char *)points.data(), points.size() * sizeof(Point));
+
+    return bool(file);
+  }
+
+  void PointCloud::read()
+  {
+    std::ifstream file(fileName, std::ios::binary);
+    FileHeader header;
+    if (!file.read((char *)&header, sizeof(header))
+        || !std::equal(fileMagic, fileMagic + 8, header.magic)
+        || header.numCells == 0)
+      throw std::runtime_error("#ospray:geometry/point_cloud: '" + fileName
+                               + "' is not a point cloud file");
+
+    cells.resize(header.numCells);
+    if (!file.read((char *)cells.data(), cells.size() * sizeof(Cell)))
+      throw std::runtime_error("#ospray:geometry/point_cloud: could not read "
+                               "'" + fileName + "'");
+    hasColor = header.hasColor;
+
+    // the points are loaded on demand
+    cellPoints.clear();
+    cellPoints.resize(cells.size());
+
+    postStatusMsg(2) << "#osp: read 'point_cloud' octree with "
+                     << cells.size() << " cells from '" << fileName << "'";
+  }
+
+  void PointCloud::readCell(int32 cellID, std::vector<Point> &points) const
+  {
+    const Cell &cell = cells[cellID];
+    const size_t dataOffset = sizeof(FileHeader) + cells.size() * sizeof(Cell);
+
+    points.resize(cell.numPoints);
+    std::ifstream file(fileName, std::ios::binary);
+    file.seekg(dataOffset + cell.pointOffset * sizeof(Point));
+    if (!file.read((char *)points.data(), points.size() * sizeof(Point)))
+      throw std::runtime_error("#ospray:geometry/point_cloud: could not read "
+                               "'" + fileName + "'");
+  }
+
+  bool PointCloud::isResident(int32 cellID) const
+  {
+    return cells[cellID].numPoints == 0 || !cellPoints[cellID].empty();
+  }
+
+  void PointCloud::requestCell(int32 cellID)
+  {
+    if (requested[cellID])
+      return;
+    requested[cellID] = 1;
+    requests.push_back(cellID);
+  }
+
+  void PointCloud::publishLoaded()
+  {
+    std::vector<std::pair<int32, std::vector<Point>>> newCells;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      newCells.swap(loaded);
+    }
+    pendingLoads -= newCells.size();
+
+    for (auto &cell : newCells) {
+      const int32 id = cell.first;
+      if (cellPoints[id].empty()) {
+        cellPoints[id].swap(cell.second);
+        residentBytes += cellPoints[id].size() * sizeof(Point);
+      }
+      requested[id] = 0;
+      lastUsed[id] = frame;
+    }
+  }
+
+  void PointCloud::updateResidency()
+  {
+    if (!paged)
+      return;
+
+    // Evict the least recently used cells not in this frame's cut (or
+    // above it), never the root.
+    if (residentBytes > maxMemory) {
+      std::vector<std::pair<int32, int32>> candidates;
+      for (size_t i = 1; i < cells.size(); i++) {
+        if (!cellPoints[i].empty() && lastUsed[i] < frame)
+          candidates.emplace_back(lastUsed[i], int32(i));
+      }
+      std::sort(candidates.begin(), candidates.end());
+      for (const auto &c : candidates) {
+        if (residentBytes <= maxMemory)
+          break;
+        residentBytes -= cellPoints[c.second].size() * sizeof(Point);
+        std::vector<Point>().swap(cellPoints[c.second]);
+      }
+    }
+
+    // Load the requested cells in the background, the ones closest to the
+    // root (and thus requested first) first; requests over the limit are
+    // dropped and repeated in later frames.
+    for (const int32 id : requests) {
+      if (pendingLoads >= maxPendingLoads) {
+        requested[id] = 0;
+        continue;
+      }
+      pendingLoads++;
+      runningLoads++;
+      tasking::schedule([=]() {
+        std::vector<Point> points;
+        readCell(id, points);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          loaded.emplace_back(id, std::move(points));
+        }
+        runningLoads--;
+      });
+    }
+    requests.clear();
+  }
+
+  void PointCloud::setCut(const std::vector<int32> &newCut)
+  {
+    cut = newCut;
+
+    std::vector<size_t> offsets(cut.size() + 1, 0);
+    for (size_t i = 0; i < cut.size(); i++)
+      offsets[i + 1] = offsets[i] + cellPoints[cut[i]].size();
+
+    spheres.resize(offsets.back());
+    colors.resize(hasColor ? offsets.back() : 0);
+    tasking::parallel_for(cut.size(), [&](size_t i) {
+      const float radius = cells[cut[i]].radius;
+      const auto &points = cellPoints[cut[i]];
+      for (size_t j = 0; j < points.size(); j++) {
+        spheres[offsets[i] + j] = vec4f(points[j].position, radius);
+        if (hasColor)
+          colors[offsets[i] + j] = points[j].color;
+      }
+    });
+
+    ispc::PointCloud_setSpheres(getIE(),
+                                nativeSpheres ? nullptr : embreeGeometry,
+                                (ispc::vec4f *)spheres.data(),
+                                hasColor ? colors.data() : nullptr,
+                                spheres.size());
+    if (!embreeGeometry)
+      return;
+
+    if (nativeSpheres) {
+      rtcSetSharedGeometryBuffer(embreeGeometry, RTC_BUFFER_TYPE_VERTEX, 0,
+                                 RTC_FORMAT_FLOAT4, spheres.data(), 0,
+                                 sizeof(vec4f), spheres.size());
+    }
+    rtcCommitGeometry(embreeGeometry);
+  }
+
+  void PointCloud::waitForLoads()
+  {
+    while (runningLoads > 0)
+      std::this_thread::yield();
+  }
+
+  OSP_REGISTER_GEOMETRY(PointCloud, point_cloud);
+
+} // ::ospray
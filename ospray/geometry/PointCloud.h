@@ -0,0 +1,140 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "Geometry.h"
+// std
+#include <atomic>
+#include <mutex>
+
+namespace ospray {
+
+  /*! \brief A point cloud (e.g., a lidar scan) rendered as spheres, with an
+      octree as level of detail hierarchy.
+
+      Each cell of the octree holds a subsample of its points, with about
+      one point per cell of a grid and a radius covering that grid cell,
+      while the leaves hold all their points. Before each frame a cut
+      through the octree is selected by the projected spacing of the points
+      of the cells. The octree is built (in parallel) at commit from the
+      'position' data, or read from a file written by an earlier build, of
+      which only the cells needed are loaded (in the background) and kept
+      within a memory budget.
+   */
+  struct OSPRAY_SDK_INTERFACE PointCloud : public Geometry
+  {
+    PointCloud();
+    virtual ~PointCloud() override;
+
+    virtual std::string toString() const override;
+    virtual void finalize(Model *model) override;
+
+    virtual bool hasLOD() const override;
+    virtual bool selectLOD(Model *model, const vec3f &eye) override;
+
+    //! a point with its RGBA8 color, also the layout in the file
+    struct Point
+    {
+      vec3f position;
+      uint32 color;
+    };
+
+    //! a cell of the octree, also the layout in the file
+    struct Cell
+    {
+      vec3f lower;
+      float size;         //!< of the cube
+      int32 firstChild;   //!< the children are consecutive
+      int32 numChildren;
+      uint64 pointOffset; //!< of its points in the file
+      uint32 numPoints;
+      float radius;       //!< of its points
+      float spacing;      //!< of its points, for the selection
+      int32 pad;
+    };
+
+  private:
+
+    struct BuildCell;
+
+    //! build the octree over 'points' (reordering them), with 'radius' for
+    //  the points of the leaves
+    void build(std::vector<Point> &points, float radius);
+    void buildRec(BuildCell &cell, Point *begin, Point *end, int depth);
+
+    //! write the built octree to 'fileName', returns whether it succeeded
+    bool write() const;
+
+    //! read the octree (but not the points of its cells) from 'fileName'
+    void read();
+
+    //! read the points of a cell from 'fileName'
+    void readCell(int32 cellID, std::vector<Point> &points) const;
+
+    //! whether the points of the cell are in memory
+    bool isResident(int32 cellID) const;
+
+    //! request loading the points of a cell in the background
+    void requestCell(int32 cellID);
+
+    //! make the cells loaded meanwhile resident
+    void publishLoaded();
+
+    //! evict the least recently used cells over the memory budget, and
+    //  start loading the requested ones
+    void updateResidency();
+
+    //! the spheres of the cells in 'cut', for rendering
+    void setCut(const std::vector<int32> &newCut);
+
+    void waitForLoads();
+
+    std::string fileName;
+    bool paged {false}; //!< whether cells can be (re)loaded from the file
+    bool hasColor {false};
+    float lodSize {0.001f};
+    size_t maxPoints {0};
+    size_t maxMemory {0};
+    int32 leafPoints {0};
+    float buildRadius {0.f};
+
+    std::vector<Cell> cells;
+    std::vector<std::vector<Point>> cellPoints;
+    std::vector<int32> lastUsed; //!< frame in which each cell was visited
+    int32 frame {0};
+    size_t residentBytes {0};
+
+    //! the selected cells, and their points as spheres and colors
+    std::vector<int32> cut;
+    std::vector<vec4f> spheres;
+    std::vector<uint32> colors;
+
+    //! the attached embree geometry, and whether it is a native one
+    RTCGeometry embreeGeometry {nullptr};
+    bool nativeSpheres {false};
+
+    //! paging state: cells requested (in this frame or still loading), and
+    //  the loaded ones (but not yet resident), guarded by 'mutex'
+    std::vector<uint8_t> requested;
+    std::vector<int32> requests;
+    size_t pendingLoads {0};
+    std::vector<std::pair<int32, std::vector<Point>>> loaded;
+    std::atomic<int> runningLoads {0};
+    std::mutex mutex;
+  };
+
+} // ::ospray
@@ -16,19 +16,16 @@
 
 // ospray
 #include "QuadMesh.h"
+#include "GeometryBounds.h"
 #include "common/Model.h"
 #include "../include/ospray/ospray.h"
 // ispc exports
 #include "QuadMesh_ispc.h"
+#include <atomic>
 #include <cmath>
 
 namespace ospray {
 
-  inline bool inRange(int64 i, int64 i0, int64 i1)
-  {
-    return i >= i0 && i < i1;
-  }
-
   QuadMesh::QuadMesh()
   {
     this->ispcEquivalent = ispc::QuadMesh_create(this);
@@ -41,8 +38,31 @@ namespace ospray {
 
   void QuadMesh::finalize(Model *model)
   {
-    static int numPrints = 0;
-    numPrints++;
+    finalizeMesh(model, false);
+  }
+
+  bool QuadMesh::refit(Model *model)
+  {
+    // only the vertex positions may have changed, in the same layout
+    Data *newIndexData = getParamData("index");
+    Data *newVertexData = getParamData("vertex");
+    if (!staticTopology || !getParam1i("staticTopology", 0)
+        || getParamData("motion.vertex")
+        || eMeshScene != model->embreeSceneHandle
+        || newIndexData != indexData.ptr || !newVertexData
+        || newVertexData->type != vertexData->type
+        || newVertexData->numItems != vertexData->numItems)
+      return false;
+
+    finalizeMesh(model, true);
+    return true;
+  }
+
+  void QuadMesh::finalizeMesh(Model *model, const bool refitOnly)
+  {
+    // meshes get finalized in parallel
+    static std::atomic<int> numPrintsCounter {0};
+    const int numPrints = ++numPrintsCounter;
     if (numPrints == 5) {
       postStatusMsg(2) << "(all future printouts for quad mesh creation "
                        << "will be omitted)";
@@ -57,6 +77,7 @@ namespace ospray {
 
     RTCScene embreeSceneHandle = model->embreeSceneHandle;
 
+    Data *previousVertexData = vertexData.ptr;
     vertexData = getParamData("vertex");
     normalData = getParamData("vertex.normal",getParamData("normal"));
     colorData  = getParamData("vertex.color");
@@ -64,6 +85,7 @@ namespace ospray {
     indexData  = getParamData("index");
     prim_materialIDData = getParamData("prim.materialID");
     geom_materialID = getParam1i("geom.materialID",-1);
+    motionVertexData = getParamData("motion.vertex");
 
     if (!vertexData)
       throw std::runtime_error("quad mesh must have 'vertex' array");
@@ -72,12 +94,25 @@ namespace ospray {
     if (colorData && colorData->type != OSP_FLOAT4 && colorData->type != OSP_FLOAT3A)
       throw std::runtime_error("vertex.color must have data type OSP_FLOAT4 or OSP_FLOAT3A");
 
+    // motion blur: 'motion.vertex' holds the vertices of all time steps
+    size_t numTimeSteps = 1;
+    if (motionVertexData) {
+      numTimeSteps = motionVertexData->numItems / vertexData->numItems;
+      if (motionVertexData->type != vertexData->type || numTimeSteps < 2
+          || motionVertexData->numItems % vertexData->numItems != 0) {
+        throw std::runtime_error("motion.vertex must hold two or more time "
+                                 "steps of vertices like the 'vertex' array");
+      }
+    }
+
     // check whether we need 64-bit addressing
     bool huge_mesh = false;
     if (indexData->numBytes > INT32_MAX)
       huge_mesh = true;
     if (vertexData->numBytes > INT32_MAX)
       huge_mesh = true;
+    if (motionVertexData && motionVertexData->numBytes > INT32_MAX)
+      huge_mesh = true;
     if (normalData && normalData->numBytes > INT32_MAX)
       huge_mesh = true;
     if (colorData && colorData->numBytes > INT32_MAX)
@@ -95,6 +130,7 @@ namespace ospray {
     size_t numQuads  = -1;
     size_t numVerts = -1;
 
+    size_t numCompsInQuad = 4;
     size_t numCompsInVtx = 0;
     size_t numCompsInNor = 0;
     switch (indexData->type) {
@@ -123,19 +159,104 @@ namespace ospray {
       throw std::runtime_error("unsupported quadmesh.vertex.normal data type");
     }
 
-    auto eMeshGeom = rtcNewGeometry(ispc_embreeDevice(), RTC_GEOMETRY_TYPE_QUAD);
-    rtcSetSharedGeometryBuffer(eMeshGeom,RTC_BUFFER_TYPE_INDEX,0,RTC_FORMAT_UINT4,
-                               indexData->data,0,4*sizeof(int),numQuads);
-    rtcSetSharedGeometryBuffer(eMeshGeom,RTC_BUFFER_TYPE_VERTEX,0,RTC_FORMAT_FLOAT3,
-                               vertexData->data,0,numCompsInVtx*sizeof(int),numVerts);
-    rtcCommitGeometry(eMeshGeom);
-    eMeshID = rtcAttachGeometry(embreeSceneHandle,eMeshGeom);
-    rtcReleaseGeometry(eMeshGeom);
+    // strided views of interleaved arrays are used in place, their stride
+    // counted in components; flat arrays of scalars must be compact though
+    auto strideOf = [](const Data *data, size_t compactComps) {
+      if (data->compact())
+        return compactComps;
+      if (data->type == OSP_INT || data->type == OSP_UINT
+          || data->type == OSP_FLOAT) {
+        throw std::runtime_error("strided quadmesh arrays must have a "
+                                 "vector data type");
+      }
+      return size_t(data->componentStride());
+    };
+    numCompsInQuad = strideOf(indexData.ptr, numCompsInQuad);
+    numCompsInVtx = strideOf(vertexData.ptr, numCompsInVtx);
+    if (normalData)
+      numCompsInNor = strideOf(normalData.ptr, numCompsInNor);
+    if ((motionVertexData && !motionVertexData->compact())
+        || (prim_materialIDData && !prim_materialIDData->compact())) {
+      throw std::runtime_error("quadmesh motion.vertex and prim.materialID "
+                               "cannot be strided");
+    }
+
+    if (!refitOnly) {
+      const bool unsignedIndex = indexData->type == OSP_UINT
+        || indexData->type == OSP_UINT3 || indexData->type == OSP_UINT4;
+      const size_t numInvalid =
+        countInvalidIndices((const int32 *)indexData->data, numCompsInQuad, 4,
+                            numQuads, numVerts, unsignedIndex);
+      if (numInvalid > 0) {
+        throw std::runtime_error(std::to_string(numInvalid)
+                                 + " quadmesh indices are out of range of its "
+                                 + std::to_string(numVerts) + " vertices");
+      }
+    }
 
-    bounds = empty;
+    if (refitOnly) {
+      // same topology, embree just refits the BVH of the moved vertices
+      rtcSetSharedGeometryBuffer(eMeshGeom,RTC_BUFFER_TYPE_VERTEX,0,RTC_FORMAT_FLOAT3,
+                                 vertexData->data,0,numCompsInVtx*sizeof(int),numVerts);
+      rtcUpdateGeometryBuffer(eMeshGeom,RTC_BUFFER_TYPE_VERTEX,0);
+      rtcCommitGeometry(eMeshGeom);
+    } else {
+      staticTopology = getParam1i("staticTopology", 0);
+      eMeshGeom = rtcNewGeometry(ispc_embreeDevice(), RTC_GEOMETRY_TYPE_QUAD);
+      if (staticTopology)
+        rtcSetGeometryBuildQuality(eMeshGeom, RTC_BUILD_QUALITY_REFIT);
+      rtcSetSharedGeometryBuffer(eMeshGeom,RTC_BUFFER_TYPE_INDEX,0,RTC_FORMAT_UINT4,
+                                 indexData->data,0,numCompsInQuad*sizeof(int),numQuads);
+      if (motionVertexData) {
+        // the time steps are distributed evenly over the shutter interval
+        const size_t stride = numCompsInVtx*sizeof(int);
+        rtcSetGeometryTimeStepCount(eMeshGeom,numTimeSteps);
+        for (size_t t = 0; t < numTimeSteps; t++) {
+          rtcSetSharedGeometryBuffer(eMeshGeom,RTC_BUFFER_TYPE_VERTEX,t,RTC_FORMAT_FLOAT3,
+                                     motionVertexData->data,t*numVerts*stride,
+                                     stride,numVerts);
+        }
+      } else {
+        rtcSetSharedGeometryBuffer(eMeshGeom,RTC_BUFFER_TYPE_VERTEX,0,RTC_FORMAT_FLOAT3,
+                                   vertexData->data,0,numCompsInVtx*sizeof(int),numVerts);
+      }
+      rtcCommitGeometry(eMeshGeom);
+      eMeshID = model->attachGeometry(this, eMeshGeom);
+      rtcReleaseGeometry(eMeshGeom);
+      eMeshScene = embreeSceneHandle;
+    }
+
+    // refitting after only some vertices were marked modified just extends
+    // the bounds by those (which thus may stay conservatively larger)
+    size_t firstVertex = 0;
+    size_t endVertex = numVerts;
+    if (refitOnly && vertexData.ptr == previousVertexData) {
+      vertexData->modifiedSince(lastFinalized, firstVertex, endVertex);
+      if (vertexData->type == OSP_FLOAT) {
+        firstVertex /= 4;
+        endVertex = (endVertex + 3) / 4;
+      }
+    }
+    if (firstVertex == 0 && endVertex == numVerts)
+      bounds = empty;
+
+    GeometryBounds vertexBox = vertexBounds((const float *)vertexData->data,
+                                            numCompsInVtx,
+                                            firstVertex,
+                                            endVertex);
+    if (motionVertexData) {
+      vertexBox.extend(vertexBounds((const float *)motionVertexData->data,
+                                    numCompsInVtx,
+                                    0,
+                                    numTimeSteps*numVerts));
+    }
+    bounds.extend(vertexBox.bounds);
+    if (vertexBox.numInvalid > 0) {
+      postStatusMsg(1) << "#osp: " << vertexBox.numInvalid << " quadmesh "
+                       << "vertices are not finite, their quads are ignored";
+    }
 
-    for (uint32_t i = 0; i < numVerts*numCompsInVtx; i+=numCompsInVtx)
-      bounds.extend(*(vec3f*)(vertex + i));
+    lastFinalized = utility::TimeStamp();
 
     if (numPrints < 5) {
       postStatusMsg(2) << "  created quad mesh (" << numQuads << " quads "
@@ -147,8 +268,13 @@ namespace ospray {
                        eMeshGeom,
                        eMeshID,
                        numQuads,
+                       numCompsInQuad,
                        numCompsInVtx,
                        numCompsInNor,
+                       colorData && !colorData->compact() ?
+                           colorData->byteStride : sizeof(vec4f),
+                       texcoordData && !texcoordData->compact() ?
+                           texcoordData->byteStride : sizeof(vec2f),
                        (ispc::vec4i*)index,
                        (float*)vertex,
                        (float*)normal,
@@ -20,6 +20,7 @@
 #include "Slices.h"
 #include "common/Data.h"
 #include "common/Model.h"
+#include "ospcommon/tasking/parallel_for.h"
 // ispc-generated files
 #include "Slices_ispc.h"
 
@@ -30,6 +31,12 @@ namespace ospray {
     this->ispcEquivalent = ispc::Slices_create(this);
   }
 
+  Slices::~Slices()
+  {
+    if (ispcEquivalent)
+      ispc::Slices_cleanup(getIE());
+  }
+
   std::string Slices::toString() const
   {
     return "ospray::Slices";
@@ -48,6 +55,25 @@ namespace ospray {
 
     ispc::Slices_set(getIE(), model->getIE(), numPlanes,
                      (ispc::vec4f*)planes, volume->getIE());
+
+    // for static planes: resample the volume once, at its sampling step,
+    // into 2D samples per plane, which make shading as cheap as a texture
+    cacheSamples.clear();
+    if (!getParam<int>("cache", 0)) {
+      ispc::Slices_cleanup(getIE());
+      return;
+    }
+
+    std::vector<vec2i> sizes(numPlanes);
+    ispc::Slices_initCaches(getIE(), (ispc::vec2i*)sizes.data());
+    cacheSamples.resize(numPlanes);
+    for (size_t i = 0; i < numPlanes; i++) {
+      cacheSamples[i].resize(size_t(sizes[i].x) * sizes[i].y);
+      ispc::Slices_setCacheSamples(getIE(), i, cacheSamples[i].data());
+      tasking::parallel_for(sizes[i].y, [&](int y) {
+        ispc::Slices_resampleCache(getIE(), i, y);
+      });
+    }
   }
 
   OSP_REGISTER_GEOMETRY(Slices, slices);
@@ -35,6 +35,7 @@ namespace ospray {
     <dl>
     <dt><li><code>Data<vec4f> planes</code></dt><dd> Array of planes for all slices in this geometry. The vec4f for each plane consists of the (a,b,c,d) coefficients of the plane equation a*x + b*y + c*z + d = 0.</dd>
     <dt><li><code>Volume  volume </code></dt><dd> volume specifies the volume to be slices. The color of the slice will be mapped through the volume's transfer function.</dd>
+    <dt><li><code>bool    cache  </code></dt><dd> resample the volume on the planes once (when committed) and shade from these 2D samples.</dd>
     </dl>
 
     The functionality for this geometry is implemented via the
@@ -50,7 +51,7 @@ namespace ospray {
   struct OSPRAY_SDK_INTERFACE Slices : public Geometry
   {
     Slices();
-    virtual ~Slices() override = default;
+    virtual ~Slices() override;
     virtual std::string toString() const override;
     virtual void finalize(Model *model) override;
 
@@ -61,6 +62,9 @@ namespace ospray {
 
     size_t numPlanes;
     vec4f *planes;
+
+    //! the volume resampled on each plane, if the "cache" parameter is set
+    std::vector<std::vector<float>> cacheSamples;
   };
   /*! @} */
 
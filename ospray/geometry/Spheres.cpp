@@ -18,9 +18,11 @@
 
 // ospray
 #include "Spheres.h"
+#include "GeometryBounds.h"
 #include "common/Data.h"
 #include "common/Model.h"
 #include "common/OSPCommon.h"
+#include "ospcommon/tasking/parallel_for.h"
 // ispc-generated files
 #include "Spheres_ispc.h"
 
@@ -42,7 +44,6 @@ namespace ospray {
 
     radius            = getParam1f("radius",0.01f);
     materialID        = getParam1i("materialID",0);
-    bytesPerSphere    = getParam1i("bytes_per_sphere",4*sizeof(float));
     texcoordData      = getParamData("texcoord");
     offset_center     = getParam1i("offset_center",0);
     offset_radius     = getParam1i("offset_radius",-1);
@@ -52,6 +53,11 @@ namespace ospray {
     colorData         = getParamData("color");
     colorOffset       = getParam1i("color_offset",0);
 
+    // a strided view of interleaved data holds one sphere per item
+    const bool stridedSpheres = sphereData && !sphereData->compact();
+    bytesPerSphere    = getParam1i("bytes_per_sphere", stridedSpheres ?
+                                   sphereData->byteStride : 4*sizeof(float));
+
     if (colorData) {
       if (hasParam("color_format")) {
         colorFormat = static_cast<OSPDataType>(getParam1i("color_format",
@@ -71,8 +77,14 @@ namespace ospray {
       colorFormat = OSP_UNKNOWN;
     }
     colorStride = getParam1i("color_stride",
-                             colorFormat == OSP_UNKNOWN ?
-                             0 : sizeOf(colorFormat));
+                             colorFormat == OSP_UNKNOWN ? 0 :
+                             !colorData->compact() ? colorData->byteStride :
+                             sizeOf(colorFormat));
+
+    if (texcoordData && !texcoordData->compact()) {
+      throw std::runtime_error("#ospray:geometry/spheres: 'texcoord' data "
+                               "cannot be strided");
+    }
 
 
     if (sphereData.ptr == nullptr) {
@@ -80,7 +92,8 @@ namespace ospray {
                                "specified");
     }
 
-    numSpheres = sphereData->numBytes / bytesPerSphere;
+    numSpheres = stridedSpheres ? sphereData->numItems
+                                : sphereData->numBytes / bytesPerSphere;
     postStatusMsg(2) << "#osp: creating 'spheres' geometry, #spheres = "
                      << numSpheres;
 
@@ -94,13 +107,19 @@ namespace ospray {
                                "without causing address overflows)");
     }
 
-    const char* spherePtr = (const char*)sphereData->data;
-    bounds = empty;
-    for (uint32_t i = 0; i < numSpheres; i++, spherePtr += bytesPerSphere) {
-      const float r = offset_radius < 0 ?
-          radius : *(const float*)(spherePtr + offset_radius);
-      const vec3f center = *(const vec3f*)(spherePtr + offset_center);
-      bounds.extend(box3f(center - r, center + r));
+    const char* spheres = (const char*)sphereData->data;
+    const GeometryBounds sphereBounds =
+      reduceBounds(numSpheres, [&](size_t i) {
+        const char *spherePtr = spheres + i * bytesPerSphere;
+        const float r = offset_radius < 0 ?
+            radius : *(const float*)(spherePtr + offset_radius);
+        const vec3f center = *(const vec3f*)(spherePtr + offset_center);
+        return box3f(center - r, center + r);
+      });
+    bounds = sphereBounds.bounds;
+    if (sphereBounds.numInvalid > 0) {
+      postStatusMsg(1) << "#osp: " << sphereBounds.numInvalid << " spheres "
+                       << "have a non-finite center or radius";
     }
 
     // check whether we need 64-bit addressing
@@ -110,6 +129,39 @@ namespace ospray {
     if (texcoordData && texcoordData->numBytes > INT32_MAX)
       huge_mesh = true;
 
+    // spheres are much faster to build and traverse as embree's native
+    // sphere primitive, which needs center and radius as consecutive
+    // floats; otherwise we use (slower) user geometry callbacks
+    int32 embreeGeomID = -1;
+    nativeSpheres.clear();
+#if RTC_VERSION >= 30600
+    const bool alignedLayout = bytesPerSphere % sizeof(float) == 0
+      && offset_center % sizeof(float) == 0;
+    if (alignedLayout && (offset_radius < 0
+                          || offset_radius == offset_center + 3*sizeof(float))) {
+      RTCGeometry geom = rtcNewGeometry(ispc_embreeDevice(),
+                                        RTC_GEOMETRY_TYPE_SPHERE_POINT);
+      if (offset_radius < 0) {
+        // shared radius, thus need to add it to the spheres
+        nativeSpheres.resize(numSpheres);
+        tasking::parallel_for(numSpheres, [&](size_t i) {
+          const char *ptr = (const char*)sphereData->data + i * bytesPerSphere;
+          nativeSpheres[i] = vec4f(*(const vec3f*)(ptr + offset_center), radius);
+        });
+        rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0,
+                                   RTC_FORMAT_FLOAT4, nativeSpheres.data(), 0,
+                                   sizeof(vec4f), numSpheres);
+      } else {
+        rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0,
+                                   RTC_FORMAT_FLOAT4, sphereData->data,
+                                   offset_center, bytesPerSphere, numSpheres);
+      }
+      rtcCommitGeometry(geom);
+      embreeGeomID = model->attachGeometry(this, geom);
+      rtcReleaseGeometry(geom);
+    }
+#endif
+
     ispc::SpheresGeometry_set(getIE(),
                               model->getIE(),
                               sphereData->data,
@@ -128,7 +180,8 @@ namespace ospray {
                               offset_radius,
                               offset_materialID,
                               offset_colorID,
-                              huge_mesh);
+                              huge_mesh,
+                              embreeGeomID);
   }
 
   OSP_REGISTER_GEOMETRY(Spheres,spheres);
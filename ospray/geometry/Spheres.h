@@ -94,6 +94,12 @@ namespace ospray {
       color. color of sphere i will be read as colorFormat color from
       'colorOffset+i*colorStride */
     size_t colorOffset;
+
+  private:
+
+    /*! spheres with their shared radius, when using embree's native
+        sphere primitive without a per-sphere radius */
+    std::vector<vec4f> nativeSpheres;
   };
   /*! @} */
 
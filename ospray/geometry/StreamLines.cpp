@@ -18,6 +18,7 @@
 
 // ospray
 #include "StreamLines.h"
+#include "GeometryBounds.h"
 #include "common/Data.h"
 #include "common/Model.h"
 #include "ospcommon/utility/DataView.h"
@@ -71,23 +72,45 @@ namespace ospray {
 
     radiusData = getParamData("vertex.radius");
     if (radiusData && radiusData->type == OSP_FLOAT) {
-      radius.reset((const float*)radiusData->data);
+      radius.reset((const float*)radiusData->data, radiusData->byteStride);
       useCurve = true;
     }
 
+    if (!vertexData->compact() || !indexData->compact()
+        || (colorData && !colorData->compact())) {
+      throw std::runtime_error("streamlines 'vertex', 'index' and "
+                               "'vertex.color' cannot be strided");
+    }
+
     postStatusMsg(2) << "#osp: creating streamlines geometry, "
                      << "#verts=" << numVertices << ", "
                      << "#segments=" << numSegments << ", "
                      << "as curve: " << useCurve;
 
-    bounds = empty;
+    // each segment starts at vertex index[i] and ends at the next one
+    const size_t numInvalidIndices =
+      countInvalidIndices((const int32 *)index, 1, 1, numSegments,
+                          int64(numVertices) - 1, true);
+    if (numInvalidIndices > 0) {
+      throw std::runtime_error(std::to_string(numInvalidIndices)
+                               + " streamlines segments are out of range of "
+                               "its " + std::to_string(numVertices)
+                               + " vertices");
+    }
+
     // XXX curves may actually have a larger bounding box due to swinging
-    for (uint32_t i = 0; i < numSegments; i++) {
-      const uint32 idx = index[i];
-      bounds.extend(vertex[idx] - radius[idx]);
-      bounds.extend(vertex[idx] + radius[idx]);
-      bounds.extend(vertex[idx+1] - radius[idx+1]);
-      bounds.extend(vertex[idx+1] + radius[idx+1]);
+    const GeometryBounds segmentBounds =
+      reduceBounds(numSegments, [&](size_t i) {
+        const uint32 idx = index[i];
+        box3f b(vertex[idx] - radius[idx], vertex[idx] + radius[idx]);
+        b.extend(box3f(vertex[idx+1] - radius[idx+1],
+                       vertex[idx+1] + radius[idx+1]));
+        return b;
+      });
+    bounds = segmentBounds.bounds;
+    if (segmentBounds.numInvalid > 0) {
+      postStatusMsg(1) << "#osp: " << segmentBounds.numInvalid << " streamlines "
+                       << "segments have non-finite vertices or radius";
     }
 
     if (useCurve) {
@@ -132,9 +155,32 @@ namespace ospray {
       ispc::StreamLines_setCurve(getIE(),model->getIE(),
           (const ispc::vec3fa*)vertexCurve.data(), vertexCurve.size(),
           indexCurve.data(), numSegments, index, color);
-    } else
+    } else {
+      // embree's native round linear curves are exactly our segments
+      // (cylinders with spheres at the vertices), but with a curve
+      // optimized BVH; they need the radius in the vertices
+      int32 embreeGeomID = -1;
+      vertexCurve.clear();
+#if RTC_VERSION >= 30600
+      vertexCurve.resize(numVertices);
+      for (size_t i = 0; i < numVertices; i++)
+        vertexCurve[i] = vec4f(vec3f(vertex[i]), globalRadius);
+      RTCGeometry geom = rtcNewGeometry(ispc_embreeDevice(),
+                                        RTC_GEOMETRY_TYPE_ROUND_LINEAR_CURVE);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0,
+                                 RTC_FORMAT_FLOAT4, vertexCurve.data(), 0,
+                                 sizeof(vec4f), numVertices);
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0,
+                                 RTC_FORMAT_UINT, index, 0, sizeof(uint32),
+                                 numSegments);
+      rtcCommitGeometry(geom);
+      embreeGeomID = model->attachGeometry(this, geom);
+      rtcReleaseGeometry(geom);
+#endif
       ispc::StreamLines_set(getIE(),model->getIE(), globalRadius,
-          (const ispc::vec3fa*)vertex, numVertices, index, numSegments, color);
+          (const ispc::vec3fa*)vertex, numVertices, index, numSegments, color,
+          embreeGeomID);
+    }
   }
 
   OSP_REGISTER_GEOMETRY(StreamLines,streamlines);
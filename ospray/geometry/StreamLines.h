@@ -97,6 +97,7 @@ namespace ospray {
     size_t        numVertices {0};
     const uint32 *index {nullptr};
     size_t        numSegments {0};
+    //! vertices with radius, of the bezier or native linear curves
     std::vector<vec4f> vertexCurve;
     std::vector<uint32> indexCurve;
   };
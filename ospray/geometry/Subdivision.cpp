@@ -18,12 +18,20 @@
 #include "Subdivision.h"
 #include "common/Model.h"
 #include "../include/ospray/ospray.h"
+#include "ospcommon/utility/DataView.h"
 // ispc exports
 #include "Subdivision_ispc.h"
+#include <algorithm>
 #include <cmath>
 
 namespace ospray {
 
+  static bool isTessellationParam(const std::string &name)
+  {
+    return name == "level" || name == "level.eye"
+        || name == "level.edgeLength";
+  }
+
   Subdivision::Subdivision()
   {
     this->ispcEquivalent = ispc::Subdivision_create(this);
@@ -39,9 +47,9 @@ namespace ospray {
     Assert(model && "invalid model pointer");
     Geometry::finalize(model);
 
-    auto vertexData = getParamData("vertex",getParamData("position"));
-    auto indexData = getParamData("index");
-    auto facesData = getParamData("face");
+    vertexData = getParamData("vertex",getParamData("position"));
+    indexData = getParamData("index");
+    facesData = getParamData("face");
     auto edge_crease_indicesData = getParamData("edgeCrease.index");
     auto edge_crease_weightsData = getParamData("edgeCrease.weight");
     auto vertex_crease_indicesData = getParamData("vertexCrease.index");
@@ -80,6 +88,15 @@ namespace ospray {
       throw std::runtime_error("unsupported subdivision 'vertex.color' data type");
     if (texcoordData && texcoordData->type != OSP_FLOAT2)
       throw std::runtime_error("unsupported subdivision 'vertex.texcoord' data type");
+    // (strided views of the vertices, indices and colors go to embree)
+    if ((facesData && !facesData->compact())
+        || (!facesData && !indexData->compact())
+        || (texcoordData && !texcoordData->compact())
+        || (indexLevelData && !indexLevelData->compact())
+        || (prim_materialIDData && !prim_materialIDData->compact()))
+      throw std::runtime_error("subdivision 'face', 'vertex.texcoord', "
+                               "'index.level', 'prim.materialID' and (u)int4 "
+                               "'index' cannot be strided");
 
     vec3f* vertex = (vec3f*)vertexData->data;
     float* colors = colorsData ?(float*)colorsData->data : nullptr;
@@ -90,9 +107,11 @@ namespace ospray {
     auto geom = rtcNewGeometry(ispc_embreeDevice(), RTC_GEOMETRY_TYPE_SUBDIVISION);
 
     rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3,
-                               vertex, 0, sizeof(vec3f), vertexData->size());
+                               vertex, 0, vertexData->byteStride, vertexData->size());
     rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT,
-        indexData->data, 0, sizeof(unsigned int), indexData->size());
+        indexData->data, 0, indexData->compact() ? sizeof(unsigned int)
+                                                 : indexData->byteStride,
+        indexData->size());
     rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_FACE, 0, RTC_FORMAT_UINT,
         faces, 0, sizeof(unsigned int), numFaces);
 
@@ -129,7 +148,7 @@ namespace ospray {
     if (colors) {
       rtcSetGeometryVertexAttributeCount(geom,1);
       rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE, 0,
-          RTC_FORMAT_FLOAT4, colors, 0, sizeof(vec4f), colorsData->size());
+          RTC_FORMAT_FLOAT4, colors, 0, colorsData->byteStride, colorsData->size());
     }
 
     if (texcoord) {
@@ -138,24 +157,30 @@ namespace ospray {
           RTC_FORMAT_FLOAT2, texcoord, 0, sizeof(vec2f), texcoordData->size());
     }
 
-    if (!indexLevelData)
-      rtcSetGeometryTessellationRate(geom, level);
-    else {
+    edgeLevels.clear();
+    if (indexLevelData) {
       rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_LEVEL, 0, RTC_FORMAT_FLOAT, indexLevel,
                                  0, sizeof(float), indexLevelData->size());
-    }
+    } else if (computeEdgeLevels()) {
+      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_LEVEL, 0, RTC_FORMAT_FLOAT,
+                                 edgeLevels.data(), 0, sizeof(float), edgeLevels.size());
+    } else
+      rtcSetGeometryTessellationRate(geom, level);
 
     rtcCommitGeometry(geom);
-    auto eGeomID = rtcAttachGeometry(model->embreeSceneHandle, geom);
+    auto eGeomID = model->attachGeometry(this, geom);
     rtcReleaseGeometry(geom);
+    eGeom = geom;
+    eScene = model->embreeSceneHandle;
 
     bounds = empty;
 
     /* better bounds if some vertices are not referenced:
     for (auto i : indexData)
       bounds.extend(vertexData[i]); */
+    utility::DataView<vec3f> vertices(vertex, vertexData->byteStride);
     for (size_t i = 0; i < vertexData->size(); i++)
-      bounds.extend(vertex[i]);
+      bounds.extend(vertices[i]);
     //TODO: must factor in displacement into bounds....
 
 
@@ -171,6 +196,109 @@ namespace ospray {
                           materialList ? ispcMaterialPtrs.data() : nullptr,
                           (ispc::vec2f*)texcoord
                                          );
+
+    finalizedParams.clear();
+    std::for_each(params_begin(), params_end(),
+                  [&](std::shared_ptr<Param> &p) {
+                    if (!isTessellationParam(p->name))
+                      finalizedParams.emplace_back(p->name, p->data);
+                  });
+    lastFinalized = utility::TimeStamp();
+  }
+
+  bool Subdivision::refit(Model *model)
+  {
+    // only the adaptive edge levels need updates if nothing else changed;
+    // without adaptivity the (shared) level buffer becomes the uniform
+    // 'level' again, which needs a finalize
+    if (edgeLevels.empty() || eScene != model->embreeSceneHandle
+        || getParam1f("level.edgeLength", 0.f) <= 0.f
+        || !onlyTessellationChanged())
+      return false;
+
+    // levels are integers, thus an only slightly moved camera keeps the
+    // tessellation (cached by embree) as it is
+    if (computeEdgeLevels()) {
+      rtcUpdateGeometryBuffer(eGeom, RTC_BUFFER_TYPE_LEVEL, 0);
+      rtcCommitGeometry(eGeom);
+    }
+    return true;
+  }
+
+  bool Subdivision::onlyTessellationChanged()
+  {
+    size_t numParams = 0;
+    bool changed = false;
+    std::for_each(params_begin(), params_end(),
+                  [&](std::shared_ptr<Param> &p) {
+                    if (changed || isTessellationParam(p->name))
+                      return;
+                    // parameters keep their order, new ones are appended
+                    if (numParams >= finalizedParams.size()
+                        || finalizedParams[numParams].first != p->name
+                        || finalizedParams[numParams].second != p->data) {
+                      changed = true;
+                      return;
+                    }
+                    numParams++;
+                    // e.g. vertices updated in place
+                    if (p->data.is<OSP_PTR>()) {
+                      auto *obj = p->data.get<OSP_PTR>();
+                      changed = obj && obj->lastCommitted > lastFinalized;
+                    }
+                  });
+    return !changed && numParams == finalizedParams.size();
+  }
+
+  bool Subdivision::computeEdgeLevels()
+  {
+    const float edgeLength = getParam1f("level.edgeLength", 0.f);
+    if (edgeLength <= 0.f) {
+      edgeLevels.clear();
+      return false;
+    }
+
+    const float maxLevel = getParam1f("level", 5.f);
+    const bool cameraDriven = hasParam("level.eye");
+    const vec3f eye = getParam3f("level.eye", vec3f(0.f));
+
+    utility::DataView<vec3f> vertex(vertexData->data, vertexData->byteStride);
+    utility::DataView<uint32_t> index(indexData->data, indexData->compact() ?
+                                      sizeof(uint32_t) : indexData->byteStride);
+    const uint32_t *faces = facesData ? (const uint32_t*)facesData->data
+                                      : generatedFacesData.data();
+    const size_t numFaces = facesData ? facesData->size()
+                                      : generatedFacesData.size();
+
+    const size_t numEdges = indexData->compact() ?
+                            indexData->numBytes / sizeof(uint32_t) :
+                            indexData->numItems;
+    const bool resized = edgeLevels.size() != numEdges;
+    edgeLevels.resize(numEdges, 0.f);
+
+    // both half-edges of an edge get the same level (as needed for
+    // watertight tessellation), because it only depends on the edge
+    bool changed = resized;
+    size_t firstEdge = 0;
+    for (size_t f = 0; f < numFaces && firstEdge < numEdges; f++) {
+      const uint32_t n = faces[f];
+      for (uint32_t e = 0; e < n && firstEdge + e < numEdges; e++) {
+        const vec3f v0 = vertex[index[firstEdge + e]];
+        const vec3f v1 = vertex[index[firstEdge + (e + 1) % n]];
+        // the target length of a tessellated edge grows with the
+        // distance to the eye, i.e., is constant in screen space
+        float target = edgeLength;
+        if (cameraDriven)
+          target *= length(0.5f * (v0 + v1) - eye);
+        const float l = std::ceil(length(v1 - v0) / std::max(target, 1e-20f));
+        const float lvl = clamp(l, 1.f, maxLevel);
+        changed |= edgeLevels[firstEdge + e] != lvl;
+        edgeLevels[firstEdge + e] = lvl;
+      }
+      firstEdge += n;
+    }
+
+    return changed;
   }
 
   OSP_REGISTER_GEOMETRY(Subdivision,subdivision);
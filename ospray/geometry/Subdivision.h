@@ -27,8 +27,36 @@ namespace ospray {
     virtual ~Subdivision() override = default;
     virtual std::string toString() const override;
     virtual void finalize(Model *model) override;
+    virtual bool refit(Model *model) override;
   protected:
     std::vector<uint32_t> generatedFacesData;
+
+  private:
+
+    /*! adaptive tessellation ("level.edgeLength"): computes the level of
+        each edge of the cage into 'edgeLevels', returns whether any
+        level changed */
+    bool computeEdgeLevels();
+
+    std::vector<float> edgeLevels;
+
+    /*! whether nothing but the tessellation parameters ("level",
+        "level.eye", "level.edgeLength") changed since the last finalize,
+        including the contents of the data arrays */
+    bool onlyTessellationChanged();
+
+    //! all other parameters at the last finalize
+    std::vector<std::pair<std::string, utility::Any>> finalizedParams;
+    //! time stamp of the last finalize
+    size_t lastFinalized {0};
+
+    // the cage of the embree subdivision geometry, kept to only update
+    // the edge levels if just the tessellation parameters changed
+    Ref<Data> vertexData;
+    Ref<Data> indexData;
+    Ref<Data> facesData;
+    RTCGeometry eGeom {nullptr};
+    RTCScene eScene {nullptr};
   };
 
 } // ::ospray
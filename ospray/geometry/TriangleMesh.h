@@ -74,6 +74,7 @@ namespace ospray {
     virtual ~TriangleMesh() override = default;
     virtual std::string toString() const override;
     virtual void finalize(Model *model) override;
+    virtual bool refit(Model *model) override;
 
     int    *index;  //!< mesh's triangle index array
     float  *vertex; //!< mesh's vertex array
@@ -89,9 +90,21 @@ namespace ospray {
     Ref<Data> colorData;  /*!< vertex color array (vec3fa) */
     Ref<Data> texcoordData; /*!< vertex texcoord array (vec2f) */
     Ref<Data> prim_materialIDData;  /*!< data array for per-prim material ID (uint32) */
+    Ref<Data> motionVertexData; /*!< optional vertex positions of all time steps, for motion blur */
 
     #define RTC_INVALID_ID RTC_INVALID_GEOMETRY_ID
     uint32 eMeshID{RTC_INVALID_ID};   /*!< embree triangle mesh handle */
+
+    /*! with parameter "staticTopology" set, vertex updates refit the
+        embree geometry attached to this scene instead of rebuilding it */
+    bool staticTopology {false};
+    RTCGeometry eMeshGeom {nullptr};
+    RTCScene eMeshScene {nullptr};
+    /*! time stamp of the last finalize, to refit only vertices modified since */
+    size_t lastFinalized {0};
+
+  private:
+    void finalizeMesh(Model *model, const bool refitOnly);
   };
 
 } // ::ospray
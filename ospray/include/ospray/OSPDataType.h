@@ -73,6 +73,9 @@ typedef enum
   //! Unsigned 64-bit integer scalar and vector types.
   OSP_ULONG = 5550, OSP_ULONG2, OSP_ULONG3, OSP_ULONG4,
 
+  //! Half precision (16-bit) floating point scalar type.
+  OSP_HALF = 5900,
+
   //! Single precision floating point scalar and vector types.
   OSP_FLOAT = 6000, OSP_FLOAT2, OSP_FLOAT3, OSP_FLOAT4, OSP_FLOAT3A,
 
@@ -34,6 +34,13 @@ typedef enum
   OSP_TEXTURE_L8,
   OSP_TEXTURE_RA8,
   OSP_TEXTURE_LA8,
+  /*! block-compressed formats, 4x4 texels per block */
+  OSP_TEXTURE_BC1,
+  OSP_TEXTURE_BC1_SRGB,
+  OSP_TEXTURE_BC4,
+  OSP_TEXTURE_BC5,
+  OSP_TEXTURE_BC7,
+  OSP_TEXTURE_BC7_SRGB,
   /*! denotes an unknown texture format, so we can properly initialize parameters */
   OSP_TEXTURE_FORMAT_INVALID = 0xff,
 /* TODO
@@ -41,7 +48,7 @@ typedef enum
   OSP_RGBA16F
   OSP_RGB16F
   OSP_RGBE, // radiance hdr
-  compressed (RGTC, BPTC, ETC, ...)
+  compressed (BC6H, ETC, ASTC, ...)
 */
 } OSPTextureFormat;
 
@@ -52,6 +59,7 @@ typedef enum
 #endif
 {
   OSP_TEXTURE_SHARED_BUFFER = (1<<0),
-  OSP_TEXTURE_FILTER_NEAREST = (1<<1) /*!< use nearest-neighbor interpolation rather than the default bilinear interpolation */
+  OSP_TEXTURE_FILTER_NEAREST = (1<<1), /*!< use nearest-neighbor interpolation rather than the default bilinear interpolation */
+  OSP_TEXTURE_FILTER_MIPMAP = (1<<2) /*!< build a MIP map and filter trilinearly according to the ray footprint */
 } OSPTextureCreationFlags;
 
@@ -104,7 +104,10 @@ typedef enum
   OSP_FB_ACCUM=(1<<2),
   OSP_FB_VARIANCE=(1<<3),
   OSP_FB_NORMAL=(1<<4), // in world-space
-  OSP_FB_ALBEDO=(1<<5)
+  OSP_FB_ALBEDO=(1<<5),
+  OSP_FB_GEOMETRY_ID=(1<<6), // of the primary hit, as int32 (-1 if none)
+  OSP_FB_PRIMITIVE_ID=(1<<7),
+  OSP_FB_INSTANCE_ID=(1<<8)
 } OSPFrameBufferChannel;
 
 /*! flags that can be passed to OSPNewData; can be OR'ed together */
@@ -116,6 +119,28 @@ typedef enum
   OSP_DATA_SHARED_BUFFER = (1<<0),
 } OSPDataCreationFlags;
 
+/*! The arrangement of the sample positions of ospSampleVolumeBatch. */
+typedef enum
+# if __cplusplus >= 201103L
+: uint32_t
+#endif
+{
+  OSP_SAMPLE_POINTS, //!< an array of arbitrary positions
+  OSP_SAMPLE_LINE,   //!< equidistant positions along a line
+  OSP_SAMPLE_PLANE,  //!< a regular grid of positions in a plane
+} OSPSamplePatternType;
+
+/*! Flags of ospTraceRays, can be combined. */
+typedef enum
+# if __cplusplus >= 201103L
+: uint32_t
+#endif
+{
+  OSP_TRACE_DEFAULT = 0,
+  OSP_TRACE_NORMAL  = (1 << 0), //!< compute the normal at the hit point
+  OSP_TRACE_VOLUMES = (1 << 1), //!< integrate the volumes along the ray
+} OSPTraceFlags;
+
 #ifdef __cplusplus
 namespace osp {
   /*! namespace for classes in the public core API */
@@ -170,6 +195,7 @@ namespace osp {
   struct Texture          : public ManagedObject {};
   struct Light            : public ManagedObject {};
   struct PixelOp          : public ManagedObject {};
+  struct Future           : public ManagedObject {};
 
   struct amr_brick_info
   {
@@ -194,6 +220,7 @@ typedef osp::TransferFunction  *OSPTransferFunction;
 typedef osp::Texture           *OSPTexture  ;
 typedef osp::ManagedObject     *OSPObject;
 typedef osp::PixelOp           *OSPPixelOp;
+typedef osp::Future            *OSPFuture;
 
 /* C++ DOES support default initializers */
 #define OSP_DEFAULT_VAL(a) a
@@ -238,7 +265,8 @@ typedef struct _OSPManagedObject *OSPManagedObject,
   *OSPTransferFunction,
   *OSPTexture,
   *OSPObject,
-  *OSPPixelOp;
+  *OSPPixelOp,
+  *OSPFuture;
 
 /* C99 does NOT support default initializers, so we use this macro
    to define them away */
@@ -335,6 +363,100 @@ extern "C" {
   /*! set callback for given Device to call when an error occurs*/
   OSPRAY_INTERFACE void ospSetProgressFunc(OSPProgressFunc, void* userPtr);
 
+  //! asynchronously render a frame, returning immediately
+  /*! Same as ospRenderFrame, but returns a future handle to query the
+    frame in flight; the frame buffer must not be mapped, cleared or
+    rendered into again until the future has finished. The returned
+    future must be released with ospRelease. */
+  OSPRAY_INTERFACE OSPFuture ospRenderFrameAsync(OSPFrameBuffer,
+                                                 OSPRenderer,
+                                                 const uint32_t frameBufferChannels OSP_DEFAULT_VAL(=OSP_FB_COLOR));
+
+  /*! returns 1 if the frame of the given future has finished, 0 otherwise */
+  OSPRAY_INTERFACE int ospIsReady(OSPFuture);
+
+  /*! block until the frame of the given future has finished;
+    returns the same variance estimate as ospRenderFrame */
+  OSPRAY_INTERFACE float ospWait(OSPFuture);
+
+  /*! ask the frame of the given future to stop rendering early; this
+    does not block, use ospWait to wait for the frame to finish */
+  OSPRAY_INTERFACE void ospCancel(OSPFuture);
+
+  /*! returns the progress of the frame of the given future, in [0..1] */
+  OSPRAY_INTERFACE float ospGetProgress(OSPFuture);
+
+  /*! number of bins of OSPFrameStats::tileTimeHistogram */
+#define OSP_FRAME_STATS_TILE_BINS 16
+
+  /*! \brief statistics of the most recently rendered frame of a frame
+    buffer, all times are wall-clock seconds
+
+    Bin 0 of the tile time histogram counts tiles rendered in less than
+    2^-16 s (~15 us), bin i the ones which took [2^(i-17), 2^(i-16)) s,
+    the last bin all slower ones (more than ~0.25 s). With multiple
+    ranks the tile and ray statistics are the ones of the queried rank.
+    The average path length is (primaryRays + secondaryRays) /
+    primaryRays. */
+  typedef struct {
+    double  frameTime;    //< ospRenderFrame, begin to end
+    double  endFrameTime; //< finishing the frame, e.g., the error estimate
+    double  pixelOpTime;  //< in pixel operations like tone mapping, summed over all tiles
+    double  tileTimeMin;  //< fastest rendered tile
+    double  tileTimeMax;  //< slowest rendered tile
+    double  tileTimeSum;  //< summed over all rendered tiles
+    int     tilesRendered;
+    int     tilesSkipped; //< tiles skipped because they reached the varianceThreshold
+    int64_t samples;      //< number of samples (primary rays) taken
+    int64_t primaryRays;  //< traced from the camera
+    int64_t secondaryRays;//< path bounces and continuations through transparent surfaces
+    int64_t shadowRays;
+    int64_t aoRays;       //< ambient occlusion rays
+    int     tileTimeHistogram[OSP_FRAME_STATS_TILE_BINS];
+  } OSPFrameStats;
+
+  /*! returns the statistics of the last frame rendered into the given frame buffer */
+  OSPRAY_INTERFACE void ospGetFrameStats(OSPFrameBuffer, OSPFrameStats *);
+
+  /*! frame statistics callback function type, called with the statistics
+      of each frame once it finished */
+  typedef void (*OSPFrameStatsFunc)(void* userPtr,
+                                    OSPFrameBuffer,
+                                    const OSPFrameStats *);
+
+  /*! set callback for the current device to call at the end of each frame,
+      NULL disables it */
+  OSPRAY_INTERFACE void ospSetFrameStatsFunc(OSPFrameStatsFunc, void* userPtr);
+
+  /*! categories of objects whose memory is tracked, see ospGetMemoryTotals */
+  typedef enum {
+    OSP_MEMORY_DATA,        //< copies of data arrays (not shared ones)
+    OSP_MEMORY_MODEL,       //< Embree BVHs and geometry buffers
+    OSP_MEMORY_VOLUME,      //< voxels, GridAccelerator, AMR kd-tree, MinMaxBVH2
+    OSP_MEMORY_TEXTURE,     //< MIP levels
+    OSP_MEMORY_FRAMEBUFFER, //< pixel buffers, the tiles of distributed ones
+    OSP_MEMORY_CATEGORY_COUNT
+  } OSPMemoryCategory;
+
+  /*! \brief host memory held by an object or a category of objects, in
+    bytes
+
+    Only memory owned by an object is counted: the arrays of an object
+    are counted at their (not shared) data objects, memory mapped
+    acceleration structure caches are not counted. With multiple ranks
+    the memory is the one of the queried rank. */
+  typedef struct {
+    int64_t bytes;      //< all memory, including the acceleration structures
+    int64_t accelBytes; //< of that the acceleration structures
+    int64_t objects;    //< number of objects, 1 for a single object
+  } OSPMemoryUsage;
+
+  /*! returns the memory currently held by the given object */
+  OSPRAY_INTERFACE void ospGetMemoryUsage(OSPObject, OSPMemoryUsage *);
+
+  /*! returns the memory held by all existing objects of the given category */
+  OSPRAY_INTERFACE void ospGetMemoryTotals(OSPMemoryCategory, OSPMemoryUsage *);
+
   //! create a new renderer of given type
   /*! return 'NULL' if that type is not known */
   OSPRAY_INTERFACE OSPRenderer ospNewRenderer(const char *type);
@@ -455,6 +577,29 @@ extern "C" {
                                       const void *source,
                                       const uint32_t dataCreationFlags OSP_DEFAULT_VAL(=0));
 
+  /*! create a new data buffer of items that are 'byteStride' bytes apart
+    in 'source' (e.g. the positions within an array of interleaved
+    vertices); with OSP_DATA_SHARED_BUFFER this is a view of the
+    application's memory which geometries use without repacking, otherwise
+    the items are copied into a compact array. A 'byteStride' of 0 means
+    the items are adjacent.
+  */
+  OSPRAY_INTERFACE OSPData ospNewDataStrided(size_t numItems,
+                                             OSPDataType,
+                                             const void *source,
+                                             size_t byteStride,
+                                             const uint32_t dataCreationFlags OSP_DEFAULT_VAL(=0));
+
+  /*! mark the items [firstItem, firstItem+numItems) of a data array as
+    modified, e.g. after changing a shared buffer in place; the next commit
+    of the data then updates only what depends on these items (e.g. the
+    bricks of a shared structured volume, or the bounds of a refitted
+    mesh). Without marks, a commit changes all items.
+  */
+  OSPRAY_INTERFACE void ospDataMarkModified(OSPData,
+                                            size_t firstItem,
+                                            size_t numItems);
+
   /*! \} */
 
 
@@ -690,6 +835,13 @@ extern "C" {
   /*! \brief commit changes to an object */
   OSPRAY_INTERFACE void ospCommit(OSPObject);
 
+  /*! \brief commit changes to 'count' objects at once, which is much
+      faster than committing them one by one: each object is committed
+      once, after the objects of the batch it depends on (e.g. a model
+      after its geometries, which makes the model build its BVH only
+      once), and independent objects are committed in parallel */
+  OSPRAY_INTERFACE void ospCommitBatch(const OSPObject *objects, size_t count);
+
 
 #ifdef __cplusplus
   /*! \brief represents the result returned by an ospPick operation */
@@ -700,6 +852,11 @@ extern "C" {
 
   /*! \brief returns the world-space position of the geometry seen at [0-1] normalized screen-space pixel coordinates (if any) */
   OSPRAY_INTERFACE void ospPick(OSPPickResult*, OSPRenderer, const osp::vec2f &screenPos);
+
+  /*! \brief like ospPick, but for 'count' screen positions at once (which
+      is much faster for many positions) */
+  OSPRAY_INTERFACE void ospPickBatch(OSPPickResult*, OSPRenderer,
+                                     const osp::vec2f *screenPos, size_t count);
 #else
   typedef struct {
     osp_vec3f position; //< the position of the hit point (in world-space)
@@ -707,8 +864,63 @@ extern "C" {
   } OSPPickResult;
 
   OSPRAY_INTERFACE void ospPick(OSPPickResult*, OSPRenderer, const osp_vec2f *screenPos);
+  OSPRAY_INTERFACE void ospPickBatch(OSPPickResult*, OSPRenderer,
+                                     const osp_vec2f *screenPos, size_t count);
+#endif
+
+
+  /*! \brief a ray of ospTraceRays, the interval [tnear, tfar] along it
+      is in units of the length of 'dir' */
+#ifdef __cplusplus
+  typedef struct {
+    osp::vec3f org;
+    float tnear;
+    osp::vec3f dir;
+    float tfar;
+  } OSPTraceRay;
+
+  /*! \brief the result of a ray of ospTraceRays */
+  typedef struct {
+    float t;           //!< distance to the closest hit, inf if none
+    int geomID;        //!< geometry, primitive and instance hit (-1 if none)
+    int primID;
+    int instID;
+    osp::vec3f normal; //!< (normalized) world-space geometry normal
+    float volume;      //!< the integral of the volumes along the ray
+  } OSPTraceHit;
+#else
+  typedef struct {
+    osp_vec3f org;
+    float tnear;
+    osp_vec3f dir;
+    float tfar;
+  } OSPTraceRay;
+
+  typedef struct {
+    float t;
+    int geomID;
+    int primID;
+    int instID;
+    osp_vec3f normal;
+    float volume;
+  } OSPTraceHit;
 #endif
 
+  /*! \brief traces 'count' arbitrary rays against the committed model,
+      in parallel streams, e.g. for visibility or sensor simulations
+
+    \param hits (provided by the application) receives one OSPTraceHit per
+    ray; its normal is only set with OSP_TRACE_NORMAL, and the integral
+    of the (sampled values of the) volumes along the ray up to the hit
+    (in world-space distance) only with OSP_TRACE_VOLUMES, 0 otherwise
+
+    \param flags a combination of OSPTraceFlags
+  */
+  OSPRAY_INTERFACE void ospTraceRays(OSPModel,
+                                     const OSPTraceRay *rays,
+                                     size_t count,
+                                     OSPTraceHit *hits,
+                                     uint32_t flags);
 
   /*! \brief Samples the given volume at the provided world-space coordinates.
 
@@ -719,7 +931,8 @@ extern "C" {
 
     This function is meant to provide a _small_ number of samples
     as needed for data probes, etc. in applications. It is not
-    intended for large-scale sampling of volumes.
+    intended for large-scale sampling of volumes, see
+    ospSampleVolumeBatch for that.
   */
 #ifdef __cplusplus
   OSPRAY_INTERFACE void ospSampleVolume(float **results,
@@ -733,6 +946,54 @@ extern "C" {
                                         const size_t count);
 #endif
 
+  /*! \brief The sample positions of ospSampleVolumeBatch: for
+    OSP_SAMPLE_POINTS the 'count[0]' positions in 'points', for
+    OSP_SAMPLE_LINE the 'count[0]' positions 'origin + i*du', and for
+    OSP_SAMPLE_PLANE the 'count[0]' x 'count[1]' positions
+    'origin + i*du + j*dv' (with 'i' varying fastest). */
+#ifdef __cplusplus
+  typedef struct {
+    OSPSamplePatternType type;
+    const osp::vec3f *points;
+    osp::vec3f origin;
+    osp::vec3f du;
+    osp::vec3f dv;
+    size_t count[2];
+  } OSPSamplePattern;
+#else
+  typedef struct {
+    OSPSamplePatternType type;
+    const osp_vec3f *points;
+    osp_vec3f origin;
+    osp_vec3f du;
+    osp_vec3f dv;
+    size_t count[2];
+  } OSPSamplePattern;
+#endif
+
+  /*! \brief Samples the given volume at the positions of a sample pattern,
+    in parallel, for large numbers of samples.
+
+    \param values (provided by the application) receives one sampled value
+    per position (NaN outside of the volume)
+
+    \param gradients (provided by the application, may be NULL) receives the
+    gradient of the volume at each position
+
+    Structured, unstructured and AMR volumes are supported.
+  */
+#ifdef __cplusplus
+  OSPRAY_INTERFACE void ospSampleVolumeBatch(OSPVolume,
+                                             const OSPSamplePattern *,
+                                             float *values,
+                                             osp::vec3f *gradients);
+#else
+  OSPRAY_INTERFACE void ospSampleVolumeBatch(OSPVolume,
+                                             const OSPSamplePattern *,
+                                             float *values,
+                                             osp_vec3f *gradients);
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
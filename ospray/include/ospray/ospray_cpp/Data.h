@@ -27,8 +27,12 @@ public:
 
   Data(size_t numItems, OSPDataType format,
        const void *init = nullptr, int flags = 0);
+  Data(size_t numItems, OSPDataType format,
+       const void *init, size_t byteStride, int flags);
   Data(const Data &copy);
   Data(OSPData existing);
+
+  void markModified(size_t firstItem, size_t numItems) const;
 };
 
 // Inlined function definitions ///////////////////////////////////////////////
@@ -39,6 +43,12 @@ inline Data::Data(size_t numItems, OSPDataType format,
   ospObject = ospNewData(numItems, format, init, flags);
 }
 
+inline Data::Data(size_t numItems, OSPDataType format,
+                  const void *init, size_t byteStride, int flags)
+{
+  ospObject = ospNewDataStrided(numItems, format, init, byteStride, flags);
+}
+
 inline Data::Data(const Data &copy) :
   ManagedObject_T<OSPData>(copy.handle())
 {
@@ -49,5 +59,10 @@ inline Data::Data(OSPData existing) :
 {
 }
 
+inline void Data::markModified(size_t firstItem, size_t numItems) const
+{
+  ospDataMarkModified(handle(), firstItem, numItems);
+}
+
 }// namespace cpp
 }// namespace ospray
@@ -21,6 +21,8 @@
 #include <ospray/ospray_cpp/ManagedObject.h>
 #include <ospray/ospray_cpp/Material.h>
 
+#include <vector>
+
 namespace ospray {
   namespace cpp    {
 
@@ -35,6 +37,8 @@ namespace ospray {
       float renderFrame(const FrameBuffer &fb, uint32_t channels) const;
 
       OSPPickResult pick(const ospcommon::vec2f &screenPos) const;
+      std::vector<OSPPickResult>
+      pick(const std::vector<ospcommon::vec2f> &screenPos) const;
     };
 
     // Inlined function definitions ///////////////////////////////////////////
@@ -72,6 +76,15 @@ namespace ospray {
       return result;
     }
 
+    inline std::vector<OSPPickResult>
+    Renderer::pick(const std::vector<ospcommon::vec2f> &screenPos) const
+    {
+      std::vector<OSPPickResult> results(screenPos.size());
+      ospPickBatch(results.data(), handle(),
+                   (const osp::vec2f*)screenPos.data(), screenPos.size());
+      return results;
+    }
+
 
   }// namespace cpp
 }// namespace ospray
@@ -46,6 +46,10 @@ public:
                     const ospcommon::vec3f *worldCoordinates,
                     size_t count) const;
   std::vector<float> sampleVolume(const std::vector<ospcommon::vec3f> &points) const;
+
+  void sampleVolumeBatch(const OSPSamplePattern &pattern,
+                         float *values,
+                         ospcommon::vec3f *gradients = nullptr) const;
 };
 
 // Inlined function definitions ///////////////////////////////////////////////
@@ -91,6 +95,16 @@ inline void Volume::sampleVolume(float **results,
                   count);
 }
 
+inline void Volume::sampleVolumeBatch(const OSPSamplePattern &pattern,
+                                      float *values,
+                                      ospcommon::vec3f *gradients) const
+{
+  ospSampleVolumeBatch(handle(),
+                       &pattern,
+                       values,
+                       (osp::vec3f *)gradients);
+}
+
 inline std::vector<float>
 Volume::sampleVolume(const std::vector<ospcommon::vec3f> &points) const
 {
@@ -16,9 +16,86 @@
 
 #include "HDRILight.h"
 #include "HDRILight_ispc.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <cmath>
+#include <map>
+#include <mutex>
 
 namespace ospray {
 
+  namespace {
+
+    // accumulate and normalize f into a cdf like Distribution1D_create,
+    // returns the sum
+    float createCDF(float *f, int size)
+    {
+      float sum = f[0];
+      for (int i = 1; i < size; i++)
+        f[i] = sum += f[i];
+
+      const float rcpSum = 1.f/sum;
+      // handle cornercases (sum=0 -> rcpSum=inf; correct termination of
+      // sampling with s=1.0f)
+      const float nextAfter1 = std::nextafter(1.f, 2.f);
+      for (int i = 0; i < size; i++)
+        f[i] = f[i] >= sum ? nextAfter1 : f[i] * rcpSum;
+
+      return sum;
+    }
+
+    std::shared_ptr<HDRILight::Distribution>
+    createDistribution(const Texture2D *map, const vec2i &size)
+    {
+      auto distribution = std::make_shared<HDRILight::Distribution>();
+      auto &cdf_x = distribution->cdf_x;
+      auto &cdf_y = distribution->cdf_y;
+      cdf_x.resize(size_t(size.x) * size.y);
+      cdf_y.resize(size.y);
+
+      tasking::parallel_for(size.y, [&](int y) {
+        float *row = &cdf_x[size_t(y) * size.x];
+        ispc::HDRILight_calcRowImportance(map->getIE(), y, row);
+        cdf_y[y] = createCDF(row, size.x);
+      });
+      createCDF(cdf_y.data(), size.y);
+
+      return distribution;
+    }
+
+    // the distributions of the maps in use, looked up by map and its last
+    // commit, such that recommitting a light (e.g., for a new intensity or
+    // direction) or using a map for several lights computes it only once
+    std::shared_ptr<HDRILight::Distribution>
+    getDistribution(const Texture2D *map, const vec2i &size)
+    {
+      using Key = std::pair<const Texture2D *, size_t>;
+      static std::map<Key, std::weak_ptr<HDRILight::Distribution>> cache;
+      static std::mutex mutex;
+
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // forget the distributions no longer used by any light
+      for (auto it = cache.begin(); it != cache.end();) {
+        if (it->second.expired())
+          it = cache.erase(it);
+        else
+          ++it;
+      }
+
+      auto &entry = cache[Key(map, map->lastCommitted)];
+      auto distribution = entry.lock();
+      if (!distribution) {
+        distribution = createDistribution(map, size);
+        entry = distribution;
+      }
+
+      return distribution;
+    }
+
+  } // ::anonymous
+
   HDRILight::HDRILight()
   {
     ispcEquivalent = ispc::HDRILight_create();
@@ -48,10 +125,20 @@ namespace ospray {
     frame.vy = normalize(cross(frame.vx, up));
     frame.vz = cross(frame.vx, frame.vy);
 
+    const vec2i size = map ? map->getParam<vec2i>("size", vec2i(0)) : vec2i(0);
+    if (size.x > 0 && size.y > 0)
+      distribution = getDistribution(map, size);
+    else {
+      map = nullptr;
+      distribution = nullptr;
+    }
+
     ispc::HDRILight_set(getIE(),
                         (const ispc::LinearSpace3f&)frame,
                         map ? map->getIE() : nullptr,
-                        intensity);
+                        intensity,
+                        distribution ? distribution->cdf_x.data() : nullptr,
+                        distribution ? distribution->cdf_y.data() : nullptr);
   }
 
   OSP_REGISTER_LIGHT(HDRILight, hdri);
@@ -18,6 +18,9 @@
 
 #include "Light.h"
 #include "texture/Texture2D.h"
+// std
+#include <memory>
+#include <vector>
 
 namespace ospray {
 
@@ -30,6 +33,14 @@ namespace ospray {
     virtual std::string toString() const override;
     virtual void commit() override;
 
+    //! The importance sampling cdfs of a map, shared by all lights using
+    //!  the same (commit of the) map
+    struct Distribution
+    {
+      std::vector<float> cdf_x; //!< size.x*size.y elements, per row
+      std::vector<float> cdf_y; //!< size.y elements
+    };
+
   private:
     vec3f up {0.f, 1.f, 0.f}; //!< up direction of the light in world-space
     vec3f dir {0.f, 0.f, 1.f};//!< direction to which the center of the envmap
@@ -39,6 +50,7 @@ namespace ospray {
 //    bool  mirror;             //!< TODO whether to mirror the map
     Texture2D *map {nullptr};//!< environment map in latitude / longitude format
     float intensity {1.f};   //!< Amount of light emitted
+    std::shared_ptr<Distribution> distribution;
   };
 
 } // ::ospray
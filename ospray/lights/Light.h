@@ -34,6 +34,27 @@ namespace ospray {
     //! toString is used to aid in printf debugging
     virtual std::string toString() const override;
 
+    //! Spatial and directional bounds of the emission of a light, used to
+    //  importance sample it among many lights
+    struct SamplingBounds
+    {
+      box3f bounds;     //!< of the emitting positions
+      vec3f axis;       //!< principal direction of the emission
+      float cosThetaO;  //!< cosine of the spread of the normals around axis
+      float cosThetaE;  //!< cosine of the emission angle around the normals
+      float power;      //!< emitted power (luminance)
+    };
+
+    //! Return false if the light cannot be bounded (e.g., it is at infinity)
+    virtual bool getSamplingBounds(SamplingBounds &) const { return false; }
+
+  protected:
+
+    static float luminance(const vec3f &c)
+    { return 0.212671f*c.x + 0.715160f*c.y + 0.072169f*c.z; }
+
+  public:
+
     bool isVisible; //!< either directly in camera, or via a straight path
   };
 
@@ -42,6 +42,16 @@ namespace ospray {
                          (ispc::vec3f&)power, radius);
   }
 
+  bool PointLight::getSamplingBounds(SamplingBounds &b) const
+  {
+    b.bounds = box3f(position - radius, position + radius);
+    b.axis = vec3f(0.f, 0.f, 1.f);
+    b.cosThetaO = -1.f; // emitting into all directions
+    b.cosThetaE = 0.f;
+    b.power = 4.f * float(pi) * intensity * luminance(color);
+    return true;
+  }
+
   OSP_REGISTER_LIGHT(PointLight, PointLight);
   OSP_REGISTER_LIGHT(PointLight, point);
   OSP_REGISTER_LIGHT(PointLight, SphereLight);
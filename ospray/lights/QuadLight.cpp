@@ -47,6 +47,21 @@ namespace ospray {
                         (ispc::vec3f&)radiance);
   }
 
+  bool QuadLight::getSamplingBounds(SamplingBounds &b) const
+  {
+    b.bounds = box3f(position);
+    b.bounds.extend(position + edge1);
+    b.bounds.extend(position + edge2);
+    b.bounds.extend(position + edge1 + edge2);
+    const vec3f n = cross(edge1, edge2);
+    const float area = length(n);
+    b.axis = area > 0.f ? n / area : vec3f(0.f, 0.f, 1.f);
+    b.cosThetaO = 1.f;
+    b.cosThetaE = 0.f; // emitting into the hemisphere
+    b.power = float(pi) * area * intensity * luminance(color);
+    return true;
+  }
+
   OSP_REGISTER_LIGHT(QuadLight, QuadLight);
   OSP_REGISTER_LIGHT(QuadLight, quad); // actually a parallelogram
 
@@ -28,6 +28,7 @@ namespace ospray {
     virtual ~QuadLight() override = default;
     virtual std::string toString() const override;
     virtual void commit() override;
+    virtual bool getSamplingBounds(SamplingBounds &) const override;
 
   private:
     vec3f position {0.f};       //!< world-space corner position of the light
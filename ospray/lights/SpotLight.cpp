@@ -58,6 +58,18 @@ namespace ospray {
                         radius);
   }
 
+  bool SpotLight::getSamplingBounds(SamplingBounds &b) const
+  {
+    const float cosAngleMax = ospcommon::cos(deg2rad(0.5f*openingAngle));
+    b.bounds = box3f(position - radius, position + radius);
+    b.axis = direction;
+    b.cosThetaO = cosAngleMax;
+    b.cosThetaE = 0.f;
+    b.power = 2.f * float(pi) * (1.f - cosAngleMax) * intensity
+              * luminance(color);
+    return true;
+  }
+
   OSP_REGISTER_LIGHT(SpotLight, SpotLight);
   OSP_REGISTER_LIGHT(SpotLight, ExtendedSpotLight);
   OSP_REGISTER_LIGHT(SpotLight, spot);
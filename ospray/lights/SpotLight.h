@@ -28,6 +28,7 @@ namespace ospray {
     virtual ~SpotLight() override = default;
     virtual std::string toString() const override;
     virtual void commit() override;
+    virtual bool getSamplingBounds(SamplingBounds &) const override;
 
   private:
     vec3f position {0.f};           //!< world-space position of the light
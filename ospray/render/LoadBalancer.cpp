@@ -18,32 +18,86 @@
 #include "LoadBalancer.h"
 #include "Renderer.h"
 #include "api/Device.h"
+#include "fb/TilePool.h"
+#include "ospcommon/sysinfo.h"
 #include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/utility/Profiler.h"
+// std
+#include <algorithm>
+#include <thread>
 
 namespace ospray {
 
   std::unique_ptr<TiledLoadBalancer> TiledLoadBalancer::instance {};
 
-  /*! render a frame via the tiled load balancer */
-  float LocalTiledLoadBalancer::renderFrame(Renderer *renderer,
-                                            FrameBuffer *fb,
-                                            const uint32 channelFlags)
+  /*! spread the lower 16 bits of x to the even bits of the result */
+  static inline uint32 spreadBits(uint32 x)
   {
-    Assert(renderer);
-    Assert(fb);
+    x &= 0x0000ffff;
+    x = (x | (x << 8)) & 0x00ff00ff;
+    x = (x | (x << 4)) & 0x0f0f0f0f;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+  }
+
+  static inline uint32 mortonCode(const vec2i &tileID)
+  {
+    return spreadBits(tileID.x) | (spreadBits(tileID.y) << 1);
+  }
+
+  /*! a frame in flight: its tiles can be rendered by the threads of any
+      frame, see LocalTiledLoadBalancer::renderFrame */
+  struct LocalTiledLoadBalancer::Frame
+  {
+    Frame(Renderer *renderer, FrameBuffer *fb, int numNodes)
+      : renderer(renderer), fb(fb), nodeTiles(numNodes), nextTile(numNodes)
+    {
+      for (auto &next : nextTile)
+        next = 0;
+    }
+
+    //! claims and renders the next tile, returns false if none is left
+    bool renderNextTile();
+
+    Renderer    *renderer;
+    FrameBuffer *fb;
+    void        *perFrameData {nullptr};
+    int32        priority {0};
+
+    //! the tiles to render, per NUMA node owning their frame buffer memory
+    std::vector<std::vector<int>> nodeTiles;
+    std::vector<std::atomic<int>> nextTile;
+    std::atomic<int> tilesLeft {0}; //!< not yet finished
+    std::atomic<int> helpers {0};   //!< threads of other frames helping
+    std::atomic<int> pixelsDone {0};
+    float rcpPixels {1.f};
+    std::atomic<bool> cancel {false};
+  };
 
-    void *perFrameData = renderer->beginFrame(fb);
-    bool cancel = false;
-    std::atomic<int> pixelsDone{0};
-    const float rcpPixels = 1.0f/(fb->size.x * fb->size.y);
-
-    tasking::parallel_for(fb->getTotalTiles(), [&](int taskIndex) {
-      if (cancel)
-        return;
-      const size_t numTiles_x = fb->getNumTiles().x;
-      const size_t tile_y = taskIndex / numTiles_x;
-      const size_t tile_x = taskIndex - tile_y*numTiles_x;
-      const vec2i tileID(tile_x, tile_y);
+  bool LocalTiledLoadBalancer::Frame::renderNextTile()
+  {
+    // threads first take the tiles of their own node, then help out with
+    // the other nodes' tiles
+    const int numNodes = nodeTiles.size();
+    const int homeNode = numNodes > 1 ? getCurrentNUMANode() : 0;
+    int tileNr = -1;
+    for (int i = 0; i < numNodes && tileNr < 0; i++) {
+      const int node = (homeNode + i) % numNodes;
+      if (nextTile[node] >= int(nodeTiles[node].size()))
+        continue;
+      const size_t next = nextTile[node]++;
+      if (next < nodeTiles[node].size())
+        tileNr = nodeTiles[node][next];
+    }
+
+    if (tileNr < 0)
+      return false;
+
+    // tiles of a cancelled frame are claimed, but not rendered
+    if (!cancel) {
+      const vec2i numTiles = fb->getNumTiles();
+      const vec2i tileID(tileNr % numTiles.x, tileNr / numTiles.x);
       const int32 accumID = fb->accumID(tileID);
 
       // increment also for finished tiles
@@ -51,29 +105,188 @@ namespace ospray {
           fb->size - tileID * TILE_SIZE);
       pixelsDone += pixels.x * pixels.y;
 
-      if (fb->tileError(tileID) <= renderer->errorThreshold)
-        return;
+      if (fb->tileError(tileID) <= renderer->errorThreshold) {
+        fb->recordSkippedTile();
+      } else {
+        OSPRAY_PROFILE_ZONE("render tile");
+        const double tileStart = getSysTime();
 
 #if TILE_SIZE > MAX_TILE_SIZE
-      auto tilePtr = make_unique<Tile>(tileID, fb->size, accumID);
-      auto &tile   = *tilePtr;
+        auto tilePtr = TilePool::acquire(tileID, fb->size, accumID,
+                                         fb->getTileChannels());
+        auto &tile   = *tilePtr;
 #else
-      Tile __aligned(64) tile(tileID, fb->size, accumID);
+        Tile __aligned(64) tile(tileID, fb->size, accumID,
+                                fb->getTileChannels());
 #endif
 
-      tasking::parallel_for(numJobs(renderer->spp, accumID), [&](size_t tIdx) {
-        renderer->renderTile(perFrameData, tile, tIdx);
-      });
+        // tiles hidden behind the raster depth are not traced at all
+        const bool occluded = renderer->tileOccluded(fb, tileID);
+        if (occluded) {
+          renderer->clearTile(tile);
+        } else {
+          tile.shadingRate = renderer->tileShadingRate(fb, tileID);
 
-      fb->setTile(tile);
+          tasking::parallel_for(numJobs(renderer->spp, accumID,
+                                        tile.shadingRate),
+                                [&](size_t tIdx) {
+            renderer->renderTile(perFrameData, tile, tIdx);
+          });
+        }
 
-      if (!api::currentDevice().reportProgress(pixelsDone*rcpPixels))
+        fb->setTile(tile);
+
+        const int blockSize = 1 << tile.shadingRate;
+        const vec2i samples = divRoundUp(pixels, vec2i(blockSize));
+        fb->recordTile(getSysTime() - tileStart, occluded ? 0 :
+                       int64_t(samples.x) * samples.y * renderer->spp);
+      }
+
+      const float progress = pixelsDone*rcpPixels;
+      fb->reportProgress(progress);
+      if (!api::currentDevice().reportProgress(progress)
+          || fb->frameCancelled())
         cancel = true;
+    }
+
+    tilesLeft--;
+    return true;
+  }
+
+  void LocalTiledLoadBalancer::updateTileOrder(FrameBuffer *fb)
+  {
+    const vec2i numTiles = fb->getNumTiles();
+    const int totalTiles = fb->getTotalTiles();
+    auto &tileOrder = fb->tileOrder;
+
+    if (numTiles != fb->orderedNumTiles) {
+      fb->orderedNumTiles = numTiles;
+      tileOrder.resize(totalTiles);
+      for (int i = 0; i < totalTiles; i++)
+        tileOrder[i] = i;
+
+      std::sort(tileOrder.begin(), tileOrder.end(), [&](int a, int b) {
+        const vec2i ta(a % numTiles.x, a / numTiles.x);
+        const vec2i tb(b % numTiles.x, b / numTiles.x);
+        return mortonCode(ta) < mortonCode(tb);
+      });
+    }
+
+    // without a variance buffer all errors are inf; keep z-order as is
+    if (!fb->hasVarianceBuffer)
+      return;
+
+    std::vector<float> tileError(totalTiles);
+    for (int i = 0; i < totalTiles; i++)
+      tileError[i] = fb->tileError(vec2i(i % numTiles.x, i / numTiles.x));
+
+    // start with the tiles that did not converge yet, worst ones first,
+    // re-sorting the previous order keeps it nearly sorted frame to frame
+    std::stable_sort(tileOrder.begin(), tileOrder.end(), [&](int a, int b) {
+      return tileError[a] > tileError[b];
     });
+  }
+
+  bool LocalTiledLoadBalancer::helpHigherPriority(const Frame &frame)
+  {
+    if (numFrames < 2)
+      return false;
+
+    // the frame with the highest priority above the own one which still
+    // has tiles to hand out
+    Frame *other = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(framesMutex);
+      for (auto *f : frames) {
+        if (f->priority > frame.priority && f->tilesLeft > 0
+            && (!other || f->priority > other->priority))
+          other = f;
+      }
+      if (!other)
+        return false;
+      other->helpers++;
+    }
+
+    const bool helped = other->renderNextTile();
+    other->helpers--;
+    return helped;
+  }
+
+  /*! render a frame via the tiled load balancer */
+  float LocalTiledLoadBalancer::renderFrame(Renderer *renderer,
+                                            FrameBuffer *fb,
+                                            const uint32 channelFlags)
+  {
+    Assert(renderer);
+    Assert(fb);
+
+    // a frame buffer holds the state of one frame at a time, frames into
+    // different frame buffers are rendered concurrently
+    std::lock_guard<std::mutex> fbLock(fb->renderMutex);
+
+    const double frameStart = getSysTime();
+
+    updateTileOrder(fb);
+
+    Frame frame(renderer, fb, getNumberOfNUMANodes());
+    frame.priority = fb->priority;
+
+    // only hand out the tiles within the region of interest; on NUMA
+    // systems split by the node owning the frame buffer band
+    const vec2i numTiles = fb->getNumTiles();
+    int numActiveTiles = 0;
+    for (int tileNr : fb->tileOrder) {
+      const vec2i tileID(tileNr % numTiles.x, tileNr / numTiles.x);
+      if (fb->tileInRenderRegion(tileID)) {
+        frame.nodeTiles[fb->tileNUMANode(tileID)].push_back(tileNr);
+        numActiveTiles++;
+      }
+    }
+    frame.tilesLeft = numActiveTiles;
+
+    const box2i region = fb->getRenderRegion();
+    const vec2i regionPixels = ospcommon::min(region.upper * TILE_SIZE,
+        fb->size) - region.lower * TILE_SIZE;
+    frame.rcpPixels = 1.0f/std::max(regionPixels.x * regionPixels.y, 1);
+
+    frame.perFrameData = renderer->beginFrame(fb);
+
+    {
+      std::lock_guard<std::mutex> lock(framesMutex);
+      frames.push_back(&frame);
+      numFrames++;
+    }
+
+    // NOTE: the task index is only used as a ticket, the tile itself is
+    //       pulled from the shared, priority-ordered queues so tiles start
+    //       in that order independent of how the tasking system splits the
+    //       range; the nested parallel_for over jobs lets idle threads help
+    //       with (i.e. steal from) the remaining expensive tiles. Frames
+    //       rendered concurrently share the threads of the tasking system,
+    //       each ticket first helps a frame of higher priority (if any).
+    tasking::parallel_for(numActiveTiles, [&](int) {
+      helpHigherPriority(frame);
+      frame.renderNextTile();
+    });
+
+    {
+      std::lock_guard<std::mutex> lock(framesMutex);
+      frames.erase(std::find(frames.begin(), frames.end(), &frame));
+      numFrames--;
+    }
+
+    // tiles taken by threads of other frames may still be rendering
+    while (frame.tilesLeft > 0 || frame.helpers > 0)
+      std::this_thread::yield();
+
+    renderer->endFrame(frame.perFrameData, channelFlags);
 
-    renderer->endFrame(perFrameData,channelFlags);
+    const double endFrameStart = getSysTime();
+    const float error = fb->endFrame(renderer->errorThreshold);
+    const double frameEnd = getSysTime();
+    fb->recordFrameTime(frameEnd - frameStart, frameEnd - endFrameStart);
 
-    return fb->endFrame(renderer->errorThreshold);
+    return error;
   }
 
   std::string LocalTiledLoadBalancer::toString() const
@@ -22,6 +22,9 @@
 #include "common/OSPCommon.h"
 #include "fb/FrameBuffer.h"
 #include "render/Renderer.h"
+// std
+#include <atomic>
+#include <mutex>
 
 namespace ospray {
 
@@ -34,10 +37,14 @@ namespace ospray {
                               FrameBuffer *fb,
                               const uint32 channelFlags) = 0;
 
-    static size_t numJobs(const int spp, int accumID)
+    /*! number of jobs to render a tile, i.e. of RENDERTILE_PIXELS_PER_JOB
+        samples each; subsampling (negative spp, first frame only) and a
+        decimated tile shadingRate take one sample per pixel block */
+    static size_t numJobs(const int spp, int accumID, const int shadingRate = 0)
     {
-      const int blocks = (accumID > 0 || spp > 0) ? 1 :
-        std::min(1 << -2 * spp, TILE_SIZE*TILE_SIZE);
+      const int subsampling = (accumID > 0 || spp > 0) ? 0 : -spp;
+      const int blocks = std::min(1 << 2 * std::max(subsampling, shadingRate),
+                                  TILE_SIZE*TILE_SIZE);
       return divRoundUp((TILE_SIZE*TILE_SIZE)/RENDERTILE_PIXELS_PER_JOB, blocks);
     }
   };
@@ -54,6 +61,25 @@ namespace ospray {
                       const uint32 channelFlags) override;
 
     std::string toString() const override;
+
+  private:
+
+    struct Frame;
+
+    /*! (re)computes the order in which tiles get handed out: z-order
+        (Morton) for locality, then stable-sorted by descending error
+        of the previous frame so that expensive tiles start first */
+    void updateTileOrder(FrameBuffer *fb);
+
+    /*! renders a tile of a concurrently rendered frame with a higher
+        priority than 'frame', if any; returns whether it did */
+    bool helpHigherPriority(const Frame &frame);
+
+    //! the frames in flight, from ospRenderFrame calls of several threads
+    //! or ospRenderFrameAsync
+    std::vector<Frame *> frames;
+    std::atomic<int> numFrames {0};
+    std::mutex framesMutex;
   };
 
 } // ::ospray
@@ -0,0 +1,118 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// ospray
+#include "common/Future.h"
+#include "fb/FrameBuffer.h"
+// ospcommon
+#include "ospcommon/tasking/async.h"
+#include "ospcommon/utility/OnScopeExit.h"
+// std
+#include <functional>
+#include <mutex>
+
+namespace ospray {
+
+  /*! \brief future of a frame rendered by ospRenderFrameAsync
+
+    Runs the given render function as a task of the tasking system;
+    cancellation and progress go through the frame buffer, which the
+    load balancers poll in the same place they call the user's
+    progress callback.
+   */
+  struct RenderTask : public Future
+  {
+    using RenderFcn = std::function<float()>;
+
+    RenderTask(FrameBuffer *fb, RenderFcn fcn);
+    virtual ~RenderTask() override;
+
+    bool isFinished() override;
+    float wait() override;
+    void cancel() override;
+    float getProgress() override;
+
+    std::string toString() const override
+    { return "ospray::RenderTask"; }
+
+  private:
+
+    Ref<FrameBuffer> fb;
+    std::future<float> taskFuture;
+    float result {0.f};
+
+    // protects 'finished' against a concurrent cancel(), so that a late
+    // cancel can not leak into the next frame rendered into this fb
+    std::mutex mutex;
+    bool finished {false};
+  };
+
+  // Inlined definitions //////////////////////////////////////////////////////
+
+  inline RenderTask::RenderTask(FrameBuffer *fb, RenderFcn fcn)
+    : fb(fb)
+  {
+    managedObjectType = OSP_OBJECT;
+    fb->reportProgress(0.f);
+
+    taskFuture = tasking::async([=]() {
+      // also mark errored frames as finished, wait() rethrows the error
+      utility::OnScopeExit markFinished([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->fb->clearCancel();
+        finished = true;
+      });
+      return fcn();
+    });
+  }
+
+  inline RenderTask::~RenderTask()
+  {
+    // errors were either already reported by wait() or nobody asked
+    try {
+      wait();
+    } catch (const std::exception &) {
+    }
+  }
+
+  inline bool RenderTask::isFinished()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return finished;
+  }
+
+  inline float RenderTask::wait()
+  {
+    if (taskFuture.valid())
+      result = taskFuture.get();
+    return result;
+  }
+
+  inline void RenderTask::cancel()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!finished)
+      fb->cancelFrame();
+  }
+
+  inline float RenderTask::getProgress()
+  {
+    return isFinished() ? 1.f : fb->getCurrentProgress();
+  }
+
+} // ::ospray
@@ -16,14 +16,57 @@
 
 // ospray
 #include "Renderer.h"
+#include "common/FrameArena.h"
 #include "common/Util.h"
+#include "camera/PerspectiveCamera.h"
+#include "texture/VirtualTexture2D.h"
 // ispc exports
 #include "Renderer_ispc.h"
 // ospray
 #include "LoadBalancer.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/utility/Profiler.h"
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ospray {
 
+  //! The number of screen positions of a batch picked per task.
+  static constexpr size_t pickBatchSize = 1024;
+
+  constexpr int32 Renderer::maxShadingRate;
+
+  /*! A lower bound of the distance of primary ray hits with 'model',
+      known only for perspective cameras (whose rays start at the
+      position, up to the aperture and the eye offset), 0 otherwise. */
+  static float primaryDistance(const Model *model, const Camera *camera)
+  {
+    auto *perspective = dynamic_cast<const PerspectiveCamera *>(camera);
+    if (!perspective)
+      return 0.f;
+
+    const box3f &bounds = model->bounds;
+    if (bounds.empty())
+      return std::numeric_limits<float>::infinity();
+
+    const vec3f &pos = perspective->pos;
+    float dist = length(pos - clamp(pos, bounds.lower, bounds.upper));
+    dist -= perspective->apertureRadius;
+    if (perspective->stereoMode != PerspectiveCamera::OSP_STEREO_NONE)
+      dist -= 0.5f * perspective->interpupillaryDistance;
+
+    return std::max(dist, 0.f);
+  }
+
+  Renderer::~Renderer()
+  {
+    if (getIE())
+      ispc::Renderer_freeMemory(getIE());
+  }
+
   std::string Renderer::toString() const 
   {
     return "ospray::Renderer";
@@ -31,12 +74,35 @@ namespace ospray {
 
   void Renderer::commit()
   {
-    spp = std::max(1, getParam1i("spp", 1));
+    spp = fullSpp = std::max(1, getParam1i("spp", 1));
+    targetFrameTime = std::max(0.f, getParam1f("targetFrameTime", 0.f));
+    if (targetFrameTime == 0.f) {
+      qualityLevel = 0;
+      qualityShadingRate = 0;
+    }
     const int32 maxDepth = std::max(0, getParam1i("maxDepth", 20));
     const float minContribution = getParam1f("minContribution", 0.001f);
     errorThreshold = getParam1f("varianceThreshold", 0.f);
     maxDepthTexture = (Texture2D*)getParamObject("maxDepthTexture", nullptr);
     model = (Model*)getParamObject("model", getParamObject("world"));
+    shadingRateMap = getParamData("shadingRate", nullptr);
+    foveaCenter = getParam2f("foveaCenter", vec2f(0.5f));
+    foveaRadius = getParam1f("foveaRadius", 0.f);
+    const float opacityThreshold =
+        clamp(getParam1f("opacityThreshold", 0.99f), 0.f, 1.f);
+    // 0 (the default) means no limit
+    const int32 maxVolumeSamples = getParam1i("maxVolumeSamples", 0);
+    const int32 interleaveParam = getParam1i("interleave", 1);
+    interleave = interleaveParam <= 1 ? 1 : (interleaveParam < 4 ? 2 : 4);
+
+    if (shadingRateMap && shadingRateMap->type != OSP_UCHAR
+        && shadingRateMap->type != OSP_INT
+        && shadingRateMap->type != OSP_UINT) {
+      static WarnOnce warning("the shadingRate data array provided to the "
+                              "renderer needs to be of type OSP_UCHAR, "
+                              "OSP_INT or OSP_UINT, ignoring it");
+      shadingRateMap = nullptr;
+    }
 
     if (maxDepthTexture) {
       if (maxDepthTexture->type != OSP_TEXTURE_R32F
@@ -61,7 +127,11 @@ namespace ospray {
           , minContribution
           , (ispc::vec4f&)bgColor
           , maxDepthTexture ? maxDepthTexture->getIE() : nullptr
+          , opacityThreshold
+          , maxVolumeSamples > 0 ? maxVolumeSamples
+                                 : std::numeric_limits<int32>::max()
           );
+      ispc::Renderer_setInterleave(getIE(), interleave);
     }
   }
 
@@ -78,18 +148,162 @@ namespace ospray {
   void *Renderer::beginFrame(FrameBuffer *fb)
   {
     this->currentFB = fb;
+    FrameArena::beginFrame();
     fb->beginFrame();
+    if (model) {
+      for (auto &volume : model->volume)
+        volume->beginFrame();
+      Camera *camera = (Camera *)getParamObject("camera");
+      if (camera)
+        model->selectLOD(camera->pos);
+      sceneDistance = primaryDistance(model, camera);
+    }
+    VirtualTexture2D::beginFrameAll();
+    const bool accumulating = fb->hasAccumBuffer && fb->accumID(vec2i(0)) > 0;
+    ispc::Renderer_beginInterleavedFrame(getIE(), fb->getIE(), accumulating);
     return ispc::Renderer_beginFrame(getIE(),fb->getIE());
   }
 
   void Renderer::endFrame(void *perFrameData, const int32 /*fbChannelFlags*/)
   {
     ispc::Renderer_endFrame(getIE(),perFrameData);
+    if (model) {
+      for (auto &volume : model->volume)
+        volume->endFrame();
+    }
+    VirtualTexture2D::endFrameAll();
+    FrameArena::endFrame();
   }
 
   float Renderer::renderFrame(FrameBuffer *fb, const uint32 channelFlags)
   {
-    return TiledLoadBalancer::instance->renderFrame(this,fb,channelFlags);
+    float error;
+    {
+      std::lock_guard<std::mutex> lock(renderMutex);
+      OSPRAY_PROFILE_ZONE("Renderer::renderFrame");
+      if (targetFrameTime > 0.f)
+        updateQuality(fb);
+      error = TiledLoadBalancer::instance->renderFrame(this,fb,channelFlags);
+    }
+
+#ifdef OSPRAY_ENABLE_PROFILING
+    OSPRAY_PROFILE_END_FRAME();
+    if (logLevel() >= 2) {
+      std::stringstream report;
+      utility::Profiler::report(report);
+      postStatusMsg(2) << "#osp: profiled zones of the frame:\n"
+                       << report.str();
+    }
+#endif
+
+    return error;
+  }
+
+  bool Renderer::tileOccluded(const FrameBuffer *fb,
+                              const vec2i &tileID) const
+  {
+    const float *maxDepth = fb->getMaxDepth();
+    if (!maxDepth || sceneDistance <= 0.f)
+      return false;
+
+    const vec2i begin = tileID * TILE_SIZE;
+    const vec2i end = ospcommon::min(begin + TILE_SIZE, fb->size);
+    for (int y = begin.y; y < end.y; y++) {
+      for (int x = begin.x; x < end.x; x++) {
+        if (maxDepth[size_t(y) * fb->size.x + x] > sceneDistance)
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+  void Renderer::clearTile(Tile &tile) const
+  {
+    constexpr int numPixels = TILE_SIZE * TILE_SIZE;
+    std::fill(tile.r, tile.r + numPixels, bgColor.x);
+    std::fill(tile.g, tile.g + numPixels, bgColor.y);
+    std::fill(tile.b, tile.b + numPixels, bgColor.z);
+    std::fill(tile.a, tile.a + numPixels, bgColor.w);
+    std::fill(tile.z, tile.z + numPixels,
+              std::numeric_limits<float>::infinity());
+    std::fill(tile.nx, tile.nx + numPixels, 0.f);
+    std::fill(tile.ny, tile.ny + numPixels, 0.f);
+    std::fill(tile.nz, tile.nz + numPixels, 0.f);
+    std::fill(tile.ar, tile.ar + numPixels, 0.f);
+    std::fill(tile.ag, tile.ag + numPixels, 0.f);
+    std::fill(tile.ab, tile.ab + numPixels, 0.f);
+  }
+
+  void Renderer::updateQuality(FrameBuffer *fb)
+  {
+    // cost of a frame relative to the one of the next lower quality
+    // level: halving spp halves it, halving the resolution quarters it
+    const int32 sppLevels = int32(std::log2(float(fullSpp)));
+    auto levelCost = [&](int32 level) {
+      return level <= sppLevels ? 2.f : 4.f;
+    };
+    const int32 maxLevel = sppLevels + maxShadingRate;
+
+    const bool accumulating = fb->hasAccumBuffer && fb->accumID(vec2i(0)) > 0;
+
+    if (accumulating) {
+      // the camera rests: restart the accumulation at full quality, such
+      // that the reduced frames do not linger in the converged image
+      if (qualityLevel > 0) {
+        fb->clear(OSP_FB_ACCUM);
+        qualityRestarted = true;
+        qualityLevel = 0;
+      }
+    } else if (qualityRestarted) {
+      // the first frame after the restart, keep full quality
+      qualityRestarted = false;
+    } else {
+      // interactive: adapt to the time of the previous frame
+      const float frameTime = fb->getFrameStats().frameTime;
+      if (frameTime > 1.2f * targetFrameTime && qualityLevel < maxLevel) {
+        qualityLevel++;
+      } else if (qualityLevel > 0
+          && frameTime * levelCost(qualityLevel) < 0.9f * targetFrameTime) {
+        qualityLevel--;
+      }
+    }
+
+    setQualityLevel(qualityLevel);
+  }
+
+  void Renderer::setQualityLevel(int32 level)
+  {
+    const int32 sppLevels = int32(std::log2(float(fullSpp)));
+    spp = std::max(1, fullSpp >> std::min(level, sppLevels));
+    qualityShadingRate = clamp(level - sppLevels, 0, maxShadingRate);
+    ispc::Renderer_setSpp(getIE(), spp);
+  }
+
+  int32 Renderer::tileShadingRate(const FrameBuffer *fb,
+                                  const vec2i &tileID) const
+  {
+    int32 rate = qualityShadingRate;
+    const size_t tileNr = tileID.y * fb->getNumTiles().x + tileID.x;
+
+    if (shadingRateMap) {
+      // a rate map of the wrong size (e.g. after a resize) is ignored
+      if (shadingRateMap->numItems != size_t(fb->getTotalTiles()))
+        return clamp(rate, 0, maxShadingRate);
+      if (shadingRateMap->type == OSP_UCHAR)
+        rate += ((const uint8 *)shadingRateMap->data)[tileNr];
+      else
+        rate += ((const int32 *)shadingRateMap->data)[tileNr];
+    } else if (foveaRadius > 0.f) {
+      // full rate within the fovea, then halving the resolution with
+      // every further radius of distance
+      const vec2f tileCenter = vec2f(tileID * TILE_SIZE) + 0.5f * TILE_SIZE;
+      const vec2f gaze = foveaCenter * vec2f(fb->size);
+      const float dist = length(tileCenter - gaze) / (fb->size.y * foveaRadius);
+      rate += int32(dist);
+    }
+
+    return clamp(rate, 0, maxShadingRate);
   }
 
   OSPPickResult Renderer::pick(const vec2f &screenPos)
@@ -105,4 +319,30 @@ namespace ospray {
     return res;
   }
 
+  void Renderer::pick(const vec2f *screenPos,
+                      size_t count,
+                      OSPPickResult *results)
+  {
+    assert(getIE());
+
+    const size_t numTasks = divRoundUp(count, pickBatchSize);
+    tasking::parallel_for(numTasks, [&](size_t taskID) {
+      const size_t begin = taskID * pickBatchSize;
+      const size_t n     = std::min(begin + pickBatchSize, count) - begin;
+
+      vec3f position[pickBatchSize];
+      bool hit[pickBatchSize];
+      ispc::Renderer_pickBatch(getIE(),
+                               (const ispc::vec2f*)screenPos + begin,
+                               n,
+                               (ispc::vec3f*)position,
+                               hit);
+
+      for (size_t i = 0; i < n; i++) {
+        results[begin + i].position = (const osp::vec3f&)position[i];
+        results[begin + i].hit = hit[i];
+      }
+    });
+  }
+
 } // ::ospray
@@ -37,7 +37,7 @@ namespace ospray {
   struct OSPRAY_SDK_INTERFACE Renderer : public ManagedObject
   {
     Renderer() = default;
-    virtual ~Renderer() override = default;
+    virtual ~Renderer() override;
 
     /*! \brief creates an abstract renderer class of given type
 
@@ -73,11 +73,68 @@ namespace ospray {
 
     virtual OSPPickResult pick(const vec2f &screenPos);
 
+    /*! \brief pick 'count' screen positions at once (in parallel) */
+    virtual void pick(const vec2f *screenPos,
+                      size_t count,
+                      OSPPickResult *results);
+
+    /*! \brief the shading rate of the given tile of 'fb', i.e. the log2
+        of its pixel decimation: 0 shades every pixel, 1 one sample per
+        2x2 pixel block, up to maxShadingRate
+
+      \detailed Comes from the per-tile "shadingRate" data array if
+      present, otherwise from the foveation parameters ("foveaCenter"
+      and "foveaRadius"), otherwise all tiles are shaded at full rate */
+    int32 tileShadingRate(const FrameBuffer *fb, const vec2i &tileID) const;
+
+    static constexpr int32 maxShadingRate = 2;
+
+    /*! \brief whether the "maxDepth" of 'fb' (e.g. the depth buffer of
+        a rasterizer) is closer than all of the scene in the given tile,
+        which then does not need to be traced at all */
+    bool tileOccluded(const FrameBuffer *fb, const vec2i &tileID) const;
+
+    /*! \brief fill a tile not traced because of tileOccluded with the
+        background */
+    void clearTile(Tile &tile) const;
+
+    /*! \brief interactive quality scaling: reduce the work of the
+        frames to be rendered into 'fb' to meet the targetFrameTime
+
+      \detailed Called (by renderFrame) before every frame. Raises the
+      quality level when the previous frame ran long and lowers it again
+      when there is enough headroom; returns to full quality (restarting
+      the accumulation) once the frame buffer accumulates, i.e. once the
+      application stopped resetting it because the camera came to rest */
+    void updateQuality(FrameBuffer *fb);
+
+    /*! \brief apply the given quality level, 0 being full quality: each
+        level first halves spp (down to one) and then increases the
+        shading rate of all tiles; renderers may further reduce their
+        own work (e.g., the number of AO samples) */
+    virtual void setQualityLevel(int32 level);
+
+
     Model *model {nullptr};
     FrameBuffer *currentFB {nullptr};
 
-    /*! \brief number of samples to be used per pixel in a tile */
+    /*! \brief number of samples to be used per pixel in a tile (of the
+        current frame, i.e. possibly reduced from the committed 'fullSpp'
+        by the quality level) */
     int32 spp {1};
+    int32 fullSpp {1};
+
+    /*! interactive quality scaling: frame time (in seconds) to aim for (0
+        disables it), the current quality level and its shading rate */
+    float targetFrameTime {0.f};
+    int32 qualityLevel {0};
+    int32 qualityShadingRate {0};
+    bool qualityRestarted {false};
+
+    /*! interleaved rendering while the frame buffer does not accumulate:
+        one of 'interleave' (1: all, 2 or 4) pixels is rendered per frame,
+        the others are reprojected from the previous frame */
+    int32 interleave {1};
 
     /*! adaptive accumulation: variance-based error to reach */
     float errorThreshold {0.f};
@@ -91,6 +148,21 @@ namespace ospray {
       should be set to nearest-neighbor interpolation:
       (OSP_TEXTURE_FILTER_NEAREST). */
     Ref<Texture2D> maxDepthTexture;
+
+    /*! \brief variable rate shading: optional per-tile rate map, or a
+        gaze point (in normalized screen coordinates) with a radius
+        (relative to the frame buffer height) of the fully shaded area */
+    Ref<Data> shadingRateMap;
+    vec2f foveaCenter {0.5f};
+    float foveaRadius {0.f};
+
+    /*! lower bound of the distance of all primary ray hits of the current
+        frame (set in beginFrame), 0 if unknown */
+    float sceneDistance {0.f};
+
+    /*! a renderer keeps state of the frame it renders (e.g. currentFB),
+        thus frames of the same renderer are rendered one at a time */
+    std::mutex renderMutex;
   };
 
   /*! \brief registers a internal ospray::<ClassName> renderer under
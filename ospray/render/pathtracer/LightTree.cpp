@@ -0,0 +1,122 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "LightTree.h"
+// std
+#include <algorithm>
+#include <numeric>
+
+namespace ospray {
+
+  // bound the union of two cones of directions, following Conty Estevez and
+  // Kulla, "Importance Sampling of Many Lights with Adaptive Tree Splitting"
+  static void mergeCones(vec3f &axis, float &cosTheta,
+                         vec3f axisB, float cosThetaB)
+  {
+    float thetaA = std::acos(clamp(cosTheta, -1.f, 1.f));
+    float thetaB = std::acos(clamp(cosThetaB, -1.f, 1.f));
+    if (thetaB > thetaA) {
+      std::swap(axis, axisB);
+      std::swap(thetaA, thetaB);
+    }
+
+    const float cosThetaD = clamp(dot(axis, axisB), -1.f, 1.f);
+    const float thetaD = std::acos(cosThetaD);
+    // B already contained in A
+    if (std::min(thetaD + thetaB, float(pi)) <= thetaA) {
+      cosTheta = std::cos(thetaA);
+      return;
+    }
+
+    const float thetaO = 0.5f * (thetaA + thetaD + thetaB);
+    const vec3f w = axisB - cosThetaD * axis;
+    const float lw = length(w);
+    if (thetaO >= float(pi) || lw < 1e-6f) {
+      cosTheta = thetaO >= float(pi) ? -1.f : std::cos(thetaO);
+      return;
+    }
+
+    // rotate the axis of A towards B
+    const float thetaR = thetaO - thetaA;
+    axis = normalize(std::cos(thetaR) * axis + std::sin(thetaR) * (w / lw));
+    cosTheta = std::cos(thetaO);
+  }
+
+  void LightTree::build(const std::vector<Light::SamplingBounds> &lights)
+  {
+    nodes.clear();
+    leafOfLight.assign(lights.size(), -1);
+    if (lights.empty())
+      return;
+
+    std::vector<int32> ids(lights.size());
+    std::iota(ids.begin(), ids.end(), 0);
+
+    nodes.reserve(2 * lights.size() - 1);
+    nodes.emplace_back();
+    nodes[0].parent = -1;
+    buildRec(0, ids.data(), ids.data() + ids.size(), lights);
+  }
+
+  void LightTree::buildRec(int32 nodeID,
+                           int32 *begin,
+                           int32 *end,
+                           const std::vector<Light::SamplingBounds> &lights)
+  {
+    if (end - begin == 1) {
+      const Light::SamplingBounds &l = lights[*begin];
+      Node &node = nodes[nodeID];
+      node.lower = l.bounds.lower;
+      node.upper = l.bounds.upper;
+      node.axis = l.axis;
+      node.cosThetaO = l.cosThetaO;
+      node.cosThetaE = l.cosThetaE;
+      node.power = l.power;
+      node.child = -1 - *begin;
+      leafOfLight[*begin] = nodeID;
+      return;
+    }
+
+    // median split along the largest extent of the light centers
+    box3f centers = empty;
+    for (int32 *i = begin; i != end; ++i)
+      centers.extend(center(lights[*i].bounds));
+    const int dim = arg_max(centers.size());
+    int32 *mid = begin + (end - begin) / 2;
+    std::nth_element(begin, mid, end, [&](int32 a, int32 b) {
+      return center(lights[a].bounds)[dim] < center(lights[b].bounds)[dim];
+    });
+
+    const int32 child = nodes.size();
+    nodes.resize(child + 2);
+    nodes[child].parent = nodes[child + 1].parent = nodeID;
+    nodes[nodeID].child = child;
+    buildRec(child, begin, mid, lights);
+    buildRec(child + 1, mid, end, lights);
+
+    const Node &a = nodes[child];
+    const Node &b = nodes[child + 1];
+    Node &node = nodes[nodeID];
+    node.lower = min(a.lower, b.lower);
+    node.upper = max(a.upper, b.upper);
+    node.axis = a.axis;
+    node.cosThetaO = a.cosThetaO;
+    mergeCones(node.axis, node.cosThetaO, b.axis, b.cosThetaO);
+    node.cosThetaE = std::min(a.cosThetaE, b.cosThetaE);
+    node.power = a.power + b.power;
+  }
+
+} // ::ospray
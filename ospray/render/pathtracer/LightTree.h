@@ -0,0 +1,58 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "lights/Light.h"
+// std
+#include <vector>
+
+namespace ospray {
+
+  //! A BVH over the lights with SamplingBounds, which is descended
+  //  stochastically to select a light proportional to an estimate of its
+  //  contribution to a shading point
+  struct LightTree
+  {
+    //! same layout as LightTreeNode in LightTree.ih
+    struct Node
+    {
+      vec3f lower;
+      vec3f upper;
+      vec3f axis;
+      float cosThetaO;
+      float cosThetaE;
+      float power;
+      int32 child;  //!< first of two consecutive children, or -1-light
+      int32 parent; //!< -1 for the root
+    };
+
+    //! Build the tree over the given lights, a leaf refers to a light by
+    //  its index in 'lights'
+    void build(const std::vector<Light::SamplingBounds> &lights);
+
+    std::vector<Node> nodes;
+    std::vector<int32> leafOfLight; //!< index of the leaf node of each light
+
+  private:
+
+    void buildRec(int32 nodeID,
+                  int32 *begin,
+                  int32 *end,
+                  const std::vector<Light::SamplingBounds> &lights);
+  };
+
+} // ::ospray
@@ -0,0 +1,118 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "PathGuide.h"
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace ospray {
+
+  // leaves are split once they recorded this many vertices per sqrt(frame)
+  // of a training iteration (the number of vertices grows with the frames,
+  // but their noise only falls with the square root)
+  static constexpr float splitSamples = 12000.f;
+  // the depth of the tree is limited, such that a few leaves of e.g. a
+  // caustic do not get refined indefinitely
+  static constexpr int maxDepth = 24;
+  // part of the distributions kept uniform, to be robust against noise
+  static constexpr float uniformFraction = 0.1f;
+
+  void PathGuide::reset()
+  {
+    nodes.assign(1, {-1, 0});
+    cdf.clear();
+    radiance.clear();
+    samples.clear();
+    addLeaf();
+  }
+
+  void PathGuide::addLeaf()
+  {
+    cdf.resize(cdf.size() + numBins, 0.f);
+    radiance.resize(radiance.size() + numBins, 0.f);
+    samples.push_back(0);
+  }
+
+  void PathGuide::update(int frames)
+  {
+    const size_t numLeaves = samples.size();
+
+    // the new distributions, leaves without radiance keep their old one
+    for (size_t leaf = 0; leaf < numLeaves; leaf++) {
+      float *bins = &radiance[leaf * numBins];
+      float sum = 0.f;
+      for (int i = 0; i < numBins; i++)
+        sum += bins[i];
+      if (!(sum > 0.f) || !std::isfinite(sum))
+        continue;
+
+      const float uniformBin = uniformFraction / numBins;
+      const float scale = (1.f - uniformFraction) / sum;
+      float *c = &cdf[leaf * numBins];
+      float acc = 0.f;
+      for (int i = 0; i < numBins; i++) {
+        acc += bins[i] * scale + uniformBin;
+        c[i] = acc;
+      }
+      // normalize as Distribution1D_create
+      const float nextAfter1 = std::nextafter(1.f, 2.f);
+      for (int i = 0; i < numBins; i++)
+        c[i] = c[i] >= acc ? nextAfter1 : c[i] / acc;
+    }
+
+    // split the leaves which recorded many vertices, both children start
+    // with the distribution of their parent
+    const float threshold = splitSamples * std::sqrt(float(frames));
+    std::vector<std::pair<int32, int32>> stack {{0, 0}}; // node, depth
+    while (!stack.empty()) {
+      const int32 nodeID = stack.back().first;
+      const int32 depth = stack.back().second;
+      stack.pop_back();
+
+      const int32 child = nodes[nodeID].child;
+      if (child >= 0) {
+        stack.push_back({child, depth + 1});
+        stack.push_back({child + 1, depth + 1});
+        continue;
+      }
+
+      const int32 leaf = -1 - child;
+      if (depth >= maxDepth || samples[leaf] < threshold)
+        continue;
+
+      const int32 newLeaf = samples.size();
+      addLeaf();
+      std::copy_n(&cdf[leaf * numBins], numBins, &cdf[newLeaf * numBins]);
+
+      const int32 axis = nodes[nodeID].axis;
+      const int32 first = nodes.size();
+      nodes[nodeID].child = first;
+      nodes.push_back({-1 - leaf, (axis + 1) % 3});
+      nodes.push_back({-1 - newLeaf, (axis + 1) % 3});
+      // the children will have recorded about half each
+      if (samples[leaf] / 2 >= threshold) {
+        samples[leaf] = samples[newLeaf] = samples[leaf] / 2;
+        stack.push_back({first, depth + 1});
+        stack.push_back({first + 1, depth + 1});
+      }
+    }
+
+    std::fill(radiance.begin(), radiance.end(), 0.f);
+    std::fill(samples.begin(), samples.end(), 0);
+  }
+
+} // ::ospray
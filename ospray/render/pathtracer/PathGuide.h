@@ -0,0 +1,63 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "common/OSPCommon.h"
+// std
+#include <vector>
+
+namespace ospray {
+
+  //! Path guiding, following Müller et al., "Practical Path Guiding for
+  //  Efficient Light-Transport Simulation": a binary tree over the bounds of
+  //  the model, its leaves hold a distribution of the incident radiance over
+  //  the sphere of directions, learned from the paths of the training
+  //  iterations. The directions are binned by an equal area (cylindrical)
+  //  map, with 'resolution'^2 bins.
+  struct PathGuide
+  {
+    //! same layout as PathGuideNode in PathGuide.ih
+    struct Node
+    {
+      int32 child; //!< first of two consecutive children, or -1-leaf
+      int32 axis;  //!< split in half along, for the children
+    };
+
+    static constexpr int resolution = 16; //!< PATH_GUIDE_RESOLUTION
+    static constexpr int numBins = resolution * resolution;
+
+    //! Start over with a single leaf, without distribution
+    void reset();
+
+    //! End a training iteration of 'frames' frames: the recorded radiance
+    //  becomes the distributions of the leaves, and leaves which recorded
+    //  many vertices are split, then recording starts anew
+    void update(int frames);
+
+    std::vector<Node> nodes;
+    //! per leaf the cdf over its bins, all zero if there is no distribution
+    std::vector<float> cdf;
+    //! radiance recorded per leaf and bin, and vertices recorded per leaf
+    std::vector<float> radiance;
+    std::vector<int32> samples;
+
+  private:
+
+    void addLeaf();
+  };
+
+} // ::ospray
@@ -21,11 +21,14 @@
 #include "common/Data.h"
 #include "lights/Light.h"
 #include "geometry/Instance.h"
+#include "ospcommon/tasking/parallel_for.h"
 // ispc exports
 #include "PathTracer_ispc.h"
 #include "Material_ispc.h"
 #include "GeometryLight_ispc.h"
 // std
+#include <algorithm>
+#include <cmath>
 #include <map>
 
 namespace ospray {
@@ -40,6 +43,7 @@ namespace ospray {
   PathTracer::~PathTracer()
   {
     destroyGeometryLights();
+    ispc::PathTracer_freeMemory(getIE());
   }
 
   std::string PathTracer::toString() const
@@ -73,15 +77,7 @@ namespace ospray {
 
           if (hasEmissive) {
             if (ispc::GeometryLight_isSupported(geo->getIE())) {
-              const affine3f rcpXfm = rcp(xfm);
-              void* light = ispc::GeometryLight_create(geo->getIE()
-                  , (const ispc::AffineSpace3f&)xfm
-                  , (const ispc::AffineSpace3f&)rcpXfm
-                  , _areaPDF+i);
-
-              // check whether the geometry has any emissive primitives
-              if (light)
-                lightArray.push_back(light);
+              emissiveGeometries.push_back({geo.ptr, xfm, _areaPDF+i});
             } else {
               postStatusMsg(1) << "#osp:pt Geometry " << geo->toString()
                                << " does not implement area sampling! "
@@ -93,6 +89,43 @@ namespace ospray {
     }
   }
 
+  void PathTracer::createGeometryLights()
+  {
+    // build the per-primitive distributions of all lights in parallel
+    std::vector<void*> lights(emissiveGeometries.size());
+    tasking::parallel_for(emissiveGeometries.size(), [&](size_t i) {
+      const EmissiveGeometry &e = emissiveGeometries[i];
+      const affine3f rcpXfm = rcp(e.xfm);
+      lights[i] = ispc::GeometryLight_create(e.geometry->getIE()
+          , (const ispc::AffineSpace3f&)e.xfm
+          , (const ispc::AffineSpace3f&)rcpXfm
+          , e.areaPDF);
+    });
+
+    // select a GeometryLight proportional to its power, such that the pdf
+    // wrt. area is luminance(emission)/totalPower on all of them
+    float totalPower = 0.f;
+    geometryLightCDF.clear();
+    for (auto light : lights) {
+      // check whether the geometry has any emissive primitives
+      if (light) {
+        lightArray.push_back(light);
+        totalPower += ispc::GeometryLight_getPower(light);
+        geometryLightCDF.push_back(totalPower);
+      }
+    }
+
+    // normalize as Distribution1D_create
+    const float nextAfter1 = std::nextafter(1.f, 2.f);
+    for (auto &c : geometryLightCDF)
+      c = c >= totalPower ? nextAfter1 : c / totalPower;
+
+    for (size_t i = 0; i < lights.size(); i++) {
+      if (lights[i])
+        *emissiveGeometries[i].areaPDF = 1.f / totalPower;
+    }
+  }
+
   void PathTracer::destroyGeometryLights()
   {
     for (size_t i = 0; i < geometryLights; i++)
@@ -111,16 +144,38 @@ namespace ospray {
 
     if (model && useGeometryLights) {
       areaPDF.resize(model->geometry.size());
+      emissiveGeometries.clear();
       generateGeometryLights(model, affine3f(one), &areaPDF[0]);
+      createGeometryLights();
       geometryLights = lightArray.size();
     }
 
+    // with lightSamples > 0 the lights which can be bounded are not sampled
+    // each, but selected from a light tree by importance
+    const int32 lightSamples = std::max(0, getParam1i("lightSamples", 0));
+    std::vector<Light::SamplingBounds> treeBounds;
+    std::vector<void*> treeLights;
+
     lightData = (Data*)getParamData("lights");
     if (lightData) {
-      for (uint32_t i = 0; i < lightData->size(); i++)
-        lightArray.push_back(((Light**)lightData->data)[i]->getIE());
+      for (uint32_t i = 0; i < lightData->size(); i++) {
+        Light *light = ((Light**)lightData->data)[i];
+        Light::SamplingBounds bounds;
+        if (lightSamples > 0 && light->getSamplingBounds(bounds)) {
+          // lights without power never contribute
+          if (bounds.power > 0.f) {
+            treeBounds.push_back(bounds);
+            treeLights.push_back(light->getIE());
+          }
+        } else
+          lightArray.push_back(light->getIE());
+      }
     }
 
+    const size_t loopLights = lightArray.size();
+    lightTree.build(treeBounds);
+    lightArray.insert(lightArray.end(), treeLights.begin(), treeLights.end());
+
     void **lightPtr = lightArray.empty() ? nullptr : &lightArray[0];
 
     const int32 rouletteDepth = getParam1i("rouletteDepth", 5);
@@ -128,6 +183,17 @@ namespace ospray {
                                          getParam1f("maxRadiance", inf));
     Texture2D *backplate = (Texture2D*)getParamObject("backplate", nullptr);
     vec4f shadowCatcherPlane = getParam4f("shadowCatcherPlane", vec4f(0.f));
+    const float pathRegularization =
+        clamp(getParam1f("pathRegularization", 0.f), 0.f, 1.f);
+    const bool progressiveClamp = getParam1i("progressiveClamp", false);
+    const bool wavefront = getParam1i("wavefront", false);
+    const int32 shadowCacheSamples =
+        std::max(0, getParam1i("shadowCacheSamples", 0));
+    const std::string sampler = getParamString("sampler", "sobol");
+    if (sampler != "sobol" && sampler != "owen") {
+      static WarnOnce warning("unknown path tracer sampler '" + sampler
+                              + "', using 'sobol'");
+    }
 
     ispc::PathTracer_set(getIE()
         , rouletteDepth
@@ -138,7 +204,91 @@ namespace ospray {
         , lightArray.size()
         , geometryLights
         , &areaPDF[0]
+        , loopLights
+        , lightSamples
+        , lightTree.nodes.empty() ? nullptr : lightTree.nodes.data()
+        , lightTree.leafOfLight.data()
+        , geometryLightCDF.data()
+        , wavefront
+        , sampler == "owen"
+        , pathRegularization
+        , progressiveClamp
+        , shadowCacheSamples
         );
+
+    // path guiding learns anew whenever the renderer (e.g. its model) changes
+    pathGuiding = getParam1i("pathGuiding", false) && model;
+    guidingIterations = std::max(0, getParam1i("guidingIterations", 6));
+    guidingProbability =
+        clamp(getParam1f("guidingProbability", 0.5f), 0.f, 0.99f);
+    guideIteration = 0;
+    guideFrames = 0;
+    guide.reset();
+    updateGuide();
+
+    // the radiance cache is recorded anew whenever the renderer changes,
+    // cells default to 1/256 of the diagonal of the model bounds
+    const bool useRadianceCache = getParam1i("radianceCache", false) && model;
+    if (useRadianceCache) {
+      radianceCache.reset(
+          std::max(getParam1i("radianceCacheSize", 1 << 20), 1));
+    } else {
+      radianceCache.cells.clear();
+      radianceCache.cells.shrink_to_fit();
+    }
+    const float cellSize = getParam1f("radianceCacheCellSize",
+        useRadianceCache ? length(model->bounds.size()) / 256.f : 1.f);
+    ispc::PathTracer_setRadianceCache(getIE()
+        , useRadianceCache ? radianceCache.cells.data() : nullptr
+        , std::max(radianceCache.cells.size(), size_t(1))
+        , cellSize
+        , std::max(getParam1i("radianceCacheSamples", 4), 1)
+        , clamp(getParam1f("radianceCacheUpdate", 0.1f), 0.f, 1.f)
+        , std::max(getParam1i("radianceCacheFrames", 16), 0)
+        );
+  }
+
+  void PathTracer::updateGuide()
+  {
+    const box3f bounds = pathGuiding ? model->bounds : box3f(vec3f(0.f));
+    ispc::PathTracer_setGuide(getIE()
+        , pathGuiding ? guide.nodes.data() : nullptr
+        , guide.cdf.data()
+        , guide.radiance.data()
+        , guide.samples.data()
+        , (const ispc::vec3f&)bounds.lower
+        , (const ispc::vec3f&)bounds.upper
+        , pathGuiding && guideIteration < guidingIterations
+        , guidingProbability
+        );
+  }
+
+  void PathTracer::endFrame(void *perFrameData, const int32 fbChannelFlags)
+  {
+    Renderer::endFrame(perFrameData, fbChannelFlags);
+
+    if (!pathGuiding || guideIteration >= guidingIterations)
+      return;
+
+    // the training iterations double in length, each learns from the paths
+    // guided by the distributions of the previous one (Müller et al.)
+    if (++guideFrames < (1 << guideIteration))
+      return;
+
+    guide.update(guideFrames);
+    guideIteration++;
+    guideFrames = 0;
+    updateGuide();
+  }
+
+  extern "C" void ospray_PathTracer_sortByMaterial(int32 numPaths,
+                                                   int32 *paths,
+                                                   void **materials)
+  {
+    // stable to keep paths of a material roughly in screen order
+    std::stable_sort(paths, paths + numPaths, [&](int32 a, int32 b) {
+      return materials[a] < materials[b];
+    });
   }
 
   OSP_REGISTER_RENDERER(PathTracer,pathtracer);
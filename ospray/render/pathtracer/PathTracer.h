@@ -18,6 +18,9 @@
 
 #include "render/Renderer.h"
 #include "common/Material.h"
+#include "LightTree.h"
+#include "PathGuide.h"
+#include "RadianceCache.h"
 
 namespace ospray {
 
@@ -27,15 +30,41 @@ namespace ospray {
     virtual ~PathTracer() override;
     virtual std::string toString() const override;
     virtual void commit() override;
+    virtual void endFrame(void *perFrameData,
+                          const int32 fbChannelFlags) override;
 
     void generateGeometryLights(const Model *const, const affine3f& xfm,
                                 float *const areaPDF);
+    void createGeometryLights();
     void destroyGeometryLights();
 
+    //! a geometry (instance) with emissive materials, to become a GeometryLight
+    struct EmissiveGeometry
+    {
+      Geometry *geometry;
+      affine3f xfm;
+      float *areaPDF;
+    };
+    std::vector<EmissiveGeometry> emissiveGeometries;
+
     std::vector<void*> lightArray; // the 'IE's of the XXXLights
     size_t geometryLights {0}; // number of GeometryLights at beginning of lightArray
+    std::vector<float> geometryLightCDF; // for selecting a GeometryLight by power
     std::vector<float> areaPDF; // pdfs wrt. area of regular (not instanced) geometry lights
+    LightTree lightTree; // over the lights at the end of lightArray
     Data *lightData;
+
+    //! pass the (reallocated) guide and its state to the ISPC side
+    void updateGuide();
+
+    PathGuide guide;
+    bool pathGuiding {false};
+    int32 guidingIterations {0};  // the training iterations
+    int32 guideIteration {0};     // the current one, takes 2^i frames
+    int32 guideFrames {0};        // rendered in the current iteration
+    float guidingProbability {0.f};
+
+    RadianceCache radianceCache;
   };
 
 }// ::ospray
@@ -0,0 +1,52 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "common/OSPCommon.h"
+// std
+#include <vector>
+
+namespace ospray {
+
+  //! Radiance cache for interactive previews with indirect light: a grid
+  //  over world space (hashed into a fixed number of cells) whose cells
+  //  hold the mean outgoing radiance of the diffuse surfaces within,
+  //  recorded by the paths passing them. After their first rough bounce
+  //  paths end in a cell with enough samples, taking its radiance.
+  struct RadianceCache
+  {
+    //! same layout as RadianceCacheCell in RadianceCache.ih
+    struct Cell
+    {
+      int32 key;      //!< of the grid cell stored, 0 if free
+      int32 samples;  //!< recorded
+      vec3f radiance; //!< sum of the recorded outgoing radiance
+    };
+
+    //! Clear the cache, with (at least) 'numCells' cells
+    void reset(size_t numCells)
+    {
+      size_t n = 1;
+      while (n < numCells)
+        n *= 2;
+      cells.assign(n, Cell{0, 0, vec3f(0.f)});
+    }
+
+    std::vector<Cell> cells; //!< a power of two
+  };
+
+} // ::ospray
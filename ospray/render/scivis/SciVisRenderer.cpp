@@ -32,6 +32,11 @@ namespace ospray {
       ispcEquivalent = ispc::SciVisRenderer_create(this);
     }
 
+    SciVisRenderer::~SciVisRenderer()
+    {
+      ispc::SciVisRenderer_freeMemory(ispcEquivalent);
+    }
+
     void SciVisRenderer::commit()
     {
       Renderer::commit();
@@ -59,7 +64,7 @@ namespace ospray {
       void **lightPtr = lightArray.empty() ? nullptr : &lightArray[0];
 
       const bool shadowsEnabled = getParam1i("shadowsEnabled", 0);
-      int aoSamples = getParam1i("aoSamples", 0);
+      aoSamples = getParam1i("aoSamples", 0);
       float aoDistance = getParam1f("aoDistance",
                           getParam1f("aoOcclusionDistance"/*old name*/, 1e20f));
       // "aoWeight" is deprecated, use an ambient light instead
@@ -67,6 +72,9 @@ namespace ospray {
         aoColor = vec3f(getParam1f("aoWeight", 0.f));
       const bool aoTransparencyEnabled = getParam1i("aoTransparencyEnabled", 0);
       const bool oneSidedLighting = getParam1i("oneSidedLighting", 1);
+      const bool aoReuse = getParam1i("aoReuse", 0);
+      const int aoReuseSamples = getParam1i("aoReuseSamples", 1);
+      const int aoReuseHistory = getParam1i("aoReuseHistory", 64);
 
       ispc::SciVisRenderer_set(getIE(),
                                shadowsEnabled,
@@ -77,6 +85,17 @@ namespace ospray {
                                lightPtr,
                                lightArray.size(),
                                oneSidedLighting);
+      ispc::SciVisRenderer_setAOReuse(getIE(),
+                                      aoReuse,
+                                      aoReuseSamples,
+                                      aoReuseHistory);
+    }
+
+    void SciVisRenderer::setQualityLevel(int32 level)
+    {
+      Renderer::setQualityLevel(level);
+      ispc::SciVisRenderer_setAOSamples(getIE(),
+          aoSamples > 0 ? std::max(1, aoSamples >> level) : 0);
     }
 
     OSP_REGISTER_RENDERER(SciVisRenderer, rt);
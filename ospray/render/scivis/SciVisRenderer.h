@@ -53,10 +53,14 @@ namespace ospray {
     struct SciVisRenderer : public Renderer
     {
       SciVisRenderer();
-      virtual ~SciVisRenderer() override = default;
+      virtual ~SciVisRenderer() override;
       virtual std::string toString() const override;
       virtual void commit() override;
 
+      //! Additionally halves the number of AO samples with every level.
+      virtual void setQualityLevel(int32 level) override;
+
+      int32 aoSamples {0}; //!< as committed, i.e. at full quality
       std::vector<void*> lightArray; // the 'IE's of the XXXLights
       Data *lightData;
     };
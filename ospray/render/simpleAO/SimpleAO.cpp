@@ -17,8 +17,12 @@
 // ospray
 #include "SimpleAO.h"
 #include "SimpleAOMaterial.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
 // ispc exports
 #include "SimpleAO_ispc.h"
+// std
+#include <cmath>
 
 namespace ospray {
 
@@ -45,6 +49,79 @@ namespace ospray {
     int   numSamples = getParam1i("aoSamples", 1);
     float rayLength  = getParam1f("aoDistance", 1e20f);
     ispc::SimpleAO_set(getIE(), numSamples, rayLength);
+
+    const bool aoCones = getParam1i("aoCones", 0);
+    const int coneResolution = getParam1i("aoConeResolution", 128);
+
+    coneDims.clear();
+    coneDensity.clear();
+    if (aoCones && model && !model->bounds.empty()) {
+      buildConePyramid(clamp(coneResolution, 1, 1 << (maxConeLevels - 1)));
+    } else {
+      const vec3f lower(0.f);
+      ispc::SimpleAO_setCones(getIE(), 0, (const ispc::vec3f&)lower, 0.f);
+    }
+  }
+
+  void SimpleAO::buildConePyramid(int resolution)
+  {
+    const box3f &bounds = model->bounds;
+    const float voxelSize = reduce_max(bounds.size()) / resolution;
+    const vec3f extent = bounds.size() / voxelSize;
+    const vec3i dims = max(vec3i(1), vec3i(std::ceil(extent.x),
+                                           std::ceil(extent.y),
+                                           std::ceil(extent.z)));
+
+    coneDims.push_back(dims);
+    coneDensity.emplace_back(size_t(dims.x) * dims.y * dims.z);
+    float *density = coneDensity[0].data();
+    tasking::parallel_for(dims.z, [&](int z) {
+      ispc::SimpleAO_probeOccupancy(model->getIE(),
+                                    (const ispc::vec3f&)bounds.lower,
+                                    voxelSize,
+                                    (const ispc::vec3i&)dims,
+                                    z,
+                                    density);
+    });
+
+    // prefilter: every coarser level averages 2x2x2 voxels of the finer
+    while (reduce_max(coneDims.back()) > 1
+        && coneDims.size() < size_t(maxConeLevels)) {
+      const vec3i fine = coneDims.back();
+      const vec3i coarse = divRoundUp(fine, vec3i(2));
+      std::vector<float> level(size_t(coarse.x) * coarse.y * coarse.z);
+      const std::vector<float> &src = coneDensity.back();
+
+      tasking::parallel_for(coarse.z, [&](int z) {
+        for (int y = 0; y < coarse.y; y++) {
+          for (int x = 0; x < coarse.x; x++) {
+            float sum = 0.f;
+            for (int i = 0; i < 8; i++) {
+              // voxels outside of the finer level count as empty
+              const vec3i c = 2 * vec3i(x, y, z)
+                + vec3i(i & 1, (i >> 1) & 1, i >> 2);
+              if (c.x < fine.x && c.y < fine.y && c.z < fine.z)
+                sum += src[(size_t(c.z) * fine.y + c.y) * fine.x + c.x];
+            }
+            level[(size_t(z) * coarse.y + y) * coarse.x + x] = sum / 8.f;
+          }
+        }
+      });
+
+      coneDims.push_back(coarse);
+      coneDensity.push_back(std::move(level));
+    }
+
+    ispc::SimpleAO_setCones(getIE(),
+                            coneDims.size(),
+                            (const ispc::vec3f&)bounds.lower,
+                            voxelSize);
+    for (size_t i = 0; i < coneDims.size(); i++) {
+      ispc::SimpleAO_setConeLevel(getIE(),
+                                  i,
+                                  (const ispc::vec3i&)coneDims[i],
+                                  coneDensity[i].data());
+    }
   }
 
   OSP_REGISTER_RENDERER(SimpleAO(4), ao);
@@ -33,6 +33,8 @@
 
 // ospray
 #include "render/Renderer.h"
+// std
+#include <vector>
 
 namespace ospray {
 
@@ -51,9 +53,20 @@ namespace ospray {
     virtual std::string toString() const override;
     virtual void commit() override;
 
+    //! finest levels of more than 2^16 voxels are not supported
+    static constexpr int maxConeLevels = 16;
+
   private:
 
+    /*! build the occupancy pyramid of 'model' for cone traced AO, with
+        'resolution' voxels along the largest extent of its bounds */
+    void buildConePyramid(int resolution);
+
     int numSamples{1};
+
+    //! the levels of the occupancy pyramid, finest first
+    std::vector<vec3i> coneDims;
+    std::vector<std::vector<float>> coneDensity;
   };
 
 } // ::ospray
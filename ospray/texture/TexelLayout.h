@@ -0,0 +1,91 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "common/OSPCommon.h"
+// std
+#include <cmath>
+
+namespace ospray {
+
+  /*! \brief The per-texel layout of an (uncompressed) OSPTextureFormat:
+      the number of channels, whether they are floats, and how many of the
+      leading channels are sRGB encoded.
+
+      Used to filter texels on the host, in linear space. */
+  struct TexelLayout
+  {
+    int channels;
+    bool isFloat;
+    int srgbChannels;
+
+    //! The layout of 'type', zero channels if it is not supported.
+    static TexelLayout of(OSPTextureFormat type)
+    {
+      switch (type) {
+      case OSP_TEXTURE_RGBA8:   return {4, false, 0};
+      case OSP_TEXTURE_SRGBA:   return {4, false, 3};
+      case OSP_TEXTURE_RGBA32F: return {4, true,  0};
+      case OSP_TEXTURE_RGB8:    return {3, false, 0};
+      case OSP_TEXTURE_SRGB:    return {3, false, 3};
+      case OSP_TEXTURE_RGB32F:  return {3, true,  0};
+      case OSP_TEXTURE_R8:      return {1, false, 0};
+      case OSP_TEXTURE_L8:      return {1, false, 1};
+      case OSP_TEXTURE_RA8:     return {2, false, 0};
+      case OSP_TEXTURE_LA8:     return {2, false, 1};
+      case OSP_TEXTURE_R32F:    return {1, true,  0};
+      default:                  return {0, false, 0};
+      }
+    }
+
+    //! Linear value of channel 'c' of texel 'i'.
+    float load(const void *texels, size_t i, int c) const
+    {
+      i = i * channels + c;
+      if (isFloat)
+        return ((const float *)texels)[i];
+      const float v = ((const uint8_t *)texels)[i] * (1.f / 255.f);
+      return c < srgbChannels ? srgbToLinear(v) : v;
+    }
+
+    //! Encode the linear value 'v' into channel 'c' of texel 'i'.
+    void store(void *texels, size_t i, int c, float v) const
+    {
+      i = i * channels + c;
+      if (isFloat) {
+        ((float *)texels)[i] = v;
+        return;
+      }
+      if (c < srgbChannels)
+        v = linearToSrgb(v);
+      ((uint8_t *)texels)[i] = uint8_t(clamp(v, 0.f, 1.f) * 255.f + 0.5f);
+    }
+
+    static float srgbToLinear(float c)
+    {
+      return c <= 0.04045f ? c / 12.92f
+                           : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static float linearToSrgb(float c)
+    {
+      return c <= 0.0031308f ? 12.92f * c
+                             : std::pow(c, 1.f / 2.4f) * 1.055f - 0.055f;
+    }
+  };
+
+} // ::ospray
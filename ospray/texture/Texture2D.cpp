@@ -15,12 +15,49 @@
 // ======================================================================== //
 
 #include "Texture2D.h"
+#include "TexelLayout.h"
 #include "Texture2D_ispc.h"
+#include "OSPCommon_ispc.h"
 
 #include "../common/Data.h"
+#include "ospcommon/tasking/parallel_for.h"
 
 namespace ospray {
 
+  namespace {
+
+    //! Average 2x2 texels of 'src' into each texel of the half-sized 'dst',
+    //!  in linear space; odd sizes clamp to the last row/column.
+    void downsample(const TexelLayout &layout,
+                    const vec2i &srcSize, const uint8_t *src,
+                    const vec2i &dstSize, uint8_t *dst)
+    {
+      auto load = [&](int x, int y, int c) {
+        return layout.load(src, size_t(y) * srcSize.x + x, c);
+      };
+
+      tasking::parallel_for(dstSize.y, [&](int y) {
+        const int y0 = std::min(2 * y, srcSize.y - 1);
+        const int y1 = std::min(2 * y + 1, srcSize.y - 1);
+        for (int x = 0; x < dstSize.x; x++) {
+          const int x0 = std::min(2 * x, srcSize.x - 1);
+          const int x1 = std::min(2 * x + 1, srcSize.x - 1);
+          for (int c = 0; c < layout.channels; c++) {
+            layout.store(dst, size_t(y) * dstSize.x + x, c,
+                         0.25f * (load(x0, y0, c) + load(x1, y0, c)
+                                + load(x0, y1, c) + load(x1, y1, c)));
+          }
+        }
+      });
+    }
+
+  } // ::ospray::{anonymous}
+
+  Texture2D::~Texture2D()
+  {
+    freeMipLevels();
+  }
+
   std::string Texture2D::toString() const
   {
     return "ospray::Texture2D";
@@ -46,7 +83,7 @@ namespace ospray {
     );
     flags = getParam1i("flags", 0);
 
-    const size_t numBytesExpected = sizeOf(type) * size.x * size.y;
+    const size_t numBytesExpected = sizeOf(type, size);
 
     if (numBytesExpected != texData->numBytes) {
       std::stringstream ss;
@@ -58,6 +95,55 @@ namespace ospray {
 
     this->ispcEquivalent = ispc::Texture2D_create((ispc::vec2i&)size,
                                                   texData->data, type, flags);
+
+    freeMipLevels();
+    if (flags & OSP_TEXTURE_FILTER_MIPMAP) {
+      // the mip levels take up to a third of level 0
+      checkMemoryBudget(numBytesExpected / 3);
+      buildMipLevels(size, texData->data);
+    }
+
+    // the texels of level 0 are counted at the data
+    size_t mipBytes = 0;
+    for (const auto &level : mipData)
+      mipBytes += level.size();
+    setMemoryUsage(OSP_MEMORY_TEXTURE, mipBytes);
+  }
+
+  void Texture2D::buildMipLevels(const vec2i &size, const void *data)
+  {
+    const TexelLayout layout = TexelLayout::of(type);
+    if (layout.channels == 0) {
+      static WarnOnce warning("MIP maps are not generated for block-compressed "
+                              "textures, ignoring OSP_TEXTURE_FILTER_MIPMAP");
+      return;
+    }
+
+    const size_t texelBytes = sizeOf(type);
+    vec2i levelSize = size;
+    const uint8_t *levelData = (const uint8_t *)data;
+
+    while (levelSize.x > 1 || levelSize.y > 1) {
+      const vec2i nextSize = max(levelSize / 2, vec2i(1));
+      mipData.emplace_back(texelBytes * nextSize.x * nextSize.y);
+      downsample(layout, levelSize, levelData, nextSize, mipData.back().data());
+
+      levelSize = nextSize;
+      levelData = mipData.back().data();
+      mipLevels.push_back(ispc::Texture2D_create((ispc::vec2i&)levelSize,
+                                                 (void*)levelData, type,
+                                                 flags & ~OSP_TEXTURE_FILTER_MIPMAP));
+    }
+
+    ispc::Texture2D_setMipLevels(getIE(), mipLevels.data(), mipLevels.size());
+  }
+
+  void Texture2D::freeMipLevels()
+  {
+    for (auto *level : mipLevels)
+      ispc::delete_uniform(level);
+    mipLevels.clear();
+    mipData.clear();
   }
 
   OSP_REGISTER_TEXTURE(Texture2D, texture2d);
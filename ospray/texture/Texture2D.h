@@ -17,13 +17,15 @@
 #pragma once
 
 #include "Texture.h"
+// std
+#include <vector>
 
 namespace ospray {
 
   /*! \brief A Texture defined through a 2D Image. */
   struct OSPRAY_SDK_INTERFACE Texture2D : public Texture
   {
-    virtual ~Texture2D() override = default;
+    virtual ~Texture2D() override;
 
     virtual std::string toString() const override;
 
@@ -31,6 +33,18 @@ namespace ospray {
 
     OSPTextureFormat type;
     int flags;
+
+  private:
+
+    //! Build the MIP levels below the given base level (with
+    //!  OSP_TEXTURE_FILTER_MIPMAP).
+    void buildMipLevels(const vec2i &size, const void *data);
+
+    void freeMipLevels();
+
+    //! Texels and ISPC equivalents of MIP levels 1 and higher.
+    std::vector<std::vector<uint8_t>> mipData;
+    std::vector<void *> mipLevels;
   };
 
 } // ::ospray
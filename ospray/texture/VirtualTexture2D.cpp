@@ -0,0 +1,341 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "VirtualTexture2D.h"
+#include "TexelLayout.h"
+#include "Texture2D_ispc.h"
+#include "VirtualTexture2D_ispc.h"
+#include "OSPCommon_ispc.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/tasking/schedule.h"
+// std
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <thread>
+
+namespace ospray {
+
+  namespace {
+
+    //! must match VIRTUAL_TILE_SIZE in VirtualTexture2D.ispc
+    constexpr int tileWidth = 128;
+
+    //! The live virtual textures, for beginFrameAll().
+    std::set<VirtualTexture2D *> &registry()
+    {
+      static std::set<VirtualTexture2D *> textures;
+      return textures;
+    }
+
+    std::mutex registryMutex;
+
+    //! The frames in flight (rendered into different frame buffers),
+    //!  guarded by 'registryMutex'.
+    int framesInFlight {0};
+
+  } // ::ospray::{anonymous}
+
+  extern "C" void ospray_VirtualTexture2D_requestTile(void *cppTexture,
+                                                      uint32 tileID)
+  {
+    static_cast<VirtualTexture2D *>(cppTexture)->requestTile(tileID);
+  }
+
+  VirtualTexture2D::VirtualTexture2D()
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry().insert(this);
+  }
+
+  VirtualTexture2D::~VirtualTexture2D()
+  {
+    {
+      std::lock_guard<std::mutex> lock(registryMutex);
+      registry().erase(this);
+    }
+
+    // the background loads access this texture
+    while (runningLoads > 0)
+      std::this_thread::yield();
+
+    for (auto *tile : tiles)
+      ispc::delete_uniform(tile);
+    ispc::delete_uniform(tail);
+  }
+
+  std::string VirtualTexture2D::toString() const
+  {
+    return "ospray::VirtualTexture2D";
+  }
+
+  void VirtualTexture2D::commit()
+  {
+    if (ispcEquivalent != nullptr) {
+      static WarnOnce warning("virtual_texture2d cannot be changed after the "
+                              "first commit, ignoring the new parameters");
+      return;
+    }
+
+    size = getParam<vec2i>("size", vec2i(0));
+    if (size.x <= 0 || size.y <= 0) {
+      std::stringstream ss;
+      ss << "'size' param on virtual_texture2d must be positive! got " << size;
+      throw std::runtime_error(ss.str());
+    }
+
+    type = static_cast<OSPTextureFormat>(
+      getParam1i("type", OSP_TEXTURE_FORMAT_INVALID)
+    );
+    if (TexelLayout::of(type).channels == 0) {
+      throw std::runtime_error("virtual_texture2d only supports uncompressed "
+                               "texture formats");
+    }
+    flags = getParam1i("flags", 0) & ~OSP_TEXTURE_FILTER_MIPMAP;
+    texelBytes = sizeOf(type);
+
+    fileName = getParamString("filename", "");
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file) {
+      throw std::runtime_error("virtual_texture2d: cannot open 'filename' ("
+                               + fileName + ")");
+    }
+    if (size_t(file.tellg()) < sizeOf(type, size)) {
+      throw std::runtime_error("virtual_texture2d: 'filename' (" + fileName
+                               + ") is smaller than 'size' and 'type' imply");
+    }
+
+    maxMemory = size_t(std::max(1, getParam1i("maxMemory", 256))) << 20;
+
+    numTiles = (size + (tileWidth - 1)) / tileWidth;
+    const size_t totalTiles = size_t(numTiles.x) * numTiles.y;
+    tileData.resize(totalTiles);
+    tiles.assign(totalTiles, nullptr);
+    tileLastUsed.assign(totalTiles, 0);
+    requested.reset(new std::atomic<bool>[totalTiles]);
+    for (size_t i = 0; i < totalTiles; i++)
+      requested[i] = false;
+
+    buildTail();
+
+    ispcEquivalent = ispc::VirtualTexture2D_create(this,
+                                                   (ispc::vec2i&)size,
+                                                   type,
+                                                   flags,
+                                                   tail,
+                                                   tailLevel,
+                                                   tiles.data(),
+                                                   tileLastUsed.data());
+  }
+
+  void VirtualTexture2D::buildTail()
+  {
+    // the tail is the first MIP level fitting into a tile
+    vec2i tailSize = size;
+    for (tailLevel = 0; reduce_max(tailSize) > tileWidth; tailLevel++)
+      tailSize = max(tailSize / 2, vec2i(1));
+
+    // average the texels of each tail texel, in linear space
+    const TexelLayout layout = TexelLayout::of(type);
+    std::vector<float> sum(size_t(tailSize.x) * tailSize.y * layout.channels);
+    std::vector<int> count(size_t(tailSize.x) * tailSize.y, 0);
+
+    std::ifstream file(fileName, std::ios::binary);
+    std::vector<uint8_t> row(size.x * texelBytes);
+    for (int y = 0; y < size.y; y++) {
+      readTexels(file, 0, y, size.x, row.data());
+      const int ty = std::min(y >> tailLevel, tailSize.y - 1);
+      for (int x = 0; x < size.x; x++) {
+        const size_t t = size_t(ty) * tailSize.x
+                         + std::min(x >> tailLevel, tailSize.x - 1);
+        for (int c = 0; c < layout.channels; c++)
+          sum[t * layout.channels + c] += layout.load(row.data(), x, c);
+        count[t]++;
+      }
+    }
+
+    if (!file) {
+      postStatusMsg(1) << "#osp: virtual_texture2d: failed to read "
+                       << fileName;
+    }
+
+    tailData.resize(count.size() * texelBytes);
+    for (size_t t = 0; t < count.size(); t++) {
+      for (int c = 0; c < layout.channels; c++) {
+        layout.store(tailData.data(), t, c,
+                     sum[t * layout.channels + c] / std::max(count[t], 1));
+      }
+    }
+
+    tail = ispc::Texture2D_create((ispc::vec2i&)tailSize, tailData.data(),
+                                  type, flags);
+  }
+
+  void VirtualTexture2D::beginFrameAll()
+  {
+    // Frames starting meanwhile wait for the tiles to be published.
+    std::lock_guard<std::mutex> lock(registryMutex);
+    const bool publish = ++framesInFlight == 1;
+    for (auto *texture : registry()) {
+      if (texture->getIE())
+        texture->beginFrame(publish);
+    }
+  }
+
+  void VirtualTexture2D::endFrameAll()
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    framesInFlight--;
+  }
+
+  void VirtualTexture2D::beginFrame(bool publish)
+  {
+    std::vector<LoadedTile> newTiles;
+    if (publish) {
+      std::lock_guard<std::mutex> lock(mutex);
+      newTiles.swap(loaded);
+      pendingLoads -= newTiles.size();
+    }
+
+    // Nothing is rendered now, so the loaded tiles can be published.
+    const size_t bytesPerTile = size_t(tileWidth + 2) * (tileWidth + 2)
+                                * texelBytes;
+    if (!newTiles.empty()) {
+      evict(maxMemory - std::min(maxMemory, newTiles.size() * bytesPerTile));
+      for (auto &tile : newTiles) {
+        storeTile(tile.id, tile.texels);
+        requested[tile.id] = false;
+      }
+    }
+
+    ispc::VirtualTexture2D_setFrame(ispcEquivalent, ++frame);
+
+    // Load the tiles requested while rendering in the background, with
+    // at most a quarter of the memory budget in flight.
+    const size_t maxPending = std::max<size_t>(1, maxMemory / (4 * bytesPerTile));
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!requests.empty() && pendingLoads < maxPending) {
+      const uint32_t id = requests.front();
+      requests.pop_front();
+      pendingLoads++;
+      runningLoads++;
+      tasking::schedule([=]() {
+        LoadedTile tile;
+        tile.id = id;
+        readTile(id, tile.texels);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          loaded.push_back(std::move(tile));
+        }
+        runningLoads--;
+      });
+    }
+  }
+
+  void VirtualTexture2D::requestTile(uint32_t tileID)
+  {
+    if (requested[tileID].exchange(true))
+      return;
+    std::lock_guard<std::mutex> lock(mutex);
+    requests.push_back(tileID);
+  }
+
+  vec2i VirtualTexture2D::tileSize(uint32_t tileID) const
+  {
+    const vec2i lower = tileWidth * vec2i(tileID % numTiles.x,
+                                          tileID / numTiles.x);
+    return min(lower + tileWidth, size) - lower + 2;
+  }
+
+  void VirtualTexture2D::readTexels(std::ifstream &file, int x, int y,
+                                    int count, uint8_t *texels) const
+  {
+    y = (y + size.y) % size.y;
+    while (count > 0) {
+      x = (x + size.x) % size.x;
+      const int run = std::min(count, size.x - x);
+      file.seekg((size_t(y) * size.x + x) * texelBytes);
+      file.read((char *)texels, run * texelBytes);
+      texels += run * texelBytes;
+      count -= run;
+      x += run;
+    }
+  }
+
+  void VirtualTexture2D::readTile(uint32_t tileID,
+                                  std::vector<uint8_t> &texels) const
+  {
+    // the border texels repeat the image, like the texture coordinates
+    const vec2i lower = tileWidth * vec2i(tileID % numTiles.x,
+                                          tileID / numTiles.x) - 1;
+    const vec2i extent = tileSize(tileID);
+    const size_t rowBytes = extent.x * texelBytes;
+    texels.assign(extent.y * rowBytes, 0);
+
+    std::ifstream file(fileName, std::ios::binary);
+    for (int y = 0; y < extent.y; y++)
+      readTexels(file, lower.x, lower.y + y, extent.x, &texels[y * rowBytes]);
+
+    if (!file) {
+      postStatusMsg(1) << "#osp: virtual_texture2d: failed to read tile "
+                       << tileID << " from " << fileName;
+    }
+  }
+
+  void VirtualTexture2D::storeTile(uint32_t tileID,
+                                   std::vector<uint8_t> &texels)
+  {
+    if (tiles[tileID])
+      return;
+
+    tileData[tileID].swap(texels);
+    const vec2i extent = tileSize(tileID);
+    tiles[tileID] = ispc::Texture2D_create((ispc::vec2i&)extent,
+                                           tileData[tileID].data(),
+                                           type, flags);
+    tileLastUsed[tileID] = frame;
+    residentBytes += tileData[tileID].size();
+  }
+
+  void VirtualTexture2D::evict(size_t budget)
+  {
+    if (residentBytes <= budget)
+      return;
+
+    // (frame last used, tile) of the resident tiles
+    std::vector<std::pair<int32, uint32_t>> resident;
+    for (size_t i = 0; i < tiles.size(); i++) {
+      if (tiles[i])
+        resident.emplace_back(tileLastUsed[i], i);
+    }
+    std::sort(resident.begin(), resident.end());
+
+    for (const auto &tile : resident) {
+      if (residentBytes <= budget)
+        break;
+      const uint32_t id = tile.second;
+      ispc::delete_uniform(tiles[id]);
+      tiles[id] = nullptr;
+      residentBytes -= tileData[id].size();
+      std::vector<uint8_t>().swap(tileData[id]);
+    }
+  }
+
+  // A texture type which pages the tiles of a large image from a file.
+  OSP_REGISTER_TEXTURE(VirtualTexture2D, virtual_texture2d);
+
+} // ::ospray
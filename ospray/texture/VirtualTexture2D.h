@@ -0,0 +1,118 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "Texture2D.h"
+// std
+#include <atomic>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+
+namespace ospray {
+
+  /*! \brief A Texture2D much larger than memory, whose 128x128 texel tiles
+      are loaded on demand from a raw file and kept in an LRU cache.
+
+      Tiles which are not resident are sampled from a resident, downsampled
+      copy of the image (the "tail") until the tile is loaded, which happens
+      in the background between frames.
+   */
+  struct OSPRAY_SDK_INTERFACE VirtualTexture2D : public Texture2D
+  {
+    VirtualTexture2D();
+    virtual ~VirtualTexture2D() override;
+
+    virtual std::string toString() const override;
+
+    //! Open the texel file and build the tail in one streaming pass.
+    virtual void commit() override;
+
+    //! Publish the tiles of all virtual textures loaded meanwhile and issue
+    //!  new requests; called by the renderer before each frame.
+    static void beginFrameAll();
+
+    //! Called by the renderer after each frame.
+    static void endFrameAll();
+
+    //! Called (from the renderer's threads) when a missing tile is sampled.
+    void requestTile(uint32_t tileID);
+
+  private:
+
+    struct LoadedTile
+    {
+      uint32_t id;
+      std::vector<uint8_t> texels;
+    };
+
+    //! 'publish' the tiles loaded meanwhile, only done when no other
+    //!  frame is rendered
+    void beginFrame(bool publish);
+
+    //! Size of the tile (including its border) in texels.
+    vec2i tileSize(uint32_t tileID) const;
+
+    //! Read 'count' texels of row 'y' starting at column 'x', wrapping
+    //!  around at the borders of the image.
+    void readTexels(std::ifstream &file, int x, int y, int count,
+                    uint8_t *texels) const;
+
+    //! Read the texels of a tile, with the border, from the file.
+    void readTile(uint32_t tileID, std::vector<uint8_t> &texels) const;
+
+    //! Make a (read) tile resident.
+    void storeTile(uint32_t tileID, std::vector<uint8_t> &texels);
+
+    //! Stream the image through memory to build the tail.
+    void buildTail();
+
+    //! Evict the least recently used tiles until at most 'budget' bytes
+    //!  are resident.
+    void evict(size_t budget);
+
+    std::string fileName;
+    vec2i size;
+    size_t texelBytes {0};
+    size_t maxMemory {0};
+    vec2i numTiles;
+    int32 frame {0};
+
+    //! The downsampled image, its MIP level and ISPC equivalent.
+    std::vector<uint8_t> tailData;
+    int tailLevel {0};
+    void *tail {nullptr};
+
+    //! The texels and ISPC equivalents (shared with ISPC) of the resident
+    //!  tiles, the frame they were last used, and the memory they use.
+    std::vector<std::vector<uint8_t>> tileData;
+    std::vector<void *> tiles;
+    std::vector<int32> tileLastUsed;
+    size_t residentBytes {0};
+
+    //! Paging state: tiles requested, in flight and loaded (but not yet
+    //!  published), guarded by 'mutex'.
+    std::unique_ptr<std::atomic<bool>[]> requested;
+    std::deque<uint32_t> requests;
+    std::vector<LoadedTile> loaded;
+    size_t pendingLoads {0};
+    std::atomic<int> runningLoads {0};
+    std::mutex mutex;
+  };
+
+} // ::ospray
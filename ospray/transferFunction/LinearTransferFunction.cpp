@@ -15,7 +15,10 @@
 // ======================================================================== //
 
 #include "transferFunction/LinearTransferFunction.h"
+#include "common/AccelCache.h"
 #include "LinearTransferFunction_ispc.h"
+// std
+#include <algorithm>
 
 namespace ospray {
 
@@ -35,25 +38,35 @@ namespace ospray {
     // Retrieve the color and opacity values.
     colorValues   = getParamData("colors", nullptr);
     opacityValues = getParamData("opacities", nullptr);
+    const bool preIntegration = getParam1i("preIntegration", 0);
     ispc::LinearTransferFunction_setPreIntegration(ispcEquivalent,
-                                               getParam1i("preIntegration", 0));
+                                                   preIntegration);
 
-    // Set the color values.
-    if (colorValues) {
-      ispc::LinearTransferFunction_setColorValues(ispcEquivalent,
-                                                  colorValues->numItems,
-                                                  (ispc::vec3f*)colorValues->data);
-    }
+    // Only pass (and resample) the values again if they actually changed,
+    // a commit of e.g. only a new value range keeps the lookup table.
+    const uint64 newHash = hashValues();
+    if (newHash != valuesHash) {
+      valuesHash = newHash;
 
-    // Set the opacity values.
-    if (opacityValues) {
-      ispc::LinearTransferFunction_setOpacityValues(ispcEquivalent,
-                                                    opacityValues->numItems,
-                                                    (float *)opacityValues->data);
+      // Set the color values.
+      if (colorValues) {
+        ispc::LinearTransferFunction_setColorValues(ispcEquivalent,
+                                                    colorValues->numItems,
+                                                    (ispc::vec3f*)colorValues->data);
+      }
+
+      // Set the opacity values.
+      if (opacityValues) {
+        ispc::LinearTransferFunction_setOpacityValues(ispcEquivalent,
+                                                      opacityValues->numItems,
+                                                      (float *)opacityValues->data);
+      }
+
+      ispc::LinearTransferFunction_resampleLUT(ispcEquivalent);
     }
 
-    if (getParam1i("preIntegration", 0) && colorValues && opacityValues)
-      ispc::LinearTransferFunction_precomputePreIntegratedValues(ispcEquivalent);
+    if (preIntegration && colorValues && opacityValues)
+      setPreIntegratedValues();
 
     TransferFunction::commit();
 
@@ -61,6 +74,50 @@ namespace ospray {
     notifyListenersThatObjectGotChanged();
   }
 
+  uint64 LinearTransferFunction::hashValues() const
+  {
+    uint64 hash = 0;
+    if (colorValues) {
+      hash = AccelCache::hash(&colorValues->numItems, sizeof(size_t), hash);
+      hash = AccelCache::hash(colorValues->data,
+                              colorValues->numItems * sizeof(vec3f), hash);
+    }
+    if (opacityValues) {
+      hash = AccelCache::hash(&opacityValues->numItems, sizeof(size_t), hash);
+      hash = AccelCache::hash(opacityValues->data,
+                              opacityValues->numItems * sizeof(float), hash);
+    }
+    return hash == 0 ? 1 : hash;
+  }
+
+  void LinearTransferFunction::setPreIntegratedValues()
+  {
+    auto tables = std::find_if(preIntegrationCache.begin(),
+                               preIntegrationCache.end(),
+                               [&](const PreIntegrationTables &t) {
+                                 return t.valuesHash == valuesHash;
+                               });
+
+    const bool compute = tables == preIntegrationCache.end();
+    if (compute) {
+      if (preIntegrationCache.size() == preIntegrationCacheSize)
+        preIntegrationCache.pop_back();
+      const size_t numOpacities = opacityValues->numItems;
+      const size_t numColors = colorValues->numItems;
+      preIntegrationCache.push_front(PreIntegrationTables());
+      preIntegrationCache.front().valuesHash = valuesHash;
+      preIntegrationCache.front().opacity.resize(numOpacities * numOpacities);
+      preIntegrationCache.front().color.resize(numColors * numColors);
+    } else {
+      preIntegrationCache.splice(preIntegrationCache.begin(),
+                                 preIntegrationCache, tables);
+    }
+
+    auto &front = preIntegrationCache.front();
+    ispc::LinearTransferFunction_setPreIntegratedValues(ispcEquivalent,
+        front.opacity.data(), (ispc::vec3f*)front.color.data(), compute);
+  }
+
   std::string LinearTransferFunction::toString() const
   {
     return "ospray::LinearTransferFunction";
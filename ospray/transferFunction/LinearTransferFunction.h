@@ -19,6 +19,8 @@
 // ospray
 #include "common/Data.h"
 #include "transferFunction/TransferFunction.h"
+// std
+#include <list>
 
 namespace ospray {
 
@@ -36,11 +38,34 @@ namespace ospray {
 
   private:
 
+    //! Hash of the color and opacity values (and their counts).
+    uint64 hashValues() const;
+
+    //! Use the preintegration tables for the current values, computing them
+    //!  only if they are not cached yet.
+    void setPreIntegratedValues();
+
+    //! The preintegration tables of one set of color and opacity values.
+    struct PreIntegrationTables
+    {
+      uint64 valuesHash;
+      std::vector<float> opacity;
+      std::vector<vec3f> color;
+    };
+
     //! Data array that stores the color map.
     Ref<Data> colorValues;
 
     //! Data array that stores the opacity map.
     Ref<Data> opacityValues;
+
+    //! Hash of the values last passed to ISPC, 0 before the first commit.
+    uint64 valuesHash {0};
+
+    //! The most recently used preintegration tables, most recent first (so
+    //!  toggling between a few transfer functions does not recompute them).
+    std::list<PreIntegrationTables> preIntegrationCache;
+    static constexpr size_t preIntegrationCacheSize = 4;
   };
 
 } // ::ospray
@@ -28,6 +28,17 @@ namespace ospray {
                                          (const ispc::vec2f &)valueRange);
   }
 
+  void TransferFunction::getColorsAndOpacities(size_t count,
+                                               const float *values,
+                                               vec3f *colors,
+                                               float *opacities) const
+  {
+    ispc::TransferFunction_getColorsAndOpacities(ispcEquivalent, count,
+                                                 values,
+                                                 (ispc::vec3f *)colors,
+                                                 opacities);
+  }
+
   std::string TransferFunction::toString() const
   {
     return "ospray::TransferFunction";
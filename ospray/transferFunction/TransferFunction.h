@@ -36,6 +36,12 @@ namespace ospray {
     virtual void commit() override;
     virtual std::string toString() const override;
 
+    //! Look up the colors and opacities of the given values.
+    void getColorsAndOpacities(size_t count,
+                               const float *values,
+                               vec3f *colors,
+                               float *opacities) const;
+
     //! Create a transfer function of the given type.
     static TransferFunction *createInstance(const std::string &type);
   };
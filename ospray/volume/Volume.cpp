@@ -20,9 +20,14 @@
 #include "transferFunction/TransferFunction.h"
 #include "common/Data.h"
 #include "Volume_ispc.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
 
 namespace ospray {
 
+  //! The number of samples of a pattern computed per task.
+  static constexpr size_t sampleBatchSize = 4096;
+
   bool Volume::isDataDistributed() const
   {
     return false;
@@ -65,6 +70,60 @@ namespace ospray {
     memcpy(*results, ptr, count * sizeof(float));
   }
 
+  void Volume::computeSampleBatch(const OSPSamplePattern &pattern,
+                                  float *values,
+                                  vec3f *gradients)
+  {
+    // The ISPC volume container must exist at this point.
+    assert(ispcEquivalent != nullptr);
+
+    // positions are 'origin + u * du + v * dv' unless given as points
+    const vec3f *points = nullptr;
+    size_t numSamples   = pattern.count[0];
+    size_t numU         = pattern.count[0];
+    switch (pattern.type) {
+    case OSP_SAMPLE_POINTS:
+      if (!pattern.points && numSamples > 0)
+        throw std::runtime_error("no points given to sample the volume at");
+      points = (const vec3f *)pattern.points;
+      break;
+    case OSP_SAMPLE_LINE:
+      break;
+    case OSP_SAMPLE_PLANE:
+      numSamples *= pattern.count[1];
+      break;
+    default:
+      throw std::runtime_error("unknown volume sample pattern");
+    }
+
+    if (numSamples == 0)
+      return;
+
+    const size_t numTasks = divRoundUp(numSamples, sampleBatchSize);
+    tasking::parallel_for(numTasks, [&](size_t taskID) {
+      const size_t begin = taskID * sampleBatchSize;
+      const size_t end   = std::min(begin + sampleBatchSize, numSamples);
+      ispc::Volume_computeSampleBatch(ispcEquivalent,
+                                      (const ispc::vec3f *)points,
+                                      (const ispc::vec3f &)pattern.origin,
+                                      (const ispc::vec3f &)pattern.du,
+                                      (const ispc::vec3f &)pattern.dv,
+                                      numU,
+                                      begin,
+                                      end,
+                                      values,
+                                      (ispc::vec3f *)gradients);
+    });
+  }
+
+  void Volume::beginFrame()
+  {
+  }
+
+  void Volume::endFrame()
+  {
+  }
+
   void Volume::finish()
   {
     // The ISPC volume container must exist at this point.
@@ -58,10 +58,23 @@ namespace ospray {
                                 const vec3f *worldCoordinates,
                                 const size_t &count);
 
+    //! Compute samples (and gradients, if not NULL) at the positions of the
+    //!  given pattern, in parallel.
+    virtual void computeSampleBatch(const OSPSamplePattern &pattern,
+                                    float *values,
+                                    vec3f *gradients);
+
     //! Update select editable parameters (allowed after the volume has been
     //! initially committed).
     virtual void updateEditableParameters();
 
+    //! Called (on each node) before a frame is rendered with this volume,
+    //!  e.g. to update paged in voxel data.
+    virtual void beginFrame();
+
+    //! Called (on each node) after a frame rendered with this volume.
+    virtual void endFrame();
+
   protected:
 
     //! Complete volume initialization (only on first commit).
@@ -15,10 +15,21 @@
 // ======================================================================== //
 
 #include "AMRAccel.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <algorithm>
 
 namespace ospray {
   namespace amr {
 
+    namespace {
+
+      //! build the two subtrees of a node in parallel above this many bricks
+      constexpr size_t parallelThreshold = 4096;
+
+    } // ::ospray::amr::{anonymous}
+
     /*! constructor that constructs the actual accel from the amr data */
     AMRAccel::AMRAccel(const AMRData &input)
     {
@@ -39,78 +50,205 @@ namespace ospray {
         level[b->level].rcpCellWidth = 1.f/b->cellWidth;
       }
 
-      node.resize(1);
-      buildRec(0, bounds, brickVec);
+      Subtree tree;
+      tree.node.resize(1);
+      buildRec(input, tree, 0, bounds, brickVec);
+
+      node    = std::move(tree.node);
+      leaf    = std::move(tree.leaf);
+      brickID = std::move(tree.brickID);
+    }
+
+    namespace {
+
+      enum CacheTag
+      {
+        CACHE_WORLD_BOUNDS,
+        CACHE_LEVELS,
+        CACHE_NODES,
+        CACHE_LEAF_BOUNDS,
+        CACHE_LEAF_BRICK_BEGIN,
+        CACHE_LEAF_BRICK_IDS
+      };
+
+      template <typename T>
+      inline const T *cacheSection(const AccelCache &cache,
+                                   uint32 tag,
+                                   size_t &num)
+      {
+        size_t numBytes;
+        const T *items = (const T *)cache.section(tag, numBytes);
+        num = numBytes / sizeof(T);
+        return (numBytes % sizeof(T)) ? nullptr : items;
+      }
+
+    } // ::ospray::amr::{anonymous}
+
+    AMRAccel::AMRAccel(const AMRData &input, const AccelCache &cache)
+    {
+      size_t numBounds, numLevels, numNodes, numLeaves, numBegins, numIDs;
+      auto bounds = cacheSection<box3f>(cache, CACHE_WORLD_BOUNDS, numBounds);
+      auto levels = cacheSection<Level>(cache, CACHE_LEVELS, numLevels);
+      auto nodes  = cacheSection<Node>(cache, CACHE_NODES, numNodes);
+      auto leafBounds =
+          cacheSection<box3f>(cache, CACHE_LEAF_BOUNDS, numLeaves);
+      auto begin =
+          cacheSection<uint32>(cache, CACHE_LEAF_BRICK_BEGIN, numBegins);
+      auto ids =
+          cacheSection<uint32>(cache, CACHE_LEAF_BRICK_IDS, numIDs);
+
+      if (!bounds || numBounds != 1 || !levels || !nodes || numNodes == 0 ||
+          !leafBounds || !begin || numBegins != numLeaves + 1 || !ids ||
+          begin[numLeaves] != numIDs)
+        return;
+      for (size_t i = 0; i < numLeaves; i++) {
+        if (begin[i] > begin[i + 1])
+          return;
+      }
+      for (size_t i = 0; i < numIDs; i++) {
+        if (ids[i] >= input.brick.size())
+          return;
+      }
+
+      worldBounds = *bounds;
+      level.assign(levels, levels + numLevels);
+      node.assign(nodes, nodes + numNodes);
+      brickID.assign(ids, ids + numIDs);
+
+      leaf.resize(numLeaves);
+      for (size_t i = 0; i < numLeaves; i++) {
+        leaf[i].bounds     = leafBounds[i];
+        leaf[i].brickBegin = begin[i];
+        leaf[i].numBricks  = begin[i + 1] - begin[i];
+      }
     }
 
-    /*! destructor that frees all allocated memory */
-    AMRAccel::~AMRAccel()
+    void AMRAccel::store(const std::string &fileName, uint64 inputHash) const
     {
-      for (auto &l : leaf)
-        delete [] l.brickList;
+      // the bricks of the leaves are stored in the order of the leaves
+      std::vector<box3f> leafBounds;
+      std::vector<uint32> begin;
+      for (const auto &l : leaf) {
+        leafBounds.push_back(l.bounds);
+        begin.push_back(l.brickBegin);
+      }
+      begin.push_back(brickID.size());
 
-      leaf.clear();
-      node.clear();
+      AccelCache::write(fileName, inputHash, {
+        {CACHE_WORLD_BOUNDS, &worldBounds, sizeof(worldBounds)},
+        {CACHE_LEVELS, level.data(), level.size() * sizeof(Level)},
+        {CACHE_NODES, node.data(), node.size() * sizeof(Node)},
+        {CACHE_LEAF_BOUNDS, leafBounds.data(),
+         leafBounds.size() * sizeof(box3f)},
+        {CACHE_LEAF_BRICK_BEGIN, begin.data(), begin.size() * sizeof(uint32)},
+        {CACHE_LEAF_BRICK_IDS, brickID.data(), brickID.size() * sizeof(uint32)}
+      });
     }
 
-    void AMRAccel::makeLeaf(index_t nodeID,
+    void AMRAccel::makeLeaf(const AMRData &input,
+                            Subtree &tree,
+                            index_t nodeID,
                             const box3f &bounds,
                             const std::vector<const AMRData::Brick *> &brick)
     {
-      node[nodeID].dim = 3;
-      node[nodeID].ofs = this->leaf.size(); //item.size();
-      node[nodeID].numItems = brick.size();
+      tree.node[nodeID].dim = 3;
+      tree.node[nodeID].ofs = tree.leaf.size();
+      tree.node[nodeID].numItems = brick.size();
 
       AMRAccel::Leaf newLeaf;
-      newLeaf.bounds = bounds;
-      newLeaf.brickList = new const AMRData::Brick *[brick.size()+1];
+      newLeaf.bounds     = bounds;
+      newLeaf.brickBegin = tree.brickID.size();
+      newLeaf.numBricks  = brick.size();
 
       // create leaf list, and sort it
-      std::copy(brick.begin(),brick.end(),newLeaf.brickList);
-      std::sort(newLeaf.brickList,newLeaf.brickList+brick.size(),
+      std::vector<const AMRData::Brick *> sorted(brick);
+      std::sort(sorted.begin(),sorted.end(),
                 [&](const AMRData::Brick *a, const AMRData::Brick *b){
                   return a->level > b->level;
                 });
 
-      newLeaf.brickList[brick.size()] = nullptr;
-      this->leaf.push_back(newLeaf);
+      for (const auto &b : sorted)
+        tree.brickID.push_back(b - input.brick.data());
+      tree.leaf.push_back(newLeaf);
+    }
+
+    void AMRAccel::makeInner(Subtree &tree,
+                             index_t nodeID,
+                             int dim,
+                             float pos,
+                             int childID)
+    {
+      tree.node[nodeID].dim = dim;
+      tree.node[nodeID].pos = pos;
+      tree.node[nodeID].ofs = childID;
     }
 
-    void AMRAccel::makeInner(index_t nodeID, int dim, float pos, int childID)
+    void AMRAccel::merge(Subtree &tree, index_t nodeID, Subtree &child)
     {
-      node[nodeID].dim = dim;
-      node[nodeID].pos = pos;
-      node[nodeID].ofs = childID;
+      // the root goes to 'nodeID', all other nodes are appended
+      const uint32 nodeBase  = tree.node.size() - 1;
+      const uint32 leafBase  = tree.leaf.size();
+      const uint32 brickBase = tree.brickID.size();
+
+      auto relocate = [&](Node n) {
+        n.ofs += n.isLeaf() ? leafBase : nodeBase;
+        return n;
+      };
+
+      tree.node[nodeID] = relocate(child.node[0]);
+      for (size_t i = 1; i < child.node.size(); i++)
+        tree.node.push_back(relocate(child.node[i]));
+
+      for (auto l : child.leaf) {
+        l.brickBegin += brickBase;
+        tree.leaf.push_back(l);
+      }
+
+      tree.brickID.insert(tree.brickID.end(),
+                          child.brickID.begin(),
+                          child.brickID.end());
+      child = Subtree();
     }
 
-    void AMRAccel::buildRec(int nodeID,
+    void AMRAccel::buildRec(const AMRData &input,
+                            Subtree &tree,
+                            int nodeID,
                             const box3f &bounds,
                             std::vector<const AMRData::Brick *> &brick)
     {
-      std::set<float> possibleSplits[3];
+      // the possible splits are the brick faces inside 'bounds'; per
+      // dimension find the one closest to the center (the lowest of
+      // equally close ones)
+      const vec3f mid = bounds.center();
+      bool canSplit[3] = {false, false, false};
+      vec3f splitPos(std::numeric_limits<float>::infinity());
+
+      auto addSplit = [&](int dim, float split) {
+        const float dist     = fabsf(split - mid[dim]);
+        const float bestDist = fabsf(splitPos[dim] - mid[dim]);
+        if (!canSplit[dim] || dist < bestDist
+            || (dist == bestDist && split < splitPos[dim]))
+          splitPos[dim] = split;
+        canSplit[dim] = true;
+      };
+
       for (const auto &b : brick) {
         const box3f clipped = intersectionOf(bounds, b->worldBounds);
         assert(clipped.lower.x != clipped.upper.x);
         assert(clipped.lower.y != clipped.upper.y);
         assert(clipped.lower.z != clipped.upper.z);
-        if (clipped.lower.x != bounds.lower.x)
-          possibleSplits[0].insert(clipped.lower.x);
-        if (clipped.upper.x != bounds.upper.x)
-          possibleSplits[0].insert(clipped.upper.x);
-        if (clipped.lower.y != bounds.lower.y)
-          possibleSplits[1].insert(clipped.lower.y);
-        if (clipped.upper.y != bounds.upper.y)
-          possibleSplits[1].insert(clipped.upper.y);
-        if (clipped.lower.z != bounds.lower.z)
-          possibleSplits[2].insert(clipped.lower.z);
-        if (clipped.upper.z != bounds.upper.z)
-          possibleSplits[2].insert(clipped.upper.z);
+        for (int dim = 0; dim < 3; dim++) {
+          if (clipped.lower[dim] != bounds.lower[dim])
+            addSplit(dim, clipped.lower[dim]);
+          if (clipped.upper[dim] != bounds.upper[dim])
+            addSplit(dim, clipped.upper[dim]);
+        }
       }
 
       int bestDim = -1;
       vec3f width = bounds.size();
       for (int dim=0;dim<3;dim++) {
-        if (possibleSplits[dim].empty()) continue;
+        if (!canSplit[dim]) continue;
         if (bestDim == -1 || (width[dim] > width[bestDim]))
           bestDim = dim;
       }
@@ -122,14 +260,9 @@ namespace ospray {
         // we're looking for (all on a lower level must be earlier in
         // the list)
 
-        makeLeaf(nodeID,bounds,brick);
+        makeLeaf(input,tree,nodeID,bounds,brick);
       } else {
-        float bestPos = std::numeric_limits<float>::infinity();
-        float mid = bounds.center()[bestDim];
-        for (const auto &split : possibleSplits[bestDim]) {
-          if (fabsf(split - mid) < fabsf(bestPos-mid))
-            bestPos = split;
-        }
+        const float bestPos = splitPos[bestDim];
         box3f lBounds = bounds;
         box3f rBounds = bounds;
 
@@ -149,13 +282,10 @@ namespace ospray {
         }
 
         std::vector<const AMRData::Brick *> l, r;
-        float sum_lo = 0.f, sum_hi = 0.f;
         for (const auto &b : brick) {
           const box3f wb = intersectionOf(b->worldBounds,bounds);
           if (wb.empty())
             throw std::runtime_error("empty box!?");
-          sum_lo += wb.lower[bestDim];
-          sum_hi += wb.upper[bestDim];
           if (wb.lower[bestDim] >= bestPos) {
             r.push_back(b);
           } else if (wb.upper[bestDim] <= bestPos) {
@@ -179,15 +309,30 @@ namespace ospray {
         }
         assert(!(l.empty() || r.empty()));
 
-        int newNodeID = node.size();
-        makeInner(nodeID,bestDim,bestPos,newNodeID);
+        int newNodeID = tree.node.size();
+        makeInner(tree,nodeID,bestDim,bestPos,newNodeID);
 
-        node.push_back(AMRAccel::Node());
-        node.push_back(AMRAccel::Node());
+        tree.node.resize(newNodeID + 2);
+        const size_t numBricks = brick.size();
         brick.clear();
+        brick.shrink_to_fit();
 
-        buildRec(newNodeID+0,lBounds,l);
-        buildRec(newNodeID+1,rBounds,r);
+        if (numBricks >= parallelThreshold) {
+          // build both halves into subtrees of their own, then merge
+          Subtree child[2];
+          tasking::parallel_for(2, [&](int i) {
+            child[i].node.resize(1);
+            if (i == 0)
+              buildRec(input,child[i],0,lBounds,l);
+            else
+              buildRec(input,child[i],0,rBounds,r);
+          });
+          merge(tree,newNodeID+0,child[0]);
+          merge(tree,newNodeID+1,child[1]);
+        } else {
+          buildRec(input,tree,newNodeID+0,lBounds,l);
+          buildRec(input,tree,newNodeID+1,rBounds,r);
+        }
       }
     }
 
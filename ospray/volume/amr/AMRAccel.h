@@ -17,6 +17,7 @@
 #pragma once
 
 #include "AMRData.h"
+#include "common/AccelCache.h"
 
 namespace ospray {
   namespace amr {
@@ -31,8 +32,13 @@ namespace ospray {
     {
       /*! constructor that constructs the actual accel from the amr data */
       AMRAccel(const AMRData &input);
-      /*! destructor that frees all allocated memory */
-      ~AMRAccel();
+      /*! constructor that restores the accel over the amr data from a
+          cache file written by 'store()'; leaves the accel empty if the
+          cache doesn't hold one */
+      AMRAccel(const AMRData &input, const AccelCache &cache);
+
+      /*! write this accel to a cache file */
+      void store(const std::string &fileName, uint64 inputHash) const;
 
       /*! precomputed values per level, so we can easily compute
           logicla coordinates, find any level's cell width, etc */
@@ -46,16 +52,15 @@ namespace ospray {
 
       /*! each leaf in the tree represents an area in which all cells
         stem from the same input block. note we not only store the
-        finest (leaf) block, but also store pointers to all parent
+        finest (leaf) block, but also store the IDs of all parent
         blocks that overlap this area */
       struct Leaf
       {
-        Leaf() {}
-        Leaf(const Leaf &o) : brickList(o.brickList), bounds(o.bounds) {}
-
-        /*! list of bricks that overlap this leaf; sorted from finest
-          to coarsest level */
-        const AMRData::Brick **brickList;
+        /*! the bricks that overlap this leaf are 'brickID[brickBegin]'
+          to 'brickID[brickBegin+numBricks-1]'; sorted from finest to
+          coarsest level */
+        uint32 brickBegin;
+        uint32 numBricks;
 
         /*! bounding box of this leaf - note that the bricks will
           likely "stick out" of this bounding box, and the same
@@ -99,16 +104,38 @@ namespace ospray {
       std::vector<Node> node;
       //! list of leaf nodes
       std::vector<Leaf> leaf;
+      //! the (input) brick IDs of all leaves
+      std::vector<uint32> brickID;
       //! world bounds of domain
       box3f worldBounds;
 
     private:
-      void makeLeaf(index_t nodeID,
-                    const box3f &bounds,
-                    const std::vector<const AMRData::Brick *> &brickIDs);
-      void makeInner(index_t nodeID, int dim, float pos, int childID);
-      void buildRec(int nodeID,const box3f &bounds,
-                    std::vector<const AMRData::Brick *> &brick);
+      /*! the nodes, leaves and brick IDs of a subtree, with its root at
+          node[0]; subtrees are built in parallel, then merged */
+      struct Subtree
+      {
+        std::vector<Node>   node;
+        std::vector<Leaf>   leaf;
+        std::vector<uint32> brickID;
+      };
+
+      static void makeLeaf(const AMRData &input,
+                           Subtree &tree,
+                           index_t nodeID,
+                           const box3f &bounds,
+                           const std::vector<const AMRData::Brick *> &brick);
+      static void makeInner(Subtree &tree,
+                            index_t nodeID,
+                            int dim,
+                            float pos,
+                            int childID);
+      /*! move 'child' into 'tree', its root into node 'nodeID' */
+      static void merge(Subtree &tree, index_t nodeID, Subtree &child);
+      static void buildRec(const AMRData &input,
+                           Subtree &tree,
+                           int nodeID,
+                           const box3f &bounds,
+                           std::vector<const AMRData::Brick *> &brick);
 
     };
 
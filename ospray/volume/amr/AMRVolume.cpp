@@ -87,7 +87,25 @@ namespace ospray {
       assert(brickDataData->data);
 
       data  = make_unique<amr::AMRData>(*brickInfoData,*brickDataData);
-      accel = make_unique<amr::AMRAccel>(*data);
+      // the kd-tree only depends on the brick layout, not on the values
+      const std::string accelCacheFile = getParamString("accelCacheFile", "");
+      if (!accelCacheFile.empty()) {
+        const uint64 inputHash =
+            AccelCache::hash(brickInfoData->data, brickInfoData->numBytes);
+        AccelCache cache;
+        if (cache.map(accelCacheFile, inputHash))
+          accel = make_unique<amr::AMRAccel>(*data, cache);
+        if (!accel || accel->node.empty()) {
+          accel = make_unique<amr::AMRAccel>(*data);
+          try {
+            accel->store(accelCacheFile, inputHash);
+          } catch (const std::runtime_error &e) {
+            postStatusMsg(1) << "WARNING: " << e.what();
+          }
+        }
+      } else {
+        accel = make_unique<amr::AMRAccel>(*data);
+      }
 
       // finding coarset cell size + finest level cell width
       float coarsestCellWidth = 0.f;
@@ -143,6 +161,8 @@ namespace ospray {
                              &accel->node[0],
                              accel->leaf.size(),
                              &accel->leaf[0],
+                             data->brick.data(),
+                             accel->brickID.data(),
                              accel->level.size(),
                              &accel->level[0],
                              voxelTypeID,
@@ -151,6 +171,15 @@ namespace ospray {
       tasking::parallel_for(accel->leaf.size(),[&](size_t leafID) {
         ispc::AMRVolume_computeValueRangeOfLeaf(getIE(), leafID);
       });
+
+      // the brick values are counted at the data
+      const size_t accelBytes = accel->level.size() * sizeof(amr::AMRAccel::Level)
+        + accel->node.size() * sizeof(amr::AMRAccel::Node)
+        + accel->leaf.size() * sizeof(amr::AMRAccel::Leaf)
+        + accel->brickID.size() * sizeof(uint32);
+      setMemoryUsage(OSP_MEMORY_VOLUME,
+                     accelBytes + data->brick.size() * sizeof(amr::AMRData::Brick),
+                     accelBytes);
     }
 
   OSPDataType AMRVolume::getVoxelType()
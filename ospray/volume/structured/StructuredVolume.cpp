@@ -19,11 +19,17 @@
 #include "StructuredVolume.h"
 #include "GridAccelerator_ispc.h"
 #include "StructuredVolume_ispc.h"
+#include "ospcommon/utility/Profiler.h"
 
 namespace ospray {
 
+  constexpr int StructuredVolume::maxMipLevels;
+  constexpr int StructuredVolume::gridBrickWidth;
+
   StructuredVolume::~StructuredVolume()
   {
+    if (visibilityTF)
+      visibilityTF->unregisterListener(this);
     if (ispcEquivalent)
       ispc::StructuredVolume_destroy(ispcEquivalent);
   }
@@ -57,11 +63,36 @@ namespace ospray {
     ispc::StructuredVolume_setGridSpacing(ispcEquivalent,
                                          (const ispc::vec3f&)this->gridSpacing);
 
+    // Listen to the transfer function, whose visibility can then be updated
+    // without rebuilding the accelerator.
+    auto *transferFunction =
+        (TransferFunction *)getParamObject("transferFunction", nullptr);
+    const bool transferFunctionChanged = transferFunction != visibilityTF.ptr;
+    if (transferFunctionChanged) {
+      if (visibilityTF)
+        visibilityTF->unregisterListener(this);
+      visibilityTF = transferFunction;
+      if (visibilityTF)
+        visibilityTF->registerListener(this);
+    }
+
     // Complete volume initialization (only on first commit).
     if (!finished) {
       finish();
       finished = true;
+    } else {
+      // Update the accelerator for regions set since the last commit.
+      if (!dirtyRegion.empty())
+        updateDirtyRegion();
+      if (transferFunctionChanged)
+        updateVisibility();
     }
+
+    // The level of the mip pyramid sampled can be changed with every commit.
+    if (!mipData.empty())
+      ispc::StructuredVolume_setMipLevel(ispcEquivalent, getParam1i("mipLevel", 0));
+
+    updateMemoryUsage();
   }
 
   bool StructuredVolume::scaleRegion(const void *source, void *&out,
@@ -87,7 +118,7 @@ namespace ospray {
         upsampleRegion((const unsigned short *)source, (unsigned short *)out,
                        regionSize, scaledRegionSize);
       }
-      else if (voxelType == "ushort") {
+      else if (voxelType == "ushort" || voxelType == "half") {
         out = malloc(sizeof(unsigned short) * size_t(scaledRegionSize.x) *
             size_t(scaledRegionSize.y) * size_t(scaledRegionSize.z));
         upsampleRegion((const unsigned short *)source, (unsigned short *)out,
@@ -113,6 +144,8 @@ namespace ospray {
 
   void StructuredVolume::buildAccelerator()
   {
+    OSPRAY_PROFILE_ZONE("volume accelerator build");
+
     // Create instance of volume accelerator.
     void *accel = ispc::StructuredVolume_createAccelerator(ispcEquivalent);
 
@@ -126,6 +159,138 @@ namespace ospray {
     tasking::parallel_for(NTASKS, [&](int taskIndex){
       ispc::GridAccelerator_buildAccelerator(ispcEquivalent, taskIndex);
     });
+
+    updateVisibility();
+  }
+
+  void StructuredVolume::updateVisibility()
+  {
+    void *accel = ispc::StructuredVolume_getAccelerator(ispcEquivalent);
+    if (!accel || !visibilityTF)
+      return;
+
+    const int numBricks = ispc::GridAccelerator_getBrickCount_x(accel)
+                          * ispc::GridAccelerator_getBrickCount_y(accel)
+                          * ispc::GridAccelerator_getBrickCount_z(accel);
+    tasking::parallel_for(numBricks, [&](int brickIndex) {
+      ispc::GridAccelerator_updateVisibility(ispcEquivalent, brickIndex);
+    });
+    ispc::GridAccelerator_setVisibilityTF(ispcEquivalent);
+  }
+
+  void StructuredVolume::updateMemoryUsage()
+  {
+    void *accel = ispc::StructuredVolume_getAccelerator(ispcEquivalent);
+    const size_t accelBytes = accel ? ispc::GridAccelerator_getMemory(accel) : 0;
+
+    size_t bytes = getVoxelMemory() + accelBytes
+                   + gradients.size() * sizeof(uint32);
+    for (const auto &level : mipData)
+      bytes += level.size() * sizeof(float);
+
+    setMemoryUsage(OSP_MEMORY_VOLUME, bytes, accelBytes);
+  }
+
+  void StructuredVolume::markDirty(const vec3i &lower, const vec3i &upper)
+  {
+    const box3i region(max(lower, vec3i(0)), min(upper, dimensions) - 1);
+    if (finished && !region.empty())
+      dirtyRegion.extend(region);
+  }
+
+  void StructuredVolume::updateDirtyRegion()
+  {
+    const box3i region = dirtyRegion;
+    dirtyRegion = box3i(empty);
+    if (region.empty())
+      return;
+
+    void *accel = ispc::StructuredVolume_getAccelerator(ispcEquivalent);
+    if (accel) {
+      const vec3i brickCount(ispc::GridAccelerator_getBrickCount_x(accel),
+                             ispc::GridAccelerator_getBrickCount_y(accel),
+                             ispc::GridAccelerator_getBrickCount_z(accel));
+
+      // Rebuild (in parallel) only the bricks containing changed voxels.
+      const vec3i lower = region.lower / gridBrickWidth;
+      const vec3i numBricks = region.upper / gridBrickWidth + 1 - lower;
+      // One task per row of bricks, which are adjacent in memory.
+      tasking::parallel_for(numBricks, vec3i(numBricks.x, 1, 1),
+                            [&](const box3i &block) {
+        const vec3i brick = lower + block.lower;
+        const int row = brickCount.x * (brick.y + brickCount.y * brick.z);
+        for (int x = brick.x; x < lower.x + block.upper.x; x++) {
+          const int address = row + x;
+          ispc::GridAccelerator_buildAccelerator(ispcEquivalent, address);
+          if (visibilityTF)
+            ispc::GridAccelerator_updateVisibility(ispcEquivalent, address);
+        }
+      });
+    }
+
+    // The slices of gradients depending on changed voxels.
+    if (!gradients.empty()) {
+      const int lower = std::max(region.lower.z - 1, 0);
+      const int upper = std::min(region.upper.z + 1, dimensions.z - 1);
+      tasking::parallel_for(upper - lower + 1, [&](int i) {
+        ispc::StructuredVolume_buildGradients(ispcEquivalent, lower + i);
+      });
+    }
+
+    // The slices of the mip levels averaging changed voxels.
+    for (int level = 1; level <= int(mipData.size()); level++) {
+      tasking::parallel_for((region.upper.z >> level) - (region.lower.z >> level)
+                            + 1, [&](int i) {
+        ispc::StructuredVolume_buildMipLevel(ispcEquivalent, level,
+                                             (region.lower.z >> level) + i);
+      });
+    }
+  }
+
+  void StructuredVolume::dependencyGotChanged(ManagedObject *object)
+  {
+    if (object == visibilityTF.ptr && finished)
+      updateVisibility();
+  }
+
+  void StructuredVolume::buildMipPyramid()
+  {
+    const int numLevels = std::min(getParam1i("mipLevels", 0), maxMipLevels);
+    vec3i levelDims = dimensions;
+
+    for (int level = 1; level <= numLevels && reduce_max(levelDims) > 1; level++) {
+      levelDims = (levelDims + 1) / 2;
+      mipData.emplace_back(size_t(levelDims.x) * levelDims.y * levelDims.z);
+      ispc::StructuredVolume_setMipData(ispcEquivalent, level,
+                                        mipData.back().data(),
+                                        (const ispc::vec3i&)levelDims);
+      tasking::parallel_for(levelDims.z, [&](int z) {
+        ispc::StructuredVolume_buildMipLevel(ispcEquivalent, level, z);
+      });
+    }
+  }
+
+  void StructuredVolume::buildGradients()
+  {
+    if (!getParam1i("precomputedGradients", 0))
+      return;
+
+    // An upper bound of the magnitude of the (one-sided at the borders)
+    // differences, used to quantize the magnitudes; the range of the voxels
+    // is known from the accelerator if it was not given.
+    vec2f range = voxelRange;
+    void *accel = ispc::StructuredVolume_getAccelerator(ispcEquivalent);
+    if (range.x > range.y && accel)
+      ispc::GridAccelerator_getValueRange(accel, (ispc::vec2f&)range);
+    const float maxGradientMagnitude = range.x <= range.y ?
+        length(vec3f(range.y - range.x) / gridSpacing) : 0.f;
+
+    gradients.resize(size_t(dimensions.x) * dimensions.y * dimensions.z);
+    ispc::StructuredVolume_setGradients(ispcEquivalent, gradients.data(),
+                                        maxGradientMagnitude);
+    tasking::parallel_for(dimensions.z, [&](int z) {
+      ispc::StructuredVolume_buildGradients(ispcEquivalent, z);
+    });
   }
 
   void StructuredVolume::finish()
@@ -137,6 +302,8 @@ namespace ospray {
       voxelRange = getParam2f("voxelRange", voxelRange);
 
     buildAccelerator();
+    buildMipPyramid();
+    buildGradients();
 
     // Volume finish actions.
     Volume::finish();
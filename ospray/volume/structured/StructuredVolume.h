@@ -19,6 +19,7 @@
 // ospray
 #include "ospcommon/tasking/parallel_for.h"
 #include "../Volume.h"
+#include "transferFunction/TransferFunction.h"
 
 namespace ospray {
 
@@ -79,6 +80,34 @@ namespace ospray {
     //! building..
     virtual void buildAccelerator();
 
+    //! Build the "mipLevels" coarser levels of the mip pyramid.
+    virtual void buildMipPyramid();
+
+    //! Precompute the (quantized) gradients if "precomputedGradients" is set.
+    virtual void buildGradients();
+
+    //! Update the accelerator's visibility bits for the transfer function.
+    void updateVisibility();
+
+    //! Memory of the voxels stored by the volume itself (not shared from a
+    //!  data array), in bytes.
+    virtual size_t getVoxelMemory() const { return 0; }
+
+    //! Report the memory of the voxels, accelerator, mip pyramid and
+    //!  gradients (see ospGetMemoryUsage).
+    void updateMemoryUsage();
+
+    //! Mark the voxels in [lower, upper) as changed after the first commit,
+    //!  the accelerator bricks (and mip levels) covering them are updated
+    //!  with the next commit.
+    virtual void markDirty(const vec3i &lower, const vec3i &upper);
+
+    //! Update the accelerator (and mip pyramid) for the dirty region.
+    void updateDirtyRegion();
+
+    //! Update the visibility bits whenever the transfer function changes.
+    void dependencyGotChanged(ManagedObject *object) override;
+
     //! Get the OSPDataType enum corresponding to the voxel type string.
     OSPDataType getVoxelType();
 
@@ -105,6 +134,23 @@ namespace ospray {
         'ospSetRegion' on the volume as the scaling is applied in that function.
      */
     vec3f scaleFactor;
+
+    //! The coarser levels of the mip pyramid, each averaging 2x2x2 voxels
+    //!  of the previous level (STRUCTURED_VOLUME_MAX_MIP_LEVELS in ISPC).
+    static constexpr int maxMipLevels = 7;
+    std::vector<std::vector<float>> mipData;
+
+    //! The optional precomputed gradients, 4 bytes per voxel.
+    std::vector<uint32> gradients;
+
+    //! The transfer function listened to for visibility updates.
+    Ref<TransferFunction> visibilityTF;
+
+    //! Width of a brick of the GridAccelerator in voxels.
+    static constexpr int gridBrickWidth = 256;
+
+    //! The voxels changed since the last commit.
+    box3i dirtyRegion {empty};
   };
 
 // Inlined member functions ///////////////////////////////////////////////////
@@ -17,11 +17,14 @@
 // ospray
 #include "BlockBrickedVolume.h"
 #include "BlockBrickedVolume_ispc.h"
+#include "api/ISPCDevice.h"
 // ospcommon
 #include "ospcommon/tasking/parallel_for.h"
 
 namespace ospray {
 
+  constexpr int BlockBrickedVolume::blockWidth;
+
   BlockBrickedVolume::~BlockBrickedVolume()
   {
     if (ispcEquivalent)
@@ -47,6 +50,16 @@ namespace ospray {
 
     // StructuredVolume commit actions.
     StructuredVolume::commit();
+
+    if (compressed) {
+      const size_t voxelSize = sizeOf(getVoxelType());
+      const size_t rawBytes = size_t(blockCount.product()) * blockWidth
+                              * blockWidth * blockWidth * voxelSize;
+      const size_t bytes = ispc::BlockBrickedVolume_getVoxelMemory(ispcEquivalent);
+      postStatusMsg(1) << "#osp: compressed_block_bricked_volume uses "
+                       << (bytes >> 20) << " MB for the voxels ("
+                       << (100.f * bytes / rawBytes) << "% of uncompressed)";
+    }
   }
 
   int BlockBrickedVolume::setRegion(
@@ -78,6 +91,34 @@ namespace ospray {
     void *finalSource = const_cast<void*>(source);
     const bool upsampling = scaleRegion(source, finalSource,
                                         finalRegionSize, finalRegionCoords);
+
+    markDirty(finalRegionCoords, finalRegionCoords + finalRegionSize);
+
+    // The blocks overlapped by the region (within the volume), which need
+    // to be raw while written to if the volume is compressed.
+    const vec3i lower = max(finalRegionCoords, vec3i(0));
+    const vec3i upper = min(finalRegionCoords + finalRegionSize, dimensions);
+    const bool emptyRegion = lower.x >= upper.x || lower.y >= upper.y
+                             || lower.z >= upper.z;
+    const vec3i blockLower = lower / blockWidth;
+    const vec3i numBlocks = emptyRegion ? vec3i(0)
+                            : (upper - 1) / blockWidth + 1 - blockLower;
+    auto blockIndex = [&](size_t i) {
+      return blockLower + vec3i(i % numBlocks.x,
+                                (i / numBlocks.x) % numBlocks.y,
+                                i / (size_t(numBlocks.x) * numBlocks.y));
+    };
+    auto blockID = [&](const vec3i &b) {
+      return uint32_t(b.x + blockCount.x * (b.y + blockCount.y * b.z));
+    };
+
+    if (compressed) {
+      tasking::parallel_for(size_t(numBlocks.product()), [&](size_t i) {
+        ispc::BlockBrickedVolume_prepareBlock(ispcEquivalent,
+                                              blockID(blockIndex(i)));
+      });
+    }
+
     // Copy voxel data into the volume.
     const size_t NTASKS = finalRegionSize.y * finalRegionSize.z;
     tasking::parallel_for(NTASKS, [&](size_t taskIndex) {
@@ -88,6 +129,22 @@ namespace ospray {
                                          taskIndex);
     });
 
+    // Compress the blocks once all of their voxels are written.
+    if (compressed) {
+      tasking::parallel_for(size_t(numBlocks.product()), [&](size_t i) {
+        const vec3i b = blockIndex(i);
+        const vec3i blockLo = b * blockWidth;
+        const vec3i blockHi = min(blockLo + blockWidth, dimensions);
+        const vec3i overlap = min(blockHi, upper) - max(blockLo, lower);
+        const uint32_t id = blockID(b);
+        blockVoxelsWritten[id] += overlap.product();
+        if (blockVoxelsWritten[id] >= uint32_t((blockHi - blockLo).product())) {
+          ispc::BlockBrickedVolume_compressBlock(ispcEquivalent, id,
+                                                 compressionTolerance);
+        }
+      });
+    }
+
     // If we're upsampling finalSource points at the chunk of data allocated by
     // scaleRegion to hold the upsampled volume data and we must free it.
     if (upsampling) {
@@ -97,6 +154,12 @@ namespace ospray {
     return true;
   }
 
+  size_t BlockBrickedVolume::getVoxelMemory() const
+  {
+    return ispcEquivalent ?
+      ispc::BlockBrickedVolume_getVoxelMemory(ispcEquivalent) : 0;
+  }
+
   void BlockBrickedVolume::createEquivalentISPC()
   {
     // Get the voxel type.
@@ -113,13 +176,47 @@ namespace ospray {
                                "calling ospSetRegion())");
     }
 
+    // fall back to compressed blocks if the voxels exceed the memory budget
+    const int64_t voxelBytes = int64_t(dimensions.x) * dimensions.y
+                               * dimensions.z * sizeOf(getVoxelType());
+    if (!compressed
+        && !withinMemoryBudget(api::ISPCDevice::embreeMemoryUsed, voxelBytes)) {
+      postStatusMsg(1) << "#osp: voxels of " << toString() << " exceed the "
+                       << "memoryBudget, storing them compressed";
+      compressed = true;
+    }
+
+    compressionTolerance = std::max(0.f, getParam1f("compressionTolerance", 0.f));
+    const float background = compressed ? getParam1f("background", 0.f) : 0.f;
+    blockCount = (this->dimensions + blockWidth - 1) / blockWidth;
+    if (compressed)
+      blockVoxelsWritten.assign(blockCount.product(), 0);
+
     // Create an ISPC BlockBrickedVolume object and assign type-specific
     // function pointers.
     ispcEquivalent = ispc::BlockBrickedVolume_createInstance(this,
                                          (int)getVoxelType(),
-                                         (const ispc::vec3i &)this->dimensions);
+                                         (const ispc::vec3i &)this->dimensions,
+                                         compressed,
+                                         background);
+  }
+
+  CompressedBlockBrickedVolume::CompressedBlockBrickedVolume()
+  {
+    compressed = true;
   }
 
+  std::string CompressedBlockBrickedVolume::toString() const
+  {
+    return("ospray::CompressedBlockBrickedVolume<" + voxelType + ">");
+  }
+
+  // The compressed variant does not depend on the (default) ghost cell layout.
+  OSP_REGISTER_VOLUME(CompressedBlockBrickedVolume,
+                      compressed_block_bricked_volume);
+  // Only the written blocks are allocated, thus also a sparse volume.
+  OSP_REGISTER_VOLUME(CompressedBlockBrickedVolume, sparse_volume);
+
 #ifdef EXP_NEW_BB_VOLUME_KERNELS
   /*! in new bb kernel mode we'll be using the code in
       GhostBlockBrickedVolume.* */
@@ -40,11 +40,37 @@ namespace ospray {
                           const vec3i &index,
                           const vec3i &count) override;
 
-  private:
+  protected:
 
     //! Create the equivalent ISPC volume container.
     void createEquivalentISPC() override;
 
+    //! The (possibly compressed) voxels are stored by the ISPC container.
+    size_t getVoxelMemory() const override;
+
+    //! Width of a block in voxels (BLOCK_VOXEL_WIDTH in the ISPC code).
+    static constexpr int blockWidth = 64;
+
+    //! Compressed volumes store each block separately, encoded with a
+    //!  maximum error of 'compressionTolerance' once all its voxels were
+    //!  written.
+    bool compressed {false};
+    float compressionTolerance {0.f};
+    vec3i blockCount {0};
+    std::vector<uint32_t> blockVoxelsWritten;
+
+  };
+
+  //! \brief A BlockBrickedVolume with compressed blocks, see
+  //!  BlockBrickedVolume::compressed.
+  //!
+  struct OSPRAY_SDK_INTERFACE CompressedBlockBrickedVolume
+    : public BlockBrickedVolume
+  {
+    CompressedBlockBrickedVolume();
+
+    //! A string description of this class.
+    virtual std::string toString() const override;
   };
 
 } // ::ospray
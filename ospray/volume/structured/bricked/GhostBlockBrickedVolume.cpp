@@ -77,6 +77,9 @@ namespace ospray {
     void *finalSource = const_cast<void*>(source);
     const bool upsampling = scaleRegion(source, finalSource,
                                         finalRegionSize, finalRegionCoords);
+
+    markDirty(finalRegionCoords, finalRegionCoords + finalRegionSize);
+
     // Copy voxel data into the volume.
     const int NTASKS = finalRegionSize.y * finalRegionSize.z;
     tasking::parallel_for(NTASKS, [&](int taskIndex){
@@ -0,0 +1,385 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// ospray
+#include "PagedBlockBrickedVolume.h"
+#include "BlockBrickedVolume_ispc.h"
+#include "GridAccelerator_ispc.h"
+#include "StructuredVolume_ispc.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+#include "ospcommon/tasking/schedule.h"
+// std
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace ospray {
+
+  namespace {
+
+    //! A stored half precision voxel, converted to float on read.
+    struct Half
+    {
+      uint16_t bits;
+
+      operator float() const
+      {
+        const uint32_t sign = uint32_t(bits & 0x8000) << 16;
+        const uint32_t exponent = (bits >> 10) & 0x1f;
+        const uint32_t mantissa = bits & 0x3ff;
+        uint32_t result;
+        if (exponent == 0x1f)
+          result = sign | 0x7f800000 | (mantissa << 13);
+        else if (exponent != 0)
+          result = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        else if (mantissa == 0)
+          result = sign;
+        else {
+          // denormal, renormalize as a float
+          float value = mantissa * (1.f / (1 << 24));
+          return sign ? -value : value;
+        }
+        float value;
+        std::memcpy(&value, &result, sizeof(value));
+        return value;
+      }
+    };
+
+    template <typename T>
+    vec2f computeRange(const std::vector<uint8_t> &voxels, float &mean)
+    {
+      const T *values = (const T *)voxels.data();
+      const size_t count = voxels.size() / sizeof(T);
+      vec2f range(FLT_MAX, -FLT_MAX);
+      double sum = 0.0;
+      size_t valid = 0;
+      for (size_t i = 0; i < count; i++) {
+        const float value = values[i];
+        if (std::isnan(value))
+          continue;
+        range.x = std::min(range.x, value);
+        range.y = std::max(range.y, value);
+        sum += value;
+        valid++;
+      }
+      mean = valid ? float(sum / valid) : 0.f;
+      return range;
+    }
+
+    vec2f computeRange(OSPDataType type,
+                       const std::vector<uint8_t> &voxels,
+                       float &mean)
+    {
+      switch (type) {
+      case OSP_UCHAR:  return computeRange<uint8_t>(voxels, mean);
+      case OSP_SHORT:  return computeRange<int16_t>(voxels, mean);
+      case OSP_USHORT: return computeRange<uint16_t>(voxels, mean);
+      case OSP_HALF:   return computeRange<Half>(voxels, mean);
+      case OSP_FLOAT:  return computeRange<float>(voxels, mean);
+      default:         return computeRange<double>(voxels, mean);
+      }
+    }
+
+  } // ::ospray::{anonymous}
+
+  extern "C" void ospray_PagedBlockBrickedVolume_requestBlock(void *cppVolume,
+                                                              uint32 blockID)
+  {
+    auto *volume = static_cast<PagedBlockBrickedVolume *>(
+        (BlockBrickedVolume *)cppVolume);
+    volume->requestBlock(blockID);
+  }
+
+  PagedBlockBrickedVolume::~PagedBlockBrickedVolume()
+  {
+    // the background loads access this volume
+    while (runningLoads > 0)
+      std::this_thread::yield();
+  }
+
+  std::string PagedBlockBrickedVolume::toString() const
+  {
+    return("ospray::PagedBlockBrickedVolume<" + voxelType + ">");
+  }
+
+  void PagedBlockBrickedVolume::commit()
+  {
+    if (ispcEquivalent == nullptr) {
+      fileName = getParamString("filename", "");
+      if (!std::ifstream(fileName, std::ios::binary)) {
+        throw std::runtime_error("paged_block_bricked_volume: cannot open "
+                                 "'filename' (" + fileName + ")");
+      }
+      maxMemory = size_t(std::max(1, getParam1i("maxMemory", 1024))) << 20;
+
+      createEquivalentISPC();
+
+      const size_t numBlocks = blockCount.product();
+      blockMean.assign(numBlocks, 0.f);
+      blockBytes.assign(numBlocks, 0);
+      blockRange.assign(numBlocks, vec2f(FLT_MAX, -FLT_MAX));
+      requested.reset(new std::atomic<bool>[numBlocks]);
+      for (size_t i = 0; i < numBlocks; i++)
+        requested[i] = false;
+    }
+
+    // skip BlockBrickedVolume::commit(), which expects ospSetRegion() data
+    StructuredVolume::commit();
+  }
+
+  int PagedBlockBrickedVolume::setRegion(const void *,
+                                         const vec3i &,
+                                         const vec3i &)
+  {
+    static WarnOnce warning("paged_block_bricked_volume reads its voxels from "
+                            "'filename', ignoring ospSetRegion()");
+    return false;
+  }
+
+  void PagedBlockBrickedVolume::buildAccelerator()
+  {
+    void *accel = ispc::StructuredVolume_createAccelerator(ispcEquivalent);
+
+    vec3i brickCount;
+    brickCount.x = ispc::GridAccelerator_getBrickCount_x(accel);
+    brickCount.y = ispc::GridAccelerator_getBrickCount_y(accel);
+    brickCount.z = ispc::GridAccelerator_getBrickCount_z(accel);
+
+    // Page in the blocks of as many accelerator bricks at a time as fit
+    // into the memory budget, fill in their cells, and evict them again.
+    constexpr int blocksPerBrick = gridBrickWidth / blockWidth;
+    const size_t voxelSize = sizeOf(getVoxelType());
+    const size_t brickBytes = size_t(blocksPerBrick * blocksPerBrick
+                                     * blocksPerBrick) * blockWidth
+                              * blockWidth * blockWidth * voxelSize;
+    const size_t numBricks = brickCount.product();
+    const size_t batchSize = std::max<size_t>(1, maxMemory / brickBytes);
+
+    for (size_t first = 0; first < numBricks; first += batchSize) {
+      const size_t last = std::min(numBricks, first + batchSize);
+
+      std::vector<uint32_t> ids;
+      for (size_t i = first; i < last; i++) {
+        const vec3i brick(i % brickCount.x,
+                          (i / brickCount.x) % brickCount.y,
+                          i / (size_t(brickCount.x) * brickCount.y));
+        const vec3i lo = brick * blocksPerBrick;
+        const vec3i hi = min(lo + blocksPerBrick, blockCount);
+        for (int z = lo.z; z < hi.z; z++)
+          for (int y = lo.y; y < hi.y; y++)
+            for (int x = lo.x; x < hi.x; x++)
+              ids.push_back(x + blockCount.x * (y + blockCount.y * z));
+      }
+
+      // the most recently built batch remains resident
+      ispc::BlockBrickedVolume_setFrame(ispcEquivalent, ++frame);
+
+      tasking::parallel_for(ids.size(), [&](size_t i) {
+        std::vector<uint8_t> voxels;
+        readBlock(ids[i], voxels);
+        storeBlock(ids[i], voxels);
+      });
+
+      tasking::parallel_for(last - first, [&](size_t i) {
+        ispc::GridAccelerator_buildAccelerator(ispcEquivalent, first + i);
+      });
+
+      evict(maxMemory);
+    }
+
+    vec2f range(FLT_MAX, -FLT_MAX);
+    for (const auto &r : blockRange)
+      range = vec2f(std::min(range.x, r.x), std::max(range.y, r.y));
+    if (voxelRange.x > voxelRange.y) {
+      voxelRange = range;
+      setParam("voxelRange", voxelRange);
+    }
+
+    updateVisibility();
+
+    postStatusMsg(1) << "#osp: paged_block_bricked_volume keeps "
+                     << (residentBytes >> 20) << " MB of voxels resident";
+  }
+
+  void PagedBlockBrickedVolume::buildMipPyramid()
+  {
+    if (getParam1i("mipLevels", 0) > 0) {
+      static WarnOnce warning("paged_block_bricked_volume does not support "
+                              "'mipLevels', ignoring it");
+    }
+  }
+
+  void PagedBlockBrickedVolume::buildGradients()
+  {
+    if (getParam1i("precomputedGradients", 0)) {
+      static WarnOnce warning("paged_block_bricked_volume does not support "
+                              "'precomputedGradients', ignoring it");
+    }
+  }
+
+  void PagedBlockBrickedVolume::markDirty(const vec3i &, const vec3i &)
+  {
+    // the voxels of paged blocks never change
+  }
+
+  void PagedBlockBrickedVolume::beginFrame()
+  {
+    // Frames starting meanwhile wait for the blocks to be published.
+    std::lock_guard<std::mutex> frameLock(frameMutex);
+    std::vector<LoadedBlock> blocks;
+    if (++framesInFlight == 1) {
+      std::lock_guard<std::mutex> lock(mutex);
+      blocks.swap(loaded);
+      pendingLoads -= blocks.size();
+    }
+
+    // No other frame renders this volume now (frames into other frame
+    // buffers may be in flight), so the loaded blocks can be published.
+    if (!blocks.empty()) {
+      const size_t bytesPerBlock = size_t(blockWidth) * blockWidth
+                                   * blockWidth * sizeOf(getVoxelType());
+      evict(maxMemory - std::min(maxMemory, blocks.size() * bytesPerBlock));
+      tasking::parallel_for(blocks.size(), [&](size_t i) {
+        storeBlock(blocks[i].id, blocks[i].voxels);
+        requested[blocks[i].id] = false;
+      });
+    }
+
+    ispc::BlockBrickedVolume_setFrame(ispcEquivalent, ++frame);
+
+    // Load the blocks requested while rendering in the background, with
+    // at most a quarter of the memory budget in flight.
+    const size_t maxPending = std::max<size_t>(1,
+        maxMemory / (4 * size_t(blockWidth) * blockWidth * blockWidth
+                     * sizeOf(getVoxelType())));
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!requests.empty() && pendingLoads < maxPending) {
+      const uint32_t id = requests.front();
+      requests.pop_front();
+      pendingLoads++;
+      runningLoads++;
+      tasking::schedule([=]() {
+        LoadedBlock block;
+        block.id = id;
+        readBlock(id, block.voxels);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          loaded.push_back(std::move(block));
+        }
+        runningLoads--;
+      });
+    }
+  }
+
+  void PagedBlockBrickedVolume::endFrame()
+  {
+    std::lock_guard<std::mutex> frameLock(frameMutex);
+    framesInFlight--;
+  }
+
+  void PagedBlockBrickedVolume::requestBlock(uint32_t blockID)
+  {
+    if (requested[blockID].exchange(true))
+      return;
+    std::lock_guard<std::mutex> lock(mutex);
+    requests.push_back(blockID);
+  }
+
+  vec3i PagedBlockBrickedVolume::blockLower(uint32_t blockID) const
+  {
+    return blockWidth * vec3i(blockID % blockCount.x,
+                              (blockID / blockCount.x) % blockCount.y,
+                              blockID / (blockCount.x * blockCount.y));
+  }
+
+  vec3i PagedBlockBrickedVolume::blockUpper(uint32_t blockID) const
+  {
+    return min(blockLower(blockID) + blockWidth, dimensions);
+  }
+
+  void PagedBlockBrickedVolume::readBlock(uint32_t blockID,
+                                          std::vector<uint8_t> &voxels) const
+  {
+    const vec3i lo = blockLower(blockID);
+    const vec3i size = blockUpper(blockID) - lo;
+    const size_t voxelSize = sizeOf(typeForString(voxelType.c_str()));
+    const size_t rowBytes = size.x * voxelSize;
+    voxels.assign(size.product() * voxelSize, 0);
+
+    std::ifstream file(fileName, std::ios::binary);
+    for (int z = 0; z < size.z; z++) {
+      for (int y = 0; y < size.y; y++) {
+        const size_t offset = ((size_t(lo.z + z) * dimensions.y + lo.y + y)
+                               * dimensions.x + lo.x) * voxelSize;
+        file.seekg(offset);
+        file.read((char *)&voxels[(z * size_t(size.y) + y) * rowBytes],
+                  rowBytes);
+      }
+    }
+
+    if (!file) {
+      postStatusMsg(1) << "#osp: paged_block_bricked_volume: failed to read "
+                       << "block " << blockID << " from " << fileName;
+    }
+  }
+
+  void PagedBlockBrickedVolume::storeBlock(uint32_t blockID,
+                                           const std::vector<uint8_t> &voxels)
+  {
+    blockRange[blockID] = computeRange(getVoxelType(), voxels,
+                                       blockMean[blockID]);
+
+    const vec3i lo = blockLower(blockID);
+    blockVoxelsWritten[blockID] = 0;
+    BlockBrickedVolume::setRegion(voxels.data(), lo, blockUpper(blockID) - lo);
+
+    residentBytes -= blockBytes[blockID];
+    blockBytes[blockID] = ispc::BlockBrickedVolume_getBlockMemory(ispcEquivalent,
+                                                                  blockID);
+    residentBytes += blockBytes[blockID];
+  }
+
+  void PagedBlockBrickedVolume::evict(size_t budget)
+  {
+    if (residentBytes <= budget)
+      return;
+
+    // (frame last used, block) of the blocks using memory
+    std::vector<std::pair<int32, uint32_t>> resident;
+    for (size_t i = 0; i < blockBytes.size(); i++) {
+      if (blockBytes[i] > 0) {
+        resident.emplace_back(
+            ispc::BlockBrickedVolume_getBlockLastUsed(ispcEquivalent, i), i);
+      }
+    }
+    std::sort(resident.begin(), resident.end());
+
+    for (const auto &block : resident) {
+      if (residentBytes <= budget)
+        break;
+      const uint32_t id = block.second;
+      ispc::BlockBrickedVolume_evictBlock(ispcEquivalent, id, blockMean[id]);
+      residentBytes -= blockBytes[id];
+      blockBytes[id] = 0;
+    }
+  }
+
+  // A volume type which pages the blocks of a large volume from a file.
+  OSP_REGISTER_VOLUME(PagedBlockBrickedVolume, paged_block_bricked_volume);
+
+} // ::ospray
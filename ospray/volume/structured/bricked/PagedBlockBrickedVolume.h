@@ -0,0 +1,121 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "BlockBrickedVolume.h"
+// std
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace ospray {
+
+  //! \brief A (compressed) BlockBrickedVolume which keeps only a bounded
+  //!  number of its blocks in memory and pages the others in from a raw
+  //!  file on demand.
+  //!
+  //!  Blocks which are not resident are sampled as their mean value until
+  //!  the block is loaded, which happens in the background between frames.
+  //!
+  struct OSPRAY_SDK_INTERFACE PagedBlockBrickedVolume
+    : public CompressedBlockBrickedVolume
+  {
+    PagedBlockBrickedVolume() = default;
+    virtual ~PagedBlockBrickedVolume() override;
+
+    //! A string description of this class.
+    virtual std::string toString() const override;
+
+    //! Open the voxel file and build the accelerator in one streaming pass.
+    virtual void commit() override;
+
+    //! Not supported, paged volumes read their voxels from 'filename'.
+    virtual int setRegion(const void *source,
+                          const vec3i &index,
+                          const vec3i &count) override;
+
+    //! Publish the blocks loaded meanwhile and issue new requests.
+    virtual void beginFrame() override;
+
+    virtual void endFrame() override;
+
+    //! Called (from the renderer's threads) when a missing block is sampled.
+    void requestBlock(uint32_t blockID);
+
+  protected:
+
+    //! Stream all blocks through memory to compute the accelerator ranges.
+    virtual void buildAccelerator() override;
+
+    //! Not supported, the pyramid would need all voxels resident.
+    virtual void buildMipPyramid() override;
+
+    //! Not supported, precomputed gradients would need all voxels resident.
+    virtual void buildGradients() override;
+
+    //! Paging blocks in does not need accelerator updates.
+    virtual void markDirty(const vec3i &lower, const vec3i &upper) override;
+
+  private:
+
+    struct LoadedBlock
+    {
+      uint32_t id;
+      std::vector<uint8_t> voxels;
+    };
+
+    vec3i blockLower(uint32_t blockID) const;
+    vec3i blockUpper(uint32_t blockID) const;
+
+    //! Read the voxels of a block from the file.
+    void readBlock(uint32_t blockID, std::vector<uint8_t> &voxels) const;
+
+    //! Make a (read) block resident, (re-)compressing it.
+    void storeBlock(uint32_t blockID, const std::vector<uint8_t> &voxels);
+
+    //! Evict the least recently used blocks until at most 'budget' bytes
+    //!  are resident.
+    void evict(size_t budget);
+
+    std::string fileName;
+    size_t maxMemory {0};
+    int32 frame {0};
+
+    //! The mean value of each block (used while it is not resident), the
+    //!  memory currently used by it and its voxel value range.
+    std::vector<float> blockMean;
+    std::vector<size_t> blockBytes;
+    std::vector<vec2f> blockRange;
+    std::atomic<size_t> residentBytes {0};
+
+    //! Paging state: blocks requested, in flight and loaded (but not yet
+    //!  published), guarded by 'mutex'.
+    std::unique_ptr<std::atomic<bool>[]> requested;
+    std::deque<uint32_t> requests;
+    std::vector<LoadedBlock> loaded;
+    size_t pendingLoads {0};
+    std::atomic<int> runningLoads {0};
+    std::mutex mutex;
+
+    //! The frames rendering this volume, the loaded blocks are only
+    //!  published when no other frame samples them, guarded by 'frameMutex'.
+    int framesInFlight {0};
+    std::mutex frameMutex;
+  };
+
+} // ::ospray
@@ -64,6 +64,11 @@ namespace ospray {
                                                    (const ispc::vec3i&)index,
                                                    (const ispc::vec3i&)count);
       break;
+    case OSP_HALF:
+      ispc::SharedStructuredVolume_setRegion_half(getIE(),source,
+                                                 (const ispc::vec3i&)index,
+                                                 (const ispc::vec3i&)count);
+      break;
     case OSP_FLOAT:
       ispc::SharedStructuredVolume_setRegion_float(getIE(),source,
                                                    (const ispc::vec3i&)index,
@@ -79,6 +84,7 @@ namespace ospray {
                                "support for volumes of voxel type '"
                                + voxelType + "'");
     }
+    markDirty(index, index + count);
     return true;
   }
 
@@ -98,6 +104,9 @@ namespace ospray {
     // Get the voxel data.
     voxelData = (Data *)getParamObject("voxelData", nullptr);
 
+    if (voxelData && !voxelData->compact())
+      throw std::runtime_error("the voxel data cannot be strided");
+
     if (voxelData && !(voxelData->flags & OSP_DATA_SHARED_BUFFER)) {
       postStatusMsg(1)
         << "WARNING: The voxel data buffer was not created with"
@@ -126,9 +135,45 @@ namespace ospray {
 
   void SharedStructuredVolume::dependencyGotChanged(ManagedObject *object)
   {
-    // Rebuild volume accelerator when voxelData is committed.
-    if(object == voxelData && ispcEquivalent)
+    StructuredVolume::dependencyGotChanged(object);
+
+    if (object != voxelData || !ispcEquivalent)
+      return;
+
+    // Update only the bricks of the voxels marked modified, rebuild the
+    // whole volume accelerator when the entire voxelData is committed.
+    const size_t begin = voxelData->modifiedBegin;
+    const size_t end = voxelData->modifiedEnd;
+    if (begin == 0 && end >= voxelData->numItems) {
       StructuredVolume::buildAccelerator();
+      return;
+    }
+    if (begin >= end)
+      return;
+
+    // the (xyz storage order) voxels of [begin, end) span whole slices,
+    // unless they are rows within a single slice
+    const size_t sliceSize = size_t(dimensions.x) * dimensions.y;
+    const vec3i first(begin % dimensions.x,
+                      (begin / dimensions.x) % dimensions.y,
+                      begin / sliceSize);
+    const vec3i last((end - 1) % dimensions.x,
+                     ((end - 1) / dimensions.x) % dimensions.y,
+                     (end - 1) / sliceSize);
+
+    vec3i lower(0, 0, first.z);
+    vec3i upper(dimensions.x, dimensions.y, last.z + 1);
+    if (first.z == last.z) {
+      lower.y = first.y;
+      upper.y = last.y + 1;
+      if (first.y == last.y) {
+        lower.x = first.x;
+        upper.x = last.x + 1;
+      }
+    }
+
+    markDirty(lower, upper);
+    updateDirtyRegion();
   }
 
   // A volume type with XYZ storage order. The voxel data is provided by the
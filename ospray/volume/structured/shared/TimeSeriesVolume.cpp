@@ -0,0 +1,185 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+//ospray
+#include "TimeSeriesVolume.h"
+#include "SharedStructuredVolume_ispc.h"
+#include "StructuredVolume_ispc.h"
+#include "GridAccelerator_ispc.h"
+#include "../../../common/Data.h"
+// ospcommon
+#include "ospcommon/tasking/schedule.h"
+// std
+#include <thread>
+
+namespace ospray {
+
+  TimeSeriesVolume::~TimeSeriesVolume()
+  {
+    // the prefetch accesses the back volume
+    waitForPrefetch();
+    if (backIE)
+      ispc::StructuredVolume_destroy(backIE);
+  }
+
+  std::string TimeSeriesVolume::toString() const
+  {
+    return("ospray::TimeSeriesVolume<" + voxelType + ">");
+  }
+
+  void TimeSeriesVolume::commit()
+  {
+    // Create the equivalent ISPC volume containers.
+    if (ispcEquivalent == nullptr) createEquivalentISPC();
+
+    const int step = clamp(int(getParam1f("time", 0.f)), 0,
+                           int(timesteps.size()) - 1);
+    if (finished && step != currentStep)
+      setTimestep(step);
+
+    // StructuredVolume commit actions.
+    StructuredVolume::commit();
+
+    waitForPrefetch();
+    ispc::StructuredVolume_setGridOrigin(backIE,
+                                         (const ispc::vec3f&)gridOrigin);
+    ispc::StructuredVolume_setGridSpacing(backIE,
+                                          (const ispc::vec3f&)gridSpacing);
+
+    // Playback is assumed forward (and looping).
+    prefetch((currentStep + 1) % timesteps.size());
+  }
+
+  void TimeSeriesVolume::createEquivalentISPC()
+  {
+    // Get the voxel type.
+    voxelType = getParamString("voxelType", "unspecified");
+    const OSPDataType ospVoxelType = getVoxelType();
+    if (ospVoxelType == OSP_UNKNOWN)
+      throw std::runtime_error("unrecognized voxel type");
+
+    // Get the volume dimensions.
+    vec3i dimensions = getParam3i("dimensions", vec3i(0));
+    if (reduce_min(dimensions) <= 0)
+      throw std::runtime_error("invalid volume dimensions");
+
+    // Get the voxel data of the timesteps.
+    Data *timestepData = getParamData("timesteps", nullptr);
+    if (!timestepData || timestepData->numItems == 0
+        || (timestepData->type != OSP_OBJECT
+            && timestepData->type != OSP_DATA)) {
+      throw std::runtime_error("time_series_volume needs a 'timesteps' "
+                               "array of voxel data arrays");
+    }
+
+    const size_t voxelBytes = size_t(dimensions.x) * dimensions.y
+                              * dimensions.z * sizeOf(ospVoxelType);
+    for (size_t i = 0; i < timestepData->numItems; i++) {
+      Data *voxels = ((Data **)timestepData->data)[i];
+      if (!voxels || voxels->numBytes < voxelBytes) {
+        throw std::runtime_error("time_series_volume: timestep "
+                                 + std::to_string(i) + " has too few voxels");
+      }
+      timesteps.emplace_back(voxels);
+    }
+
+    allocatedVoxelData = nullptr;
+    currentStep = clamp(int(getParam1f("time", 0.f)), 0,
+                        int(timesteps.size()) - 1);
+
+    // Create the rendered and the prefetch ISPC volumes.
+    ispcEquivalent = ispc::SharedStructuredVolume_createInstance
+      (this, ospVoxelType, (const ispc::vec3i &)dimensions,
+       timesteps[currentStep]->data);
+    backIE = ispc::SharedStructuredVolume_createInstance
+      (this, ospVoxelType, (const ispc::vec3i &)dimensions,
+       timesteps[currentStep]->data);
+  }
+
+  void TimeSeriesVolume::buildMipPyramid()
+  {
+    if (getParam1i("mipLevels", 0) > 0) {
+      static WarnOnce warning("time_series_volume does not support "
+                              "'mipLevels', ignoring it");
+    }
+  }
+
+  void TimeSeriesVolume::buildGradients()
+  {
+    if (getParam1i("precomputedGradients", 0)) {
+      static WarnOnce warning("time_series_volume does not support "
+                              "'precomputedGradients', ignoring it");
+    }
+  }
+
+  void TimeSeriesVolume::setTimestep(int step)
+  {
+    waitForPrefetch();
+
+    // The timestep was not prefetched (e.g. when jumping), build it now.
+    if (step != prefetchedStep) {
+      ispc::SharedStructuredVolume_setVoxelData(backIE,
+                                                timesteps[step]->data);
+      buildBackAccelerator();
+    }
+
+    // Nothing is rendered now, the back volume (with the previous timestep)
+    // is prefetched the next time.
+    ispc::SharedStructuredVolume_swapVoxels(ispcEquivalent, backIE);
+    prefetchedStep = currentStep;
+    currentStep = step;
+
+    updateVisibility();
+  }
+
+  void TimeSeriesVolume::prefetch(int step)
+  {
+    if (step == currentStep || step == prefetchedStep)
+      return;
+
+    prefetchedStep = -1;
+    prefetching = true;
+    tasking::schedule([=]() {
+      ispc::SharedStructuredVolume_setVoxelData(backIE,
+                                                timesteps[step]->data);
+      buildBackAccelerator();
+      prefetchedStep = step;
+      prefetching = false;
+    });
+  }
+
+  void TimeSeriesVolume::buildBackAccelerator()
+  {
+    void *accel = ispc::StructuredVolume_createAccelerator(backIE);
+    const int numBricks = ispc::GridAccelerator_getBrickCount_x(accel)
+                          * ispc::GridAccelerator_getBrickCount_y(accel)
+                          * ispc::GridAccelerator_getBrickCount_z(accel);
+    tasking::parallel_for(numBricks, [&](int brickIndex) {
+      ispc::GridAccelerator_buildAccelerator(backIE, brickIndex);
+    });
+  }
+
+  void TimeSeriesVolume::waitForPrefetch()
+  {
+    while (prefetching)
+      std::this_thread::yield();
+  }
+
+  // A structured volume animated through shared voxel buffers, one per
+  // timestep.
+  OSP_REGISTER_VOLUME(TimeSeriesVolume, time_series_volume);
+
+} // ::ospray
@@ -0,0 +1,80 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "SharedStructuredVolume.h"
+// std
+#include <atomic>
+
+namespace ospray {
+
+  //! \brief A SharedStructuredVolume animated through a sequence of
+  //!  timesteps, each a shared voxel buffer.
+  //!
+  //!  While one timestep is rendered the accelerator of the next one is
+  //!  built in the background into a second ISPC volume, which is swapped
+  //!  with the rendered one when the application commits the new "time".
+  //!
+  struct OSPRAY_SDK_INTERFACE TimeSeriesVolume : public SharedStructuredVolume
+  {
+    virtual ~TimeSeriesVolume() override;
+
+    //! A string description of this class.
+    virtual std::string toString() const override;
+
+    //! Switch to the timestep selected by "time", prefetching the next one.
+    virtual void commit() override;
+
+  protected:
+
+    //! Create the front and back ISPC volumes.
+    void createEquivalentISPC() override;
+
+    //! Not supported, the mip levels would need a rebuild per timestep.
+    virtual void buildMipPyramid() override;
+
+    //! Not supported, the gradients would need a rebuild per timestep.
+    virtual void buildGradients() override;
+
+  private:
+
+    //! Make 'step' the rendered timestep, using the prefetched accelerator
+    //!  if it is ready.
+    void setTimestep(int step);
+
+    //! Build the accelerator of 'step' in the back volume in the background.
+    void prefetch(int step);
+
+    //! Build the accelerator of the timestep the back volume points to.
+    void buildBackAccelerator();
+
+    void waitForPrefetch();
+
+    //! The voxels of each timestep.
+    std::vector<Ref<Data>> timesteps;
+
+    //! The ISPC volume the next timestep is prefetched into.
+    void *backIE {nullptr};
+
+    //! The rendered timestep and the one whose accelerator is ready in the
+    //!  back volume (-1 if none).
+    int currentStep {0};
+    int prefetchedStep {-1};
+    std::atomic<bool> prefetching {false};
+  };
+
+} // ::ospray
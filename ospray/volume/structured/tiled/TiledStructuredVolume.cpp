@@ -0,0 +1,137 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+//ospray
+#include "TiledStructuredVolume.h"
+#include "TiledStructuredVolume_ispc.h"
+#include "../../../common/Data.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <cstring>
+
+namespace ospray {
+
+  constexpr int TiledStructuredVolume::tileWidth;
+
+  TiledStructuredVolume::~TiledStructuredVolume()
+  {
+    free64(tiledVoxels);
+  }
+
+  std::string TiledStructuredVolume::toString() const
+  {
+    return("ospray::TiledStructuredVolume<" + voxelType + ">");
+  }
+
+  void TiledStructuredVolume::commit()
+  {
+    // Create the equivalent ISPC volume container.
+    if (ispcEquivalent == nullptr)
+      createEquivalentISPC();
+
+    // Tile the voxelData, if given, once per data object; otherwise the
+    // voxels are set via ospSetRegion().
+    Data *voxelData = (Data *)getParamObject("voxelData", nullptr);
+    if (voxelData && voxelData != copiedVoxelData) {
+      const size_t bytes = size_t(dimensions.x) * dimensions.y * dimensions.z
+                           * sizeOf(getVoxelType());
+      if (voxelData->numBytes < bytes)
+        throw std::runtime_error("the voxelData of a tiled_structured_volume "
+                                 "is smaller than its dimensions");
+      setRegion(voxelData->data, vec3i(0), dimensions);
+      copiedVoxelData = voxelData;
+    }
+
+    // StructuredVolume commit actions.
+    StructuredVolume::commit();
+  }
+
+  int TiledStructuredVolume::setRegion(const void *source,
+                                       const vec3i &index,
+                                       const vec3i &count)
+  {
+    if (ispcEquivalent == nullptr)
+      createEquivalentISPC();
+
+    Assert2(source,"nullptr source in TiledStructuredVolume::setRegion()");
+
+    const vec3i lower = max(index, vec3i(0));
+    const vec3i upper = min(index + count, dimensions);
+    if (lower.x >= upper.x || lower.y >= upper.y || lower.z >= upper.z)
+      return true;
+
+    // Copy the rows of the region, in runs of voxels within one tile.
+    const size_t voxelSize = sizeOf(getVoxelType());
+    const vec3i rows = upper - lower;
+    tasking::parallel_for(size_t(rows.y) * rows.z, [&](size_t row) {
+      const int y = lower.y + row % rows.y;
+      const int z = lower.z + row / rows.y;
+      const uint8_t *in = (const uint8_t *)source + voxelSize *
+          ((lower.x - index.x) + size_t(count.x) *
+           ((y - index.y) + size_t(count.y) * (z - index.z)));
+      uint8_t *out = (uint8_t *)tiledVoxels;
+      for (int x = lower.x; x < upper.x;) {
+        const int run = std::min(tileWidth - (x & (tileWidth - 1)),
+                                 upper.x - x);
+        memcpy(out + voxelSize * tiledIndex(vec3i(x, y, z)), in,
+               run * voxelSize);
+        in += run * voxelSize;
+        x += run;
+      }
+    });
+
+    markDirty(lower, upper);
+    return true;
+  }
+
+  void TiledStructuredVolume::createEquivalentISPC()
+  {
+    // Get the voxel type.
+    voxelType = getParamString("voxelType", "unspecified");
+    const OSPDataType ospVoxelType = getVoxelType();
+    if (ospVoxelType == OSP_UNKNOWN) {
+      throw std::runtime_error("unrecognized voxel type (must be set before "
+                               "calling ospSetRegion())");
+    }
+
+    // Get the volume dimensions.
+    this->dimensions = getParam3i("dimensions", vec3i(0));
+    if (reduce_min(this->dimensions) <= 0) {
+      throw std::runtime_error("invalid volume dimensions (must be set before "
+                               "calling ospSetRegion())");
+    }
+
+    // Voxels not set read as 0; the zeroing also first touches the pages
+    // in parallel.
+    tileCount = (this->dimensions + tileWidth - 1) / tileWidth;
+    tiledVoxels = malloc64Large(size_t(tileCount.x) * tileCount.y *
+                                tileCount.z * tileWidth * tileWidth *
+                                tileWidth * sizeOf(ospVoxelType));
+
+    // Create an ISPC TiledStructuredVolume object and assign type-specific
+    // function pointers.
+    ispcEquivalent = ispc::TiledStructuredVolume_createInstance(this,
+                                         (int)ospVoxelType,
+                                         (const ispc::vec3i &)this->dimensions,
+                                         tiledVoxels);
+  }
+
+  // A volume type with the voxels in tiles of 4x4x4, copied from the
+  // application's voxelData or set via ospSetRegion().
+  OSP_REGISTER_VOLUME(TiledStructuredVolume, tiled_structured_volume);
+
+} // ::ospray
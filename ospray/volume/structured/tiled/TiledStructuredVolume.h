@@ -0,0 +1,73 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "../StructuredVolume.h"
+
+namespace ospray {
+
+  //! \brief A concrete implementation of the StructuredVolume class
+  //!  in which the voxel data is copied into tiles of 4x4x4 voxels.
+  //!
+  //!  The tiles keep the 8 voxels of a trilinear interpolation within one
+  //!  or few cache lines for any viewing direction, while (unlike the
+  //!  BlockBrickedVolume) needing only a single copy of the voxels, which
+  //!  is transformed from xyz-order at commit (voxelData) or ospSetRegion().
+  //!
+  struct OSPRAY_SDK_INTERFACE TiledStructuredVolume : public StructuredVolume
+  {
+    virtual ~TiledStructuredVolume() override;
+
+    //! A string description of this class.
+    virtual std::string toString() const override;
+
+    //! Allocate storage and populate the volume, called through the OSPRay API.
+    virtual void commit() override;
+
+    //! Copy voxels into the volume at the given index (non-zero return value
+    //!  indicates success).
+    virtual int setRegion(const void *source,
+                          const vec3i &index,
+                          const vec3i &count) override;
+
+  protected:
+
+    //! Create the equivalent ISPC volume container.
+    void createEquivalentISPC() override;
+
+    //! Width of a tile in voxels (TILE_WIDTH in the ISPC code).
+    static constexpr int tileWidth = 4;
+
+    //! Index of a voxel in the tiled layout.
+    size_t tiledIndex(const vec3i &index) const
+    {
+      const size_t tile = (index.x >> 2) + size_t(tileCount.x) *
+          ((index.y >> 2) + size_t(tileCount.y) * (index.z >> 2));
+      return (tile << 6) | ((index.z & 3) << 4) | ((index.y & 3) << 2) |
+             (index.x & 3);
+    }
+
+    vec3i tileCount {0};
+
+    //! The tiled copy of the voxels.
+    void *tiledVoxels {nullptr};
+
+    //! The voxelData copied by the last commit().
+    Data *copiedVoxelData {nullptr};
+  };
+
+} // ::ospray
@@ -15,107 +15,305 @@
 // ======================================================================== //
 
 #include "MinMaxBVH2.h"
+// ospcommon
+#include "ospcommon/tasking/parallel_for.h"
+// std
+#include <algorithm>
+#include <limits>
 
 // num prims that _force_ a leaf; undef to revert to sah termination criterion
 //#define LEAF_THRESHOLD 2
 
 namespace ospray {
 
-  template <typename T, int SIZE>
-  inline float safeArea(const box_t<T, SIZE> &b)
-  {
-    auto size = b.upper - b.lower;
-    float f   = size.x * size.y + size.x * size.z + size.y * size.z;
-    return std::max(std::fabs(f), 1e-20f);
-  }
+  namespace {
+
+    //! The number of SAH bins (along the largest centroid extent).
+    constexpr int numBins = 16;
+
+    //! The maximum number of primitives per leaf (encoded in 3 bits).
+    constexpr size_t maxLeafSize = 7;
+
+    //! Ranges of at least this many primitives are binned, and their
+    //!  subtrees built, in parallel.
+    constexpr size_t parallelThreshold = 4096;
+    constexpr size_t parallelBlockSize = 1024;
+
+    template <typename T, int SIZE>
+    inline float safeArea(const box_t<T, SIZE> &b)
+    {
+      auto size = b.upper - b.lower;
+      float f   = size.x * size.y + size.x * size.z + size.y * size.z;
+      return std::max(std::fabs(f), 1e-20f);
+    }
+
+    inline vec3f centroid(const box4f &b)
+    {
+      return 0.5f * (vec3f(b.lower.x, b.lower.y, b.lower.z) +
+                     vec3f(b.upper.x, b.upper.y, b.upper.z));
+    }
+
+    //! Bounds of the primitives and of their centroids.
+    struct RangeInfo
+    {
+      box4f bounds = empty;
+      box3f centBounds = empty;
+
+      void merge(const RangeInfo &other)
+      {
+        bounds.extend(other.bounds);
+        centBounds.extend(other.centBounds);
+      }
+    };
+
+    struct BinInfo
+    {
+      box4f bounds[numBins];
+      size_t count[numBins];
+
+      BinInfo()
+      {
+        for (int b = 0; b < numBins; b++) {
+          bounds[b] = empty;
+          count[b]  = 0;
+        }
+      }
+
+      void merge(const BinInfo &other)
+      {
+        for (int b = 0; b < numBins; b++) {
+          bounds[b].extend(other.bounds[b]);
+          count[b] += other.count[b];
+        }
+      }
+    };
+
+    //! Maps centroids to bins along the largest extent of their bounds.
+    struct BinMapping
+    {
+      int dim;
+      float lower;
+      float scale;
+
+      BinMapping(const box3f &centBounds)
+      {
+        const vec3f extent = centBounds.size();
+        dim   = arg_max(extent);
+        lower = centBounds.lower[dim];
+        scale = extent[dim] > 0.f ? (numBins * 0.99999f) / extent[dim] : 0.f;
+      }
+
+      inline int bin(const vec3f &c) const
+      {
+        const int b = int((c[dim] - lower) * scale);
+        return std::min(std::max(b, 0), numBins - 1);
+      }
+    };
+
+    //! Compute 'func(begin, end)' over 'numItems', merging the results of
+    //!  blocks of items in parallel if there are enough of them.
+    template <typename T, typename FUNC>
+    inline T parallelReduce(const size_t numItems, const FUNC &func)
+    {
+      if (numItems < parallelThreshold)
+        return func(size_t(0), numItems);
+
+      const size_t numBlocks =
+          (numItems + parallelBlockSize - 1) / parallelBlockSize;
+      std::vector<T> blockResult(numBlocks);
+      tasking::parallel_for(numBlocks, [&](size_t blockID) {
+        const size_t begin = blockID * parallelBlockSize;
+        const size_t end   = std::min(begin + parallelBlockSize, numItems);
+        blockResult[blockID] = func(begin, end);
+      });
+
+      T result = blockResult[0];
+      for (size_t i = 1; i < numBlocks; i++)
+        result.merge(blockResult[i]);
+      return result;
+    }
+
+  }  // ::ospray::{anonymous}
 
   void MinMaxBVH2::buildRec(const size_t nodeID,
                             const box4f *const primBounds,
-                            /*! tmp primid array, for non-inplace partition */
-                            int64 *tmp_primID,
                             const size_t begin,
                             const size_t end)
   {
-    box4f bounds4     = empty;
-    box4f centBounds4 = empty;
+    const size_t numPrims = end - begin;
+    int64 *const prims    = primID.data() + begin;
 
-    union
-    {
-      vec3f as_vec3f;
-      vec4f as_vec4f;
-      float raw[4];
-    } ctr;
-
-    for (size_t i = begin; i < end; i++) {
-      bounds4.extend(primBounds[primID[i]]);
-      centBounds4.extend(center(primBounds[primID[i]]));
-    }
+    const RangeInfo info =
+        parallelReduce<RangeInfo>(numPrims, [&](size_t b, size_t e) {
+          RangeInfo r;
+          for (size_t i = b; i < e; i++) {
+            const box4f &primBox = primBounds[prims[i]];
+            r.bounds.extend(primBox);
+            r.centBounds.extend(centroid(primBox));
+          }
+          return r;
+        });
 
-    if (nodeID == 0)
-      overallBounds = bounds4;
+    BinaryNode &n = binaryNode[nodeID];
+    n.lower       = info.bounds.lower;
+    n.upper       = info.bounds.upper;
+    n.isLeaf      = true;
+    n.begin       = begin;
+    n.numPrims    = numPrims;
 
-    node[nodeID].lower = bounds4.lower;
-    node[nodeID].upper = bounds4.upper;
+    if (numPrims <= 1)
+      return;
 
-    const box3f centBounds((vec3f &)centBounds4.lower,
-                           (vec3f &)centBounds4.upper);
+    // find the best SAH split over the bins
+    const BinMapping mapping(info.centBounds);
+    const BinInfo bins =
+        parallelReduce<BinInfo>(numPrims, [&](size_t b, size_t e) {
+          BinInfo r;
+          for (size_t i = b; i < e; i++) {
+            const box4f &primBox = primBounds[prims[i]];
+            const int bin        = mapping.bin(centroid(primBox));
+            r.bounds[bin].extend(primBox);
+            r.count[bin]++;
+          }
+          return r;
+        });
 
-    size_t dim        = arg_max(centBounds.size());
-    ctr.as_vec3f      = center(centBounds);
-    float pos         = ctr.raw[dim];
-    float costNoSplit = 1 + (end - begin);
+    int bestSplit  = -1;
+    float bestCost = std::numeric_limits<float>::infinity();
+    if (mapping.scale > 0.f) {
+      // areas and counts left of each split, then sweep from the right
+      float leftArea[numBins];
+      size_t leftCount[numBins];
+      box4f lBounds = empty;
+      size_t lCount = 0;
+      for (int b = 0; b < numBins - 1; b++) {
+        lBounds.extend(bins.bounds[b]);
+        lCount += bins.count[b];
+        leftArea[b + 1]  = safeArea(lBounds);
+        leftCount[b + 1] = lCount;
+      }
 
-    size_t l      = begin;
-    size_t r      = end;
-    box4f lBounds = empty;
-    box4f rBounds = empty;
+      box4f rBounds = empty;
+      size_t rCount = 0;
+      for (int b = numBins - 1; b > 0; b--) {
+        rBounds.extend(bins.bounds[b]);
+        rCount += bins.count[b];
+        if (leftCount[b] == 0 || rCount == 0)
+          continue;
+        const float cost =
+            leftArea[b] * leftCount[b] + safeArea(rBounds) * rCount;
+        if (cost < bestCost) {
+          bestCost  = cost;
+          bestSplit = b;
+        }
+      }
+    }
 
-    for (size_t i = begin; i < end; i++) {
-      ctr.as_vec4f = center(primBounds[primID[i]]);
+    const float costNoSplit = 1 + numPrims;
+    const float costIfSplit =
+        1 + (1.f / safeArea(info.bounds)) * bestCost;
 
-      if (ctr.raw[dim] < pos) {
-        tmp_primID[l++] = primID[i];
-        lBounds.extend(primBounds[primID[i]]);
-      } else {
-        tmp_primID[--r] = primID[i];
-        rBounds.extend(primBounds[primID[i]]);
-      }
+    if (numPrims <= maxLeafSize &&
+        (
+#ifdef LEAF_THRESHOLD
+            numPrims <= LEAF_THRESHOLD ||
+#endif
+            bestSplit < 0 || costIfSplit >= costNoSplit)) {
+      return;
     }
 
-    for (size_t i = begin; i < end; i++) {
-      primID[i] = tmp_primID[i];
+    size_t mid;
+    if (bestSplit >= 0) {
+      mid = std::partition(prims,
+                           prims + numPrims,
+                           [&](const int64 prim) {
+                             return mapping.bin(centroid(primBounds[prim])) <
+                                    bestSplit;
+                           }) -
+            primID.data();
+    } else {
+      // all centroids are the same, but the leaf would be too large
+      mid = begin + numPrims / 2;
     }
+    assert(mid > begin && mid < end);
 
-    float costIfSplit =
-        1 +
-        (1.f / safeArea(bounds4)) * (safeArea(lBounds) * (l - begin) +
+    const size_t childID = numBinaryNodes.fetch_add(2);
+    n.isLeaf             = false;
+    n.child              = childID;
+
+    if (numPrims >= parallelThreshold) {
+      tasking::parallel_for(2, [&](int i) {
+        if (i == 0)
+          buildRec(childID + 0, primBounds, begin, mid);
+        else
+          buildRec(childID + 1, primBounds, mid, end);
+      });
+    } else {
+      buildRec(childID + 0, primBounds, begin, mid);
+      buildRec(childID + 1, primBounds, mid, end);
+    }
+  }
 
-                                     safeArea(rBounds) * (end - l));
+  void MinMaxBVH2::collapse(const size_t nodeID, const size_t binaryID)
+  {
+    // open the inner node with the largest surface area until the node
+    // is full
+    size_t child[width];
+    int numChildren = 0;
 
-    if (
-#ifdef LEAF_THRESHOLD
-        (end - begin) <= LEAF_THRESHOLD ||
-#endif
-        ((costIfSplit >= costNoSplit) && ((end - begin) <= 7)) ||
-        (l == begin) || (l == end)) {
-      node[nodeID].childRef = (end - begin) + begin * sizeof(primID[0]);
+    const BinaryNode &bn = binaryNode[binaryID];
+    if (bn.isLeaf) {
+      if (bn.numPrims)
+        child[numChildren++] = binaryID;
     } else {
-      assert(l > begin);
-      assert(l < end);
-      for (size_t i = begin; i < l; i++) {
-        ctr.as_vec4f = center(primBounds[primID[i]]);
-        assert(ctr.raw[dim] < pos);
+      child[numChildren++] = bn.child + 0;
+      child[numChildren++] = bn.child + 1;
+    }
+
+    while (numChildren < width) {
+      int best       = -1;
+      float bestArea = -1.f;
+      for (int i = 0; i < numChildren; i++) {
+        const BinaryNode &c = binaryNode[child[i]];
+        if (!c.isLeaf && safeArea(c) > bestArea) {
+          best     = i;
+          bestArea = safeArea(c);
+        }
+      }
+      if (best < 0)
+        break;
+      const size_t opened  = binaryNode[child[best]].child;
+      child[best]          = opened + 0;
+      child[numChildren++] = opened + 1;
+    }
+
+    for (int i = 0; i < width; i++) {
+      Node &n = node[nodeID];
+      if (i >= numChildren) {
+        n.lower_x[i] = n.lower_y[i] = n.lower_z[i] = n.range_lo[i] = pos_inf;
+        n.upper_x[i] = n.upper_y[i] = n.upper_z[i] = n.range_hi[i] = neg_inf;
+        n.childRef[i] = 0;
+        continue;
       }
-      for (size_t i = l; i < end; i++) {
-        ctr.as_vec4f = center(primBounds[primID[i]]);
-        assert(ctr.raw[dim] >= pos);
+
+      const BinaryNode &c = binaryNode[child[i]];
+      n.lower_x[i]  = c.lower.x;
+      n.lower_y[i]  = c.lower.y;
+      n.lower_z[i]  = c.lower.z;
+      n.range_lo[i] = c.lower.w;
+      n.upper_x[i]  = c.upper.x;
+      n.upper_y[i]  = c.upper.y;
+      n.upper_z[i]  = c.upper.z;
+      n.range_hi[i] = c.upper.w;
+
+      if (c.isLeaf) {
+        n.childRef[i] = c.numPrims + c.begin * sizeof(primID[0]);
+      } else {
+        const size_t childID = node.size();
+        n.childRef[i]        = childID * sizeof(Node);
+        node.push_back(Node());
+        collapse(childID, child[i]);
       }
-      size_t childID        = node.size();
-      node[nodeID].childRef = childID * sizeof(Node);
-      node.push_back(Node());
-      node.push_back(Node());
-      buildRec(childID + 0, primBounds, tmp_primID, begin, l);
-      buildRec(childID + 1, primBounds, tmp_primID, l, end);
     }
   }
 
@@ -132,30 +330,78 @@ namespace ospray {
                     const int64 *const primRefs,
                     const size_t numPrims)
   {
+    mappedNode   = nullptr;
+    mappedPrimID = nullptr;
+
     this->primID.resize(numPrims);
     std::copy(primRefs, primRefs + numPrims, primID.begin());
 
+    binaryNode.resize(std::max(2 * numPrims, size_t(1)));
+    numBinaryNodes = 1;
+    buildRec(0, primBounds, 0, numPrims);
+    overallBounds = binaryNode[0];
+
+    // the root is always an inner node, as its range is used for the
+    // samples of all primitives
     this->node.clear();
+    this->node.reserve(numBinaryNodes / 2 + 1);
     this->node.push_back(Node());
-    this->node.push_back(Node());
+    collapse(0, 0);
+
+    binaryNode.clear();
+    binaryNode.shrink_to_fit();
+
+    numNodes   = node.size();
+    numPrimIDs = primID.size();
+    root       = 0;
+  }
 
-    /*! tmp primid array, for non-inplace partition */
-    std::vector<int64> tmp_primID(numPrims);
+  void MinMaxBVH2::store(std::vector<AccelCache::Section> &sections,
+                         uint32 firstTag) const
+  {
+    sections.push_back({firstTag + 0, &overallBounds, sizeof(overallBounds)});
+    sections.push_back({firstTag + 1, nodePtr(), numNodes * sizeof(Node)});
+    sections.push_back(
+        {firstTag + 2, itemListPtr(), numPrimIDs * sizeof(int64)});
+  }
+
+  bool MinMaxBVH2::restore(const AccelCache &cache, uint32 firstTag)
+  {
+    size_t boundsBytes, nodeBytes, primIDBytes;
+    const void *bounds  = cache.section(firstTag + 0, boundsBytes);
+    const void *nodes   = cache.section(firstTag + 1, nodeBytes);
+    const void *primIDs = cache.section(firstTag + 2, primIDBytes);
+    if (!bounds || boundsBytes != sizeof(overallBounds) || !nodes ||
+        nodeBytes == 0 || nodeBytes % sizeof(Node) != 0 || !primIDs)
+      return false;
 
-    buildRec(0, primBounds, tmp_primID.data(), 0, numPrims);
-    this->node.resize(this->node.size());
+    overallBounds = *(const box4f *)bounds;
+    mappedNode    = (const Node *)nodes;
+    mappedPrimID  = (const int64 *)primIDs;
+    numNodes      = nodeBytes / sizeof(Node);
+    numPrimIDs    = primIDBytes / sizeof(int64);
+    root          = 0;
 
-    root = node[0].childRef;
+    node.clear();
+    node.shrink_to_fit();
+    primID.clear();
+    primID.shrink_to_fit();
+
+    return true;
   }
 
   const void *MinMaxBVH2::nodePtr() const
   {
+    if (mappedNode)
+      return mappedNode;
     assert(!node.empty());
     return node.data();
   }
 
   const int64 *MinMaxBVH2::itemListPtr() const
   {
+    if (mappedPrimID)
+      return mappedPrimID;
     assert(!primID.empty());
     return primID.data();
   }
@@ -170,4 +416,9 @@ namespace ospray {
     return overallBounds;
   }
 
+  size_t MinMaxBVH2::memoryUsage() const
+  {
+    return node.size() * sizeof(Node) + primID.size() * sizeof(int64);
+  }
+
 }  // ::ospray
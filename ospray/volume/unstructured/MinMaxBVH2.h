@@ -19,18 +19,40 @@
 // ospray
 #include "common/Data.h"
 #include "common/Model.h"
+#include "common/AccelCache.h"
+// std
+#include <atomic>
 
 namespace ospray {
 
-  /*! defines a (binary) BVH with some float min/max value per
-      node. The BVH itself does not specify the primitive type it is
-      used with, or what those min/max values represent. */
+  /*! defines a BVH with some float min/max value per node. The BVH
+      itself does not specify the primitive type it is used with, or
+      what those min/max values represent.
+
+      It is built as a binary BVH (with a parallel binned SAH builder)
+      which is then collapsed into nodes of up to 'width' children,
+      stored in SoA layout such that the traversal can test all
+      children of a node at once. */
   struct MinMaxBVH2
   {
-    /*! a node in a MinMaxBVH: a (4D-)bounding box, plus a child/leaf reference */
-    struct Node : public box4f
+    /*! the (maximum) number of children of a node, must match
+        MINMAXBVH_WIDTH in MinMaxBVH2.ih */
+    static constexpr int width = 4;
+
+    /*! a node in a MinMaxBVH: the (4D-)bounding boxes of its children,
+        plus a child/leaf reference each; unused children have empty
+        bounds and ranges */
+    struct Node
     {
-      uint64 childRef;
+      float lower_x[width];
+      float lower_y[width];
+      float lower_z[width];
+      float range_lo[width];
+      float upper_x[width];
+      float upper_y[width];
+      float upper_z[width];
+      float range_hi[width];
+      uint64 childRef[width];
     };
 
     void build(/*! one bounding box per primitive. The attribute value
@@ -45,20 +67,46 @@ namespace ospray {
                const int64 *const primRefs,
                const size_t numPrims);
 
+    /*! add the sections of the built BVH to 'sections', using the tags
+        'firstTag' to 'firstTag'+2 */
+    void store(std::vector<AccelCache::Section> &sections,
+               uint32 firstTag) const;
+
+    /*! use a BVH stored by 'store()' in the (mapped) cache instead of
+        building it, returns false if the cache doesn't hold one */
+    bool restore(const AccelCache &cache, uint32 firstTag);
+
     const void *nodePtr() const;
 
     const int64 *itemListPtr() const;
 
     uint64 rootRef() const;
 
+    const box4f &bounds() const;
+
+    /*! memory of the nodes and item list built (not restored from a
+        mapped cache), in bytes */
+    size_t memoryUsage() const;
+
    private:
+    /*! a node of the binary BVH built first */
+    struct BinaryNode : public box4f
+    {
+      bool isLeaf;
+      /*! index of the first of the two children, for inner nodes */
+      size_t child;
+      /*! the range of primIDs, for leaves */
+      size_t begin;
+      size_t numPrims;
+    };
+
     void buildRec(const size_t nodeID,
                   const box4f *const primBounds,
-                  int64 *tmp_primID,
                   const size_t begin,
                   const size_t end);
 
-    const box4f &bounds() const;
+    /*! collapse the binary subtree below 'binaryID' into 'node[nodeID]' */
+    void collapse(const size_t nodeID, const size_t binaryID);
 
     // Data members //
 
@@ -70,6 +118,16 @@ namespace ospray {
     /*! node reference to the root node */
     uint64 root;
 
+    /*! the nodes and item list, if restored from a cache file */
+    const Node *mappedNode {nullptr};
+    const int64 *mappedPrimID {nullptr};
+    size_t numNodes {0};
+    size_t numPrimIDs {0};
+
     box4f overallBounds;
+
+    /*! the binary BVH, only valid during the build */
+    std::vector<BinaryNode> binaryNode;
+    std::atomic<size_t> numBinaryNodes;
   };
 }
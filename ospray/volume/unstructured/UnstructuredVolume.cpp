@@ -22,11 +22,24 @@
 #include "ospcommon/tasking/parallel_for.h"
 #include "ospcommon/utility/getEnvVar.h"
 
+// std
+#include <algorithm>
+#include <atomic>
+
 // auto-generated .h file.
 #include "UnstructuredVolume_ispc.h"
 
 namespace ospray {
 
+  namespace {
+
+    //! Sections of the accel cache file.
+    constexpr uint32 bvhCacheTag           = 0;
+    constexpr uint32 faceNormalsCacheTag   = 3;
+    constexpr uint32 faceNeighborsCacheTag = 4;
+
+  }  // ::ospray::{anonymous}
+
   UnstructuredVolume::UnstructuredVolume()
   {
     ispcEquivalent = ispc::UnstructuredVolume_createInstance(this);
@@ -56,30 +69,76 @@ namespace ospray {
     auto methodStringFromEnv =
       utility::getEnvVar<std::string>("OSPRAY_HEX_METHOD");
     std::string methodString =
-      methodStringFromEnv.value_or(getParamString("hexMethod","planar"));
+      methodStringFromEnv.value_or(getParamString("hexMethod","auto"));
     if (methodString == "planar") {
       ispc::UnstructuredVolume_method_planar(ispcEquivalent);
     } else if (methodString == "nonplanar") {
       ispc::UnstructuredVolume_method_nonplanar(ispcEquivalent);
+    } else {
+      ispc::UnstructuredVolume_method_auto(ispcEquivalent);
     }
 
     ispc::UnstructuredVolume_disableCellGradient(ispcEquivalent);
 
     if (getParam<int>("precomputedNormals", 1)) {
-      if (faceNormals.empty()) {
-        calculateFaceNormals();
+      if (faceNormals.empty() && !mappedFaceNormals) {
+        size_t numBytes = 0;
+        const void *cached = accelCache
+            ? accelCache->section(faceNormalsCacheTag, numBytes) : nullptr;
+        if (cached && numBytes == size_t(nCells) * 6 * sizeof(vec3f)) {
+          mappedFaceNormals = (const vec3f *)cached;
+        } else {
+          calculateFaceNormals();
+          accelCacheDirty = !accelCacheFile.empty();
+        }
         ispc::UnstructuredVolume_setFaceNormals(ispcEquivalent,
-                                                (const ispc::vec3f *)faceNormals.data());
+            (const ispc::vec3f *)(mappedFaceNormals ? mappedFaceNormals
+                                                    : faceNormals.data()));
       }
     } else {
-      if (!faceNormals.empty()) {
+      if (!faceNormals.empty() || mappedFaceNormals) {
         ispc::UnstructuredVolume_setFaceNormals(ispcEquivalent,
                                                 (const ispc::vec3f *)nullptr);
         faceNormals.clear();
         faceNormals.shrink_to_fit();
+        mappedFaceNormals = nullptr;
+      }
+    }
+
+    if (getParam<int>("cellAdjacency", 1)) {
+      if (faceNeighbors.empty() && !mappedFaceNeighbors) {
+        size_t numBytes = 0;
+        const void *cached = accelCache
+            ? accelCache->section(faceNeighborsCacheTag, numBytes) : nullptr;
+        if (cached && numBytes == size_t(nCells) * 4 * sizeof(int)) {
+          mappedFaceNeighbors = (const int *)cached;
+        } else {
+          buildCellAdjacency();
+          accelCacheDirty = !accelCacheFile.empty();
+        }
+        ispc::UnstructuredVolume_setFaceNeighbors(ispcEquivalent,
+            mappedFaceNeighbors ? mappedFaceNeighbors : faceNeighbors.data());
+      }
+    } else {
+      if (!faceNeighbors.empty() || mappedFaceNeighbors) {
+        ispc::UnstructuredVolume_setFaceNeighbors(ispcEquivalent, nullptr);
+        faceNeighbors.clear();
+        faceNeighbors.shrink_to_fit();
+        mappedFaceNeighbors = nullptr;
       }
     }
 
+    if (accelCacheDirty)
+      writeAccelCache();
+
+    // restored from the accel cache the BVH, normals and neighbors are
+    // memory mapped and thus not counted
+    const size_t accelBytes = bvh.memoryUsage();
+    setMemoryUsage(OSP_MEMORY_VOLUME,
+                   accelBytes + faceNormals.size() * sizeof(vec3f)
+                     + faceNeighbors.size() * sizeof(int) + cellShape.size(),
+                   accelBytes);
+
     Volume::commit();
   }
 
@@ -101,11 +160,11 @@ namespace ospray {
 
     int maxIdx;
 
-    switch (indices[2 * id][0]) {
-    case -1:
+    switch (getCellType(id)) {
+    case TETRAHEDRON:
       maxIdx = 4;
       break;
-    case -2:
+    case WEDGE:
       maxIdx = 6;
       break;
     default:
@@ -113,25 +172,9 @@ namespace ospray {
       break;
     }
 
+    const size_t begin = getCellBegin(id);
     for (int i = 0; i < maxIdx; i++) {
-      size_t idx = 0;
-      switch (maxIdx) {
-      case 4:
-        idx = indices[2 * id + 1][i];
-        break;
-      case 6:
-        if (i < 2)
-          idx = indices[2 * id][1 + 2];
-        else
-          idx = indices[2 * id + 1][i - 2];
-        break;
-      case 8:
-        if (i < 4)
-          idx = indices[2 * id][i];
-        else
-          idx = indices[2 * id + 1][i - 4];
-        break;
-      }
+      const size_t idx = getIndex(begin + i);
       const auto &v = vertices[idx];
       const float f = cellField ? cellField[id] : field[idx];
       const auto p  = vec4f(v.x, v.y, v.z, f);
@@ -148,21 +191,25 @@ namespace ospray {
   void UnstructuredVolume::fixupTetWinding()
   {
     tasking::parallel_for(nCells, [&](int i) {
-      if (indices[2 * i].x != -1)
+      if (getCellType(i) != TETRAHEDRON)
         return;
 
-      auto &idx = indices[2 * i + 1];
-      const auto &p0 = vertices[idx.x];
-      const auto &p1 = vertices[idx.y];
-      const auto &p2 = vertices[idx.z];
-      const auto &p3 = vertices[idx.w];
+      const size_t begin = getCellBegin(i);
+      const int64 i0 = getIndex(begin);
+      const int64 i1 = getIndex(begin + 1);
+      const auto &p0 = vertices[i0];
+      const auto &p1 = vertices[i1];
+      const auto &p2 = vertices[getIndex(begin + 2)];
+      const auto &p3 = vertices[getIndex(begin + 3)];
 
       auto center = (p0 + p1 + p2 + p3) / 4;
       auto norm = cross(p1 - p0, p2 - p0);
       auto dist = dot(norm, p0 - center);
 
-      if (dist > 0.f)
-        std::swap(idx.x, idx.y);
+      if (dist > 0.f) {
+        setIndex(begin, i1);
+        setIndex(begin + 1, i0);
+      }
     });
   }
 
@@ -170,25 +217,98 @@ namespace ospray {
   {
     Data *verticesData   = getParamData("vertices", nullptr);
     Data *indicesData    = getParamData("indices", nullptr);
+    Data *indexData      = getParamData("index", nullptr);
+    Data *cellData       = getParamData("cell", nullptr);
+    Data *cellTypeData   = getParamData("cell.type", nullptr);
     Data *fieldData      = getParamData("field", nullptr);
     Data *cellFieldData  = getParamData("cellField", nullptr);
 
-    if (!verticesData || !indicesData || (!fieldData && !cellFieldData)) {
+    if (!verticesData || !(indicesData || indexData)
+        || (!fieldData && !cellFieldData)) {
       throw std::runtime_error(
           "#osp: missing correct data arrays in UnstructuredVolume!");
     }
 
+    for (const Data *data : {verticesData, indicesData, indexData, cellData,
+                             cellTypeData, fieldData, cellFieldData}) {
+      if (data && !data->compact()) {
+        throw std::runtime_error("#osp: UnstructuredVolume data arrays "
+                                 "cannot be strided!");
+      }
+    }
+
     nVertices   = verticesData->size();
 
-    nCells = indicesData->size() / 2;
-    indices = (vec4i *)indicesData->data;
+    if (indexData) {
+      // packed topology: the cell offsets into the index array and the
+      // cell types (as VTK)
+      auto is32 = [](const Data *data) {
+        return data->type == OSP_INT || data->type == OSP_UINT;
+      };
+      auto is64 = [](const Data *data) {
+        return data->type == OSP_LONG || data->type == OSP_ULONG;
+      };
+
+      if (!cellData || !cellTypeData
+          || cellData->size() != cellTypeData->size()
+          || cellTypeData->type != OSP_UCHAR
+          || !(is32(indexData) || is64(indexData))
+          || !(is32(cellData) || is64(cellData))) {
+        throw std::runtime_error("#osp: UnstructuredVolume 'index' needs "
+                                 "'cell' (int or long) and 'cell.type' "
+                                 "(uchar) arrays of the same size!");
+      }
+
+      nCells     = cellData->size();
+      index      = indexData->data;
+      numIndices = indexData->size();
+      index32    = is32(indexData);
+      cell       = cellData->data;
+      cell32     = is32(cellData);
+      cellType   = (const uint8 *)cellTypeData->data;
+
+      for (int i = 0; i < nCells; i++) {
+        const uint8 type = cellType[i];
+        const size_t numCellIndices =
+            type == TETRAHEDRON ? 4 : (type == WEDGE ? 6 : 8);
+        if (type != TETRAHEDRON && type != WEDGE && type != HEXAHEDRON) {
+          throw std::runtime_error(
+              "#osp: unsupported cell type in UnstructuredVolume!");
+        }
+        if (getCellBegin(i) + numCellIndices > numIndices) {
+          throw std::runtime_error(
+              "#osp: cell offset out of range in UnstructuredVolume!");
+        }
+      }
+    } else {
+      nCells     = indicesData->size() / 2;
+      index      = indicesData->data;
+      numIndices = size_t(nCells) * 8;
+      index32    = true;
+      cell       = nullptr;
+      cell32     = true;
+      cellType   = nullptr;
+    }
 
     vertices   = (vec3f *)verticesData->data;
     field      = fieldData ? (float *)fieldData->data : nullptr;
     cellField  = cellFieldData ? (float *)cellFieldData->data : nullptr;
 
-    buildBvhAndCalculateBounds();
+    // the adjacency is rebuilt (or restored) for the new cells in commit()
+    faceNeighbors.clear();
+
+    // the input is hashed before fixupTetWinding() modifies the indices
+    mapAccelCache();
+    if (accelCache && bvh.restore(*accelCache, bvhCacheTag)) {
+      const box4f &bounds = bvh.bounds();
+      bbox = box3f(vec3f(bounds.lower.x, bounds.lower.y, bounds.lower.z),
+                   vec3f(bounds.upper.x, bounds.upper.y, bounds.upper.z));
+    } else {
+      buildBvhAndCalculateBounds();
+      accelCacheDirty = !accelCacheFile.empty();
+    }
     fixupTetWinding();
+    classifyCells();
 
     float samplingRate = getParam1f("samplingRate", 1.f);
     float samplingStep = calculateSamplingStep();
@@ -198,7 +318,11 @@ namespace ospray {
                           nCells,
                           (const ispc::box3f &)bbox,
                           (const ispc::vec3f *)vertices,
-                          (const ispc::vec4i *)indices,
+                          index,
+                          index32,
+                          cell,
+                          cell32,
+                          cellType,
                           (const float *)field,
                           (const float *)cellField,
                           bvh.rootRef(),
@@ -206,6 +330,7 @@ namespace ospray {
                           bvh.itemListPtr(),
                           samplingRate,
                           samplingStep);
+    ispc::UnstructuredVolume_setCellShapes(ispcEquivalent, cellShape.data());
 
     Volume::finish();
     finished = true;
@@ -232,6 +357,73 @@ namespace ospray {
     bvh.build(primBounds.data(), primID.data(), nCells);
   }
 
+  void UnstructuredVolume::mapAccelCache()
+  {
+    // the normals of a previous mapping are about to become invalid
+    if (mappedFaceNormals) {
+      ispc::UnstructuredVolume_setFaceNormals(ispcEquivalent,
+                                              (const ispc::vec3f *)nullptr);
+      mappedFaceNormals = nullptr;
+    }
+    mappedFaceNeighbors = nullptr;
+    accelCache.reset();
+
+    accelCacheFile = getParamString("accelCacheFile", "");
+    if (accelCacheFile.empty())
+      return;
+
+    accelCacheHash =
+        AccelCache::hash(vertices, size_t(nVertices) * sizeof(vec3f));
+    accelCacheHash = AccelCache::hash(
+        index, numIndices * (index32 ? 4 : 8), accelCacheHash);
+    if (cell) {
+      accelCacheHash = AccelCache::hash(
+          cell, size_t(nCells) * (cell32 ? 4 : 8), accelCacheHash);
+      accelCacheHash = AccelCache::hash(cellType, nCells, accelCacheHash);
+    }
+    if (field) {
+      accelCacheHash = AccelCache::hash(
+          field, size_t(nVertices) * sizeof(float), accelCacheHash);
+    }
+    if (cellField) {
+      accelCacheHash = AccelCache::hash(
+          cellField, size_t(nCells) * sizeof(float), accelCacheHash);
+    }
+
+    accelCache = make_unique<AccelCache>();
+    if (!accelCache->map(accelCacheFile, accelCacheHash))
+      accelCache.reset();
+  }
+
+  void UnstructuredVolume::writeAccelCache()
+  {
+    std::vector<AccelCache::Section> sections;
+    bvh.store(sections, bvhCacheTag);
+
+    const vec3f *normals =
+        mappedFaceNormals ? mappedFaceNormals : faceNormals.data();
+    if (mappedFaceNormals || !faceNormals.empty()) {
+      sections.push_back({faceNormalsCacheTag,
+                          normals,
+                          size_t(nCells) * 6 * sizeof(vec3f)});
+    }
+
+    const int *neighbors =
+        mappedFaceNeighbors ? mappedFaceNeighbors : faceNeighbors.data();
+    if (mappedFaceNeighbors || !faceNeighbors.empty()) {
+      sections.push_back({faceNeighborsCacheTag,
+                          neighbors,
+                          size_t(nCells) * 4 * sizeof(int)});
+    }
+
+    try {
+      AccelCache::write(accelCacheFile, accelCacheHash, sections);
+    } catch (const std::runtime_error &e) {
+      postStatusMsg(1) << "WARNING: " << e.what();
+    }
+    accelCacheDirty = false;
+  }
+
   void UnstructuredVolume::calculateFaceNormals()
   {
     const auto numNormals = nCells * 6;
@@ -240,9 +432,13 @@ namespace ospray {
     tasking::parallel_for(numNormals / 6, [&](int taskIndex) {
       const int i   = taskIndex * 6;
 
-      if (indices[2 * taskIndex].x == -1) {
+      vec4i lower, upper;
+      getCellIndices(taskIndex, lower, upper);
+
+      const uint8 type = getCellType(taskIndex);
+      if (type == TETRAHEDRON) {
         // tetrahedron cell
-        const vec4i &t = indices[2 * taskIndex + 1];
+        const vec4i &t = upper;
 
         // The corners of each triangle in the tetrahedron.
         const int faces[4][3] = {{1, 2, 3}, {2, 0, 3}, {3, 0, 1}, {0, 2, 1}};
@@ -263,11 +459,8 @@ namespace ospray {
 
           faceNormals[i + j] = norm;
         }
-      } else if (indices[2 * taskIndex].x == -2) {
+      } else if (type == WEDGE) {
         // wedge cell
-        const vec4i &lower = indices[2 * taskIndex];
-        const vec4i &upper = indices[2 * taskIndex + 1];
-
         const auto v0 = vertices[lower.z];
         const auto v1 = vertices[lower.w];
         const auto v2 = vertices[upper.x];
@@ -282,9 +475,6 @@ namespace ospray {
         faceNormals[i + 4] = normalize(cross(v5 - v2, v1 - v2));
       } else {
         // hexahedron cell
-        const vec4i &lower = indices[2 * taskIndex];
-        const vec4i &upper = indices[2 * taskIndex + 1];
-
         const auto v0 = vertices[lower.x];
         const auto v1 = vertices[lower.y];
         const auto v2 = vertices[lower.z];
@@ -304,6 +494,120 @@ namespace ospray {
     });
   }
 
+  void UnstructuredVolume::classifyCells()
+  {
+    cellShape.resize(nCells);
+
+    std::atomic<int> numShapes[3];
+    for (auto &n : numShapes)
+      n = 0;
+
+    tasking::parallel_for(nCells, [&](int i) {
+      const uint8 type = getCellType(i);
+      if (type == TETRAHEDRON) {
+        cellShape[i] = AFFINE;
+        return;
+      }
+
+      const int numVertices = type == WEDGE ? 6 : 8;
+      const size_t begin    = getCellBegin(i);
+      vec3f v[8];
+      box3f bounds = empty;
+      for (int j = 0; j < numVertices; j++) {
+        v[j] = vertices[getIndex(begin + j)];
+        bounds.extend(v[j]);
+      }
+
+      // deviations below this are rounding, relative to the cell size
+      const float eps = 1e-4f * reduce_max(bounds.size());
+      auto zero = [&](const vec3f &d) { return length(d) <= eps; };
+
+      uint8 shape = NONPLANAR;
+      if (type == WEDGE) {
+        // the top is the translated bottom
+        if (zero(v[4] - v[1] - v[3] + v[0]) && zero(v[5] - v[2] - v[3] + v[0]))
+          shape = AFFINE;
+      } else if (zero(v[2] - v[1] - v[3] + v[0])
+                 && zero(v[5] - v[1] - v[4] + v[0])
+                 && zero(v[7] - v[3] - v[4] + v[0])
+                 && zero(v[6] - v[2] - v[4] + v[0])) {
+        // a parallelepiped, spanned by the edges from vertex 0
+        shape = AFFINE;
+      } else {
+        const int faces[6][4] = {{0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 5, 4},
+                                 {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}};
+        bool planar = true;
+        for (int f = 0; f < 6 && planar; f++) {
+          const vec3f &p0 = v[faces[f][0]];
+          const vec3f n   = cross(v[faces[f][1]] - p0, v[faces[f][3]] - p0);
+          const float len = length(n);
+          planar = len > 0.f && std::abs(dot(n, v[faces[f][2]] - p0)) <= eps * len;
+        }
+        if (planar)
+          shape = PLANAR;
+      }
+
+      cellShape[i] = shape;
+      numShapes[shape]++;
+    });
+
+    postStatusMsg(2) << "#osp: UnstructuredVolume has " << numShapes[AFFINE]
+                     << " affine, " << numShapes[PLANAR] << " planar and "
+                     << numShapes[NONPLANAR] << " nonplanar hexahedra/wedges";
+  }
+
+  void UnstructuredVolume::buildCellAdjacency()
+  {
+    // the faces of all tetrahedra, keyed by their sorted vertex indices;
+    // face j of a tetrahedron is the one opposite of its vertex j
+    struct Face
+    {
+      vec3i key;
+      int ref;  // 4 * cell + face
+
+      bool operator<(const Face &o) const
+      {
+        return key.x != o.key.x ? key.x < o.key.x
+             : key.y != o.key.y ? key.y < o.key.y
+             : key.z != o.key.z ? key.z < o.key.z
+             : ref < o.ref;
+      }
+    };
+
+    faceNeighbors.assign(size_t(nCells) * 4, -1);
+
+    std::vector<Face> faces;
+    faces.reserve(size_t(nCells) * 4);
+    for (int i = 0; i < nCells; i++) {
+      if (getCellType(i) != TETRAHEDRON)
+        continue;
+
+      const size_t begin = getCellBegin(i);
+      for (int j = 0; j < 4; j++) {
+        int v[3], n = 0;
+        for (int k = 0; k < 4; k++)
+          if (k != j)
+            v[n++] = int(getIndex(begin + k));
+        std::sort(v, v + 3);
+        faces.push_back({vec3i(v[0], v[1], v[2]), 4 * i + j});
+      }
+    }
+
+    std::sort(faces.begin(), faces.end());
+
+    // a shared face appears twice in a row, faces on the boundary (or
+    // shared with other cell types) once
+    for (size_t i = 0; i + 1 < faces.size(); i++) {
+      const Face &a = faces[i];
+      const Face &b = faces[i + 1];
+      if (a.key == b.key) {
+        faceNeighbors[a.ref] = b.ref / 4;
+        faceNeighbors[b.ref] = a.ref / 4;
+        i++;
+      }
+    }
+  }
+
   float UnstructuredVolume::calculateSamplingStep()
   {
     float dx = bbox.upper.x - bbox.lower.x;
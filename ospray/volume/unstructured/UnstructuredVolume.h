@@ -47,14 +47,38 @@ namespace ospray {
                         const size_t &count) override;
 
    private:
+    //! VTK cell types
+    enum CellType : uint8
+    {
+      TETRAHEDRON = 10,
+      HEXAHEDRON  = 12,
+      WEDGE       = 13
+    };
+
+    //! The type of cell 'id'.
+    uint8 getCellType(size_t id) const;
+    //! The offset of the first vertex index of cell 'id' into 'index'.
+    size_t getCellBegin(size_t id) const;
+    //! The i-th entry of 'index'.
+    int64 getIndex(size_t i) const;
+    void setIndex(size_t i, int64 value);
+    //! The vertex indices of cell 'id' in the legacy layout (e.g. those of
+    //! a tetrahedron in 'upper').
+    void getCellIndices(size_t id, vec4i &lower, vec4i &upper) const;
+
     box4f getTetBBox(size_t id);
 
     //! Complete volume initialization (only on first commit).
     void finish() override;
 
     void buildBvhAndCalculateBounds();
+    void mapAccelCache();
+    void writeAccelCache();
     void fixupTetWinding();
     void calculateFaceNormals();
+    //! Classify the shape of each hexahedron and wedge into 'cellShape'.
+    void classifyCells();
+    void buildCellAdjacency();
     float calculateSamplingStep();
 
     // Data members //
@@ -68,15 +92,117 @@ namespace ospray {
     Data *oldCellField{nullptr};
 
     int nCells;
-    vec4i *indices{nullptr};
+    //! The vertex indices of all cells (32 or 64 bit). With 'cell' (the
+    //! offset of each cell into it) and 'cellType' packed, otherwise in
+    //! the (32 bit) legacy layout of 8 per cell, padded at the front.
+    void *index{nullptr};
+    size_t numIndices{0};
+    bool index32{true};
+    const void *cell{nullptr};
+    bool cell32{true};
+    const uint8 *cellType{nullptr};
+
+    //! Cell shapes, which select the sampling method of each cell.
+    enum CellShape : uint8
+    {
+      AFFINE    = 0,
+      PLANAR    = 1,
+      NONPLANAR = 2
+    };
+    std::vector<uint8> cellShape;
 
     std::vector<vec3f> faceNormals;
+    //! The face normals, if restored from the accel cache.
+    const vec3f *mappedFaceNormals{nullptr};
+
+    //! The cell across each face of the tetrahedra (4 per cell, -1 if none).
+    std::vector<int> faceNeighbors;
+    //! The face neighbours, if restored from the accel cache.
+    const int *mappedFaceNeighbors{nullptr};
 
     box3f bbox;
 
     MinMaxBVH2 bvh;
 
+    //! The (optional) file the BVH, face normals and neighbours are cached in.
+    std::string accelCacheFile;
+    uint64 accelCacheHash{0};
+    std::unique_ptr<AccelCache> accelCache;
+    //! Whether the cache file is missing anything built during commit.
+    bool accelCacheDirty{false};
+
     bool finished{false};
   };
 
+  // Inlined function definitions ///////////////////////////////////////////
+
+  inline int64 UnstructuredVolume::getIndex(size_t i) const
+  {
+    return index32 ? int64(((const int32 *)index)[i])
+                   : ((const int64 *)index)[i];
+  }
+
+  inline void UnstructuredVolume::setIndex(size_t i, int64 value)
+  {
+    if (index32)
+      ((int32 *)index)[i] = int32(value);
+    else
+      ((int64 *)index)[i] = value;
+  }
+
+  inline void UnstructuredVolume::getCellIndices(size_t id,
+                                                 vec4i &lower,
+                                                 vec4i &upper) const
+  {
+    if (!cell) {
+      lower = ((const vec4i *)index)[2 * id];
+      upper = ((const vec4i *)index)[2 * id + 1];
+      return;
+    }
+
+    const uint8 type = getCellType(id);
+    const int first  = type == TETRAHEDRON ? 4 : (type == WEDGE ? 2 : 0);
+    const size_t begin = getCellBegin(id);
+    for (int i = 0; i < 8; i++) {
+      const int v = i < first ? -1 : int(getIndex(begin + i - first));
+      if (i < 4)
+        lower[i] = v;
+      else
+        upper[i - 4] = v;
+    }
+  }
+
+  inline uint8 UnstructuredVolume::getCellType(size_t id) const
+  {
+    if (cellType)
+      return cellType[id];
+
+    switch (getIndex(8 * id)) {
+    case -1:
+      return TETRAHEDRON;
+    case -2:
+      return WEDGE;
+    default:
+      return HEXAHEDRON;
+    }
+  }
+
+  inline size_t UnstructuredVolume::getCellBegin(size_t id) const
+  {
+    if (cell) {
+      return cell32 ? size_t(((const uint32 *)cell)[id])
+                    : size_t(((const uint64 *)cell)[id]);
+    }
+
+    // the legacy layout pads the front of the 8 indices of each cell
+    switch (getCellType(id)) {
+    case TETRAHEDRON:
+      return 8 * id + 4;
+    case WEDGE:
+      return 8 * id + 2;
+    default:
+      return 8 * id;
+    }
+  }
+
 }  // ::ospray
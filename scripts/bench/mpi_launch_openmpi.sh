@@ -1 +1 @@
-mpirun -np 4 "$@"
+mpirun -np ${OSPRAY_BENCH_RANKS:-4} "$@"
@@ -1 +1 @@
-ibrun "$@"
+ibrun ${OSPRAY_BENCH_RANKS:+-n $OSPRAY_BENCH_RANKS} "$@"
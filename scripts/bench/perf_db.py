@@ -0,0 +1,315 @@
+#!/usr/bin/python
+## ======================================================================== ##
+## Copyright 2016-2019 Intel Corporation                                    ##
+##                                                                          ##
+## Licensed under the Apache License, Version 2.0 (the "License");          ##
+## you may not use this file except in compliance with the License.         ##
+## You may obtain a copy of the License at                                  ##
+##                                                                          ##
+##     http://www.apache.org/licenses/LICENSE-2.0                           ##
+##                                                                          ##
+## Unless required by applicable law or agreed to in writing, software      ##
+## distributed under the License is distributed on an "AS IS" BASIS,        ##
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. ##
+## See the License for the specific language governing permissions and      ##
+## limitations under the License.                                           ##
+## ======================================================================== ##
+
+# Database of benchmark timings per commit, machine and dataset, and the
+# comparison of two commits which flags statistically significant slowdowns.
+#
+# The timings are the JSON files written by "ospBenchmark --json"; the
+# run_benchmark*.py scripts store them with --database. Each stored run of a
+# dataset is one sample: with several runs per commit (--repeat) the
+# comparison is a Welch t-test over the mean frame times of the runs, with a
+# single run per commit it falls back to the frame times within the run,
+# which underestimates the noise between runs.
+
+from __future__ import division, print_function
+
+import argparse
+import json
+import math
+import os
+import platform
+import sqlite3
+import subprocess
+import sys
+import time
+
+# Global constants ############################################################
+
+DEFAULT_DATABASE = "bench_results.sqlite"
+DEFAULT_STAGE = "frame"
+DEFAULT_THRESHOLD_PERCENT = 3.0
+DEFAULT_CONFIDENCE = 0.95
+
+SCHEMA = """
+CREATE TABLE IF NOT EXISTS runs (
+    id        INTEGER PRIMARY KEY,
+    commit_id TEXT NOT NULL,
+    machine   TEXT NOT NULL,
+    dataset   TEXT NOT NULL,
+    timestamp REAL NOT NULL
+);
+CREATE TABLE IF NOT EXISTS stages (
+    run_id  INTEGER NOT NULL REFERENCES runs(id),
+    stage   TEXT NOT NULL,
+    unit    TEXT NOT NULL,
+    samples INTEGER NOT NULL,
+    mean    REAL NOT NULL,
+    std_dev REAL NOT NULL,
+    median  REAL NOT NULL,
+    min     REAL NOT NULL,
+    max     REAL NOT NULL
+);
+CREATE INDEX IF NOT EXISTS runs_key ON runs (commit_id, machine, dataset);
+"""
+
+# Function definitions ########################################################
+
+def open_database(filename):
+    db = sqlite3.connect(filename)
+    db.executescript(SCHEMA)
+    return db
+
+def current_commit():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "HEAD"]) \
+            .decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+def current_machine():
+    return platform.node()
+
+# Stores the stages of one ospBenchmark JSON file as a run
+def store_run(db, commit, machine, dataset, json_file):
+    with open(json_file) as f:
+        results = json.load(f)
+
+    cursor = db.execute("INSERT INTO runs (commit_id, machine, dataset, "
+                        "timestamp) VALUES (?, ?, ?, ?)",
+                        (commit, machine, dataset, time.time()))
+    run_id = cursor.lastrowid
+    for stage, stats in results["stages"].items():
+        db.execute("INSERT INTO stages VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                   (run_id, stage, results.get("unit", "ms"),
+                    stats["samples"], stats["mean"], stats["stdDev"],
+                    stats["median"], stats["min"], stats["max"]))
+    db.commit()
+    return run_id
+
+# Resolves an abbreviated commit against the stored ones
+def resolve_commit(db, commit):
+    rows = db.execute("SELECT DISTINCT commit_id FROM runs "
+                      "WHERE commit_id LIKE ?", (commit + "%",)).fetchall()
+    if len(rows) != 1:
+        raise ValueError("commit '{}' matches {} stored commits"
+                         .format(commit, len(rows)))
+    return rows[0][0]
+
+# Returns {dataset: [(mean, std_dev, samples), ...]} of the given stage
+def load_runs(db, commit, machine, stage):
+    rows = db.execute("SELECT runs.dataset, stages.mean, stages.std_dev, "
+                      "stages.samples FROM runs JOIN stages "
+                      "ON stages.run_id = runs.id WHERE runs.commit_id = ? "
+                      "AND runs.machine = ? AND stages.stage = ? "
+                      "ORDER BY runs.id", (commit, machine, stage)).fetchall()
+    runs = {}
+    for dataset, mean, std_dev, samples in rows:
+        runs.setdefault(dataset, []).append((mean, std_dev, samples))
+    return runs
+
+# Student's t distribution ####################################################
+
+# Continued fraction of the regularized incomplete beta function (after
+# Numerical Recipes, betacf)
+def incomplete_beta_cf(a, b, x):
+    tiny = 1e-30
+    c = 1.0
+    d = 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        m2 = 2 * m
+        for num in (m * (b - m) * x / ((a + m2 - 1.0) * (a + m2)),
+                    -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0))):
+            d = 1.0 + num * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + num / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+def incomplete_beta(a, b, x):
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+                     + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * incomplete_beta_cf(a, b, x) / a
+    return 1.0 - front * incomplete_beta_cf(b, a, 1.0 - x) / b
+
+def t_cdf(t, df):
+    tail = 0.5 * incomplete_beta(df / 2.0, 0.5, df / (df + t * t))
+    return 1.0 - tail if t > 0 else tail
+
+def t_quantile(p, df):
+    lower, upper = -1e3, 1e3
+    for _ in range(200):
+        middle = 0.5 * (lower + upper)
+        if t_cdf(middle, df) < p:
+            lower = middle
+        else:
+            upper = middle
+    return 0.5 * (lower + upper)
+
+# Comparison ##################################################################
+
+# Mean, variance of the mean and sample count of the runs of a dataset
+def summarize(runs):
+    if len(runs) > 1:
+        means = [r[0] for r in runs]
+        mean = sum(means) / len(means)
+        variance = sum((m - mean) ** 2 for m in means) / (len(means) - 1)
+        return mean, variance / len(means), len(means)
+
+    mean, std_dev, samples = runs[0]
+    samples = max(samples, 2)
+    return mean, std_dev ** 2 / samples, samples
+
+# Welch's t-test of new against base, returns the difference of the means
+# with its confidence interval and the one-sided p-value of a slowdown
+def welch(base, new, confidence):
+    base_mean, base_var, base_n = summarize(base)
+    new_mean, new_var, new_n = summarize(new)
+
+    diff = new_mean - base_mean
+    var = base_var + new_var
+    if var == 0.0:
+        return diff, (diff, diff), 0.0 if diff > 0 else 1.0
+
+    df = var ** 2 / (base_var ** 2 / (base_n - 1) + new_var ** 2 / (new_n - 1))
+    se = math.sqrt(var)
+    t = t_quantile(0.5 + confidence / 2.0, df)
+    return diff, (diff - t * se, diff + t * se), 1.0 - t_cdf(diff / se, df)
+
+# Compares all datasets both commits have runs of, returns the number of
+# regressions: datasets whose slowdown is above the threshold for the whole
+# confidence interval
+def compare(db, base, new, machine, stage, threshold, confidence):
+    base_runs = load_runs(db, base, machine, stage)
+    new_runs = load_runs(db, new, machine, stage)
+    datasets = sorted(set(base_runs) & set(new_runs))
+    if not datasets:
+        print("no common datasets of {} and {} on '{}'"
+              .format(base[:10], new[:10], machine))
+        return 0
+
+    print("{} -> {} on '{}', stage '{}', {:.0f}% confidence"
+          .format(base[:10], new[:10], machine, stage, confidence * 100))
+    print("{:<28} {:>5} {:>10} {:>5} {:>10} {:>8} {:>19} {:>8}"
+          .format("dataset", "runs", "base", "runs", "new", "change",
+                  "interval", "p"))
+
+    regressions = 0
+    for dataset in datasets:
+        base_mean = summarize(base_runs[dataset])[0]
+        new_mean = summarize(new_runs[dataset])[0]
+        diff, (lower, upper), p = welch(base_runs[dataset], new_runs[dataset],
+                                        confidence)
+        percent = lambda x: 100.0 * x / base_mean if base_mean else 0.0
+
+        regressed = percent(lower) > threshold
+        improved = percent(upper) < -threshold
+        regressions += regressed
+
+        print("{:<28} {:>5} {:>10.3f} {:>5} {:>10.3f} {:>+7.2f}% "
+              "[{:>+7.2f}%,{:>+7.2f}%] {:>8.4f} {}"
+              .format(dataset, len(base_runs[dataset]), base_mean,
+                      len(new_runs[dataset]), new_mean, percent(diff),
+                      percent(lower), percent(upper), p,
+                      "REGRESSION" if regressed else
+                      "improvement" if improved else ""))
+        if len(base_runs[dataset]) < 2 or len(new_runs[dataset]) < 2:
+            print("  (single run, interval from the frame times only)")
+
+    print("{} significant regression(s) above {}%"
+          .format(regressions, threshold))
+    return regressions
+
+def list_runs(db):
+    rows = db.execute("SELECT commit_id, machine, dataset, COUNT(*), "
+                      "MAX(timestamp) FROM runs GROUP BY commit_id, machine, "
+                      "dataset ORDER BY MAX(timestamp)").fetchall()
+    for commit, machine, dataset, count, timestamp in rows:
+        print("{} {:<20} {:<28} {:>3} run(s), last {}".format(
+            commit[:10], machine, dataset, count,
+            time.strftime("%Y-%m-%d %H:%M", time.localtime(timestamp))))
+
+# Main execution ##############################################################
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="stores and compares benchmark timings")
+    parser.add_argument("--database", default=DEFAULT_DATABASE,
+                        help="database file, default '{}'"
+                        .format(DEFAULT_DATABASE))
+    commands = parser.add_subparsers(dest="command")
+
+    store = commands.add_parser("store", help="store results of "
+                                "'ospBenchmark --json' as runs of a dataset")
+    store.add_argument("--commit", help="default: HEAD of the current "
+                       "directory")
+    store.add_argument("--machine", help="default: the host name")
+    store.add_argument("--dataset", required=True)
+    store.add_argument("json_files", nargs="+")
+
+    commands.add_parser("list", help="list the stored runs")
+
+    comp = commands.add_parser("compare", help="compare the runs of two "
+                               "commits, the exit code is the number of "
+                               "regressions")
+    comp.add_argument("base")
+    comp.add_argument("new")
+    comp.add_argument("--machine", help="default: the host name")
+    comp.add_argument("--stage", default=DEFAULT_STAGE,
+                      help="stage of the frame to compare, default '{}'"
+                      .format(DEFAULT_STAGE))
+    comp.add_argument("--threshold", type=float,
+                      default=DEFAULT_THRESHOLD_PERCENT,
+                      help="minimum slowdown in percent to flag, default {}"
+                      .format(DEFAULT_THRESHOLD_PERCENT))
+    comp.add_argument("--confidence", type=float, default=DEFAULT_CONFIDENCE,
+                      help="confidence level of the intervals, default {}"
+                      .format(DEFAULT_CONFIDENCE))
+    args = parser.parse_args()
+
+    db = open_database(args.database)
+
+    if args.command == "store":
+        commit = args.commit or current_commit()
+        machine = args.machine or current_machine()
+        for json_file in args.json_files:
+            store_run(db, commit, machine, args.dataset, json_file)
+    elif args.command == "list":
+        list_runs(db)
+    elif args.command == "compare":
+        try:
+            base = resolve_commit(db, args.base)
+            new = resolve_commit(db, args.new)
+        except ValueError as e:
+            print(e)
+            sys.exit(-1)
+        sys.exit(compare(db, base, new, args.machine or current_machine(),
+                         args.stage, args.threshold, args.confidence))
+    else:
+        parser.print_help()
+
+if __name__ == "__main__":
+    main()
@@ -22,6 +22,10 @@ import re
 import csv
 import sys
 import math
+import shutil
+import tempfile
+
+import perf_db
 
 # Global constants ############################################################
 
@@ -132,7 +136,7 @@ def print_tests_list():
         print test_name
 
 # Runs a test and returns its exit code, stdout and stderr
-def run_single_test(test_name, exe, img_dir, use_scivis):
+def run_single_test(test_name, exe, img_dir, use_scivis, json_file=None):
     filename, fbSize, params = TEST_PARAMETERS[test_name]
     results = []
 
@@ -144,6 +148,8 @@ def run_single_test(test_name, exe, img_dir, use_scivis):
         " -i {}/test_{}_pt {}".format(exe,filename, fbSize, img_dir, test_name, params)
 
     command = command_sv if use_scivis else command_pt
+    if json_file:
+        command += " --json {}".format(json_file)
 
     print "Running \"{}\"".format(command.strip())
 
@@ -216,6 +222,12 @@ def run_tests(args):
     if run_mpi:
         exe ="{} {} --osp:mpi".format(args.mpi_wrapper, exe)
 
+    # Timings of every run are stored per commit, machine and test
+    database = perf_db.open_database(args.database) if args.database else None
+    commit = args.commit or perf_db.current_commit()
+    machine = args.machine or perf_db.current_machine()
+    json_dir = tempfile.mkdtemp(prefix="ospray_bench")
+
     failed_tests = 0
 
     for test_num, (test_name, use_scivis) in enumerate(sorted(tests_to_run)):
@@ -223,9 +235,17 @@ def run_tests(args):
         test_name_full2 = "{}_{}".format(test_name, "scivis" if use_scivis else "pt")
         print_headline("TEST {}/{}: {}".format(test_num + 1, len(tests_to_run), test_name_full))
 
-        retcode, output = run_single_test(test_name, exe, img_dir, use_scivis)
-        passed, error_msg = analyze_results(test_name_full2, retcode, output, output_csv, img_dir,
-                                            baseline_score, args)
+        for run in range(args.repeat):
+            json_file = os.path.join(json_dir, "{}.json".format(test_name_full2)) \
+                if database else None
+            if json_file and os.path.isfile(json_file):
+                os.remove(json_file)
+            retcode, output = run_single_test(test_name, exe, img_dir, use_scivis, json_file)
+            if run == 0:
+                passed, error_msg = analyze_results(test_name_full2, retcode, output, output_csv,
+                                                    img_dir, baseline_score, args)
+            if database and retcode == 0 and os.path.isfile(json_file):
+                perf_db.store_run(database, commit, machine, test_name_full2, json_file)
 
         if passed:
             print_headline("PASSED")
@@ -233,6 +253,11 @@ def run_tests(args):
             print_headline("FAILED, {}".format(error_msg))
             failed_tests += 1
 
+    shutil.rmtree(json_dir)
+    if database:
+        print "Timings stored in '{}' for commit {} on '{}'".format(args.database, commit[:10],
+                                                                   machine)
+
     sys.exit(failed_tests)
 
 # Main execution ##############################################################
@@ -252,6 +277,12 @@ parser.add_argument("--renderer", help="type of renderer used",
                     choices=["both", "scivis", "pt"], default="both")
 parser.add_argument("--app-location", help="path to ospBenchmark", default="")
 parser.add_argument("--mpi-wrapper", help="path to file which is used to wrap ospBenchmark with an MPI launch", default="")
+parser.add_argument("--database",
+                    help="database file to store the timings of all runs in, see perf_db.py")
+parser.add_argument("--repeat", type=int, default=1,
+                    help="number of runs of each test, for confidence intervals of the timings")
+parser.add_argument("--commit", help="commit the timings are stored for, default HEAD")
+parser.add_argument("--machine", help="machine the timings are stored for, default the host name")
 args = parser.parse_args()
 
 # Set the list of tests we intend on using
@@ -0,0 +1,220 @@
+#!/usr/bin/python
+## ======================================================================== ##
+## Copyright 2016-2019 Intel Corporation                                    ##
+##                                                                          ##
+## Licensed under the Apache License, Version 2.0 (the "License");          ##
+## you may not use this file except in compliance with the License.         ##
+## You may obtain a copy of the License at                                  ##
+##                                                                          ##
+##     http://www.apache.org/licenses/LICENSE-2.0                           ##
+##                                                                          ##
+## Unless required by applicable law or agreed to in writing, software      ##
+## distributed under the License is distributed on an "AS IS" BASIS,        ##
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. ##
+## See the License for the specific language governing permissions and      ##
+## limitations under the License.                                           ##
+## ======================================================================== ##
+
+# Runs strong- and weak-scaling sweeps of ospRandSciVisTest over rank counts,
+# image sizes, compositing modes and compression settings through an MPI
+# launch script (e.g. mpi_launch_openmpi.sh), and writes the frame times and
+# the per-phase timings of the distributed frame buffer of each run as JSON.
+
+import argparse
+import glob
+import itertools
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+# Global constants ############################################################
+
+EXE_NAME = "ospRandSciVisTest"
+SCORE_DIFF_PERCENT = 15.0
+
+# Function definitions ########################################################
+
+def print_headline(line):
+    print("=== {} ===".format(line.strip()))
+
+def parse_list(value, convert=str):
+    return [convert(v) for v in value.split(",") if v]
+
+def parse_size(value):
+    width, height = value.lower().split("x")
+    return int(width), int(height)
+
+# The name identifying a configuration, to compare it against a baseline
+def config_name(config):
+    return "{scaling}-{ranks}r-{width}x{height}-{tileOwnership}-" \
+        "{tileCodec}-c{compression}".format(**config)
+
+# Sums up the durations of the events of the traces per name and rank, and
+# returns the mean and max over the ranks per frame in ms
+def phase_timings(trace_files, frames):
+    per_rank = {}
+    for trace_file in trace_files:
+        with open(trace_file) as f:
+            events = json.load(f)["traceEvents"]
+        for e in events:
+            if e.get("ph") != "X":
+                continue
+            ranks = per_rank.setdefault(e["name"], {})
+            ranks[e["pid"]] = ranks.get(e["pid"], 0.0) + e["dur"] / 1000.0
+
+    phases = {}
+    for name, ranks in per_rank.items():
+        times = [t / frames for t in ranks.values()]
+        phases[name] = {"mean": sum(times) / len(times), "max": max(times)}
+    return phases
+
+def run_config(args, exe, config, work_dir):
+    env = dict(os.environ)
+    env["OSPRAY_BENCH_RANKS"] = str(config["ranks"])
+    env["OSPRAY_FORCE_COMPRESSION"] = str(config["compression"])
+
+    trace_prefix = os.path.join(work_dir, config_name(config))
+    if not args.no_phases:
+        env["OSPRAY_MPI_TRACE"] = trace_prefix
+        env["OSPRAY_MPI_TRACE_FRAMES"] = str(args.frames)
+
+    json_file = trace_prefix + "-results.json"
+    command = [args.mpi_wrapper, exe,
+               "-w", str(config["width"]), "-h", str(config["height"]),
+               "-nf", str(args.frames),
+               "-spn", str(config["spheresPerNode"]),
+               "--tile-ownership", config["tileOwnership"],
+               "--tile-codec", config["tileCodec"],
+               "--json", json_file]
+
+    print("Running \"{}\"".format(" ".join(command)))
+    sys.stdout.flush()
+    retcode = subprocess.call(command, env=env)
+    if retcode != 0 or not os.path.isfile(json_file):
+        return None, "subprocess returned with exit code {}".format(retcode)
+
+    with open(json_file) as f:
+        result = json.load(f)
+    result.update(config)
+    result["name"] = config_name(config)
+    if not args.no_phases:
+        result["phases"] = phase_timings(
+            sorted(glob.glob(trace_prefix + "-[0-9]*.json")), args.frames)
+    return result, None
+
+# Compares the mean frame time against the one of the same configuration of
+# a previous run
+def check_baseline(result, baseline):
+    if result["name"] not in baseline:
+        return True, None
+
+    target = baseline[result["name"]]["frameTime"]["mean"]
+    mean = result["frameTime"]["mean"]
+    if target == 0:
+        return True, None
+
+    ratio = mean / target
+    if ratio > 1.0 + SCORE_DIFF_PERCENT / 100.0:
+        return False, "the frame time regressed ({:.2f} ratio)".format(ratio)
+    return True, None
+
+def run_sweeps(args):
+    exe = EXE_NAME
+    if args.app_location != "":
+        exe = os.path.join(args.app_location, exe)
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = dict((r["name"], r) for r in json.load(f)["results"])
+
+    configs = []
+    for scaling, ranks, size, ownership, codec, compression in \
+            itertools.product(parse_list(args.scaling),
+                              parse_list(args.ranks, int),
+                              parse_list(args.sizes, parse_size),
+                              parse_list(args.tile_ownership),
+                              parse_list(args.tile_codec),
+                              parse_list(args.compression, int)):
+        # the volume bricks are of the same size per rank, the spheres
+        # are kept per rank for weak scaling and split up for strong
+        # scaling
+        spheres = args.spheres if scaling == "weak" \
+            else max(1, args.spheres // ranks)
+        configs.append({"scaling": scaling, "ranks": ranks,
+                        "width": size[0], "height": size[1],
+                        "tileOwnership": ownership, "tileCodec": codec,
+                        "compression": compression,
+                        "spheresPerNode": spheres})
+
+    work_dir = tempfile.mkdtemp(prefix="ospray_mpi_scaling")
+    results = []
+    failed = 0
+    try:
+        for num, config in enumerate(configs):
+            print_headline("RUN {}/{}: {}".format(num + 1, len(configs),
+                                                  config_name(config)))
+            result, error_msg = run_config(args, exe, config, work_dir)
+            if result:
+                results.append(result)
+                print("mean frame time: {:.2f} {}".format(
+                    result["frameTime"]["mean"], result["frameTime"]["unit"]))
+                passed, error_msg = check_baseline(result, baseline)
+            else:
+                passed = False
+
+            if passed:
+                print_headline("PASSED")
+            else:
+                print_headline("FAILED, {}".format(error_msg))
+                failed += 1
+    finally:
+        shutil.rmtree(work_dir)
+
+    with open(args.output, "w") as f:
+        json.dump({"frames": args.frames, "results": results}, f, indent=2,
+                  sort_keys=True)
+    print("results written to '{}'".format(args.output))
+
+    sys.exit(failed)
+
+# Main execution ##############################################################
+
+parser = argparse.ArgumentParser()
+parser.add_argument("--mpi-wrapper", required=True,
+                    help="script launching a command with MPI on the number "
+                    "of ranks given in OSPRAY_BENCH_RANKS, e.g. "
+                    "mpi_launch_openmpi.sh")
+parser.add_argument("--app-location", help="path to ospRandSciVisTest",
+                    default="")
+parser.add_argument("--scaling", help="comma-separated list of 'strong' "
+                    "and/or 'weak'", default="strong,weak")
+parser.add_argument("--ranks", help="comma-separated list of rank counts",
+                    default="1,2,4,8")
+parser.add_argument("--sizes", help="comma-separated list of image sizes",
+                    default="1024x768,1920x1080")
+parser.add_argument("--tile-ownership", help="comma-separated list of tile "
+                    "ownership modes of the mpi_raycast renderer",
+                    default="roundRobin,locality")
+parser.add_argument("--tile-codec", help="comma-separated list of tile "
+                    "codecs of the distributed frame buffer", default="none")
+parser.add_argument("--compression", help="comma-separated list of values "
+                    "of OSPRAY_FORCE_COMPRESSION", default="0,1")
+parser.add_argument("--spheres", type=int, default=1000,
+                    help="spheres per rank for weak scaling, in total for "
+                    "strong scaling")
+parser.add_argument("--frames", type=int, default=32,
+                    help="frames rendered per run")
+parser.add_argument("--no-phases", action="store_true",
+                    help="do not trace the runs for the per-phase timings")
+parser.add_argument("--output", help="output file name",
+                    default="mpi_scaling.json")
+parser.add_argument("--baseline", help="results of a previous run, runs "
+                    "whose mean frame time is more than {}%% slower fail"
+                    .format(SCORE_DIFF_PERCENT))
+args = parser.parse_args()
+
+run_sweeps(args)
@@ -0,0 +1,451 @@
+// ======================================================================== //
+// Copyright 2009-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Generates ospray/render/pathtracer/bsdfs/MicrofacetAlbedoTables.ispc,
+// the precomputed directional and average albedo tables of the microfacet
+// BSDFs. This is a scalar port of the integrators in MicrofacetAlbedo.ih
+// and of the distributions they use, keep it in sync with them.
+//
+//   g++ -std=c++11 -O2 generate_microfacet_albedo_tables.cpp -o gen
+//   ./gen > ../ospray/render/pathtracer/bsdfs/MicrofacetAlbedoTables.ispc
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+  const float pi = 3.14159265358979323846f;
+
+  // table sizes and ranges, see MicrofacetAlbedoTables.ih
+  const int MICROFACET_ALBEDO_TABLE_SIZE = 32;
+  const int MICROFACET_DIELECTRIC_ALBEDO_TABLE_SIZE = 16;
+  const float MICROFACET_DIELECTRIC_ALBEDO_TABLE_MIN_IOR = 1.f;
+  const float MICROFACET_DIELECTRIC_ALBEDO_TABLE_MAX_IOR = 3.f;
+  const int MICROFACET_SHEEN_ALBEDO_TABLE_SIZE = 16;
+
+  struct vec3
+  {
+    float x, y, z;
+  };
+
+  inline vec3 operator+(const vec3 &a, const vec3 &b)
+  { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+  inline vec3 operator-(const vec3 &a, const vec3 &b)
+  { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+  inline vec3 operator*(float s, const vec3 &a)
+  { return {s * a.x, s * a.y, s * a.z}; }
+  inline float dot(const vec3 &a, const vec3 &b)
+  { return a.x * b.x + a.y * b.y + a.z * b.z; }
+  inline vec3 cross(const vec3 &a, const vec3 &b)
+  { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+  inline vec3 normalize(const vec3 &a)
+  { return (1.f / std::sqrt(dot(a, a))) * a; }
+
+  inline float sqr(float x) { return x * x; }
+  inline float rcp_safe(float x) { return 1.f / (std::abs(x) < 1e-8f ? 1e-8f : x); }
+  inline float cos2sin(float f) { return std::sqrt(std::max(0.f, 1.f - sqr(f))); }
+  inline float lerp(float factor, float a, float b) { return (1 - factor) * a + factor * b; }
+
+  // Optics.ih, Fresnel.ih
+
+  inline vec3 reflect(const vec3 &I, const vec3 &N, float cosI)
+  { return (2.f * cosI) * N - I; }
+
+  inline vec3 refract(const vec3 &I, const vec3 &N, float cosI, float cosT, float eta)
+  { return eta * (cosI * N - I) - cosT * N; }
+
+  inline float sqrCosT(float cosI, float eta)
+  { return 1.f - sqr(eta) * (1.f - sqr(cosI)); }
+
+  inline float fresnelDielectric(float cosI, float cosT, float eta)
+  {
+    const float Rper = (eta*cosI -     cosT) / (eta*cosI +     cosT);
+    const float Rpar = (    cosI - eta*cosT) / (    cosI + eta*cosT);
+    return 0.5f*(sqr(Rpar) + sqr(Rper));
+  }
+
+  inline float fresnelDielectric(float cosI, float eta)
+  {
+    const float c = sqrCosT(cosI, eta);
+    if (c < 0.f) return 1.f;
+    return fresnelDielectric(cosI, std::sqrt(c), eta);
+  }
+
+  inline float fresnelDielectricEx(float cosI, float &cosT, float eta)
+  {
+    const float c = sqrCosT(cosI, eta);
+    if (c < 0.f) {
+      cosT = 0.f;
+      return 1.f;
+    }
+    cosT = std::sqrt(c);
+    return fresnelDielectric(cosI, cosT, eta);
+  }
+
+  // GGXDistribution.ih (isotropic)
+
+  inline float roughnessToAlpha(float roughness)
+  { return std::max(sqr(roughness), 0.001f); }
+
+  inline float GGX_eval(float alpha, const vec3 &wh)
+  {
+    const float cosTheta2 = sqr(wh.z);
+    const float e = (sqr(wh.x / alpha) + sqr(wh.y / alpha)) / cosTheta2;
+    return 1.f / (pi * alpha * alpha * sqr(cosTheta2 * (1.f + e)));
+  }
+
+  inline float GGX_evalLambda(float alpha, const vec3 &wo)
+  {
+    const float cosThetaO2 = sqr(wo.z);
+    const float invA2 = (sqr(wo.x * alpha) + sqr(wo.y * alpha)) / cosThetaO2;
+    return 0.5f * (-1.f + std::sqrt(1.f + invA2));
+  }
+
+  inline float GGX_evalG1(float alpha, const vec3 &wo, float cosThetaOH)
+  {
+    if (wo.z * cosThetaOH <= 0.f)
+      return 0.f;
+    return 1.f / (1.f + GGX_evalLambda(alpha, wo));
+  }
+
+  inline float GGX_evalG2(float alpha, const vec3 &wo, const vec3 &wi,
+                          float cosThetaOH, float cosThetaIH)
+  {
+    if (wo.z * cosThetaOH <= 0.f || wi.z * cosThetaIH <= 0.f)
+      return 0.f;
+    return 1.f / (1.f + GGX_evalLambda(alpha, wo) + GGX_evalLambda(alpha, wi));
+  }
+
+  inline vec3 GGX_sampleVisible(float alpha, const vec3 &wo, float sx, float sy)
+  {
+    const vec3 V = normalize({alpha * wo.x, alpha * wo.y, wo.z});
+    const vec3 T1 = (V.z < 0.9999f) ? normalize(cross(V, {0.f, 0.f, 1.f}))
+                                    : vec3{1.f, 0.f, 0.f};
+    const vec3 T2 = cross(T1, V);
+    const float a = 1.f / (1.f + V.z);
+    const float r = std::sqrt(sx);
+    const float phi = (sy < a) ? sy/a * pi : pi + (sy-a)/(1.f-a) * pi;
+    const float P1 = r*std::cos(phi);
+    const float P2 = r*std::sin(phi)*((sy < a) ? 1.f : V.z);
+    vec3 wh = P1*T1 + P2*T2 + std::sqrt(std::max(0.f, 1.f - P1*P1 - P2*P2))*V;
+    return normalize({alpha * wh.x, alpha * wh.y, std::max(0.f, wh.z)});
+  }
+
+  // SheenDistribution.ih
+
+  inline float Sheen_eval(float r, float cosTheta)
+  {
+    const float invr = 1.f / r;
+    return (2.f + invr) * std::pow(cos2sin(cosTheta), invr) * (0.5f / pi);
+  }
+
+  inline float Sheen_evalL(float r, float x)
+  {
+    const float w0 = sqr(1.f - r);
+    const float w1 = 1.f - w0;
+    const float a = w0*25.3245f + w1*21.5473f;
+    const float b = w0*3.32435f + w1*3.82987f;
+    const float c = w0*0.16801f + w1*0.19823f;
+    const float d = w0*-1.27393f + w1*-1.97760f;
+    const float e = w0*-4.85967f + w1*-4.32054f;
+    return a / (1.f + b * std::pow(x, c)) + d * x + e;
+  }
+
+  inline float Sheen_evalLambda(float r, float cosTheta)
+  {
+    if (cosTheta < 0.5f)
+      return std::exp(Sheen_evalL(r, cosTheta));
+    else
+      return std::exp(2.f * Sheen_evalL(r, 0.5f) - Sheen_evalL(r, 1.f - cosTheta));
+  }
+
+  inline float Sheen_evalLambdaI(float r, float cosTheta)
+  {
+    const float x = 1.f + 2.f * sqr(sqr(sqr(1.f - cosTheta)));
+    return std::pow(Sheen_evalLambda(r, cosTheta), x);
+  }
+
+  inline float Sheen_evalG2(float r, float cosThetaO, float cosThetaI,
+                            float cosThetaOH, float cosThetaIH)
+  {
+    if (cosThetaO * cosThetaOH <= 0.f || cosThetaI * cosThetaIH <= 0.f)
+      return 0.f;
+    return 1.f / (1.f + Sheen_evalLambda(r, cosThetaO) + Sheen_evalLambdaI(r, cosThetaI));
+  }
+
+  // MicrofacetAlbedo.ih
+
+  float MicrofacetAlbedo_sample(float cosThetaO, float alpha, float sx, float sy)
+  {
+    cosThetaO = std::max(cosThetaO, 1e-6f);
+    const vec3 wo = {cos2sin(cosThetaO), 0.f, cosThetaO};
+    const vec3 wh = GGX_sampleVisible(alpha, wo, sx, sy);
+    const float cosThetaOH = dot(wo, wh);
+    const vec3 wi = reflect(wo, wh, cosThetaOH);
+    if (wi.z <= 0.f)
+      return 0.f;
+    const float G = GGX_evalG2(alpha, wo, wi, cosThetaOH, dot(wi, wh));
+    return G * rcp_safe(GGX_evalG1(alpha, wo, cosThetaOH));
+  }
+
+  float MicrofacetDielectricAlbedo_sample(float cosThetaO, float eta, float alpha,
+                                          float sx, float sy)
+  {
+    cosThetaO = std::max(cosThetaO, 1e-6f);
+    const vec3 wo = {cos2sin(cosThetaO), 0.f, cosThetaO};
+    const vec3 wh = GGX_sampleVisible(alpha, wo, sx, sy);
+    const float cosThetaOH = dot(wo, wh);
+
+    float cosThetaTH;
+    const float F = fresnelDielectricEx(cosThetaOH, cosThetaTH, eta);
+
+    float weight = 0.f;
+
+    vec3 wi = reflect(wo, wh, cosThetaOH);
+    if (wi.z > 0.f) {
+      const float G = GGX_evalG2(alpha, wo, wi, cosThetaOH, dot(wi, wh));
+      weight += F * (G * rcp_safe(GGX_evalG1(alpha, wo, cosThetaOH)));
+    }
+
+    wi = refract(wo, wh, cosThetaOH, cosThetaTH, eta);
+    if (wi.z < 0.f) {
+      const float G = GGX_evalG2(alpha, wo, wi, cosThetaOH, dot(wi, wh));
+      weight += (1.f-F) * (G * rcp_safe(GGX_evalG1(alpha, wo, cosThetaOH)));
+    }
+
+    return weight;
+  }
+
+  float MicrofacetDielectricReflectionAlbedo_sample(float cosThetaO, float eta,
+                                                    float alpha, float sx, float sy)
+  {
+    cosThetaO = std::max(cosThetaO, 1e-6f);
+    const vec3 wo = {cos2sin(cosThetaO), 0.f, cosThetaO};
+    const vec3 wh = GGX_sampleVisible(alpha, wo, sx, sy);
+    const float cosThetaOH = dot(wo, wh);
+    const float F = fresnelDielectric(cosThetaOH, eta);
+    const vec3 wi = reflect(wo, wh, cosThetaOH);
+    if (wi.z <= 0.f)
+      return 0.f;
+    const float G = GGX_evalG2(alpha, wo, wi, cosThetaOH, dot(wi, wh));
+    return F * (G * rcp_safe(GGX_evalG1(alpha, wo, cosThetaOH)));
+  }
+
+  float MicrofacetSheenAlbedo_sample(float cosThetaO, float r, float sx, float sy)
+  {
+    cosThetaO = std::max(cosThetaO, 1e-6f);
+    const vec3 wo = {cos2sin(cosThetaO), 0.f, cosThetaO};
+
+    // uniformSampleHemisphere
+    const float phi = 2.f*pi * sx;
+    const float sinTheta = cos2sin(sy);
+    const vec3 wi = {std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, sy};
+    const float cosThetaI = wi.z;
+
+    const vec3 wh = normalize(wo + wi);
+    const float D = Sheen_eval(r, wh.z);
+    const float G = Sheen_evalG2(r, cosThetaO, cosThetaI, dot(wo, wh), dot(wi, wh));
+
+    const float pdf = 0.5f / pi;
+    return D * G / (4.f*cosThetaO * pdf);
+  }
+
+  // integrate over a stratified grid of numSamples samples
+  template <typename F>
+  float integrate(const F &sample, int numSamples = 1024)
+  {
+    const int n = int(std::sqrt(float(numSamples)));
+    float sum = 0.f;
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        const float sx = std::min((i + 0.5f) / n, 1.f - 1e-6f);
+        const float sy = std::min((j + 0.5f) / n, 1.f - 1e-6f);
+        sum += sample(sx, sy);
+      }
+    }
+    return std::min(sum / (n*n), 1.f);
+  }
+
+  // MicrofacetAlbedoTables.ispc
+
+  float interp1DLinear(float x, const float *f, int size)
+  {
+    const float xc = std::min(std::max(x, 0.f), float(size-1));
+    const float s = xc - std::floor(xc);
+    const int x0 = std::min(int(xc), size-1);
+    const int x1 = std::min(x0+1, size-1);
+    return lerp(s, f[x0], f[x1]);
+  }
+
+  float integrateAvg(const float *f, int size, int numSamples = 1024)
+  {
+    // Trapezoidal rule
+    const int n = numSamples+1;
+    float sum = 0.f;
+    for (int i = 0; i < n; i++) {
+      const float cosThetaO = float(i) / (n-1);
+      const float x = cosThetaO * (size-1);
+      sum += interp1DLinear(x, f, size) * cosThetaO * ((i == 0 || i == n-1) ? 0.5f : 1.f);
+    }
+    return std::min(2.f * (sum / (n-1)), 1.f);
+  }
+
+  void computeTable(std::vector<float> &dir, std::vector<float> &avg)
+  {
+    const int size = MICROFACET_ALBEDO_TABLE_SIZE;
+    dir.resize(size*size);
+    avg.resize(size);
+
+    for (int j = 0; j < size; j++) {
+      const float alpha = roughnessToAlpha(float(j) / (size-1));
+      float *dirPtr = &dir[j*size];
+      for (int i = 0; i < size; i++) {
+        const float cosThetaO = float(i) / (size-1);
+        dirPtr[i] = integrate([&](float sx, float sy) {
+          return MicrofacetAlbedo_sample(cosThetaO, alpha, sx, sy);
+        });
+      }
+      avg[j] = integrateAvg(dirPtr, size);
+    }
+  }
+
+  template <typename F>
+  void computeDielectricTable(const F &sample, float minEta, float maxEta,
+                              std::vector<float> &dir, std::vector<float> &avg)
+  {
+    const int size = MICROFACET_DIELECTRIC_ALBEDO_TABLE_SIZE;
+    dir.resize(size*size*size);
+    avg.resize(size*size);
+
+    for (int k = 0; k < size; k++) {
+      const float alpha = roughnessToAlpha(float(k) / (size-1));
+      for (int j = 0; j < size; j++) {
+        const float eta = lerp(float(j) / (size-1), minEta, maxEta);
+        float *dirPtr = &dir[(k*size + j)*size];
+        for (int i = 0; i < size; i++) {
+          const float cosThetaO = float(i) / (size-1);
+          dirPtr[i] = integrate([&](float sx, float sy) {
+            return sample(cosThetaO, eta, alpha, sx, sy);
+          });
+        }
+        avg[k*size + j] = integrateAvg(dirPtr, size);
+      }
+    }
+  }
+
+  void computeSheenTable(std::vector<float> &dir)
+  {
+    const int size = MICROFACET_SHEEN_ALBEDO_TABLE_SIZE;
+    dir.resize(size*size);
+
+    for (int j = 0; j < size; j++) {
+      const float r = roughnessToAlpha(float(j) / (size-1));
+      for (int i = 0; i < size; i++) {
+        const float cosThetaO = float(i) / (size-1);
+        dir[j*size + i] = integrate([&](float sx, float sy) {
+          return MicrofacetSheenAlbedo_sample(cosThetaO, r, sx, sy);
+        });
+      }
+    }
+  }
+
+  void printTable(const char *name, const char *size,
+                  const std::vector<float> &values)
+  {
+    printf("\nconst uniform float %s[%s] = {\n", name, size);
+    for (size_t i = 0; i < values.size(); i++) {
+      char value[32];
+      snprintf(value, sizeof(value), "%.9g", values[i]);
+      // keep it a floating point literal
+      const bool integral = !strpbrk(value, ".e");
+      printf("%s%s%sf,", i % 6 == 0 ? "  " : " ", value, integral ? ".0" : "");
+      if (i % 6 == 5 || i + 1 == values.size())
+        printf("\n");
+    }
+    printf("};\n");
+  }
+
+} // ::anonymous
+
+int main()
+{
+  std::vector<float> dir, avg;
+
+  printf("%s",
+"// ======================================================================== //\n"
+"// Copyright 2009-2019 Intel Corporation                                    //\n"
+"//                                                                          //\n"
+"// Licensed under the Apache License, Version 2.0 (the \"License\");          //\n"
+"// you may not use this file except in compliance with the License.         //\n"
+"// You may obtain a copy of the License at                                  //\n"
+"//                                                                          //\n"
+"//     http://www.apache.org/licenses/LICENSE-2.0                           //\n"
+"//                                                                          //\n"
+"// Unless required by applicable law or agreed to in writing, software      //\n"
+"// distributed under the License is distributed on an \"AS IS\" BASIS,        //\n"
+"// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //\n"
+"// See the License for the specific language governing permissions and      //\n"
+"// limitations under the License.                                           //\n"
+"// ======================================================================== //\n"
+"\n"
+"// Generated by scripts/generate_microfacet_albedo_tables.cpp, do not edit.\n"
+"\n"
+"#include \"MicrofacetAlbedoTables.ih\"\n");
+
+  computeTable(dir, avg);
+  printTable("MicrofacetAlbedoTable_dir",
+             "MICROFACET_ALBEDO_TABLE_SIZE*MICROFACET_ALBEDO_TABLE_SIZE", dir);
+  printTable("MicrofacetAlbedoTable_avg", "MICROFACET_ALBEDO_TABLE_SIZE", avg);
+
+  const char *dirSize = "MICROFACET_DIELECTRIC_ALBEDO_TABLE_SIZE*"
+                        "MICROFACET_DIELECTRIC_ALBEDO_TABLE_SIZE*"
+                        "MICROFACET_DIELECTRIC_ALBEDO_TABLE_SIZE";
+  const char *avgSize = "MICROFACET_DIELECTRIC_ALBEDO_TABLE_SIZE*"
+                        "MICROFACET_DIELECTRIC_ALBEDO_TABLE_SIZE";
+
+  // eta in [1/3, 1]
+  computeDielectricTable(MicrofacetDielectricAlbedo_sample,
+                         1.f / MICROFACET_DIELECTRIC_ALBEDO_TABLE_MAX_IOR,
+                         1.f / MICROFACET_DIELECTRIC_ALBEDO_TABLE_MIN_IOR,
+                         dir, avg);
+  printTable("MicrofacetDielectricAlbedoTable_dir", dirSize, dir);
+  printTable("MicrofacetDielectricAlbedoTable_avg", avgSize, avg);
+
+  computeDielectricTable(MicrofacetDielectricReflectionAlbedo_sample,
+                         1.f / MICROFACET_DIELECTRIC_ALBEDO_TABLE_MAX_IOR,
+                         1.f / MICROFACET_DIELECTRIC_ALBEDO_TABLE_MIN_IOR,
+                         dir, avg);
+  printTable("MicrofacetDielectricReflectionAlbedoTable_dir", dirSize, dir);
+  printTable("MicrofacetDielectricReflectionAlbedoTable_avg", avgSize, avg);
+
+  // eta in [1, 3]
+  computeDielectricTable(MicrofacetDielectricAlbedo_sample,
+                         MICROFACET_DIELECTRIC_ALBEDO_TABLE_MIN_IOR,
+                         MICROFACET_DIELECTRIC_ALBEDO_TABLE_MAX_IOR,
+                         dir, avg);
+  printTable("MicrofacetDielectricRcpEtaAlbedoTable_dir", dirSize, dir);
+  printTable("MicrofacetDielectricRcpEtaAlbedoTable_avg", avgSize, avg);
+
+  computeSheenTable(dir);
+  printTable("MicrofacetSheenAlbedoTable_dir",
+             "MICROFACET_SHEEN_ALBEDO_TABLE_SIZE*MICROFACET_SHEEN_ALBEDO_TABLE_SIZE",
+             dir);
+
+  return 0;
+}
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 #include <vector>
 #include <gtest/gtest.h>
@@ -31,6 +32,14 @@ class OSPRayEnvironment : public ::testing::Environment {
   osp::vec2i imgSize;
   OSPDevice device;
 
+  // performance mode: render times compared to a per-machine baseline
+  bool perfMode;
+  bool perfUpdate;
+  bool perfFail;
+  float perfTolerance;
+  std::string perfBaselineFile;
+  std::map<std::string, double> perfBaseline; // render seconds per test
+
  public:
   OSPRayEnvironment(int argc, char **argv);
   ~OSPRayEnvironment();
@@ -53,6 +62,26 @@ class OSPRayEnvironment : public ::testing::Environment {
   std::string GetFailedDir() const {
     return failedDir;
   }
+  bool GetPerfMode() const {
+    return perfMode;
+  }
+  bool GetPerfUpdate() const {
+    return perfUpdate;
+  }
+  bool GetPerfFail() const {
+    return perfFail;
+  }
+  float GetPerfTolerance() const {
+    return perfTolerance;
+  }
+
+  // baseline render time of a test, false if there is none yet
+  bool GetPerfBaseline(const std::string &testName, double &seconds) const;
+  // record the render time of a test, written with --perf-update
+  void SetPerfBaseline(const std::string &testName, double seconds);
+
+  void LoadPerfBaseline();
+  void SavePerfBaseline() const;
 
   void ParsArgs(int argc, char **argv);
   std::string GetStrArgValue(std::string *arg) const;
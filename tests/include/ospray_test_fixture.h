@@ -81,6 +81,8 @@ protected:
   OSPMaterial CreateMaterial(std::string type);
 
   void RenderFrame(const uint32_t frameBufferChannels = OSP_FB_COLOR | OSP_FB_ACCUM);
+  // compare the render time with the baseline of the machine (--perf)
+  void CheckPerformance(double seconds);
 };
 
 // Fixture class for tests parametrized with renderer type and material type, intended for
@@ -15,6 +15,8 @@
 // ======================================================================== //
 
 #include "ospray_environment.h"
+#include <fstream>
+#include <sstream>
 
 OSPRayEnvironment::OSPRayEnvironment(int argc, char **argv) :
   dumpImg(false),
@@ -22,9 +24,16 @@ OSPRayEnvironment::OSPRayEnvironment(int argc, char **argv) :
   imgSize({ 1920,1080 }),
   deviceType("default"),
   baselineDir("regression_tests/baseline"),
-  failedDir("failed")
+  failedDir("failed"),
+  perfMode(false),
+  perfUpdate(false),
+  perfFail(false),
+  perfTolerance(0.1f),
+  perfBaselineFile("perf_baseline.txt")
 {
   ParsArgs(argc, argv);
+  if (perfMode)
+    LoadPerfBaseline();
   ospLoadModule("ispc");
   device = ospNewDevice(GetDeviceType().c_str());
   if(device == NULL) {
@@ -38,6 +47,8 @@ OSPRayEnvironment::OSPRayEnvironment(int argc, char **argv) :
 
 OSPRayEnvironment::~OSPRayEnvironment()
 {
+  if (perfUpdate)
+    SavePerfBaseline();
   ospShutdown();
 }
 
@@ -54,7 +65,12 @@ void OSPRayEnvironment::ParsArgs(int argc, char **argv) {
                 "--imgsize-y=XX : change the height of an image\n" <<
                 "--device-type=XX : change the device type which is used by OSPRay\n" <<
                 "--renderer-type=XX : change the renderer used for tests\n" <<
-                "--baseline-dir=XX : Change the directory used for baseline images during tests\n";
+                "--baseline-dir=XX : Change the directory used for baseline images during tests\n" <<
+                "--perf : also measure render times and compare them to a baseline\n" <<
+                "--perf-baseline=XX : file with the render time baseline of this machine\n" <<
+                "--perf-tolerance=XX : slowdown in percent reported as regression (default 10)\n" <<
+                "--perf-fail : fail tests on performance regressions instead of warning\n" <<
+                "--perf-update : write the measured render times to the baseline file\n";
       std::exit(EXIT_SUCCESS);
     } else if(testArgs.at(idx) == "--dump-img") {
       dumpImg = true;
@@ -70,6 +86,20 @@ void OSPRayEnvironment::ParsArgs(int argc, char **argv) {
       baselineDir = GetStrArgValue(&testArgs.at(idx));
     } else if (testArgs.at(idx).find("--failed-dir=") == 0) {
       failedDir = GetStrArgValue(&testArgs.at(idx));
+    } else if (testArgs.at(idx) == "--perf") {
+      perfMode = true;
+    } else if (testArgs.at(idx) == "--perf-update") {
+      perfMode = true;
+      perfUpdate = true;
+    } else if (testArgs.at(idx) == "--perf-fail") {
+      perfMode = true;
+      perfFail = true;
+    } else if (testArgs.at(idx).find("--perf-baseline=") == 0) {
+      perfMode = true;
+      perfBaselineFile = GetStrArgValue(&testArgs.at(idx));
+    } else if (testArgs.at(idx).find("--perf-tolerance=") == 0) {
+      perfMode = true;
+      perfTolerance = GetNumArgValue(&testArgs.at(idx)) / 100.f;
     }
   }
 }
@@ -96,3 +126,49 @@ std::string OSPRayEnvironment::GetStrArgValue(std::string *arg) const {
   return ret;
 }
 
+bool OSPRayEnvironment::GetPerfBaseline(const std::string &testName,
+                                        double &seconds) const {
+  auto it = perfBaseline.find(testName);
+  if (it == perfBaseline.end())
+    return false;
+  seconds = it->second;
+  return true;
+}
+
+void OSPRayEnvironment::SetPerfBaseline(const std::string &testName,
+                                        double seconds) {
+  perfBaseline[testName] = seconds;
+}
+
+// the baseline has one "<test name> <render seconds>" line per test
+void OSPRayEnvironment::LoadPerfBaseline() {
+  std::ifstream inFile(perfBaselineFile.c_str());
+  if (!inFile.good()) {
+    std::cerr << "[ WARNING  ] no performance baseline " << perfBaselineFile
+              << ", run with --perf-update to create one" << std::endl;
+    return;
+  }
+
+  std::string line;
+  while (std::getline(inFile, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream lineStream(line);
+    std::string testName;
+    double seconds;
+    if (lineStream >> testName >> seconds)
+      perfBaseline[testName] = seconds;
+  }
+}
+
+void OSPRayEnvironment::SavePerfBaseline() const {
+  std::ofstream outFile(perfBaselineFile.c_str());
+  if (!outFile.good()) {
+    std::cerr << "Failed to open file " << perfBaselineFile << std::endl;
+    return;
+  }
+
+  outFile << "# render time in seconds per test, see --perf\n";
+  for (const auto &entry : perfBaseline)
+    outFile << entry.first << " " << entry.second << "\n";
+}
@@ -15,6 +15,9 @@
 // ======================================================================== //
 
 #include "ospray_test_fixture.h"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
 
 extern OSPRayEnvironment * ospEnv;
 
@@ -146,7 +149,14 @@ void Base::PerformRenderTest()
 
   ospFrameBufferClear(framebuffer, OSP_FB_ACCUM);
 
+  auto renderStart = std::chrono::steady_clock::now();
   RenderFrame(OSP_FB_COLOR | OSP_FB_ACCUM | OSP_FB_DEPTH);
+  std::chrono::duration<double> renderTime =
+    std::chrono::steady_clock::now() - renderStart;
+
+  if (ospEnv->GetPerfMode())
+    CheckPerformance(renderTime.count());
+
   uint32_t* framebuffer_data = (uint32_t*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
 
   if(ospEnv->GetDumpImg()) {
@@ -233,6 +243,42 @@ void Base::RenderFrame(const uint32_t frameBufferChannels)
     ospRenderFrame(framebuffer, renderer, frameBufferChannels);
 }
 
+void Base::CheckPerformance(double seconds)
+{
+  // primary rays, i.e. samples
+  const double rays = double(imgSize.x) * imgSize.y * samplesPerPixel * frames;
+  const double mraysPerSecond = rays / seconds * 1e-6;
+
+  ::testing::Test::RecordProperty("renderTimeMs", int(seconds * 1e3));
+  ::testing::Test::RecordProperty("mraysPerSecond", int(mraysPerSecond));
+
+  double baseline;
+  const bool haveBaseline = ospEnv->GetPerfBaseline(GetTestName(), baseline);
+
+  std::cerr << "[ PERF     ] " << GetTestName() << ": "
+    << std::fixed << std::setprecision(2) << seconds * 1e3 << " ms, "
+    << mraysPerSecond << " Mrays/s";
+  if (haveBaseline)
+    std::cerr << " (baseline " << baseline * 1e3 << " ms)";
+  std::cerr << std::endl;
+
+  if (ospEnv->GetPerfUpdate()) {
+    ospEnv->SetPerfBaseline(GetTestName(), seconds);
+    return;
+  }
+
+  if (!haveBaseline || seconds <= baseline * (1.f + ospEnv->GetPerfTolerance()))
+    return;
+
+  std::stringstream msg;
+  msg << GetTestName() << " is " << std::setprecision(0)
+      << (seconds / baseline - 1.0) * 100 << "% slower than the baseline";
+  if (ospEnv->GetPerfFail())
+    ADD_FAILURE() << msg.str();
+  else
+    std::cerr << "[ WARNING  ] " << msg.str() << std::endl;
+}
+
 
 SingleObject::SingleObject()
 {
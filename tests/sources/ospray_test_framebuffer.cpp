@@ -0,0 +1,60 @@
+// ======================================================================== //
+// Copyright 2017-2019 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "ospray_test_fixture.h"
+#include <algorithm>
+#include <vector>
+
+// the last completed frame stays mapped when the number of color buffers
+// of the swap chain ("colorBufferCount") changes
+TEST(FrameBuffer, colorBufferCount) {
+  const osp::vec2i size = { 16, 16 };
+  OSPFrameBuffer framebuffer =
+    ospNewFrameBuffer(size, OSP_FB_RGBA8, OSP_FB_COLOR);
+
+  OSPModel world = ospNewModel();
+  ospCommit(world);
+  OSPCamera camera = ospNewCamera("perspective");
+  ospCommit(camera);
+  OSPRenderer renderer = ospNewRenderer("scivis");
+  ospSetObject(renderer, "model", world);
+  ospSetObject(renderer, "camera", camera);
+  ospSet3f(renderer, "bgColor", 1.f, 0.5f, 0.f);
+  ospCommit(renderer);
+
+  ospRenderFrame(framebuffer, renderer, OSP_FB_COLOR);
+
+  const uint32_t *mapped =
+    (const uint32_t *)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
+  ASSERT_TRUE(mapped);
+  const std::vector<uint32_t> rendered(mapped, mapped + size.x * size.y);
+  ospUnmapFrameBuffer(mapped, framebuffer);
+
+  for (int count : { 2, 3, 1 }) {
+    ospSet1i(framebuffer, "colorBufferCount", count);
+    ospCommit(framebuffer);
+    mapped = (const uint32_t *)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
+    ASSERT_TRUE(mapped);
+    EXPECT_TRUE(std::equal(rendered.begin(), rendered.end(), mapped))
+      << "colorBufferCount " << count;
+    ospUnmapFrameBuffer(mapped, framebuffer);
+  }
+
+  ospRelease(renderer);
+  ospRelease(camera);
+  ospRelease(world);
+  ospRelease(framebuffer);
+}